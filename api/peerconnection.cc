@@ -505,6 +505,8 @@ bool PeerConnectionInterface::RTCConfiguration::operator==(
     bool enable_ice_renomination;
     bool redetermine_role_on_ice_restart;
     std::string media_crypto_key;
+    std::string media_crypto_next_key;
+    int media_crypto_replay_window_size;
   };
   static_assert(sizeof(stuff_being_tested_for_equality) == sizeof(*this),
                 "Did you add something to RTCConfiguration and forget to "
@@ -537,7 +539,9 @@ bool PeerConnectionInterface::RTCConfiguration::operator==(
              o.presume_writable_when_fully_relayed &&
          enable_ice_renomination == o.enable_ice_renomination &&
          redetermine_role_on_ice_restart == o.redetermine_role_on_ice_restart &&
-         media_crypto_key == o.media_crypto_key;
+         media_crypto_key == o.media_crypto_key &&
+         media_crypto_next_key == o.media_crypto_next_key &&
+         media_crypto_replay_window_size == o.media_crypto_replay_window_size;
 }
 
 bool PeerConnectionInterface::RTCConfiguration::operator!=(
@@ -1423,6 +1427,8 @@ bool PeerConnection::SetConfiguration(const RTCConfiguration& configuration,
   modified_config.ice_candidate_pool_size =
       configuration.ice_candidate_pool_size;
   modified_config.prune_turn_ports = configuration.prune_turn_ports;
+  modified_config.media_crypto_key = configuration.media_crypto_key;
+  modified_config.media_crypto_next_key = configuration.media_crypto_next_key;
   if (configuration != modified_config) {
     LOG(LS_ERROR) << "Modifying the configuration in an unsupported way.";
     return SafeSetError(RTCErrorType::INVALID_MODIFICATION, error);
@@ -1435,6 +1441,27 @@ bool PeerConnection::SetConfiguration(const RTCConfiguration& configuration,
     return SafeSetError(RTCErrorType::INVALID_RANGE, error);
   }
 
+  // The end to end media key can be rotated, but not turned on or off.
+  if (modified_config.media_crypto_key != configuration_.media_crypto_key) {
+    if (configuration_.media_crypto_key.empty() ||
+        modified_config.media_crypto_key.empty()) {
+      LOG(LS_ERROR) << "Can't enable or disable media crypto after creation.";
+      return SafeSetError(RTCErrorType::INVALID_MODIFICATION, error);
+    }
+  }
+  // Receivers get the next key before any sender switches to it, even when
+  // both change in the same call.
+  if (modified_config.media_crypto_next_key !=
+          configuration_.media_crypto_next_key &&
+      !modified_config.media_crypto_next_key.empty() &&
+      !session_->SetNextMediaCryptoKey(modified_config.media_crypto_next_key)) {
+    return SafeSetError(RTCErrorType::INVALID_PARAMETER, error);
+  }
+  if (modified_config.media_crypto_key != configuration_.media_crypto_key &&
+      !session_->SetMediaCryptoKey(modified_config.media_crypto_key)) {
+    return SafeSetError(RTCErrorType::INVALID_PARAMETER, error);
+  }
+
   // Parse ICE servers before hopping to network thread.
   cricket::ServerAddresses stun_servers;
   std::vector<cricket::RelayServerConfig> turn_servers;
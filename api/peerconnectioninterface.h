@@ -386,8 +386,16 @@ class PeerConnectionInterface : public rtc::RefCountInterface {
     // If true, ICE role is redetermined when peerconnection sets a local
     // transport description that indicates an ICE restart.
     bool redetermine_role_on_ice_restart = true;
-    // End to end media encryption key
+    // End to end media encryption key. Can be changed with SetConfiguration
+    // to rotate the key without renegotiating.
     std::string media_crypto_key;
+    // Key only accepted on receive, for hitless rotation: every endpoint sets
+    // the new key here first, and once all of them have it, moves it to
+    // |media_crypto_key| to start sending with it. The replaced key is still
+    // accepted for a grace period after the first packet with the new one.
+    std::string media_crypto_next_key;
+    // Replay window of each remote sender end to end decryption context.
+    int media_crypto_replay_window_size = 1024;
     //
     // Don't forget to update operator== if adding something.
     //
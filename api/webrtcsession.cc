@@ -540,8 +540,14 @@ bool WebRtcSession::Initialize(
     if (!media_crypto_key_.Parse(rtc::SRTP_AEAD_AES_256_GCM,
       rtc_configuration.media_crypto_key))
         return false;
+    media_crypto_key_.replay_window_size =
+        rtc_configuration.media_crypto_replay_window_size;
     LOG(LS_INFO) << "Enabling E2E Media Encryption";
     media_crypto_enabled_ = true;
+    if (!rtc_configuration.media_crypto_next_key.empty() &&
+        !SetNextMediaCryptoKey(rtc_configuration.media_crypto_next_key)) {
+      return false;
+    }
   }
   
   bundle_policy_ = rtc_configuration.bundle_policy;
@@ -1446,6 +1452,49 @@ void WebRtcSession::SetNeedsIceRestartFlag() {
   transport_controller_->SetNeedsIceRestartFlag();
 }
 
+bool WebRtcSession::SetMediaCryptoKey(const std::string& key) {
+  if (!media_crypto_enabled_) {
+    LOG(LS_ERROR) << "Can't set a media crypto key on a session created "
+                     "without one.";
+    return false;
+  }
+  MediaCryptoKey media_crypto_key;
+  if (!media_crypto_key.Parse(rtc::SRTP_AEAD_AES_256_GCM, key))
+    return false;
+  media_crypto_key.replay_window_size = media_crypto_key_.replay_window_size;
+  media_crypto_key_ = media_crypto_key;
+  if (media_crypto_next_key_.buffer == media_crypto_key_.buffer)
+    media_crypto_next_key_ = MediaCryptoKey();
+
+  LOG(LS_INFO) << "Rotating E2E Media Encryption key";
+  if (voice_channel_)
+    voice_channel_->SetMediaCryptoKey(media_crypto_key_);
+  if (video_channel_)
+    video_channel_->SetMediaCryptoKey(media_crypto_key_);
+  return true;
+}
+
+bool WebRtcSession::SetNextMediaCryptoKey(const std::string& key) {
+  if (!media_crypto_enabled_) {
+    LOG(LS_ERROR) << "Can't set a media crypto key on a session created "
+                     "without one.";
+    return false;
+  }
+  MediaCryptoKey media_crypto_key;
+  if (!media_crypto_key.Parse(rtc::SRTP_AEAD_AES_256_GCM, key))
+    return false;
+  media_crypto_key.replay_window_size = media_crypto_key_.replay_window_size;
+  media_crypto_key.receive_only = true;
+  media_crypto_next_key_ = media_crypto_key;
+
+  LOG(LS_INFO) << "Accepting next E2E Media Encryption key";
+  if (voice_channel_)
+    voice_channel_->SetMediaCryptoKey(media_crypto_next_key_);
+  if (video_channel_)
+    video_channel_->SetMediaCryptoKey(media_crypto_next_key_);
+  return true;
+}
+
 bool WebRtcSession::NeedsIceRestart(const std::string& content_name) const {
   return transport_controller_->NeedsIceRestart(content_name);
 }
@@ -1821,6 +1870,8 @@ bool WebRtcSession::CreateVoiceChannel(const cricket::ContentInfo* content,
 
   if (media_crypto_enabled_)
     voice_channel_->SetMediaCryptoKey(media_crypto_key_);
+  if (!media_crypto_next_key_.buffer.empty())
+    voice_channel_->SetMediaCryptoKey(media_crypto_next_key_);
 
   voice_channel_->SignalRtcpMuxFullyActive.connect(
       this, &WebRtcSession::DestroyRtcpTransport_n);
@@ -1861,6 +1912,8 @@ bool WebRtcSession::CreateVideoChannel(const cricket::ContentInfo* content,
   
   if (media_crypto_enabled_)
     video_channel_->SetMediaCryptoKey(media_crypto_key_);
+  if (!media_crypto_next_key_.buffer.empty())
+    video_channel_->SetMediaCryptoKey(media_crypto_next_key_);
 
   video_channel_->SignalRtcpMuxFullyActive.connect(
       this, &WebRtcSession::DestroyRtcpTransport_n);
@@ -330,6 +330,12 @@ class WebRtcSession :
   // set, offers should generate new ufrags/passwords until an ICE restart
   // occurs.
   void SetNeedsIceRestartFlag();
+  // Rotates the end to end media key on the existing channels, without any
+  // renegotiation. Fails if the session was created without a key.
+  bool SetMediaCryptoKey(const std::string& key);
+  // Installs the key the remote senders will switch to on the receive side
+  // only, so that SetMediaCryptoKey with it later on is hitless.
+  bool SetNextMediaCryptoKey(const std::string& key);
   // Returns true if the ICE restart flag above was set, and no ICE restart has
   // occurred yet for this transport (by applying a local description with
   // changed ufrag/password). If the transport has been deleted as a result of
@@ -649,6 +655,8 @@ class WebRtcSession :
 #endif  // HAVE_QUIC
   
   MediaCryptoKey media_crypto_key_;
+  // Empty unless a next key was set and not switched to yet.
+  MediaCryptoKey media_crypto_next_key_;
   bool media_crypto_enabled_;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(WebRtcSession);
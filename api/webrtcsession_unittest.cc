@@ -23,6 +23,7 @@
 #include "webrtc/api/videotrack.h"
 #include "webrtc/api/webrtcsession.h"
 #include "webrtc/api/webrtcsessiondescriptionfactory.h"
+#include "webrtc/base/base64.h"
 #include "webrtc/base/checks.h"
 #include "webrtc/base/fakenetwork.h"
 #include "webrtc/base/firewallsocketserver.h"
@@ -4434,6 +4435,47 @@ TEST_F(WebRtcSessionTest, TestPacketOptionsAndOnPacketSent) {
   TestPacketOptions();
 }
 
+// The next media crypto key is installed receive only on existing and new
+// channels, and only used for sending once it is set as the key.
+TEST_F(WebRtcSessionTest, NextMediaCryptoKeyIsReceiveOnlyUntilSwitchedTo) {
+  const std::string key = rtc::Base64::Encode(std::string(44, '\x01'));
+  const std::string next_key = rtc::Base64::Encode(std::string(44, '\x02'));
+  configuration_.media_crypto_key = key;
+  Init();
+  EXPECT_TRUE(session_->SetNextMediaCryptoKey(next_key));
+  SendAudioVideoStream1();
+  InitiateCall();
+
+  cricket::FakeVoiceMediaChannel* voice_channel =
+      media_engine_->GetVoiceChannel(0);
+  cricket::FakeVideoMediaChannel* video_channel =
+      media_engine_->GetVideoChannel(0);
+  ASSERT_TRUE(voice_channel);
+  ASSERT_TRUE(video_channel);
+  for (const auto& keys :
+       {voice_channel->media_crypto_keys(), video_channel->media_crypto_keys()}) {
+    ASSERT_EQ(2u, keys.size());
+    EXPECT_EQ(std::vector<uint8_t>(44, 1), keys[0].buffer);
+    EXPECT_FALSE(keys[0].receive_only);
+    EXPECT_EQ(std::vector<uint8_t>(44, 2), keys[1].buffer);
+    EXPECT_TRUE(keys[1].receive_only);
+  }
+
+  EXPECT_TRUE(session_->SetMediaCryptoKey(next_key));
+  for (const auto& keys :
+       {voice_channel->media_crypto_keys(), video_channel->media_crypto_keys()}) {
+    ASSERT_EQ(3u, keys.size());
+    EXPECT_EQ(std::vector<uint8_t>(44, 2), keys[2].buffer);
+    EXPECT_FALSE(keys[2].receive_only);
+  }
+}
+
+TEST_F(WebRtcSessionTest, NextMediaCryptoKeyNeedsMediaCrypto) {
+  Init();
+  EXPECT_FALSE(session_->SetNextMediaCryptoKey(
+      rtc::Base64::Encode(std::string(44, '\x02'))));
+}
+
 // Make sure the signal from "GetOnDestroyedSignal()" fires when the session
 // is destroyed.
 TEST_F(WebRtcSessionTest, TestOnDestroyedSignal) {
@@ -26,4 +26,16 @@ AsyncPacketSocket::AsyncPacketSocket() {
 AsyncPacketSocket::~AsyncPacketSocket() {
 }
 
+int AsyncPacketSocket::SendToBatch(const DatagramToSend* datagrams,
+                                   const PacketOptions* options,
+                                   size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    int sent = SendTo(datagrams[i].data, datagrams[i].length,
+                      datagrams[i].address, options[i]);
+    if (sent < 0)
+      return i > 0 ? static_cast<int>(i) : sent;
+  }
+  return static_cast<int>(count);
+}
+
 };  // namespace rtc
@@ -89,6 +89,12 @@ class AsyncPacketSocket : public sigslot::has_slots<> {
   virtual int Send(const void *pv, size_t cb, const PacketOptions& options) = 0;
   virtual int SendTo(const void *pv, size_t cb, const SocketAddress& addr,
                      const PacketOptions& options) = 0;
+  // Sends |count| packets in order, |options| has one entry per packet.
+  // Returns the number of packets sent, or a negative error if none could be.
+  // The default implementation calls SendTo for each packet.
+  virtual int SendToBatch(const DatagramToSend* datagrams,
+                          const PacketOptions* options,
+                          size_t count);
 
   // Close the socket.
   virtual int Close() = 0;
@@ -9,12 +9,20 @@
  */
 
 #include "webrtc/base/asyncudpsocket.h"
+
+#include <algorithm>
+
 #include "webrtc/base/checks.h"
 #include "webrtc/base/logging.h"
 
 namespace rtc {
 
 static const int BUF_SIZE = 64 * 1024;
+// Size of each datagram slot of the buffer when reading in batches, large
+// enough for any packet that fits in the MTU.
+static const size_t kBatchSlotSize = 2 * 1024;
+
+const size_t AsyncUDPSocket::kMaxReceiveBatchSize = BUF_SIZE / kBatchSlotSize;
 
 AsyncUDPSocket* AsyncUDPSocket::Create(
     AsyncSocket* socket,
@@ -37,7 +45,7 @@ AsyncUDPSocket* AsyncUDPSocket::Create(SocketFactory* factory,
 }
 
 AsyncUDPSocket::AsyncUDPSocket(AsyncSocket* socket)
-    : socket_(socket) {
+    : socket_(socket), destroyed_(nullptr) {
   size_ = BUF_SIZE;
   buf_ = new char[size_];
 
@@ -47,6 +55,8 @@ AsyncUDPSocket::AsyncUDPSocket(AsyncSocket* socket)
 }
 
 AsyncUDPSocket::~AsyncUDPSocket() {
+  if (destroyed_)
+    *destroyed_ = true;
   delete [] buf_;
 }
 
@@ -75,6 +85,16 @@ int AsyncUDPSocket::SendTo(const void *pv, size_t cb,
   return ret;
 }
 
+int AsyncUDPSocket::SendToBatch(const DatagramToSend* datagrams,
+                                const rtc::PacketOptions* options,
+                                size_t count) {
+  int64_t send_time_ms = rtc::TimeMillis();
+  int ret = socket_->SendToBatch(datagrams, count);
+  for (int i = 0; i < ret; ++i)
+    SignalSentPacket(this, rtc::SentPacket(options[i].packet_id, send_time_ms));
+  return ret;
+}
+
 int AsyncUDPSocket::Close() {
   return socket_->Close();
 }
@@ -99,8 +119,25 @@ void AsyncUDPSocket::SetError(int error) {
   return socket_->SetError(error);
 }
 
+void AsyncUDPSocket::SetReceiveBatchSize(size_t batch_size) {
+  RTC_DCHECK_GE(batch_size, 1u);
+  batch_size = std::min(batch_size, kMaxReceiveBatchSize);
+  batch_.clear();
+  if (batch_size == 1)
+    return;
+  batch_.resize(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    batch_[i].data = buf_ + i * kBatchSlotSize;
+    batch_[i].capacity = kBatchSlotSize;
+  }
+}
+
 void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
   RTC_DCHECK(socket_.get() == socket);
+  if (!batch_.empty()) {
+    ReadBatch();
+    return;
+  }
 
   SocketAddress remote_addr;
   int64_t timestamp;
@@ -123,6 +160,35 @@ void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
       (timestamp > -1 ? PacketTime(timestamp, 0) : CreatePacketTime(0)));
 }
 
+void AsyncUDPSocket::ReadBatch() {
+  int count = socket_->RecvFromBatch(batch_.data(), batch_.size());
+  if (count < 0) {
+    // See OnReadEvent().
+    SocketAddress local_addr = socket_->GetLocalAddress();
+    LOG(LS_INFO) << "AsyncUDPSocket[" << local_addr.ToSensitiveString() << "] "
+                 << "receive failed with error " << socket_->GetError();
+    return;
+  }
+
+  bool destroyed = false;
+  destroyed_ = &destroyed;
+  for (int i = 0; i < count && !destroyed; ++i) {
+    const ReceivedDatagram& datagram = batch_[i];
+    if (datagram.truncated) {
+      LOG(LS_WARNING) << "Dropping datagram that does not fit in "
+                      << kBatchSlotSize << " bytes from "
+                      << datagram.address.ToSensitiveString();
+      continue;
+    }
+    SignalReadPacket(this, datagram.data, datagram.length, datagram.address,
+                     (datagram.timestamp > -1
+                          ? PacketTime(datagram.timestamp, 0)
+                          : CreatePacketTime(0)));
+  }
+  if (!destroyed)
+    destroyed_ = nullptr;
+}
+
 void AsyncUDPSocket::OnWriteEvent(AsyncSocket* socket) {
   SignalReadyToSend(this);
 }
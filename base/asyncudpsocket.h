@@ -12,6 +12,7 @@
 #define WEBRTC_BASE_ASYNCUDPSOCKET_H_
 
 #include <memory>
+#include <vector>
 
 #include "webrtc/base/asyncpacketsocket.h"
 #include "webrtc/base/socketfactory.h"
@@ -51,15 +52,37 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   int GetError() const override;
   void SetError(int error) override;
 
+  // Largest batch SetReceiveBatchSize accepts.
+  static const size_t kMaxReceiveBatchSize;
+
+  // Reads up to |batch_size| datagrams on each read event, with a single
+  // system call where the platform supports it, instead of one. Every
+  // datagram is still signalled with SignalReadPacket, back to back, so that
+  // cricket::BaseChannel hands them to the worker thread as one batch. When
+  // batching, datagrams that don't fit in the 2 KB slots of the receive buffer
+  // are dropped.
+  void SetReceiveBatchSize(size_t batch_size);
+
+  // Uses a single system call where the platform supports it, and signals
+  // SignalSentPacket for each packet sent.
+  int SendToBatch(const DatagramToSend* datagrams,
+                  const rtc::PacketOptions* options,
+                  size_t count) override;
+
  private:
   // Called when the underlying socket is ready to be read from.
   void OnReadEvent(AsyncSocket* socket);
+  void ReadBatch();
   // Called when the underlying socket is ready to send.
   void OnWriteEvent(AsyncSocket* socket);
 
   std::unique_ptr<AsyncSocket> socket_;
   char* buf_;
   size_t size_;
+  // Slots of |buf_| used when reading datagrams in batches.
+  std::vector<ReceivedDatagram> batch_;
+  // Set while signalling a batch, a handler may delete this socket.
+  bool* destroyed_;
 };
 
 }  // namespace rtc
@@ -0,0 +1,154 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <time.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/sigslot.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace rtc {
+namespace {
+
+const int kNumPackets = 50000;
+// Packets sent back to back, like a video frame packetized by a sender.
+const int kBurstSize = 32;
+const size_t kPacketSize = 1200;
+
+int64_t ProcessCpuTimeMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * kNumMicrosecsPerSec + ts.tv_nsec / kNumNanosecsPerMicrosec;
+}
+
+class Counter : public sigslot::has_slots<> {
+ public:
+  explicit Counter(PhysicalSocketServer* ss) : ss_(ss) {}
+
+  void OnReadEvent(AsyncSocket* socket) { ++read_events_; }
+  void OnReadPacket(AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const SocketAddress& remote_addr,
+                    const PacketTime& packet_time) {
+    if (++packets_ == expected_packets_)
+      ss_->WakeUp();
+  }
+
+  PhysicalSocketServer* const ss_;
+  int expected_packets_ = 0;
+  int read_events_ = 0;
+  int packets_ = 0;
+};
+
+// Sends |kNumPackets| over loopback in bursts, either one SendTo per packet or
+// one SendToBatch per burst, and reads them back |receive_batch_size| at a
+// time. Every read event of the receiving socket is one receive system call.
+void RunThroughputTest(size_t receive_batch_size,
+                       bool send_batch,
+                       const std::string& trace) {
+  PhysicalSocketServer ss;
+  SocketServerScope scope(&ss);
+
+  AsyncSocket* receive_socket = ss.CreateAsyncSocket(AF_INET, SOCK_DGRAM);
+  ASSERT_EQ(0, receive_socket->Bind(SocketAddress("127.0.0.1", 0)));
+  // Leaves room for whole bursts, so that losses don't skew the results.
+  receive_socket->SetOption(Socket::OPT_RCVBUF, 4 * 1024 * 1024);
+  Counter counter(&ss);
+  receive_socket->SignalReadEvent.connect(&counter, &Counter::OnReadEvent);
+  AsyncUDPSocket receiver(receive_socket);
+  receiver.SetReceiveBatchSize(receive_batch_size);
+  receiver.SignalReadPacket.connect(&counter, &Counter::OnReadPacket);
+
+  std::unique_ptr<AsyncUDPSocket> sender(
+      AsyncUDPSocket::Create(&ss, SocketAddress("127.0.0.1", 0)));
+  ASSERT_TRUE(sender);
+
+  const std::string payload(kPacketSize, 'x');
+  std::vector<DatagramToSend> burst(kBurstSize);
+  for (DatagramToSend& datagram : burst) {
+    datagram.data = payload.data();
+    datagram.length = payload.size();
+    datagram.address = receiver.GetLocalAddress();
+  }
+  std::vector<PacketOptions> options(kBurstSize);
+
+  const int64_t start_cpu_us = ProcessCpuTimeMicros();
+  const int64_t start_us = TimeMicros();
+  int send_calls = 0;
+  for (int sent = 0; sent < kNumPackets; sent += kBurstSize) {
+    counter.expected_packets_ = sent + kBurstSize;
+    if (send_batch) {
+      ASSERT_EQ(kBurstSize,
+                sender->SendToBatch(burst.data(), options.data(), kBurstSize));
+      ++send_calls;
+    } else {
+      for (int i = 0; i < kBurstSize; ++i) {
+        ASSERT_EQ(static_cast<int>(kPacketSize),
+                  sender->SendTo(payload.data(), payload.size(),
+                                 receiver.GetLocalAddress(), options[i]));
+        ++send_calls;
+      }
+    }
+    // Drains the burst, Wait() is woken up by its last packet.
+    if (counter.packets_ < counter.expected_packets_)
+      ss.Wait(100, true);
+  }
+  const int64_t elapsed_us = TimeMicros() - start_us;
+  const int64_t cpu_us = ProcessCpuTimeMicros() - start_cpu_us;
+  const int num_sent = (kNumPackets + kBurstSize - 1) / kBurstSize * kBurstSize;
+  ASSERT_GT(counter.packets_, 0);
+
+  webrtc::test::PrintResult("recv_calls", "", trace,
+                            static_cast<size_t>(counter.read_events_ * 1000 /
+                                                counter.packets_),
+                            "calls/kpacket", true);
+  webrtc::test::PrintResult("send_calls", "", trace,
+                            static_cast<size_t>(send_calls * 1000 / num_sent),
+                            "calls/kpacket", false);
+  webrtc::test::PrintResult("cpu", "", trace,
+                            static_cast<size_t>(cpu_us * 1000 /
+                                                counter.packets_),
+                            "ns/packet", true);
+  webrtc::test::PrintResult("throughput", "", trace,
+                            static_cast<size_t>(
+                                counter.packets_ * kNumMicrosecsPerSec /
+                                std::max<int64_t>(elapsed_us, 1)),
+                            "packets/s", false);
+  webrtc::test::PrintResult("lost", "", trace,
+                            static_cast<size_t>(num_sent - counter.packets_),
+                            "packets", false);
+}
+
+}  // namespace
+
+TEST(AsyncUdpSocketPerformanceTest, Unbatched) {
+  RunThroughputTest(1, false, "unbatched");
+}
+
+TEST(AsyncUdpSocketPerformanceTest, BatchedReceive) {
+  RunThroughputTest(AsyncUDPSocket::kMaxReceiveBatchSize, false,
+                    "batched_receive");
+}
+
+TEST(AsyncUdpSocketPerformanceTest, Batched) {
+  RunThroughputTest(AsyncUDPSocket::kMaxReceiveBatchSize, true, "batched");
+}
+
+}  // namespace rtc
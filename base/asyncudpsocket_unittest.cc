@@ -10,10 +10,12 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "webrtc/base/asyncudpsocket.h"
 #include "webrtc/base/gunit.h"
 #include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/thread.h"
 #include "webrtc/base/virtualsocketserver.h"
 
 namespace rtc {
@@ -50,4 +52,100 @@ TEST_F(AsyncUdpSocketTest, OnWriteEvent) {
   EXPECT_TRUE(ready_to_send_);
 }
 
+// Virtual sockets use the default RecvFromBatch, which can only tell that a
+// datagram filled its whole buffer.
+TEST_F(AsyncUdpSocketTest, DefaultRecvFromBatchReportsTruncation) {
+  SocketServerScope scope(vss_.get());
+  std::unique_ptr<AsyncSocket> receiver(vss_->CreateAsyncSocket(SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress("127.0.0.1", 0)));
+  std::unique_ptr<AsyncSocket> sender(vss_->CreateAsyncSocket(SOCK_DGRAM));
+  ASSERT_EQ(0, sender->Bind(SocketAddress("127.0.0.1", 0)));
+  const std::string packets[] = {std::string(64, 'a'), std::string(63, 'b')};
+  for (const std::string& packet : packets) {
+    EXPECT_EQ(static_cast<int>(packet.size()),
+              sender->SendTo(packet.data(), packet.size(),
+                             receiver->GetLocalAddress()));
+  }
+  vss_->ProcessMessagesUntilIdle();
+
+  char buffer[2][64];
+  ReceivedDatagram datagrams[2];
+  for (int i = 0; i < 2; ++i) {
+    datagrams[i].data = buffer[i];
+    datagrams[i].capacity = sizeof(buffer[i]);
+  }
+  ASSERT_EQ(2, receiver->RecvFromBatch(datagrams, 2));
+  EXPECT_TRUE(datagrams[0].truncated);
+  EXPECT_FALSE(datagrams[1].truncated);
+  EXPECT_EQ(63u, datagrams[1].length);
+  EXPECT_EQ(sender->GetLocalAddress(), datagrams[1].address);
+}
+
+// Batched I/O goes through real sockets, to exercise recvmmsg and sendmmsg
+// where they are available.
+class AsyncUdpSocketBatchTest
+    : public testing::Test,
+      public sigslot::has_slots<> {
+ public:
+  AsyncUdpSocketBatchTest()
+      : pss_(new PhysicalSocketServer),
+        scope_(pss_.get()),
+        sender_(AsyncUDPSocket::Create(pss_.get(),
+                                       SocketAddress("127.0.0.1", 0))),
+        receiver_(AsyncUDPSocket::Create(pss_.get(),
+                                         SocketAddress("127.0.0.1", 0))) {
+    receiver_->SignalReadPacket.connect(this,
+                                        &AsyncUdpSocketBatchTest::OnReadPacket);
+  }
+
+  void OnReadPacket(AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const SocketAddress& remote_addr,
+                    const PacketTime& packet_time) {
+    packets_.push_back(std::string(data, size));
+    EXPECT_EQ(sender_->GetLocalAddress(), remote_addr);
+    EXPECT_GT(packet_time.timestamp, 0);
+  }
+
+  // Sends |packets| in a single batch.
+  void SendBatch(const std::vector<std::string>& packets) {
+    std::vector<DatagramToSend> datagrams(packets.size());
+    for (size_t i = 0; i < packets.size(); ++i) {
+      datagrams[i].data = packets[i].data();
+      datagrams[i].length = packets[i].size();
+      datagrams[i].address = receiver_->GetLocalAddress();
+    }
+    std::vector<PacketOptions> options(packets.size());
+    EXPECT_EQ(static_cast<int>(packets.size()),
+              sender_->SendToBatch(datagrams.data(), options.data(),
+                                   datagrams.size()));
+  }
+
+ protected:
+  std::unique_ptr<PhysicalSocketServer> pss_;
+  SocketServerScope scope_;
+  std::unique_ptr<AsyncUDPSocket> sender_;
+  std::unique_ptr<AsyncUDPSocket> receiver_;
+  std::vector<std::string> packets_;
+};
+
+TEST_F(AsyncUdpSocketBatchTest, ReceivesAllPacketsInOrder) {
+  receiver_->SetReceiveBatchSize(8);
+  std::vector<std::string> packets;
+  for (int i = 0; i < 20; ++i)
+    packets.push_back(std::string(100 + i, 'a' + i));
+  SendBatch(packets);
+  EXPECT_EQ_WAIT(packets.size(), packets_.size(), 1000);
+  EXPECT_EQ(packets, packets_);
+}
+
+TEST_F(AsyncUdpSocketBatchTest, DropsPacketsLargerThanBatchSlot) {
+  receiver_->SetReceiveBatchSize(AsyncUDPSocket::kMaxReceiveBatchSize);
+  SendBatch({std::string(1200, 'a'), std::string(4000, 'b'), "c"});
+  EXPECT_EQ_WAIT(2u, packets_.size(), 1000);
+  EXPECT_EQ(std::string(1200, 'a'), packets_[0]);
+  EXPECT_EQ("c", packets_[1]);
+}
+
 }  // namespace rtc
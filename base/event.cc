@@ -53,6 +53,26 @@ bool Event::Wait(int milliseconds) {
 
 #elif defined(WEBRTC_POSIX)
 
+namespace {
+pthread_key_t g_wait_observer_tls;
+pthread_once_t g_wait_observer_once = PTHREAD_ONCE_INIT;
+
+void InitializeWaitObserverTls() {
+  RTC_CHECK(pthread_key_create(&g_wait_observer_tls, nullptr) == 0);
+}
+
+pthread_key_t GetWaitObserverTls() {
+  RTC_CHECK(pthread_once(&g_wait_observer_once, &InitializeWaitObserverTls) ==
+            0);
+  return g_wait_observer_tls;
+}
+}  // namespace
+
+// static
+void EventWaitObserver::SetForCurrentThread(EventWaitObserver* observer) {
+  RTC_CHECK(pthread_setspecific(GetWaitObserverTls(), observer) == 0);
+}
+
 Event::Event(bool manual_reset, bool initially_signaled)
     : is_manual_reset_(manual_reset),
       event_status_(initially_signaled) {
@@ -107,6 +127,17 @@ bool Event::Wait(int milliseconds) {
   }
 
   pthread_mutex_lock(&event_mutex_);
+  // The observer is only told about waits that block.
+  EventWaitObserver* observer = nullptr;
+  if (!event_status_ && milliseconds != 0) {
+    observer = static_cast<EventWaitObserver*>(
+        pthread_getspecific(GetWaitObserverTls()));
+  }
+  if (observer) {
+    pthread_mutex_unlock(&event_mutex_);
+    observer->OnWaitStarted();
+    pthread_mutex_lock(&event_mutex_);
+  }
   if (milliseconds != kForever) {
     while (!event_status_ && error == 0) {
 #ifdef HAVE_PTHREAD_COND_TIMEDWAIT_RELATIVE
@@ -128,6 +159,8 @@ bool Event::Wait(int milliseconds) {
     event_status_ = false;
 
   pthread_mutex_unlock(&event_mutex_);
+  if (observer)
+    observer->OnWaitEnded();
 
   return (error == 0);
 }
@@ -21,6 +21,21 @@
 
 namespace rtc {
 
+#if defined(WEBRTC_POSIX)
+// Told when the thread it is set for starts and stops waiting in Event::Wait,
+// so that a thread pool can make up for its threads that block.
+class EventWaitObserver {
+ public:
+  static void SetForCurrentThread(EventWaitObserver* observer);
+
+  virtual void OnWaitStarted() = 0;
+  virtual void OnWaitEnded() = 0;
+
+ protected:
+  virtual ~EventWaitObserver() {}
+};
+#endif
+
 class Event {
  public:
   static const int kForever = -1;
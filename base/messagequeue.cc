@@ -506,9 +506,18 @@ void MessageQueue::Clear(MessageHandler* phandler,
     }
   }
 
-  // Remove from priority queue. Not directly iterable, so use this approach
-
-  PriorityQueue::container_type::iterator new_end = dmsgq_.container().begin();
+  // Remove from priority queue. Not directly iterable, so use this approach.
+  // Handlers are cleared far more often than they have delayed messages
+  // pending, e.g. by every MessageHandler destructor, so leave the heap
+  // alone, rather than rebuild it, unless something is removed.
+
+  PriorityQueue::container_type::iterator new_end = std::find_if(
+      dmsgq_.container().begin(), dmsgq_.container().end(),
+      [phandler, id](const DelayedMessage& dmsg) {
+        return dmsg.msg_.Match(phandler, id);
+      });
+  if (new_end == dmsgq_.container().end())
+    return;
   for (PriorityQueue::container_type::iterator it = new_end;
        it != dmsgq_.container().end(); ++it) {
     if (it->msg_.Match(phandler, id)) {
@@ -28,6 +28,11 @@
 #include <signal.h>
 #endif
 
+#if defined(WEBRTC_USE_EPOLL)
+#include <poll.h>
+#include <sys/epoll.h>
+#endif
+
 #if defined(WEBRTC_WIN)
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -123,9 +128,9 @@ static const int ICMP_PING_TIMEOUT_MILLIS = 10000u;
 #endif
 
 PhysicalSocket::PhysicalSocket(PhysicalSocketServer* ss, SOCKET s)
-  : ss_(ss), s_(s), enabled_events_(0), error_(0),
+  : ss_(ss), s_(s), error_(0),
     state_((s == INVALID_SOCKET) ? CS_CLOSED : CS_CONNECTED),
-    resolver_(nullptr) {
+    resolver_(nullptr), enabled_events_(0) {
 #if defined(WEBRTC_WIN)
   // EnsureWinsockInit() ensures that winsock is initialized. The default
   // version of this function doesn't do anything because winsock is
@@ -135,7 +140,7 @@ PhysicalSocket::PhysicalSocket(PhysicalSocketServer* ss, SOCKET s)
   EnsureWinsockInit();
 #endif
   if (s_ != INVALID_SOCKET) {
-    enabled_events_ = DE_READ | DE_WRITE;
+    SetEnabledEvents(DE_READ | DE_WRITE);
 
     int type = SOCK_STREAM;
     socklen_t len = sizeof(type);
@@ -154,7 +159,7 @@ bool PhysicalSocket::Create(int family, int type) {
   udp_ = (SOCK_DGRAM == type);
   UpdateLastError();
   if (udp_)
-    enabled_events_ = DE_READ | DE_WRITE;
+    SetEnabledEvents(DE_READ | DE_WRITE);
   return s_ != INVALID_SOCKET;
 }
 
@@ -244,12 +249,12 @@ int PhysicalSocket::DoConnect(const SocketAddress& connect_addr) {
     state_ = CS_CONNECTED;
   } else if (IsBlockingError(GetError())) {
     state_ = CS_CONNECTING;
-    enabled_events_ |= DE_CONNECT;
+    EnableEvents(DE_CONNECT);
   } else {
     return SOCKET_ERROR;
   }
 
-  enabled_events_ |= DE_READ | DE_WRITE;
+  EnableEvents(DE_READ | DE_WRITE);
   return 0;
 }
 
@@ -315,7 +320,7 @@ int PhysicalSocket::Send(const void* pv, size_t cb) {
   RTC_DCHECK(sent <= static_cast<int>(cb));
   if ((sent > 0 && sent < static_cast<int>(cb)) ||
       (sent < 0 && IsBlockingError(GetError()))) {
-    enabled_events_ |= DE_WRITE;
+    EnableEvents(DE_WRITE);
   }
   return sent;
 }
@@ -340,7 +345,7 @@ int PhysicalSocket::SendTo(const void* buffer,
   RTC_DCHECK(sent <= static_cast<int>(length));
   if ((sent > 0 && sent < static_cast<int>(length)) ||
       (sent < 0 && IsBlockingError(GetError()))) {
-    enabled_events_ |= DE_WRITE;
+    EnableEvents(DE_WRITE);
   }
   return sent;
 }
@@ -355,7 +360,7 @@ int PhysicalSocket::Recv(void* buffer, size_t length, int64_t* timestamp) {
     LOG(LS_WARNING) << "EOF from socket; deferring close event";
     // Must turn this back on so that the select() loop will notice the close
     // event.
-    enabled_events_ |= DE_READ;
+    EnableEvents(DE_READ);
     SetError(EWOULDBLOCK);
     return SOCKET_ERROR;
   }
@@ -366,7 +371,7 @@ int PhysicalSocket::Recv(void* buffer, size_t length, int64_t* timestamp) {
   int error = GetError();
   bool success = (received >= 0) || IsBlockingError(error);
   if (udp_ || success) {
-    enabled_events_ |= DE_READ;
+    EnableEvents(DE_READ);
   }
   if (!success) {
     LOG_F(LS_VERBOSE) << "Error = " << error;
@@ -392,20 +397,124 @@ int PhysicalSocket::RecvFrom(void* buffer,
   int error = GetError();
   bool success = (received >= 0) || IsBlockingError(error);
   if (udp_ || success) {
-    enabled_events_ |= DE_READ;
+    EnableEvents(DE_READ);
+  }
+  if (!success) {
+    LOG_F(LS_VERBOSE) << "Error = " << error;
+  }
+  return received;
+}
+
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+
+// Datagrams handled per recvmmsg and sendmmsg call, bounds the stack usage.
+static const size_t kMaxBatchSize = 64;
+
+int PhysicalSocket::RecvFromBatch(ReceivedDatagram* datagrams, size_t count) {
+  if (!batch_timestamps_enabled_) {
+    int value = 1;
+    if (::setsockopt(s_, SOL_SOCKET, SO_TIMESTAMP, &value, sizeof(value)) != 0)
+      LOG_ERR(LS_WARNING) << "setsockopt SO_TIMESTAMP";
+    batch_timestamps_enabled_ = true;
+  }
+  count = std::min(count, kMaxBatchSize);
+
+  struct mmsghdr msgs[kMaxBatchSize];
+  struct iovec iovs[kMaxBatchSize];
+  sockaddr_storage addrs[kMaxBatchSize];
+  char controls[kMaxBatchSize][CMSG_SPACE(sizeof(struct timeval))];
+  memset(msgs, 0, sizeof(msgs[0]) * count);
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = datagrams[i].data;
+    iovs[i].iov_len = datagrams[i].capacity;
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_control = controls[i];
+    msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+  }
+  int received =
+      ::recvmmsg(s_, msgs, static_cast<unsigned int>(count), 0, nullptr);
+  UpdateLastError();
+  int error = GetError();
+  bool success = (received >= 0) || IsBlockingError(error);
+  if (udp_ || success) {
+    EnableEvents(DE_READ);
   }
   if (!success) {
     LOG_F(LS_VERBOSE) << "Error = " << error;
   }
+
+  for (int i = 0; i < received; ++i) {
+    const struct msghdr& hdr = msgs[i].msg_hdr;
+    ReceivedDatagram& datagram = datagrams[i];
+    datagram.length = msgs[i].msg_len;
+    datagram.truncated = (hdr.msg_flags & MSG_TRUNC) != 0;
+    SocketAddressFromSockAddrStorage(addrs[i], &datagram.address);
+    datagram.timestamp = -1;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+         cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&hdr), cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP) {
+        struct timeval tv;
+        memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+        datagram.timestamp =
+            kNumMicrosecsPerSec * static_cast<int64_t>(tv.tv_sec) +
+            static_cast<int64_t>(tv.tv_usec);
+      }
+    }
+  }
   return received;
 }
 
+int PhysicalSocket::SendToBatch(const DatagramToSend* datagrams,
+                                size_t count) {
+  struct mmsghdr msgs[kMaxBatchSize];
+  struct iovec iovs[kMaxBatchSize];
+  sockaddr_storage addrs[kMaxBatchSize];
+  size_t total_sent = 0;
+  while (total_sent < count) {
+    size_t batch_size = std::min(count - total_sent, kMaxBatchSize);
+    memset(msgs, 0, sizeof(msgs[0]) * batch_size);
+    for (size_t i = 0; i < batch_size; ++i) {
+      const DatagramToSend& datagram = datagrams[total_sent + i];
+      iovs[i].iov_base = const_cast<void*>(datagram.data);
+      iovs[i].iov_len = datagram.length;
+      msgs[i].msg_hdr.msg_name = &addrs[i];
+      msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(
+          datagram.address.ToSockAddrStorage(&addrs[i]));
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    // Suppress SIGPIPE. See Send() for explanation.
+    int sent = ::sendmmsg(s_, msgs, static_cast<unsigned int>(batch_size),
+                          MSG_NOSIGNAL);
+    UpdateLastError();
+    MaybeRemapSendError();
+    if (sent < 0) {
+      if (IsBlockingError(GetError()))
+        EnableEvents(DE_WRITE);
+      return total_sent > 0 ? static_cast<int>(total_sent) : sent;
+    }
+    total_sent += sent;
+    if (static_cast<size_t>(sent) < batch_size) {
+      // sendmmsg stops at the first datagram that fails, the error is
+      // reported by the next call.
+      EnableEvents(DE_WRITE);
+      break;
+    }
+  }
+  return static_cast<int>(total_sent);
+}
+
+#endif  // WEBRTC_LINUX && !WEBRTC_ANDROID
+
 int PhysicalSocket::Listen(int backlog) {
   int err = ::listen(s_, backlog);
   UpdateLastError();
   if (err == 0) {
     state_ = CS_CONNECTING;
-    enabled_events_ |= DE_ACCEPT;
+    EnableEvents(DE_ACCEPT);
 #if !defined(NDEBUG)
     dbg_addr_ = "Listening @ ";
     dbg_addr_.append(GetLocalAddress().ToString());
@@ -417,7 +526,7 @@ int PhysicalSocket::Listen(int backlog) {
 AsyncSocket* PhysicalSocket::Accept(SocketAddress* out_addr) {
   // Always re-subscribe DE_ACCEPT to make sure new incoming connections will
   // trigger an event even if DoAccept returns an error here.
-  enabled_events_ |= DE_ACCEPT;
+  EnableEvents(DE_ACCEPT);
   sockaddr_storage addr_storage;
   socklen_t addr_len = sizeof(addr_storage);
   sockaddr* addr = reinterpret_cast<sockaddr*>(&addr_storage);
@@ -437,7 +546,7 @@ int PhysicalSocket::Close() {
   UpdateLastError();
   s_ = INVALID_SOCKET;
   state_ = CS_CLOSED;
-  enabled_events_ = 0;
+  SetEnabledEvents(0);
   if (resolver_) {
     resolver_->Destroy(false);
     resolver_ = nullptr;
@@ -528,6 +637,18 @@ int PhysicalSocket::DoSendTo(SOCKET socket,
   return ::sendto(socket, buf, len, flags, dest_addr, addrlen);
 }
 
+void PhysicalSocket::SetEnabledEvents(uint8_t events) {
+  enabled_events_ = events;
+}
+
+void PhysicalSocket::EnableEvents(uint8_t events) {
+  enabled_events_ |= events;
+}
+
+void PhysicalSocket::DisableEvents(uint8_t events) {
+  enabled_events_ &= ~events;
+}
+
 void PhysicalSocket::OnResolveResult(AsyncResolverInterface* resolver) {
   if (resolver != resolver_) {
     return;
@@ -595,6 +716,16 @@ int PhysicalSocket::TranslateOption(Option opt, int* slevel, int* sopt) {
       return -1;
     case OPT_RTP_SENDTIME_EXTN_ID:
       return -1;  // No logging is necessary as this not a OS socket option.
+    case OPT_REUSEPORT:
+#if defined(WEBRTC_LINUX) && defined(SO_REUSEPORT)
+      *slevel = SOL_SOCKET;
+      *sopt = SO_REUSEPORT;
+      break;
+#else
+      // Elsewhere SO_REUSEPORT does not load balance unicast datagrams.
+      LOG(LS_WARNING) << "Socket::OPT_REUSEPORT not supported.";
+      return -1;
+#endif
     default:
       RTC_NOTREACHED();
       return -1;
@@ -725,7 +856,7 @@ bool SocketDispatcher::IsDescriptorClosed() {
 #endif // WEBRTC_POSIX
 
 uint32_t SocketDispatcher::GetRequestedEvents() {
-  return enabled_events_;
+  return enabled_events();
 }
 
 void SocketDispatcher::OnPreEvent(uint32_t ff) {
@@ -749,7 +880,7 @@ void SocketDispatcher::OnEvent(uint32_t ff, int err) {
   if (((ff & DE_CONNECT) != 0) && (id_ == cache_id)) {
     if (ff != DE_CONNECT)
       LOG(LS_VERBOSE) << "Signalled with DE_CONNECT: " << ff;
-    enabled_events_ &= ~DE_CONNECT;
+    DisableEvents(DE_CONNECT);
 #if !defined(NDEBUG)
     dbg_addr_ = "Connected @ ";
     dbg_addr_.append(GetRemoteAddress().ToString());
@@ -757,15 +888,15 @@ void SocketDispatcher::OnEvent(uint32_t ff, int err) {
     SignalConnectEvent(this);
   }
   if (((ff & DE_ACCEPT) != 0) && (id_ == cache_id)) {
-    enabled_events_ &= ~DE_ACCEPT;
+    DisableEvents(DE_ACCEPT);
     SignalReadEvent(this);
   }
   if ((ff & DE_READ) != 0) {
-    enabled_events_ &= ~DE_READ;
+    DisableEvents(DE_READ);
     SignalReadEvent(this);
   }
   if (((ff & DE_WRITE) != 0) && (id_ == cache_id)) {
-    enabled_events_ &= ~DE_WRITE;
+    DisableEvents(DE_WRITE);
     SignalWriteEvent(this);
   }
   if (((ff & DE_CLOSE) != 0) && (id_ == cache_id)) {
@@ -777,33 +908,81 @@ void SocketDispatcher::OnEvent(uint32_t ff, int err) {
 #elif defined(WEBRTC_POSIX)
 
 void SocketDispatcher::OnEvent(uint32_t ff, int err) {
+#if defined(WEBRTC_USE_EPOLL)
+  StartBatchedEventUpdates();
+#endif
   // Make sure we deliver connect/accept first. Otherwise, consumers may see
   // something like a READ followed by a CONNECT, which would be odd.
   if ((ff & DE_CONNECT) != 0) {
-    enabled_events_ &= ~DE_CONNECT;
+    DisableEvents(DE_CONNECT);
     SignalConnectEvent(this);
   }
   if ((ff & DE_ACCEPT) != 0) {
-    enabled_events_ &= ~DE_ACCEPT;
+    DisableEvents(DE_ACCEPT);
     SignalReadEvent(this);
   }
   if ((ff & DE_READ) != 0) {
-    enabled_events_ &= ~DE_READ;
+    DisableEvents(DE_READ);
     SignalReadEvent(this);
   }
   if ((ff & DE_WRITE) != 0) {
-    enabled_events_ &= ~DE_WRITE;
+    DisableEvents(DE_WRITE);
     SignalWriteEvent(this);
   }
+#if defined(WEBRTC_USE_EPOLL)
+  // Before the close event, the socket may be deleted by its handler.
+  FinishBatchedEventUpdates();
+#endif
   if ((ff & DE_CLOSE) != 0) {
     // The socket is now dead to us, so stop checking it.
-    enabled_events_ = 0;
+    SetEnabledEvents(0);
     SignalCloseEvent(this, err);
   }
 }
 
 #endif // WEBRTC_POSIX
 
+#if defined(WEBRTC_USE_EPOLL)
+
+void SocketDispatcher::StartBatchedEventUpdates() {
+  RTC_DCHECK_EQ(saved_enabled_events_, -1);
+  saved_enabled_events_ = enabled_events();
+}
+
+void SocketDispatcher::FinishBatchedEventUpdates() {
+  RTC_DCHECK_NE(saved_enabled_events_, -1);
+  uint8_t old_events = static_cast<uint8_t>(saved_enabled_events_);
+  saved_enabled_events_ = -1;
+  MaybeUpdateDispatcher(old_events);
+}
+
+void SocketDispatcher::MaybeUpdateDispatcher(uint8_t old_events) {
+  if (enabled_events() != old_events && saved_enabled_events_ == -1 &&
+      s_ != INVALID_SOCKET) {
+    ss_->Update(this);
+  }
+}
+
+void SocketDispatcher::SetEnabledEvents(uint8_t events) {
+  uint8_t old_events = enabled_events();
+  PhysicalSocket::SetEnabledEvents(events);
+  MaybeUpdateDispatcher(old_events);
+}
+
+void SocketDispatcher::EnableEvents(uint8_t events) {
+  uint8_t old_events = enabled_events();
+  PhysicalSocket::EnableEvents(events);
+  MaybeUpdateDispatcher(old_events);
+}
+
+void SocketDispatcher::DisableEvents(uint8_t events) {
+  uint8_t old_events = enabled_events();
+  PhysicalSocket::DisableEvents(events);
+  MaybeUpdateDispatcher(old_events);
+}
+
+#endif  // WEBRTC_USE_EPOLL
+
 int SocketDispatcher::Close() {
   if (s_ == INVALID_SOCKET)
     return 0;
@@ -1130,7 +1309,29 @@ class Signaler : public EventDispatcher {
 };
 
 PhysicalSocketServer::PhysicalSocketServer()
-    : fWait_(false) {
+    : PhysicalSocketServer(Backend::kSelect) {
+}
+
+PhysicalSocketServer::PhysicalSocketServer(Backend backend)
+    :
+#if defined(WEBRTC_USE_EPOLL)
+      epoll_fd_(INVALID_SOCKET),
+      next_epoll_key_(0),
+#endif
+      fWait_(false) {
+#if defined(WEBRTC_USE_EPOLL)
+  if (backend == Backend::kEpoll) {
+    // The size argument is ignored by the kernel but must be positive.
+    epoll_fd_ = epoll_create(FD_SETSIZE);
+    if (epoll_fd_ == -1) {
+      LOG_E(LS_WARNING, EN, errno) << "epoll_create, falling back to select";
+      epoll_fd_ = INVALID_SOCKET;
+    }
+  }
+#else
+  if (backend == Backend::kEpoll)
+    LOG(LS_WARNING) << "epoll is not available, falling back to select";
+#endif
   signal_wakeup_ = new Signaler(this, &fWait_);
 #if defined(WEBRTC_WIN)
   socket_ev_ = WSACreateEvent();
@@ -1145,9 +1346,22 @@ PhysicalSocketServer::~PhysicalSocketServer() {
   signal_dispatcher_.reset();
 #endif
   delete signal_wakeup_;
+#if defined(WEBRTC_USE_EPOLL)
+  RTC_DCHECK(epoll_entries_.empty());
+  if (epoll_fd_ != INVALID_SOCKET)
+    close(epoll_fd_);
+#endif
   RTC_DCHECK(dispatchers_.empty());
 }
 
+PhysicalSocketServer::Backend PhysicalSocketServer::backend() const {
+#if defined(WEBRTC_USE_EPOLL)
+  if (epoll_fd_ != INVALID_SOCKET)
+    return Backend::kEpoll;
+#endif
+  return Backend::kSelect;
+}
+
 void PhysicalSocketServer::WakeUp() {
   signal_wakeup_->Signal();
 }
@@ -1192,6 +1406,12 @@ AsyncSocket* PhysicalSocketServer::WrapSocket(SOCKET s) {
 
 void PhysicalSocketServer::Add(Dispatcher *pdispatcher) {
   CritScope cs(&crit_);
+#if defined(WEBRTC_USE_EPOLL)
+  if (epoll_fd_ != INVALID_SOCKET) {
+    AddEpoll(pdispatcher);
+    return;
+  }
+#endif
   // Prevent duplicates. This can cause dead dispatchers to stick around.
   DispatcherList::iterator pos = std::find(dispatchers_.begin(),
                                            dispatchers_.end(),
@@ -1203,6 +1423,12 @@ void PhysicalSocketServer::Add(Dispatcher *pdispatcher) {
 
 void PhysicalSocketServer::Remove(Dispatcher *pdispatcher) {
   CritScope cs(&crit_);
+#if defined(WEBRTC_USE_EPOLL)
+  if (epoll_fd_ != INVALID_SOCKET) {
+    RemoveEpoll(pdispatcher);
+    return;
+  }
+#endif
   DispatcherList::iterator pos = std::find(dispatchers_.begin(),
                                            dispatchers_.end(),
                                            pdispatcher);
@@ -1224,8 +1450,87 @@ void PhysicalSocketServer::Remove(Dispatcher *pdispatcher) {
   }
 }
 
+void PhysicalSocketServer::Update(Dispatcher* pdispatcher) {
+#if defined(WEBRTC_USE_EPOLL)
+  if (epoll_fd_ == INVALID_SOCKET)
+    return;
+
+  CritScope cs(&crit_);
+  auto it = epoll_entries_.find(pdispatcher);
+  // Sockets report changes before they are added and after they are removed.
+  if (it != epoll_entries_.end())
+    UpdateEpoll(pdispatcher, &it->second);
+#endif
+}
+
 #if defined(WEBRTC_POSIX)
+
+// Translates the readiness of the descriptor of |pdispatcher| to dispatcher
+// events and delivers them. Shared by the select, epoll and poll loops.
+static void ProcessEvents(Dispatcher* pdispatcher,
+                          bool readable,
+                          bool writable,
+                          bool check_error) {
+  int errcode = 0;
+  // Reap any error code, which can be signaled through reads or writes.
+  // TODO(pthatcher): Should we set errcode if getsockopt fails?
+  if (check_error) {
+    socklen_t len = sizeof(errcode);
+    ::getsockopt(pdispatcher->GetDescriptor(), SOL_SOCKET, SO_ERROR, &errcode,
+                 &len);
+  }
+
+  uint32_t ff = 0;
+  // Check readable descriptors. If we're waiting on an accept, signal
+  // that. Otherwise we're waiting for data, check to see if we're
+  // readable or really closed.
+  // TODO(pthatcher): Only peek at TCP descriptors.
+  if (readable) {
+    if (pdispatcher->GetRequestedEvents() & DE_ACCEPT) {
+      ff |= DE_ACCEPT;
+    } else if (errcode || pdispatcher->IsDescriptorClosed()) {
+      ff |= DE_CLOSE;
+    } else {
+      ff |= DE_READ;
+    }
+  }
+
+  // Check writable descriptors. If we're waiting on a connect, detect
+  // success versus failure by the reaped error code.
+  if (writable) {
+    if (pdispatcher->GetRequestedEvents() & DE_CONNECT) {
+      if (!errcode) {
+        ff |= DE_CONNECT;
+      } else {
+        ff |= DE_CLOSE;
+      }
+    } else {
+      ff |= DE_WRITE;
+    }
+  }
+
+  // Tell the descriptor about the event.
+  if (ff != 0) {
+    pdispatcher->OnPreEvent(ff);
+    pdispatcher->OnEvent(ff, errcode);
+  }
+}
+
 bool PhysicalSocketServer::Wait(int cmsWait, bool process_io) {
+#if defined(WEBRTC_USE_EPOLL)
+  if (epoll_fd_ != INVALID_SOCKET) {
+    // Without I/O only the wakeup signaler is waited for. It is polled on its
+    // own, as select can't handle the descriptors above FD_SETSIZE that
+    // epoll is used for.
+    if (!process_io)
+      return WaitPoll(cmsWait, signal_wakeup_);
+    return WaitEpoll(cmsWait);
+  }
+#endif
+  return WaitSelect(cmsWait, process_io);
+}
+
+bool PhysicalSocketServer::WaitSelect(int cmsWait, bool process_io) {
   // Calculate timing information
 
   struct timeval *ptvWait = NULL;
@@ -1311,51 +1616,15 @@ bool PhysicalSocketServer::Wait(int cmsWait, bool process_io) {
       for (size_t i = 0; i < dispatchers_.size(); ++i) {
         Dispatcher *pdispatcher = dispatchers_[i];
         int fd = pdispatcher->GetDescriptor();
-        uint32_t ff = 0;
-        int errcode = 0;
-
-        // Reap any error code, which can be signaled through reads or writes.
-        // TODO(pthatcher): Should we set errcode if getsockopt fails?
-        if (FD_ISSET(fd, &fdsRead) || FD_ISSET(fd, &fdsWrite)) {
-          socklen_t len = sizeof(errcode);
-          ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &errcode, &len);
-        }
 
-        // Check readable descriptors. If we're waiting on an accept, signal
-        // that. Otherwise we're waiting for data, check to see if we're
-        // readable or really closed.
-        // TODO(pthatcher): Only peek at TCP descriptors.
-        if (FD_ISSET(fd, &fdsRead)) {
+        bool readable = FD_ISSET(fd, &fdsRead);
+        if (readable)
           FD_CLR(fd, &fdsRead);
-          if (pdispatcher->GetRequestedEvents() & DE_ACCEPT) {
-            ff |= DE_ACCEPT;
-          } else if (errcode || pdispatcher->IsDescriptorClosed()) {
-            ff |= DE_CLOSE;
-          } else {
-            ff |= DE_READ;
-          }
-        }
-
-        // Check writable descriptors. If we're waiting on a connect, detect
-        // success versus failure by the reaped error code.
-        if (FD_ISSET(fd, &fdsWrite)) {
+        bool writable = FD_ISSET(fd, &fdsWrite);
+        if (writable)
           FD_CLR(fd, &fdsWrite);
-          if (pdispatcher->GetRequestedEvents() & DE_CONNECT) {
-            if (!errcode) {
-              ff |= DE_CONNECT;
-            } else {
-              ff |= DE_CLOSE;
-            }
-          } else {
-            ff |= DE_WRITE;
-          }
-        }
 
-        // Tell the descriptor about the event.
-        if (ff != 0) {
-          pdispatcher->OnPreEvent(ff);
-          pdispatcher->OnEvent(ff, errcode);
-        }
+        ProcessEvents(pdispatcher, readable, writable, readable || writable);
       }
     }
 
@@ -1383,6 +1652,194 @@ bool PhysicalSocketServer::Wait(int cmsWait, bool process_io) {
   return true;
 }
 
+#if defined(WEBRTC_USE_EPOLL)
+
+// Number of ready descriptors handled per epoll_wait call. More are returned
+// by the next call, epoll(7) rotates through the ready list.
+static const int kNumEpollEvents = 128;
+
+static uint32_t GetEpollEvents(uint32_t ff) {
+  uint32_t events = 0;
+  if (ff & (DE_READ | DE_ACCEPT))
+    events |= EPOLLIN;
+  if (ff & (DE_WRITE | DE_CONNECT))
+    events |= EPOLLOUT;
+  return events;
+}
+
+void PhysicalSocketServer::AddEpoll(Dispatcher* pdispatcher) {
+  // As with select, duplicate calls to Add are ignored.
+  if (epoll_entries_.find(pdispatcher) != epoll_entries_.end())
+    return;
+
+  EpollEntry entry;
+  entry.key = next_epoll_key_++;
+  entry.events = 0;
+  UpdateEpoll(pdispatcher, &entry);
+  epoll_entries_[pdispatcher] = entry;
+  epoll_dispatchers_[entry.key] = pdispatcher;
+}
+
+void PhysicalSocketServer::RemoveEpoll(Dispatcher* pdispatcher) {
+  auto it = epoll_entries_.find(pdispatcher);
+  if (it == epoll_entries_.end()) {
+    LOG(LS_WARNING) << "PhysicalSocketServer asked to remove a unknown "
+                    << "dispatcher, potentially from a duplicate call to Add.";
+    return;
+  }
+
+  if (it->second.events != 0) {
+    // Before kernel 2.6.9 the event must be non null even though it is
+    // ignored.
+    struct epoll_event event = {0};
+    int fd = pdispatcher->GetDescriptor();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &event) == -1 &&
+        errno != ENOENT && errno != EBADF) {
+      LOG_E(LS_WARNING, EN, errno) << "epoll_ctl EPOLL_CTL_DEL " << fd;
+    }
+  }
+  epoll_dispatchers_.erase(it->second.key);
+  epoll_entries_.erase(it);
+}
+
+// The descriptor is only registered while it has events enabled: level
+// triggered epoll reports hang ups and errors even when no events are
+// requested, which would otherwise wake Wait() up repeatedly for sockets
+// nobody is waiting on.
+void PhysicalSocketServer::UpdateEpoll(Dispatcher* pdispatcher,
+                                       EpollEntry* entry) {
+  uint32_t events = GetEpollEvents(pdispatcher->GetRequestedEvents());
+  if (events == entry->events)
+    return;
+
+  int op = EPOLL_CTL_MOD;
+  if (entry->events == 0) {
+    op = EPOLL_CTL_ADD;
+  } else if (events == 0) {
+    op = EPOLL_CTL_DEL;
+  }
+  struct epoll_event event = {0};
+  event.events = events;
+  event.data.u64 = entry->key;
+  int fd = pdispatcher->GetDescriptor();
+  if (epoll_ctl(epoll_fd_, op, fd, &event) == -1) {
+    LOG_E(LS_ERROR, EN, errno) << "epoll_ctl " << op << " " << fd;
+    return;
+  }
+  entry->events = events;
+}
+
+bool PhysicalSocketServer::WaitEpoll(int cmsWait) {
+  RTC_DCHECK(epoll_fd_ != INVALID_SOCKET);
+  int64_t msWait = -1;
+  int64_t msStop = -1;
+  if (cmsWait != kForever) {
+    msWait = cmsWait;
+    msStop = TimeAfter(cmsWait);
+  }
+
+  struct epoll_event events[kNumEpollEvents];
+  fWait_ = true;
+
+  while (fWait_) {
+    // Wait then call handlers as appropriate
+    // < 0 means error
+    // 0 means timeout
+    // > 0 means count of descriptors ready
+    int n = epoll_wait(epoll_fd_, events, kNumEpollEvents,
+                       static_cast<int>(msWait));
+    if (n < 0) {
+      if (errno != EINTR) {
+        LOG_E(LS_ERROR, EN, errno) << "epoll";
+        return false;
+      }
+      // Else ignore the error and keep going. If this EINTR was for one of the
+      // signals managed by this PhysicalSocketServer, the
+      // PosixSignalDeliveryDispatcher will be in the signaled state in the next
+      // iteration.
+    } else if (n == 0) {
+      // If timeout, return success
+      return true;
+    } else {
+      // We have signaled descriptors
+      CritScope cr(&crit_);
+      for (int i = 0; i < n; ++i) {
+        const struct epoll_event& event = events[i];
+        auto it = epoll_dispatchers_.find(event.data.u64);
+        if (it == epoll_dispatchers_.end()) {
+          // Removed by the handler of an earlier event of this batch.
+          continue;
+        }
+        Dispatcher* pdispatcher = it->second;
+
+        // Errors and hang ups make the descriptor both readable and writable,
+        // as select reports them, but only for the events still requested.
+        uint32_t requested = GetEpollEvents(pdispatcher->GetRequestedEvents());
+        bool error = (event.events & (EPOLLERR | EPOLLHUP)) != 0;
+        bool readable =
+            (requested & EPOLLIN) && (error || (event.events & EPOLLIN));
+        bool writable =
+            (requested & EPOLLOUT) && (error || (event.events & EPOLLOUT));
+        ProcessEvents(pdispatcher, readable, writable, error);
+      }
+    }
+
+    if (cmsWait != kForever) {
+      msWait = std::max<int64_t>(TimeDiff(msStop, TimeMillis()), 0);
+    }
+  }
+
+  return true;
+}
+
+bool PhysicalSocketServer::WaitPoll(int cmsWait, Dispatcher* dispatcher) {
+  RTC_DCHECK(dispatcher);
+  int64_t msWait = -1;
+  int64_t msStop = -1;
+  if (cmsWait != kForever) {
+    msWait = cmsWait;
+    msStop = TimeAfter(cmsWait);
+  }
+
+  struct pollfd fds = {0};
+  fds.fd = dispatcher->GetDescriptor();
+  fWait_ = true;
+
+  while (fWait_) {
+    uint32_t events = GetEpollEvents(dispatcher->GetRequestedEvents());
+    fds.events = 0;
+    if (events & EPOLLIN)
+      fds.events |= POLLIN;
+    if (events & EPOLLOUT)
+      fds.events |= POLLOUT;
+    fds.revents = 0;
+
+    int n = poll(&fds, 1, static_cast<int>(msWait));
+    if (n < 0) {
+      if (errno != EINTR) {
+        LOG_E(LS_ERROR, EN, errno) << "poll";
+        return false;
+      }
+    } else if (n == 0) {
+      return true;
+    } else {
+      bool error = (fds.revents & (POLLERR | POLLHUP)) != 0;
+      bool readable = (fds.events & POLLIN) && (error || (fds.revents & POLLIN));
+      bool writable =
+          (fds.events & POLLOUT) && (error || (fds.revents & POLLOUT));
+      ProcessEvents(dispatcher, readable, writable, error);
+    }
+
+    if (cmsWait != kForever) {
+      msWait = std::max<int64_t>(TimeDiff(msStop, TimeMillis()), 0);
+    }
+  }
+
+  return true;
+}
+
+#endif  // WEBRTC_USE_EPOLL
+
 static void GlobalSignalHandler(int signum) {
   PosixSignalHandler::Instance()->OnPosixSignalReceived(signum);
 }
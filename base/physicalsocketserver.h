@@ -11,7 +11,13 @@
 #ifndef WEBRTC_BASE_PHYSICALSOCKETSERVER_H__
 #define WEBRTC_BASE_PHYSICALSOCKETSERVER_H__
 
+#if defined(WEBRTC_LINUX)
+// On Linux, PhysicalSocketServer can use epoll(7) instead of select(2).
+#define WEBRTC_USE_EPOLL 1
+#endif
+
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "webrtc/base/nethelpers.h"
@@ -57,7 +63,15 @@ class Dispatcher {
 // A socket server that provides the real sockets of the underlying OS.
 class PhysicalSocketServer : public SocketServer {
  public:
+  // How Wait() waits for dispatchers to become ready. kSelect rebuilds the
+  // fd_sets from every dispatcher on each iteration and is limited to
+  // FD_SETSIZE descriptors. kEpoll keeps the descriptors registered with the
+  // kernel and only visits the ready ones; it falls back to kSelect where
+  // epoll is not available.
+  enum class Backend { kSelect, kEpoll };
+
   PhysicalSocketServer();
+  explicit PhysicalSocketServer(Backend backend);
   ~PhysicalSocketServer() override;
 
   // SocketFactory:
@@ -76,6 +90,10 @@ class PhysicalSocketServer : public SocketServer {
 
   void Add(Dispatcher* dispatcher);
   void Remove(Dispatcher* dispatcher);
+  // Must be called when the events requested by |dispatcher| change.
+  void Update(Dispatcher* dispatcher);
+
+  Backend backend() const;
 
 #if defined(WEBRTC_POSIX)
   // Sets the function to be executed in response to the specified POSIX signal.
@@ -101,7 +119,29 @@ class PhysicalSocketServer : public SocketServer {
 #if defined(WEBRTC_POSIX)
   static bool InstallSignal(int signum, void (*handler)(int));
 
+  bool WaitSelect(int cms, bool process_io);
+
   std::unique_ptr<PosixSignalDispatcher> signal_dispatcher_;
+#endif
+#if defined(WEBRTC_USE_EPOLL)
+  struct EpollEntry {
+    // Identifies the dispatcher in epoll events, never reused so that events
+    // of a removed dispatcher are not delivered to one added later.
+    uint64_t key;
+    // Events the descriptor is registered for, 0 when not registered.
+    uint32_t events;
+  };
+
+  void AddEpoll(Dispatcher* dispatcher);
+  void RemoveEpoll(Dispatcher* dispatcher);
+  void UpdateEpoll(Dispatcher* dispatcher, EpollEntry* entry);
+  bool WaitEpoll(int cms);
+  bool WaitPoll(int cms, Dispatcher* dispatcher);
+
+  int epoll_fd_;
+  uint64_t next_epoll_key_;
+  std::unordered_map<Dispatcher*, EpollEntry> epoll_entries_;
+  std::unordered_map<uint64_t, Dispatcher*> epoll_dispatchers_;
 #endif
   DispatcherList dispatchers_;
   IteratorList iterators_;
@@ -146,6 +186,12 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
                SocketAddress* out_addr,
                int64_t* timestamp) override;
 
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+  // Use recvmmsg(2) and sendmmsg(2).
+  int RecvFromBatch(ReceivedDatagram* datagrams, size_t count) override;
+  int SendToBatch(const DatagramToSend* datagrams, size_t count) override;
+#endif
+
   int Listen(int backlog) override;
   AsyncSocket* Accept(SocketAddress* out_addr) override;
 
@@ -158,6 +204,13 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
  protected:
   int DoConnect(const SocketAddress& connect_addr);
 
+  // All changes to |enabled_events_| go through these, so that the socket
+  // server can be told when the requested events change.
+  uint8_t enabled_events() const { return enabled_events_; }
+  virtual void SetEnabledEvents(uint8_t events);
+  virtual void EnableEvents(uint8_t events);
+  virtual void DisableEvents(uint8_t events);
+
   // Make virtual so ::accept can be overwritten in tests.
   virtual SOCKET DoAccept(SOCKET socket, sockaddr* addr, socklen_t* addrlen);
 
@@ -177,7 +230,6 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
 
   PhysicalSocketServer* ss_;
   SOCKET s_;
-  uint8_t enabled_events_;
   bool udp_;
   CriticalSection crit_;
   int error_ GUARDED_BY(crit_);
@@ -187,6 +239,14 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
 #if !defined(NDEBUG)
   std::string dbg_addr_;
 #endif
+
+ private:
+  uint8_t enabled_events_;
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+  // SO_TIMESTAMP is enabled on the first batched read, to get the receive
+  // time of each datagram.
+  bool batch_timestamps_enabled_ = false;
+#endif
 };
 
 class SocketDispatcher : public Dispatcher, public PhysicalSocket {
@@ -215,6 +275,25 @@ class SocketDispatcher : public Dispatcher, public PhysicalSocket {
 
   int Close() override;
 
+#if defined(WEBRTC_USE_EPOLL)
+ protected:
+  void SetEnabledEvents(uint8_t events) override;
+  void EnableEvents(uint8_t events) override;
+  void DisableEvents(uint8_t events) override;
+
+ private:
+  // While the events are dispatched, changes to the enabled events are only
+  // forwarded to the socket server once, after all signals were handled.
+  // Reading a datagram disables and then re-enables DE_READ, so this saves
+  // two epoll_ctl calls per packet.
+  void StartBatchedEventUpdates();
+  void FinishBatchedEventUpdates();
+  void MaybeUpdateDispatcher(uint8_t old_events);
+
+  // Enabled events when the batch started, or -1 outside of OnEvent.
+  int saved_enabled_events_ = -1;
+#endif
+
 #if defined(WEBRTC_WIN)
  private:
   static int next_id_;
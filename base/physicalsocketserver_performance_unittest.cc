@@ -0,0 +1,163 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/logging.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/sigslot.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace rtc {
+namespace {
+
+const int kNumWakeups = 2000;
+
+int64_t ProcessCpuTimeMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * kNumMicrosecsPerSec + ts.tv_nsec / kNumNanosecsPerMicrosec;
+}
+
+// Makes sure |num_descriptors| more descriptors can be opened.
+bool RaiseDescriptorLimit(size_t num_descriptors) {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+    return false;
+  rlim_t needed = num_descriptors + 64;
+  if (limit.rlim_cur >= needed)
+    return true;
+  if (limit.rlim_max < needed)
+    return false;
+  limit.rlim_cur = needed;
+  return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+}
+
+class Receiver : public sigslot::has_slots<> {
+ public:
+  Receiver(PhysicalSocketServer* ss, AsyncSocket* socket)
+      : ss_(ss), socket_(socket) {
+    socket_->SignalReadEvent.connect(this, &Receiver::OnReadEvent);
+  }
+
+  void set_send_time_us(int64_t send_time_us) { send_time_us_ = send_time_us; }
+  const std::vector<int64_t>& latencies_us() const { return latencies_us_; }
+
+ private:
+  void OnReadEvent(AsyncSocket* socket) {
+    char buffer[64];
+    if (socket_->RecvFrom(buffer, sizeof(buffer), nullptr, nullptr) > 0) {
+      latencies_us_.push_back(TimeMicros() - send_time_us_);
+      ss_->WakeUp();
+    }
+  }
+
+  PhysicalSocketServer* const ss_;
+  AsyncSocket* const socket_;
+  int64_t send_time_us_ = 0;
+  std::vector<int64_t> latencies_us_;
+};
+
+// Opens |num_sockets| idle UDP sockets, all waiting to be readable like the
+// candidates of many PeerConnections, and measures the latency and CPU time
+// of waking Wait() up for a datagram sent to one more socket.
+void RunWakeupTest(PhysicalSocketServer::Backend backend,
+                   size_t num_sockets,
+                   const std::string& trace) {
+  if (!RaiseDescriptorLimit(num_sockets + 2)) {
+    LOG(LS_WARNING) << "Can't open " << num_sockets << " sockets, skipping.";
+    return;
+  }
+  PhysicalSocketServer ss(backend);
+  ASSERT_EQ(backend, ss.backend());
+
+  std::vector<std::unique_ptr<AsyncSocket>> idle_sockets;
+  for (size_t i = 0; i < num_sockets; ++i) {
+    AsyncSocket* socket = ss.CreateAsyncSocket(AF_INET, SOCK_DGRAM);
+    ASSERT_TRUE(socket);
+    idle_sockets.emplace_back(socket);
+    ASSERT_EQ(0, socket->Bind(SocketAddress("127.0.0.1", 0)));
+  }
+  std::unique_ptr<AsyncSocket> receive_socket(
+      ss.CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receive_socket->Bind(SocketAddress("127.0.0.1", 0)));
+  std::unique_ptr<AsyncSocket> send_socket(
+      ss.CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  Receiver receiver(&ss, receive_socket.get());
+
+  // Delivers the initial write events of the new sockets.
+  ss.Wait(100, true);
+
+  const SocketAddress address = receive_socket->GetLocalAddress();
+  const char kData[] = "wakeup";
+  const int64_t start_cpu_us = ProcessCpuTimeMicros();
+  const int64_t start_us = TimeMicros();
+  for (int i = 0; i < kNumWakeups; ++i) {
+    receiver.set_send_time_us(TimeMicros());
+    ASSERT_EQ(static_cast<int>(sizeof(kData)),
+              send_socket->SendTo(kData, sizeof(kData), address));
+    ASSERT_TRUE(ss.Wait(1000, true));
+  }
+  const int64_t elapsed_us = TimeMicros() - start_us;
+  const int64_t cpu_us = ProcessCpuTimeMicros() - start_cpu_us;
+  ASSERT_EQ(static_cast<size_t>(kNumWakeups), receiver.latencies_us().size());
+
+  std::vector<int64_t> latencies_us = receiver.latencies_us();
+  std::sort(latencies_us.begin(), latencies_us.end());
+  webrtc::test::PrintResult("wakeup_latency_median", "", trace,
+                            static_cast<size_t>(
+                                latencies_us[latencies_us.size() / 2]),
+                            "us", true);
+  webrtc::test::PrintResult("wakeup_latency_p99", "", trace,
+                            static_cast<size_t>(
+                                latencies_us[latencies_us.size() * 99 / 100]),
+                            "us", false);
+  webrtc::test::PrintResult("wakeup_cpu", "", trace,
+                            static_cast<size_t>(cpu_us / kNumWakeups),
+                            "us/wakeup", true);
+  webrtc::test::PrintResult("wakeup_rate", "", trace,
+                            static_cast<size_t>(kNumWakeups *
+                                                kNumMicrosecsPerSec /
+                                                std::max<int64_t>(elapsed_us,
+                                                                  1)),
+                            "wakeups/s", false);
+}
+
+}  // namespace
+
+// select() can't wait on more than FD_SETSIZE (1024) descriptors, so it is
+// only measured with 1k sockets.
+TEST(PhysicalSocketServerPerformanceTest, Select1k) {
+  RunWakeupTest(PhysicalSocketServer::Backend::kSelect, 1000, "select_1k");
+}
+
+#if defined(WEBRTC_USE_EPOLL)
+TEST(PhysicalSocketServerPerformanceTest, Epoll1k) {
+  RunWakeupTest(PhysicalSocketServer::Backend::kEpoll, 1000, "epoll_1k");
+}
+
+TEST(PhysicalSocketServerPerformanceTest, Epoll5k) {
+  RunWakeupTest(PhysicalSocketServer::Backend::kEpoll, 5000, "epoll_5k");
+}
+
+TEST(PhysicalSocketServerPerformanceTest, Epoll10k) {
+  RunWakeupTest(PhysicalSocketServer::Backend::kEpoll, 10000, "epoll_10k");
+}
+#endif
+
+}  // namespace rtc
@@ -11,6 +11,9 @@
 #include <memory>
 #include <signal.h>
 #include <stdarg.h>
+#if defined(WEBRTC_POSIX)
+#include <sys/resource.h>
+#endif
 
 #include "webrtc/base/gunit.h"
 #include "webrtc/base/logging.h"
@@ -48,8 +51,8 @@ class FakeSocketDispatcher : public SocketDispatcher {
 
 class FakePhysicalSocketServer : public PhysicalSocketServer {
  public:
-  explicit FakePhysicalSocketServer(PhysicalSocketTest* test)
-    : test_(test) {
+  FakePhysicalSocketServer(PhysicalSocketTest* test, Backend backend)
+    : PhysicalSocketServer(backend), test_(test) {
   }
 
   AsyncSocket* CreateAsyncSocket(int type) override {
@@ -96,8 +99,10 @@ class PhysicalSocketTest : public SocketTest {
   int MaxSendSize() const { return max_send_size_; }
 
  protected:
-  PhysicalSocketTest()
-    : server_(new FakePhysicalSocketServer(this)),
+  explicit PhysicalSocketTest(
+      PhysicalSocketServer::Backend backend =
+          PhysicalSocketServer::Backend::kSelect)
+    : server_(new FakePhysicalSocketServer(this, backend)),
       scope_(server_.get()),
       fail_accept_(false),
       max_send_size_(-1) {
@@ -402,6 +407,125 @@ TEST_F(PhysicalSocketTest, TestGetSetOptionsIPv6) {
   SocketTest::TestGetSetOptionsIPv6();
 }
 
+#if defined(WEBRTC_LINUX)
+TEST_F(PhysicalSocketTest, TestReusePortIPv4) {
+  std::unique_ptr<AsyncSocket> socket1(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> socket2(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, socket1->SetOption(Socket::OPT_REUSEPORT, 1));
+  ASSERT_EQ(0, socket2->SetOption(Socket::OPT_REUSEPORT, 1));
+  ASSERT_EQ(0, socket1->Bind(SocketAddress(kIPv4Loopback, 0)));
+  EXPECT_EQ(0, socket2->Bind(socket1->GetLocalAddress()));
+  EXPECT_EQ(socket1->GetLocalAddress(), socket2->GetLocalAddress());
+}
+#endif
+
+#if defined(WEBRTC_USE_EPOLL)
+
+// Runs the socket tests that exercise every dispatcher event against the
+// epoll backend.
+class PhysicalSocketEpollTest : public PhysicalSocketTest {
+ protected:
+  PhysicalSocketEpollTest()
+      : PhysicalSocketTest(PhysicalSocketServer::Backend::kEpoll) {}
+};
+
+TEST_F(PhysicalSocketEpollTest, UsesEpoll) {
+  EXPECT_EQ(PhysicalSocketServer::Backend::kEpoll, server_->backend());
+}
+
+TEST_F(PhysicalSocketEpollTest, TestConnectIPv4) {
+  SocketTest::TestConnectIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestConnectFailIPv4) {
+  SocketTest::TestConnectFailIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestConnectAcceptErrorIPv4) {
+  ConnectInternalAcceptError(kIPv4Loopback);
+}
+
+TEST_F(PhysicalSocketEpollTest, TestWritableAfterPartialWriteIPv4) {
+  WritableAfterPartialWrite(kIPv4Loopback);
+}
+
+TEST_F(PhysicalSocketEpollTest, TestConnectWithClosedSocketIPv4) {
+  SocketTest::TestConnectWithClosedSocketIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestServerCloseDuringConnectIPv4) {
+  SocketTest::TestServerCloseDuringConnectIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestClientCloseDuringConnectIPv4) {
+  SocketTest::TestClientCloseDuringConnectIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestServerCloseIPv4) {
+  SocketTest::TestServerCloseIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestCloseInClosedCallbackIPv4) {
+  SocketTest::TestCloseInClosedCallbackIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestSocketServerWaitIPv4) {
+  SocketTest::TestSocketServerWaitIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestTcpIPv4) {
+  SocketTest::TestTcpIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestTcpIPv6) {
+  SocketTest::TestTcpIPv6();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestUdpIPv4) {
+  SocketTest::TestUdpIPv4();
+}
+
+TEST_F(PhysicalSocketEpollTest, TestUdpIPv6) {
+  SocketTest::TestUdpIPv6();
+}
+
+// Descriptors above FD_SETSIZE can't be used with select.
+TEST_F(PhysicalSocketEpollTest, ReceivesOnDescriptorsAboveFdSetSize) {
+  struct rlimit limit;
+  ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &limit));
+  if (limit.rlim_cur <= FD_SETSIZE + 16 && limit.rlim_max > FD_SETSIZE + 16) {
+    limit.rlim_cur = FD_SETSIZE + 16;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  std::vector<std::unique_ptr<SocketDispatcher>> sockets;
+  while (sockets.empty() || sockets.back()->GetDescriptor() < FD_SETSIZE) {
+    AsyncSocket* socket = server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM);
+    if (!socket) {
+      LOG(LS_INFO) << "Not enough descriptors available... skipping";
+      return;
+    }
+    sockets.emplace_back(static_cast<SocketDispatcher*>(socket));
+  }
+  AsyncSocket* receiver = sockets.back().get();
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  testing::StreamSink sink;
+  sink.Monitor(receiver);
+
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  const char kData[] = "data";
+  EXPECT_EQ(static_cast<int>(sizeof(kData)),
+            sender->SendTo(kData, sizeof(kData), receiver->GetLocalAddress()));
+  EXPECT_TRUE_WAIT(sink.Check(receiver, testing::SSE_READ), kTimeout);
+  char buffer[sizeof(kData)];
+  EXPECT_EQ(static_cast<int>(sizeof(kData)),
+            receiver->RecvFrom(buffer, sizeof(buffer), nullptr, nullptr));
+}
+
+#endif  // WEBRTC_USE_EPOLL
+
 #if defined(WEBRTC_POSIX)
 
 // We don't get recv timestamps on Mac.
@@ -500,6 +624,17 @@ TEST_F(PosixSignalDeliveryTest, SignalDuringWait) {
   EXPECT_TRUE(ExpectNone());
 }
 
+#if defined(WEBRTC_USE_EPOLL)
+TEST_F(PosixSignalDeliveryTest, SignalDuringEpollWait) {
+  ss_.reset(new PhysicalSocketServer(PhysicalSocketServer::Backend::kEpoll));
+  ss_->SetPosixSignalHandler(SIGALRM, &RecordSignal);
+  alarm(1);
+  EXPECT_TRUE(ss_->Wait(1500, true));
+  EXPECT_TRUE(ExpectSignal(SIGALRM));
+  EXPECT_TRUE(ExpectNone());
+}
+#endif
+
 class RaiseSigTermRunnable : public Runnable {
   void Run(Thread *thread) {
     thread->socketserver()->Wait(1000, false);
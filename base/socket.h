@@ -133,6 +133,27 @@ struct SentPacket {
   int64_t send_time_ms;
 };
 
+// A datagram read by Socket::RecvFromBatch. |data| and |capacity| are set by
+// the caller, the other fields describe the datagram that was read.
+struct ReceivedDatagram {
+  char* data = nullptr;
+  size_t capacity = 0;
+  size_t length = 0;
+  SocketAddress address;
+  // In microseconds, -1 if not available.
+  int64_t timestamp = -1;
+  // Set when the datagram was longer than |capacity|. Implementations that
+  // can't tell also set it when the datagram is exactly |capacity| long.
+  bool truncated = false;
+};
+
+// A datagram sent by Socket::SendToBatch.
+struct DatagramToSend {
+  const void* data = nullptr;
+  size_t length = 0;
+  SocketAddress address;
+};
+
 // General interface for the socket implementations of various networks.  The
 // methods match those of normal UNIX sockets very closely.
 class Socket {
@@ -186,10 +207,44 @@ class Socket {
     OPT_RTP_SENDTIME_EXTN_ID,  // This is a non-traditional socket option param.
                                // This is specific to libjingle and will be used
                                // if SendTime option is needed at socket level.
+    OPT_REUSEPORT,   // Lets sockets bind to the same address and port, with
+                     // the kernel spreading datagrams across them by flow.
+                     // Must be set before Bind(). Only supported on Linux.
   };
   virtual int GetOption(Option opt, int* value) = 0;
   virtual int SetOption(Option opt, int value) = 0;
 
+  // Reads up to |count| datagrams, with a single system call where the
+  // platform supports it. Returns the number of datagrams read, or
+  // SOCKET_ERROR if none could be read.
+  // RecvFrom does not report truncation, so this default implementation
+  // flags every datagram that fills its whole buffer as truncated.
+  virtual int RecvFromBatch(ReceivedDatagram* datagrams, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      ReceivedDatagram& datagram = datagrams[i];
+      int received = RecvFrom(datagram.data, datagram.capacity,
+                              &datagram.address, &datagram.timestamp);
+      if (received < 0)
+        return i > 0 ? static_cast<int>(i) : received;
+      datagram.length = static_cast<size_t>(received);
+      datagram.truncated = datagram.length >= datagram.capacity;
+    }
+    return static_cast<int>(count);
+  }
+
+  // Sends |count| datagrams, with as few system calls as the platform
+  // allows. Returns the number of datagrams sent, which is less than |count|
+  // if the socket would block, or SOCKET_ERROR if none could be sent.
+  virtual int SendToBatch(const DatagramToSend* datagrams, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      int sent = SendTo(datagrams[i].data, datagrams[i].length,
+                        datagrams[i].address);
+      if (sent < 0)
+        return i > 0 ? static_cast<int>(i) : sent;
+    }
+    return static_cast<int>(count);
+  }
+
  protected:
   Socket() {}
 
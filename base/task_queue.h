@@ -22,7 +22,9 @@
 #include "webrtc/base/constructormagic.h"
 #include "webrtc/base/criticalsection.h"
 
-#if defined(WEBRTC_WIN) || defined(WEBRTC_BUILD_LIBEVENT)
+#if defined(WEBRTC_BUILD_TASK_QUEUE_POOL)
+#include "webrtc/base/scoped_ref_ptr.h"
+#elif defined(WEBRTC_WIN) || defined(WEBRTC_BUILD_LIBEVENT)
 #include "webrtc/base/platform_thread.h"
 #endif
 
@@ -225,7 +227,14 @@ class LOCKABLE TaskQueue {
   }
 
  private:
-#if defined(WEBRTC_BUILD_LIBEVENT)
+#if defined(WEBRTC_BUILD_TASK_QUEUE_POOL)
+  class WorkerPool;
+  class TimerWheel;
+  class PostAndReplyTask;
+  struct QueueContext;
+
+  const scoped_refptr<QueueContext> context_;
+#elif defined(WEBRTC_BUILD_LIBEVENT)
   static bool ThreadMain(void* context);
   static void OnWakeup(int socket, short flags, void* context);  // NOLINT
   static void RunTask(int fd, short flags, void* context);       // NOLINT
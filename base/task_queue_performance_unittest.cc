@@ -0,0 +1,170 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/event.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/task_queue.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace rtc {
+namespace {
+
+const int kNumLaps = 50;
+const uint32_t kTimerIntervalMs = 10;
+const int kNumTimerRuns = 20;
+
+// Returns the number of threads of the process, or -1 if it can't be read.
+int CountThreads() {
+  FILE* file = fopen("/proc/self/status", "r");
+  if (!file)
+    return -1;
+  int threads = -1;
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    if (sscanf(line, "Threads: %d", &threads) == 1)
+      break;
+  }
+  fclose(file);
+  return threads;
+}
+
+std::vector<std::unique_ptr<TaskQueue>> CreateQueues(int num_queues) {
+  std::vector<std::unique_ptr<TaskQueue>> queues;
+  for (int i = 0; i < num_queues; ++i)
+    queues.emplace_back(new TaskQueue(("Queue" + ToString(i)).c_str()));
+  return queues;
+}
+
+// Passes a task around a ring of queues, as a frame passes from one stream's
+// queue to the next, and reports the time per hop along with the threads the
+// queues need.
+void RunRingTest(int num_queues) {
+  const int threads_before = CountThreads();
+  std::vector<std::unique_ptr<TaskQueue>> queues = CreateQueues(num_queues);
+
+  class HopTask : public QueuedTask {
+   public:
+    HopTask(std::vector<std::unique_ptr<TaskQueue>>* queues, Event* done)
+        : queues_(queues), done_(done) {}
+
+   private:
+    bool Run() override {
+      if (++hops_ == queues_->size() * kNumLaps) {
+        done_->Set();
+        return true;
+      }
+      (*queues_)[hops_ % queues_->size()]->PostTask(
+          std::unique_ptr<QueuedTask>(this));
+      return false;
+    }
+
+    std::vector<std::unique_ptr<TaskQueue>>* const queues_;
+    Event* const done_;
+    size_t hops_ = 0;
+  };
+
+  Event done(false, false);
+  const int64_t start_ns = SystemTimeNanos();
+  queues[0]->PostTask(
+      std::unique_ptr<QueuedTask>(new HopTask(&queues, &done)));
+  ASSERT_TRUE(done.Wait(10000));
+  const int64_t elapsed_ns = SystemTimeNanos() - start_ns;
+  const int threads = CountThreads() - threads_before;
+
+  const std::string trace = ToString(num_queues) + "_queues";
+  webrtc::test::PrintResult("task_queue_hop", "", trace,
+                            static_cast<size_t>(
+                                elapsed_ns / (num_queues * kNumLaps)),
+                            "ns", true);
+  if (threads_before >= 0) {
+    webrtc::test::PrintResult("task_queue_threads", "", trace,
+                              static_cast<size_t>(std::max(threads, 0)),
+                              "threads", false);
+  }
+}
+
+// Runs a periodic timer on every queue, as the pacers and statistics of many
+// streams do, and reports how late the timers fire.
+void RunTimerTest(int num_queues) {
+  std::vector<std::unique_ptr<TaskQueue>> queues = CreateQueues(num_queues);
+
+  class TimerTask : public QueuedTask {
+   public:
+    TimerTask(TaskQueue* queue, Event* done, int64_t* total_late_ms)
+        : queue_(queue),
+          done_(done),
+          total_late_ms_(total_late_ms),
+          due_ms_(TimeMillis() + kTimerIntervalMs) {}
+
+   private:
+    bool Run() override {
+      *total_late_ms_ += TimeMillis() - due_ms_;
+      if (++runs_ == kNumTimerRuns) {
+        done_->Set();
+        return true;
+      }
+      due_ms_ = TimeMillis() + kTimerIntervalMs;
+      queue_->PostDelayedTask(std::unique_ptr<QueuedTask>(this),
+                              kTimerIntervalMs);
+      return false;
+    }
+
+    TaskQueue* const queue_;
+    Event* const done_;
+    int64_t* const total_late_ms_;
+    int64_t due_ms_;
+    int runs_ = 0;
+  };
+
+  std::vector<std::unique_ptr<Event>> done;
+  std::vector<int64_t> late_ms(num_queues, 0);
+  for (int i = 0; i < num_queues; ++i) {
+    done.emplace_back(new Event(false, false));
+    queues[i]->PostDelayedTask(
+        std::unique_ptr<QueuedTask>(new TimerTask(
+            queues[i].get(), done.back().get(), &late_ms[i])),
+        kTimerIntervalMs);
+  }
+  int64_t total_late_ms = 0;
+  for (int i = 0; i < num_queues; ++i) {
+    ASSERT_TRUE(done[i]->Wait(10000));
+    total_late_ms += late_ms[i];
+  }
+
+  webrtc::test::PrintResult(
+      "task_queue_timer_late", "", ToString(num_queues) + "_queues",
+      static_cast<size_t>(total_late_ms * 1000 / (num_queues * kNumTimerRuns)),
+      "us", false);
+}
+
+}  // namespace
+
+TEST(TaskQueuePerformanceTest, Ring10Queues) {
+  RunRingTest(10);
+}
+
+TEST(TaskQueuePerformanceTest, Ring200Queues) {
+  RunRingTest(200);
+}
+
+TEST(TaskQueuePerformanceTest, Timers200Queues) {
+  RunTimerTest(200);
+}
+
+}  // namespace rtc
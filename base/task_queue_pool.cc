@@ -0,0 +1,653 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// This file contains the implementation of TaskQueue for Linux and Android.
+// Instead of a thread per queue, all queues share a fixed pool of worker
+// threads. A queue is a sequence of tasks that at most one worker runs at a
+// time, so its tasks still run one after the other, in the order posted.
+// Idle workers sleep on an eventfd and steal queues from busy ones. A worker
+// blocked in Event::Wait, typically on tasks it posted to other queues, is
+// made up for by another worker, started if need be. Delayed tasks wait in a
+// hierarchical timer wheel, driven by a single timer thread.
+
+#include "webrtc/base/task_queue.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/base/refcount.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/task_queue_posix.h"
+#include "webrtc/base/timeutils.h"
+
+namespace rtc {
+using internal::AutoSetCurrentQueuePtr;
+
+namespace {
+// Tasks are expected to be short, but a blocking task only takes one worker
+// out of the pool, so there are always a few of them.
+const int kMinWorkers = 4;
+const int kMaxWorkers = 16;
+// Workers started to make up for blocked ones. They stay in the pool, so their
+// number is the most workers ever blocked at once, up to this limit.
+const int kMaxExtraWorkers = 240;
+// The number of tasks a worker runs from one queue before the queue goes to
+// the back of the line, so that a busy queue can't starve the others.
+const int kMaxTasksPerSlice = 32;
+// The timer wheel ticks once per millisecond. Every level has 64 slots and a
+// slot spans all 64 slots of the level below, so six levels cover 2^36 ms,
+// more than any delay PostDelayedTask accepts.
+const int kWheelBits = 6;
+const int kWheelSlots = 1 << kWheelBits;
+const int kWheelLevels = 6;
+const int64_t kNoTick = std::numeric_limits<int64_t>::max();
+
+int CreateEventFd() {
+  int fd = eventfd(0, EFD_CLOEXEC);
+  RTC_CHECK(fd != -1) << "eventfd failed: " << errno;
+  return fd;
+}
+
+void SignalEventFd(int fd) {
+  const uint64_t value = 1;
+  while (write(fd, &value, sizeof(value)) != sizeof(value))
+    RTC_CHECK_EQ(EINTR, errno);
+}
+
+// Waits for |fd| to be signaled, or for |timeout_ms| to pass unless it's -1.
+void WaitEventFd(int fd, int timeout_ms) {
+  struct pollfd pfd = {fd, POLLIN, 0};
+  if (poll(&pfd, 1, timeout_ms) > 0) {
+    uint64_t value;
+    RTC_CHECK_EQ(static_cast<ssize_t>(sizeof(value)),
+                 read(fd, &value, sizeof(value)));
+  }
+}
+}  // namespace
+
+struct TaskQueue::QueueContext : public RefCountInterface {
+  QueueContext(TaskQueue* queue, const char* name)
+      : queue(queue), name(name), stopped(false, false) {}
+
+  // Appends |task| to the queue and, unless a worker has the queue already,
+  // hands the queue to the pool. Deletes |task| if the queue has stopped.
+  void PostTask(std::unique_ptr<QueuedTask> task);
+
+  // Runs the queue's tasks on the calling worker until the queue is empty or
+  // its slice is over. Returns true if the queue has more tasks to run.
+  bool RunTasks();
+
+  // Stops the queue, waits for a running task to finish and deletes pending
+  // tasks.
+  void Stop();
+
+  TaskQueue* const queue;
+  const std::string name;
+  CriticalSection lock;
+  std::deque<std::unique_ptr<QueuedTask>> tasks GUARDED_BY(lock);
+  // Set while the queue waits for a worker or a worker runs its tasks.
+  bool scheduled GUARDED_BY(lock) = false;
+  bool running GUARDED_BY(lock) = false;
+  bool is_active GUARDED_BY(lock) = true;
+  // Signaled when a task that ran while the queue stopped has finished.
+  Event stopped;
+};
+
+class TaskQueue::WorkerPool {
+ public:
+  static WorkerPool* Instance();
+
+  // Hands |queue| to a worker: the calling one if it is a worker, the next one
+  // in turn otherwise. Wakes an idle worker to run or steal it.
+  void Schedule(scoped_refptr<QueueContext> queue);
+
+  TimerWheel* timers() { return timers_.get(); }
+
+ private:
+  struct Worker : public EventWaitObserver {
+    Worker(WorkerPool* pool, size_t index, const std::string& name)
+        : pool(pool),
+          index(index),
+          wakeup_fd(CreateEventFd()),
+          thread(&WorkerPool::WorkerMain, this, name.c_str()) {}
+
+    void OnWaitStarted() override { pool->OnWorkerBlocked(this); }
+    void OnWaitEnded() override {
+      AtomicOps::Decrement(&pool->num_blocked_workers_);
+    }
+
+    WorkerPool* const pool;
+    const size_t index;
+    const int wakeup_fd;
+    PlatformThread thread;
+    CriticalSection lock;
+    std::deque<scoped_refptr<QueueContext>> run_queue GUARDED_BY(lock);
+  };
+
+  // The pool lives as long as the process and is never deleted.
+  WorkerPool();
+
+  static void CreateInstance();
+  static bool WorkerMain(void* context);
+
+  int num_workers() const { return AtomicOps::AcquireLoad(&num_workers_); }
+  // Starts another worker unless there are |num_initial_workers_| workers
+  // that aren't blocked.
+  void AddWorker();
+  void Run(Worker* worker);
+  // Takes the next queue off |worker|'s run queue, or steals one from another
+  // worker.
+  scoped_refptr<QueueContext> NextQueue(Worker* worker);
+  void WakeIdleWorker(Worker* preferred);
+  void RemoveIdleWorker(Worker* worker);
+  // Called when |worker| blocks in a task. Makes sure that enough workers run
+  // meanwhile, and that the queues waiting on |worker| get to one of them.
+  void OnWorkerBlocked(Worker* worker);
+
+  static WorkerPool* instance_;
+
+  pthread_key_t current_worker_;
+  int num_initial_workers_;
+  // Workers are only added, to the end. The first |num_workers_| are started
+  // and may be read without locking.
+  std::unique_ptr<Worker> workers_[kMaxWorkers + kMaxExtraWorkers];
+  volatile int num_workers_ = 0;
+  CriticalSection add_worker_lock_;
+  std::unique_ptr<TimerWheel> timers_;
+  volatile int next_worker_ = 0;
+  volatile int num_idle_workers_ = 0;
+  volatile int num_blocked_workers_ = 0;
+  CriticalSection idle_lock_;
+  std::vector<Worker*> idle_workers_ GUARDED_BY(idle_lock_);
+};
+
+class TaskQueue::TimerWheel {
+ public:
+  TimerWheel();
+
+  // Posts |task| to |queue| once |milliseconds| have passed.
+  void Add(scoped_refptr<QueueContext> queue,
+           std::unique_ptr<QueuedTask> task,
+           uint32_t milliseconds);
+
+  // Deletes all timers of |queue|.
+  void Cancel(QueueContext* queue);
+
+ private:
+  struct Timer {
+    Timer(int64_t expiry,
+          scoped_refptr<QueueContext> queue,
+          std::unique_ptr<QueuedTask> task)
+        : expiry(expiry), queue(std::move(queue)), task(std::move(task)) {}
+
+    const int64_t expiry;
+    scoped_refptr<QueueContext> queue;
+    std::unique_ptr<QueuedTask> task;
+  };
+  typedef std::list<Timer> Slot;
+
+  static bool ThreadMain(void* context);
+
+  void Run();
+  // Moves |timer| from |from| to the slot where it waits for its expiry.
+  void Insert(Slot* from, Slot::iterator timer)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Processes |next_tick_|: moves the timers of the higher level slots it
+  // reaches down, and the timers that expire on it to |expired|.
+  void ProcessTick(Slot* expired) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns the first tick from |next_tick_| on that reaches a slot with
+  // timers, or kNoTick if there are no timers.
+  int64_t NextBusyTick() const EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  CriticalSection lock_;
+  Slot slots_[kWheelLevels][kWheelSlots] GUARDED_BY(lock_);
+  size_t num_timers_ GUARDED_BY(lock_) = 0;
+  // Ticks before |next_tick_| have been processed.
+  int64_t next_tick_ GUARDED_BY(lock_);
+  // The tick the timer thread sleeps until.
+  int64_t wakeup_tick_ GUARDED_BY(lock_) = kNoTick;
+  const int wakeup_fd_;
+  PlatformThread thread_;
+};
+
+class TaskQueue::PostAndReplyTask : public QueuedTask {
+ public:
+  PostAndReplyTask(std::unique_ptr<QueuedTask> task,
+                   std::unique_ptr<QueuedTask> reply,
+                   scoped_refptr<QueueContext> reply_queue)
+      : task_(std::move(task)),
+        reply_(std::move(reply)),
+        reply_queue_(std::move(reply_queue)) {}
+
+ private:
+  bool Run() override {
+    if (!task_->Run())
+      task_.release();
+    // The reply is deleted instead if the reply queue is gone.
+    reply_queue_->PostTask(std::move(reply_));
+    return true;
+  }
+
+  std::unique_ptr<QueuedTask> task_;
+  std::unique_ptr<QueuedTask> reply_;
+  const scoped_refptr<QueueContext> reply_queue_;
+};
+
+void TaskQueue::QueueContext::PostTask(std::unique_ptr<QueuedTask> task) {
+  {
+    CritScope cs(&lock);
+    if (!is_active)
+      return;
+    tasks.push_back(std::move(task));
+    if (scheduled)
+      return;
+    scheduled = true;
+  }
+  WorkerPool::Instance()->Schedule(this);
+}
+
+bool TaskQueue::QueueContext::RunTasks() {
+  AutoSetCurrentQueuePtr set_current(queue);
+  for (int i = 0;; ++i) {
+    std::unique_ptr<QueuedTask> task;
+    {
+      CritScope cs(&lock);
+      if (running) {
+        running = false;
+        if (!is_active)
+          stopped.Set();
+      }
+      if (!is_active || tasks.empty()) {
+        scheduled = false;
+        return false;
+      }
+      if (i == kMaxTasksPerSlice)
+        return true;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+      running = true;
+    }
+    if (!task->Run())
+      task.release();
+  }
+}
+
+void TaskQueue::QueueContext::Stop() {
+  std::deque<std::unique_ptr<QueuedTask>> pending;
+  bool wait_for_task;
+  {
+    CritScope cs(&lock);
+    is_active = false;
+    pending.swap(tasks);
+    wait_for_task = running;
+  }
+  if (wait_for_task)
+    stopped.Wait(Event::kForever);
+}
+
+TaskQueue::WorkerPool* TaskQueue::WorkerPool::instance_ = nullptr;
+
+// static
+TaskQueue::WorkerPool* TaskQueue::WorkerPool::Instance() {
+  static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+  RTC_CHECK(pthread_once(&init_once, &CreateInstance) == 0);
+  return instance_;
+}
+
+// static
+void TaskQueue::WorkerPool::CreateInstance() {
+  instance_ = new WorkerPool();
+}
+
+TaskQueue::WorkerPool::WorkerPool() : timers_(new TimerWheel()) {
+  RTC_CHECK(pthread_key_create(&current_worker_, nullptr) == 0);
+  const long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);  // NOLINT
+  num_initial_workers_ = static_cast<int>(std::max<long>(  // NOLINT
+      kMinWorkers, std::min<long>(kMaxWorkers, num_cpus)));  // NOLINT
+  for (int i = 0; i < num_initial_workers_; ++i)
+    AddWorker();
+}
+
+void TaskQueue::WorkerPool::AddWorker() {
+  CritScope cs(&add_worker_lock_);
+  const int index = num_workers_;
+  if (index - AtomicOps::AcquireLoad(&num_blocked_workers_) >=
+          num_initial_workers_ ||
+      index == kMaxWorkers + kMaxExtraWorkers) {
+    return;
+  }
+  workers_[index].reset(
+      new Worker(this, index, "TaskQueueWorker" + ToString(index)));
+  AtomicOps::ReleaseStore(&num_workers_, index + 1);
+  workers_[index]->thread.Start();
+}
+
+void TaskQueue::WorkerPool::Schedule(scoped_refptr<QueueContext> queue) {
+  Worker* worker = static_cast<Worker*>(pthread_getspecific(current_worker_));
+  if (!worker) {
+    const unsigned int turn = AtomicOps::Increment(&next_worker_);
+    worker = workers_[turn % num_workers()].get();
+  }
+  {
+    CritScope cs(&worker->lock);
+    worker->run_queue.push_back(std::move(queue));
+  }
+  if (AtomicOps::AcquireLoad(&num_idle_workers_) > 0)
+    WakeIdleWorker(worker);
+}
+
+// static
+bool TaskQueue::WorkerPool::WorkerMain(void* context) {
+  Worker* worker = static_cast<Worker*>(context);
+  worker->pool->Run(worker);
+  return false;
+}
+
+void TaskQueue::WorkerPool::Run(Worker* worker) {
+  pthread_setspecific(current_worker_, worker);
+  EventWaitObserver::SetForCurrentThread(worker);
+  while (true) {
+    scoped_refptr<QueueContext> queue = NextQueue(worker);
+    if (!queue) {
+      {
+        CritScope cs(&idle_lock_);
+        idle_workers_.push_back(worker);
+        AtomicOps::Increment(&num_idle_workers_);
+      }
+      // A queue scheduled before this worker was listed as idle didn't wake
+      // anyone, so look again before going to sleep.
+      queue = NextQueue(worker);
+      if (!queue) {
+        WaitEventFd(worker->wakeup_fd, -1);
+        continue;
+      }
+      RemoveIdleWorker(worker);
+    }
+    if (queue->RunTasks())
+      Schedule(std::move(queue));
+  }
+}
+
+scoped_refptr<TaskQueue::QueueContext> TaskQueue::WorkerPool::NextQueue(
+    Worker* worker) {
+  scoped_refptr<QueueContext> queue;
+  {
+    CritScope cs(&worker->lock);
+    if (!worker->run_queue.empty()) {
+      queue = std::move(worker->run_queue.front());
+      worker->run_queue.pop_front();
+      return queue;
+    }
+  }
+  const size_t num_workers = this->num_workers();
+  for (size_t i = 1; i < num_workers; ++i) {
+    Worker* victim = workers_[(worker->index + i) % num_workers].get();
+    CritScope cs(&victim->lock);
+    if (!victim->run_queue.empty()) {
+      queue = std::move(victim->run_queue.back());
+      victim->run_queue.pop_back();
+      return queue;
+    }
+  }
+  return queue;
+}
+
+void TaskQueue::WorkerPool::WakeIdleWorker(Worker* preferred) {
+  Worker* worker;
+  {
+    CritScope cs(&idle_lock_);
+    if (idle_workers_.empty())
+      return;
+    // Unless the worker that has the queue is idle, wake the one that went
+    // idle last, as it is the most likely to still have a warm cache.
+    auto it = std::find(idle_workers_.begin(), idle_workers_.end(), preferred);
+    if (it == idle_workers_.end())
+      --it;
+    worker = *it;
+    idle_workers_.erase(it);
+    AtomicOps::Decrement(&num_idle_workers_);
+  }
+  SignalEventFd(worker->wakeup_fd);
+}
+
+void TaskQueue::WorkerPool::OnWorkerBlocked(Worker* worker) {
+  const int num_blocked = AtomicOps::Increment(&num_blocked_workers_);
+  if (num_workers() - num_blocked < num_initial_workers_) {
+    // The new worker steals the queues scheduled on |worker| once started.
+    AddWorker();
+    return;
+  }
+  bool has_queues;
+  {
+    CritScope cs(&worker->lock);
+    has_queues = !worker->run_queue.empty();
+  }
+  if (has_queues && AtomicOps::AcquireLoad(&num_idle_workers_) > 0)
+    WakeIdleWorker(nullptr);
+}
+
+void TaskQueue::WorkerPool::RemoveIdleWorker(Worker* worker) {
+  CritScope cs(&idle_lock_);
+  auto it = std::find(idle_workers_.begin(), idle_workers_.end(), worker);
+  // If the worker has been woken up already, its next wait returns right away.
+  if (it != idle_workers_.end()) {
+    idle_workers_.erase(it);
+    AtomicOps::Decrement(&num_idle_workers_);
+  }
+}
+
+TaskQueue::TimerWheel::TimerWheel()
+    : next_tick_(TimeMillis()),
+      wakeup_fd_(CreateEventFd()),
+      thread_(&TimerWheel::ThreadMain, this, "TaskQueueTimer") {
+  thread_.Start();
+}
+
+void TaskQueue::TimerWheel::Add(scoped_refptr<QueueContext> queue,
+                                std::unique_ptr<QueuedTask> task,
+                                uint32_t milliseconds) {
+  bool wake_up;
+  {
+    CritScope cs(&lock_);
+    const int64_t expiry = std::max(TimeMillis() + milliseconds, next_tick_);
+    Slot timer;
+    timer.emplace_back(expiry, std::move(queue), std::move(task));
+    Insert(&timer, timer.begin());
+    ++num_timers_;
+    wake_up = expiry < wakeup_tick_;
+    if (wake_up)
+      wakeup_tick_ = expiry;
+  }
+  if (wake_up)
+    SignalEventFd(wakeup_fd_);
+}
+
+void TaskQueue::TimerWheel::Cancel(QueueContext* queue) {
+  Slot canceled;
+  {
+    CritScope cs(&lock_);
+    for (int level = 0; level < kWheelLevels && num_timers_ > 0; ++level) {
+      for (Slot& slot : slots_[level]) {
+        for (auto it = slot.begin(); it != slot.end();) {
+          auto timer = it++;
+          if (timer->queue.get() == queue) {
+            canceled.splice(canceled.end(), slot, timer);
+            --num_timers_;
+          }
+        }
+      }
+    }
+  }
+  // The tasks are deleted here, without holding the lock.
+}
+
+// static
+bool TaskQueue::TimerWheel::ThreadMain(void* context) {
+  static_cast<TimerWheel*>(context)->Run();
+  return false;
+}
+
+void TaskQueue::TimerWheel::Run() {
+  while (true) {
+    Slot expired;
+    int timeout_ms = -1;
+    {
+      CritScope cs(&lock_);
+      const int64_t now = TimeMillis();
+      while (next_tick_ <= now) {
+        // Nothing happens on the ticks up to the next busy one.
+        const int64_t tick = NextBusyTick();
+        if (tick > now) {
+          next_tick_ = now + 1;
+          break;
+        }
+        next_tick_ = tick;
+        ProcessTick(&expired);
+      }
+      wakeup_tick_ = NextBusyTick();
+      if (wakeup_tick_ != kNoTick) {
+        timeout_ms = static_cast<int>(std::min<int64_t>(
+            wakeup_tick_ - now, std::numeric_limits<int>::max()));
+      }
+    }
+    for (Timer& timer : expired)
+      timer.queue->PostTask(std::move(timer.task));
+    expired.clear();
+    WaitEventFd(wakeup_fd_, timeout_ms);
+  }
+}
+
+void TaskQueue::TimerWheel::Insert(Slot* from, Slot::iterator timer) {
+  const int64_t delta = timer->expiry - next_tick_;
+  RTC_DCHECK_GE(delta, 0);
+  int level = 0;
+  while (level < kWheelLevels - 1 &&
+         delta >= (int64_t{1} << (kWheelBits * (level + 1)))) {
+    ++level;
+  }
+  const int index =
+      (timer->expiry >> (kWheelBits * level)) & (kWheelSlots - 1);
+  Slot* slot = &slots_[level][index];
+  slot->splice(slot->end(), *from, timer);
+}
+
+void TaskQueue::TimerWheel::ProcessTick(Slot* expired) {
+  const int64_t tick = next_tick_;
+  // A tick that starts a slot of a level reaches the slots starting there on
+  // all levels below. Their timers move down, top level first, so that the
+  // ones that expire on this tick end up in the level 0 slot processed below.
+  int top_level = 0;
+  while (top_level < kWheelLevels - 1 &&
+         (tick & ((int64_t{1} << (kWheelBits * (top_level + 1))) - 1)) == 0) {
+    ++top_level;
+  }
+  for (int level = top_level; level > 0; --level) {
+    Slot cascading;
+    cascading.swap(
+        slots_[level][(tick >> (kWheelBits * level)) & (kWheelSlots - 1)]);
+    while (!cascading.empty())
+      Insert(&cascading, cascading.begin());
+  }
+  Slot* slot = &slots_[0][tick & (kWheelSlots - 1)];
+  num_timers_ -= slot->size();
+  expired->splice(expired->end(), *slot);
+  ++next_tick_;
+}
+
+int64_t TaskQueue::TimerWheel::NextBusyTick() const {
+  if (num_timers_ == 0)
+    return kNoTick;
+  int64_t busy_tick = kNoTick;
+  for (int level = 0; level < kWheelLevels; ++level) {
+    const int shift = kWheelBits * level;
+    const int64_t block = next_tick_ >> shift;
+    // The slot holding |next_tick_| has been reached already, unless
+    // |next_tick_| is where the slot starts.
+    const int first = (next_tick_ & ((int64_t{1} << shift) - 1)) == 0 ? 0 : 1;
+    for (int i = first; i < first + kWheelSlots; ++i) {
+      const int64_t tick = (block + i) << shift;
+      if (tick >= busy_tick)
+        break;
+      if (!slots_[level][(block + i) & (kWheelSlots - 1)].empty()) {
+        busy_tick = tick;
+        break;
+      }
+    }
+  }
+  return busy_tick;
+}
+
+TaskQueue::TaskQueue(const char* queue_name)
+    : context_(new RefCountedObject<QueueContext>(this, queue_name)) {
+  RTC_DCHECK(queue_name);
+}
+
+TaskQueue::~TaskQueue() {
+  RTC_DCHECK(!IsCurrent());
+  // Timers that expire from now on find the queue stopped and delete their
+  // tasks, the others are deleted right away.
+  context_->Stop();
+  WorkerPool::Instance()->timers()->Cancel(context_.get());
+}
+
+// static
+TaskQueue* TaskQueue::Current() {
+  return static_cast<TaskQueue*>(
+      pthread_getspecific(internal::GetQueuePtrTls()));
+}
+
+// static
+bool TaskQueue::IsCurrent(const char* queue_name) {
+  TaskQueue* current = Current();
+  return current && current->context_->name == queue_name;
+}
+
+bool TaskQueue::IsCurrent() const {
+  return this == Current();
+}
+
+void TaskQueue::PostTask(std::unique_ptr<QueuedTask> task) {
+  context_->PostTask(std::move(task));
+}
+
+void TaskQueue::PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                                uint32_t milliseconds) {
+  WorkerPool::Instance()->timers()->Add(context_, std::move(task),
+                                        milliseconds);
+}
+
+void TaskQueue::PostTaskAndReply(std::unique_ptr<QueuedTask> task,
+                                 std::unique_ptr<QueuedTask> reply,
+                                 TaskQueue* reply_queue) {
+  PostTask(std::unique_ptr<QueuedTask>(new PostAndReplyTask(
+      std::move(task), std::move(reply), reply_queue->context_)));
+}
+
+void TaskQueue::PostTaskAndReply(std::unique_ptr<QueuedTask> task,
+                                 std::unique_ptr<QueuedTask> reply) {
+  return PostTaskAndReply(std::move(task), std::move(reply), Current());
+}
+
+}  // namespace rtc
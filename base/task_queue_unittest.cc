@@ -8,12 +8,15 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <vector>
 
 #include "webrtc/base/bind.h"
 #include "webrtc/base/event.h"
 #include "webrtc/base/gunit.h"
+#include "webrtc/base/stringencode.h"
 #include "webrtc/base/task_queue.h"
 #include "webrtc/base/timeutils.h"
 
@@ -122,6 +125,28 @@ TEST(TaskQueueTest, PostMultipleDelayed) {
     EXPECT_TRUE(e->Wait(100));
 }
 
+// Delays on both sides of a 64 ms boundary, where timers move between the
+// levels of a timer wheel.
+TEST(TaskQueueTest, PostDelayedRunsInOrderOfDelay) {
+  static const char kQueueName[] = "PostDelayedRunsInOrderOfDelay";
+  static const uint32_t kDelaysMs[] = {130, 10, 200, 63, 70, 1, 65, 150};
+  TaskQueue queue(kQueueName);
+
+  Event event(false, false);
+  std::vector<uint32_t> run_order;
+  for (uint32_t delay_ms : kDelaysMs) {
+    queue.PostDelayedTask([&run_order, delay_ms]() {
+      run_order.push_back(delay_ms);
+    }, delay_ms);
+  }
+  queue.PostDelayedTask([&event]() { event.Set(); }, 250);
+  EXPECT_TRUE(event.Wait(1000));
+
+  std::vector<uint32_t> expected(std::begin(kDelaysMs), std::end(kDelaysMs));
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(expected, run_order);
+}
+
 TEST(TaskQueueTest, PostDelayedAfterDestruct) {
   static const char kQueueName[] = "PostDelayedAfterDestruct";
   Event event(false, false);
@@ -229,6 +254,82 @@ TEST(TaskQueueTest, PostAndReply2) {
   EXPECT_TRUE(event.Wait(1000));
 }
 
+// Posts to many queues at once, so that they share threads. The tasks of each
+// queue must still run one at a time and in order.
+TEST(TaskQueueTest, PostToManyQueues) {
+  static const int kNumQueues = 50;
+  static const int kTasksPerQueue = 200;
+
+  struct QueueState {
+    bool running = false;
+    std::vector<int> run_order;
+  };
+  std::vector<QueueState> states(kNumQueues);
+  std::vector<std::unique_ptr<TaskQueue>> queues;
+  for (int i = 0; i < kNumQueues; ++i) {
+    queues.emplace_back(
+        new TaskQueue(("PostToManyQueues" + rtc::ToString(i)).c_str()));
+  }
+
+  std::vector<std::unique_ptr<Event>> events;
+  for (int i = 0; i < kTasksPerQueue; ++i) {
+    for (int j = 0; j < kNumQueues; ++j) {
+      QueueState* state = &states[j];
+      queues[j]->PostTask([state, i]() {
+        EXPECT_FALSE(state->running);
+        state->running = true;
+        state->run_order.push_back(i);
+        state->running = false;
+      });
+    }
+  }
+  for (const auto& queue : queues) {
+    events.push_back(std::unique_ptr<Event>(new Event(false, false)));
+    Event* event = events.back().get();
+    queue->PostTask([event]() { event->Set(); });
+  }
+  for (const auto& event : events)
+    EXPECT_TRUE(event->Wait(1000));
+
+  for (const QueueState& state : states) {
+    ASSERT_EQ(static_cast<size_t>(kTasksPerQueue), state.run_order.size());
+    for (int i = 0; i < kTasksPerQueue; ++i)
+      EXPECT_EQ(i, state.run_order[i]);
+  }
+}
+
+// Blocks a task on each of more queues than there are workers, until a task
+// posted to another queue has run, like encoders fanning out to per-layer
+// queues. Blocked workers must be made up for by new ones.
+TEST(TaskQueueTest, PostAndWaitOnManyQueues) {
+  static const int kNumQueues = 32;
+
+  std::vector<std::unique_ptr<TaskQueue>> queues;
+  std::vector<std::unique_ptr<TaskQueue>> partners;
+  std::vector<std::unique_ptr<Event>> events;
+  for (int i = 0; i < kNumQueues; ++i) {
+    queues.emplace_back(
+        new TaskQueue(("WaitingQueue" + rtc::ToString(i)).c_str()));
+    partners.emplace_back(
+        new TaskQueue(("PartnerQueue" + rtc::ToString(i)).c_str()));
+    events.push_back(std::unique_ptr<Event>(new Event(false, false)));
+  }
+
+  for (int i = 0; i < kNumQueues; ++i) {
+    TaskQueue* partner = partners[i].get();
+    Event* event = events[i].get();
+    queues[i]->PostTask([partner, event]() {
+      Event partner_done(false, false);
+      partner->PostTask([&partner_done]() { partner_done.Set(); });
+      // Bounded, so that a failure doesn't hang the test.
+      EXPECT_TRUE(partner_done.Wait(10000));
+      event->Set();
+    });
+  }
+  for (const auto& event : events)
+    EXPECT_TRUE(event->Wait(1000));
+}
+
 // Tests posting more messages than a queue can queue up.
 // In situations like that, tasks will get dropped.
 TEST(TaskQueueTest, PostALot) {
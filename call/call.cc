@@ -32,6 +32,7 @@
 #include "webrtc/call/bitrate_allocator.h"
 #include "webrtc/call/call.h"
 #include "webrtc/call/flexfec_receive_stream_impl.h"
+#include "webrtc/call/ssrc_map.h"
 #include "webrtc/config.h"
 #include "webrtc/logging/rtc_event_log/rtc_event_log.h"
 #include "webrtc/modules/bitrate_controller/include/bitrate_controller.h"
@@ -106,6 +107,9 @@ class Call : public webrtc::Call,
                                const uint8_t* packet,
                                size_t length,
                                const PacketTime& packet_time) override;
+  void DeliverPackets(MediaType media_type,
+                      rtc::ArrayView<const ReceivedPacket> packets,
+                      DeliveryStatus* statuses) override;
 
   // Implements RecoveredPacketReceiver.
   bool OnRecoveredPacket(const uint8_t* packet, size_t length) override;
@@ -141,12 +145,44 @@ class Call : public webrtc::Call,
                                  uint32_t max_padding_bitrate_bps) override;
 
  private:
+  // Receive streams an incoming SSRC maps to.
+  struct ReceiveSsrcEntry {
+    AudioReceiveStream* audio = nullptr;
+    VideoReceiveStream* video = nullptr;
+    // FlexFEC stream receiving its protection packets on this SSRC.
+    FlexfecReceiveStreamImpl* flexfec = nullptr;
+    // Whether media on this SSRC is protected by FlexFEC streams.
+    bool flexfec_protected = false;
+  };
+
   DeliveryStatus DeliverRtcp(MediaType media_type, const uint8_t* packet,
                              size_t length);
   DeliveryStatus DeliverRtp(MediaType media_type,
                             const uint8_t* packet,
                             size_t length,
                             const PacketTime& packet_time);
+  DeliveryStatus DeliverRtpToStreams(MediaType media_type,
+                                     uint32_t ssrc,
+                                     const ReceiveSsrcEntry& entry,
+                                     const uint8_t* packet,
+                                     size_t length,
+                                     const PacketTime& packet_time,
+                                     const rtc::CopyOnWriteBuffer* buffer)
+      SHARED_LOCKS_REQUIRED(receive_crit_);
+  struct RtpPacketToDeliver {
+    const ReceiveSsrcEntry* entry;
+    uint32_t ssrc;
+    size_t index;
+  };
+  // Delivers the RTP packets in [begin, end) of |packets|, grouped by SSRC.
+  // |rtp_packets| is scratch space.
+  void DeliverRtpPackets(MediaType media_type,
+                         rtc::ArrayView<const ReceivedPacket> packets,
+                         size_t begin,
+                         size_t end,
+                         DeliveryStatus* statuses,
+                         std::vector<RtpPacketToDeliver>* rtp_packets);
+  void UpdateReceiveSsrcLookup() EXCLUSIVE_LOCKS_REQUIRED(receive_crit_);
   void ConfigureSync(const std::string& sync_group)
       EXCLUSIVE_LOCKS_REQUIRED(receive_crit_);
 
@@ -159,9 +195,13 @@ class Call : public webrtc::Call,
       return nullptr;
   }
 
-  rtc::Optional<RtpPacketReceived> ParseRtpPacket(const uint8_t* packet,
-                                                  size_t length,
-                                                  const PacketTime& packet_time)
+  // Parses the packet in |buffer| if not null, sharing it instead of copying
+  // |packet|.
+  rtc::Optional<RtpPacketReceived> ParseRtpPacket(
+      const uint8_t* packet,
+      size_t length,
+      const PacketTime& packet_time,
+      const rtc::CopyOnWriteBuffer* buffer)
       SHARED_LOCKS_REQUIRED(receive_crit_);
 
   void UpdateSendHistograms() EXCLUSIVE_LOCKS_REQUIRED(&bitrate_crit_);
@@ -209,6 +249,10 @@ class Call : public webrtc::Call,
   // overhead.
   std::map<uint32_t, RtpHeaderExtensionMap> received_rtp_header_extensions_
       GUARDED_BY(receive_crit_);
+  // Flattened view of the maps above, rebuilt by UpdateReceiveSsrcLookup()
+  // whenever a receive stream is created or destroyed, so that delivering a
+  // packet costs a single hash table probe.
+  SsrcMap<ReceiveSsrcEntry> receive_ssrc_lookup_ GUARDED_BY(receive_crit_);
 
   std::unique_ptr<RWLockWrapper> send_crit_;
   // Audio and Video send streams are owned by the client that creates them.
@@ -366,9 +410,12 @@ Call::~Call() {
 rtc::Optional<RtpPacketReceived> Call::ParseRtpPacket(
     const uint8_t* packet,
     size_t length,
-    const PacketTime& packet_time) {
+    const PacketTime& packet_time,
+    const rtc::CopyOnWriteBuffer* buffer) {
   RtpPacketReceived parsed_packet;
-  if (!parsed_packet.Parse(packet, length))
+  bool parsed = buffer ? parsed_packet.Parse(*buffer)
+                       : parsed_packet.Parse(packet, length);
+  if (!parsed)
     return rtc::Optional<RtpPacketReceived>();
 
   auto it = received_rtp_header_extensions_.find(parsed_packet.Ssrc());
@@ -531,6 +578,7 @@ webrtc::AudioReceiveStream* Call::CreateAudioReceiveStream(
     RTC_DCHECK(audio_receive_ssrcs_.find(config.rtp.remote_ssrc) ==
                audio_receive_ssrcs_.end());
     audio_receive_ssrcs_[config.rtp.remote_ssrc] = receive_stream;
+    UpdateReceiveSsrcLookup();
     ConfigureSync(config.sync_group);
   }
   {
@@ -557,6 +605,7 @@ void Call::DestroyAudioReceiveStream(
     size_t num_deleted = audio_receive_ssrcs_.erase(
         audio_receive_stream->config().rtp.remote_ssrc);
     RTC_DCHECK(num_deleted == 1);
+    UpdateReceiveSsrcLookup();
     const std::string& sync_group = audio_receive_stream->config().sync_group;
     const auto it = sync_stream_mapping_.find(sync_group);
     if (it != sync_stream_mapping_.end() &&
@@ -659,6 +708,7 @@ webrtc::VideoReceiveStream* Call::CreateVideoReceiveStream(
     if (it != config.rtp.rtx.end())
       video_receive_ssrcs_[it->second.ssrc] = receive_stream;
     video_receive_streams_.insert(receive_stream);
+    UpdateReceiveSsrcLookup();
     ConfigureSync(config.sync_group);
   }
   receive_stream->SignalNetworkState(video_network_state_);
@@ -690,6 +740,7 @@ void Call::DestroyVideoReceiveStream(
     }
     video_receive_streams_.erase(receive_stream_impl);
     RTC_CHECK(receive_stream_impl != nullptr);
+    UpdateReceiveSsrcLookup();
     ConfigureSync(receive_stream_impl->config().sync_group);
   }
   UpdateAggregateNetworkState();
@@ -724,6 +775,7 @@ FlexfecReceiveStream* Call::CreateFlexfecReceiveStream(
                received_rtp_header_extensions_.end());
     RtpHeaderExtensionMap rtp_header_extensions(config.rtp_header_extensions);
     received_rtp_header_extensions_[config.remote_ssrc] = rtp_header_extensions;
+    UpdateReceiveSsrcLookup();
   }
 
   // TODO(brandtr): Store config in RtcEventLog here.
@@ -764,6 +816,7 @@ void Call::DestroyFlexfecReceiveStream(FlexfecReceiveStream* receive_stream) {
     }
 
     flexfec_receive_streams_.erase(receive_stream_impl);
+    UpdateReceiveSsrcLookup();
   }
 
   delete receive_stream_impl;
@@ -1121,60 +1174,71 @@ PacketReceiver::DeliveryStatus Call::DeliverRtp(MediaType media_type,
 
   uint32_t ssrc = ByteReader<uint32_t>::ReadBigEndian(&packet[8]);
   ReadLockScoped read_lock(*receive_crit_);
-  if (media_type == MediaType::ANY || media_type == MediaType::AUDIO) {
-    auto it = audio_receive_ssrcs_.find(ssrc);
-    if (it != audio_receive_ssrcs_.end()) {
-      received_bytes_per_second_counter_.Add(static_cast<int>(length));
-      received_audio_bytes_per_second_counter_.Add(static_cast<int>(length));
-      auto status = it->second->DeliverRtp(packet, length, packet_time)
-                        ? DELIVERY_OK
-                        : DELIVERY_PACKET_ERROR;
-      if (status == DELIVERY_OK)
-        event_log_->LogRtpHeader(kIncomingPacket, media_type, packet, length);
-      return status;
-    }
+  const ReceiveSsrcEntry* entry = receive_ssrc_lookup_.Find(ssrc);
+  if (!entry)
+    return DELIVERY_UNKNOWN_SSRC;
+  return DeliverRtpToStreams(media_type, ssrc, *entry, packet, length,
+                             packet_time, nullptr);
+}
+
+PacketReceiver::DeliveryStatus Call::DeliverRtpToStreams(
+    MediaType media_type,
+    uint32_t ssrc,
+    const ReceiveSsrcEntry& entry,
+    const uint8_t* packet,
+    size_t length,
+    const PacketTime& packet_time,
+    const rtc::CopyOnWriteBuffer* buffer) {
+  if (entry.audio &&
+      (media_type == MediaType::ANY || media_type == MediaType::AUDIO)) {
+    received_bytes_per_second_counter_.Add(static_cast<int>(length));
+    received_audio_bytes_per_second_counter_.Add(static_cast<int>(length));
+    auto status = entry.audio->DeliverRtp(packet, length, packet_time)
+                      ? DELIVERY_OK
+                      : DELIVERY_PACKET_ERROR;
+    if (status == DELIVERY_OK)
+      event_log_->LogRtpHeader(kIncomingPacket, media_type, packet, length);
+    return status;
   }
-  if (media_type == MediaType::ANY || media_type == MediaType::VIDEO) {
-    auto it = video_receive_ssrcs_.find(ssrc);
-    if (it != video_receive_ssrcs_.end()) {
-      received_bytes_per_second_counter_.Add(static_cast<int>(length));
-      received_video_bytes_per_second_counter_.Add(static_cast<int>(length));
-      // TODO(brandtr): Notify the BWE of received media packets here.
-      auto status = it->second->DeliverRtp(packet, length, packet_time)
-                        ? DELIVERY_OK
-                        : DELIVERY_PACKET_ERROR;
-      // Deliver media packets to FlexFEC subsystem. RTP header extensions need
-      // not be parsed, as FlexFEC is oblivious to the semantic meaning of the
-      // packet contents beyond the 12 byte RTP base header. The BWE is fed
-      // information about these media packets from the regular media pipeline.
+  if (entry.video &&
+      (media_type == MediaType::ANY || media_type == MediaType::VIDEO)) {
+    received_bytes_per_second_counter_.Add(static_cast<int>(length));
+    received_video_bytes_per_second_counter_.Add(static_cast<int>(length));
+    // TODO(brandtr): Notify the BWE of received media packets here.
+    auto status = entry.video->DeliverRtp(packet, length, packet_time, buffer)
+                      ? DELIVERY_OK
+                      : DELIVERY_PACKET_ERROR;
+    // Deliver media packets to FlexFEC subsystem. RTP header extensions need
+    // not be parsed, as FlexFEC is oblivious to the semantic meaning of the
+    // packet contents beyond the 12 byte RTP base header. The BWE is fed
+    // information about these media packets from the regular media pipeline.
+    if (entry.flexfec_protected) {
       rtc::Optional<RtpPacketReceived> parsed_packet =
-          ParseRtpPacket(packet, length, packet_time);
+          ParseRtpPacket(packet, length, packet_time, buffer);
       if (parsed_packet) {
         auto it_bounds = flexfec_receive_ssrcs_media_.equal_range(ssrc);
         for (auto it = it_bounds.first; it != it_bounds.second; ++it)
           it->second->AddAndProcessReceivedPacket(*parsed_packet);
       }
+    }
+    if (status == DELIVERY_OK)
+      event_log_->LogRtpHeader(kIncomingPacket, media_type, packet, length);
+    return status;
+  }
+  if (entry.flexfec &&
+      (media_type == MediaType::ANY || media_type == MediaType::VIDEO)) {
+    rtc::Optional<RtpPacketReceived> parsed_packet =
+        ParseRtpPacket(packet, length, packet_time, buffer);
+    if (parsed_packet) {
+      NotifyBweOfReceivedPacket(*parsed_packet);
+      auto status = entry.flexfec->AddAndProcessReceivedPacket(*parsed_packet)
+                        ? DELIVERY_OK
+                        : DELIVERY_PACKET_ERROR;
       if (status == DELIVERY_OK)
         event_log_->LogRtpHeader(kIncomingPacket, media_type, packet, length);
       return status;
     }
   }
-  if (media_type == MediaType::ANY || media_type == MediaType::VIDEO) {
-    auto it = flexfec_receive_ssrcs_protection_.find(ssrc);
-    if (it != flexfec_receive_ssrcs_protection_.end()) {
-      rtc::Optional<RtpPacketReceived> parsed_packet =
-          ParseRtpPacket(packet, length, packet_time);
-      if (parsed_packet) {
-        NotifyBweOfReceivedPacket(*parsed_packet);
-        auto status = it->second->AddAndProcessReceivedPacket(*parsed_packet)
-                          ? DELIVERY_OK
-                          : DELIVERY_PACKET_ERROR;
-        if (status == DELIVERY_OK)
-          event_log_->LogRtpHeader(kIncomingPacket, media_type, packet, length);
-        return status;
-      }
-    }
-  }
   return DELIVERY_UNKNOWN_SSRC;
 }
 
@@ -1193,15 +1257,100 @@ PacketReceiver::DeliveryStatus Call::DeliverPacket(
   return DeliverRtp(media_type, packet, length, packet_time);
 }
 
+void Call::DeliverPackets(MediaType media_type,
+                          rtc::ArrayView<const ReceivedPacket> packets,
+                          DeliveryStatus* statuses) {
+  TRACE_EVENT1("webrtc", "Call::DeliverPackets", "packets", packets.size());
+  std::vector<RtpPacketToDeliver> rtp_packets;
+  rtp_packets.reserve(packets.size());
+  // RTCP packets are delivered where they are in the batch, after the RTP
+  // packets received before them, as DeliverPacket would.
+  size_t run_begin = 0;
+  for (size_t i = 0; i < packets.size(); ++i) {
+    const ReceivedPacket& packet = packets[i];
+    RTC_DCHECK(!packet.buffer || (packet.buffer->cdata() == packet.data &&
+                                  packet.buffer->size() == packet.length));
+    if (!RtpHeaderParser::IsRtcp(packet.data, packet.length))
+      continue;
+    DeliverRtpPackets(media_type, packets, run_begin, i, statuses,
+                      &rtp_packets);
+    // RTCP goes to all streams, with locks of its own.
+    DeliveryStatus status = DeliverRtcp(media_type, packet.data, packet.length);
+    if (statuses)
+      statuses[i] = status;
+    run_begin = i + 1;
+  }
+  DeliverRtpPackets(media_type, packets, run_begin, packets.size(), statuses,
+                    &rtp_packets);
+}
+
+void Call::DeliverRtpPackets(MediaType media_type,
+                             rtc::ArrayView<const ReceivedPacket> packets,
+                             size_t begin,
+                             size_t end,
+                             DeliveryStatus* statuses,
+                             std::vector<RtpPacketToDeliver>* rtp_packets) {
+  if (begin == end)
+    return;
+  rtp_packets->clear();
+  ReadLockScoped read_lock(*receive_crit_);
+  for (size_t i = begin; i < end; ++i) {
+    const ReceivedPacket& packet = packets[i];
+    DeliveryStatus status = DELIVERY_OK;
+    if (packet.length < 12) {
+      status = DELIVERY_PACKET_ERROR;
+    } else {
+      uint32_t ssrc = ByteReader<uint32_t>::ReadBigEndian(&packet.data[8]);
+      const ReceiveSsrcEntry* entry = receive_ssrc_lookup_.Find(ssrc);
+      if (entry)
+        rtp_packets->push_back({entry, ssrc, i});
+      else
+        status = DELIVERY_UNKNOWN_SSRC;
+    }
+    if (statuses)
+      statuses[i] = status;
+  }
+
+  // Hands the packets of each SSRC to its streams back to back, while their
+  // state is hot in the cache. The sort is stable to keep the packets of
+  // each SSRC in order.
+  std::stable_sort(
+      rtp_packets->begin(), rtp_packets->end(),
+      [](const RtpPacketToDeliver& a, const RtpPacketToDeliver& b) {
+        return a.entry < b.entry;
+      });
+  for (const RtpPacketToDeliver& rtp_packet : *rtp_packets) {
+    const ReceivedPacket& packet = packets[rtp_packet.index];
+    DeliveryStatus status =
+        DeliverRtpToStreams(media_type, rtp_packet.ssrc, *rtp_packet.entry,
+                            packet.data, packet.length, packet.packet_time,
+                            packet.buffer);
+    if (statuses)
+      statuses[rtp_packet.index] = status;
+  }
+}
+
 // TODO(brandtr): Update this member function when we support protecting
 // audio packets with FlexFEC.
 bool Call::OnRecoveredPacket(const uint8_t* packet, size_t length) {
   uint32_t ssrc = ByteReader<uint32_t>::ReadBigEndian(&packet[8]);
   ReadLockScoped read_lock(*receive_crit_);
-  auto it = video_receive_ssrcs_.find(ssrc);
-  if (it == video_receive_ssrcs_.end())
+  const ReceiveSsrcEntry* entry = receive_ssrc_lookup_.Find(ssrc);
+  if (!entry || !entry->video)
     return false;
-  return it->second->OnRecoveredPacket(packet, length);
+  return entry->video->OnRecoveredPacket(packet, length);
+}
+
+void Call::UpdateReceiveSsrcLookup() {
+  receive_ssrc_lookup_.Clear();
+  for (const auto& kv : audio_receive_ssrcs_)
+    receive_ssrc_lookup_[kv.first].audio = kv.second;
+  for (const auto& kv : video_receive_ssrcs_)
+    receive_ssrc_lookup_[kv.first].video = kv.second;
+  for (const auto& kv : flexfec_receive_ssrcs_protection_)
+    receive_ssrc_lookup_[kv.first].flexfec = kv.second;
+  for (const auto& kv : flexfec_receive_ssrcs_media_)
+    receive_ssrc_lookup_[kv.first].flexfec_protected = true;
 }
 
 void Call::NotifyBweOfReceivedPacket(const RtpPacketReceived& packet) {
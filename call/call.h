@@ -13,6 +13,8 @@
 #include <string>
 #include <vector>
 
+#include "webrtc/base/array_view.h"
+#include "webrtc/base/copyonwritebuffer.h"
 #include "webrtc/base/networkroute.h"
 #include "webrtc/base/platform_file.h"
 #include "webrtc/base/socket.h"
@@ -51,6 +53,34 @@ class PacketReceiver {
                                        size_t length,
                                        const PacketTime& packet_time) = 0;
 
+  struct ReceivedPacket {
+    const uint8_t* data;
+    size_t length;
+    PacketTime packet_time;
+    // The reference counted buffer holding |data|, or null. Receive streams
+    // may keep a reference to it instead of copying the payload.
+    const rtc::CopyOnWriteBuffer* buffer;
+  };
+
+  // Delivers several RTP or RTCP packets at once, typically all those read
+  // from the network since the previous call. Implementations may save the
+  // per packet locking and lookups of DeliverPacket, and may deliver RTP
+  // packets of different SSRCs in another order than given, but packets of
+  // the same SSRC are delivered in order, and RTCP packets after every RTP
+  // packet preceding them. If |statuses| isn't null, it gets the status of
+  // each packet.
+  virtual void DeliverPackets(MediaType media_type,
+                              rtc::ArrayView<const ReceivedPacket> packets,
+                              DeliveryStatus* statuses) {
+    for (size_t i = 0; i < packets.size(); ++i) {
+      DeliveryStatus status = DeliverPacket(media_type, packets[i].data,
+                                            packets[i].length,
+                                            packets[i].packet_time);
+      if (statuses)
+        statuses[i] = status;
+    }
+  }
+
  protected:
   virtual ~PacketReceiver() {}
 };
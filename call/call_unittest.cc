@@ -10,12 +10,15 @@
 
 #include <list>
 #include <memory>
+#include <vector>
 
+#include "webrtc/base/arraysize.h"
 #include "webrtc/call/audio_state.h"
 #include "webrtc/call/call.h"
 #include "webrtc/logging/rtc_event_log/rtc_event_log.h"
 #include "webrtc/modules/audio_coding/codecs/mock/mock_audio_decoder_factory.h"
 #include "webrtc/modules/audio_mixer/audio_mixer_impl.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
 #include "webrtc/test/gtest.h"
 #include "webrtc/test/mock_transport.h"
 #include "webrtc/test/mock_voice_engine.h"
@@ -294,4 +297,91 @@ TEST(CallTest, MultipleFlexfecReceiveStreamsProtectingSingleVideoStream) {
   }
 }
 
+TEST(CallTest, DeliverPacketsReportsStatusOfEachPacket) {
+  CallHelper call;
+  MockTransport rtcp_send_transport;
+  FlexfecReceiveStream::Config config(&rtcp_send_transport);
+  config.payload_type = 118;
+  config.remote_ssrc = 38837212;
+  config.protected_media_ssrcs = {27273};
+  FlexfecReceiveStream* stream = call->CreateFlexfecReceiveStream(config);
+
+  auto make_packet = [](uint32_t ssrc) {
+    std::vector<uint8_t> packet(20, 0);
+    packet[0] = 0x80;
+    packet[1] = 118;
+    ByteWriter<uint32_t>::WriteBigEndian(&packet[8], ssrc);
+    return packet;
+  };
+  // The FlexFEC stream knows its SSRC, but drops packets until started.
+  const std::vector<uint8_t> flexfec_packet = make_packet(config.remote_ssrc);
+  const std::vector<uint8_t> unknown_packet = make_packet(1234);
+  const std::vector<uint8_t> protected_packet = make_packet(27273);
+  const uint8_t short_packet[] = {0x80, 118, 0, 1};
+  const PacketReceiver::ReceivedPacket packets[] = {
+      {flexfec_packet.data(), flexfec_packet.size(), PacketTime(), nullptr},
+      {unknown_packet.data(), unknown_packet.size(), PacketTime(), nullptr},
+      {short_packet, sizeof(short_packet), PacketTime(), nullptr},
+      {protected_packet.data(), protected_packet.size(), PacketTime(),
+       nullptr},
+  };
+  PacketReceiver::DeliveryStatus statuses[arraysize(packets)];
+  call->Receiver()->DeliverPackets(MediaType::VIDEO, packets, statuses);
+  EXPECT_EQ(PacketReceiver::DELIVERY_PACKET_ERROR, statuses[0]);
+  EXPECT_EQ(PacketReceiver::DELIVERY_UNKNOWN_SSRC, statuses[1]);
+  EXPECT_EQ(PacketReceiver::DELIVERY_PACKET_ERROR, statuses[2]);
+  // Protected media is delivered to FlexFEC only along with a video stream.
+  EXPECT_EQ(PacketReceiver::DELIVERY_UNKNOWN_SSRC, statuses[3]);
+
+  call->DestroyFlexfecReceiveStream(stream);
+  call->Receiver()->DeliverPackets(MediaType::VIDEO, packets, statuses);
+  EXPECT_EQ(PacketReceiver::DELIVERY_UNKNOWN_SSRC, statuses[0]);
+}
+
+TEST(CallTest, DeliverPacketsKeepsRtcpInOrderWithRtp) {
+  rtc::scoped_refptr<AudioDecoderFactory> decoder_factory(
+      new rtc::RefCountedObject<MockAudioDecoderFactory>);
+  CallHelper call(decoder_factory);
+  test::MockVoEChannelProxy* channel_proxy = nullptr;
+  EXPECT_CALL(*call.voice_engine(), ChannelProxyFactory(123))
+      .WillOnce(testing::Invoke([&](int channel_id) {
+        channel_proxy = new testing::NiceMock<test::MockVoEChannelProxy>();
+        EXPECT_CALL(*channel_proxy, GetAudioDecoderFactory())
+            .WillRepeatedly(testing::ReturnRef(decoder_factory));
+        return channel_proxy;
+      }));
+  AudioReceiveStream::Config config;
+  config.rtp.remote_ssrc = 42;
+  config.voe_channel_id = 123;
+  config.decoder_factory = decoder_factory;
+  AudioReceiveStream* stream = call->CreateAudioReceiveStream(config);
+  ASSERT_TRUE(channel_proxy);
+
+  const uint8_t first_rtp[] = {0x80, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 42};
+  const uint8_t rtcp[] = {0x80, 201, 0, 1, 0, 0, 0, 42};
+  const uint8_t second_rtp[] = {0x80, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 42};
+  const PacketReceiver::ReceivedPacket packets[] = {
+      {first_rtp, sizeof(first_rtp), PacketTime(), nullptr},
+      {rtcp, sizeof(rtcp), PacketTime(), nullptr},
+      {second_rtp, sizeof(second_rtp), PacketTime(), nullptr},
+  };
+  {
+    testing::InSequence sequence;
+    EXPECT_CALL(*channel_proxy, ReceivedRTPPacket(first_rtp, testing::_,
+                                                  testing::_))
+        .WillOnce(testing::Return(true));
+    EXPECT_CALL(*channel_proxy, ReceivedRTCPPacket(rtcp, testing::_))
+        .WillOnce(testing::Return(true));
+    EXPECT_CALL(*channel_proxy, ReceivedRTPPacket(second_rtp, testing::_,
+                                                  testing::_))
+        .WillOnce(testing::Return(true));
+  }
+  PacketReceiver::DeliveryStatus statuses[arraysize(packets)];
+  call->Receiver()->DeliverPackets(MediaType::AUDIO, packets, statuses);
+  for (PacketReceiver::DeliveryStatus status : statuses)
+    EXPECT_EQ(PacketReceiver::DELIVERY_OK, status);
+
+  call->DestroyAudioReceiveStream(stream);
+}
+
 }  // namespace webrtc
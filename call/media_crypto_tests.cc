@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <vector>
+
+#include "third_party/libsrtp/include/srtp.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/modules/video_coding/codecs/vp8/include/vp8.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/system_wrappers/include/sleep.h"
+#include "webrtc/test/call_test.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+namespace {
+constexpr int kLossPercent = 10;
+constexpr int kPollIntervalMs = 100;
+constexpr int kMinRetransmittedPackets = 10;
+
+MediaCryptoKey CreateKey() {
+  MediaCryptoKey key;
+  key.type = rtc::SRTP_AEAD_AES_256_GCM;
+  key.buffer.resize(32 + 12);
+  for (size_t i = 0; i < key.buffer.size(); ++i)
+    key.buffer[i] = static_cast<uint8_t>(i * 7);
+  return key;
+}
+}  // namespace
+
+class MediaCryptoTest : public test::CallTest {};
+
+// Sends PERC protected VP8 with NACK, RTX and ULPFEC over a lossy link, and
+// checks that only media packets went through the crypto. RTX and FEC packets
+// are built from the protected payload kept in the packet history, so once
+// retransmissions happened the number of encrypted packets still equals the
+// number of media packets sent on the media SSRC.
+TEST_F(MediaCryptoTest, RetransmissionsAndFecAreNotReEncrypted) {
+  class MediaCryptoObserver : public test::EndToEndTest {
+   public:
+    MediaCryptoObserver()
+        : EndToEndTest(kLongTimeoutMs),
+          encoder_(VP8Encoder::Create()),
+          send_stream_(nullptr) {}
+
+   private:
+    test::PacketTransport* CreateSendTransport(Call* sender_call) override {
+      FakeNetworkPipe::Config config;
+      config.loss_percent = kLossPercent;
+      return new test::PacketTransport(sender_call, this,
+                                       test::PacketTransport::kSender, config);
+    }
+
+    void ModifyVideoConfigs(
+        VideoSendStream::Config* send_config,
+        std::vector<VideoReceiveStream::Config>* receive_configs,
+        VideoEncoderConfig* encoder_config) override {
+      static bool srtp_initialized = srtp_init() == srtp_err_status_ok;
+      ASSERT_TRUE(srtp_initialized);
+
+      send_config->rtp.nack.rtp_history_ms = kNackRtpHistoryMs;
+      send_config->rtp.ulpfec.ulpfec_payload_type = kUlpfecPayloadType;
+      send_config->rtp.ulpfec.red_payload_type = kRedPayloadType;
+      send_config->rtp.ulpfec.red_rtx_payload_type = kRtxRedPayloadType;
+      send_config->rtp.rtx.ssrcs.push_back(kSendRtxSsrcs[0]);
+      send_config->rtp.rtx.payload_type = kSendRtxPayloadType;
+      send_config->media_crypto_enabled = true;
+      send_config->media_crypto_key = CreateKey();
+
+      VideoReceiveStream::Config& receive_config = (*receive_configs)[0];
+      receive_config.rtp.nack.rtp_history_ms = kNackRtpHistoryMs;
+      receive_config.rtp.ulpfec = send_config->rtp.ulpfec;
+      receive_config.rtp.rtx[kRedPayloadType].ssrc = kSendRtxSsrcs[0];
+      receive_config.rtp.rtx[kRedPayloadType].payload_type =
+          kSendRtxPayloadType;
+      receive_config.media_crypto_enabled = true;
+      receive_config.media_crypto_key = CreateKey();
+
+      // Generic packetization doesn't support FEC with NACK.
+      RTC_DCHECK_EQ(1, receive_config.decoders.size());
+      send_config->encoder_settings.encoder = encoder_.get();
+      send_config->encoder_settings.payload_name = "VP8";
+      receive_config.decoders[0].payload_name = "VP8";
+    }
+
+    void OnVideoStreamsCreated(
+        VideoSendStream* send_stream,
+        const std::vector<VideoReceiveStream*>& receive_streams) override {
+      send_stream_ = send_stream;
+    }
+
+    void PerformTest() override {
+      Clock* clock = Clock::GetRealTimeClock();
+      const int64_t stop_time_ms = clock->TimeInMilliseconds() + kLongTimeoutMs;
+      while (clock->TimeInMilliseconds() < stop_time_ms) {
+        if (CheckStats())
+          return;
+        SleepMs(kPollIntervalMs);
+      }
+      ADD_FAILURE() << "Timed out waiting for retransmissions. Last stats: "
+                    << send_stream_->GetStats().ToString(
+                           clock->TimeInMilliseconds());
+    }
+
+    // The encrypted counter runs ahead of the pacer, so a single snapshot may
+    // not match yet; poll until one does.
+    bool CheckStats() {
+      VideoSendStream::Stats stats = send_stream_->GetStats();
+      auto media = stats.substreams.find(kVideoSendSsrcs[0]);
+      auto rtx = stats.substreams.find(kSendRtxSsrcs[0]);
+      if (media == stats.substreams.end() || rtx == stats.substreams.end())
+        return false;
+      if (rtx->second.rtp_stats.retransmitted.packets <
+          kMinRetransmittedPackets) {
+        return false;
+      }
+      const StreamDataCounters& counters = media->second.rtp_stats;
+      return media->second.media_crypto_packets > 0 &&
+             media->second.media_crypto_packets ==
+                 counters.transmitted.packets - counters.fec.packets;
+    }
+
+    std::unique_ptr<VideoEncoder> encoder_;
+    VideoSendStream* send_stream_;
+  } test;
+
+  RunBaseTest(&test);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_CALL_SSRC_MAP_H_
+#define WEBRTC_CALL_SSRC_MAP_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "webrtc/base/checks.h"
+
+namespace webrtc {
+
+// Hash table from SSRC to T, for lookups on the packet delivery path. Entries
+// live in a single array probed linearly from a multiplicative hash of the
+// SSRC, so a lookup touches one or two cache lines instead of walking the
+// nodes of a std::map. The table is kept at most half full.
+//
+// There is no erase: the table is meant to be rebuilt with Clear() when the
+// set of SSRCs changes, which is rare compared to lookups. Pointers returned
+// by Find() are invalidated by insertions and Clear().
+template <typename T>
+class SsrcMap {
+ public:
+  SsrcMap() { Clear(); }
+
+  void Clear() {
+    slots_.clear();
+    slots_.resize(kMinCapacity);
+    shift_ = 32 - kMinCapacityLog2;
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns the value of |ssrc|, default constructed if it wasn't present.
+  T& operator[](uint32_t ssrc) {
+    Slot* slot = Probe(ssrc);
+    if (slot->used)
+      return slot->value;
+    if (2 * (size_ + 1) > slots_.size()) {
+      Grow();
+      slot = Probe(ssrc);
+    }
+    slot->used = true;
+    slot->ssrc = ssrc;
+    ++size_;
+    return slot->value;
+  }
+
+  // Returns null if |ssrc| isn't present.
+  T* Find(uint32_t ssrc) {
+    Slot* slot = Probe(ssrc);
+    return slot->used ? &slot->value : nullptr;
+  }
+  const T* Find(uint32_t ssrc) const {
+    return const_cast<SsrcMap*>(this)->Find(ssrc);
+  }
+
+ private:
+  static const int kMinCapacityLog2 = 4;
+  static const size_t kMinCapacity = 1 << kMinCapacityLog2;
+
+  struct Slot {
+    Slot() : ssrc(0), used(false), value() {}
+    uint32_t ssrc;
+    bool used;
+    T value;
+  };
+
+  // Returns the slot holding |ssrc|, or the free slot where it would go.
+  Slot* Probe(uint32_t ssrc) {
+    const size_t mask = slots_.size() - 1;
+    // Fibonacci hashing, SSRCs used in tests are often consecutive.
+    size_t index = static_cast<uint32_t>(ssrc * 2654435769u) >> shift_;
+    while (slots_[index].used && slots_[index].ssrc != ssrc)
+      index = (index + 1) & mask;
+    return &slots_[index];
+  }
+
+  void Grow() {
+    std::vector<Slot> old_slots(2 * slots_.size());
+    old_slots.swap(slots_);
+    --shift_;
+    RTC_DCHECK_GT(shift_, 0);
+    for (Slot& old_slot : old_slots) {
+      if (!old_slot.used)
+        continue;
+      Slot* slot = Probe(old_slot.ssrc);
+      *slot = old_slot;
+    }
+  }
+
+  std::vector<Slot> slots_;
+  // 32 - log2 of the capacity, the hash keeps the top bits of the product.
+  int shift_;
+  size_t size_;
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_CALL_SSRC_MAP_H_
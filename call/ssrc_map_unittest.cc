@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+
+#include "webrtc/base/random.h"
+#include "webrtc/call/ssrc_map.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+
+TEST(SsrcMapTest, EmptyMapFindsNothing) {
+  SsrcMap<int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.Find(0));
+  EXPECT_EQ(nullptr, map.Find(0xFFFFFFFF));
+}
+
+TEST(SsrcMapTest, InsertsAndFinds) {
+  SsrcMap<int> map;
+  map[0] = 1;
+  map[0xFFFFFFFF] = 2;
+  EXPECT_EQ(2u, map.size());
+  ASSERT_NE(nullptr, map.Find(0));
+  EXPECT_EQ(1, *map.Find(0));
+  ASSERT_NE(nullptr, map.Find(0xFFFFFFFF));
+  EXPECT_EQ(2, *map.Find(0xFFFFFFFF));
+  EXPECT_EQ(nullptr, map.Find(1));
+}
+
+TEST(SsrcMapTest, OperatorReturnsExistingValue) {
+  SsrcMap<int> map;
+  map[17] = 5;
+  map[17] += 1;
+  EXPECT_EQ(1u, map.size());
+  EXPECT_EQ(6, *map.Find(17));
+}
+
+TEST(SsrcMapTest, ClearRemovesEverything) {
+  SsrcMap<int> map;
+  for (uint32_t ssrc = 0; ssrc < 100; ++ssrc)
+    map[ssrc] = 1;
+  map.Clear();
+  EXPECT_TRUE(map.empty());
+  for (uint32_t ssrc = 0; ssrc < 100; ++ssrc)
+    EXPECT_EQ(nullptr, map.Find(ssrc));
+}
+
+TEST(SsrcMapTest, GrowsWithConsecutiveSsrcs) {
+  SsrcMap<uint32_t> map;
+  for (uint32_t ssrc = 1000; ssrc < 3000; ++ssrc)
+    map[ssrc] = ssrc * 3;
+  EXPECT_EQ(2000u, map.size());
+  for (uint32_t ssrc = 1000; ssrc < 3000; ++ssrc) {
+    ASSERT_NE(nullptr, map.Find(ssrc));
+    EXPECT_EQ(ssrc * 3, *map.Find(ssrc));
+  }
+  EXPECT_EQ(nullptr, map.Find(999));
+  EXPECT_EQ(nullptr, map.Find(3000));
+}
+
+TEST(SsrcMapTest, MatchesStdMapWithRandomSsrcs) {
+  Random random(0x1234);
+  SsrcMap<uint32_t> map;
+  std::map<uint32_t, uint32_t> reference;
+  for (int i = 0; i < 5000; ++i) {
+    uint32_t ssrc = random.Rand<uint32_t>();
+    uint32_t value = random.Rand<uint32_t>();
+    map[ssrc] = value;
+    reference[ssrc] = value;
+  }
+  EXPECT_EQ(reference.size(), map.size());
+  for (const auto& kv : reference) {
+    ASSERT_NE(nullptr, map.Find(kv.first));
+    EXPECT_EQ(kv.second, *map.Find(kv.first));
+  }
+  for (int i = 0; i < 5000; ++i) {
+    uint32_t ssrc = random.Rand<uint32_t>();
+    EXPECT_EQ(reference.count(ssrc) != 0, map.Find(ssrc) != nullptr);
+  }
+}
+
+}  // namespace webrtc
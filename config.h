@@ -27,11 +27,26 @@
 namespace webrtc {
 
 // End to end media encryption	
+const int kDefaultMediaCryptoReplayWindowSize = 1024;
+
 struct MediaCryptoKey {
   int type = rtc::SRTP_INVALID_CRYPTO_SUITE;
   std::vector<uint8_t> buffer;
+  // Replay window of each inbound context, in packets.
+  int replay_window_size = kDefaultMediaCryptoReplayWindowSize;
+  // Only installed on the receive side, ahead of the senders switching to it.
+  // See RTCConfiguration::media_crypto_next_key.
+  bool receive_only = false;
   bool Parse(int crypto_suite, const std::string &str);
 };
+
+// Counters of the end to end media decryption of one remote SSRC.
+struct MediaCryptoStats {
+  uint32_t ssrc = 0;
+  uint32_t packets = 0;
+  uint32_t replay_drops = 0;
+  uint32_t auth_failures = 0;
+};
   
 
 // Settings for NACK, see RFC 4585 for details.
@@ -0,0 +1,172 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/examples/percrelay/perc_relay.h"
+
+#include <utility>
+
+#include "webrtc/base/checks.h"
+#include "webrtc/base/logging.h"
+#include "webrtc/common_types.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_header_parser.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
+#include "webrtc/pc/srtpfilter.h"
+
+namespace webrtc {
+
+namespace {
+// Largest datagram relayed, leaves room for the SRTP tag and MKI.
+const size_t kMaxPacketSize = 2048;
+const size_t kMaxSrtpOverhead = 64;
+}  // namespace
+
+struct PercRelay::Leg {
+  explicit Leg(const LegConfig& config) : config(config) {}
+  const LegConfig config;
+  // Hop-by-hop SRTP, null for plain RTP legs.
+  std::unique_ptr<cricket::SrtpFilter> srtp;
+};
+
+PercRelay::PercRelay(rtc::AsyncPacketSocket* socket)
+    : socket_(socket),
+      receive_buffer_(0, kMaxPacketSize),
+      send_buffer_(0, kMaxPacketSize + kMaxSrtpOverhead) {
+  socket_->SignalReadPacket.connect(this, &PercRelay::OnReadPacket);
+}
+
+PercRelay::~PercRelay() {
+  socket_->SignalReadPacket.disconnect(this);
+}
+
+bool PercRelay::AddLeg(const LegConfig& config) {
+  if (legs_.find(config.address) != legs_.end()) {
+    LOG(LS_ERROR) << "Leg " << config.address.ToString() << " already added";
+    return false;
+  }
+  std::unique_ptr<Leg> leg(new Leg(config));
+  if (!config.send_key.empty() || !config.recv_key.empty()) {
+    leg->srtp.reset(new cricket::SrtpFilter());
+    if (!leg->srtp->SetRtpParams(
+            config.crypto_suite, config.send_key.data(),
+            static_cast<int>(config.send_key.size()), config.crypto_suite,
+            config.recv_key.data(),
+            static_cast<int>(config.recv_key.size()))) {
+      LOG(LS_ERROR) << "Invalid hop-by-hop keys for leg "
+                    << config.address.ToString();
+      return false;
+    }
+  }
+  if (!config.send_only)
+    receivers_.push_back(leg.get());
+  legs_[config.address] = std::move(leg);
+  return true;
+}
+
+void PercRelay::OnReadPacket(rtc::AsyncPacketSocket* socket,
+                             const char* data,
+                             size_t size,
+                             const rtc::SocketAddress& remote_address,
+                             const rtc::PacketTime& packet_time) {
+  RTC_DCHECK_EQ(socket_, socket);
+  auto it = legs_.find(remote_address);
+  if (it == legs_.end()) {
+    ++stats_.unknown_source;
+    return;
+  }
+  const Leg& source = *it->second;
+  if (size > kMaxPacketSize) {
+    ++stats_.invalid;
+    return;
+  }
+
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  bool rtcp = RtpHeaderParser::IsRtcp(bytes, size);
+  if (rtcp) {
+    ++stats_.rtcp_received;
+  } else {
+    ++stats_.rtp_received;
+  }
+
+  receive_buffer_.SetData(bytes, size);
+  int length = static_cast<int>(size);
+  if (source.srtp) {
+    bool unprotected =
+        rtcp ? source.srtp->UnprotectRtcp(receive_buffer_.data(), length,
+                                          &length)
+             : source.srtp->UnprotectRtp(receive_buffer_.data(), length,
+                                         &length);
+    if (!unprotected) {
+      ++stats_.unprotect_failures;
+      return;
+    }
+  }
+  Forward(source, rtcp, static_cast<size_t>(length));
+}
+
+void PercRelay::Forward(const Leg& source, bool rtcp, size_t size) {
+  // RTCP is relayed as is, RTP is validated and its outer header parsed
+  // without copying the packet out of |receive_buffer_|.
+  const uint8_t* data = receive_buffer_.data();
+  uint8_t payload_type = 0;
+  if (!rtcp) {
+    RTPHeader header;
+    if (!RtpUtility::RtpHeaderParser(data, size).Parse(&header)) {
+      ++stats_.invalid;
+      return;
+    }
+    payload_type = header.payloadType;
+  }
+
+  for (const Leg* leg : receivers_) {
+    if (leg == &source)
+      continue;
+    auto rewrite = rtcp ? leg->config.payload_types.end()
+                        : leg->config.payload_types.find(payload_type);
+    bool rewritten = rewrite != leg->config.payload_types.end();
+    if (!leg->srtp && !rewritten) {
+      // Plain leg, sent straight from |receive_buffer_|.
+      if (SendTo(*leg, data, size))
+        ++stats_.forwarded;
+      continue;
+    }
+
+    send_buffer_.SetData(data, size);
+    if (rewritten) {
+      // Keeps the marker bit, the original payload type stays in the OHB.
+      send_buffer_[1] = (send_buffer_[1] & 0x80) | rewrite->second;
+    }
+    int length = static_cast<int>(size);
+    if (leg->srtp) {
+      int max_length = static_cast<int>(send_buffer_.capacity());
+      bool protected_packet =
+          rtcp ? leg->srtp->ProtectRtcp(send_buffer_.data(), length,
+                                        max_length, &length)
+               : leg->srtp->ProtectRtp(send_buffer_.data(), length,
+                                       max_length, &length);
+      if (!protected_packet) {
+        ++stats_.protect_failures;
+        continue;
+      }
+    }
+    if (SendTo(*leg, send_buffer_.data(), static_cast<size_t>(length)))
+      ++stats_.forwarded;
+  }
+}
+
+bool PercRelay::SendTo(const Leg& leg, const uint8_t* data, size_t size) {
+  rtc::PacketOptions options;
+  if (socket_->SendTo(data, size, leg.config.address, options) < 0) {
+    ++stats_.send_failures;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,103 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_EXAMPLES_PERCRELAY_PERC_RELAY_H_
+#define WEBRTC_EXAMPLES_PERCRELAY_PERC_RELAY_H_
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/base/buffer.h"
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/sigslot.h"
+#include "webrtc/base/socketaddress.h"
+
+namespace cricket {
+class SrtpFilter;
+}  // namespace cricket
+
+namespace webrtc {
+
+// Reference PERC media distributor (MDD). Every endpoint is a leg with its
+// own hop-by-hop SRTP keys. The relay terminates the hop-by-hop layer of each
+// packet it receives and forwards it to every other leg, re-protected with
+// that leg's keys.
+//
+// The end to end protected payload, the OHB followed by the inner ciphertext
+// and tag, is never touched: the OHB carries the original header values, so
+// the outer header may be rewritten per leg (only the payload type is, see
+// LegConfig::payload_types) without breaking end to end authentication.
+//
+// Must be used on the thread of the socket. Packets are unprotected in a
+// buffer reused across packets and their outer header is parsed in place, so
+// every plain RTP leg is sent that same buffer. Each copy sent to an SRTP leg,
+// or with a rewritten payload type, goes through one more scratch buffer. The
+// forwarding path does not allocate.
+class PercRelay : public sigslot::has_slots<> {
+ public:
+  struct LegConfig {
+    rtc::SocketAddress address;
+    // Hop-by-hop keys as seen by the relay, empty for a plain RTP leg.
+    int crypto_suite = 0;
+    std::vector<uint8_t> send_key;
+    std::vector<uint8_t> recv_key;
+    // Legs that only send are not forwarded to.
+    bool send_only = false;
+    // Outer payload type rewrites applied on packets sent to this leg.
+    std::map<uint8_t, uint8_t> payload_types;
+  };
+
+  struct Stats {
+    uint64_t rtp_received = 0;
+    uint64_t rtcp_received = 0;
+    uint64_t forwarded = 0;
+    uint64_t unknown_source = 0;
+    uint64_t invalid = 0;
+    uint64_t unprotect_failures = 0;
+    uint64_t protect_failures = 0;
+    uint64_t send_failures = 0;
+  };
+
+  // Does not take ownership of |socket|.
+  explicit PercRelay(rtc::AsyncPacketSocket* socket);
+  ~PercRelay() override;
+
+  bool AddLeg(const LegConfig& config);
+  size_t num_legs() const { return legs_.size(); }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Leg;
+
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const rtc::SocketAddress& remote_address,
+                    const rtc::PacketTime& packet_time);
+  void Forward(const Leg& source, bool rtcp, size_t size);
+  bool SendTo(const Leg& leg, const uint8_t* data, size_t size);
+
+  rtc::AsyncPacketSocket* const socket_;
+  std::map<rtc::SocketAddress, std::unique_ptr<Leg>> legs_;
+  // Legs packets are forwarded to, in insertion order.
+  std::vector<Leg*> receivers_;
+  // Unprotected packet being forwarded and the per leg protected copy.
+  rtc::Buffer receive_buffer_;
+  rtc::Buffer send_buffer_;
+  Stats stats_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(PercRelay);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_EXAMPLES_PERCRELAY_PERC_RELAY_H_
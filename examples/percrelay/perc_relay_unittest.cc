@@ -0,0 +1,149 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/examples/percrelay/perc_relay.h"
+
+#include <vector>
+
+#include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/base/gunit.h"
+
+namespace webrtc {
+namespace {
+
+const uint8_t kPayloadType = 96;
+
+// Records every packet sent, along with the buffer it was sent from.
+class FakePacketSocket : public rtc::AsyncPacketSocket {
+ public:
+  struct SentPacket {
+    const uint8_t* data;
+    std::vector<uint8_t> bytes;
+    rtc::SocketAddress address;
+  };
+
+  rtc::SocketAddress GetLocalAddress() const override {
+    return rtc::SocketAddress("127.0.0.1", 5000);
+  }
+  rtc::SocketAddress GetRemoteAddress() const override {
+    return rtc::SocketAddress();
+  }
+  int Send(const void* pv,
+           size_t cb,
+           const rtc::PacketOptions& options) override {
+    return -1;
+  }
+  int SendTo(const void* pv,
+             size_t cb,
+             const rtc::SocketAddress& addr,
+             const rtc::PacketOptions& options) override {
+    const uint8_t* data = static_cast<const uint8_t*>(pv);
+    sent_.push_back({data, std::vector<uint8_t>(data, data + cb), addr});
+    return static_cast<int>(cb);
+  }
+  int Close() override { return 0; }
+  State GetState() const override { return STATE_BOUND; }
+  int GetOption(rtc::Socket::Option opt, int* value) override { return -1; }
+  int SetOption(rtc::Socket::Option opt, int value) override { return -1; }
+  int GetError() const override { return 0; }
+  void SetError(int error) override {}
+
+  void Receive(const std::vector<uint8_t>& packet,
+               const rtc::SocketAddress& from) {
+    SignalReadPacket(this, reinterpret_cast<const char*>(packet.data()),
+                     packet.size(), from, rtc::PacketTime());
+  }
+
+  const std::vector<SentPacket>& sent() const { return sent_; }
+
+ private:
+  std::vector<SentPacket> sent_;
+};
+
+rtc::SocketAddress LegAddress(int leg) {
+  return rtc::SocketAddress("127.0.0.1", 6000 + leg);
+}
+
+std::vector<uint8_t> CreateRtpPacket() {
+  std::vector<uint8_t> packet = {0x80, kPayloadType, 0x12, 0x34,
+                                 0x00, 0x00, 0x00, 0x01,
+                                 0x11, 0x22, 0x33, 0x44};
+  for (int i = 0; i < 100; ++i)
+    packet.push_back(static_cast<uint8_t>(i));
+  return packet;
+}
+
+}  // namespace
+
+class PercRelayTest : public testing::Test {
+ protected:
+  PercRelayTest() : relay_(&socket_) {}
+
+  void AddPlainLegs(int num_legs) {
+    for (int i = 0; i < num_legs; ++i) {
+      PercRelay::LegConfig config;
+      config.address = LegAddress(i);
+      EXPECT_TRUE(relay_.AddLeg(config));
+    }
+  }
+
+  FakePacketSocket socket_;
+  PercRelay relay_;
+};
+
+TEST_F(PercRelayTest, FanOutToPlainLegsSharesOneBuffer) {
+  AddPlainLegs(4);
+  std::vector<uint8_t> packet = CreateRtpPacket();
+  socket_.Receive(packet, LegAddress(0));
+
+  const std::vector<FakePacketSocket::SentPacket>& sent = socket_.sent();
+  ASSERT_EQ(3u, sent.size());
+  for (size_t i = 0; i < sent.size(); ++i) {
+    EXPECT_EQ(LegAddress(i + 1), sent[i].address);
+    EXPECT_EQ(packet, sent[i].bytes);
+    EXPECT_EQ(sent[0].data, sent[i].data);
+  }
+  EXPECT_NE(packet.data(), sent[0].data);
+  EXPECT_EQ(3u, relay_.stats().forwarded);
+}
+
+TEST_F(PercRelayTest, RewritesPayloadTypeOnlyForConfiguredLeg) {
+  AddPlainLegs(2);
+  PercRelay::LegConfig config;
+  config.address = LegAddress(2);
+  config.payload_types[kPayloadType] = 100;
+  ASSERT_TRUE(relay_.AddLeg(config));
+
+  std::vector<uint8_t> packet = CreateRtpPacket();
+  packet[1] |= 0x80;
+  socket_.Receive(packet, LegAddress(0));
+
+  const std::vector<FakePacketSocket::SentPacket>& sent = socket_.sent();
+  ASSERT_EQ(2u, sent.size());
+  EXPECT_EQ(packet, sent[0].bytes);
+  EXPECT_EQ(0x80 | 100, sent[1].bytes[1]);
+  EXPECT_NE(sent[0].data, sent[1].data);
+  // The packet kept for the plain leg is not touched by the rewrite.
+  EXPECT_EQ(0x80 | kPayloadType, sent[0].data[1]);
+}
+
+TEST_F(PercRelayTest, DropsInvalidRtpAndUnknownSources) {
+  AddPlainLegs(2);
+  std::vector<uint8_t> packet = CreateRtpPacket();
+  packet[0] = 0x40;
+  socket_.Receive(packet, LegAddress(0));
+  socket_.Receive(CreateRtpPacket(), LegAddress(5));
+
+  EXPECT_TRUE(socket_.sent().empty());
+  EXPECT_EQ(1u, relay_.stats().invalid);
+  EXPECT_EQ(1u, relay_.stats().unknown_source);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,307 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Measures the whole PERC pipeline on one machine: N senders protect media
+// end to end and hop-by-hop, a PercRelay on its own thread forwards every
+// packet to M receivers, which strip both layers and record the latency
+// from the moment the sender started protecting the packet.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/buffer.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/base/flags.h"
+#include "webrtc/base/helpers.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/examples/percrelay/perc_relay.h"
+#include "webrtc/media/base/rtputils.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/modules/rtp_rtcp/source/media_crypto.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/pc/srtpfilter.h"
+
+DEFINE_bool(help, false, "Prints this message");
+DEFINE_int(senders, 4, "Number of sending endpoints");
+DEFINE_int(receivers, 16, "Number of receiving endpoints");
+DEFINE_int(rate, 1000, "Packets per second sent by each sender");
+DEFINE_int(payload_size, 1000, "Media payload size in bytes");
+DEFINE_int(duration, 10, "Test duration in seconds");
+DEFINE_bool(hop_srtp, true, "Protect the hop-by-hop legs with SRTP");
+
+namespace {
+
+const int kHopCryptoSuite = rtc::SRTP_AES128_CM_SHA1_80;
+const int kMediaCryptoSuite = rtc::SRTP_AEAD_AES_256_GCM;
+const uint8_t kPayloadType = 96;
+const size_t kMaxPacketSize = 2048;
+const int kDrainTimeMs = 500;
+
+std::vector<uint8_t> CreateKey(int crypto_suite) {
+  int key_length;
+  int salt_length;
+  RTC_CHECK(
+      rtc::GetSrtpKeyAndSaltLengths(crypto_suite, &key_length, &salt_length));
+  std::string random;
+  RTC_CHECK(rtc::CreateRandomData(key_length + salt_length, &random));
+  return std::vector<uint8_t>(random.begin(), random.end());
+}
+
+// One endpoint, either sending or receiving. All its methods must be called
+// on the thread it was created on.
+class Endpoint : public sigslot::has_slots<> {
+ public:
+  Endpoint(uint32_t ssrc,
+           const rtc::SocketAddress& relay_address,
+           const webrtc::MediaCryptoKey& media_key)
+      : ssrc_(ssrc),
+        relay_address_(relay_address),
+        send_key_(CreateKey(kHopCryptoSuite)),
+        recv_key_(CreateKey(kHopCryptoSuite)),
+        packet_(nullptr, kMaxPacketSize),
+        buffer_(0, kMaxPacketSize),
+        seq_num_(0),
+        received_(0),
+        failures_(0) {
+    socket_.reset(rtc::AsyncUDPSocket::Create(
+        rtc::Thread::Current()->socketserver(),
+        rtc::SocketAddress("127.0.0.1", 0)));
+    RTC_CHECK(socket_);
+    socket_->SignalReadPacket.connect(this, &Endpoint::OnReadPacket);
+    if (FLAG_hop_srtp) {
+      srtp_.reset(new cricket::SrtpFilter());
+      RTC_CHECK(srtp_->SetRtpParams(
+          kHopCryptoSuite, send_key_.data(), static_cast<int>(send_key_.size()),
+          kHopCryptoSuite, recv_key_.data(),
+          static_cast<int>(recv_key_.size())));
+    }
+    RTC_CHECK(media_crypto_.SetOutboundKey(media_key));
+    RTC_CHECK(inbound_media_crypto_.SetInboundKey(media_key));
+  }
+
+  // The relay's view of this endpoint.
+  webrtc::PercRelay::LegConfig GetLegConfig(bool send_only) const {
+    webrtc::PercRelay::LegConfig config;
+    config.address = socket_->GetLocalAddress();
+    if (srtp_) {
+      config.crypto_suite = kHopCryptoSuite;
+      config.send_key = recv_key_;
+      config.recv_key = send_key_;
+    }
+    config.send_only = send_only;
+    return config;
+  }
+
+  void SendPacket() {
+    packet_.SetPayloadType(kPayloadType);
+    packet_.SetSequenceNumber(seq_num_++);
+    packet_.SetTimestamp(seq_num_ * 90);
+    packet_.SetSsrc(ssrc_);
+    uint8_t* payload = packet_.AllocatePayload(FLAG_payload_size);
+    memset(payload, 0, FLAG_payload_size);
+    webrtc::ByteWriter<int64_t>::WriteBigEndian(payload, rtc::TimeMicros());
+    if (!media_crypto_.Encrypt(&packet_)) {
+      ++failures_;
+      return;
+    }
+    buffer_.SetData(packet_.data(), packet_.size());
+    int length = static_cast<int>(packet_.size());
+    if (srtp_ && !srtp_->ProtectRtp(buffer_.data(), length,
+                                    static_cast<int>(buffer_.capacity()),
+                                    &length)) {
+      ++failures_;
+      return;
+    }
+    rtc::PacketOptions options;
+    socket_->SendTo(buffer_.data(), length, relay_address_, options);
+  }
+
+  size_t received() const { return received_; }
+  size_t failures() const { return failures_; }
+  const std::vector<int64_t>& latencies_us() const { return latencies_us_; }
+
+ private:
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const rtc::SocketAddress& remote_address,
+                    const rtc::PacketTime& packet_time) {
+    if (size > kMaxPacketSize)
+      return;
+    buffer_.SetData(data, size);
+    int length = static_cast<int>(size);
+    size_t header_length;
+    if ((srtp_ && !srtp_->UnprotectRtp(buffer_.data(), length, &length)) ||
+        !cricket::GetRtpHeaderLen(buffer_.data(), length, &header_length)) {
+      ++failures_;
+      return;
+    }
+    uint8_t* payload = buffer_.data() + header_length;
+    size_t payload_length = length - header_length;
+    if (!inbound_media_crypto_.Decrypt(payload, &payload_length) ||
+        payload_length < sizeof(int64_t)) {
+      ++failures_;
+      return;
+    }
+    ++received_;
+    latencies_us_.push_back(
+        rtc::TimeMicros() -
+        webrtc::ByteReader<int64_t>::ReadBigEndian(payload));
+  }
+
+  const uint32_t ssrc_;
+  const rtc::SocketAddress relay_address_;
+  const std::vector<uint8_t> send_key_;
+  const std::vector<uint8_t> recv_key_;
+  std::unique_ptr<rtc::AsyncUDPSocket> socket_;
+  std::unique_ptr<cricket::SrtpFilter> srtp_;
+  webrtc::MediaCrypto media_crypto_;
+  webrtc::MediaCrypto inbound_media_crypto_;
+  webrtc::RtpPacketToSend packet_;
+  rtc::Buffer buffer_;
+  uint16_t seq_num_;
+  size_t received_;
+  size_t failures_;
+  std::vector<int64_t> latencies_us_;
+};
+
+int64_t Percentile(const std::vector<int64_t>& sorted, int percent) {
+  if (sorted.empty())
+    return 0;
+  return sorted[(sorted.size() - 1) * percent / 100];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+  if (FLAG_help || FLAG_senders <= 0 || FLAG_receivers <= 0 ||
+      FLAG_rate <= 0 || FLAG_payload_size < static_cast<int>(sizeof(int64_t))) {
+    rtc::FlagList::Print(nullptr, false);
+    return FLAG_help ? 0 : 1;
+  }
+  // MediaCrypto expects libsrtp to be initialized by the SRTP transport.
+  cricket::SrtpSession::Init();
+
+  // The relay gets a thread, and therefore a core, of its own.
+  std::unique_ptr<rtc::Thread> relay_thread =
+      rtc::Thread::CreateWithSocketServer();
+  relay_thread->SetName("PercRelay", nullptr);
+  relay_thread->Start();
+  std::unique_ptr<rtc::Thread> receiver_thread =
+      rtc::Thread::CreateWithSocketServer();
+  receiver_thread->SetName("PercReceivers", nullptr);
+  receiver_thread->Start();
+
+  std::unique_ptr<rtc::AsyncUDPSocket> relay_socket;
+  std::unique_ptr<webrtc::PercRelay> relay;
+  relay_thread->Invoke<void>(RTC_FROM_HERE, [&] {
+    relay_socket.reset(rtc::AsyncUDPSocket::Create(
+        rtc::Thread::Current()->socketserver(),
+        rtc::SocketAddress("127.0.0.1", 0)));
+    RTC_CHECK(relay_socket);
+    relay.reset(new webrtc::PercRelay(relay_socket.get()));
+  });
+  const rtc::SocketAddress relay_address = relay_socket->GetLocalAddress();
+
+  webrtc::MediaCryptoKey media_key;
+  media_key.type = kMediaCryptoSuite;
+  media_key.buffer = CreateKey(kMediaCryptoSuite);
+
+  std::vector<std::unique_ptr<Endpoint>> senders;
+  for (int i = 0; i < FLAG_senders; ++i)
+    senders.emplace_back(new Endpoint(1000 + i, relay_address, media_key));
+  std::vector<std::unique_ptr<Endpoint>> receivers;
+  receiver_thread->Invoke<void>(RTC_FROM_HERE, [&] {
+    for (int i = 0; i < FLAG_receivers; ++i)
+      receivers.emplace_back(new Endpoint(2000 + i, relay_address, media_key));
+  });
+  relay_thread->Invoke<void>(RTC_FROM_HERE, [&] {
+    for (const auto& sender : senders)
+      RTC_CHECK(relay->AddLeg(sender->GetLegConfig(true)));
+    for (const auto& receiver : receivers)
+      RTC_CHECK(relay->AddLeg(receiver->GetLegConfig(false)));
+  });
+
+  printf("Relaying %d senders to %d receivers at %d packets/s each, "
+         "%d byte payload, hop-by-hop SRTP %s\n",
+         FLAG_senders, FLAG_receivers, FLAG_rate, FLAG_payload_size,
+         FLAG_hop_srtp ? "on" : "off");
+
+  // Sends in 1 ms rounds, catching up on whatever a late round missed.
+  const int64_t start_us = rtc::TimeMicros();
+  const int64_t duration_us = FLAG_duration * rtc::kNumMicrosecsPerSec;
+  int64_t sent_per_sender = 0;
+  for (int64_t elapsed_us = 0; elapsed_us < duration_us;
+       elapsed_us = rtc::TimeMicros() - start_us) {
+    int64_t due = elapsed_us * FLAG_rate / rtc::kNumMicrosecsPerSec;
+    for (; sent_per_sender < due; ++sent_per_sender) {
+      for (const auto& sender : senders)
+        sender->SendPacket();
+    }
+    rtc::Thread::SleepMs(1);
+  }
+  const int64_t send_time_us = rtc::TimeMicros() - start_us;
+  rtc::Thread::SleepMs(kDrainTimeMs);
+
+  webrtc::PercRelay::Stats relay_stats;
+  relay_thread->Invoke<void>(RTC_FROM_HERE,
+                             [&] { relay_stats = relay->stats(); });
+  size_t received = 0;
+  size_t failures = 0;
+  std::vector<int64_t> latencies_us;
+  receiver_thread->Invoke<void>(RTC_FROM_HERE, [&] {
+    for (const auto& receiver : receivers) {
+      received += receiver->received();
+      failures += receiver->failures();
+      latencies_us.insert(latencies_us.end(),
+                          receiver->latencies_us().begin(),
+                          receiver->latencies_us().end());
+    }
+  });
+  std::sort(latencies_us.begin(), latencies_us.end());
+
+  const int64_t expected = sent_per_sender * FLAG_senders * FLAG_receivers;
+  printf("Relay received %llu, forwarded %llu packets: %lld packets/s on "
+         "one core\n",
+         static_cast<unsigned long long>(relay_stats.rtp_received),
+         static_cast<unsigned long long>(relay_stats.forwarded),
+         static_cast<long long>(relay_stats.forwarded *
+                                rtc::kNumMicrosecsPerSec / send_time_us));
+  printf("Relay failures: unprotect %llu, protect %llu, send %llu\n",
+         static_cast<unsigned long long>(relay_stats.unprotect_failures),
+         static_cast<unsigned long long>(relay_stats.protect_failures),
+         static_cast<unsigned long long>(relay_stats.send_failures));
+  printf("Receivers got %zu of %lld packets (%.2f%% lost), %zu failures\n",
+         received, static_cast<long long>(expected),
+         expected ? 100.0 * (expected - static_cast<int64_t>(received)) /
+                        expected
+                  : 0.0,
+         failures);
+  printf("Latency us: p50 %lld, p90 %lld, p99 %lld, max %lld\n",
+         static_cast<long long>(Percentile(latencies_us, 50)),
+         static_cast<long long>(Percentile(latencies_us, 90)),
+         static_cast<long long>(Percentile(latencies_us, 99)),
+         static_cast<long long>(Percentile(latencies_us, 100)));
+
+  receiver_thread->Invoke<void>(RTC_FROM_HERE, [&] { receivers.clear(); });
+  relay_thread->Invoke<void>(RTC_FROM_HERE, [&] {
+    relay.reset();
+    relay_socket.reset();
+  });
+  return 0;
+}
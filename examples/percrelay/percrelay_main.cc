@@ -0,0 +1,114 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+
+#include <iostream>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/base/stream.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/examples/percrelay/perc_relay.h"
+
+namespace {
+
+bool ParseKey(const std::string& hex, std::vector<uint8_t>* key) {
+  key->resize(hex.size() / 2);
+  size_t length = rtc::hex_decode(reinterpret_cast<char*>(key->data()),
+                                  key->size(), hex);
+  return length > 0 && length == key->size();
+}
+
+// Each non empty line that does not start with '#' describes one leg:
+//   <ip:port> <suite> <send key> <recv key> [sendonly] [pt=<from>:<to>]...
+// Keys are hex, as seen by the relay. A suite of "none" makes a plain RTP
+// leg, with "-" in place of both keys.
+bool ParseLeg(const std::string& line, webrtc::PercRelay::LegConfig* config) {
+  std::vector<std::string> tokens;
+  if (rtc::tokenize(line, ' ', &tokens) < 4)
+    return false;
+  if (!config->address.FromString(tokens[0]))
+    return false;
+  if (tokens[1] != "none") {
+    config->crypto_suite = rtc::SrtpCryptoSuiteFromName(tokens[1]);
+    if (config->crypto_suite == rtc::SRTP_INVALID_CRYPTO_SUITE ||
+        !ParseKey(tokens[2], &config->send_key) ||
+        !ParseKey(tokens[3], &config->recv_key)) {
+      return false;
+    }
+  }
+  for (size_t i = 4; i < tokens.size(); ++i) {
+    int from;
+    int to;
+    if (tokens[i] == "sendonly") {
+      config->send_only = true;
+    } else if (sscanf(tokens[i].c_str(), "pt=%d:%d", &from, &to) == 2 &&
+               from >= 0 && from < 128 && to >= 0 && to < 128) {
+      config->payload_types[from] = to;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "usage: percrelay int-addr legs-file" << std::endl;
+    return 1;
+  }
+
+  rtc::SocketAddress int_addr;
+  if (!int_addr.FromString(argv[1])) {
+    std::cerr << "Unable to parse IP address: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  rtc::Thread* main = rtc::Thread::Current();
+  std::unique_ptr<rtc::AsyncUDPSocket> int_socket(
+      rtc::AsyncUDPSocket::Create(main->socketserver(), int_addr));
+  if (!int_socket) {
+    std::cerr << "Failed to create a UDP socket bound at "
+              << int_addr.ToString() << std::endl;
+    return 1;
+  }
+
+  webrtc::PercRelay relay(int_socket.get());
+  rtc::FileStream file;
+  if (!file.Open(argv[2], "r", nullptr)) {
+    std::cerr << "Unable to open " << argv[2] << std::endl;
+    return 1;
+  }
+  std::string line;
+  for (int line_number = 1; file.ReadLine(&line) == rtc::SR_SUCCESS;
+       ++line_number) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    webrtc::PercRelay::LegConfig config;
+    if (!ParseLeg(line, &config) || !relay.AddLeg(config)) {
+      std::cerr << "Invalid leg at line " << line_number << ": " << line
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "Relaying " << relay.num_legs() << " legs at "
+            << int_addr.ToString() << std::endl;
+
+  main->Run();
+  return 0;
+}
@@ -0,0 +1,420 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Loads a TURN server with many UDP allocations made by TurnPorts, each
+// sending to an echoing peer through the relay at a fixed rate, and reports
+// the relayed packets per second and the round trip latency. Without
+// --server, a ShardedTurnServer is started in the process.
+
+#include <stdio.h>
+#include <string.h>
+#if defined(WEBRTC_POSIX)
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/base/flags.h"
+#include "webrtc/base/helpers.h"
+#include "webrtc/base/logging.h"
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/base/network.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/p2p/base/basicpacketsocketfactory.h"
+#include "webrtc/p2p/base/p2pconstants.h"
+#include "webrtc/p2p/base/shardedturnserver.h"
+#include "webrtc/p2p/base/stun.h"
+#include "webrtc/p2p/base/turnport.h"
+
+DEFINE_bool(help, false, "Prints this message");
+DEFINE_string(server, "", "TURN server address, a local one when empty");
+DEFINE_int(server_threads, 4, "Threads of the local TURN server");
+DEFINE_string(username, "loadgen", "TURN username");
+DEFINE_string(password, "loadgen", "TURN password");
+DEFINE_string(local_ip, "127.0.0.1", "Address of the clients and the peers");
+DEFINE_int(allocations, 1000, "Number of allocations");
+DEFINE_int(threads, 4, "Client threads, each with an echoing peer");
+DEFINE_int(rate, 10, "Packets per second sent through each allocation");
+DEFINE_int(payload_size, 200, "Payload size in bytes");
+DEFINE_int(duration, 10, "Test duration in seconds");
+
+namespace {
+
+const char kRealm[] = "loadgen";
+const int kAllocateTimeoutMs = 30000;
+const int kDrainTimeMs = 500;
+// Tells the payload apart from STUN, and carries the send time.
+const uint8_t kPayloadMarker = 0x80;
+const size_t kTimestampOffset = 1;
+const size_t kMinPayloadSize = kTimestampOffset + sizeof(int64_t);
+
+enum { MSG_SEND };
+
+class LoadGenAuth : public cricket::TurnAuthInterface {
+ public:
+  bool GetKey(const std::string& username,
+              const std::string& realm,
+              std::string* key) override {
+    return username == FLAG_username &&
+           cricket::ComputeStunCredentialHash(username, realm, FLAG_password,
+                                              key);
+  }
+};
+
+std::unique_ptr<rtc::Thread> CreateThread(const char* name) {
+  // Each allocation has a socket of its own, more than select() can wait on.
+  std::unique_ptr<rtc::Thread> thread(new rtc::Thread(
+      std::unique_ptr<rtc::SocketServer>(new rtc::PhysicalSocketServer(
+          rtc::PhysicalSocketServer::Backend::kEpoll))));
+  thread->SetName(name, nullptr);
+  thread->Start();
+  return thread;
+}
+
+// Lets the process open a socket per allocation, for both the clients and a
+// local server.
+void RaiseFileLimit() {
+#if defined(WEBRTC_POSIX)
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+#endif
+}
+
+// Echoes every packet back to where it came from, i.e. to the relayed
+// address of the allocation that sent it.
+class EchoPeer : public sigslot::has_slots<> {
+ public:
+  explicit EchoPeer(const rtc::IPAddress& ip)
+      : socket_(rtc::AsyncUDPSocket::Create(
+            rtc::Thread::Current()->socketserver(),
+            rtc::SocketAddress(ip, 0))) {
+    RTC_CHECK(socket_);
+    socket_->SignalReadPacket.connect(this, &EchoPeer::OnReadPacket);
+  }
+
+  rtc::SocketAddress address() const { return socket_->GetLocalAddress(); }
+
+ private:
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const rtc::SocketAddress& remote_addr,
+                    const rtc::PacketTime& packet_time) {
+    rtc::PacketOptions options;
+    socket_->SendTo(data, size, remote_addr, options);
+  }
+
+  std::unique_ptr<rtc::AsyncUDPSocket> socket_;
+};
+
+// One allocation, made by a TurnPort, with a permission for the peer. The
+// first packets go in send indications and bind a channel for the rest.
+class Allocation : public sigslot::has_slots<> {
+ public:
+  enum State { kAllocating, kReady, kFailed };
+
+  Allocation(rtc::PacketSocketFactory* factory,
+             rtc::Network* network,
+             const rtc::IPAddress& ip,
+             const rtc::SocketAddress& server_addr,
+             const rtc::SocketAddress& peer_addr,
+             std::vector<int64_t>* latencies_us)
+      : peer_addr_(peer_addr),
+        latencies_us_(latencies_us),
+        payload_(FLAG_payload_size, 0) {
+    port_.reset(cricket::TurnPort::Create(
+        rtc::Thread::Current(), factory, network, ip, 0, 0,
+        rtc::CreateRandomString(cricket::ICE_UFRAG_LENGTH),
+        rtc::CreateRandomString(cricket::ICE_PWD_LENGTH),
+        cricket::ProtocolAddress(server_addr, cricket::PROTO_UDP),
+        cricket::RelayCredentials(FLAG_username, FLAG_password), 0,
+        std::string()));
+    port_->SignalPortComplete.connect(this, &Allocation::OnPortComplete);
+    port_->SignalPortError.connect(this, &Allocation::OnPortError);
+    port_->SignalCreatePermissionResult.connect(
+        this, &Allocation::OnCreatePermissionResult);
+    port_->PrepareAddress();
+    payload_[0] = kPayloadMarker;
+  }
+
+  State state() const { return state_; }
+  size_t sent() const { return sent_; }
+  size_t received() const { return received_; }
+
+  void Send() {
+    if (state_ != kReady)
+      return;
+    webrtc::ByteWriter<int64_t>::WriteBigEndian(&payload_[kTimestampOffset],
+                                                rtc::TimeMicros());
+    rtc::PacketOptions options;
+    if (port_->SendTo(payload_.data(), payload_.size(), peer_addr_, options,
+                      true) > 0) {
+      ++sent_;
+    }
+  }
+
+ private:
+  void OnPortComplete(cricket::Port* port) {
+    cricket::Candidate peer_candidate(
+        cricket::ICE_CANDIDATE_COMPONENT_RTP, cricket::UDP_PROTOCOL_NAME,
+        peer_addr_, 0, "", "", cricket::LOCAL_PORT_TYPE, 0, "");
+    cricket::Connection* connection = port_->CreateConnection(
+        peer_candidate, cricket::PortInterface::ORIGIN_MESSAGE);
+    if (!connection) {
+      state_ = kFailed;
+      return;
+    }
+    connection->SignalReadPacket.connect(this, &Allocation::OnReadPacket);
+  }
+
+  void OnPortError(cricket::Port* port) { state_ = kFailed; }
+
+  void OnCreatePermissionResult(cricket::TurnPort* port,
+                                const rtc::SocketAddress& addr,
+                                int code) {
+    if (state_ == kAllocating)
+      state_ = code == 0 ? kReady : kFailed;
+  }
+
+  void OnReadPacket(cricket::Connection* connection,
+                    const char* data,
+                    size_t size,
+                    const rtc::PacketTime& packet_time) {
+    if (size < kMinPayloadSize)
+      return;
+    ++received_;
+    latencies_us_->push_back(
+        rtc::TimeMicros() -
+        webrtc::ByteReader<int64_t>::ReadBigEndian(
+            reinterpret_cast<const uint8_t*>(data) + kTimestampOffset));
+  }
+
+  const rtc::SocketAddress peer_addr_;
+  std::vector<int64_t>* const latencies_us_;
+  std::vector<uint8_t> payload_;
+  std::unique_ptr<cricket::TurnPort> port_;
+  State state_ = kAllocating;
+  size_t sent_ = 0;
+  size_t received_ = 0;
+};
+
+// The allocations of one client thread, and the peer they send to. All its
+// methods must be called on that thread.
+class Client : public rtc::MessageHandler {
+ public:
+  Client(const rtc::IPAddress& ip, const rtc::SocketAddress& server_addr)
+      : ip_(ip),
+        network_("loadgen", "loadgen", ip, ip.family() == AF_INET ? 32 : 128),
+        socket_factory_(rtc::Thread::Current()),
+        server_addr_(server_addr),
+        peer_(ip) {
+    network_.AddIP(ip);
+  }
+
+  ~Client() override { rtc::Thread::Current()->Clear(this); }
+
+  void AddAllocations(int count) {
+    for (int i = 0; i < count; ++i) {
+      allocations_.emplace_back(new Allocation(&socket_factory_, &network_,
+                                               ip_, server_addr_,
+                                               peer_.address(),
+                                               &latencies_us_));
+    }
+  }
+
+  // Sends through every ready allocation at FLAG_rate, from |start_us| for
+  // |duration_us|. The allocations take turns every 1 ms, rather than all
+  // sending at once, which would overflow the socket buffers of the server.
+  void StartSending(int64_t start_us, int64_t duration_us) {
+    start_us_ = start_us;
+    duration_us_ = duration_us;
+    packets_due_ = 0;
+    rtc::Thread::Current()->Post(RTC_FROM_HERE, this, MSG_SEND);
+  }
+
+  size_t CountAllocations(Allocation::State state) const {
+    return std::count_if(allocations_.begin(), allocations_.end(),
+                         [state](const std::unique_ptr<Allocation>& a) {
+                           return a->state() == state;
+                         });
+  }
+  size_t sent() const {
+    size_t sent = 0;
+    for (const auto& allocation : allocations_)
+      sent += allocation->sent();
+    return sent;
+  }
+  size_t received() const {
+    size_t received = 0;
+    for (const auto& allocation : allocations_)
+      received += allocation->received();
+    return received;
+  }
+  const std::vector<int64_t>& latencies_us() const { return latencies_us_; }
+
+ private:
+  void OnMessage(rtc::Message* msg) override {
+    RTC_DCHECK_EQ(MSG_SEND, msg->message_id);
+    int64_t elapsed_us = std::min(rtc::TimeMicros() - start_us_, duration_us_);
+    const int64_t num_allocations = allocations_.size();
+    int64_t due = elapsed_us * FLAG_rate * num_allocations /
+                  rtc::kNumMicrosecsPerSec;
+    for (; packets_due_ < due; ++packets_due_)
+      allocations_[packets_due_ % num_allocations]->Send();
+    if (elapsed_us < duration_us_)
+      rtc::Thread::Current()->PostDelayed(RTC_FROM_HERE, 1, this, MSG_SEND);
+  }
+
+  const rtc::IPAddress ip_;
+  rtc::Network network_;
+  rtc::BasicPacketSocketFactory socket_factory_;
+  const rtc::SocketAddress server_addr_;
+  EchoPeer peer_;
+  std::vector<std::unique_ptr<Allocation>> allocations_;
+  std::vector<int64_t> latencies_us_;
+  int64_t start_us_ = 0;
+  int64_t duration_us_ = 0;
+  int64_t packets_due_ = 0;
+};
+
+int64_t Percentile(const std::vector<int64_t>& sorted, int percent) {
+  if (sorted.empty())
+    return 0;
+  return sorted[(sorted.size() - 1) * percent / 100];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+  rtc::IPAddress local_ip;
+  if (FLAG_help || !rtc::IPFromString(FLAG_local_ip, &local_ip) ||
+      FLAG_allocations <= 0 || FLAG_threads <= 0 || FLAG_rate <= 0 ||
+      FLAG_server_threads <= 0 ||
+      FLAG_payload_size < static_cast<int>(kMinPayloadSize)) {
+    rtc::FlagList::Print(nullptr, false);
+    return FLAG_help ? 0 : 1;
+  }
+  RaiseFileLimit();
+  // Every allocation logs its setup.
+  rtc::LogMessage::LogToDebug(rtc::LS_WARNING);
+
+  LoadGenAuth auth;
+  std::unique_ptr<cricket::ShardedTurnServer> local_server;
+  rtc::SocketAddress server_addr;
+  if (strlen(FLAG_server) == 0) {
+    local_server.reset(new cricket::ShardedTurnServer(FLAG_server_threads));
+    local_server->set_realm(kRealm);
+    local_server->set_auth_hook(&auth);
+    if (!local_server->Start(rtc::SocketAddress(local_ip, 0), local_ip)) {
+      fprintf(stderr, "Failed to start the local TURN server\n");
+      return 1;
+    }
+    server_addr = local_server->address();
+  } else if (!server_addr.FromString(FLAG_server)) {
+    fprintf(stderr, "Unable to parse the server address: %s\n", FLAG_server);
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<rtc::Thread>> threads;
+  std::vector<std::unique_ptr<Client>> clients(FLAG_threads);
+  const int64_t allocate_start_ms = rtc::TimeMillis();
+  for (int i = 0; i < FLAG_threads; ++i) {
+    threads.push_back(CreateThread("TurnLoadGenClient"));
+    int count = FLAG_allocations / FLAG_threads +
+                (i < FLAG_allocations % FLAG_threads ? 1 : 0);
+    threads[i]->Invoke<void>(RTC_FROM_HERE, [&, i, count] {
+      clients[i].reset(new Client(local_ip, server_addr));
+      clients[i]->AddAllocations(count);
+    });
+  }
+
+  size_t ready = 0;
+  size_t failed = 0;
+  while (true) {
+    ready = 0;
+    failed = 0;
+    for (int i = 0; i < FLAG_threads; ++i) {
+      threads[i]->Invoke<void>(RTC_FROM_HERE, [&, i] {
+        ready += clients[i]->CountAllocations(Allocation::kReady);
+        failed += clients[i]->CountAllocations(Allocation::kFailed);
+      });
+    }
+    if (ready + failed == static_cast<size_t>(FLAG_allocations) ||
+        rtc::TimeMillis() - allocate_start_ms > kAllocateTimeoutMs) {
+      break;
+    }
+    rtc::Thread::SleepMs(10);
+  }
+  printf("Allocated %zu of %d in %lld ms, %zu failed, through %s %s\n",
+         ready, FLAG_allocations,
+         static_cast<long long>(rtc::TimeMillis() - allocate_start_ms),
+         failed, local_server ? "a local server at" : "the server at",
+         server_addr.ToString().c_str());
+  if (local_server) {
+    printf("Allocations per server thread:");
+    for (size_t num : local_server->GetNumAllocations())
+      printf(" %zu", num);
+    printf("\n");
+  }
+
+  const int64_t start_us = rtc::TimeMicros();
+  const int64_t duration_us = FLAG_duration * rtc::kNumMicrosecsPerSec;
+  for (int i = 0; i < FLAG_threads; ++i) {
+    threads[i]->Invoke<void>(RTC_FROM_HERE, [&, i] {
+      clients[i]->StartSending(start_us, duration_us);
+    });
+  }
+  rtc::Thread::SleepMs(FLAG_duration * rtc::kNumMillisecsPerSec +
+                       kDrainTimeMs);
+
+  size_t sent = 0;
+  size_t received = 0;
+  std::vector<int64_t> latencies_us;
+  for (int i = 0; i < FLAG_threads; ++i) {
+    threads[i]->Invoke<void>(RTC_FROM_HERE, [&, i] {
+      sent += clients[i]->sent();
+      received += clients[i]->received();
+      latencies_us.insert(latencies_us.end(),
+                          clients[i]->latencies_us().begin(),
+                          clients[i]->latencies_us().end());
+    });
+  }
+  std::sort(latencies_us.begin(), latencies_us.end());
+
+  // Every echoed packet was relayed twice, to the peer and back.
+  printf("Sent %zu, received %zu echoes (%.2f%% lost): %lld relayed "
+         "packets/s\n",
+         sent, received,
+         sent ? 100.0 * (sent - std::min(sent, received)) / sent : 0.0,
+         static_cast<long long>(2 * received * rtc::kNumMicrosecsPerSec /
+                                duration_us));
+  printf("Round trip us: p50 %lld, p90 %lld, p99 %lld, max %lld\n",
+         static_cast<long long>(Percentile(latencies_us, 50)),
+         static_cast<long long>(Percentile(latencies_us, 90)),
+         static_cast<long long>(Percentile(latencies_us, 99)),
+         static_cast<long long>(Percentile(latencies_us, 100)));
+
+  for (int i = 0; i < FLAG_threads; ++i)
+    threads[i]->Invoke<void>(RTC_FROM_HERE, [&, i] { clients[i].reset(); });
+  return 0;
+}
@@ -10,15 +10,15 @@
 
 #include <iostream>  // NOLINT
 
-#include "webrtc/p2p/base/basicpacketsocketfactory.h"
-#include "webrtc/p2p/base/turnserver.h"
-#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/p2p/base/shardedturnserver.h"
 #include "webrtc/base/optionsfile.h"
 #include "webrtc/base/stringencode.h"
 #include "webrtc/base/thread.h"
 
 static const char kSoftware[] = "libjingle TurnServer";
 
+// Only reads the file once loaded, so it may be used by all the shards at
+// the same time.
 class TurnFileAuth : public cricket::TurnAuthInterface {
  public:
   explicit TurnFileAuth(const std::string& path) : file_(path) {
@@ -42,8 +42,8 @@ class TurnFileAuth : public cricket::TurnAuthInterface {
 };
 
 int main(int argc, char **argv) {
-  if (argc != 5) {
-    std::cerr << "usage: turnserver int-addr ext-ip realm auth-file"
+  if (argc != 5 && argc != 6) {
+    std::cerr << "usage: turnserver int-addr ext-ip realm auth-file [threads]"
               << std::endl;
     return 1;
   }
@@ -60,26 +60,28 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  rtc::Thread* main = rtc::Thread::Current();
-  rtc::AsyncUDPSocket* int_socket =
-      rtc::AsyncUDPSocket::Create(main->socketserver(), int_addr);
-  if (!int_socket) {
-    std::cerr << "Failed to create a UDP socket bound at"
-              << int_addr.ToString() << std::endl;
+  // Allocations are spread across the threads by their 5-tuple.
+  int num_threads = 1;
+  if (argc == 6 && (!rtc::FromString(argv[5], &num_threads) ||
+                    num_threads <= 0)) {
+    std::cerr << "Invalid number of threads: " << argv[5] << std::endl;
     return 1;
   }
 
-  cricket::TurnServer server(main);
+  cricket::ShardedTurnServer server(num_threads);
   TurnFileAuth auth(argv[4]);
   server.set_realm(argv[3]);
   server.set_software(kSoftware);
   server.set_auth_hook(&auth);
-  server.AddInternalSocket(int_socket, cricket::PROTO_UDP);
-  server.SetExternalSocketFactory(new rtc::BasicPacketSocketFactory(),
-                                  rtc::SocketAddress(ext_addr, 0));
+  if (!server.Start(int_addr, ext_addr)) {
+    std::cerr << "Failed to listen at " << int_addr.ToString() << " on "
+              << num_threads << " threads" << std::endl;
+    return 1;
+  }
 
-  std::cout << "Listening internally at " << int_addr.ToString() << std::endl;
+  std::cout << "Listening internally at " << server.address().ToString()
+            << " on " << num_threads << " threads" << std::endl;
 
-  main->Run();
+  rtc::Thread::Current()->Run();
   return 0;
 }
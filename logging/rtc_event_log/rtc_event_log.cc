@@ -80,12 +80,13 @@ class RtcEventLogImpl final : public RtcEventLog {
 
  private:
   void StoreEvent(std::unique_ptr<rtclog::Event>* event);
+  void StoreEvent(RtcEventLogHelperThread::QueuedEvent* event);
 
   // Message queue for passing control messages to the logging thread.
   SwapQueue<RtcEventLogHelperThread::ControlMessage> message_queue_;
 
   // Message queue for passing events to the logging thread.
-  SwapQueue<std::unique_ptr<rtclog::Event> > event_queue_;
+  SwapQueue<RtcEventLogHelperThread::QueuedEvent> event_queue_;
 
   RtcEventLogHelperThread helper_thread_;
   rtc::ThreadChecker thread_checker_;
@@ -352,6 +353,21 @@ void RtcEventLogImpl::LogRtpHeader(PacketDirection direction,
     header_length += (x_len + 1) * 4;
   }
 
+  // Most headers are passed to the logging thread as they are, and are delta
+  // encoded there.
+  if (header_length <=
+      RtcEventLogHelperThread::QueuedEvent::kMaxRtpHeaderSize) {
+    RtcEventLogHelperThread::QueuedEvent rtp_event;
+    rtp_event.timestamp_us = rtc::TimeMicros();
+    rtp_event.incoming = direction == kIncomingPacket;
+    rtp_event.media_type = ConvertMediaType(media_type);
+    rtp_event.packet_length = static_cast<uint32_t>(packet_length);
+    rtp_event.header_length = static_cast<uint8_t>(header_length);
+    memcpy(rtp_event.header, header, header_length);
+    StoreEvent(&rtp_event);
+    return;
+  }
+
   std::unique_ptr<rtclog::Event> rtp_event(new rtclog::Event());
   rtp_event->set_timestamp_us(rtc::TimeMicros());
   rtp_event->set_type(rtclog::Event::RTP_EVENT);
@@ -435,6 +451,13 @@ void RtcEventLogImpl::LogBwePacketLossEvent(int32_t bitrate,
 }
 
 void RtcEventLogImpl::StoreEvent(std::unique_ptr<rtclog::Event>* event) {
+  RtcEventLogHelperThread::QueuedEvent queued_event;
+  queued_event.timestamp_us = (*event)->timestamp_us();
+  queued_event.event = std::move(*event);
+  StoreEvent(&queued_event);
+}
+
+void RtcEventLogImpl::StoreEvent(RtcEventLogHelperThread::QueuedEvent* event) {
   if (!event_queue_.Insert(event)) {
     LOG(LS_ERROR) << "WebRTC event log queue full. Dropping event.";
   }
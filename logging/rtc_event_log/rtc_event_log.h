@@ -120,6 +120,8 @@ class RtcEventLog {
   // The current implementation writes a LOG_START event, then the old
   // configurations, then the remaining events in timestamp order and finally
   // a LOG_END event. However, this might change without further notice.
+  // Most RTP packets are stored in RTP_PACKET_BATCH_EVENTs, which
+  // ParsedRtcEventLog expands to RTP_EVENTs.
   // TODO(terelius): Change result type to a vector?
   static bool ParseRtcEventLog(const std::string& file_name,
                                rtclog::EventStream* result);
@@ -21,7 +21,16 @@
 namespace webrtc {
 
 namespace {
-const int kEventsInHistory = 10000;
+const size_t kEventsInHistory = 10000;
+// The history is dropped a block at a time, so that the RTP headers of a
+// block can be encoded against each other.
+const size_t kEventsPerHistoryBlock = 250;
+// A batch is written when it reaches either limit. This keeps the events
+// the parser has to hold back before the batch is read to a few hundred.
+const size_t kPacketsPerBatch = 250;
+const size_t kBytesPerBatch = 16384;
+// Upper bound of the bytes a batch event adds to its encoded packets.
+const size_t kBatchOverhead = 48;
 
 bool IsConfigEvent(const rtclog::Event& event) {
   rtclog::Event_EventType event_type = event.type();
@@ -35,10 +44,11 @@ bool IsConfigEvent(const rtclog::Event& event) {
 // RtcEventLogImpl member functions.
 RtcEventLogHelperThread::RtcEventLogHelperThread(
     SwapQueue<ControlMessage>* message_queue,
-    SwapQueue<std::unique_ptr<rtclog::Event>>* event_queue)
+    SwapQueue<QueuedEvent>* event_queue)
     : message_queue_(message_queue),
       event_queue_(event_queue),
-      history_(kEventsInHistory),
+      history_(),
+      events_in_history_(0),
       config_history_(),
       file_(FileWrapper::Create()),
       thread_(&ThreadOutputFunction, this, "RtcEventLog thread"),
@@ -48,6 +58,7 @@ RtcEventLogHelperThread::RtcEventLogHelperThread(
       stop_time_(std::numeric_limits<int64_t>::max()),
       has_recent_event_(false),
       most_recent_event_(),
+      file_batch_(),
       output_string_(),
       wake_periodically_(false, false),
       wake_from_hibernation_(false, false),
@@ -92,9 +103,13 @@ bool RtcEventLogHelperThread::AppendEventToString(rtclog::Event* event) {
   // We create a new event stream per event but because of the way protobufs
   // are encoded, events can be merged by concatenating them. Therefore,
   // it will look like a single stream when we read it back from file.
+  // Leave room for the RTP headers that have yet to be written.
+  const size_t reserved_bytes =
+      file_batch_.num_packets() > 0 ? file_batch_.data().size() + kBatchOverhead
+                                    : 0;
   bool stop = true;
   if (written_bytes_ + static_cast<int64_t>(output_string_.size()) +
-          event_stream.ByteSize() <=
+          static_cast<int64_t>(reserved_bytes) + event_stream.ByteSize() <=
       max_size_bytes_) {
     event_stream.AppendToString(&output_string_);
     stop = false;
@@ -104,6 +119,71 @@ bool RtcEventLogHelperThread::AppendEventToString(rtclog::Event* event) {
   return stop;
 }
 
+bool RtcEventLogHelperThread::AppendBatchToString(
+    RtpHeaderBatchEncoder* batch) {
+  if (batch->num_packets() == 0) {
+    // The other events counted were logged without packets, they must not be
+    // counted in the next batch, which may be in another file.
+    batch->Clear();
+    return false;
+  }
+  rtclog::Event batch_event;
+  batch_event.set_timestamp_us(batch->first_timestamp_us());
+  batch_event.set_type(rtclog::Event::RTP_PACKET_BATCH_EVENT);
+  rtclog::RtpPacketBatch* packets = batch_event.mutable_rtp_packet_batch();
+  packets->set_interleaved_events(batch->num_other_events());
+  packets->set_packet_count(batch->num_packets());
+  packets->set_packets(batch->data());
+  // The room for |file_batch_| is reserved, so it has to be released before
+  // the batch is appended.
+  batch->Clear();
+  return AppendEventToString(&batch_event);
+}
+
+bool RtcEventLogHelperThread::AppendRtpHeaderToBatch(
+    const QueuedEvent& packet) {
+  if (written_bytes_ + static_cast<int64_t>(output_string_.size()) +
+          static_cast<int64_t>(file_batch_.data().size() + kBatchOverhead +
+                               RtpHeaderBatchEncoder::kMaxEncodedPacketSize) >
+      max_size_bytes_) {
+    return true;
+  }
+  file_batch_.AddRtpHeader(packet.timestamp_us, packet.incoming,
+                           packet.media_type, packet.header,
+                           packet.header_length, packet.packet_length);
+  if (file_batch_.num_packets() >= kPacketsPerBatch ||
+      file_batch_.data().size() >= kBytesPerBatch) {
+    return AppendBatchToString(&file_batch_);
+  }
+  return false;
+}
+
+RtcEventLogHelperThread::HistoryBlock*
+RtcEventLogHelperThread::HistoryBlockWithRoom() {
+  if (!history_.empty() &&
+      history_.back()->size() < kEventsPerHistoryBlock &&
+      history_.back()->rtp_batch.data().size() < kBytesPerBatch) {
+    return history_.back().get();
+  }
+  // Drop the oldest blocks to make room for a new one, and reuse the memory
+  // of the last of them.
+  std::unique_ptr<HistoryBlock> block;
+  while (!history_.empty() &&
+         events_in_history_ + kEventsPerHistoryBlock > kEventsInHistory) {
+    block = std::move(history_.front());
+    history_.pop_front();
+    events_in_history_ -= block->size();
+  }
+  if (block) {
+    block->events.clear();
+    block->rtp_batch.Clear();
+  } else {
+    block.reset(new HistoryBlock());
+  }
+  history_.push_back(std::move(block));
+  return history_.back().get();
+}
+
 bool RtcEventLogHelperThread::LogToMemory() {
   RTC_DCHECK(!file_->is_open());
   bool message_received = false;
@@ -115,11 +195,22 @@ bool RtcEventLogHelperThread::LogToMemory() {
     has_recent_event_ = event_queue_->Remove(&most_recent_event_);
   }
   while (has_recent_event_ &&
-         most_recent_event_->timestamp_us() <= current_time) {
-    if (IsConfigEvent(*most_recent_event_)) {
-      config_history_.push_back(std::move(most_recent_event_));
+         most_recent_event_.timestamp_us <= current_time) {
+    rtclog::Event* event = most_recent_event_.event.get();
+    if (event && IsConfigEvent(*event)) {
+      config_history_.push_back(std::move(most_recent_event_.event));
+    } else if (event) {
+      HistoryBlock* block = HistoryBlockWithRoom();
+      block->events.push_back(std::move(most_recent_event_.event));
+      block->rtp_batch.AddOtherEvent();
+      ++events_in_history_;
     } else {
-      history_.push_back(std::move(most_recent_event_));
+      HistoryBlock* block = HistoryBlockWithRoom();
+      block->rtp_batch.AddRtpHeader(
+          most_recent_event_.timestamp_us, most_recent_event_.incoming,
+          most_recent_event_.media_type, most_recent_event_.header,
+          most_recent_event_.header_length, most_recent_event_.packet_length);
+      ++events_in_history_;
     }
     has_recent_event_ = event_queue_->Remove(&most_recent_event_);
     message_received = true;
@@ -143,10 +234,22 @@ void RtcEventLogHelperThread::StartLogFile() {
     AppendEventToString(event.get());
   }
 
-  // Serialize the events in the event queue.
+  // Serialize the events in the history, a block at a time. The RTP headers
+  // of a block can only be read back after all its other events, so they are
+  // dropped if those don't fit.
   while (!history_.empty() && !stop) {
-    stop = AppendEventToString(history_.front().get());
-    if (!stop) {
+    HistoryBlock* block = history_.front().get();
+    events_in_history_ -= block->size();
+    for (auto& event : block->events) {
+      stop = AppendEventToString(event.get());
+      if (stop)
+        break;
+    }
+    if (!stop)
+      stop = AppendBatchToString(&block->rtp_batch);
+    if (stop) {
+      events_in_history_ += block->size();
+    } else {
       history_.pop_front();
     }
   }
@@ -185,16 +288,26 @@ bool RtcEventLogHelperThread::LogToFile() {
   }
   bool stop = false;
   while (!stop && has_recent_event_ &&
-         most_recent_event_->timestamp_us() <= time_limit) {
-    stop = AppendEventToString(most_recent_event_.get());
-    if (!stop) {
-      if (IsConfigEvent(*most_recent_event_)) {
-        config_history_.push_back(std::move(most_recent_event_));
+         most_recent_event_.timestamp_us <= time_limit) {
+    rtclog::Event* event = most_recent_event_.event.get();
+    if (event) {
+      stop = AppendEventToString(event);
+      if (!stop) {
+        file_batch_.AddOtherEvent();
+        if (IsConfigEvent(*event)) {
+          config_history_.push_back(std::move(most_recent_event_.event));
+        }
       }
+    } else {
+      stop = AppendRtpHeaderToBatch(most_recent_event_);
+    }
+    if (!stop) {
       has_recent_event_ = event_queue_->Remove(&most_recent_event_);
     }
     message_received = true;
   }
+  // There is always room for the batch.
+  AppendBatchToString(&file_batch_);
 
   // Write string to file.
   if (!file_->Write(output_string_.data(), output_string_.size())) {
@@ -209,7 +322,7 @@ bool RtcEventLogHelperThread::LogToFile() {
   // want to stop logging if the remaining events are more recent than the
   // time limit, or in other words if we have terminated the loop despite
   // having more events in the queue.
-  if ((has_recent_event_ && most_recent_event_->timestamp_us() > stop_time_) ||
+  if ((has_recent_event_ && most_recent_event_.timestamp_us > stop_time_) ||
       stop) {
     RTC_DCHECK(file_->is_open());
     StopLogFile();
@@ -220,6 +333,7 @@ bool RtcEventLogHelperThread::LogToFile() {
 void RtcEventLogHelperThread::StopLogFile() {
   RTC_DCHECK(file_->is_open());
   output_string_.clear();
+  AppendBatchToString(&file_batch_);
 
   rtclog::Event end_event;
   // This function can be called either because we have reached the stop time,
@@ -11,6 +11,7 @@
 #ifndef WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_LOG_HELPER_THREAD_H_
 #define WEBRTC_LOGGING_RTC_EVENT_LOG_RTC_EVENT_LOG_HELPER_THREAD_H_
 
+#include <deque>
 #include <limits>
 #include <memory>
 #include <string>
@@ -22,7 +23,7 @@
 #include "webrtc/base/ignore_wundef.h"
 #include "webrtc/base/platform_thread.h"
 #include "webrtc/base/swap_queue.h"
-#include "webrtc/logging/rtc_event_log/ringbuffer.h"
+#include "webrtc/logging/rtc_event_log/rtp_header_batch.h"
 #include "webrtc/system_wrappers/include/file_wrapper.h"
 
 #ifdef ENABLE_RTC_EVENT_LOG
@@ -66,9 +67,42 @@ class RtcEventLogHelperThread final {
     }
   };
 
-  RtcEventLogHelperThread(
-      SwapQueue<ControlMessage>* message_queue,
-      SwapQueue<std::unique_ptr<rtclog::Event>>* event_queue);
+  // An event, or the RTP header of a packet. The header is copied into the
+  // element, so that logging a packet does not allocate any memory.
+  struct QueuedEvent {
+    static const size_t kMaxRtpHeaderSize =
+        RtpHeaderBatchEncoder::kMaxHeaderSize;
+
+    QueuedEvent()
+        : event(nullptr),
+          timestamp_us(0),
+          incoming(false),
+          media_type(rtclog::ANY),
+          packet_length(0),
+          header_length(0) {}
+
+    std::unique_ptr<rtclog::Event> event;  // Null for an RTP header.
+    int64_t timestamp_us;
+    bool incoming;                         // Only used for an RTP header.
+    rtclog::MediaType media_type;          // Only used for an RTP header.
+    uint32_t packet_length;                // Only used for an RTP header.
+    uint8_t header_length;                 // Only used for an RTP header.
+    uint8_t header[kMaxRtpHeaderSize];     // Only used for an RTP header.
+
+    friend void swap(QueuedEvent& lhs, QueuedEvent& rhs) {
+      using std::swap;
+      lhs.event.swap(rhs.event);
+      swap(lhs.timestamp_us, rhs.timestamp_us);
+      swap(lhs.incoming, rhs.incoming);
+      swap(lhs.media_type, rhs.media_type);
+      swap(lhs.packet_length, rhs.packet_length);
+      swap(lhs.header_length, rhs.header_length);
+      swap(lhs.header, rhs.header);
+    }
+  };
+
+  RtcEventLogHelperThread(SwapQueue<ControlMessage>* message_queue,
+                          SwapQueue<QueuedEvent>* event_queue);
   ~RtcEventLogHelperThread();
 
   // This function MUST be called once a STOP_FILE message is added to the
@@ -81,9 +115,21 @@ class RtcEventLogHelperThread final {
   void SignalNewEvent();
 
  private:
+  // A run of recent events. The RTP headers among them are encoded in
+  // |rtp_batch|, and the other events are kept in |events|.
+  struct HistoryBlock {
+    size_t size() const { return events.size() + rtp_batch.num_packets(); }
+
+    std::vector<std::unique_ptr<rtclog::Event>> events;
+    RtpHeaderBatchEncoder rtp_batch;
+  };
+
   static bool ThreadOutputFunction(void* obj);
 
   bool AppendEventToString(rtclog::Event* event);
+  bool AppendBatchToString(RtpHeaderBatchEncoder* batch);
+  bool AppendRtpHeaderToBatch(const QueuedEvent& packet);
+  HistoryBlock* HistoryBlockWithRoom();
   bool LogToMemory();
   void StartLogFile();
   bool LogToFile();
@@ -92,10 +138,11 @@ class RtcEventLogHelperThread final {
 
   // Message queues for passing events to the logging thread.
   SwapQueue<ControlMessage>* message_queue_;
-  SwapQueue<std::unique_ptr<rtclog::Event>>* event_queue_;
+  SwapQueue<QueuedEvent>* event_queue_;
 
   // History containing the most recent events (~ 10 s).
-  RingBuffer<std::unique_ptr<rtclog::Event>> history_;
+  std::deque<std::unique_ptr<HistoryBlock>> history_;
+  size_t events_in_history_;
 
   // History containing all past configuration events.
   std::vector<std::unique_ptr<rtclog::Event>> config_history_;
@@ -109,7 +156,10 @@ class RtcEventLogHelperThread final {
   int64_t stop_time_;
 
   bool has_recent_event_;
-  std::unique_ptr<rtclog::Event> most_recent_event_;
+  QueuedEvent most_recent_event_;
+
+  // The RTP headers logged to file since the last batch was written.
+  RtpHeaderBatchEncoder file_batch_;
 
   // Temporary space for serializing profobuf data.
   std::string output_string_;
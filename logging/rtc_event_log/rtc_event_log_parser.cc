@@ -20,6 +20,7 @@
 #include "webrtc/base/logging.h"
 #include "webrtc/call/call.h"
 #include "webrtc/logging/rtc_event_log/rtc_event_log.h"
+#include "webrtc/logging/rtc_event_log/rtp_header_batch.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "webrtc/system_wrappers/include/file_wrapper.h"
 
@@ -79,6 +80,10 @@ ParsedRtcEventLog::EventType GetRuntimeEventType(
       return ParsedRtcEventLog::EventType::AUDIO_RECEIVER_CONFIG_EVENT;
     case rtclog::Event::AUDIO_SENDER_CONFIG_EVENT:
       return ParsedRtcEventLog::EventType::AUDIO_SENDER_CONFIG_EVENT;
+    case rtclog::Event::RTP_PACKET_BATCH_EVENT:
+      // Batches are expanded to RTP events as the log is parsed.
+      RTC_NOTREACHED();
+      return ParsedRtcEventLog::EventType::UNKNOWN_EVENT;
   }
   RTC_NOTREACHED();
   return ParsedRtcEventLog::EventType::UNKNOWN_EVENT;
@@ -188,10 +193,67 @@ bool ParsedRtcEventLog::ParseStream(std::istream& stream) {
       LOG(LS_WARNING) << "Failed to parse protobuf message.";
       return false;
     }
+    if (event.type() == rtclog::Event::RTP_PACKET_BATCH_EVENT) {
+      if (!ExpandRtpPacketBatch(event)) {
+        LOG(LS_WARNING) << "Failed to decode RTP packet batch.";
+        return false;
+      }
+      continue;
+    }
     events_.push_back(event);
   }
 }
 
+bool ParsedRtcEventLog::ExpandRtpPacketBatch(
+    const rtclog::Event& batch_event) {
+  if (!batch_event.has_timestamp_us() || !batch_event.has_rtp_packet_batch())
+    return false;
+  const rtclog::RtpPacketBatch& batch = batch_event.rtp_packet_batch();
+  if (!batch.has_interleaved_events() || !batch.has_packet_count() ||
+      !batch.has_packets() || batch.interleaved_events() > events_.size()) {
+    return false;
+  }
+  std::vector<RtpHeaderBatchDecoder::Packet> packets;
+  if (!RtpHeaderBatchDecoder::Decode(batch.packets(), batch.packet_count(),
+                                     batch_event.timestamp_us(), &packets)) {
+    return false;
+  }
+
+  // Take out the events the packets were logged among, and put them back
+  // with the packets in between.
+  const size_t first_event = events_.size() - batch.interleaved_events();
+  std::vector<rtclog::Event> interleaved_events(batch.interleaved_events());
+  for (size_t i = 0; i < interleaved_events.size(); ++i)
+    interleaved_events[i].Swap(&events_[first_event + i]);
+  events_.resize(first_event);
+  events_.reserve(first_event + interleaved_events.size() + packets.size());
+  size_t next_event = 0;
+  for (const RtpHeaderBatchDecoder::Packet& packet : packets) {
+    if (packet.position > interleaved_events.size() ||
+        !rtclog::MediaType_IsValid(packet.media_type)) {
+      return false;
+    }
+    for (; next_event < packet.position; ++next_event) {
+      events_.emplace_back();
+      events_.back().Swap(&interleaved_events[next_event]);
+    }
+    events_.emplace_back();
+    rtclog::Event* rtp_event = &events_.back();
+    rtp_event->set_timestamp_us(packet.timestamp_us);
+    rtp_event->set_type(rtclog::Event::RTP_EVENT);
+    rtclog::RtpPacket* rtp_packet = rtp_event->mutable_rtp_packet();
+    rtp_packet->set_incoming(packet.incoming);
+    rtp_packet->set_type(static_cast<rtclog::MediaType>(packet.media_type));
+    rtp_packet->set_packet_length(packet.packet_length);
+    rtp_packet->set_header(packet.header.data(), packet.header.size());
+  }
+  for (; next_event < interleaved_events.size(); ++next_event) {
+    events_.emplace_back();
+    events_.back().Swap(&interleaved_events[next_event]);
+  }
+  return true;
+}
+
 size_t ParsedRtcEventLog::GetNumberOfEvents() const {
   return events_.size();
 }
@@ -124,6 +124,10 @@ class ParsedRtcEventLog {
                              int32_t* total_packets) const;
 
  private:
+  // Replaces the last events with them and the RTP events of |batch_event|,
+  // in the order they were logged. Returns false if the batch is malformed.
+  bool ExpandRtpPacketBatch(const rtclog::Event& batch_event);
+
   std::vector<rtclog::Event> events_;
 };
 
@@ -0,0 +1,366 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "webrtc/api/video/video_rotation.h"
+#include "webrtc/base/buffer.h"
+#include "webrtc/base/fakeclock.h"
+#include "webrtc/base/random.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/call/call.h"
+#include "webrtc/logging/rtc_event_log/rtc_event_log.h"
+#include "webrtc/logging/rtc_event_log/rtc_event_log_parser.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet/sender_report.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_header_extension.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/system_wrappers/include/sleep.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+// Files generated at build-time by the protobuf compiler.
+#ifdef WEBRTC_ANDROID_PLATFORM_BUILD
+#include "external/webrtc/webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#else
+#include "webrtc/logging/rtc_event_log/rtc_event_log.pb.h"
+#endif
+
+namespace webrtc {
+
+namespace {
+
+const int kCallSeconds = 30;
+const int kAudioFrameMs = 20;
+const int kVideoFrameMs = 33;
+const int kKeyFrameIntervalMs = 3000;
+const size_t kVideoFrameBytes = 6000;  // About 1.5 Mbps at 30 fps.
+const size_t kMaxPayloadBytes = 1100;
+const int kRtcpIntervalMs = 500;
+const int kPlayoutIntervalMs = 10;
+const int kBweIntervalMs = 1000;
+// The logging thread picks up the queued events every 100 ms, and the queue
+// holds 1000 events. Pausing after every second of the call keeps the queue
+// from overflowing.
+const int kPauseMs = 150;
+
+// An event of the call, as it is passed to the event log.
+struct CallEvent {
+  enum { RTP_PACKET, RTCP_PACKET, AUDIO_PLAYOUT, BWE_PACKET_LOSS } type;
+  int64_t time_us;
+  PacketDirection direction;
+  MediaType media_type;
+  rtc::Buffer packet;  // The header only for an RTP packet.
+  size_t packet_length;
+  uint32_t ssrc;
+  int32_t bitrate;
+  uint8_t fraction_loss;
+};
+
+// The packets one side of a call sends: an audio stream and a video stream
+// that share a transport sequence number.
+struct Endpoint {
+  PacketDirection direction;
+  uint32_t audio_ssrc;
+  uint32_t video_ssrc;
+  uint16_t audio_sequence_number;
+  uint16_t video_sequence_number;
+  uint16_t transport_sequence_number;
+  uint32_t audio_timestamp;
+  uint32_t video_timestamp;
+  size_t video_bytes_left;
+};
+
+// Generates the events of a call with an audio and a video stream in each
+// direction, so that they can be logged without spending time on them.
+class SimulatedCall {
+ public:
+  SimulatedCall() : prng_(4711) {
+    extensions_.Register<AudioLevel>(1);
+    extensions_.Register<AbsoluteSendTime>(2);
+    extensions_.Register<TransmissionOffset>(3);
+    extensions_.Register<TransportSequenceNumber>(4);
+    extensions_.Register<VideoOrientation>(5);
+    for (PacketDirection direction : {kOutgoingPacket, kIncomingPacket}) {
+      Endpoint endpoint;
+      endpoint.direction = direction;
+      endpoint.audio_ssrc = prng_.Rand<uint32_t>();
+      endpoint.video_ssrc = prng_.Rand<uint32_t>();
+      endpoint.audio_sequence_number = prng_.Rand<uint16_t>();
+      endpoint.video_sequence_number = prng_.Rand<uint16_t>();
+      endpoint.transport_sequence_number = prng_.Rand<uint16_t>();
+      endpoint.audio_timestamp = prng_.Rand<uint32_t>();
+      endpoint.video_timestamp = prng_.Rand<uint32_t>();
+      endpoint.video_bytes_left = 0;
+      endpoints_.push_back(endpoint);
+    }
+  }
+
+  std::vector<CallEvent> Generate(int seconds) {
+    for (int64_t time_ms = 0; time_ms < seconds * 1000; ++time_ms) {
+      time_us_ = time_ms * 1000;
+      for (size_t i = 0; i < endpoints_.size(); ++i) {
+        Endpoint* endpoint = &endpoints_[i];
+        if (time_ms % kAudioFrameMs == 0)
+          AddAudioPacket(endpoint);
+        if (time_ms % kVideoFrameMs == 0) {
+          endpoint->video_bytes_left =
+              time_ms % kKeyFrameIntervalMs == 0
+                  ? 5 * kVideoFrameBytes
+                  : prng_.Rand<uint32_t>() % kVideoFrameBytes +
+                        kVideoFrameBytes / 2;
+          endpoint->video_timestamp += 90 * kVideoFrameMs;
+        }
+        // The pacer sends a packet per millisecond, and more when a key frame
+        // has to go out.
+        do {
+          AddVideoPacket(endpoint);
+        } while (endpoint->video_bytes_left > 4 * kVideoFrameBytes);
+        if (time_ms % kRtcpIntervalMs == 0)
+          AddRtcpPacket(*endpoint, endpoints_[1 - i].video_ssrc);
+      }
+      if (time_ms % kPlayoutIntervalMs == 0) {
+        CallEvent* event = AddEvent();
+        event->type = CallEvent::AUDIO_PLAYOUT;
+        event->ssrc = endpoints_[1].audio_ssrc;
+      }
+      if (time_ms % kBweIntervalMs == 0) {
+        CallEvent* event = AddEvent();
+        event->type = CallEvent::BWE_PACKET_LOSS;
+        event->bitrate = prng_.Rand(500000, 2000000);
+        event->fraction_loss = prng_.Rand<uint8_t>() / 16;
+      }
+    }
+    return std::move(events_);
+  }
+
+ private:
+  // Spreads the events over the millisecond they happen in.
+  CallEvent* AddEvent() {
+    time_us_ += prng_.Rand(1, 20);
+    events_.emplace_back();
+    events_.back().time_us = time_us_;
+    return &events_.back();
+  }
+
+  void AddAudioPacket(Endpoint* endpoint) {
+    endpoint->audio_timestamp += 48 * kAudioFrameMs;
+    RtpPacketToSend packet(&extensions_);
+    packet.SetPayloadType(111);
+    packet.SetSequenceNumber(endpoint->audio_sequence_number++);
+    packet.SetTimestamp(endpoint->audio_timestamp);
+    packet.SetSsrc(endpoint->audio_ssrc);
+    packet.SetExtension<AudioLevel>(true, prng_.Rand(20, 80));
+    packet.SetExtension<AbsoluteSendTime>(time_us_ / 1000);
+    packet.SetExtension<TransportSequenceNumber>(
+        endpoint->transport_sequence_number++);
+    AddRtpPacket(endpoint->direction, MediaType::AUDIO, packet,
+                 prng_.Rand(60, 120));
+  }
+
+  void AddVideoPacket(Endpoint* endpoint) {
+    if (endpoint->video_bytes_left == 0)
+      return;
+    const size_t payload_bytes =
+        std::min(endpoint->video_bytes_left, kMaxPayloadBytes);
+    endpoint->video_bytes_left -= payload_bytes;
+    RtpPacketToSend packet(&extensions_);
+    packet.SetPayloadType(100);
+    packet.SetMarker(endpoint->video_bytes_left == 0);
+    packet.SetSequenceNumber(endpoint->video_sequence_number++);
+    packet.SetTimestamp(endpoint->video_timestamp);
+    packet.SetSsrc(endpoint->video_ssrc);
+    packet.SetExtension<TransmissionOffset>(prng_.Rand(0, 900));
+    packet.SetExtension<AbsoluteSendTime>(time_us_ / 1000);
+    packet.SetExtension<TransportSequenceNumber>(
+        endpoint->transport_sequence_number++);
+    packet.SetExtension<VideoOrientation>(kVideoRotation_0);
+    AddRtpPacket(endpoint->direction, MediaType::VIDEO, packet, payload_bytes);
+  }
+
+  void AddRtpPacket(PacketDirection direction,
+                    MediaType media_type,
+                    const RtpPacketToSend& packet,
+                    size_t payload_bytes) {
+    CallEvent* event = AddEvent();
+    event->type = CallEvent::RTP_PACKET;
+    event->direction = direction;
+    event->media_type = media_type;
+    event->packet.SetData(packet.data(), packet.headers_size());
+    event->packet_length = packet.headers_size() + payload_bytes;
+  }
+
+  void AddRtcpPacket(const Endpoint& endpoint, uint32_t remote_ssrc) {
+    rtcp::ReportBlock report_block;
+    report_block.SetMediaSsrc(remote_ssrc);
+    report_block.SetFractionLost(prng_.Rand(5));
+    report_block.SetExtHighestSeqNum(prng_.Rand<uint32_t>());
+    report_block.SetJitter(prng_.Rand(1000));
+    rtcp::SenderReport sender_report;
+    sender_report.SetSenderSsrc(endpoint.video_ssrc);
+    sender_report.SetNtp(NtpTime(prng_.Rand<uint32_t>(),
+                                 prng_.Rand<uint32_t>()));
+    sender_report.SetRtpTimestamp(endpoint.video_timestamp);
+    sender_report.SetPacketCount(prng_.Rand<uint32_t>());
+    sender_report.SetOctetCount(prng_.Rand<uint32_t>());
+    sender_report.AddReportBlock(report_block);
+    CallEvent* event = AddEvent();
+    event->type = CallEvent::RTCP_PACKET;
+    event->direction = endpoint.direction;
+    event->media_type = MediaType::VIDEO;
+    event->packet = sender_report.Build();
+  }
+
+  Random prng_;
+  RtpPacketToSend::ExtensionManager extensions_;
+  std::vector<Endpoint> endpoints_;
+  int64_t time_us_ = 0;
+  std::vector<CallEvent> events_;
+};
+
+// Returns the number of bytes the RTP events of |parsed_log| take when they
+// are logged one by one.
+size_t SizeOfSeparateRtpEvents(const ParsedRtcEventLog& parsed_log) {
+  size_t size = 0;
+  std::vector<uint8_t> header(IP_PACKET_SIZE);
+  for (size_t i = 0; i < parsed_log.GetNumberOfEvents(); ++i) {
+    if (parsed_log.GetEventType(i) != ParsedRtcEventLog::RTP_EVENT)
+      continue;
+    PacketDirection direction;
+    size_t header_length;
+    size_t packet_length;
+    parsed_log.GetRtpHeader(i, &direction, nullptr, header.data(),
+                            &header_length, &packet_length);
+    rtclog::EventStream event_stream;
+    rtclog::Event* event = event_stream.add_stream();
+    event->set_timestamp_us(parsed_log.GetTimestamp(i));
+    event->set_type(rtclog::Event::RTP_EVENT);
+    rtclog::RtpPacket* rtp_packet = event->mutable_rtp_packet();
+    rtp_packet->set_incoming(direction == kIncomingPacket);
+    // All media types take the same space.
+    rtp_packet->set_type(rtclog::VIDEO);
+    rtp_packet->set_packet_length(packet_length);
+    rtp_packet->set_header(header.data(), header_length);
+    size += event_stream.ByteSize();
+  }
+  return size;
+}
+
+}  // namespace
+
+// Logs a call with an audio and a video stream in each direction to file, and
+// reports the space a logged RTP packet takes compared to logging the packets
+// one by one, and the time spent on logging.
+TEST(RtcEventLogPerformanceTest, LogAudioVideoCall) {
+  auto test_info = ::testing::UnitTest::GetInstance()->current_test_info();
+  const std::string temp_filename =
+      test::OutputPath() + test_info->test_case_name() + test_info->name();
+  const std::vector<CallEvent> events = SimulatedCall().Generate(kCallSeconds);
+
+  size_t num_rtp_packets = 0;
+  int64_t log_rtp_header_ns = 0;
+  // Includes the time the logging thread spends.
+  const std::clock_t start_cpu = std::clock();
+  {
+    rtc::ScopedFakeClock clock;
+    std::unique_ptr<RtcEventLog> event_log(RtcEventLog::Create());
+    event_log->StartLogging(temp_filename, 100000000);
+    for (const CallEvent& event : events) {
+      if (event.time_us / 1000000 != rtc::TimeMicros() / 1000000)
+        SleepMs(kPauseMs);
+      clock.AdvanceTimeMicros(event.time_us - rtc::TimeMicros());
+      switch (event.type) {
+        case CallEvent::RTP_PACKET: {
+          int64_t start_ns = rtc::SystemTimeNanos();
+          // Only the header is read, so the payload does not have to be there.
+          event_log->LogRtpHeader(event.direction, event.media_type,
+                                  event.packet.data(), event.packet_length);
+          log_rtp_header_ns += rtc::SystemTimeNanos() - start_ns;
+          ++num_rtp_packets;
+          break;
+        }
+        case CallEvent::RTCP_PACKET:
+          event_log->LogRtcpPacket(event.direction, event.media_type,
+                                   event.packet.data(), event.packet.size());
+          break;
+        case CallEvent::AUDIO_PLAYOUT:
+          event_log->LogAudioPlayout(event.ssrc);
+          break;
+        case CallEvent::BWE_PACKET_LOSS:
+          event_log->LogBwePacketLossEvent(event.bitrate, event.fraction_loss,
+                                           1000);
+          break;
+      }
+    }
+    event_log->StopLogging();
+  }
+  const double cpu_ns = 1e9 * (std::clock() - start_cpu) / CLOCKS_PER_SEC;
+
+  std::ifstream file(temp_filename, std::ios_base::in | std::ios_base::binary);
+  const std::string log((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+  file.close();
+  remove(temp_filename.c_str());
+  ParsedRtcEventLog parsed_log;
+  ASSERT_TRUE(parsed_log.ParseString(log));
+  size_t num_logged_rtp_packets = 0;
+  for (size_t i = 0; i < parsed_log.GetNumberOfEvents(); ++i) {
+    if (parsed_log.GetEventType(i) == ParsedRtcEventLog::RTP_EVENT)
+      ++num_logged_rtp_packets;
+  }
+  // No events may be dropped.
+  ASSERT_EQ(num_rtp_packets, num_logged_rtp_packets);
+  ASSERT_EQ(events.size() + 2, parsed_log.GetNumberOfEvents());
+
+  // The other events take the same space however the packets are logged.
+  rtclog::EventStream event_stream;
+  ASSERT_TRUE(event_stream.ParseFromString(log));
+  size_t other_events_bytes = 0;
+  for (const rtclog::Event& event : event_stream.stream()) {
+    if (event.type() != rtclog::Event::RTP_EVENT &&
+        event.type() != rtclog::Event::RTP_PACKET_BATCH_EVENT) {
+      rtclog::EventStream single_event;
+      *single_event.add_stream() = event;
+      other_events_bytes += single_event.ByteSize();
+    }
+  }
+  const size_t rtp_bytes = log.size() - other_events_bytes;
+  const size_t separate_rtp_bytes = SizeOfSeparateRtpEvents(parsed_log);
+
+  webrtc::test::PrintResult("rtc_event_log_rtp_packet_size", "", "logged",
+                            8 * rtp_bytes / num_rtp_packets, "bits", true);
+  webrtc::test::PrintResult("rtc_event_log_rtp_packet_size", "", "separate",
+                            8 * separate_rtp_bytes / num_rtp_packets, "bits",
+                            false);
+  webrtc::test::PrintResult("rtc_event_log_file_size", "", "logged",
+                            log.size() / 1024, "kB", false);
+  webrtc::test::PrintResult("rtc_event_log_file_size", "", "separate",
+                            (other_events_bytes + separate_rtp_bytes) / 1024,
+                            "kB", false);
+  webrtc::test::PrintResult(
+      "rtc_event_log_log_rtp_header", "", "",
+      static_cast<size_t>(log_rtp_header_ns / num_rtp_packets), "ns", true);
+  webrtc::test::PrintResult(
+      "rtc_event_log_cpu_per_event", "", "",
+      static_cast<size_t>(cpu_ns / events.size()), "ns", true);
+}
+
+}  // namespace webrtc
@@ -417,6 +417,10 @@ TEST(RtcEventLogTest, LogSessionAndReadBack) {
   extensions = (1u << kNumExtensions) - 1;  // Enable all header extensions.
   LogSessionAndReadBack(9, 2, 3, 2, extensions, 2, 2718281828u);
 
+  // Headers with this many CSRCs are too long to be batched, and are logged
+  // as separate events.
+  LogSessionAndReadBack(9, 2, 3, 2, extensions, 13, 1618033988u);
+
   // Try all combinations of header extensions and up to 2 CSRCS.
   for (extensions = 0; extensions < (1u << kNumExtensions); extensions++) {
     for (uint32_t csrcs_count = 0; csrcs_count < 3; csrcs_count++) {
@@ -488,6 +492,52 @@ TEST(RtcEventLogTest, LogEventAndReadBack) {
   remove(temp_filename.c_str());
 }
 
+// Other events are counted in the RTP batch of the file they are logged to.
+// They must not be counted again in the next file when no RTP was logged.
+TEST(RtcEventLogTest, LogOnlyRtcpThenRtpInNextFile) {
+  Random prng(987654321);
+  size_t packet_size = prng.Rand(1000, 1100);
+  RtpPacketToSend rtp_packet =
+      GenerateRtpPacket(nullptr, 0, packet_size, &prng);
+  rtc::Buffer rtcp_packet = GenerateRtcpPacket(&prng);
+
+  auto test_info = ::testing::UnitTest::GetInstance()->current_test_info();
+  const std::string temp_filename =
+      test::OutputPath() + test_info->test_case_name() + test_info->name();
+
+  rtc::ScopedFakeClock fake_clock;
+  fake_clock.SetTimeMicros(prng.Rand<uint32_t>());
+  std::unique_ptr<RtcEventLog> log_dumper(RtcEventLog::Create());
+
+  log_dumper->StartLogging(temp_filename, 10000000);
+  for (int i = 0; i < 2; ++i) {
+    fake_clock.AdvanceTimeMicros(prng.Rand(1, 1000));
+    log_dumper->LogRtcpPacket(kOutgoingPacket, MediaType::VIDEO,
+                              rtcp_packet.data(), rtcp_packet.size());
+  }
+  fake_clock.AdvanceTimeMicros(prng.Rand(1, 1000));
+  log_dumper->StopLogging();
+
+  fake_clock.AdvanceTimeMicros(prng.Rand(1, 1000));
+  log_dumper->StartLogging(temp_filename, 10000000);
+  fake_clock.AdvanceTimeMicros(prng.Rand(1, 1000));
+  log_dumper->LogRtpHeader(kIncomingPacket, MediaType::VIDEO, rtp_packet.data(),
+                           rtp_packet.size());
+  fake_clock.AdvanceTimeMicros(prng.Rand(1, 1000));
+  log_dumper->StopLogging();
+
+  ParsedRtcEventLog parsed_log;
+  ASSERT_TRUE(parsed_log.ParseFile(temp_filename));
+  EXPECT_EQ(3u, parsed_log.GetNumberOfEvents());
+  RtcEventLogTestHelper::VerifyLogStartEvent(parsed_log, 0);
+  RtcEventLogTestHelper::VerifyRtpEvent(
+      parsed_log, 1, kIncomingPacket, MediaType::VIDEO, rtp_packet.data(),
+      rtp_packet.headers_size(), rtp_packet.size());
+  RtcEventLogTestHelper::VerifyLogEndEvent(parsed_log, 2);
+
+  remove(temp_filename.c_str());
+}
+
 class ConfigReadWriteTest {
  public:
   ConfigReadWriteTest() : prng(987654321) {}
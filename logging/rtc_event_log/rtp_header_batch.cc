@@ -0,0 +1,325 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/logging/rtc_event_log/rtp_header_batch.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "webrtc/base/checks.h"
+
+namespace webrtc {
+
+namespace {
+const size_t kFixedHeaderSize = 12;
+const size_t kBytesPerMask = 8;
+
+uint16_t ReadSequenceNumber(const uint8_t* header) {
+  return (header[2] << 8) | header[3];
+}
+
+void WriteSequenceNumber(uint16_t sequence_number, uint8_t* header) {
+  header[2] = static_cast<uint8_t>(sequence_number >> 8);
+  header[3] = static_cast<uint8_t>(sequence_number);
+}
+
+uint32_t ReadUint32(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) |
+         (data[2] << 8) | data[3];
+}
+
+void WriteUint32(uint32_t value, uint8_t* data) {
+  data[0] = static_cast<uint8_t>(value >> 24);
+  data[1] = static_cast<uint8_t>(value >> 16);
+  data[2] = static_cast<uint8_t>(value >> 8);
+  data[3] = static_cast<uint8_t>(value);
+}
+
+class BatchReader {
+ public:
+  explicit BatchReader(const std::string& data)
+      : data_(reinterpret_cast<const uint8_t*>(data.data())),
+        remaining_(data.size()) {}
+
+  bool ReadByte(uint8_t* value) {
+    if (remaining_ == 0)
+      return false;
+    *value = *data_++;
+    --remaining_;
+    return true;
+  }
+
+  bool ReadBytes(size_t length, uint8_t* bytes) {
+    if (remaining_ < length)
+      return false;
+    memcpy(bytes, data_, length);
+    data_ += length;
+    remaining_ -= length;
+    return true;
+  }
+
+  bool ReadVarInt(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+      if (!ReadByte(&byte))
+        return false;
+      *value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool ReadSignedVarInt(int64_t* value) {
+    uint64_t zigzag;
+    if (!ReadVarInt(&zigzag))
+      return false;
+    *value = static_cast<int64_t>(zigzag >> 1) ^
+             -static_cast<int64_t>(zigzag & 1);
+    return true;
+  }
+
+  bool ReadHeaderLength(size_t* header_length) {
+    uint64_t length;
+    if (!ReadVarInt(&length) || length < kFixedHeaderSize ||
+        length > RtpHeaderBatchEncoder::kMaxHeaderSize) {
+      return false;
+    }
+    *header_length = static_cast<size_t>(length);
+    return true;
+  }
+
+  bool empty() const { return remaining_ == 0; }
+
+ private:
+  const uint8_t* data_;
+  size_t remaining_;
+};
+}  // namespace
+
+const size_t RtpHeaderBatchEncoder::kMaxHeaderSize;
+const size_t RtpHeaderBatchEncoder::kMaxEncodedPacketSize;
+
+RtpHeaderBatchEncoder::RtpHeaderBatchEncoder() {}
+
+RtpHeaderBatchEncoder::~RtpHeaderBatchEncoder() {}
+
+void RtpHeaderBatchEncoder::AddRtpHeader(int64_t timestamp_us,
+                                         bool incoming,
+                                         uint8_t media_type,
+                                         const uint8_t* header,
+                                         size_t header_length,
+                                         size_t packet_length) {
+  RTC_DCHECK_GE(header_length, kFixedHeaderSize);
+  RTC_DCHECK_LE(header_length, kMaxHeaderSize);
+  RTC_DCHECK_EQ(0, media_type & ~(kRtpBatchMediaTypeMask >>
+                                  kRtpBatchMediaTypeShift));
+  if (num_packets_ == 0) {
+    first_timestamp_us_ = timestamp_us;
+    last_timestamp_us_ = timestamp_us;
+  }
+  uint8_t flags = media_type << kRtpBatchMediaTypeShift;
+  if (incoming)
+    flags |= kRtpBatchIncoming;
+
+  const uint32_t ssrc = ReadUint32(&header[8]);
+  size_t index = 0;
+  while (index < streams_.size() &&
+         (streams_[index].ssrc != ssrc ||
+          streams_[index].incoming != incoming)) {
+    ++index;
+  }
+
+  const size_t flags_offset = data_.size();
+  data_.push_back(flags);
+  WriteVarInt(num_other_events_ - last_position_);
+  WriteSignedVarInt(timestamp_us - last_timestamp_us_);
+  last_position_ = num_other_events_;
+  last_timestamp_us_ = timestamp_us;
+  ++num_packets_;
+
+  if (index == streams_.size()) {
+    data_[flags_offset] |= kRtpBatchNewStream;
+    WriteVarInt(header_length);
+    data_.append(reinterpret_cast<const char*>(header), header_length);
+    WriteVarInt(packet_length);
+
+    streams_.resize(streams_.size() + 1);
+    Stream* stream = &streams_.back();
+    stream->ssrc = ssrc;
+    stream->incoming = incoming;
+    stream->header_length = header_length;
+    memcpy(stream->header, header, header_length);
+    stream->packet_length = packet_length;
+    return;
+  }
+
+  Stream* stream = &streams_[index];
+  WriteVarInt(index);
+  if (header[0] != stream->header[0] || header[1] != stream->header[1]) {
+    data_[flags_offset] |= kRtpBatchFirstBytesChanged;
+    data_.append(reinterpret_cast<const char*>(header), 2);
+  }
+  WriteSignedVarInt(static_cast<int16_t>(ReadSequenceNumber(header) -
+                                         ReadSequenceNumber(stream->header)));
+  WriteSignedVarInt(static_cast<int32_t>(ReadUint32(&header[4]) -
+                                         ReadUint32(&stream->header[4])));
+  if (header_length != stream->header_length) {
+    data_[flags_offset] |= kRtpBatchHeaderLengthChanged;
+    WriteVarInt(header_length);
+    data_.append(reinterpret_cast<const char*>(&header[kFixedHeaderSize]),
+                 header_length - kFixedHeaderSize);
+  } else {
+    for (size_t i = kFixedHeaderSize; i < header_length; i += kBytesPerMask) {
+      const size_t end = std::min(i + kBytesPerMask, header_length);
+      const size_t mask_offset = data_.size();
+      uint8_t mask = 0;
+      data_.push_back(0);
+      for (size_t j = i; j < end; ++j) {
+        if (header[j] != stream->header[j]) {
+          mask |= 1 << (j - i);
+          data_.push_back(header[j]);
+        }
+      }
+      data_[mask_offset] = mask;
+    }
+  }
+  WriteSignedVarInt(static_cast<int64_t>(packet_length) -
+                    static_cast<int64_t>(stream->packet_length));
+
+  stream->header_length = header_length;
+  memcpy(stream->header, header, header_length);
+  stream->packet_length = packet_length;
+}
+
+void RtpHeaderBatchEncoder::Clear() {
+  data_.clear();
+  streams_.clear();
+  num_packets_ = 0;
+  num_other_events_ = 0;
+  last_position_ = 0;
+  first_timestamp_us_ = 0;
+  last_timestamp_us_ = 0;
+}
+
+void RtpHeaderBatchEncoder::WriteVarInt(uint64_t value) {
+  while (value >= 0x80) {
+    data_.push_back(static_cast<char>(0x80 | (value & 0x7F)));
+    value >>= 7;
+  }
+  data_.push_back(static_cast<char>(value));
+}
+
+void RtpHeaderBatchEncoder::WriteSignedVarInt(int64_t value) {
+  WriteVarInt((static_cast<uint64_t>(value) << 1) ^
+              static_cast<uint64_t>(value >> 63));
+}
+
+bool RtpHeaderBatchDecoder::Decode(const std::string& data,
+                                   size_t num_packets,
+                                   int64_t first_timestamp_us,
+                                   std::vector<Packet>* packets) {
+  BatchReader reader(data);
+  // The last packet of every stream.
+  std::vector<size_t> streams;
+  size_t position = 0;
+  int64_t timestamp_us = first_timestamp_us;
+  const size_t first_packet = packets->size();
+  for (size_t n = 0; n < num_packets; ++n) {
+    uint8_t flags;
+    uint64_t position_delta;
+    int64_t timestamp_delta;
+    if (!reader.ReadByte(&flags) || !reader.ReadVarInt(&position_delta) ||
+        !reader.ReadSignedVarInt(&timestamp_delta)) {
+      return false;
+    }
+    position += position_delta;
+    timestamp_us += timestamp_delta;
+
+    packets->resize(packets->size() + 1);
+    Packet* packet = &packets->back();
+    packet->position = position;
+    packet->timestamp_us = timestamp_us;
+    packet->incoming = (flags & kRtpBatchIncoming) != 0;
+    packet->media_type =
+        (flags & kRtpBatchMediaTypeMask) >> kRtpBatchMediaTypeShift;
+
+    if (flags & kRtpBatchNewStream) {
+      size_t header_length;
+      uint64_t packet_length;
+      if (!reader.ReadHeaderLength(&header_length))
+        return false;
+      packet->header.resize(header_length);
+      if (!reader.ReadBytes(header_length, packet->header.data()) ||
+          !reader.ReadVarInt(&packet_length)) {
+        return false;
+      }
+      packet->packet_length = static_cast<size_t>(packet_length);
+      streams.push_back(packets->size() - 1);
+      continue;
+    }
+
+    uint64_t index;
+    if (!reader.ReadVarInt(&index) || index >= streams.size())
+      return false;
+    const Packet& previous = (*packets)[streams[index]];
+    streams[index] = packets->size() - 1;
+    packet->header = previous.header;
+    uint8_t* header = packet->header.data();
+    if ((flags & kRtpBatchFirstBytesChanged) && !reader.ReadBytes(2, header))
+      return false;
+    int64_t sequence_number_delta;
+    int64_t timestamp_rtp_delta;
+    if (!reader.ReadSignedVarInt(&sequence_number_delta) ||
+        !reader.ReadSignedVarInt(&timestamp_rtp_delta)) {
+      return false;
+    }
+    WriteSequenceNumber(static_cast<uint16_t>(ReadSequenceNumber(header) +
+                                              sequence_number_delta),
+                        header);
+    WriteUint32(static_cast<uint32_t>(ReadUint32(&header[4]) +
+                                      timestamp_rtp_delta),
+                &header[4]);
+    if (flags & kRtpBatchHeaderLengthChanged) {
+      size_t header_length;
+      if (!reader.ReadHeaderLength(&header_length))
+        return false;
+      packet->header.resize(header_length);
+      header = packet->header.data();
+      if (!reader.ReadBytes(header_length - kFixedHeaderSize,
+                            &header[kFixedHeaderSize])) {
+        return false;
+      }
+    } else {
+      const size_t header_length = packet->header.size();
+      for (size_t i = kFixedHeaderSize; i < header_length; i += kBytesPerMask) {
+        const size_t end = std::min(i + kBytesPerMask, header_length);
+        uint8_t mask;
+        if (!reader.ReadByte(&mask) || (mask >> (end - i)) != 0)
+          return false;
+        for (size_t j = i; j < end; ++j) {
+          if ((mask & (1 << (j - i))) && !reader.ReadByte(&header[j]))
+            return false;
+        }
+      }
+    }
+    int64_t packet_length_delta;
+    if (!reader.ReadSignedVarInt(&packet_length_delta))
+      return false;
+    packet->packet_length =
+        static_cast<size_t>(previous.packet_length + packet_length_delta);
+  }
+  RTC_DCHECK_EQ(first_packet + num_packets, packets->size());
+  return reader.empty();
+}
+
+}  // namespace webrtc
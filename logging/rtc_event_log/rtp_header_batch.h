@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_LOGGING_RTC_EVENT_LOG_RTP_HEADER_BATCH_H_
+#define WEBRTC_LOGGING_RTC_EVENT_LOG_RTP_HEADER_BATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+
+namespace webrtc {
+
+// The RTP headers of a run of logged events, delta encoded against the
+// previous header of the same stream. A batch is written to the log right
+// after the other events of the run, and records how many of those each
+// packet follows, so that the order of the events can be restored.
+//
+// Each packet is encoded as
+//   flags                   1 byte, see kRtpBatch* below.
+//   position delta          varint, other events since the previous packet.
+//   arrival time delta      signed varint, us since the previous packet.
+// followed, for the first packet of a stream, by
+//   header length           varint.
+//   header                  raw bytes.
+//   packet length           varint.
+// and for later packets of a stream, by
+//   stream index            varint, in order of the streams' first packets.
+//   first two header bytes  2 raw bytes, if kRtpBatchFirstBytesChanged.
+//   sequence number delta   signed varint.
+//   RTP timestamp delta     signed varint.
+//   rest of the header      if kRtpBatchHeaderLengthChanged, the header
+//                           length as a varint and the bytes after the fixed
+//                           header raw. Otherwise, for every 8 bytes after the
+//                           fixed header, a mask of the bytes that changed
+//                           followed by the new values of those bytes.
+//   packet length delta     signed varint.
+// Signed varints are zigzag encoded.
+const uint8_t kRtpBatchIncoming = 0x01;
+const uint8_t kRtpBatchMediaTypeMask = 0x06;
+const int kRtpBatchMediaTypeShift = 1;
+const uint8_t kRtpBatchNewStream = 0x08;
+const uint8_t kRtpBatchFirstBytesChanged = 0x10;
+const uint8_t kRtpBatchHeaderLengthChanged = 0x20;
+
+class RtpHeaderBatchEncoder {
+ public:
+  // Headers longer than this are logged as separate events. Most headers,
+  // including their extensions, take less than half of it.
+  static const size_t kMaxHeaderSize = 64;
+  // Upper bound of the bytes a packet adds to the batch.
+  static const size_t kMaxEncodedPacketSize = kMaxHeaderSize + 64;
+
+  RtpHeaderBatchEncoder();
+  ~RtpHeaderBatchEncoder();
+
+  // Counts an event that is logged among the packets of the batch.
+  void AddOtherEvent() { ++num_other_events_; }
+
+  // Appends the RTP header of a packet. |media_type| must fit in two bits.
+  void AddRtpHeader(int64_t timestamp_us,
+                    bool incoming,
+                    uint8_t media_type,
+                    const uint8_t* header,
+                    size_t header_length,
+                    size_t packet_length);
+
+  // Empties the batch. The memory is kept for the next batch.
+  void Clear();
+
+  size_t num_packets() const { return num_packets_; }
+  size_t num_other_events() const { return num_other_events_; }
+  int64_t first_timestamp_us() const { return first_timestamp_us_; }
+  const std::string& data() const { return data_; }
+
+ private:
+  struct Stream {
+    uint32_t ssrc;
+    bool incoming;
+    size_t header_length;
+    uint8_t header[kMaxHeaderSize];
+    size_t packet_length;
+  };
+
+  void WriteVarInt(uint64_t value);
+  void WriteSignedVarInt(int64_t value);
+
+  std::string data_;
+  std::vector<Stream> streams_;
+  size_t num_packets_ = 0;
+  size_t num_other_events_ = 0;
+  size_t last_position_ = 0;
+  int64_t first_timestamp_us_ = 0;
+  int64_t last_timestamp_us_ = 0;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RtpHeaderBatchEncoder);
+};
+
+class RtpHeaderBatchDecoder {
+ public:
+  struct Packet {
+    // The number of the batch's other events that come before the packet.
+    size_t position;
+    int64_t timestamp_us;
+    bool incoming;
+    uint8_t media_type;
+    std::vector<uint8_t> header;
+    size_t packet_length;
+  };
+
+  // Decodes |num_packets| packets from |data|, a batch whose first packet
+  // arrived at |first_timestamp_us|. Returns false if the batch is malformed.
+  static bool Decode(const std::string& data,
+                     size_t num_packets,
+                     int64_t first_timestamp_us,
+                     std::vector<Packet>* packets);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_LOGGING_RTC_EVENT_LOG_RTP_HEADER_BATCH_H_
@@ -0,0 +1,181 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include "webrtc/base/random.h"
+#include "webrtc/logging/rtc_event_log/rtp_header_batch.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+
+struct LoggedPacket {
+  size_t position;
+  int64_t timestamp_us;
+  bool incoming;
+  uint8_t media_type;
+  std::vector<uint8_t> header;
+  size_t packet_length;
+};
+
+// Builds an RTP header with a one-byte header extension of |extension_words|
+// 32-bit words, filled with |extension_byte|.
+std::vector<uint8_t> BuildHeader(uint32_t ssrc,
+                                 uint16_t sequence_number,
+                                 uint32_t timestamp,
+                                 uint8_t payload_type,
+                                 size_t extension_words,
+                                 uint8_t extension_byte) {
+  std::vector<uint8_t> header(12);
+  header[0] = 0x80;
+  header[1] = payload_type;
+  header[2] = sequence_number >> 8;
+  header[3] = sequence_number;
+  header[4] = timestamp >> 24;
+  header[5] = timestamp >> 16;
+  header[6] = timestamp >> 8;
+  header[7] = timestamp;
+  header[8] = ssrc >> 24;
+  header[9] = ssrc >> 16;
+  header[10] = ssrc >> 8;
+  header[11] = ssrc;
+  if (extension_words > 0) {
+    header[0] |= 0x10;
+    header.push_back(0xBE);
+    header.push_back(0xDE);
+    header.push_back(extension_words >> 8);
+    header.push_back(extension_words);
+    header.resize(header.size() + 4 * extension_words, extension_byte);
+  }
+  return header;
+}
+
+void EncodeAndVerify(const std::vector<LoggedPacket>& logged_packets,
+                     RtpHeaderBatchEncoder* encoder) {
+  size_t other_events = 0;
+  for (const LoggedPacket& logged : logged_packets) {
+    for (; other_events < logged.position; ++other_events)
+      encoder->AddOtherEvent();
+    encoder->AddRtpHeader(logged.timestamp_us, logged.incoming,
+                          logged.media_type, logged.header.data(),
+                          logged.header.size(), logged.packet_length);
+  }
+  EXPECT_EQ(logged_packets.size(), encoder->num_packets());
+  EXPECT_EQ(other_events, encoder->num_other_events());
+  EXPECT_EQ(logged_packets[0].timestamp_us, encoder->first_timestamp_us());
+
+  std::vector<RtpHeaderBatchDecoder::Packet> packets;
+  ASSERT_TRUE(RtpHeaderBatchDecoder::Decode(
+      encoder->data(), encoder->num_packets(), encoder->first_timestamp_us(),
+      &packets));
+  ASSERT_EQ(logged_packets.size(), packets.size());
+  for (size_t i = 0; i < packets.size(); ++i) {
+    EXPECT_EQ(logged_packets[i].position, packets[i].position);
+    EXPECT_EQ(logged_packets[i].timestamp_us, packets[i].timestamp_us);
+    EXPECT_EQ(logged_packets[i].incoming, packets[i].incoming);
+    EXPECT_EQ(logged_packets[i].media_type, packets[i].media_type);
+    EXPECT_EQ(logged_packets[i].header, packets[i].header);
+    EXPECT_EQ(logged_packets[i].packet_length, packets[i].packet_length);
+  }
+}
+
+}  // namespace
+
+TEST(RtpHeaderBatchTest, EncodesAndDecodesStreams) {
+  Random prng(1234);
+  std::vector<LoggedPacket> logged_packets;
+  const uint32_t kSsrcs[] = {0x12345678, 0x9abcdef0, 0x12345678};
+  const bool kIncoming[] = {false, false, true};
+  uint16_t sequence_numbers[] = {65500, 1, 65535};
+  uint32_t timestamps[] = {0xfffff000, 100, 0};
+  size_t position = 0;
+  int64_t timestamp_us = 1000000;
+  for (int i = 0; i < 300; ++i) {
+    const int stream = prng.Rand(2);
+    sequence_numbers[stream] += prng.Rand(-3, 5);
+    timestamps[stream] += prng.Rand(-3000, 3000);
+    position += prng.Rand(2);
+    timestamp_us += prng.Rand(0, 20000) - 100;
+
+    LoggedPacket logged;
+    logged.position = position;
+    logged.timestamp_us = timestamp_us;
+    logged.incoming = kIncoming[stream];
+    logged.media_type = prng.Rand(3);
+    // Change the marker bit and the extensions now and then, and the length
+    // of the extensions more seldom.
+    logged.header = BuildHeader(kSsrcs[stream], sequence_numbers[stream],
+                                timestamps[stream], 96 + prng.Rand(1) * 128,
+                                prng.Rand(40) == 0 ? 1 : 3, prng.Rand(3));
+    logged.packet_length = logged.header.size() + prng.Rand(0, 1200);
+    logged_packets.push_back(logged);
+  }
+
+  RtpHeaderBatchEncoder encoder;
+  EncodeAndVerify(logged_packets, &encoder);
+}
+
+TEST(RtpHeaderBatchTest, ClearStartsNewBatch) {
+  std::vector<LoggedPacket> logged_packets(2);
+  logged_packets[0] = {0, 5000, false, 1, BuildHeader(1, 10, 1000, 111, 1, 7),
+                       100};
+  logged_packets[1] = {2, 25000, false, 1, BuildHeader(1, 11, 1960, 111, 1, 8),
+                       90};
+  RtpHeaderBatchEncoder encoder;
+  EncodeAndVerify(logged_packets, &encoder);
+
+  encoder.Clear();
+  EXPECT_EQ(0u, encoder.num_packets());
+  EXPECT_EQ(0u, encoder.num_other_events());
+  EXPECT_TRUE(encoder.data().empty());
+  // The stream is encoded from scratch in the new batch.
+  logged_packets.erase(logged_packets.begin());
+  logged_packets[0].position = 0;
+  EncodeAndVerify(logged_packets, &encoder);
+}
+
+TEST(RtpHeaderBatchTest, EncodesConsecutivePacketsCompactly) {
+  RtpHeaderBatchEncoder encoder;
+  for (int i = 0; i < 100; ++i) {
+    std::vector<uint8_t> header =
+        BuildHeader(1, 1000 + i, 160 * i, 111, 1, static_cast<uint8_t>(i));
+    encoder.AddRtpHeader(20000 * i, false, 1, header.data(), header.size(),
+                         header.size() + 60);
+  }
+  // Besides the 4 extension bytes that change, a packet takes 11 bytes.
+  EXPECT_GE(25u + 99 * 15, encoder.data().size());
+}
+
+TEST(RtpHeaderBatchTest, RejectsMalformedBatch) {
+  RtpHeaderBatchEncoder encoder;
+  for (int i = 0; i < 10; ++i) {
+    std::vector<uint8_t> header = BuildHeader(1, i, 90 * i, 100, 1, i);
+    encoder.AddRtpHeader(i, true, 2, header.data(), header.size(), 200);
+  }
+  std::vector<RtpHeaderBatchDecoder::Packet> packets;
+  for (size_t length = 0; length < encoder.data().size(); ++length) {
+    EXPECT_FALSE(RtpHeaderBatchDecoder::Decode(encoder.data().substr(0, length),
+                                               encoder.num_packets(), 0,
+                                               &packets));
+  }
+  EXPECT_FALSE(RtpHeaderBatchDecoder::Decode(encoder.data() + '\0',
+                                             encoder.num_packets(), 0,
+                                             &packets));
+  // Without the flag, the first packet refers to a stream the batch lacks.
+  std::string data = encoder.data();
+  data[0] &= ~kRtpBatchNewStream;
+  EXPECT_FALSE(RtpHeaderBatchDecoder::Decode(data, encoder.num_packets(), 0,
+                                             &packets));
+}
+
+}  // namespace webrtc
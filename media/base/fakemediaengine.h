@@ -220,6 +220,14 @@ template <class Base> class RtpHelper : public Base {
   void set_num_network_route_changes(int changes) {
     num_network_route_changes_ = changes;
   }
+  void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key) override {
+    Base::SetMediaCryptoKey(key);
+    media_crypto_keys_.push_back(key);
+  }
+  // Every key set so far, in order.
+  const std::vector<webrtc::MediaCryptoKey>& media_crypto_keys() const {
+    return media_crypto_keys_;
+  }
 
  protected:
   bool MuteStream(uint32_t ssrc, bool mute) {
@@ -289,6 +297,7 @@ template <class Base> class RtpHelper : public Base {
   int transport_overhead_per_packet_;
   rtc::NetworkRoute last_network_route_;
   int num_network_route_changes_ = 0;
+  std::vector<webrtc::MediaCryptoKey> media_crypto_keys_;
 };
 
 class FakeVoiceMediaChannel : public RtpHelper<VoiceMediaChannel> {
@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "webrtc/api/rtpparameters.h"
+#include "webrtc/base/array_view.h"
 #include "webrtc/base/basictypes.h"
 #include "webrtc/base/buffer.h"
 #include "webrtc/base/copyonwritebuffer.h"
@@ -423,6 +424,24 @@ class MediaChannel : public sigslot::has_slots<> {
   // Called when a RTCP packet is received.
   virtual void OnRtcpReceived(rtc::CopyOnWriteBuffer* packet,
                               const rtc::PacketTime& packet_time) = 0;
+
+  struct ReceivedPacket {
+    bool rtcp;
+    rtc::CopyOnWriteBuffer packet;
+    rtc::PacketTime packet_time;
+  };
+  // Called with RTP and RTCP packets received back to back, in order. By
+  // default they are handed one at a time to OnPacketReceived and
+  // OnRtcpReceived.
+  virtual void OnPacketsReceived(rtc::ArrayView<ReceivedPacket> packets) {
+    for (ReceivedPacket& packet : packets) {
+      if (packet.rtcp) {
+        OnRtcpReceived(&packet.packet, packet.packet_time);
+      } else {
+        OnPacketReceived(&packet.packet, packet.packet_time);
+      }
+    }
+  }
   // Called when the socket's ability to send has changed.
   virtual void OnReadyToSend(bool ready) = 0;
   // Called when the network route used for sending packets changed.
@@ -473,9 +492,18 @@ class MediaChannel : public sigslot::has_slots<> {
     return network_interface_->SetOption(type, opt, option);
   }
   
-  void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key) {
+  // May be called again on a live channel to rotate the key, implementations
+  // then forward it to their existing streams. Receive only keys are kept
+  // apart until the same key is set for sending.
+  virtual void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key) {
+    if (key.receive_only) {
+      media_crypto_next_key_ = key;
+      return;
+    }
     media_crypto_enabled_ = true;	  
     media_crypto_key_ = key;
+    if (media_crypto_next_key_.buffer == key.buffer)
+      media_crypto_next_key_ = webrtc::MediaCryptoKey();
   }
   
  protected:
@@ -485,6 +513,10 @@ class MediaChannel : public sigslot::has_slots<> {
   const webrtc::MediaCryptoKey& media_crypto_key() const {
     return media_crypto_key_;
   }
+  // Empty unless a receive only key is waiting to be switched to.
+  const webrtc::MediaCryptoKey& media_crypto_next_key() const {
+    return media_crypto_next_key_;
+  }
   
  private:
   // This method sets DSCP |value| on both RTP and RTCP channels.
@@ -522,6 +554,7 @@ class MediaChannel : public sigslot::has_slots<> {
   // End to end meia encription
   bool media_crypto_enabled_;
   webrtc::MediaCryptoKey media_crypto_key_;
+  webrtc::MediaCryptoKey media_crypto_next_key_;
 };
 
 // The stats information is structured as follows:
@@ -201,6 +201,11 @@ void FakeVideoSendStream::EnableEncodedFrameRecording(
     rtc::ClosePlatformFile(file);
 }
 
+void FakeVideoSendStream::SetMediaCryptoKey(
+    const webrtc::MediaCryptoKey& key) {
+  config_.media_crypto_key = key;
+}
+
 void FakeVideoSendStream::ReconfigureVideoEncoder(
     webrtc::VideoEncoderConfig config) {
   int width, height;
@@ -286,6 +291,14 @@ webrtc::VideoReceiveStream::Stats FakeVideoReceiveStream::GetStats() const {
   return stats_;
 }
 
+void FakeVideoReceiveStream::SetMediaCryptoKey(
+    const webrtc::MediaCryptoKey& key) {
+  if (key.receive_only)
+    config_.media_crypto_next_key = key;
+  else
+    config_.media_crypto_key = key;
+}
+
 void FakeVideoReceiveStream::Start() {
   receiving_ = true;
 }
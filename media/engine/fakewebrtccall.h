@@ -151,6 +151,7 @@ class FakeVideoSendStream final
                      degradation_preference) override;
   webrtc::VideoSendStream::Stats GetStats() override;
   void ReconfigureVideoEncoder(webrtc::VideoEncoderConfig config) override;
+  void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key) override;
 
   bool sending_;
   webrtc::VideoSendStream::Config config_;
@@ -192,6 +193,7 @@ class FakeVideoReceiveStream final : public webrtc::VideoReceiveStream {
   void Stop() override;
 
   webrtc::VideoReceiveStream::Stats GetStats() const override;
+  void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key) override;
 
   webrtc::VideoReceiveStream::Config config_;
   bool receiving_;
@@ -1257,6 +1257,7 @@ void WebRtcVideoChannel2::ConfigureReceiverRtp(
   if (media_crypto_enabled()) {
     config->media_crypto_enabled = true;
     config->media_crypto_key = media_crypto_key();
+    config->media_crypto_next_key = media_crypto_next_key();
   }
 }
 
@@ -1459,6 +1460,31 @@ void WebRtcVideoChannel2::OnRtcpReceived(
       webrtc_packet_time);
 }
 
+void WebRtcVideoChannel2::OnPacketsReceived(
+    rtc::ArrayView<ReceivedPacket> packets) {
+  delivered_packets_.clear();
+  for (const ReceivedPacket& packet : packets) {
+    delivered_packets_.push_back(
+        {packet.packet.cdata(), packet.packet.size(),
+         webrtc::PacketTime(packet.packet_time.timestamp,
+                            packet.packet_time.not_before),
+         &packet.packet});
+  }
+  delivery_statuses_.resize(packets.size());
+  call_->Receiver()->DeliverPackets(webrtc::MediaType::VIDEO,
+                                    delivered_packets_,
+                                    delivery_statuses_.data());
+  // Packets of unknown SSRCs take the slow path, which may create a default
+  // receive stream. Once created, the remaining packets of its SSRC are
+  // delivered by OnPacketReceived's first DeliverPacket.
+  for (size_t i = 0; i < packets.size(); ++i) {
+    if (!packets[i].rtcp &&
+        delivery_statuses_[i] == webrtc::PacketReceiver::DELIVERY_UNKNOWN_SSRC) {
+      OnPacketReceived(&packets[i].packet, packets[i].packet_time);
+    }
+  }
+}
+
 void WebRtcVideoChannel2::OnReadyToSend(bool ready) {
   LOG(LS_VERBOSE) << "OnReadyToSend: " << (ready ? "Ready." : "Not ready.");
   call_->SignalChannelNetworkState(
@@ -1494,6 +1520,18 @@ void WebRtcVideoChannel2::SetInterface(NetworkInterface* iface) {
                           kVideoRtpBufferSize);
 }
 
+void WebRtcVideoChannel2::SetMediaCryptoKey(
+    const webrtc::MediaCryptoKey& key) {
+  MediaChannel::SetMediaCryptoKey(key);
+  // Existing streams rotate to the new key without being recreated, so the
+  // decoders keep their state.
+  rtc::CritScope stream_lock(&stream_crit_);
+  for (auto& kv : send_streams_)
+    kv.second->SetMediaCryptoKey(key);
+  for (auto& kv : receive_streams_)
+    kv.second->SetMediaCryptoKey(key);
+}
+
 bool WebRtcVideoChannel2::SendRtp(const uint8_t* data,
                                   size_t len,
                                   const webrtc::PacketOptions& options) {
@@ -1763,6 +1801,16 @@ void WebRtcVideoChannel2::WebRtcVideoSendStream::SetCodec(
   }
 }
 
+void WebRtcVideoChannel2::WebRtcVideoSendStream::SetMediaCryptoKey(
+    const webrtc::MediaCryptoKey& key) {
+  RTC_DCHECK_RUN_ON(&thread_checker_);
+  if (!parameters_.config.media_crypto_enabled || key.receive_only)
+    return;
+  parameters_.config.media_crypto_key = key;
+  if (stream_)
+    stream_->SetMediaCryptoKey(key);
+}
+
 void WebRtcVideoChannel2::WebRtcVideoSendStream::SetSendParameters(
     const ChangedSendParameters& params) {
   RTC_DCHECK_RUN_ON(&thread_checker_);
@@ -2223,6 +2271,21 @@ void WebRtcVideoChannel2::WebRtcVideoReceiveStream::ConfigureCodecs(
       HasNack(recv_codecs.begin()->codec) ? kNackHistoryMs : 0;
 }
 
+void WebRtcVideoChannel2::WebRtcVideoReceiveStream::SetMediaCryptoKey(
+    const webrtc::MediaCryptoKey& key) {
+  if (!config_.media_crypto_enabled)
+    return;
+  // Kept in the config so that a recreated stream accepts both keys.
+  if (key.receive_only) {
+    config_.media_crypto_next_key = key;
+  } else {
+    config_.media_crypto_key = key;
+    if (config_.media_crypto_next_key.buffer == key.buffer)
+      config_.media_crypto_next_key = webrtc::MediaCryptoKey();
+  }
+  stream_->SetMediaCryptoKey(key);
+}
+
 void WebRtcVideoChannel2::WebRtcVideoReceiveStream::SetLocalSsrc(
     uint32_t local_ssrc) {
   // TODO(pbos): Consider turning this sanity check into a RTC_DCHECK. You
@@ -165,11 +165,13 @@ class WebRtcVideoChannel2 : public VideoMediaChannel, public webrtc::Transport {
                         const rtc::PacketTime& packet_time) override;
   void OnRtcpReceived(rtc::CopyOnWriteBuffer* packet,
                       const rtc::PacketTime& packet_time) override;
+  void OnPacketsReceived(rtc::ArrayView<ReceivedPacket> packets) override;
   void OnReadyToSend(bool ready) override;
   void OnNetworkRouteChanged(const std::string& transport_name,
                              const rtc::NetworkRoute& network_route) override;
   void OnTransportOverheadChanged(int transport_overhead_per_packet) override;
   void SetInterface(NetworkInterface* iface) override;
+  void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key) override;
 
   // Implemented for VideoMediaChannelTest.
   bool sending() const { return sending_; }
@@ -251,6 +253,7 @@ class WebRtcVideoChannel2 : public VideoMediaChannel, public webrtc::Transport {
     virtual ~WebRtcVideoSendStream();
 
     void SetSendParameters(const ChangedSendParameters& send_params);
+    void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key);
     bool SetRtpParameters(const webrtc::RtpParameters& parameters);
     webrtc::RtpParameters GetRtpParameters() const;
 
@@ -376,6 +379,7 @@ class WebRtcVideoChannel2 : public VideoMediaChannel, public webrtc::Transport {
                                bool transport_cc_enabled,
                                webrtc::RtcpMode rtcp_mode);
     void SetRecvParameters(const ChangedRecvParameters& recv_params);
+    void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key);
 
     void OnFrame(const webrtc::VideoFrame& frame) override;
     bool IsDefaultStream() const;
@@ -492,6 +496,9 @@ class WebRtcVideoChannel2 : public VideoMediaChannel, public webrtc::Transport {
   VideoOptions default_send_options_;
   VideoRecvParameters recv_params_;
   int64_t last_stats_log_ms_;
+  // Reused by OnPacketsReceived.
+  std::vector<webrtc::PacketReceiver::ReceivedPacket> delivered_packets_;
+  std::vector<webrtc::PacketReceiver::DeliveryStatus> delivery_statuses_;
 };
 
 }  // namespace cricket
@@ -16,6 +16,7 @@
 
 #include "webrtc/base/arraysize.h"
 #include "webrtc/base/gunit.h"
+#include "webrtc/base/sslstreamadapter.h"
 #include "webrtc/base/stringutils.h"
 #include "webrtc/common_video/h264/profile_level_id.h"
 #include "webrtc/logging/rtc_event_log/rtc_event_log.h"
@@ -1256,6 +1257,56 @@ TEST_F(WebRtcVideoChannel2Test, RecvStreamNoRtx) {
   ASSERT_TRUE(recv_stream->GetConfig().rtp.rtx.empty());
 }
 
+TEST_F(WebRtcVideoChannel2Test, RotatesMediaCryptoKeyWithoutRecreatingStreams) {
+  webrtc::MediaCryptoKey key;
+  key.type = rtc::SRTP_AEAD_AES_256_GCM;
+  key.buffer.assign(44, 1);
+  channel_->SetMediaCryptoKey(key);
+  FakeVideoSendStream* send_stream = AddSendStream();
+  FakeVideoReceiveStream* recv_stream = AddRecvStream();
+  ASSERT_TRUE(send_stream->GetConfig().media_crypto_enabled);
+  ASSERT_TRUE(recv_stream->GetConfig().media_crypto_enabled);
+  int num_send_stream_creations = fake_call_->GetNumCreatedSendStreams();
+  int num_recv_stream_creations = fake_call_->GetNumCreatedReceiveStreams();
+
+  key.buffer.assign(44, 2);
+  channel_->SetMediaCryptoKey(key);
+  EXPECT_EQ(num_send_stream_creations, fake_call_->GetNumCreatedSendStreams());
+  EXPECT_EQ(num_recv_stream_creations,
+            fake_call_->GetNumCreatedReceiveStreams());
+  EXPECT_EQ(key.buffer, send_stream->GetConfig().media_crypto_key.buffer);
+  EXPECT_EQ(key.buffer, recv_stream->GetConfig().media_crypto_key.buffer);
+}
+
+TEST_F(WebRtcVideoChannel2Test, NextMediaCryptoKeyOnlyReachesReceiveStreams) {
+  webrtc::MediaCryptoKey key;
+  key.type = rtc::SRTP_AEAD_AES_256_GCM;
+  key.buffer.assign(44, 1);
+  channel_->SetMediaCryptoKey(key);
+  FakeVideoSendStream* send_stream = AddSendStream();
+  FakeVideoReceiveStream* recv_stream = AddRecvStream();
+
+  webrtc::MediaCryptoKey next_key = key;
+  next_key.buffer.assign(44, 2);
+  next_key.receive_only = true;
+  channel_->SetMediaCryptoKey(next_key);
+  EXPECT_EQ(key.buffer, send_stream->GetConfig().media_crypto_key.buffer);
+  EXPECT_EQ(key.buffer, recv_stream->GetConfig().media_crypto_key.buffer);
+  EXPECT_EQ(next_key.buffer,
+            recv_stream->GetConfig().media_crypto_next_key.buffer);
+
+  // Streams added before the switch are created with both keys.
+  FakeVideoReceiveStream* new_recv_stream = AddRecvStream();
+  EXPECT_EQ(key.buffer, new_recv_stream->GetConfig().media_crypto_key.buffer);
+  EXPECT_EQ(next_key.buffer,
+            new_recv_stream->GetConfig().media_crypto_next_key.buffer);
+
+  next_key.receive_only = false;
+  channel_->SetMediaCryptoKey(next_key);
+  EXPECT_EQ(next_key.buffer, send_stream->GetConfig().media_crypto_key.buffer);
+  EXPECT_EQ(next_key.buffer, recv_stream->GetConfig().media_crypto_key.buffer);
+}
+
 TEST_F(WebRtcVideoChannel2Test, NoHeaderExtesionsByDefault) {
   FakeVideoSendStream* send_stream =
       AddSendStream(cricket::StreamParams::CreateLegacy(kSsrcs1[0]));
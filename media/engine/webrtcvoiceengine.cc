@@ -2165,6 +2165,12 @@ int WebRtcVoiceMediaChannel::CreateVoEChannel() {
     LOG_RTCERR0(CreateVoEChannel);
     return -1;
   }
+  // voe::Channel only installs receive only keys on its receive side.
+  if (media_crypto_enabled() && !media_crypto_next_key().buffer.empty() &&
+      engine()->voe()->base()->SetMediaCryptoKey(
+          id, media_crypto_next_key()) == -1) {
+    LOG_RTCERR1(SetMediaCryptoKey, id);
+  }
 
   return id;
 }
@@ -2596,6 +2602,28 @@ void WebRtcVoiceMediaChannel::OnTransportOverheadChanged(
                                     transport_overhead_per_packet);
 }
 
+void WebRtcVoiceMediaChannel::SetMediaCryptoKey(
+    const webrtc::MediaCryptoKey& key) {
+  RTC_DCHECK(worker_thread_checker_.CalledOnValidThread());
+  // Channels created without media crypto can't start using it midway.
+  bool rotate = media_crypto_enabled();
+  MediaChannel::SetMediaCryptoKey(key);
+  if (!rotate)
+    return;
+  for (const auto& kv : send_streams_) {
+    if (engine()->voe()->base()->SetMediaCryptoKey(kv.second->channel(),
+                                                   key) == -1) {
+      LOG_RTCERR1(SetMediaCryptoKey, kv.second->channel());
+    }
+  }
+  for (const auto& kv : recv_streams_) {
+    if (engine()->voe()->base()->SetMediaCryptoKey(kv.second->channel(),
+                                                   key) == -1) {
+      LOG_RTCERR1(SetMediaCryptoKey, kv.second->channel());
+    }
+  }
+}
+
 bool WebRtcVoiceMediaChannel::GetStats(VoiceMediaInfo* info) {
   TRACE_EVENT0("webrtc", "WebRtcVoiceMediaChannel::GetStats");
   RTC_DCHECK(worker_thread_checker_.CalledOnValidThread());
@@ -202,6 +202,7 @@ class WebRtcVoiceMediaChannel final : public VoiceMediaChannel,
                              const rtc::NetworkRoute& network_route) override;
   void OnReadyToSend(bool ready) override;
   void OnTransportOverheadChanged(int transport_overhead_per_packet) override;
+  void SetMediaCryptoKey(const webrtc::MediaCryptoKey& key) override;
   bool GetStats(VoiceMediaInfo* info) override;
 
   void SetRawAudioSink(
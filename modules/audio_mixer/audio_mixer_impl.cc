@@ -16,25 +16,16 @@
 #include <utility>
 
 #include "webrtc/audio/utility/audio_frame_operations.h"
+#include "webrtc/base/atomicops.h"
 #include "webrtc/base/logging.h"
 #include "webrtc/modules/audio_mixer/audio_frame_manipulator.h"
 #include "webrtc/modules/audio_mixer/default_output_rate_calculator.h"
+#include "webrtc/modules/audio_mixer/mixing_ops.h"
 
 namespace webrtc {
 namespace {
 
 struct SourceFrame {
-  SourceFrame(AudioMixerImpl::SourceStatus* source_status,
-              AudioFrame* audio_frame,
-              bool muted)
-      : source_status(source_status), audio_frame(audio_frame), muted(muted) {
-    RTC_DCHECK(source_status);
-    RTC_DCHECK(audio_frame);
-    if (!muted) {
-      energy = AudioMixerCalculateEnergy(*audio_frame);
-    }
-  }
-
   SourceFrame(AudioMixerImpl::SourceStatus* source_status,
               AudioFrame* audio_frame,
               bool muted,
@@ -79,10 +70,28 @@ void RampAndUpdateGain(
   }
 }
 
-// Mix the AudioFrames stored in audioFrameList into mixed_audio.
+// Updates the speech type and VAD activity of |mixed_audio| for
+// |added_frame|, the way AudioFrameOperations::Add() does.
+void AddFrameInfo(const AudioFrame& added_frame, AudioFrame* mixed_audio) {
+  if (mixed_audio->vad_activity_ == AudioFrame::kVadActive ||
+      added_frame.vad_activity_ == AudioFrame::kVadActive) {
+    mixed_audio->vad_activity_ = AudioFrame::kVadActive;
+  } else if (mixed_audio->vad_activity_ == AudioFrame::kVadUnknown ||
+             added_frame.vad_activity_ == AudioFrame::kVadUnknown) {
+    mixed_audio->vad_activity_ = AudioFrame::kVadUnknown;
+  }
+
+  if (mixed_audio->speech_type_ != added_frame.speech_type_)
+    mixed_audio->speech_type_ = AudioFrame::kUndefined;
+}
+
+// Mix the AudioFrames stored in audioFrameList into mixed_audio. Several
+// frames are summed in |mix_buffer| and limited by |limiter| before they are
+// converted back to int16, a single frame is copied as is.
 int32_t MixFromList(AudioFrame* mixed_audio,
                     const AudioFrameList& audio_frame_list,
-                    bool use_limiter) {
+                    float* mix_buffer,
+                    PeakLimiter* limiter) {
   if (audio_frame_list.empty()) {
     return 0;
   }
@@ -104,17 +113,26 @@ int32_t MixFromList(AudioFrame* mixed_audio,
         static_cast<size_t>((mixed_audio->sample_rate_hz_ *
                              webrtc::AudioMixerImpl::kFrameDurationInMs) /
                             1000));
-
-    // Mix |f.frame| into |mixed_audio|, with saturation protection.
-    // These effect is applied to |f.frame| itself prior to mixing.
-    if (use_limiter) {
-      // This is to avoid saturation in the mixing. It is only
-      // meaningful if the limiter will be used.
-      AudioFrameOperations::ApplyHalfGain(frame);
-    }
     RTC_DCHECK_EQ(frame->num_channels_, mixed_audio->num_channels_);
-    AudioFrameOperations::Add(*frame, mixed_audio);
   }
+
+  if (audio_frame_list.size() == 1) {
+    AudioFrameOperations::Add(*audio_frame_list.front(), mixed_audio);
+    return 0;
+  }
+
+  mixed_audio->samples_per_channel_ =
+      audio_frame_list.front()->samples_per_channel_;
+  const size_t length =
+      mixed_audio->samples_per_channel_ * mixed_audio->num_channels_;
+  std::fill(mix_buffer, mix_buffer + length, 0.0f);
+  for (const auto& frame : audio_frame_list) {
+    internal::AccumulateS16(frame->data_, length, mix_buffer);
+    AddFrameInfo(*frame, mixed_audio);
+  }
+  limiter->Process(mixed_audio->num_channels_,
+                   mixed_audio->samples_per_channel_, mix_buffer);
+  internal::SaturateToS16(mix_buffer, length, mixed_audio->data_);
   return 0;
 }
 
@@ -139,53 +157,25 @@ AudioMixerImpl::SourceStatusList::iterator FindSourceInList(
       });
 }
 
-std::unique_ptr<AudioProcessing> CreateLimiter() {
-  Config config;
-  config.Set<ExperimentalAgc>(new ExperimentalAgc(false));
-  std::unique_ptr<AudioProcessing> limiter(AudioProcessing::Create(config));
-  if (!limiter.get()) {
-    return nullptr;
-  }
-
-  if (limiter->gain_control()->set_mode(GainControl::kFixedDigital) !=
-      limiter->kNoError) {
-    return nullptr;
-  }
-
-  // We smoothly limit the mixed frame to -7 dbFS. -6 would correspond to the
-  // divide-by-2 but -7 is used instead to give a bit of headroom since the
-  // AGC is not a hard limiter.
-  if (limiter->gain_control()->set_target_level_dbfs(7) != limiter->kNoError) {
-    return nullptr;
-  }
-
-  if (limiter->gain_control()->set_compression_gain_db(0) !=
-      limiter->kNoError) {
-    return nullptr;
-  }
-
-  if (limiter->gain_control()->enable_limiter(true) != limiter->kNoError) {
-    return nullptr;
-  }
-
-  if (limiter->gain_control()->Enable(true) != limiter->kNoError) {
-    return nullptr;
-  }
-  return limiter;
-}
-
 }  // namespace
 
 AudioMixerImpl::AudioMixerImpl(
-    std::unique_ptr<AudioProcessing> limiter,
-    std::unique_ptr<OutputRateCalculator> output_rate_calculator)
+    std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+    size_t num_pulling_threads)
     : output_rate_calculator_(std::move(output_rate_calculator)),
       output_frequency_(0),
       sample_size_(0),
       audio_source_list_(),
-      use_limiter_(true),
       time_stamp_(0),
-      limiter_(std::move(limiter)) {}
+      mix_buffer_(AudioFrame::kMaxDataSizeSamples),
+      next_source_to_pull_(0),
+      num_pulling_queues_running_(0),
+      pulling_done_(false, false) {
+  for (size_t i = 0; i < num_pulling_threads; ++i) {
+    pulling_queues_.emplace_back(
+        new rtc::TaskQueue("AudioMixerPullingQueue"));
+  }
+}
 
 AudioMixerImpl::~AudioMixerImpl() {}
 
@@ -198,9 +188,15 @@ rtc::scoped_refptr<AudioMixerImpl> AudioMixerImpl::Create() {
 rtc::scoped_refptr<AudioMixerImpl>
 AudioMixerImpl::CreateWithOutputRateCalculator(
     std::unique_ptr<OutputRateCalculator> output_rate_calculator) {
+  return CreateWithPullingThreads(std::move(output_rate_calculator), 0);
+}
+
+rtc::scoped_refptr<AudioMixerImpl> AudioMixerImpl::CreateWithPullingThreads(
+    std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+    size_t num_pulling_threads) {
   return rtc::scoped_refptr<AudioMixerImpl>(
       new rtc::RefCountedObject<AudioMixerImpl>(
-          CreateLimiter(), std::move(output_rate_calculator)));
+          std::move(output_rate_calculator), num_pulling_threads));
 }
 
 void AudioMixerImpl::Mix(size_t number_of_channels,
@@ -225,19 +221,15 @@ void AudioMixerImpl::Mix(size_t number_of_channels,
 
     time_stamp_ += static_cast<uint32_t>(sample_size_);
 
-    use_limiter_ = mix_list.size() > 1;
-
     // We only use the limiter if we're actually mixing multiple streams.
-    MixFromList(audio_frame_for_mixing, mix_list, use_limiter_);
+    MixFromList(audio_frame_for_mixing, mix_list, mix_buffer_.data(),
+                &limiter_);
   }
 
   if (audio_frame_for_mixing->samples_per_channel_ == 0) {
     // Nothing was mixed, set the audio samples to silence.
     audio_frame_for_mixing->samples_per_channel_ = sample_size_;
     AudioFrameOperations::Mute(audio_frame_for_mixing);
-  } else {
-    // Only call the limiter if we have something to mix.
-    LimitMixedAudio(audio_frame_for_mixing);
   }
 
   return;
@@ -289,18 +281,21 @@ AudioFrameList AudioMixerImpl::GetAudioFromSources() {
   std::vector<SourceFrame> ramp_list;
 
   // Get audio from the audio sources and put it in the SourceFrame vector.
-  for (auto& source_and_status : audio_source_list_) {
-    const auto audio_frame_info =
-        source_and_status->audio_source->GetAudioFrameWithInfo(
-            OutputFrequency(), &source_and_status->audio_frame);
-
-    if (audio_frame_info == Source::AudioFrameInfo::kError) {
+  std::vector<SourceStatus*> sources;
+  sources.reserve(audio_source_list_.size());
+  for (auto& source_and_status : audio_source_list_)
+    sources.push_back(source_and_status.get());
+  PullAudioFromSources(sources, OutputFrequency());
+
+  for (SourceStatus* source_status : sources) {
+    if (source_status->audio_frame_info == Source::AudioFrameInfo::kError) {
       LOG_F(LS_WARNING) << "failed to GetAudioFrameWithInfo() from source";
       continue;
     }
     audio_source_mixing_data_list.emplace_back(
-        source_and_status.get(), &source_and_status->audio_frame,
-        audio_frame_info == Source::AudioFrameInfo::kMuted);
+        source_status, &source_status->audio_frame,
+        source_status->audio_frame_info == Source::AudioFrameInfo::kMuted,
+        source_status->energy);
   }
 
   // Sort frames by sorting function.
@@ -332,33 +327,50 @@ AudioFrameList AudioMixerImpl::GetAudioFromSources() {
 }
 
 
-bool AudioMixerImpl::LimitMixedAudio(AudioFrame* mixed_audio) const {
+void AudioMixerImpl::PullAudioFromSources(
+    const std::vector<SourceStatus*>& sources,
+    int sample_rate_hz) {
   RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
-  if (!use_limiter_) {
-    return true;
+  rtc::AtomicOps::ReleaseStore(&next_source_to_pull_, 0);
+  // The calling thread pulls too, so there is no point in waking up more
+  // threads than there are other sources.
+  const int num_queues = static_cast<int>(
+      std::min(pulling_queues_.size(),
+               sources.empty() ? 0 : sources.size() - 1));
+  if (num_queues == 0) {
+    PullAudioFromRemainingSources(sources, sample_rate_hz);
+    return;
   }
 
-  // Smoothly limit the mixed frame.
-  const int error = limiter_->ProcessStream(mixed_audio);
-
-  // And now we can safely restore the level. This procedure results in
-  // some loss of resolution, deemed acceptable.
-  //
-  // It's possible to apply the gain in the AGC (with a target level of 0 dbFS
-  // and compression gain of 6 dB). However, in the transition frame when this
-  // is enabled (moving from one to two audio sources) it has the potential to
-  // create discontinuities in the mixed frame.
-  //
-  // Instead we double the frame (with addition since left-shifting a
-  // negative value is undefined).
-  AudioFrameOperations::Add(*mixed_audio, mixed_audio);
-
-  if (error != limiter_->kNoError) {
-    LOG_F(LS_ERROR) << "Error from AudioProcessing: " << error;
-    RTC_NOTREACHED();
-    return false;
+  rtc::AtomicOps::ReleaseStore(&num_pulling_queues_running_, num_queues);
+  for (int i = 0; i < num_queues; ++i) {
+    // |sources| outlives the tasks, since they are waited for below.
+    pulling_queues_[i]->PostTask([this, &sources, sample_rate_hz] {
+      PullAudioFromRemainingSources(sources, sample_rate_hz);
+      if (rtc::AtomicOps::Decrement(&num_pulling_queues_running_) == 0)
+        pulling_done_.Set();
+    });
+  }
+  PullAudioFromRemainingSources(sources, sample_rate_hz);
+  pulling_done_.Wait(rtc::Event::kForever);
+}
+
+void AudioMixerImpl::PullAudioFromRemainingSources(
+    const std::vector<SourceStatus*>& sources,
+    int sample_rate_hz) {
+  const int num_sources = static_cast<int>(sources.size());
+  for (int index = rtc::AtomicOps::Increment(&next_source_to_pull_) - 1;
+       index < num_sources;
+       index = rtc::AtomicOps::Increment(&next_source_to_pull_) - 1) {
+    SourceStatus* source_status = sources[index];
+    source_status->audio_frame_info =
+        source_status->audio_source->GetAudioFrameWithInfo(
+            sample_rate_hz, &source_status->audio_frame);
+    source_status->energy =
+        source_status->audio_frame_info == Source::AudioFrameInfo::kNormal
+            ? AudioMixerCalculateEnergy(source_status->audio_frame)
+            : 0;
   }
-  return true;
 }
 
 bool AudioMixerImpl::GetAudioSourceMixabilityStatusForTest(
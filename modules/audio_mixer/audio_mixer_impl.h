@@ -15,11 +15,13 @@
 #include <vector>
 
 #include "webrtc/api/audio/audio_mixer.h"
+#include "webrtc/base/event.h"
 #include "webrtc/base/scoped_ref_ptr.h"
+#include "webrtc/base/task_queue.h"
 #include "webrtc/base/thread_annotations.h"
 #include "webrtc/base/race_checker.h"
 #include "webrtc/modules/audio_mixer/output_rate_calculator.h"
-#include "webrtc/modules/audio_processing/include/audio_processing.h"
+#include "webrtc/modules/audio_mixer/peak_limiter.h"
 #include "webrtc/modules/include/module_common_types.h"
 #include "webrtc/system_wrappers/include/critical_section_wrapper.h"
 #include "webrtc/typedefs.h"
@@ -39,6 +41,10 @@ class AudioMixerImpl : public AudioMixer {
 
     // A frame that will be passed to audio_source->GetAudioFrameWithInfo.
     AudioFrame audio_frame;
+    // What GetAudioFrameWithInfo returned in the current mixing round, and
+    // the energy of |audio_frame| if it isn't muted.
+    Source::AudioFrameInfo audio_frame_info = Source::AudioFrameInfo::kError;
+    uint32_t energy = 0;
   };
 
   using SourceStatusList = std::vector<std::unique_ptr<SourceStatus>>;
@@ -50,6 +56,14 @@ class AudioMixerImpl : public AudioMixer {
   static rtc::scoped_refptr<AudioMixerImpl> Create();
   static rtc::scoped_refptr<AudioMixerImpl> CreateWithOutputRateCalculator(
       std::unique_ptr<OutputRateCalculator> output_rate_calculator);
+  // Creates a mixer that pulls audio from its sources on
+  // |num_pulling_threads| threads in addition to the mixing thread. Pulling
+  // decodes the audio of a source, which dominates the mixing time when there
+  // are many sources. The sources' GetAudioFrameWithInfo() is then called on
+  // any of these threads, but only once per mixing round.
+  static rtc::scoped_refptr<AudioMixerImpl> CreateWithPullingThreads(
+      std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+      size_t num_pulling_threads);
 
   ~AudioMixerImpl() override;
 
@@ -66,8 +80,8 @@ class AudioMixerImpl : public AudioMixer {
   bool GetAudioSourceMixabilityStatusForTest(Source* audio_source) const;
 
  protected:
-  AudioMixerImpl(std::unique_ptr<AudioProcessing> limiter,
-                 std::unique_ptr<OutputRateCalculator> output_rate_calculator);
+  AudioMixerImpl(std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+                 size_t num_pulling_threads);
 
  private:
   // Set mixing frequency through OutputFrequencyCalculator.
@@ -80,6 +94,15 @@ class AudioMixerImpl : public AudioMixer {
   // kMaximumAmountOfMixedAudioSources audio sources.
   AudioFrameList GetAudioFromSources() EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
+  // Pulls audio from all |sources|, spread over the pulling threads and the
+  // calling thread.
+  void PullAudioFromSources(const std::vector<SourceStatus*>& sources,
+                            int sample_rate_hz);
+  // Pulls audio from the sources of |sources| that no thread has taken yet,
+  // one at a time.
+  void PullAudioFromRemainingSources(const std::vector<SourceStatus*>& sources,
+                                     int sample_rate_hz);
+
   // Add/remove the MixerAudioSource to the specified
   // MixerAudioSource list.
   bool AddAudioSourceToList(Source* audio_source,
@@ -87,8 +110,6 @@ class AudioMixerImpl : public AudioMixer {
   bool RemoveAudioSourceFromList(Source* remove_audio_source,
                                  SourceStatusList* audio_source_list) const;
 
-  bool LimitMixedAudio(AudioFrame* mixed_audio) const;
-
   // The critical section lock guards audio source insertion and
   // removal, which can be done from any thread. The race checker
   // checks that mixing is done sequentially.
@@ -103,14 +124,19 @@ class AudioMixerImpl : public AudioMixer {
   // List of all audio sources. Note all lists are disjunct
   SourceStatusList audio_source_list_ GUARDED_BY(crit_);  // May be mixed.
 
-  // Determines if we will use a limiter for clipping protection during
-  // mixing.
-  bool use_limiter_ GUARDED_BY(race_checker_);
-
   uint32_t time_stamp_ GUARDED_BY(race_checker_);
 
-  // Used for inhibiting saturation in mixing.
-  std::unique_ptr<AudioProcessing> limiter_ GUARDED_BY(race_checker_);
+  // The sum of the mixed frames, which is limited before it is converted
+  // back to int16.
+  std::vector<float> mix_buffer_ GUARDED_BY(race_checker_);
+  PeakLimiter limiter_ GUARDED_BY(race_checker_);
+
+  // The threads audio is pulled from the sources on, and the state of the
+  // current round of pulling.
+  std::vector<std::unique_ptr<rtc::TaskQueue>> pulling_queues_;
+  volatile int next_source_to_pull_;
+  volatile int num_pulling_queues_running_;
+  rtc::Event pulling_done_;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(AudioMixerImpl);
 };
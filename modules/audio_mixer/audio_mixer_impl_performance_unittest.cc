@@ -0,0 +1,134 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/audio_mixer/audio_mixer_impl.h"
+#include "webrtc/modules/audio_mixer/default_output_rate_calculator.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kSampleRateHz = 48000;
+constexpr size_t kSamplesPerChannel = kSampleRateHz / 100;
+constexpr int kNumTicks = 500;
+// Passes of the filter that stands in for decoding, about as much work as
+// decoding 10 ms of Opus.
+constexpr int kDecodePasses = 20;
+
+// A source that synthesizes a tone, and filters it to stand in for the work
+// of decoding its audio.
+class DecodingSource : public AudioMixer::Source {
+ public:
+  DecodingSource(int index, int decode_passes)
+      : ssrc_(index),
+        decode_passes_(decode_passes),
+        frequency_hz_(200.0f + 37.0f * index),
+        // Every fourth source is loud, so that the mix needs limiting.
+        amplitude_(index % 4 == 0 ? 25000.0f : 3000.0f) {}
+
+  AudioFrameInfo GetAudioFrameWithInfo(int sample_rate_hz,
+                                       AudioFrame* audio_frame) override {
+    float samples[kSamplesPerChannel];
+    for (size_t i = 0; i < kSamplesPerChannel; ++i) {
+      samples[i] = amplitude_ * sinf(phase_);
+      phase_ += 2 * M_PI * frequency_hz_ / sample_rate_hz;
+    }
+    phase_ = fmodf(phase_, 2 * M_PI);
+    for (int pass = 0; pass < decode_passes_; ++pass) {
+      for (size_t i = 0; i < kSamplesPerChannel; ++i) {
+        filter_state_ = 0.5f * filter_state_ + 0.5f * samples[i];
+        samples[i] = filter_state_;
+      }
+    }
+    int16_t data[kSamplesPerChannel];
+    for (size_t i = 0; i < kSamplesPerChannel; ++i)
+      data[i] = static_cast<int16_t>(samples[i]);
+    audio_frame->UpdateFrame(-1, timestamp_, data, kSamplesPerChannel,
+                             sample_rate_hz, AudioFrame::kNormalSpeech,
+                             AudioFrame::kVadActive, 1);
+    timestamp_ += kSamplesPerChannel;
+    return AudioFrameInfo::kNormal;
+  }
+
+  int Ssrc() const override { return ssrc_; }
+  int PreferredSampleRate() const override { return kSampleRateHz; }
+
+ private:
+  const int ssrc_;
+  const int decode_passes_;
+  const float frequency_hz_;
+  const float amplitude_;
+  float phase_ = 0.0f;
+  float filter_state_ = 0.0f;
+  uint32_t timestamp_ = 0;
+};
+
+// Mixes |num_sources| sources for |kNumTicks| ticks, and reports the average
+// time of a tick.
+void RunMixTest(int num_sources,
+                int decode_passes,
+                size_t num_pulling_threads,
+                const std::string& modifier) {
+  rtc::scoped_refptr<AudioMixerImpl> mixer =
+      AudioMixerImpl::CreateWithPullingThreads(
+          std::unique_ptr<OutputRateCalculator>(
+              new DefaultOutputRateCalculator()),
+          num_pulling_threads);
+  std::vector<std::unique_ptr<DecodingSource>> sources;
+  for (int i = 0; i < num_sources; ++i) {
+    sources.emplace_back(new DecodingSource(i, decode_passes));
+    mixer->AddSource(sources.back().get());
+  }
+
+  AudioFrame mixed_frame;
+  // Let the mixed sources ramp in first.
+  mixer->Mix(2, &mixed_frame);
+  int64_t start_ns = rtc::TimeNanos();
+  for (int tick = 0; tick < kNumTicks; ++tick)
+    mixer->Mix(2, &mixed_frame);
+  int64_t tick_ns = (rtc::TimeNanos() - start_ns) / kNumTicks;
+
+  for (auto& source : sources)
+    mixer->RemoveSource(source.get());
+  EXPECT_EQ(2u, mixed_frame.num_channels_);
+  EXPECT_EQ(kSamplesPerChannel, mixed_frame.samples_per_channel_);
+
+  test::PrintResult("audio_mixer_mix_tick", modifier,
+                    std::to_string(num_sources) + "_sources",
+                    static_cast<size_t>(tick_ns / 1000), "us", true);
+}
+
+}  // namespace
+
+// The time the mixer itself takes, with sources that don't decode.
+TEST(AudioMixerPerformanceTest, MixWithoutDecoding) {
+  for (int num_sources : {3, 10, 30, 100})
+    RunMixTest(num_sources, 0, 0, "_without_decoding");
+}
+
+TEST(AudioMixerPerformanceTest, MixOnMixingThread) {
+  for (int num_sources : {3, 10, 30, 100})
+    RunMixTest(num_sources, kDecodePasses, 0, "_0_pulling_threads");
+}
+
+TEST(AudioMixerPerformanceTest, MixWithPullingThreads) {
+  for (int num_sources : {3, 10, 30, 100})
+    RunMixTest(num_sources, kDecodePasses, 4, "_4_pulling_threads");
+}
+
+}  // namespace webrtc
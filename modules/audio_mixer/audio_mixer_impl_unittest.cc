@@ -8,6 +8,7 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <limits>
@@ -19,6 +20,7 @@
 #include "webrtc/base/thread.h"
 #include "webrtc/modules/audio_mixer/audio_mixer_impl.h"
 #include "webrtc/modules/audio_mixer/default_output_rate_calculator.h"
+#include "webrtc/modules/audio_mixer/peak_limiter.h"
 #include "webrtc/test/gmock.h"
 
 using testing::_;
@@ -479,4 +481,58 @@ TEST(AudioMixer, ZeroSourceRateShouldBeDecidedByRateCalculator) {
 
   EXPECT_EQ(kOutputRate, frame_for_mixing.sample_rate_hz_);
 }
+
+TEST(AudioMixer, LargestEnergyMixedWhenPullingOnThreads) {
+  constexpr int kAudioSources = 20;
+  const auto mixer = AudioMixerImpl::CreateWithPullingThreads(
+      std::unique_ptr<OutputRateCalculator>(new DefaultOutputRateCalculator()),
+      4);
+
+  std::vector<MockMixerAudioSource> participants(kAudioSources);
+  for (int i = 0; i < kAudioSources; ++i) {
+    ResetFrame(participants[i].fake_frame());
+    participants[i].fake_frame()->data_[80] = i;
+    EXPECT_TRUE(mixer->AddSource(&participants[i]));
+    EXPECT_CALL(participants[i], GetAudioFrameWithInfo(_, _)).Times(Exactly(2));
+  }
+
+  AudioFrame audio_frame;
+  for (int i = 0; i < 2; ++i)
+    mixer->Mix(1, &audio_frame);
+
+  for (int i = 0; i < kAudioSources; ++i) {
+    EXPECT_EQ(i >= kAudioSources -
+                       AudioMixerImpl::kMaximumAmountOfMixedAudioSources,
+              mixer->GetAudioSourceMixabilityStatusForTest(&participants[i]))
+        << "Mixing status of AudioSource #" << i << " wrong.";
+  }
+  // The sum of the mixed sources, which is low enough not to be limited.
+  EXPECT_EQ(17 + 18 + 19, audio_frame.data_[80]);
+}
+
+TEST(AudioMixer, LimitsLoudMixInsteadOfWrapping) {
+  const auto mixer = AudioMixerImpl::Create();
+
+  std::vector<MockMixerAudioSource> participants(
+      AudioMixerImpl::kMaximumAmountOfMixedAudioSources);
+  for (auto& participant : participants) {
+    ResetFrame(participant.fake_frame());
+    const size_t n_samples = participant.fake_frame()->samples_per_channel_;
+    for (size_t j = 0; j < n_samples; ++j)
+      participant.fake_frame()->data_[j] = j % 2 ? 20000 : -20000;
+    EXPECT_TRUE(mixer->AddSource(&participant));
+  }
+
+  AudioFrame audio_frame;
+  // Compare after the ramp-up step.
+  for (int i = 0; i < 2; ++i)
+    mixer->Mix(1, &audio_frame);
+
+  for (size_t j = 0; j < audio_frame.samples_per_channel_; ++j) {
+    EXPECT_LE(std::abs(audio_frame.data_[j]),
+              static_cast<int>(PeakLimiter::kThreshold) + 1);
+    EXPECT_EQ(j % 2 == 1, audio_frame.data_[j] > 0) << "sample " << j;
+  }
+}
+
 }  // namespace webrtc
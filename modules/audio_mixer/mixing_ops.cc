@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_mixer/mixing_ops.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "webrtc/common_audio/include/audio_util.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace internal {
+namespace {
+
+// If we know the minimum architecture at compile time, avoid CPU detection.
+#if defined(WEBRTC_ARCH_X86_FAMILY) && !defined(__SSE2__)
+bool HaveSse2() {
+  static const bool have_sse2 = WebRtc_GetCPUInfo(kSSE2) != 0;
+  return have_sse2;
+}
+#endif
+
+}  // namespace
+
+void AccumulateS16(const int16_t* src, size_t length, float* dst) {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#if defined(__SSE2__)
+  AccumulateS16_SSE2(src, length, dst);
+#else
+  if (HaveSse2()) {
+    AccumulateS16_SSE2(src, length, dst);
+  } else {
+    AccumulateS16_C(src, length, dst);
+  }
+#endif
+#elif defined(WEBRTC_HAS_NEON)
+  AccumulateS16_NEON(src, length, dst);
+#else
+  AccumulateS16_C(src, length, dst);
+#endif
+}
+
+void SaturateToS16(const float* src, size_t length, int16_t* dst) {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#if defined(__SSE2__)
+  SaturateToS16_SSE2(src, length, dst);
+#else
+  if (HaveSse2()) {
+    SaturateToS16_SSE2(src, length, dst);
+  } else {
+    SaturateToS16_C(src, length, dst);
+  }
+#endif
+#elif defined(WEBRTC_HAS_NEON)
+  SaturateToS16_NEON(src, length, dst);
+#else
+  SaturateToS16_C(src, length, dst);
+#endif
+}
+
+float MaxAbsValue(const float* src, size_t length) {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#if defined(__SSE2__)
+  return MaxAbsValue_SSE2(src, length);
+#else
+  return HaveSse2() ? MaxAbsValue_SSE2(src, length)
+                    : MaxAbsValue_C(src, length);
+#endif
+#elif defined(WEBRTC_HAS_NEON)
+  return MaxAbsValue_NEON(src, length);
+#else
+  return MaxAbsValue_C(src, length);
+#endif
+}
+
+void AccumulateS16_C(const int16_t* src, size_t length, float* dst) {
+  for (size_t i = 0; i < length; ++i)
+    dst[i] += src[i];
+}
+
+void SaturateToS16_C(const float* src, size_t length, int16_t* dst) {
+  FloatS16ToS16(src, length, dst);
+}
+
+float MaxAbsValue_C(const float* src, size_t length) {
+  float max_abs = 0.0f;
+  for (size_t i = 0; i < length; ++i)
+    max_abs = std::max(max_abs, std::fabs(src[i]));
+  return max_abs;
+}
+
+}  // namespace internal
+}  // namespace webrtc
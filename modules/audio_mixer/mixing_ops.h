@@ -0,0 +1,50 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_MIXER_MIXING_OPS_H_
+#define WEBRTC_MODULES_AUDIO_MIXER_MIXING_OPS_H_
+
+#include <stddef.h>
+
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+namespace internal {
+
+// Adds |length| int16 samples of |src| to the float samples of |dst|. Floats
+// have the headroom to sum any number of frames without saturating.
+void AccumulateS16(const int16_t* src, size_t length, float* dst);
+
+// Rounds |length| float samples of |src| to int16, saturating the ones that
+// are out of range. Gives the same result as FloatS16ToS16().
+void SaturateToS16(const float* src, size_t length, int16_t* dst);
+
+// Returns the largest absolute value of |length| samples of |src|.
+float MaxAbsValue(const float* src, size_t length);
+
+// The implementations the functions above pick from, exposed for testing.
+void AccumulateS16_C(const int16_t* src, size_t length, float* dst);
+void SaturateToS16_C(const float* src, size_t length, int16_t* dst);
+float MaxAbsValue_C(const float* src, size_t length);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+void AccumulateS16_SSE2(const int16_t* src, size_t length, float* dst);
+void SaturateToS16_SSE2(const float* src, size_t length, int16_t* dst);
+float MaxAbsValue_SSE2(const float* src, size_t length);
+#endif
+#if defined(WEBRTC_HAS_NEON)
+void AccumulateS16_NEON(const int16_t* src, size_t length, float* dst);
+void SaturateToS16_NEON(const float* src, size_t length, int16_t* dst);
+float MaxAbsValue_NEON(const float* src, size_t length);
+#endif
+
+}  // namespace internal
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_MIXER_MIXING_OPS_H_
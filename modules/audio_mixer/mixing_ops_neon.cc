@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_mixer/mixing_ops.h"
+
+#include <arm_neon.h>
+
+namespace webrtc {
+namespace internal {
+
+void AccumulateS16_NEON(const int16_t* src, size_t length, float* dst) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    int16x8_t s = vld1q_s16(src + i);
+    float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+    float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+    vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), lo));
+    vst1q_f32(dst + i + 4, vaddq_f32(vld1q_f32(dst + i + 4), hi));
+  }
+  for (; i < length; ++i)
+    dst[i] += src[i];
+}
+
+void SaturateToS16_NEON(const float* src, size_t length, int16_t* dst) {
+  const float32x4_t kMax = vdupq_n_f32(32767.0f);
+  const float32x4_t kMin = vdupq_n_f32(-32768.0f);
+  const float32x4_t kZero = vdupq_n_f32(0.0f);
+  const float32x4_t kHalf = vdupq_n_f32(0.5f);
+  const float32x4_t kMinusHalf = vdupq_n_f32(-0.5f);
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    int32x4_t v[2];
+    for (int j = 0; j < 2; ++j) {
+      float32x4_t x = vld1q_f32(src + i + 4 * j);
+      x = vminq_f32(vmaxq_f32(x, kMin), kMax);
+      // Round half away from zero, by adding +-0.5 and truncating.
+      float32x4_t half = vbslq_f32(vcgtq_f32(x, kZero), kHalf, kMinusHalf);
+      v[j] = vcvtq_s32_f32(vaddq_f32(x, half));
+    }
+    vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(v[0]), vqmovn_s32(v[1])));
+  }
+  SaturateToS16_C(src + i, length - i, dst + i);
+}
+
+float MaxAbsValue_NEON(const float* src, size_t length) {
+  float32x4_t max_abs = vdupq_n_f32(0.0f);
+  size_t i = 0;
+  for (; i + 4 <= length; i += 4)
+    max_abs = vmaxq_f32(max_abs, vabsq_f32(vld1q_f32(src + i)));
+  float32x2_t max_pair =
+      vpmax_f32(vget_low_f32(max_abs), vget_high_f32(max_abs));
+  max_pair = vpmax_f32(max_pair, max_pair);
+  float result = vget_lane_f32(max_pair, 0);
+  float tail = MaxAbsValue_C(src + i, length - i);
+  return result > tail ? result : tail;
+}
+
+}  // namespace internal
+}  // namespace webrtc
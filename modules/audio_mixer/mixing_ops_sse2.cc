@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_mixer/mixing_ops.h"
+
+#include <emmintrin.h>
+
+namespace webrtc {
+namespace internal {
+
+void AccumulateS16_SSE2(const int16_t* src, size_t length, float* dst) {
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // Sign extend to 32 bits by placing the samples in the upper halves, and
+    // shifting them back down.
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+    _mm_storeu_ps(dst + i,
+                  _mm_add_ps(_mm_loadu_ps(dst + i), _mm_cvtepi32_ps(lo)));
+    _mm_storeu_ps(dst + i + 4,
+                  _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_cvtepi32_ps(hi)));
+  }
+  for (; i < length; ++i)
+    dst[i] += src[i];
+}
+
+void SaturateToS16_SSE2(const float* src, size_t length, int16_t* dst) {
+  const __m128 kMax = _mm_set1_ps(32767.0f);
+  const __m128 kMin = _mm_set1_ps(-32768.0f);
+  const __m128 kZero = _mm_setzero_ps();
+  const __m128 kHalf = _mm_set1_ps(0.5f);
+  const __m128 kMinusHalf = _mm_set1_ps(-0.5f);
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    __m128 v[2];
+    for (int j = 0; j < 2; ++j) {
+      __m128 x = _mm_loadu_ps(src + i + 4 * j);
+      x = _mm_min_ps(_mm_max_ps(x, kMin), kMax);
+      // Round half away from zero, by adding +-0.5 and truncating.
+      __m128 positive = _mm_cmpgt_ps(x, kZero);
+      __m128 half = _mm_or_ps(_mm_and_ps(positive, kHalf),
+                              _mm_andnot_ps(positive, kMinusHalf));
+      v[j] = _mm_add_ps(x, half);
+    }
+    __m128i packed =
+        _mm_packs_epi32(_mm_cvttps_epi32(v[0]), _mm_cvttps_epi32(v[1]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+  }
+  SaturateToS16_C(src + i, length - i, dst + i);
+}
+
+float MaxAbsValue_SSE2(const float* src, size_t length) {
+  // Clears the sign bit.
+  const __m128 kAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 max_abs = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 4 <= length; i += 4)
+    max_abs = _mm_max_ps(max_abs, _mm_and_ps(_mm_loadu_ps(src + i), kAbsMask));
+  max_abs = _mm_max_ps(max_abs, _mm_movehl_ps(max_abs, max_abs));
+  max_abs = _mm_max_ss(max_abs, _mm_shuffle_ps(max_abs, max_abs, 1));
+  float result = _mm_cvtss_f32(max_abs);
+  float tail = MaxAbsValue_C(src + i, length - i);
+  return result > tail ? result : tail;
+}
+
+}  // namespace internal
+}  // namespace webrtc
@@ -0,0 +1,141 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "webrtc/base/arraysize.h"
+#include "webrtc/base/random.h"
+#include "webrtc/common_audio/include/audio_util.h"
+#include "webrtc/modules/audio_mixer/mixing_ops.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+namespace internal {
+namespace {
+
+typedef void (*AccumulateFunction)(const int16_t*, size_t, float*);
+typedef void (*SaturateFunction)(const float*, size_t, int16_t*);
+typedef float (*MaxAbsFunction)(const float*, size_t);
+
+// Lengths around the vector sizes, and of full 10 ms stereo frames.
+std::vector<size_t> TestLengths() {
+  std::vector<size_t> lengths;
+  for (size_t length = 0; length <= 40; ++length)
+    lengths.push_back(length);
+  lengths.push_back(320);
+  lengths.push_back(960);
+  return lengths;
+}
+
+void VerifyAccumulate(AccumulateFunction accumulate) {
+  Random random(0x1a2b);
+  for (size_t length : TestLengths()) {
+    std::vector<int16_t> src(length);
+    std::vector<float> dst(length);
+    for (size_t i = 0; i < length; ++i) {
+      src[i] = random.Rand<int16_t>();
+      dst[i] = static_cast<float>(random.Rand(-100000, 100000));
+    }
+    std::vector<float> expected = dst;
+    for (size_t i = 0; i < length; ++i)
+      expected[i] += src[i];
+
+    accumulate(src.data(), length, dst.data());
+    EXPECT_EQ(expected, dst) << "length " << length;
+  }
+}
+
+void VerifySaturate(SaturateFunction saturate) {
+  Random random(0x3c4d);
+  // Ties, and values on both sides of the int16 limits.
+  const float kEdgeValues[] = {0.0f,     0.5f,     -0.5f,    1.5f,
+                               -1.5f,    2.5f,     -2.5f,    32766.4f,
+                               32766.5f, 32767.0f, 32767.4f, 32768.0f,
+                               1.0e9f,   -32767.5f, -32768.0f, -32768.6f,
+                               -1.0e9f};
+  for (size_t length : TestLengths()) {
+    std::vector<float> src(length);
+    for (size_t i = 0; i < length; ++i) {
+      src[i] = i % 3 == 0
+                   ? kEdgeValues[random.Rand(arraysize(kEdgeValues) - 1)]
+                   : random.Rand(-40000, 40000) + random.Rand<float>();
+    }
+    std::vector<int16_t> expected(length);
+    for (size_t i = 0; i < length; ++i)
+      expected[i] = FloatS16ToS16(src[i]);
+    std::vector<int16_t> dst(length);
+
+    saturate(src.data(), length, dst.data());
+    EXPECT_EQ(expected, dst) << "length " << length;
+  }
+}
+
+void VerifyMaxAbs(MaxAbsFunction max_abs) {
+  Random random(0x5e6f);
+  for (size_t length : TestLengths()) {
+    std::vector<float> src(length);
+    float expected = 0.0f;
+    for (size_t i = 0; i < length; ++i) {
+      src[i] = random.Rand(-40000, 40000) + random.Rand<float>();
+      expected = std::max(expected, std::fabs(src[i]));
+    }
+    EXPECT_EQ(expected, max_abs(src.data(), length)) << "length " << length;
+    // The peak in the last sample, which is outside of the vectors for most
+    // lengths.
+    if (length > 0) {
+      src[length - 1] = -50000.0f;
+      EXPECT_EQ(50000.0f, max_abs(src.data(), length)) << "length " << length;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(MixingOpsTest, AccumulateS16) {
+  VerifyAccumulate(&AccumulateS16);
+  VerifyAccumulate(&AccumulateS16_C);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2))
+    VerifyAccumulate(&AccumulateS16_SSE2);
+#endif
+#if defined(WEBRTC_HAS_NEON)
+  VerifyAccumulate(&AccumulateS16_NEON);
+#endif
+}
+
+TEST(MixingOpsTest, SaturateToS16) {
+  VerifySaturate(&SaturateToS16);
+  VerifySaturate(&SaturateToS16_C);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2))
+    VerifySaturate(&SaturateToS16_SSE2);
+#endif
+#if defined(WEBRTC_HAS_NEON)
+  VerifySaturate(&SaturateToS16_NEON);
+#endif
+}
+
+TEST(MixingOpsTest, MaxAbsValue) {
+  VerifyMaxAbs(&MaxAbsValue);
+  VerifyMaxAbs(&MaxAbsValue_C);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2))
+    VerifyMaxAbs(&MaxAbsValue_SSE2);
+#endif
+#if defined(WEBRTC_HAS_NEON)
+  VerifyMaxAbs(&MaxAbsValue_NEON);
+#endif
+}
+
+}  // namespace internal
+}  // namespace webrtc
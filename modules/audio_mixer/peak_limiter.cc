@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_mixer/peak_limiter.h"
+
+#include <algorithm>
+
+#include "webrtc/base/checks.h"
+#include "webrtc/modules/audio_mixer/mixing_ops.h"
+
+namespace webrtc {
+namespace {
+
+// The gain is computed for each 1 ms of a 10 ms frame, and interpolated in
+// between.
+constexpr size_t kNumSubframes = 10;
+// How much of the distance to unity gain is recovered per subframe. Gives a
+// release time constant of about 50 ms.
+constexpr float kReleaseRate = 0.02f;
+
+}  // namespace
+
+constexpr float PeakLimiter::kThreshold;
+
+PeakLimiter::PeakLimiter() : gain_(1.0f) {}
+
+void PeakLimiter::Process(size_t num_channels,
+                          size_t samples_per_channel,
+                          float* data) {
+  RTC_DCHECK_GT(num_channels, 0u);
+  const size_t subframe_size =
+      std::max<size_t>(samples_per_channel / kNumSubframes, 1);
+  const size_t num_subframes =
+      std::min(kNumSubframes, samples_per_channel / subframe_size);
+  if (num_subframes == 0)
+    return;
+
+  // The largest gain each subframe may have without exceeding the threshold.
+  // The last subframe includes the samples that don't fill up a subframe.
+  float max_gains[kNumSubframes];
+  for (size_t k = 0; k < num_subframes; ++k) {
+    size_t begin = k * subframe_size;
+    size_t end = k + 1 == num_subframes ? samples_per_channel
+                                        : begin + subframe_size;
+    float peak = internal::MaxAbsValue(data + begin * num_channels,
+                                       (end - begin) * num_channels);
+    max_gains[k] = peak > kThreshold ? kThreshold / peak : 1.0f;
+  }
+
+  // The gains at the subframe boundaries. Both ends of a subframe are limited
+  // by its gain, so that the gain interpolated in between is too.
+  float gains[kNumSubframes + 1];
+  gains[0] = std::min(gain_, max_gains[0]);
+  for (size_t k = 1; k <= num_subframes; ++k) {
+    float released = gains[k - 1] + (1.0f - gains[k - 1]) * kReleaseRate;
+    float max_gain = max_gains[k - 1];
+    if (k < num_subframes)
+      max_gain = std::min(max_gain, max_gains[k]);
+    gains[k] = std::min(released, max_gain);
+  }
+  gain_ = gains[num_subframes];
+
+  if (std::all_of(gains, gains + num_subframes + 1,
+                  [](float gain) { return gain == 1.0f; })) {
+    return;
+  }
+
+  for (size_t k = 0; k < num_subframes; ++k) {
+    size_t begin = k * subframe_size;
+    size_t end = k + 1 == num_subframes ? samples_per_channel
+                                        : begin + subframe_size;
+    const float step = (gains[k + 1] - gains[k]) / (end - begin);
+    float gain = gains[k];
+    for (size_t i = begin; i < end; ++i) {
+      for (size_t channel = 0; channel < num_channels; ++channel)
+        data[i * num_channels + channel] *= gain;
+      gain += step;
+    }
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_MIXER_PEAK_LIMITER_H_
+#define WEBRTC_MODULES_AUDIO_MIXER_PEAK_LIMITER_H_
+
+#include <stddef.h>
+
+#include "webrtc/base/constructormagic.h"
+
+namespace webrtc {
+
+// Keeps the peaks of mixed audio below full scale. Audio is in the int16
+// range, but in floats, so that a mix of several sources can exceed it before
+// being limited. The gain drops as soon as a peak would exceed the threshold,
+// and recovers slowly afterwards. Audio that stays below the threshold is not
+// changed.
+class PeakLimiter {
+ public:
+  // -1 dBFS.
+  static constexpr float kThreshold = 29204.0f;
+
+  PeakLimiter();
+
+  // Limits a frame of |samples_per_channel| interleaved samples of
+  // |num_channels| channels, in place.
+  void Process(size_t num_channels, size_t samples_per_channel, float* data);
+
+  // The gain applied at the end of the last processed frame.
+  float gain() const { return gain_; }
+
+ private:
+  float gain_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(PeakLimiter);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_MIXER_PEAK_LIMITER_H_
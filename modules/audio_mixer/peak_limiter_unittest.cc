@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "webrtc/modules/audio_mixer/peak_limiter.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr size_t kSamplesPerChannel = 480;
+
+// A 10 ms frame of a 1 kHz sine at 48 kHz with |amplitude|, on all channels.
+std::vector<float> SineFrame(float amplitude, size_t num_channels) {
+  std::vector<float> frame(kSamplesPerChannel * num_channels);
+  for (size_t i = 0; i < kSamplesPerChannel; ++i) {
+    float sample = amplitude * std::sin(2 * M_PI * i / 48);
+    for (size_t channel = 0; channel < num_channels; ++channel)
+      frame[i * num_channels + channel] = sample;
+  }
+  return frame;
+}
+
+float MaxAbs(const std::vector<float>& frame) {
+  float max_abs = 0.0f;
+  for (float sample : frame)
+    max_abs = std::max(max_abs, std::fabs(sample));
+  return max_abs;
+}
+
+}  // namespace
+
+TEST(PeakLimiterTest, DoesNotChangeAudioBelowThreshold) {
+  PeakLimiter limiter;
+  for (int i = 0; i < 10; ++i) {
+    std::vector<float> frame = SineFrame(PeakLimiter::kThreshold, 2);
+    const std::vector<float> original = frame;
+    limiter.Process(2, kSamplesPerChannel, frame.data());
+    EXPECT_EQ(original, frame);
+    EXPECT_EQ(1.0f, limiter.gain());
+  }
+}
+
+TEST(PeakLimiterTest, KeepsPeaksBelowThreshold) {
+  PeakLimiter limiter;
+  for (float amplitude : {40000.0f, 100000.0f, 35000.0f, 200000.0f}) {
+    for (size_t num_channels : {1, 2}) {
+      std::vector<float> frame = SineFrame(amplitude, num_channels);
+      limiter.Process(num_channels, kSamplesPerChannel, frame.data());
+      EXPECT_LE(MaxAbs(frame), PeakLimiter::kThreshold * 1.0001f);
+      EXPECT_LT(limiter.gain(), 1.0f);
+    }
+  }
+}
+
+TEST(PeakLimiterTest, LimitsPeakInFirstSample) {
+  PeakLimiter limiter;
+  std::vector<float> frame(kSamplesPerChannel, 0.0f);
+  frame[0] = 60000.0f;
+  limiter.Process(1, kSamplesPerChannel, frame.data());
+  EXPECT_FLOAT_EQ(PeakLimiter::kThreshold, frame[0]);
+}
+
+TEST(PeakLimiterTest, GainRecoversSmoothly) {
+  PeakLimiter limiter;
+  std::vector<float> loud = SineFrame(2 * PeakLimiter::kThreshold, 1);
+  limiter.Process(1, kSamplesPerChannel, loud.data());
+  EXPECT_NEAR(0.5f, limiter.gain(), 0.01f);
+
+  // The gain recovers over a few hundred ms of quiet audio, without jumps
+  // between frames.
+  float last_gain = limiter.gain();
+  for (int i = 0; i < 50; ++i) {
+    std::vector<float> quiet = SineFrame(1000.0f, 1);
+    limiter.Process(1, kSamplesPerChannel, quiet.data());
+    EXPECT_GT(limiter.gain(), last_gain);
+    EXPECT_LT(limiter.gain() - last_gain, 0.2f);
+    last_gain = limiter.gain();
+  }
+  EXPECT_GT(limiter.gain(), 0.99f);
+}
+
+}  // namespace webrtc
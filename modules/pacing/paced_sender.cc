@@ -16,14 +16,18 @@
 #include <set>
 #include <vector>
 
+#include "webrtc/base/atomicops.h"
 #include "webrtc/base/checks.h"
 #include "webrtc/base/logging.h"
+#include "webrtc/base/timeutils.h"
 #include "webrtc/modules/include/module_common_types.h"
 #include "webrtc/modules/pacing/alr_detector.h"
 #include "webrtc/modules/pacing/bitrate_prober.h"
+#include "webrtc/modules/utility/include/process_thread.h"
 #include "webrtc/system_wrappers/include/clock.h"
 #include "webrtc/system_wrappers/include/critical_section_wrapper.h"
 #include "webrtc/system_wrappers/include/field_trial.h"
+#include "webrtc/system_wrappers/include/metrics.h"
 
 namespace {
 // Time limit in milliseconds between packet bursts.
@@ -33,6 +37,10 @@ const int64_t kMinPacketLimitMs = 5;
 // time.
 const int64_t kMaxIntervalTimeMs = 30;
 
+// Upper cap on process interval when there is nothing to send. Inserting a
+// packet wakes up the process thread before that.
+const int64_t kMaxIdleIntervalMs = 100;
+
 }  // namespace
 
 // TODO(sprang): Move at least PacketQueue and MediaBudget out to separate
@@ -102,13 +110,18 @@ class PacketQueue {
     if (!AddToDupeSet(packet))
       return;
 
-    UpdateQueueTime(packet.enqueue_time_ms);
+    // A packet inserted while the queue time was being updated may be pushed
+    // with an enqueue time older than the last update.
+    int64_t enqueue_time_ms =
+        std::max(packet.enqueue_time_ms, time_last_updated_);
+    UpdateQueueTime(enqueue_time_ms);
 
     // Store packet in list, use pointers in priority queue for cheaper moves.
     // Packets have a handle to its own iterator in the list, for easy removal
     // when popping from queue.
     packet_list_.push_front(packet);
     std::list<Packet>::iterator it = packet_list_.begin();
+    it->enqueue_time_ms = enqueue_time_ms;
     it->this_it = it;          // Handle for direct removal from list.
     prio_queue_.push(&(*it));  // Pointer into list.
     bytes_ += packet.bytes;
@@ -201,6 +214,92 @@ class PacketQueue {
   int64_t time_last_updated_;
 };
 
+// Queue of packets inserted by any number of threads without locking, taken
+// out all at once by a single thread. The slots are preallocated, so neither
+// side allocates. Each slot has a sequence number, telling producers whether
+// it is free for the position they claim and the consumer whether it has
+// been filled. Positions wrap around at 2^32, which is far more packets than
+// a producer can be preempted for between reading a slot and claiming it.
+class IngressQueue {
+ public:
+  // Must be a power of two.
+  static const uint32_t kCapacity = 1024;
+
+  IngressQueue() : slots_(kCapacity), enqueue_pos_(0), dequeue_pos_(0) {
+    for (size_t i = 0; i < kCapacity; ++i)
+      slots_[i].sequence = static_cast<int>(i);
+    packets_.reserve(kCapacity);
+  }
+
+  // May be called on any thread. Returns false if the queue is full.
+  bool Push(const Packet& packet) {
+    uint32_t pos = Load(&enqueue_pos_);
+    while (true) {
+      Slot* slot = &slots_[pos & (kCapacity - 1)];
+      int32_t diff = static_cast<int32_t>(Load(&slot->sequence) - pos);
+      if (diff < 0)
+        return false;
+      if (diff > 0) {
+        // Another producer claimed |pos| meanwhile.
+        pos = Load(&enqueue_pos_);
+        continue;
+      }
+      uint32_t old_pos = static_cast<uint32_t>(rtc::AtomicOps::CompareAndSwap(
+          &enqueue_pos_, static_cast<int>(pos), static_cast<int>(pos + 1)));
+      if (old_pos == pos) {
+        slot->packet = packet;
+        rtc::AtomicOps::ReleaseStore(&slot->sequence,
+                                     static_cast<int>(pos + 1));
+        return true;
+      }
+      pos = old_pos;
+    }
+  }
+
+  // Also true while a packet is being pushed.
+  bool Empty() { return Load(&enqueue_pos_) == Load(&dequeue_pos_); }
+
+  // Takes out all pushed packets, in the order they were pushed. Must only be
+  // called by one thread at a time. The returned packets are valid until the
+  // next call.
+  std::vector<Packet>* PopAll() {
+    packets_.clear();
+    uint32_t pos = Load(&dequeue_pos_);
+    while (true) {
+      Slot* slot = &slots_[pos & (kCapacity - 1)];
+      if (Load(&slot->sequence) != pos + 1)
+        break;
+      packets_.push_back(slot->packet);
+      // Frees the slot for the producer claiming it on the next lap.
+      rtc::AtomicOps::ReleaseStore(&slot->sequence,
+                                   static_cast<int>(pos + kCapacity));
+      ++pos;
+    }
+    rtc::AtomicOps::ReleaseStore(&dequeue_pos_, static_cast<int>(pos));
+    return &packets_;
+  }
+
+ private:
+  struct Slot {
+    Slot()
+        : sequence(0),
+          packet(RtpPacketSender::kNormalPriority, 0, 0, 0, 0, 0, false, 0) {}
+
+    volatile int sequence;
+    Packet packet;
+  };
+
+  static uint32_t Load(volatile const int* value) {
+    return static_cast<uint32_t>(rtc::AtomicOps::AcquireLoad(value));
+  }
+
+  std::vector<Slot> slots_;
+  volatile int enqueue_pos_;
+  volatile int dequeue_pos_;
+  // Scratch space of PopAll, only touched by the consumer.
+  std::vector<Packet> packets_;
+};
+
 class IntervalBudget {
  public:
   explicit IntervalBudget(int initial_target_rate_kbps)
@@ -261,15 +360,24 @@ PacedSender::PacedSender(Clock* clock, PacketSender* packet_sender)
       pacing_bitrate_kbps_(0),
       time_last_update_us_(clock->TimeInMicroseconds()),
       packets_(new paced_sender::PacketQueue(clock)),
-      packet_counter_(0) {
+      packet_counter_(0),
+      ingress_(new paced_sender::IngressQueue()),
+      idle_(true),
+      lock_acquired_us_(0),
+      lock_hold_time_us_(0),
+      sleeping_(0),
+      process_thread_(nullptr) {
   UpdateBudgetWithElapsedTime(kMinPacketLimitMs);
 }
 
 PacedSender::~PacedSender() {}
 
 void PacedSender::CreateProbeCluster(int bitrate_bps) {
-  CriticalSectionScoped cs(critsect_.get());
-  prober_->CreateProbeCluster(bitrate_bps);
+  {
+    CriticalSectionScoped cs(critsect_.get());
+    prober_->CreateProbeCluster(bitrate_bps);
+  }
+  WakeUpIfSleeping();
 }
 
 void PacedSender::Pause() {
@@ -280,39 +388,49 @@ void PacedSender::Pause() {
 
 void PacedSender::Resume() {
   LOG(LS_INFO) << "PacedSender resumed.";
-  CriticalSectionScoped cs(critsect_.get());
-  paused_ = false;
+  {
+    CriticalSectionScoped cs(critsect_.get());
+    paused_ = false;
+  }
+  WakeUpIfSleeping();
 }
 
 void PacedSender::SetProbingEnabled(bool enabled) {
-  RTC_CHECK_EQ(0, packet_counter_);
   CriticalSectionScoped cs(critsect_.get());
+  DrainIngress();
+  RTC_CHECK_EQ(0, packet_counter_);
   prober_->SetEnabled(enabled);
 }
 
 void PacedSender::SetEstimatedBitrate(uint32_t bitrate_bps) {
   if (bitrate_bps == 0)
     LOG(LS_ERROR) << "PacedSender is not designed to handle 0 bitrate.";
-  CriticalSectionScoped cs(critsect_.get());
-  estimated_bitrate_bps_ = bitrate_bps;
-  padding_budget_->set_target_rate_kbps(
-      std::min(estimated_bitrate_bps_ / 1000, max_padding_bitrate_kbps_));
-  pacing_bitrate_kbps_ =
-      std::max(min_send_bitrate_kbps_, estimated_bitrate_bps_ / 1000) *
-      kDefaultPaceMultiplier;
-  alr_detector_->SetEstimatedBitrate(bitrate_bps);
+  {
+    CriticalSectionScoped cs(critsect_.get());
+    estimated_bitrate_bps_ = bitrate_bps;
+    padding_budget_->set_target_rate_kbps(
+        std::min(estimated_bitrate_bps_ / 1000, max_padding_bitrate_kbps_));
+    pacing_bitrate_kbps_ =
+        std::max(min_send_bitrate_kbps_, estimated_bitrate_bps_ / 1000) *
+        kDefaultPaceMultiplier;
+    alr_detector_->SetEstimatedBitrate(bitrate_bps);
+  }
+  WakeUpIfSleeping();
 }
 
 void PacedSender::SetSendBitrateLimits(int min_send_bitrate_bps,
                                        int padding_bitrate) {
-  CriticalSectionScoped cs(critsect_.get());
-  min_send_bitrate_kbps_ = min_send_bitrate_bps / 1000;
-  pacing_bitrate_kbps_ =
-      std::max(min_send_bitrate_kbps_, estimated_bitrate_bps_ / 1000) *
-      kDefaultPaceMultiplier;
-  max_padding_bitrate_kbps_ = padding_bitrate / 1000;
-  padding_budget_->set_target_rate_kbps(
-      std::min(estimated_bitrate_bps_ / 1000, max_padding_bitrate_kbps_));
+  {
+    CriticalSectionScoped cs(critsect_.get());
+    min_send_bitrate_kbps_ = min_send_bitrate_bps / 1000;
+    pacing_bitrate_kbps_ =
+        std::max(min_send_bitrate_kbps_, estimated_bitrate_bps_ / 1000) *
+        kDefaultPaceMultiplier;
+    max_padding_bitrate_kbps_ = padding_bitrate / 1000;
+    padding_budget_->set_target_rate_kbps(
+        std::min(estimated_bitrate_bps_ / 1000, max_padding_bitrate_kbps_));
+  }
+  WakeUpIfSleeping();
 }
 
 void PacedSender::InsertPacket(RtpPacketSender::Priority priority,
@@ -321,23 +439,27 @@ void PacedSender::InsertPacket(RtpPacketSender::Priority priority,
                                int64_t capture_time_ms,
                                size_t bytes,
                                bool retransmission) {
-  CriticalSectionScoped cs(critsect_.get());
-  RTC_DCHECK(estimated_bitrate_bps_ > 0)
-        << "SetEstimatedBitrate must be called before InsertPacket.";
-
   int64_t now_ms = clock_->TimeInMilliseconds();
-  prober_->OnIncomingPacket(bytes);
-
   if (capture_time_ms < 0)
     capture_time_ms = now_ms;
 
-  packets_->Push(paced_sender::Packet(priority, ssrc, sequence_number,
-                                      capture_time_ms, now_ms, bytes,
-                                      retransmission, packet_counter_++));
+  // The packet is only handed to the ingress queue here, without taking
+  // |critsect_|, and is moved into |packets_| by the next call holding it.
+  // The enqueue order is assigned then. If the queue is full, this thread
+  // makes room itself.
+  paced_sender::Packet packet(priority, ssrc, sequence_number,
+                              capture_time_ms, now_ms, bytes, retransmission,
+                              0);
+  while (!ingress_->Push(packet)) {
+    CriticalSectionScoped cs(critsect_.get());
+    DrainIngress();
+  }
+  WakeUpIfSleeping();
 }
 
 int64_t PacedSender::ExpectedQueueTimeMs() const {
   CriticalSectionScoped cs(critsect_.get());
+  DrainIngress();
   RTC_DCHECK_GT(pacing_bitrate_kbps_, 0);
   return static_cast<int64_t>(packets_->SizeInBytes() * 8 /
                               pacing_bitrate_kbps_);
@@ -351,11 +473,13 @@ rtc::Optional<int64_t> PacedSender::GetApplicationLimitedRegionStartTime()
 
 size_t PacedSender::QueueSizePackets() const {
   CriticalSectionScoped cs(critsect_.get());
+  DrainIngress();
   return packets_->SizeInPackets();
 }
 
 int64_t PacedSender::QueueInMs() const {
   CriticalSectionScoped cs(critsect_.get());
+  DrainIngress();
 
   int64_t oldest_packet = packets_->OldestEnqueueTimeMs();
   if (oldest_packet == 0)
@@ -366,12 +490,19 @@ int64_t PacedSender::QueueInMs() const {
 
 int64_t PacedSender::AverageQueueTimeMs() {
   CriticalSectionScoped cs(critsect_.get());
+  DrainIngress();
   packets_->UpdateQueueTime(clock_->TimeInMilliseconds());
   return packets_->AverageQueueTimeMs();
 }
 
+void PacedSender::ProcessThreadAttached(ProcessThread* process_thread) {
+  rtc::CritScope cs(&process_thread_lock_);
+  process_thread_ = process_thread;
+}
+
 int64_t PacedSender::TimeUntilNextProcess() {
   CriticalSectionScoped cs(critsect_.get());
+  DrainIngress();
   if (prober_->IsProbing()) {
     int64_t ret = prober_->TimeUntilNextProbe(clock_->TimeInMilliseconds());
     if (ret >= 0)
@@ -379,14 +510,31 @@ int64_t PacedSender::TimeUntilNextProcess() {
   }
   int64_t elapsed_time_us = clock_->TimeInMicroseconds() - time_last_update_us_;
   int64_t elapsed_time_ms = (elapsed_time_us + 500) / 1000;
-  return std::max<int64_t>(kMinPacketLimitMs - elapsed_time_ms, 0);
+  if (!IsIdle())
+    return std::max<int64_t>(kMinPacketLimitMs - elapsed_time_ms, 0);
+
+  // Nothing to send until a packet is inserted or the configuration changes,
+  // both of which wake up the process thread. The flag must be set before
+  // checking for packets, since inserting a packet checks it after pushing.
+  rtc::AtomicOps::CompareAndSwap(&sleeping_, 0, 1);
+  if (!ingress_->Empty()) {
+    rtc::AtomicOps::ReleaseStore(&sleeping_, 0);
+    return 0;
+  }
+  return std::max<int64_t>(kMaxIdleIntervalMs - elapsed_time_ms, 0);
 }
 
 void PacedSender::Process() {
   int64_t now_us = clock_->TimeInMicroseconds();
+  rtc::AtomicOps::ReleaseStore(&sleeping_, 0);
   CriticalSectionScoped cs(critsect_.get());
+  lock_acquired_us_ = rtc::TimeMicros();
+  lock_hold_time_us_ = 0;
+  DrainIngress();
   int64_t elapsed_time_ms = (now_us - time_last_update_us_ + 500) / 1000;
   time_last_update_us_ = now_us;
+  RTC_HISTOGRAM_COUNTS_1000("WebRTC.Pacer.ProcessIntervalMs",
+                            static_cast<int>(elapsed_time_ms));
   int target_bitrate_kbps = pacing_bitrate_kbps_;
   // TODO(holmer): Remove the !paused_ check when issue 5307 has been fixed.
   if (!paused_ && elapsed_time_ms > 0) {
@@ -406,6 +554,15 @@ void PacedSender::Process() {
 
     media_budget_->set_target_rate_kbps(target_bitrate_kbps);
 
+    if (idle_ && elapsed_time_ms > kMinPacketLimitMs) {
+      // Nothing has been sent since the last call, which may have been long
+      // ago. Pay back any overuse for that time, but don't let the budget
+      // grow past what it would have been if called every
+      // |kMinPacketLimitMs|.
+      UpdateBudgetWithElapsedTime(std::min(
+          kMaxIdleIntervalMs, elapsed_time_ms - kMinPacketLimitMs));
+      elapsed_time_ms = kMinPacketLimitMs;
+    }
     elapsed_time_ms = std::min(kMaxIntervalTimeMs, elapsed_time_ms);
     UpdateBudgetWithElapsedTime(elapsed_time_ms);
   }
@@ -453,6 +610,11 @@ void PacedSender::Process() {
   if (is_probing && bytes_sent > 0)
     prober_->ProbeSent(clock_->TimeInMilliseconds(), bytes_sent);
   alr_detector_->OnBytesSent(bytes_sent, now_us / 1000);
+
+  idle_ = IsIdle();
+  lock_hold_time_us_ += rtc::TimeMicros() - lock_acquired_us_;
+  RTC_HISTOGRAM_COUNTS_10000("WebRTC.Pacer.ProcessLockHoldTimeUs",
+                             static_cast<int>(lock_hold_time_us_));
 }
 
 bool PacedSender::SendPacket(const paced_sender::Packet& packet,
@@ -468,11 +630,13 @@ bool PacedSender::SendPacket(const paced_sender::Packet& packet,
       return false;
     }
   }
+  lock_hold_time_us_ += rtc::TimeMicros() - lock_acquired_us_;
   critsect_->Leave();
   const bool success = packet_sender_->TimeToSendPacket(
       packet.ssrc, packet.sequence_number, packet.capture_time_ms,
       packet.retransmission, probe_cluster_id);
   critsect_->Enter();
+  lock_acquired_us_ = rtc::TimeMicros();
 
   if (success) {
     // TODO(holmer): High priority packets should only be accounted for if we
@@ -487,10 +651,12 @@ bool PacedSender::SendPacket(const paced_sender::Packet& packet,
 }
 
 size_t PacedSender::SendPadding(size_t padding_needed, int probe_cluster_id) {
+  lock_hold_time_us_ += rtc::TimeMicros() - lock_acquired_us_;
   critsect_->Leave();
   size_t bytes_sent =
       packet_sender_->TimeToSendPadding(padding_needed, probe_cluster_id);
   critsect_->Enter();
+  lock_acquired_us_ = rtc::TimeMicros();
 
   if (bytes_sent > 0) {
     UpdateBudgetWithBytesSent(bytes_sent);
@@ -498,6 +664,37 @@ size_t PacedSender::SendPadding(size_t padding_needed, int probe_cluster_id) {
   return bytes_sent;
 }
 
+void PacedSender::DrainIngress() const {
+  std::vector<paced_sender::Packet>* packets = ingress_->PopAll();
+  for (paced_sender::Packet& packet : *packets) {
+    RTC_DCHECK(estimated_bitrate_bps_ > 0)
+        << "SetEstimatedBitrate must be called before InsertPacket.";
+    prober_->OnIncomingPacket(packet.bytes);
+    packet.enqueue_order = packet_counter_++;
+    packets_->Push(packet);
+  }
+}
+
+bool PacedSender::IsIdle() const {
+  if (!packets_->Empty() || prober_->IsProbing())
+    return false;
+  // Padding can only be sent once a normal packet has been sent.
+  return paused_ || packet_counter_ == 0 ||
+         padding_budget_->target_rate_kbps() == 0;
+}
+
+void PacedSender::WakeUpIfSleeping() {
+  if (rtc::AtomicOps::CompareAndSwap(&sleeping_, 1, 0) != 1)
+    return;
+  ProcessThread* process_thread;
+  {
+    rtc::CritScope cs(&process_thread_lock_);
+    process_thread = process_thread_;
+  }
+  if (process_thread)
+    process_thread->WakeUp(this);
+}
+
 void PacedSender::UpdateBudgetWithElapsedTime(int64_t delta_time_ms) {
   media_budget_->IncreaseBudget(delta_time_ms);
   padding_budget_->IncreaseBudget(delta_time_ms);
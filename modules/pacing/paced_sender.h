@@ -15,6 +15,7 @@
 #include <memory>
 #include <set>
 
+#include "webrtc/base/criticalsection.h"
 #include "webrtc/base/optional.h"
 #include "webrtc/base/thread_annotations.h"
 #include "webrtc/modules/include/module.h"
@@ -27,8 +28,10 @@ class BitrateProber;
 class Clock;
 class CriticalSectionWrapper;
 class ProbeClusterCreatedObserver;
+class ProcessThread;
 
 namespace paced_sender {
+class IngressQueue;
 class IntervalBudget;
 struct Packet;
 class PacketQueue;
@@ -105,6 +108,8 @@ class PacedSender : public Module, public RtpPacketSender {
 
   // Returns true if we send the packet now, else it will add the packet
   // information to the queue and call TimeToSendPacket when it's time to send.
+  // Doesn't take the lock held by Process(), so it can be called from any
+  // number of threads without contending with it.
   void InsertPacket(RtpPacketSender::Priority priority,
                     uint32_t ssrc,
                     uint16_t sequence_number,
@@ -134,13 +139,29 @@ class PacedSender : public Module, public RtpPacketSender {
   virtual int64_t AverageQueueTimeMs();
 
   // Returns the number of milliseconds until the module want a worker thread
-  // to call Process.
+  // to call Process. This is every few milliseconds while there are packets
+  // or padding to send, and more seldom otherwise. The process thread is
+  // woken up when a packet is inserted.
   int64_t TimeUntilNextProcess() override;
 
   // Process any pending packets in the queue(s).
+  // The time between calls and the time the lock is held, not counting the
+  // callbacks, are reported in the WebRTC.Pacer.ProcessIntervalMs and
+  // WebRTC.Pacer.ProcessLockHoldTimeUs histograms.
   void Process() override;
 
+  void ProcessThreadAttached(ProcessThread* process_thread) override;
+
  private:
+  // Moves the packets inserted since the last call into |packets_|.
+  void DrainIngress() const EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+
+  // Whether there is nothing to send until a packet is inserted.
+  bool IsIdle() const EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+
+  // Wakes up the process thread if TimeUntilNextProcess() let it sleep.
+  void WakeUpIfSleeping();
+
   // Updates the number of bytes that can be sent for the next time interval.
   void UpdateBudgetWithElapsedTime(int64_t delta_time_in_ms)
       EXCLUSIVE_LOCKS_REQUIRED(critsect_);
@@ -179,7 +200,23 @@ class PacedSender : public Module, public RtpPacketSender {
   int64_t time_last_update_us_ GUARDED_BY(critsect_);
 
   std::unique_ptr<paced_sender::PacketQueue> packets_ GUARDED_BY(critsect_);
-  uint64_t packet_counter_;
+  mutable uint64_t packet_counter_ GUARDED_BY(critsect_);
+
+  // Packets inserted but not yet moved into |packets_|. Pushed to without
+  // locking.
+  const std::unique_ptr<paced_sender::IngressQueue> ingress_;
+
+  // Whether there was nothing to send at the end of the last Process().
+  bool idle_ GUARDED_BY(critsect_);
+  // For the WebRTC.Pacer.ProcessLockHoldTimeUs histogram.
+  int64_t lock_acquired_us_ GUARDED_BY(critsect_);
+  int64_t lock_hold_time_us_ GUARDED_BY(critsect_);
+
+  // Set when TimeUntilNextProcess() lets the process thread sleep, cleared by
+  // whoever wakes it up.
+  volatile int sleeping_;
+  rtc::CriticalSection process_thread_lock_;
+  ProcessThread* process_thread_ GUARDED_BY(process_thread_lock_);
 };
 }  // namespace webrtc
 #endif  // WEBRTC_MODULES_PACING_PACED_SENDER_H_
@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/pacing/paced_sender.h"
+#include "webrtc/modules/utility/include/process_thread.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/system_wrappers/include/metrics_default.h"
+#include "webrtc/system_wrappers/include/sleep.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int kPacketsPerThread = 50000;
+const size_t kPacketSize = 1200;
+// High enough for the pacer to keep up with all inserting threads.
+const uint32_t kBitrateBps = 1000000000;
+
+class NullPacketSender : public PacedSender::PacketSender {
+ public:
+  bool TimeToSendPacket(uint32_t ssrc,
+                        uint16_t sequence_number,
+                        int64_t capture_time_ms,
+                        bool retransmission,
+                        int probe_cluster_id) override {
+    return true;
+  }
+  size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) override {
+    return 0;
+  }
+};
+
+// Returns the average of the samples added to histogram |name|, and clears
+// all histograms.
+int AverageSampleAndReset(const std::string& name) {
+  std::map<std::string, std::unique_ptr<metrics::SampleInfo>> histograms;
+  metrics::GetAndReset(&histograms);
+  auto it = histograms.find(name);
+  if (it == histograms.end())
+    return 0;
+  int64_t sum = 0;
+  int64_t count = 0;
+  for (const auto& sample : it->second->samples) {
+    sum += static_cast<int64_t>(sample.first) * sample.second;
+    count += sample.second;
+  }
+  return count > 0 ? static_cast<int>(sum / count) : 0;
+}
+
+struct Inserter {
+  static bool Run(void* obj) {
+    Inserter* inserter = static_cast<Inserter*>(obj);
+    int64_t start_ns = rtc::TimeNanos();
+    for (int i = 0; i < kPacketsPerThread; ++i) {
+      inserter->pacer->InsertPacket(PacedSender::kNormalPriority,
+                                    inserter->ssrc, static_cast<uint16_t>(i),
+                                    -1, kPacketSize, false);
+    }
+    inserter->elapsed_ns = rtc::TimeNanos() - start_ns;
+    return false;
+  }
+
+  PacedSender* pacer = nullptr;
+  uint32_t ssrc = 0;
+  int64_t elapsed_ns = 0;
+};
+
+// Inserts packets from |num_threads| threads while the pacer runs on its own
+// process thread, and reports the time per InsertPacket() call and how long
+// Process() held the lock.
+void RunInsertTest(int num_threads, const std::string& trace) {
+  NullPacketSender packet_sender;
+  PacedSender pacer(Clock::GetRealTimeClock(), &packet_sender);
+  pacer.SetProbingEnabled(false);
+  pacer.SetEstimatedBitrate(kBitrateBps);
+  std::unique_ptr<ProcessThread> process_thread =
+      ProcessThread::Create("PacerThread");
+  process_thread->RegisterModule(&pacer);
+  process_thread->Start();
+  metrics::Reset();
+
+  std::vector<Inserter> inserters(num_threads);
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    inserters[i].pacer = &pacer;
+    inserters[i].ssrc = 1000 + i;
+    threads.emplace_back(
+        new rtc::PlatformThread(&Inserter::Run, &inserters[i], "Inserter"));
+    threads.back()->Start();
+  }
+  int64_t elapsed_ns = 0;
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i]->Stop();
+    elapsed_ns += inserters[i].elapsed_ns;
+  }
+  process_thread->Stop();
+  process_thread->DeRegisterModule(&pacer);
+
+  test::PrintResult("insert_packet", "", trace,
+                    static_cast<size_t>(elapsed_ns /
+                                        (num_threads * kPacketsPerThread)),
+                    "ns/packet", true);
+  EXPECT_GT(metrics::NumSamples("WebRTC.Pacer.ProcessLockHoldTimeUs"), 0);
+  test::PrintResult(
+      "process_lock_hold_time", "", trace,
+      AverageSampleAndReset("WebRTC.Pacer.ProcessLockHoldTimeUs"), "us",
+      false);
+}
+
+}  // namespace
+
+TEST(PacedSenderPerformanceTest, InsertFromOneThread) {
+  RunInsertTest(1, "1_thread");
+}
+
+TEST(PacedSenderPerformanceTest, InsertFromFourThreads) {
+  RunInsertTest(4, "4_threads");
+}
+
+// Counts how often an idle pacer is processed.
+TEST(PacedSenderPerformanceTest, IdleWakeups) {
+  const int64_t kIdleTimeMs = 2000;
+  NullPacketSender packet_sender;
+  PacedSender pacer(Clock::GetRealTimeClock(), &packet_sender);
+  pacer.SetProbingEnabled(false);
+  pacer.SetEstimatedBitrate(300000);
+  std::unique_ptr<ProcessThread> process_thread =
+      ProcessThread::Create("PacerThread");
+  process_thread->RegisterModule(&pacer);
+  metrics::Reset();
+  process_thread->Start();
+  int64_t start_ms = rtc::TimeMillis();
+  while (rtc::TimeMillis() - start_ms < kIdleTimeMs)
+    SleepMs(100);
+  process_thread->Stop();
+  process_thread->DeRegisterModule(&pacer);
+
+  int wakeups = metrics::NumSamples("WebRTC.Pacer.ProcessIntervalMs");
+  test::PrintResult("idle_wakeups", "", "",
+                    static_cast<size_t>(wakeups * 1000 / kIdleTimeMs),
+                    "wakeups/s", true);
+  EXPECT_LT(wakeups, kIdleTimeMs / 5);
+}
+
+}  // namespace webrtc
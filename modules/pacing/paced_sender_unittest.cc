@@ -10,9 +10,13 @@
 
 #include <list>
 #include <memory>
+#include <vector>
 
+#include "webrtc/base/platform_thread.h"
 #include "webrtc/modules/pacing/paced_sender.h"
+#include "webrtc/modules/utility/include/mock/mock_process_thread.h"
 #include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/system_wrappers/include/metrics_default.h"
 #include "webrtc/test/gmock.h"
 #include "webrtc/test/gtest.h"
 
@@ -33,6 +37,7 @@ namespace webrtc {
 namespace test {
 
 static const int kTargetBitrateBps = 800000;
+static const int64_t kMaxIdleIntervalMs = 100;
 
 class MockPacedSenderCallback : public PacedSender::PacketSender {
  public:
@@ -216,9 +221,9 @@ TEST_F(PacedSenderTest, PaceQueuedPackets) {
     send_bucket_->Process();
   }
   EXPECT_EQ(0u, send_bucket_->QueueSizePackets());
-  EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
+  // Nothing left to send, so no need to process again soon.
+  EXPECT_EQ(kMaxIdleIntervalMs, send_bucket_->TimeUntilNextProcess());
   clock_.AdvanceTimeMilliseconds(5);
-  EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
   EXPECT_EQ(0u, send_bucket_->QueueSizePackets());
   send_bucket_->Process();
 
@@ -273,9 +278,8 @@ TEST_F(PacedSenderTest, PaceQueuedPacketsWithDuplicates) {
     EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
     send_bucket_->Process();
   }
-  EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
+  EXPECT_EQ(kMaxIdleIntervalMs, send_bucket_->TimeUntilNextProcess());
   clock_.AdvanceTimeMilliseconds(5);
-  EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
   send_bucket_->Process();
 
   for (size_t i = 0; i < packets_to_send_per_interval; ++i) {
@@ -677,14 +681,14 @@ TEST_F(PacedSenderTest, Pause) {
   }
   send_bucket_->Resume();
 
-  for (size_t i = 0; i < 4; i++) {
-    EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
-    clock_.AdvanceTimeMilliseconds(5);
-    EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
-    send_bucket_->Process();
-  }
+  // The packets have been queued for so long that they are all sent at once.
+  EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
+  clock_.AdvanceTimeMilliseconds(5);
+  EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
+  send_bucket_->Process();
 
   EXPECT_EQ(0, send_bucket_->QueueInMs());
+  EXPECT_EQ(kMaxIdleIntervalMs, send_bucket_->TimeUntilNextProcess());
 }
 
 TEST_F(PacedSenderTest, ResendPacket) {
@@ -1037,5 +1041,150 @@ TEST_F(PacedSenderTest, ProbeClusterId) {
   send_bucket_->Process();
 }
 
+TEST_F(PacedSenderTest, WakesUpProcessThreadWhenPacketInsertedWhileIdle) {
+  MockProcessThread process_thread;
+  send_bucket_->ProcessThreadAttached(&process_thread);
+  send_bucket_->Process();
+  EXPECT_EQ(kMaxIdleIntervalMs, send_bucket_->TimeUntilNextProcess());
+
+  // Only the first packet inserted while idle wakes up the process thread.
+  EXPECT_CALL(process_thread, WakeUp(send_bucket_.get())).Times(1);
+  send_bucket_->InsertPacket(PacedSender::kNormalPriority, 12345, 1234,
+                             clock_.TimeInMilliseconds(), 250, false);
+  send_bucket_->InsertPacket(PacedSender::kNormalPriority, 12345, 1235,
+                             clock_.TimeInMilliseconds(), 250, false);
+  EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
+
+  // Not idle, so there is no need to wake up the process thread.
+  testing::Mock::VerifyAndClearExpectations(&process_thread);
+  EXPECT_CALL(process_thread, WakeUp(_)).Times(0);
+  send_bucket_->InsertPacket(PacedSender::kNormalPriority, 12345, 1236,
+                             clock_.TimeInMilliseconds(), 250, false);
+  EXPECT_EQ(3u, send_bucket_->QueueSizePackets());
+
+  send_bucket_->ProcessThreadAttached(nullptr);
+}
+
+TEST_F(PacedSenderTest, KeepsProcessingWhileSendingPadding) {
+  send_bucket_->SetSendBitrateLimits(kTargetBitrateBps, kTargetBitrateBps);
+  send_bucket_->Process();
+  EXPECT_EQ(kMaxIdleIntervalMs, send_bucket_->TimeUntilNextProcess());
+
+  // Padding can be sent once a packet has been sent.
+  SendAndExpectPacket(PacedSender::kNormalPriority, 12345, 1234,
+                      clock_.TimeInMilliseconds(), 250, false);
+  send_bucket_->Process();
+  EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
+
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _))
+      .Times(1)
+      .WillOnce(Return(250));
+  clock_.AdvanceTimeMilliseconds(5);
+  send_bucket_->Process();
+  EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
+
+  send_bucket_->Pause();
+  clock_.AdvanceTimeMilliseconds(5);
+  send_bucket_->Process();
+  EXPECT_EQ(kMaxIdleIntervalMs, send_bucket_->TimeUntilNextProcess());
+}
+
+TEST_F(PacedSenderTest, BudgetDoesNotGrowWhileIdle) {
+  const size_t packets_to_send_per_interval =
+      kTargetBitrateBps * PacedSender::kDefaultPaceMultiplier / (8 * 250 * 200);
+  send_bucket_->Process();
+  clock_.AdvanceTimeMilliseconds(kMaxIdleIntervalMs);
+
+  // After being idle, as many packets are sent as after |kMinPacketLimitMs|.
+  uint16_t sequence_number = 1234;
+  for (size_t i = 0; i < packets_to_send_per_interval; ++i) {
+    SendAndExpectPacket(PacedSender::kNormalPriority, 12345, sequence_number++,
+                        clock_.TimeInMilliseconds(), 250, false);
+  }
+  send_bucket_->InsertPacket(PacedSender::kNormalPriority, 12345,
+                             sequence_number, clock_.TimeInMilliseconds(), 250,
+                             false);
+  send_bucket_->Process();
+  EXPECT_EQ(1u, send_bucket_->QueueSizePackets());
+}
+
+TEST_F(PacedSenderTest, KeepsOrderOfMorePacketsThanIngressSlots) {
+  const uint16_t kNumPackets = 3000;
+  std::vector<uint16_t> sent;
+  EXPECT_CALL(callback_, TimeToSendPacket(12345, _, _, false, _))
+      .WillRepeatedly(testing::Invoke(
+          [&sent](uint32_t ssrc, uint16_t sequence_number,
+                  int64_t capture_time_ms, bool retransmission,
+                  int probe_cluster_id) {
+            sent.push_back(sequence_number);
+            return true;
+          }));
+  int64_t capture_time_ms = clock_.TimeInMilliseconds();
+  for (uint16_t i = 0; i < kNumPackets; ++i) {
+    send_bucket_->InsertPacket(PacedSender::kNormalPriority, 12345, i,
+                               capture_time_ms, 250, false);
+  }
+  EXPECT_EQ(kNumPackets, send_bucket_->QueueSizePackets());
+
+  while (send_bucket_->QueueSizePackets() > 0) {
+    clock_.AdvanceTimeMilliseconds(send_bucket_->TimeUntilNextProcess());
+    send_bucket_->Process();
+  }
+  ASSERT_EQ(kNumPackets, sent.size());
+  for (uint16_t i = 0; i < kNumPackets; ++i)
+    EXPECT_EQ(i, sent[i]);
+}
+
+TEST_F(PacedSenderTest, InsertsPacketsFromManyThreads) {
+  const int kNumThreads = 4;
+  const int kPacketsPerThread = 1000;
+  struct Inserter {
+    static bool Run(void* obj) {
+      Inserter* inserter = static_cast<Inserter*>(obj);
+      for (int i = 0; i < kPacketsPerThread; ++i) {
+        inserter->pacer->InsertPacket(PacedSender::kNormalPriority,
+                                      inserter->ssrc, static_cast<uint16_t>(i),
+                                      -1, 250, false);
+      }
+      return false;
+    }
+    PacedSender* pacer;
+    uint32_t ssrc;
+  };
+
+  send_bucket_->Pause();
+  Inserter inserters[kNumThreads];
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    inserters[i].pacer = send_bucket_.get();
+    inserters[i].ssrc = 1000 + i;
+    threads.emplace_back(
+        new rtc::PlatformThread(&Inserter::Run, &inserters[i], "Inserter"));
+    threads.back()->Start();
+  }
+  // Process concurrently with the inserting threads.
+  for (int i = 0; i < 100; ++i) {
+    clock_.AdvanceTimeMilliseconds(5);
+    send_bucket_->Process();
+  }
+  for (auto& thread : threads)
+    thread->Stop();
+
+  EXPECT_EQ(static_cast<size_t>(kNumThreads * kPacketsPerThread),
+            send_bucket_->QueueSizePackets());
+}
+
+TEST_F(PacedSenderTest, ReportsProcessHistograms) {
+  send_bucket_->Process();
+  metrics::Reset();
+  for (int i = 0; i < 10; ++i) {
+    clock_.AdvanceTimeMilliseconds(5);
+    send_bucket_->Process();
+  }
+  EXPECT_EQ(10, metrics::NumSamples("WebRTC.Pacer.ProcessIntervalMs"));
+  EXPECT_EQ(10, metrics::NumEvents("WebRTC.Pacer.ProcessIntervalMs", 5));
+  EXPECT_EQ(10, metrics::NumSamples("WebRTC.Pacer.ProcessLockHoldTimeUs"));
+}
+
 }  // namespace test
 }  // namespace webrtc
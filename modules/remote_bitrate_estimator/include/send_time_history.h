@@ -11,15 +11,14 @@
 #ifndef WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_INCLUDE_SEND_TIME_HISTORY_H_
 #define WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_INCLUDE_SEND_TIME_HISTORY_H_
 
-#include <map>
-
 #include "webrtc/base/basictypes.h"
 #include "webrtc/base/constructormagic.h"
 #include "webrtc/modules/include/module_common_types.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/video_coding/sequence_number_util.h"
 
 namespace webrtc {
 class Clock;
-struct PacketInfo;
 
 class SendTimeHistory {
  public:
@@ -45,8 +44,7 @@ class SendTimeHistory {
  private:
   Clock* const clock_;
   const int64_t packet_age_limit_ms_;
-  SequenceNumberUnwrapper seq_num_unwrapper_;
-  std::map<int64_t, PacketInfo> history_;
+  SeqNumMap<uint16_t, PacketInfo> history_;
 
   RTC_DISALLOW_IMPLICIT_CONSTRUCTORS(SendTimeHistory);
 };
@@ -135,15 +135,14 @@ void RemoteEstimatorProxy::OnPacketArrival(uint16_t sequence_number,
     return;
   }
 
-  if (packet_arrival_times_.lower_bound(window_start_seq_) ==
-      packet_arrival_times_.end()) {
+  if (packet_arrival_times_.lower_bound(static_cast<uint16_t>(
+          window_start_seq_)) == packet_arrival_times_.end()) {
     // Start new feedback packet, cull old packets.
     for (auto it = packet_arrival_times_.begin();
-         it != packet_arrival_times_.end() && it->first < seq &&
+         it != packet_arrival_times_.end() &&
+         AheadOf(sequence_number, it->first) &&
          arrival_time - it->second >= kBackWindowMs;) {
-      auto delete_it = it;
-      ++it;
-      packet_arrival_times_.erase(delete_it);
+      it = packet_arrival_times_.erase(it);
     }
   }
 
@@ -154,10 +153,7 @@ void RemoteEstimatorProxy::OnPacketArrival(uint16_t sequence_number,
   }
 
   // We are only interested in the first time a packet is received.
-  if (packet_arrival_times_.find(seq) != packet_arrival_times_.end())
-    return;
-
-  packet_arrival_times_[seq] = arrival_time;
+  packet_arrival_times_.insert(std::make_pair(sequence_number, arrival_time));
 }
 
 bool RemoteEstimatorProxy::BuildFeedbackPacket(
@@ -166,7 +162,8 @@ bool RemoteEstimatorProxy::BuildFeedbackPacket(
   // feedback packet. Some older may still be in the map, in case a reordering
   // happens and we need to retransmit them.
   rtc::CritScope cs(&lock_);
-  auto it = packet_arrival_times_.lower_bound(window_start_seq_);
+  auto it =
+      packet_arrival_times_.lower_bound(static_cast<uint16_t>(window_start_seq_));
   if (it == packet_arrival_times_.end()) {
     // Feedback for all packets already sent.
     return false;
@@ -174,7 +171,7 @@ bool RemoteEstimatorProxy::BuildFeedbackPacket(
 
   // TODO(sprang): Measure receive times in microseconds and remove the
   // conversions below.
-  const int64_t first_sequence = it->first;
+  const uint16_t first_sequence = it->first;
   feedback_packet->SetMediaSsrc(media_ssrc_);
   // Base sequence is the expected next (window_start_seq_). This is known, but
   // we might not have actually received it, so the base time shall be the time
@@ -183,8 +180,7 @@ bool RemoteEstimatorProxy::BuildFeedbackPacket(
                            it->second * 1000);
   feedback_packet->SetFeedbackSequenceNumber(feedback_sequence_++);
   for (; it != packet_arrival_times_.end(); ++it) {
-    if (!feedback_packet->AddReceivedPacket(
-            static_cast<uint16_t>(it->first & 0xFFFF), it->second * 1000)) {
+    if (!feedback_packet->AddReceivedPacket(it->first, it->second * 1000)) {
       // If we can't even add the first seq to the feedback packet, we won't be
       // able to build it at all.
       RTC_CHECK_NE(first_sequence, it->first);
@@ -197,7 +193,8 @@ bool RemoteEstimatorProxy::BuildFeedbackPacket(
     // Note: Don't erase items from packet_arrival_times_ after sending, in case
     // they need to be re-sent after a reordering. Removal will be handled
     // by OnPacketArrival once packets are too old.
-    window_start_seq_ = it->first + 1;
+    window_start_seq_ +=
+        ForwardDiff(static_cast<uint16_t>(window_start_seq_), it->first) + 1;
   }
 
   return true;
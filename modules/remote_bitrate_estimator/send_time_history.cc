@@ -38,20 +38,18 @@ void SendTimeHistory::AddAndRemoveOld(uint16_t sequence_number,
   }
 
   // Add new.
-  int64_t unwrapped_seq_num = seq_num_unwrapper_.Unwrap(sequence_number);
   int64_t creation_time_ms = now_ms;
   constexpr int64_t kNoArrivalTimeMs = -1;  // Arrival time is ignored.
   constexpr int64_t kNoSendTimeMs = -1;     // Send time is set by OnSentPacket.
   history_.insert(std::make_pair(
-      unwrapped_seq_num,
+      sequence_number,
       PacketInfo(creation_time_ms, kNoArrivalTimeMs, kNoSendTimeMs,
                  sequence_number, payload_size, probe_cluster_id)));
 }
 
 bool SendTimeHistory::OnSentPacket(uint16_t sequence_number,
                                    int64_t send_time_ms) {
-  int64_t unwrapped_seq_num = seq_num_unwrapper_.Unwrap(sequence_number);
-  auto it = history_.find(unwrapped_seq_num);
+  auto it = history_.find(sequence_number);
   if (it == history_.end())
     return false;
   it->second.send_time_ms = send_time_ms;
@@ -60,9 +58,7 @@ bool SendTimeHistory::OnSentPacket(uint16_t sequence_number,
 
 bool SendTimeHistory::GetInfo(PacketInfo* packet_info, bool remove) {
   RTC_DCHECK(packet_info);
-  int64_t unwrapped_seq_num =
-      seq_num_unwrapper_.Unwrap(packet_info->sequence_number);
-  auto it = history_.find(unwrapped_seq_num);
+  auto it = history_.find(packet_info->sequence_number);
   if (it == history_.end())
     return false;
 
@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/random.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/bitrate_controller/include/mock/mock_bitrate_controller.h"
+#include "webrtc/modules/congestion_controller/transport_feedback_adapter.h"
+#include "webrtc/modules/pacing/packet_router.h"
+#include "webrtc/modules/remote_bitrate_estimator/remote_estimator_proxy.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet/transport_feedback.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/gmock.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int kPacketsPerSecond = 10000;
+const int kDurationSeconds = 20;
+const size_t kPayloadSize = 1200;
+const uint32_t kMediaSsrc = 0x1234;
+
+class BitrateControllerStub : public test::MockBitrateController {
+ public:
+  void OnDelayBasedBweResult(const DelayBasedBwe::Result& result) override {}
+};
+
+// Hands the feedback built by the RemoteEstimatorProxy straight to the
+// TransportFeedbackAdapter, and measures the time it takes to handle it.
+class FeedbackLoopback : public PacketRouter {
+ public:
+  explicit FeedbackLoopback(TransportFeedbackAdapter* adapter)
+      : adapter_(adapter), elapsed_ns_(0), num_feedbacks_(0) {}
+
+  bool SendFeedback(rtcp::TransportFeedback* packet) override {
+    int64_t start_ns = rtc::TimeNanos();
+    adapter_->OnTransportFeedback(*packet);
+    elapsed_ns_ += rtc::TimeNanos() - start_ns;
+    ++num_feedbacks_;
+    return true;
+  }
+
+  int64_t elapsed_ns() const { return elapsed_ns_; }
+  int num_feedbacks() const { return num_feedbacks_; }
+
+ private:
+  TransportFeedbackAdapter* const adapter_;
+  int64_t elapsed_ns_;
+  int num_feedbacks_;
+};
+
+// Sends |kPacketsPerSecond| packets per second for |kDurationSeconds|, and
+// delivers them out of order within windows of |reorder_window| packets,
+// dropping |loss_percent| percent of them. Reports the time spent per packet
+// recording sent packets, recording received packets and building feedback,
+// and handling the feedback on the send side.
+void RunFeedbackTest(int reorder_window,
+                     int loss_percent,
+                     const std::string& trace) {
+  SimulatedClock clock(0);
+  testing::NiceMock<BitrateControllerStub> bitrate_controller;
+  TransportFeedbackAdapter adapter(&clock, &bitrate_controller);
+  adapter.InitBwe();
+  FeedbackLoopback loopback(&adapter);
+  RemoteEstimatorProxy proxy(&clock, &loopback);
+  Random random(0x5eed);
+
+  const int num_packets = kPacketsPerSecond * kDurationSeconds;
+  std::vector<uint16_t> arrival_order;
+  arrival_order.reserve(num_packets);
+  for (int i = 0; i < num_packets; ++i)
+    arrival_order.push_back(static_cast<uint16_t>(i));
+  for (int start = 0; start + reorder_window <= num_packets;
+       start += reorder_window) {
+    for (int i = start + reorder_window - 1; i > start; --i) {
+      std::swap(arrival_order[i],
+                arrival_order[start + random.Rand(0, i - start)]);
+    }
+  }
+
+  RTPHeader header;
+  header.ssrc = kMediaSsrc;
+  header.extension.hasTransportSequenceNumber = true;
+  int64_t send_ns = 0;
+  int64_t receive_ns = 0;
+  // Packets are received as soon as they are sent, one window later.
+  for (int i = 0; i < num_packets + reorder_window; ++i) {
+    if (i < num_packets) {
+      uint16_t sequence_number = static_cast<uint16_t>(i);
+      int64_t start_ns = rtc::TimeNanos();
+      adapter.AddPacket(sequence_number, kPayloadSize, PacketInfo::kNotAProbe);
+      adapter.OnSentPacket(sequence_number, clock.TimeInMilliseconds());
+      send_ns += rtc::TimeNanos() - start_ns;
+    }
+
+    int received = i - reorder_window;
+    if (received >= 0 && random.Rand(0, 99) >= loss_percent) {
+      header.extension.transportSequenceNumber = arrival_order[received];
+      int64_t start_ns = rtc::TimeNanos();
+      proxy.IncomingPacket(clock.TimeInMilliseconds(), kPayloadSize, header);
+      receive_ns += rtc::TimeNanos() - start_ns;
+    }
+
+    if ((i + 1) % (kPacketsPerSecond / 1000) == 0)
+      clock.AdvanceTimeMilliseconds(1);
+    if (proxy.TimeUntilNextProcess() <= 0) {
+      int64_t start_ns = rtc::TimeNanos();
+      proxy.Process();
+      // The feedback is handled in Process(), but timed separately.
+      receive_ns += rtc::TimeNanos() - start_ns;
+    }
+  }
+  receive_ns -= loopback.elapsed_ns();
+
+  test::PrintResult("send_time_history", "", trace,
+                    static_cast<size_t>(send_ns / num_packets), "ns/packet",
+                    true);
+  test::PrintResult("remote_estimator_proxy", "", trace,
+                    static_cast<size_t>(receive_ns / num_packets), "ns/packet",
+                    true);
+  test::PrintResult("transport_feedback_adapter", "", trace,
+                    static_cast<size_t>(loopback.elapsed_ns() / num_packets),
+                    "ns/packet", true);
+  EXPECT_GT(loopback.num_feedbacks(), 0);
+  EXPECT_FALSE(adapter.GetTransportFeedbackVector().empty());
+}
+
+}  // namespace
+
+TEST(TransportFeedbackPerformanceTest, InOrder) {
+  RunFeedbackTest(1, 0, "in_order");
+}
+
+TEST(TransportFeedbackPerformanceTest, Reordered) {
+  RunFeedbackTest(16, 0, "reordered");
+}
+
+TEST(TransportFeedbackPerformanceTest, ReorderedWithLoss) {
+  RunFeedbackTest(16, 5, "reordered_with_loss");
+}
+
+}  // namespace webrtc
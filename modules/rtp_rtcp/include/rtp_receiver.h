@@ -11,6 +11,8 @@
 #ifndef WEBRTC_MODULES_RTP_RTCP_INCLUDE_RTP_RECEIVER_H_
 #define WEBRTC_MODULES_RTP_RTCP_INCLUDE_RTP_RECEIVER_H_
 
+#include <vector>
+
 #include "webrtc/config.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "webrtc/typedefs.h"
@@ -91,8 +93,11 @@ class RtpReceiver {
   // Returns the current energy of the RTP stream received.
   virtual int32_t Energy(uint8_t array_of_energy[kRtpCsrcSize]) const = 0;
   
-  // Double PERC stuff
+  // Double PERC stuff. Calling it again rotates the key, packets protected
+  // with the previous one are still accepted for a grace period.
   virtual bool EnableMediaCrypto(const MediaCryptoKey &key) = 0;
+  // Returns decryption counters of every remote SSRC seen so far.
+  virtual std::vector<MediaCryptoStats> GetMediaCryptoStats() const = 0;
 };
 }  // namespace webrtc
 
@@ -96,6 +96,8 @@ class RtpRtcp : public Module {
     // End to end media encryption
     bool media_crypto_enabled = false;
     const MediaCryptoKey* media_crypto_key;
+    // Number of extra threads used to encrypt large video frames.
+    size_t media_crypto_workers = 0;
 
    private:
     RTC_DISALLOW_COPY_AND_ASSIGN(Configuration);
@@ -207,6 +209,15 @@ class RtpRtcp : public Module {
   // Returns the FlexFEC SSRC, if there is one.
   virtual rtc::Optional<uint32_t> FlexfecSsrc() const = 0;
 
+  // Installs a new end to end media key. If one is already in use, the new
+  // key takes over at the next frame.
+  virtual bool SetMediaCryptoKey(const MediaCryptoKey& key) = 0;
+
+  // Returns the number of packets protected with the end to end key.
+  // Retransmissions, FEC and padding reuse the protected payload stored in the
+  // packet history and are not encrypted again.
+  virtual MediaCryptoStats GetMediaCryptoStats() const = 0;
+
   // Sets sending status. Sends kRtcpByeCode when going from true to false.
   // Returns -1 on failure else 0.
   virtual int32_t SetSendingStatus(bool sending) = 0;
@@ -246,6 +246,8 @@ class RtcpBandwidthObserver {
 };
 
 struct PacketInfo {
+  PacketInfo() : PacketInfo(-1, -1, -1, 0, 0, kNotAProbe) {}
+
   PacketInfo(int64_t arrival_time_ms, uint16_t sequence_number)
       : PacketInfo(-1,
                    arrival_time_ms,
@@ -84,6 +84,8 @@ class MockRtpRtcp : public RtpRtcp {
   MOCK_METHOD1(SetRtxSsrc, void(uint32_t));
   MOCK_METHOD2(SetRtxSendPayloadType, void(int, int));
   MOCK_CONST_METHOD0(FlexfecSsrc, rtc::Optional<uint32_t>());
+  MOCK_METHOD1(SetMediaCryptoKey, bool(const MediaCryptoKey& key));
+  MOCK_CONST_METHOD0(GetMediaCryptoStats, MediaCryptoStats());
   MOCK_CONST_METHOD0(RtxSendPayloadType, std::pair<int, int>());
   MOCK_METHOD1(SetSendingStatus, int32_t(bool sending));
   MOCK_CONST_METHOD0(Sending, bool());
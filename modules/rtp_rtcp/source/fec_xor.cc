@@ -0,0 +1,58 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/fec_xor.h"
+
+#include <string.h>
+
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace internal {
+
+void XorBytes(const uint8_t* src, size_t length, uint8_t* dst) {
+// If we know the minimum architecture at compile time, avoid CPU detection.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#if defined(__SSE2__)
+  XorBytes_SSE2(src, length, dst);
+#else
+  // x86 CPU detection required.
+  static const bool have_sse2 = WebRtc_GetCPUInfo(kSSE2) != 0;
+  if (have_sse2) {
+    XorBytes_SSE2(src, length, dst);
+  } else {
+    XorBytes_C(src, length, dst);
+  }
+#endif
+#elif defined(WEBRTC_HAS_NEON)
+  XorBytes_NEON(src, length, dst);
+#else
+  XorBytes_C(src, length, dst);
+#endif
+}
+
+void XorBytes_C(const uint8_t* src, size_t length, uint8_t* dst) {
+  // A word at a time. Going through memcpy allows unaligned buffers, and
+  // compiles to plain loads and stores.
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+    uint64_t src_word;
+    uint64_t dst_word;
+    memcpy(&src_word, src + i, sizeof(src_word));
+    memcpy(&dst_word, dst + i, sizeof(dst_word));
+    dst_word ^= src_word;
+    memcpy(dst + i, &dst_word, sizeof(dst_word));
+  }
+  for (; i < length; ++i)
+    dst[i] ^= src[i];
+}
+
+}  // namespace internal
+}  // namespace webrtc
@@ -0,0 +1,44 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/fec_xor.h"
+
+#include <emmintrin.h>
+
+namespace webrtc {
+namespace internal {
+
+void XorBytes_SSE2(const uint8_t* src, size_t length, uint8_t* dst) {
+  size_t i = 0;
+  // Four registers at a time, which covers a typical payload in about 20
+  // iterations.
+  for (; i + 64 <= length; i += 64) {
+    const __m128i* s = reinterpret_cast<const __m128i*>(src + i);
+    __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+    __m128i x0 = _mm_xor_si128(_mm_loadu_si128(d), _mm_loadu_si128(s));
+    __m128i x1 = _mm_xor_si128(_mm_loadu_si128(d + 1), _mm_loadu_si128(s + 1));
+    __m128i x2 = _mm_xor_si128(_mm_loadu_si128(d + 2), _mm_loadu_si128(s + 2));
+    __m128i x3 = _mm_xor_si128(_mm_loadu_si128(d + 3), _mm_loadu_si128(s + 3));
+    _mm_storeu_si128(d, x0);
+    _mm_storeu_si128(d + 1, x1);
+    _mm_storeu_si128(d + 2, x2);
+    _mm_storeu_si128(d + 3, x3);
+  }
+  for (; i + 16 <= length; i += 16) {
+    const __m128i* s = reinterpret_cast<const __m128i*>(src + i);
+    __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+    _mm_storeu_si128(d, _mm_xor_si128(_mm_loadu_si128(d), _mm_loadu_si128(s)));
+  }
+  for (; i < length; ++i)
+    dst[i] ^= src[i];
+}
+
+}  // namespace internal
+}  // namespace webrtc
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "webrtc/base/random.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/fec_xor.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+namespace internal {
+namespace {
+
+constexpr size_t kGuardSize = 32;
+constexpr uint8_t kGuardByte = 0xa5;
+
+typedef void (*XorBytesFunction)(const uint8_t*, size_t, uint8_t*);
+
+// Checks |xor_bytes| against XORing a byte at a time, for all |lengths| and
+// all combinations of misaligned source and destination, and that no bytes
+// outside of the destination are written.
+void VerifyXorBytes(XorBytesFunction xor_bytes,
+                    const std::vector<size_t>& lengths) {
+  Random random(0x7a3);
+  for (size_t length : lengths) {
+    for (size_t src_offset = 0; src_offset < 16; src_offset += 3) {
+      for (size_t dst_offset = 0; dst_offset < 16; dst_offset += 5) {
+        std::vector<uint8_t> src(src_offset + length);
+        std::vector<uint8_t> dst(dst_offset + length + kGuardSize, kGuardByte);
+        for (uint8_t& byte : src)
+          byte = random.Rand<uint8_t>();
+        for (size_t i = 0; i < length; ++i)
+          dst[dst_offset + i] = random.Rand<uint8_t>();
+        std::vector<uint8_t> expected = dst;
+        for (size_t i = 0; i < length; ++i)
+          expected[dst_offset + i] ^= src[src_offset + i];
+
+        xor_bytes(src.data() + src_offset, length, dst.data() + dst_offset);
+        ASSERT_EQ(expected, dst) << "length " << length << ", src offset "
+                                 << src_offset << ", dst offset "
+                                 << dst_offset;
+      }
+    }
+  }
+}
+
+std::vector<size_t> TestLengths() {
+  std::vector<size_t> lengths;
+  for (size_t length = 0; length <= 300; ++length)
+    lengths.push_back(length);
+  for (size_t length = 1000; length <= IP_PACKET_SIZE; length += 37)
+    lengths.push_back(length);
+  lengths.push_back(IP_PACKET_SIZE);
+  return lengths;
+}
+
+}  // namespace
+
+TEST(FecXorTest, XorBytes) {
+  VerifyXorBytes(&XorBytes, TestLengths());
+}
+
+TEST(FecXorTest, XorBytes_C) {
+  VerifyXorBytes(&XorBytes_C, TestLengths());
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+TEST(FecXorTest, XorBytes_SSE2) {
+  if (!WebRtc_GetCPUInfo(kSSE2))
+    return;
+  VerifyXorBytes(&XorBytes_SSE2, TestLengths());
+}
+#endif
+
+#if defined(WEBRTC_HAS_NEON)
+TEST(FecXorTest, XorBytes_NEON) {
+  VerifyXorBytes(&XorBytes_NEON, TestLengths());
+}
+#endif
+
+}  // namespace internal
+}  // namespace webrtc
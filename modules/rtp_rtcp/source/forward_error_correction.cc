@@ -20,6 +20,7 @@
 #include "webrtc/base/logging.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/modules/rtp_rtcp/source/fec_xor.h"
 #include "webrtc/modules/rtp_rtcp/source/flexfec_header_reader_writer.h"
 #include "webrtc/modules/rtp_rtcp/source/forward_error_correction_internal.h"
 #include "webrtc/modules/rtp_rtcp/source/ulpfec_header_reader_writer.h"
@@ -29,6 +30,34 @@ namespace webrtc {
 namespace {
 // Transport header size in bytes. Assume UDP/IPv4 as a reasonable minimum.
 constexpr size_t kTransportOverhead = 28;
+
+// Loads up to eight bytes of a packet mask into a word, such that the first
+// bit of the mask is the most significant bit of the word. The set bits can
+// then be found with CountLeadingZeros() instead of testing every bit.
+uint64_t LoadPacketMaskWord(const uint8_t* packet_mask, size_t size) {
+  RTC_DCHECK_LE(size, sizeof(uint64_t));
+  uint64_t word = 0;
+  for (size_t i = 0; i < size; ++i)
+    word |= static_cast<uint64_t>(packet_mask[i]) << (56 - 8 * i);
+  return word;
+}
+
+// Number of leading zero bits of |word|, which must not be zero.
+int CountLeadingZeros(uint64_t word) {
+  RTC_DCHECK_NE(word, 0u);
+#ifdef __GNUC__
+  return __builtin_clzll(word);
+#else
+  int count = 0;
+  while (!(word >> 63)) {
+    word <<= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+constexpr uint64_t kHighestBit = uint64_t{1} << 63;
 }  // namespace
 
 ForwardErrorCorrection::Packet::Packet() : length(0), data(), ref_count_(0) {}
@@ -186,21 +215,37 @@ void ForwardErrorCorrection::GenerateFecPayloads(
     const PacketList& media_packets,
     size_t num_fec_packets) {
   RTC_DCHECK(!media_packets.empty());
+  RTC_DCHECK_LE(packet_mask_size_, sizeof(uint64_t));
+  // The media packet of each bit in the packet masks, so that only the media
+  // packets protected by an FEC packet have to be visited. There are no media
+  // packets for the zeros inserted for missing sequence numbers.
+  Packet* media_packets_by_mask_bit[kUlpfecMaxMediaPackets] = {};
+  const uint16_t first_seq_num =
+      ParseSequenceNumber(media_packets.front()->data);
+  for (const auto& media_packet : media_packets) {
+    size_t mask_bit = static_cast<uint16_t>(
+        ParseSequenceNumber(media_packet->data) - first_seq_num);
+    if (mask_bit >= kUlpfecMaxMediaPackets)
+      break;
+    media_packets_by_mask_bit[mask_bit] = media_packet.get();
+  }
+
   for (size_t i = 0; i < num_fec_packets; ++i) {
     Packet* const fec_packet = &generated_fec_packets_[i];
-    size_t pkt_mask_idx = i * packet_mask_size_;
-    const size_t min_packet_mask_size = fec_header_writer_->MinPacketMaskSize(
-        &packet_masks_[pkt_mask_idx], packet_mask_size_);
+    const uint8_t* packet_mask = &packet_masks_[i * packet_mask_size_];
+    const size_t min_packet_mask_size =
+        fec_header_writer_->MinPacketMaskSize(packet_mask, packet_mask_size_);
     const size_t fec_header_size =
         fec_header_writer_->FecHeaderSize(min_packet_mask_size);
 
-    size_t media_pkt_idx = 0;
-    auto media_packets_it = media_packets.cbegin();
-    uint16_t prev_seq_num = ParseSequenceNumber((*media_packets_it)->data);
-    while (media_packets_it != media_packets.end()) {
-      Packet* const media_packet = media_packets_it->get();
-      // Should |media_packet| be protected by |fec_packet|?
-      if (packet_masks_[pkt_mask_idx] & (1 << (7 - media_pkt_idx))) {
+    // Visit the media packets protected by |fec_packet|, in order.
+    uint64_t mask_word = LoadPacketMaskWord(packet_mask, packet_mask_size_);
+    while (mask_word != 0) {
+      const int mask_bit = CountLeadingZeros(mask_word);
+      mask_word &= ~(kHighestBit >> mask_bit);
+      Packet* const media_packet = media_packets_by_mask_bit[mask_bit];
+      RTC_DCHECK(media_packet) << "Packet mask is wrong or poorly designed.";
+      if (media_packet) {
         size_t media_payload_length = media_packet->length - kRtpHeaderSize;
 
         bool first_protected_packet = (fec_packet->length == 0);
@@ -230,14 +275,6 @@ void ForwardErrorCorrection::GenerateFecPayloads(
                       fec_packet);
         }
       }
-      media_packets_it++;
-      if (media_packets_it != media_packets.end()) {
-        uint16_t seq_num = ParseSequenceNumber((*media_packets_it)->data);
-        media_pkt_idx += static_cast<uint16_t>(seq_num - prev_seq_num);
-        prev_seq_num = seq_num;
-      }
-      pkt_mask_idx += media_pkt_idx / 8;
-      media_pkt_idx %= 8;
     }
     RTC_DCHECK_GT(fec_packet->length, 0)
         << "Packet mask is wrong or poorly designed.";
@@ -395,21 +432,24 @@ void ForwardErrorCorrection::InsertFecPacket(
   if (!ret) {
     return;
   }
-  // Parse packet mask from header and represent as protected packets.
-  for (uint16_t byte_idx = 0; byte_idx < fec_packet->packet_mask_size;
-       ++byte_idx) {
-    uint8_t packet_mask =
-        fec_packet->pkt->data[fec_packet->packet_mask_offset + byte_idx];
-    for (uint16_t bit_idx = 0; bit_idx < 8; ++bit_idx) {
-      if (packet_mask & (1 << (7 - bit_idx))) {
-        std::unique_ptr<ProtectedPacket> protected_packet(
-            new ProtectedPacket());
-        // This wraps naturally with the sequence number.
-        protected_packet->seq_num = static_cast<uint16_t>(
-            fec_packet->seq_num_base + (byte_idx << 3) + bit_idx);
-        protected_packet->pkt = nullptr;
-        fec_packet->protected_packets.push_back(std::move(protected_packet));
-      }
+  // Parse packet mask from header and represent as protected packets. The
+  // mask is gone through a word at a time, only visiting the set bits.
+  const uint8_t* packet_mask =
+      &fec_packet->pkt->data[fec_packet->packet_mask_offset];
+  for (size_t byte_idx = 0; byte_idx < fec_packet->packet_mask_size;
+       byte_idx += sizeof(uint64_t)) {
+    uint64_t mask_word = LoadPacketMaskWord(
+        &packet_mask[byte_idx],
+        std::min(sizeof(uint64_t), fec_packet->packet_mask_size - byte_idx));
+    while (mask_word != 0) {
+      const int bit_idx = CountLeadingZeros(mask_word);
+      mask_word &= ~(kHighestBit >> bit_idx);
+      std::unique_ptr<ProtectedPacket> protected_packet(new ProtectedPacket());
+      // This wraps naturally with the sequence number.
+      protected_packet->seq_num = static_cast<uint16_t>(
+          fec_packet->seq_num_base + (byte_idx << 3) + bit_idx);
+      protected_packet->pkt = nullptr;
+      fec_packet->protected_packets.push_back(std::move(protected_packet));
     }
   }
   if (fec_packet->protected_packets.empty()) {
@@ -580,9 +620,8 @@ void ForwardErrorCorrection::XorPayloads(const Packet& src,
   // XOR the payload.
   RTC_DCHECK_LE(kRtpHeaderSize + payload_length, sizeof(src.data));
   RTC_DCHECK_LE(dst_offset + payload_length, sizeof(dst->data));
-  for (size_t i = 0; i < payload_length; ++i) {
-    dst->data[dst_offset + i] ^= src.data[kRtpHeaderSize + i];
-  }
+  internal::XorBytes(&src.data[kRtpHeaderSize], payload_length,
+                     &dst->data[dst_offset]);
 }
 
 bool ForwardErrorCorrection::RecoverPacket(const ReceivedFecPacket& fec_packet,
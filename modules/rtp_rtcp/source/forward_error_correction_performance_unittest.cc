@@ -0,0 +1,187 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/random.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/modules/rtp_rtcp/source/fec_test_helper.h"
+#include "webrtc/modules/rtp_rtcp/source/forward_error_correction.h"
+#include "webrtc/modules/rtp_rtcp/source/forward_error_correction_internal.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+// Transport header size in bytes. Assume UDP/IPv4 as a reasonable minimum.
+constexpr size_t kTransportOverhead = 28;
+constexpr uint32_t kMediaSsrc = 83542;
+constexpr int kNumFrames = 1000;
+// High protection, where the XOR work dominates.
+constexpr uint8_t kProtectionFactor = 255;
+
+using PacketList = ForwardErrorCorrection::PacketList;
+
+// The FEC payload protecting the media packets in |packet_mask|, XORed a byte
+// at a time, and a bit of the mask at a time.
+std::vector<uint8_t> ReferenceFecPayload(const PacketList& media_packets,
+                                         const uint8_t* packet_mask) {
+  std::vector<uint8_t> payload;
+  int bit = 0;
+  for (const auto& media_packet : media_packets) {
+    if (packet_mask[bit / 8] & (0x80 >> (bit % 8))) {
+      size_t payload_length = media_packet->length - kRtpHeaderSize;
+      payload.resize(std::max(payload.size(), payload_length));
+      for (size_t i = 0; i < payload_length; ++i)
+        payload[i] ^= media_packet->data[kRtpHeaderSize + i];
+    }
+    ++bit;
+  }
+  return payload;
+}
+
+// Encodes FEC for |kNumFrames| frames of |num_media_packets| packets, checks
+// that the FEC payloads are the same as the reference ones, and that a lost
+// media packet is recovered. Reports the time spent encoding and decoding.
+void RunFecTest(std::unique_ptr<ForwardErrorCorrection> fec,
+                FecMaskType fec_mask_type,
+                int num_media_packets,
+                const std::string& modifier) {
+  Random random(0x5eed);
+  test::fec::MediaPacketGenerator media_packet_generator(
+      kRtpHeaderSize,
+      IP_PACKET_SIZE - kRtpHeaderSize - kTransportOverhead -
+          fec->MaxPacketOverhead(),
+      kMediaSsrc, &random);
+  const int num_fec_packets =
+      ForwardErrorCorrection::NumFecPackets(num_media_packets,
+                                            kProtectionFactor);
+  const internal::PacketMaskTable mask_table(fec_mask_type, num_media_packets);
+  const size_t packet_mask_size = internal::PacketMaskSize(num_media_packets);
+  std::vector<uint8_t> packet_masks(num_fec_packets * packet_mask_size);
+  internal::GeneratePacketMasks(num_media_packets, num_fec_packets, 0, false,
+                                mask_table, packet_masks.data());
+
+  int64_t encode_ns = 0;
+  int64_t decode_ns = 0;
+  int64_t num_fec_bytes = 0;
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    PacketList media_packets =
+        media_packet_generator.ConstructMediaPackets(num_media_packets);
+    std::list<ForwardErrorCorrection::Packet*> fec_packets;
+    int64_t start_ns = rtc::TimeNanos();
+    ASSERT_EQ(0, fec->EncodeFec(media_packets, kProtectionFactor, 0, false,
+                                fec_mask_type, &fec_packets));
+    encode_ns += rtc::TimeNanos() - start_ns;
+    ASSERT_EQ(static_cast<size_t>(num_fec_packets), fec_packets.size());
+
+    int row = 0;
+    for (const ForwardErrorCorrection::Packet* fec_packet : fec_packets) {
+      std::vector<uint8_t> reference = ReferenceFecPayload(
+          media_packets, &packet_masks[row * packet_mask_size]);
+      ASSERT_GE(fec_packet->length, reference.size());
+      const size_t fec_header_size = fec_packet->length - reference.size();
+      ASSERT_EQ(0, memcmp(reference.data(), &fec_packet->data[fec_header_size],
+                          reference.size()))
+          << "FEC packet " << row << " of frame " << frame;
+      num_fec_bytes += fec_packet->length;
+      ++row;
+    }
+
+    // Lose one media packet, and recover it from all FEC packets.
+    const int lost_index = frame % num_media_packets;
+    ForwardErrorCorrection::ReceivedPacketList received_packets;
+    int index = 0;
+    for (const auto& media_packet : media_packets) {
+      if (index++ == lost_index)
+        continue;
+      std::unique_ptr<ForwardErrorCorrection::ReceivedPacket> received_packet(
+          new ForwardErrorCorrection::ReceivedPacket());
+      received_packet->pkt = new ForwardErrorCorrection::Packet(*media_packet);
+      received_packet->is_fec = false;
+      received_packet->seq_num =
+          ByteReader<uint16_t>::ReadBigEndian(&media_packet->data[2]);
+      received_packets.push_back(std::move(received_packet));
+    }
+    uint16_t fec_seq_num = media_packet_generator.GetFecSeqNum();
+    for (const ForwardErrorCorrection::Packet* fec_packet : fec_packets) {
+      std::unique_ptr<ForwardErrorCorrection::ReceivedPacket> received_packet(
+          new ForwardErrorCorrection::ReceivedPacket());
+      received_packet->pkt = new ForwardErrorCorrection::Packet(*fec_packet);
+      received_packet->is_fec = true;
+      received_packet->seq_num = fec_seq_num++;
+      received_packet->ssrc = kMediaSsrc;
+      received_packets.push_back(std::move(received_packet));
+    }
+
+    ForwardErrorCorrection::RecoveredPacketList recovered_packets;
+    start_ns = rtc::TimeNanos();
+    ASSERT_EQ(0, fec->DecodeFec(&received_packets, &recovered_packets));
+    decode_ns += rtc::TimeNanos() - start_ns;
+
+    const ForwardErrorCorrection::Packet& lost_packet =
+        **std::next(media_packets.begin(), lost_index);
+    auto recovered = std::find_if(
+        recovered_packets.begin(), recovered_packets.end(),
+        [&lost_packet](
+            const std::unique_ptr<ForwardErrorCorrection::RecoveredPacket>&
+                recovered_packet) {
+          return recovered_packet->seq_num ==
+                 ByteReader<uint16_t>::ReadBigEndian(&lost_packet.data[2]);
+        });
+    ASSERT_TRUE(recovered != recovered_packets.end());
+    ASSERT_EQ(lost_packet.length, (*recovered)->pkt->length);
+    ASSERT_EQ(0, memcmp(lost_packet.data, (*recovered)->pkt->data,
+                        lost_packet.length));
+    fec->ResetState(&recovered_packets);
+  }
+
+  const std::string trace = std::to_string(num_media_packets) + "_packets";
+  test::PrintResult("fec_encode", modifier, trace,
+                    static_cast<size_t>(encode_ns / kNumFrames), "ns/frame",
+                    true);
+  test::PrintResult("fec_encode_throughput", modifier, trace,
+                    static_cast<size_t>(num_fec_bytes * 1000 /
+                                        std::max<int64_t>(encode_ns, 1)),
+                    "MB/s", false);
+  test::PrintResult("fec_decode", modifier, trace,
+                    static_cast<size_t>(decode_ns / kNumFrames), "ns/frame",
+                    true);
+}
+
+}  // namespace
+
+TEST(ForwardErrorCorrectionPerformanceTest, UlpfecRandomMasks) {
+  for (int num_media_packets : {4, 12, 24, 48}) {
+    RunFecTest(ForwardErrorCorrection::CreateUlpfec(), kFecMaskRandom,
+               num_media_packets, "_ulpfec_random");
+  }
+}
+
+TEST(ForwardErrorCorrectionPerformanceTest, UlpfecBurstyMasks) {
+  for (int num_media_packets : {4, 12, 24, 48}) {
+    RunFecTest(ForwardErrorCorrection::CreateUlpfec(), kFecMaskBursty,
+               num_media_packets, "_ulpfec_bursty");
+  }
+}
+
+TEST(ForwardErrorCorrectionPerformanceTest, FlexfecRandomMasks) {
+  for (int num_media_packets : {4, 12, 24, 48}) {
+    RunFecTest(ForwardErrorCorrection::CreateFlexfec(), kFecMaskRandom,
+               num_media_packets, "_flexfec_random");
+  }
+}
+
+}  // namespace webrtc
@@ -12,11 +12,20 @@
 
 #include <string.h>
 
+#include <algorithm>
+
 #include "third_party/libsrtp/include/srtp.h"
+#include "webrtc/base/atomicops.h"
 #include "webrtc/base/base64.h"
 #include "webrtc/base/buffer.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/base/event.h"
 #include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
 #include "webrtc/modules/rtp_rtcp/source/media_crypto.h"
+#include "webrtc/modules/rtp_rtcp/source/media_crypto_aead.h"
+#include "webrtc/system_wrappers/include/field_trial.h"
 
 /* OHB data
  *   0                   1                   2                   3
@@ -32,6 +41,75 @@
 static size_t ohb_size = 11;
 
 namespace webrtc {
+
+namespace {
+// Frames smaller than this are not worth the thread hop to a worker.
+const size_t kMinPacketsPerWorker = 16;
+// More workers do not pay off for the few dozen packets of a video frame.
+const size_t kMaxWorkers = 8;
+// Replay window limits supported by libsrtp.
+const int kMinReplayWindowSize = 64;
+const int kMaxReplayWindowSize = 0x8000;
+// The inner RTP header is a fixed header byte followed by the OHB.
+const size_t kInnerHeaderSize = 1 + 11;
+// Contexts of unknown senders dropped before authenticating a packet, per
+// period, before new ones are refused for the rest of the period.
+const int kMaxDroppedPendingContexts = 64;
+const int64_t kPendingContextPeriodMs = 1000;
+
+size_t InboundSlot(uint32_t ssrc) {
+  // Fibonacci hashing, SSRCs are random but keep it cheap anyway.
+  return (ssrc * 2654435761u) >> (32 - 9);
+}
+
+bool SetCryptoPolicy(int cs, srtp_policy_t* policy) {
+  if (cs == rtc::SRTP_AES128_CM_SHA1_80) {
+    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy->rtp);
+    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy->rtcp);
+  } else if (cs == rtc::SRTP_AES128_CM_SHA1_32) {
+    // RTP HMAC is shortened to 32 bits, but RTCP remains 80 bits.
+    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy->rtp);
+    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy->rtcp);
+  } else if (cs == rtc::SRTP_AEAD_AES_128_GCM ) {
+    srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy->rtp);
+    srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy->rtcp);
+  } else if (cs == rtc::SRTP_AEAD_AES_256_GCM ) {
+    srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy->rtp);
+    srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy->rtcp);
+  } else {
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+struct MediaCrypto::Worker {
+  Worker() : queue("MediaCryptoWorker"), done(false, false), result(false) {}
+  rtc::TaskQueue queue;
+  rtc::Event done;
+  bool result;
+};
+
+struct MediaCrypto::InboundContext {
+  // Either |session| or |window| is set, depending on the engine in use.
+  InboundContext(uint32_t ssrc,
+                 srtp_ctx_t_* session,
+                 std::unique_ptr<MediaCryptoReplayWindow> window)
+      : ssrc(ssrc), session(session), window(std::move(window)), packets(0),
+        replay_drops(0), auth_failures(0), last_used(0) {}
+  ~InboundContext() {
+    if (session)
+      srtp_dealloc(session);
+  }
+  const uint32_t ssrc;
+  srtp_ctx_t_* const session;
+  const std::unique_ptr<MediaCryptoReplayWindow> window;
+  volatile int packets;
+  volatile int replay_drops;
+  volatile int auth_failures;
+  // Value of |inbound_clock_| when the context last decrypted a packet.
+  uint32_t last_used;
+};
   
   
 bool MediaCryptoKey::Parse(int crypto_suite, const std::string &str) {
@@ -71,30 +149,54 @@ bool MediaCryptoKey::Parse(int crypto_suite, const std::string &str) {
   return true;
 }
   
+const size_t MediaCrypto::kMaxInboundContexts;
+
 MediaCrypto::MediaCrypto()
-    : session_(nullptr),
+    : use_aead_(webrtc::field_trial::FindFullName("WebRTC-MediaCryptoAead") ==
+                "Enabled"),
+      session_(nullptr),
       rtp_auth_tag_len_(0),
-      rtcp_auth_tag_len_(0) {
+      rtcp_auth_tag_len_(0),
+      ssrc_type_(0),
+      crypto_suite_(0),
+      replay_window_size_(kDefaultMediaCryptoReplayWindowSize),
+      inbound_clock_(0),
+      num_inbound_contexts_(0),
+      next_pending_inbound_(0),
+      pending_period_start_ms_(rtc::TimeMillis()),
+      num_dropped_pending_contexts_(0) {
+  static_assert(kInboundSlots == 1 << 9,
+                "InboundSlot must hash to kInboundSlots");
+  static_assert(kMaxInboundContexts <= kInboundSlots / 2,
+                "Keep the inbound table at most half full");
+  for (size_t i = 0; i < kInboundSlots; ++i)
+    inbound_[i] = nullptr;
 }
 
 MediaCrypto::~MediaCrypto() {
+  // Stop worker queues before releasing the state they use.
+  workers_.clear();
   if (session_) {
     srtp_dealloc(session_);
   }
+  for (size_t i = 0; i < kInboundSlots; ++i)
+    delete inbound_[i];
 }
 bool MediaCrypto::SetOutboundKey(const MediaCryptoKey& key) {
   LOG(LS_ERROR) << "E2E media encryption oubound key set";
+  replay_window_size_ = key.replay_window_size;
   return SetKey(ssrc_any_outbound, key.type, key.buffer.data(), key.buffer.size());
 }
 
 bool MediaCrypto::SetInboundKey(const MediaCryptoKey& key) {
   LOG(LS_INFO) << "E2E media encryption inbound key set";
+  replay_window_size_ = key.replay_window_size;
   return SetKey(ssrc_any_inbound, key.type, key.buffer.data(), key.buffer.size());
 }
 
 bool MediaCrypto::SetKey(int type, int cs, const uint8_t* key, size_t len) {
 
-  if (session_) {
+  if (!key_.empty()) {
     LOG(LS_ERROR) << "Failed to create SRTP session: "
                   << "SRTP session already created";
     return false;
@@ -102,20 +204,7 @@ bool MediaCrypto::SetKey(int type, int cs, const uint8_t* key, size_t len) {
 
   srtp_policy_t policy;
   memset(&policy, 0, sizeof(policy));
-  if (cs == rtc::SRTP_AES128_CM_SHA1_80) {
-    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtp);
-    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtcp);
-  } else if (cs == rtc::SRTP_AES128_CM_SHA1_32) {
-    // RTP HMAC is shortened to 32 bits, but RTCP remains 80 bits.
-    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy.rtp);
-    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtcp);
-  } else if (cs == rtc::SRTP_AEAD_AES_128_GCM ) {
-    srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy.rtp);
-    srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy.rtcp);
-  } else if (cs == rtc::SRTP_AEAD_AES_256_GCM ) {
-    srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy.rtp);
-    srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy.rtcp);
-  } else {
+  if (!SetCryptoPolicy(cs, &policy)) {
     LOG(LS_WARNING) << "Failed to create SRTP session: unsupported"
                     << " cipher_suite " << cs;
     return false;
@@ -137,29 +226,232 @@ bool MediaCrypto::SetKey(int type, int cs, const uint8_t* key, size_t len) {
     return false;
   }
 
-  policy.ssrc.type = static_cast<srtp_ssrc_type_t>(type);
-  policy.ssrc.value = 0;
-  policy.key = const_cast<uint8_t*>(key);
+  if (replay_window_size_ < kMinReplayWindowSize ||
+      replay_window_size_ >= kMaxReplayWindowSize) {
+    LOG(LS_WARNING) << "Failed to create SRTP session: invalid replay"
+                    << " window size " << replay_window_size_;
+    return false;
+  }
+
+  // Keep the key around to create worker and per SSRC inbound sessions
+  ssrc_type_ = type;
+  crypto_suite_ = cs;
+  key_.assign(key, key + len);
+  rtp_auth_tag_len_ = policy.rtp.auth_tag_len;
+  rtcp_auth_tag_len_ = policy.rtcp.auth_tag_len;
+
+  if (use_aead_ && MediaCryptoAead::IsSupported(cs)) {
+    aead_ = MediaCryptoAead::Create(cs, key, len);
+    if (!aead_) {
+      LOG(LS_ERROR) << "Failed to create AEAD media crypto context";
+      key_.clear();
+      return false;
+    }
+    RTC_DCHECK_EQ(static_cast<size_t>(rtp_auth_tag_len_),
+                  aead_->tag_length());
+    LOG(LS_INFO) << "Using AEAD engine for E2E media crypto";
+    return true;
+  }
+
+  // Inbound sessions are created per SSRC on the first packet received
+  if (type == ssrc_any_inbound)
+    return true;
+
+  session_ = CreateSession(0);
+  if (!session_) {
+    key_.clear();
+    return false;
+  }
+  return true;
+}
+
+srtp_ctx_t_* MediaCrypto::CreateSession(uint32_t ssrc) {
+  srtp_policy_t policy;
+  memset(&policy, 0, sizeof(policy));
+  SetCryptoPolicy(crypto_suite_, &policy);
+  if (ssrc_type_ == ssrc_any_inbound) {
+    policy.ssrc.type = ssrc_specific;
+    policy.ssrc.value = ssrc;
+  } else {
+    policy.ssrc.type = static_cast<srtp_ssrc_type_t>(ssrc_type_);
+    policy.ssrc.value = 0;
+  }
+  policy.key = key_.data();
   // TODO(astor) parse window size from WSH session-param
-  policy.window_size = 1024;
+  policy.window_size = replay_window_size_;
   policy.allow_repeat_tx = 1;
 
   policy.next = nullptr;
 
-  int err = srtp_create(&session_, &policy);
+  srtp_ctx_t_* session = nullptr;
+  int err = srtp_create(&session, &policy);
   if (err != srtp_err_status_ok) {
-    session_ = nullptr;
     LOG(LS_ERROR) << "Failed to create SRTP session, err=" << err;
+    return nullptr;
+  }
+  return session;
+}
+
+MediaCrypto::InboundContext* MediaCrypto::FindInboundContext(uint32_t ssrc) {
+  // Open addressing with linear probing. The table is only changed by the
+  // decrypting thread, so its own lookups need no lock.
+  for (size_t slot = InboundSlot(ssrc); inbound_[slot];
+       slot = (slot + 1) & (kInboundSlots - 1)) {
+    if (inbound_[slot]->ssrc == ssrc)
+      return inbound_[slot];
+  }
+  return nullptr;
+}
+
+std::unique_ptr<MediaCrypto::InboundContext> MediaCrypto::CreateInboundContext(
+    uint32_t ssrc) {
+  srtp_ctx_t_* session = nullptr;
+  std::unique_ptr<MediaCryptoReplayWindow> window;
+  if (aead_) {
+    window.reset(new MediaCryptoReplayWindow(replay_window_size_));
+  } else {
+    session = CreateSession(ssrc);
+    if (!session)
+      return nullptr;
+  }
+  return std::unique_ptr<InboundContext>(
+      new InboundContext(ssrc, session, std::move(window)));
+}
+
+MediaCrypto::InboundContext* MediaCrypto::GetPendingInboundContext(
+    uint32_t ssrc,
+    size_t* slot) {
+  size_t free_slot = kMaxPendingInboundContexts;
+  for (size_t i = 0; i < kMaxPendingInboundContexts; ++i) {
+    if (!pending_inbound_[i]) {
+      if (free_slot == kMaxPendingInboundContexts)
+        free_slot = i;
+    } else if (pending_inbound_[i]->ssrc == ssrc) {
+      *slot = i;
+      return pending_inbound_[i].get();
+    }
+  }
+
+  // Take a free slot, or drop the oldest pending context, as long as not too
+  // many were dropped lately. Forged SSRCs would otherwise cost a key setup
+  // per packet.
+  if (free_slot == kMaxPendingInboundContexts) {
+    int64_t now_ms = rtc::TimeMillis();
+    if (now_ms - pending_period_start_ms_ >= kPendingContextPeriodMs) {
+      pending_period_start_ms_ = now_ms;
+      num_dropped_pending_contexts_ = 0;
+    }
+    if (num_dropped_pending_contexts_ == kMaxDroppedPendingContexts) {
+      LOG(LS_WARNING) << "Too many unauthenticated E2E media crypto senders,"
+                      << " dropping packet for ssrc " << ssrc;
+      return nullptr;
+    }
+    ++num_dropped_pending_contexts_;
+    free_slot = next_pending_inbound_;
+    next_pending_inbound_ =
+        (next_pending_inbound_ + 1) % kMaxPendingInboundContexts;
+  }
+  pending_inbound_[free_slot] = CreateInboundContext(ssrc);
+  *slot = free_slot;
+  return pending_inbound_[free_slot].get();
+}
+
+void MediaCrypto::AddInboundContext(std::unique_ptr<InboundContext> context) {
+  rtc::CritScope lock(&inbound_crit_);
+  if (num_inbound_contexts_ == kMaxInboundContexts) {
+    // Evict the sender that has been idle the longest. Its replay window goes
+    // with it, should it come back it starts over like a new sender.
+    size_t lru = kInboundSlots;
+    for (size_t i = 0; i < kInboundSlots; ++i) {
+      if (inbound_[i] &&
+          (lru == kInboundSlots ||
+           inbound_clock_ - inbound_[i]->last_used >
+               inbound_clock_ - inbound_[lru]->last_used)) {
+        lru = i;
+      }
+    }
+    LOG(LS_INFO) << "Evicted E2E media crypto context for ssrc "
+                 << inbound_[lru]->ssrc;
+    RemoveInboundContext(lru);
+  }
+  LOG(LS_INFO) << "Created E2E media crypto context for ssrc "
+               << context->ssrc;
+  size_t slot = InboundSlot(context->ssrc);
+  while (inbound_[slot])
+    slot = (slot + 1) & (kInboundSlots - 1);
+  inbound_[slot] = context.release();
+  ++num_inbound_contexts_;
+}
+
+void MediaCrypto::RemoveInboundContext(size_t slot) {
+  delete inbound_[slot];
+  inbound_[slot] = nullptr;
+  --num_inbound_contexts_;
+  // Move later contexts of the probe sequence back into the hole, unless
+  // that would put them before their own slot, so lookups still find them.
+  const size_t kMask = kInboundSlots - 1;
+  size_t hole = slot;
+  for (size_t i = (slot + 1) & kMask; inbound_[i]; i = (i + 1) & kMask) {
+    size_t home = InboundSlot(inbound_[i]->ssrc);
+    if (((i - home) & kMask) >= ((i - hole) & kMask)) {
+      inbound_[hole] = inbound_[i];
+      inbound_[i] = nullptr;
+      hole = i;
+    }
+  }
+}
+
+size_t MediaCrypto::GetNumInboundContexts() const {
+  rtc::CritScope lock(&inbound_crit_);
+  return num_inbound_contexts_;
+}
+
+std::vector<MediaCryptoStats> MediaCrypto::GetInboundStats() const {
+  rtc::CritScope lock(&inbound_crit_);
+  std::vector<MediaCryptoStats> stats;
+  for (size_t i = 0; i < kInboundSlots; ++i) {
+    const InboundContext* context = inbound_[i];
+    if (!context)
+      continue;
+    MediaCryptoStats entry;
+    entry.ssrc = context->ssrc;
+    entry.packets = rtc::AtomicOps::AcquireLoad(&context->packets);
+    entry.replay_drops = rtc::AtomicOps::AcquireLoad(&context->replay_drops);
+    entry.auth_failures = rtc::AtomicOps::AcquireLoad(&context->auth_failures);
+    stats.push_back(entry);
+  }
+  return stats;
+}
+
+bool MediaCrypto::EnableWorkers(size_t num_workers) {
+  if ((!session_ && !aead_) || !workers_.empty()) {
+    LOG(LS_ERROR) << "Failed to enable media crypto workers: "
+                  << "no SRTP session or workers already enabled";
     return false;
   }
+  // libsrtp estimates the rollover counter from the packets each session has
+  // seen, so sessions sharing the key would disagree on packet indexes and
+  // reuse them. Only the AEAD engine, which is given the index of every
+  // packet, can split a frame.
+  if (!aead_) {
+    LOG(LS_INFO) << "Media crypto workers need the AEAD engine, encrypting "
+                 << "frames on the calling thread";
+    return true;
+  }
+  num_workers = std::min(num_workers, kMaxWorkers);
 
-  rtp_auth_tag_len_ = policy.rtp.auth_tag_len;
-  rtcp_auth_tag_len_ = policy.rtcp.auth_tag_len;
+  // The AEAD context is stateless and shared by all workers.
+  for (size_t i = 0; i < num_workers; ++i)
+    workers_.push_back(std::unique_ptr<Worker>(new Worker()));
   return true;
 }
 
-bool MediaCrypto::ProtectRtp(void* p, int in_len, int max_len, int* out_len) {
-  if (!session_) {
+bool MediaCrypto::ProtectRtp(srtp_ctx_t_* session,
+                             void* p,
+                             int in_len,
+                             int max_len,
+                             int* out_len) {
+  if (!session) {
     LOG(LS_WARNING) << "Failed to protect SRTP packet: no SRTP Session";
     return false;
   }
@@ -172,7 +464,7 @@ bool MediaCrypto::ProtectRtp(void* p, int in_len, int max_len, int* out_len) {
   }
 
   *out_len = in_len;
-  int err = srtp_protect(session_, p, out_len);
+  int err = srtp_protect(session, p, out_len);
   if (err != srtp_err_status_ok) {
     LOG(LS_WARNING) << "Failed to encrypt double packet";
     return false;
@@ -181,22 +473,83 @@ bool MediaCrypto::ProtectRtp(void* p, int in_len, int max_len, int* out_len) {
 }
 
 
-bool MediaCrypto::UnprotectRtp(void* p, int in_len, int* out_len) {
+bool MediaCrypto::UnprotectRtp(InboundContext* context,
+                               void* p,
+                               int in_len,
+                               int* out_len) {
   
-  if (!session_) {
+  if (!context) {
     LOG(LS_WARNING) << "Failed to unprotect SRTP packet: no SRTP Session";
     return false;
   }
 
+  if (aead_)
+    return OpenRtp(context, static_cast<uint8_t*>(p), in_len, out_len);
+
   *out_len = in_len;
-  int err = srtp_unprotect(session_, p, out_len);
+  int err = srtp_unprotect(context->session, p, out_len);
 
-  if (err == srtp_err_status_replay_fail) {
-     LOG(LS_WARNING) << "Replay failed";
+  // libsrtp leaves the payload encrypted on replay failures, so drop them.
+  if (err == srtp_err_status_replay_fail ||
+      err == srtp_err_status_replay_old) {
+    rtc::AtomicOps::Increment(&context->replay_drops);
+    LOG(LS_WARNING) << "Replay failed for ssrc " << context->ssrc;
+    return false;
+  } else if (err == srtp_err_status_auth_fail) {
+    rtc::AtomicOps::Increment(&context->auth_failures);
+    LOG(LS_WARNING) << "Failed to authenticate SRTP packet for ssrc "
+                    << context->ssrc;
+    return false;
   } else if (err != srtp_err_status_ok) {
     LOG(LS_WARNING) << "Failed to unprotect SRTP packet, err=" << err;
     return false;
   }
+  rtc::AtomicOps::Increment(&context->packets);
+  return true;
+}
+
+bool MediaCrypto::OpenRtp(InboundContext* context,
+                          uint8_t* p,
+                          int in_len,
+                          int* out_len) {
+  // Same checks and counters as the libsrtp path above.
+  uint16_t seq_num = ByteReader<uint16_t>::ReadBigEndian(p + 2);
+  uint64_t index;
+  int32_t delta = context->window->Estimate(seq_num, &index);
+  if (context->window->Check(delta) != MediaCryptoReplayWindow::kOk) {
+    rtc::AtomicOps::Increment(&context->replay_drops);
+    LOG(LS_WARNING) << "Replay failed for ssrc " << context->ssrc;
+    return false;
+  }
+  size_t length;
+  if (!aead_->Open(index, p, kInnerHeaderSize, in_len, &length)) {
+    rtc::AtomicOps::Increment(&context->auth_failures);
+    LOG(LS_WARNING) << "Failed to authenticate SRTP packet for ssrc "
+                    << context->ssrc;
+    return false;
+  }
+  context->window->Add(delta);
+  rtc::AtomicOps::Increment(&context->packets);
+  *out_len = static_cast<int>(length);
+  return true;
+}
+
+bool MediaCrypto::GetOutboundIndex(uint32_t ssrc,
+                                   uint16_t seq_num,
+                                   uint64_t* index) {
+  std::unique_ptr<MediaCryptoReplayWindow>& window = outbound_windows_[ssrc];
+  if (!window)
+    window.reset(new MediaCryptoReplayWindow(replay_window_size_));
+  int32_t delta = window->Estimate(seq_num, index);
+  MediaCryptoReplayWindow::Status status = window->Check(delta);
+  if (status == MediaCryptoReplayWindow::kTooOld) {
+    LOG(LS_WARNING) << "Failed to encrypt double packet, sequence number "
+                    << seq_num << " is too old";
+    return false;
+  }
+  // Sending an index twice is allowed, as with allow_repeat_tx in libsrtp.
+  if (status == MediaCryptoReplayWindow::kOk)
+    window->Add(delta);
   return true;
 }
 
@@ -206,9 +559,85 @@ size_t MediaCrypto::GetEncryptionOverhead()
 }
 
 bool MediaCrypto::Encrypt(rtp::Packet *packet)
+{
+  RTC_DCHECK_RUNS_SERIALIZED(&encrypt_race_checker_);
+  uint64_t index = 0;
+  if (aead_ &&
+      !GetOutboundIndex(packet->Ssrc(), packet->SequenceNumber(), &index)) {
+    return false;
+  }
+  return Encrypt(session_, index, packet);
+}
+
+bool MediaCrypto::EncryptBatch(rtc::ArrayView<rtp::Packet* const> packets)
+{
+  RTC_DCHECK_RUNS_SERIALIZED(&encrypt_race_checker_);
+  if (!session_ && !aead_) {
+    LOG(LS_WARNING) << "Failed to protect SRTP packets: no SRTP Session";
+    return false;
+  }
+
+  // A single libsrtp session sees every packet, see EnableWorkers.
+  if (!aead_)
+    return EncryptRange(session_, nullptr, packets.data(), packets.size());
+
+  // The AEAD engine tracks packet indexes itself, do it up front so that
+  // only the sealing is split between threads.
+  batch_indexes_.resize(packets.size());
+  for (size_t i = 0; i < packets.size(); ++i) {
+    if (!GetOutboundIndex(packets[i]->Ssrc(), packets[i]->SequenceNumber(),
+                          &batch_indexes_[i])) {
+      return false;
+    }
+  }
+  const uint64_t* indexes = batch_indexes_.data();
+
+  size_t num_chunks = std::min(workers_.size() + 1,
+                               packets.size() / kMinPacketsPerWorker);
+  if (num_chunks <= 1)
+    return EncryptRange(nullptr, indexes, packets.data(), packets.size());
+
+  // Fan the frame out, first chunk is encrypted on the calling thread
+  size_t chunk = (packets.size() + num_chunks - 1) / num_chunks;
+  for (size_t i = 1; i < num_chunks; ++i) {
+    Worker* worker = workers_[i - 1].get();
+    rtp::Packet* const* first = packets.data() + i * chunk;
+    const uint64_t* first_index = indexes + i * chunk;
+    size_t count = std::min(chunk, packets.size() - i * chunk);
+    worker->queue.PostTask([this, worker, first_index, first, count] {
+      worker->result = EncryptRange(nullptr, first_index, first, count);
+      worker->done.Set();
+    });
+  }
+  bool result = EncryptRange(nullptr, indexes, packets.data(), chunk);
+
+  // Join
+  for (size_t i = 1; i < num_chunks; ++i) {
+    workers_[i - 1]->done.Wait(rtc::Event::kForever);
+    result &= workers_[i - 1]->result;
+  }
+  return result;
+}
+
+bool MediaCrypto::EncryptRange(srtp_ctx_t_* session,
+                               const uint64_t* indexes,
+                               rtp::Packet* const* packets,
+                               size_t count)
+{
+  for (size_t i = 0; i < count; ++i) {
+    if (!Encrypt(session, indexes ? indexes[i] : 0, packets[i]))
+      return false;
+  }
+  return true;
+}
+
+bool MediaCrypto::Encrypt(srtp_ctx_t_* session,
+                          uint64_t index,
+                          rtp::Packet *packet)
 {
   // Calculate payload size for encrypted version
-  size_t encrypted_payload_size = ohb_size + packet->payload_size() + rtp_auth_tag_len_;
+  size_t payload_size = packet->payload_size();
+  size_t encrypted_payload_size = ohb_size + payload_size + rtp_auth_tag_len_;
   
   //Check it is enought
   if (encrypted_payload_size > packet->MaxPayloadSize()) {
@@ -216,17 +645,31 @@ bool MediaCrypto::Encrypt(rtp::Packet *packet)
       << " encrypted size will exceed max payload size available";
     return false;
   }
-  // Alloc temporal buffer for encryption
-  size_t size = encrypted_payload_size + 1;
-  uint8_t* inner = (uint8_t*) malloc(size);
   
-  //Get packet values
+  //Get packet values before touching the packet buffer
   bool mark = packet->Marker ();
   uint8_t pt = packet->PayloadType ();
   uint16_t seq = packet->SequenceNumber();
   uint32_t ts = packet->Timestamp();
   uint32_t ssrc = packet->Ssrc();
   
+  // Grow payload in place to hold OHB + payload + auth tag
+  uint8_t* payload = packet->ResizePayload(encrypted_payload_size);
+  if (!payload) {
+    LOG(LS_WARNING) << "Failed to perform DOUBLE PERC"
+      << " could not allocate payload for encrypted data";
+    return false;
+  }
+  
+  // Make room for the OHB in front of the payload
+  memmove(payload + ohb_size, payload, payload_size);
+  
+  // The inner RTP header is the first byte of a fixed RTP header followed by
+  // the OHB, so borrow the last byte of the outer header for it while the
+  // inner packet is protected and restore it afterwards.
+  uint8_t* inner = payload - 1;
+  uint8_t outer = inner[0];
+  
   // Innert RTP packet has no padding,csrcs or extensions
   inner[0] = 0x80;
   
@@ -245,35 +688,32 @@ bool MediaCrypto::Encrypt(rtp::Packet *packet)
   inner[9] = ssrc >> 16;
   inner[10] = ssrc >> 8;
   inner[11] = ssrc;
-  
-  //Copy the rest of the payload
-  memcpy(inner + 1 + ohb_size, packet->payload().data(), packet->payload_size());
 
   // Protect inner rtp packet
   int out_len;
-  bool result = ProtectRtp(inner,
-                           1 + ohb_size + packet->payload_size(),
-                           size,
-                           &out_len);
-  //Set encrypted payload
-  if (result) {
-    // Allocate new payload size
-    uint8_t* buffer = packet->AllocatePayload(out_len - 1);
-    
-    if (buffer) {
-      // Copy the encrypted inner rtp packet except first byte  of rtp header
-      memcpy(buffer, inner + 1, out_len - 1);
-      // Set new payload size
-      packet->SetPayloadSize(out_len - 1);
-    } else {
-      LOG(LS_WARNING) << "Failed to perform DOUBLE PERC"
-        << " could not allocate payload for encrypted data";
-      result = false;
-    }
+  bool result;
+  if (aead_) {
+    size_t sealed_len = 0;
+    result = aead_->Seal(index, inner, kInnerHeaderSize,
+                         1 + ohb_size + payload_size,
+                         1 + encrypted_payload_size, &sealed_len);
+    out_len = static_cast<int>(sealed_len);
+    if (!result)
+      LOG(LS_WARNING) << "Failed to encrypt double packet";
+  } else {
+    result = ProtectRtp(session,
+                        inner,
+                        1 + ohb_size + payload_size,
+                        1 + encrypted_payload_size,
+                        &out_len);
   }
-
-  //Free aux
-  free(inner);
+  
+  // Restore outer header
+  inner[0] = outer;
+  
+  //Set encrypted payload size, the packet is unusable on failure
+  if (result)
+    packet->SetPayloadSize(out_len - 1);
   
   return result;
 }
@@ -286,33 +726,45 @@ bool MediaCrypto::Decrypt(uint8_t* payload,size_t* payload_length) {
     return false;
   }
   
-  // Alloc temporal buffer for decryption
-  uint8_t* inner = (uint8_t*) malloc(*payload_length + 1);
+  // Each original sender gets its own context, keyed by the OHB SSRC. The
+  // OHB is not authenticated yet, so a new sender's context is only added to
+  // the table once its first packet has been, or forged SSRCs could fill it.
+  uint32_t ssrc = ByteReader<uint32_t>::ReadBigEndian(payload + 7);
+  InboundContext* context = FindInboundContext(ssrc);
+  size_t pending_slot = kMaxPendingInboundContexts;
+  if (!context)
+    context = GetPendingInboundContext(ssrc, &pending_slot);
   
-   // Reconstruct RTP header
+  // Reconstruct RTP header on the last byte of the outer header, see Encrypt
+  uint8_t* inner = payload - 1;
+  uint8_t outer = inner[0];
   inner[0] = 0x80;
-  // Copy the rest of the header
-  memcpy(inner + 1, payload, *payload_length);
 
   // UnProtect inner rtp packet
   int out_length;
-  bool result = UnprotectRtp(inner,
+  bool result = UnprotectRtp(context,
+                           inner,
                            1 + *payload_length,
                            &out_length);
   
+  // Restore outer header
+  inner[0] = outer;
+
+  if (result) {
+    context->last_used = ++inbound_clock_;
+    if (pending_slot != kMaxPendingInboundContexts)
+      AddInboundContext(std::move(pending_inbound_[pending_slot]));
+  }
+  
   //Set decyrpted payload
   if (result) {
     // Remove the OHB data
     *payload_length = out_length - ohb_size - 1;
-    // Copy the encrypted inner rtp packet except first byte  of rtp header
-    memcpy(payload, inner + ohb_size + 1, *payload_length);
+    // Move the decrypted payload to the start of the buffer
+    memmove(payload, payload + ohb_size, *payload_length);
   } else {
       LOG(LS_WARNING) << "Failed to perform DOUBLE PERC";
-      result = false;
   }
- 
-  //Free aux
-  free(inner);
   
   return result;
 }
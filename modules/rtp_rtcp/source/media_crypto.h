@@ -11,6 +11,14 @@
 #ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_DOUBLE_PERC_H_
 #define WEBRTC_MODULES_RTP_RTCP_SOURCE_DOUBLE_PERC_H_
 
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "webrtc/base/array_view.h"
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/race_checker.h"
+#include "webrtc/base/task_queue.h"
 #include "webrtc/config.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_packet.h"
@@ -20,27 +28,122 @@
 struct srtp_ctx_t_;
 
 namespace webrtc {
+
+class MediaCryptoAead;
+class MediaCryptoReplayWindow;
 	
+// The AEAD suites are handled by MediaCryptoAead instead of libsrtp when the
+// "WebRTC-MediaCryptoAead" field trial is enabled at construction time. Both
+// produce the same packets, so either side may use either engine.
 class MediaCrypto {
  public:
+  // Inbound contexts kept at most, see GetNumInboundContexts.
+  static const size_t kMaxInboundContexts = 256;
+
   MediaCrypto();
   ~MediaCrypto();
 
+  // True if the key set is handled by MediaCryptoAead.
+  bool aead_enabled() const { return aead_ != nullptr; }
+
   
   bool SetOutboundKey(const MediaCryptoKey& key);
   bool SetInboundKey(const MediaCryptoKey& key);
+  // Creates |num_workers| task queues that EncryptBatch uses to split large
+  // frames. Must be called after the outbound key is set. Only the AEAD
+  // engine splits frames, libsrtp encrypts them on the calling thread.
+  bool EnableWorkers(size_t num_workers);
+  // Encrypts and decrypts the inner payload in place, without allocating.
+  // The byte preceding |payload| (the last byte of the outer RTP header) is
+  // used as scratch and restored before returning. Encrypt and EncryptBatch
+  // calls must not overlap, they track the outbound packet indexes.
   bool Encrypt(rtp::Packet *packet);
+  // Decrypt calls must not overlap, they add and evict inbound contexts.
   bool Decrypt(uint8_t* payload,size_t* payload_length);
+  // Encrypts all packets of one frame, fanning large frames out to the
+  // workers if enabled. Blocks until every packet has been processed.
+  bool EncryptBatch(rtc::ArrayView<rtp::Packet* const> packets);
   
   size_t GetEncryptionOverhead();
   
+  // Inbound contexts are created per original sender SSRC, as found in the
+  // OHB, the first time one of its packets is authenticated. Once there are
+  // kMaxInboundContexts, the least recently used one is evicted. Both may be
+  // called from any thread.
+  size_t GetNumInboundContexts() const;
+  std::vector<MediaCryptoStats> GetInboundStats() const;
+  
  private:
+  struct Worker;
+  struct InboundContext;
+  
+  static const size_t kInboundSlots = 2 * kMaxInboundContexts;
+  static const size_t kMaxPendingInboundContexts = 16;
+  
   bool SetKey(int type, int cs, const uint8_t* key, size_t len);
-  bool ProtectRtp(void* data, int in_len, int max_len, int* out_len);
-  bool UnprotectRtp(void* data, int in_len, int* out_len);  
+  srtp_ctx_t_* CreateSession(uint32_t ssrc);
+  InboundContext* FindInboundContext(uint32_t ssrc);
+  std::unique_ptr<InboundContext> CreateInboundContext(uint32_t ssrc);
+  // Finds or creates the context of a sender that has not authenticated a
+  // packet yet, and sets |slot| to its index in |pending_inbound_|. Returns
+  // nullptr once too many of them were dropped unauthenticated.
+  InboundContext* GetPendingInboundContext(uint32_t ssrc, size_t* slot);
+  void AddInboundContext(std::unique_ptr<InboundContext> context);
+  void RemoveInboundContext(size_t slot)
+      EXCLUSIVE_LOCKS_REQUIRED(inbound_crit_);
+  // |index| is only used by the AEAD engine, libsrtp tracks it itself.
+  bool Encrypt(srtp_ctx_t_* session, uint64_t index, rtp::Packet *packet);
+  bool EncryptRange(srtp_ctx_t_* session,
+                    const uint64_t* indexes,
+                    rtp::Packet* const* packets,
+                    size_t count);
+  bool GetOutboundIndex(uint32_t ssrc, uint16_t seq_num, uint64_t* index)
+      EXCLUSIVE_LOCKS_REQUIRED(encrypt_race_checker_);
+  bool ProtectRtp(srtp_ctx_t_* session,
+                  void* data,
+                  int in_len,
+                  int max_len,
+                  int* out_len);
+  bool UnprotectRtp(InboundContext* context,
+                    void* data,
+                    int in_len,
+                    int* out_len);
+  bool OpenRtp(InboundContext* context,
+               uint8_t* data,
+               int in_len,
+               int* out_len);
+  const bool use_aead_;
   srtp_ctx_t_* session_;
+  std::unique_ptr<MediaCryptoAead> aead_;
+  rtc::RaceChecker encrypt_race_checker_;
+  // Outbound packet index tracking per SSRC, for the AEAD engine. Workers
+  // are handed the indexes, only the encrypting thread uses the windows.
+  std::map<uint32_t, std::unique_ptr<MediaCryptoReplayWindow>>
+      outbound_windows_ GUARDED_BY(encrypt_race_checker_);
+  // Packet indexes of the batch being encrypted, reused across frames.
+  std::vector<uint64_t> batch_indexes_ GUARDED_BY(encrypt_race_checker_);
   int rtp_auth_tag_len_;
   int rtcp_auth_tag_len_;
+  int ssrc_type_;
+  int crypto_suite_;
+  std::vector<uint8_t> key_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  int replay_window_size_;
+  // SSRC table, only changed by the decrypting thread, see FindInboundContext.
+  // Other threads read it under |inbound_crit_|.
+  rtc::CriticalSection inbound_crit_;
+  InboundContext* inbound_[kInboundSlots];
+  // Counts successful decryptions, to find the least recently used context.
+  uint32_t inbound_clock_;
+  size_t num_inbound_contexts_ GUARDED_BY(inbound_crit_);
+  // Contexts kept until their first packet authenticates, only used by the
+  // decrypting thread. Creating a context costs as much as a key setup, so
+  // the rate at which they are dropped unauthenticated is limited.
+  std::unique_ptr<InboundContext>
+      pending_inbound_[kMaxPendingInboundContexts];
+  size_t next_pending_inbound_;
+  int64_t pending_period_start_ms_;
+  int num_dropped_pending_contexts_;
   RTC_DISALLOW_COPY_AND_ASSIGN(MediaCrypto);  
 };
 
@@ -0,0 +1,248 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/media_crypto_aead.h"
+
+#include <openssl/aes.h>
+#include <openssl/mem.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "webrtc/base/checks.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+
+namespace webrtc {
+
+namespace {
+// SRTP key derivation labels, RFC 3711 section 4.3.2.
+const uint8_t kLabelRtpEncryption = 0x00;
+const uint8_t kLabelRtpSalt = 0x02;
+const size_t kMaxKeyLength = 32;
+const size_t kNonceLength = 12;
+const size_t kRtpHeaderSsrcOffset = 8;
+const uint16_t kSeqNumMedian = 1 << 15;
+const int32_t kSeqNumMax = 1 << 16;
+
+// SRTP key derivation with a zero key derivation rate, as done by libsrtp for
+// the GCM suites: AES in counter mode keyed with the master key, using the
+// master salt padded to 14 bytes as IV, xored with the label in its eighth
+// byte.
+void DeriveSessionKey(const AES_KEY& kdf,
+                      const uint8_t* master_salt,
+                      uint8_t label,
+                      uint8_t* out,
+                      size_t length) {
+  uint8_t block[AES_BLOCK_SIZE];
+  uint8_t keystream[AES_BLOCK_SIZE];
+  for (size_t offset = 0; offset < length; offset += AES_BLOCK_SIZE) {
+    uint16_t counter = static_cast<uint16_t>(offset / AES_BLOCK_SIZE);
+    memset(block, 0, sizeof(block));
+    memcpy(block, master_salt, MediaCryptoAead::kSaltLength);
+    block[7] ^= label;
+    ByteWriter<uint16_t>::WriteBigEndian(block + 14, counter);
+    AES_encrypt(block, keystream, &kdf);
+    memcpy(out + offset, keystream,
+           std::min<size_t>(AES_BLOCK_SIZE, length - offset));
+  }
+  OPENSSL_cleanse(keystream, sizeof(keystream));
+}
+
+size_t RingWords(int window_size) {
+  size_t words = 1;
+  while (words * 64 < static_cast<size_t>(window_size) + 128)
+    words <<= 1;
+  return words;
+}
+}  // namespace
+
+const size_t MediaCryptoAead::kSaltLength;
+
+MediaCryptoAead::MediaCryptoAead() : tag_length_(0) {
+  EVP_AEAD_CTX_zero(&context_);
+  memset(salt_, 0, sizeof(salt_));
+}
+
+MediaCryptoAead::~MediaCryptoAead() {
+  EVP_AEAD_CTX_cleanup(&context_);
+  OPENSSL_cleanse(salt_, sizeof(salt_));
+}
+
+bool MediaCryptoAead::IsSupported(int crypto_suite) {
+  return crypto_suite == rtc::SRTP_AEAD_AES_128_GCM ||
+         crypto_suite == rtc::SRTP_AEAD_AES_256_GCM;
+}
+
+std::unique_ptr<MediaCryptoAead> MediaCryptoAead::Create(
+    int crypto_suite,
+    const uint8_t* master_key,
+    size_t length) {
+  const EVP_AEAD* aead;
+  size_t key_length;
+  if (crypto_suite == rtc::SRTP_AEAD_AES_128_GCM) {
+    aead = EVP_aead_aes_128_gcm();
+    key_length = 16;
+  } else if (crypto_suite == rtc::SRTP_AEAD_AES_256_GCM) {
+    aead = EVP_aead_aes_256_gcm();
+    key_length = 32;
+  } else {
+    return nullptr;
+  }
+  if (!master_key || length != key_length + kSaltLength)
+    return nullptr;
+
+  AES_KEY kdf;
+  if (AES_set_encrypt_key(master_key, key_length * 8, &kdf) != 0)
+    return nullptr;
+
+  std::unique_ptr<MediaCryptoAead> crypto(new MediaCryptoAead());
+  uint8_t session_key[kMaxKeyLength];
+  const uint8_t* master_salt = master_key + key_length;
+  DeriveSessionKey(kdf, master_salt, kLabelRtpEncryption, session_key,
+                   key_length);
+  DeriveSessionKey(kdf, master_salt, kLabelRtpSalt, crypto->salt_,
+                   kSaltLength);
+  int result = EVP_AEAD_CTX_init(&crypto->context_, aead, session_key,
+                                 key_length, EVP_AEAD_DEFAULT_TAG_LENGTH,
+                                 nullptr);
+  OPENSSL_cleanse(session_key, sizeof(session_key));
+  OPENSSL_cleanse(&kdf, sizeof(kdf));
+  if (!result)
+    return nullptr;
+  crypto->tag_length_ = EVP_AEAD_max_overhead(aead);
+  return crypto;
+}
+
+void MediaCryptoAead::ComputeNonce(const uint8_t* header,
+                                   uint64_t index,
+                                   uint8_t* nonce) const {
+  // RFC 7714 section 8.1: 00 00 || SSRC || ROC || SEQ, xored with the salt.
+  nonce[0] = 0;
+  nonce[1] = 0;
+  memcpy(nonce + 2, header + kRtpHeaderSsrcOffset, 4);
+  ByteWriter<uint32_t>::WriteBigEndian(nonce + 6,
+                                       static_cast<uint32_t>(index >> 16));
+  ByteWriter<uint16_t>::WriteBigEndian(nonce + 10,
+                                       static_cast<uint16_t>(index));
+  for (size_t i = 0; i < kNonceLength; ++i)
+    nonce[i] ^= salt_[i];
+}
+
+bool MediaCryptoAead::Seal(uint64_t index,
+                           uint8_t* packet,
+                           size_t header_length,
+                           size_t length,
+                           size_t max_length,
+                           size_t* out_length) const {
+  RTC_DCHECK_GE(header_length, kRtpHeaderSsrcOffset + 4);
+  if (length < header_length || max_length < length + tag_length_)
+    return false;
+  uint8_t nonce[kNonceLength];
+  ComputeNonce(packet, index, nonce);
+  uint8_t* payload = packet + header_length;
+  size_t sealed_length;
+  if (!EVP_AEAD_CTX_seal(&context_, payload, &sealed_length,
+                         max_length - header_length, nonce, sizeof(nonce),
+                         payload, length - header_length, packet,
+                         header_length)) {
+    return false;
+  }
+  *out_length = header_length + sealed_length;
+  return true;
+}
+
+bool MediaCryptoAead::Open(uint64_t index,
+                           uint8_t* packet,
+                           size_t header_length,
+                           size_t length,
+                           size_t* out_length) const {
+  RTC_DCHECK_GE(header_length, kRtpHeaderSsrcOffset + 4);
+  if (length < header_length + tag_length_)
+    return false;
+  uint8_t nonce[kNonceLength];
+  ComputeNonce(packet, index, nonce);
+  uint8_t* payload = packet + header_length;
+  size_t opened_length;
+  if (!EVP_AEAD_CTX_open(&context_, payload, &opened_length,
+                         length - header_length, nonce, sizeof(nonce),
+                         payload, length - header_length, packet,
+                         header_length)) {
+    return false;
+  }
+  *out_length = header_length + opened_length;
+  return true;
+}
+
+MediaCryptoReplayWindow::MediaCryptoReplayWindow(int window_size)
+    : window_size_((window_size + 31) & ~31),
+      index_(0),
+      bitmap_(RingWords(window_size_), 0),
+      word_mask_(bitmap_.size() - 1) {}
+
+MediaCryptoReplayWindow::~MediaCryptoReplayWindow() {}
+
+int32_t MediaCryptoReplayWindow::Estimate(uint16_t seq_num,
+                                          uint64_t* index) const {
+  // Until the sequence number has moved past half its range the rollover
+  // counter is taken to be zero, see srtp_rdbx_estimate_index.
+  if (index_ <= kSeqNumMedian) {
+    *index = seq_num;
+    return static_cast<int32_t>(seq_num - index_);
+  }
+  uint32_t local_roc = static_cast<uint32_t>(index_ >> 16);
+  uint16_t local_seq = static_cast<uint16_t>(index_);
+  uint32_t roc = local_roc;
+  int32_t delta = seq_num - local_seq;
+  if (local_seq < kSeqNumMedian) {
+    if (seq_num - local_seq > kSeqNumMedian) {
+      roc = local_roc - 1;
+      delta -= kSeqNumMax;
+    }
+  } else if (local_seq - kSeqNumMedian > seq_num) {
+    roc = local_roc + 1;
+    delta += kSeqNumMax;
+  }
+  *index = (static_cast<uint64_t>(roc) << 16) | seq_num;
+  return delta;
+}
+
+MediaCryptoReplayWindow::Status MediaCryptoReplayWindow::Check(
+    int32_t delta) const {
+  if (delta > 0)
+    return kOk;
+  if (window_size_ - 1 + delta < 0)
+    return kTooOld;
+  if (IsSet(index_ + delta))
+    return kReplayed;
+  return kOk;
+}
+
+void MediaCryptoReplayWindow::Add(int32_t delta) {
+  if (delta > 0) {
+    // Clear the words the index moves into, the bits of the current word
+    // above |index_| are already clear.
+    uint64_t next = index_ + delta;
+    uint64_t word = index_ >> 6;
+    uint64_t words = std::min<uint64_t>((next >> 6) - word, bitmap_.size());
+    for (uint64_t i = 1; i <= words; ++i)
+      bitmap_[(word + i) & word_mask_] = 0;
+    index_ = next;
+    delta = 0;
+  }
+  uint64_t index = index_ + delta;
+  bitmap_[(index >> 6) & word_mask_] |= uint64_t{1} << (index & 63);
+}
+
+bool MediaCryptoReplayWindow::IsSet(uint64_t index) const {
+  return (bitmap_[(index >> 6) & word_mask_] >> (index & 63)) & 1;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_MEDIA_CRYPTO_AEAD_H_
+#define WEBRTC_MODULES_RTP_RTCP_SOURCE_MEDIA_CRYPTO_AEAD_H_
+
+#include <openssl/aead.h>
+
+#include <memory>
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// SRTP AEAD_AES_128_GCM and AEAD_AES_256_GCM (RFC 7714) for the fixed size
+// inner PERC packet, on top of BoringSSL's EVP_AEAD so that AES-NI and PCLMUL
+// are used where available. The session key and salt are derived once and
+// the expanded key kept in the AEAD context, so protecting a packet is a
+// single seal or open call without libsrtp's stream lookup and policy checks.
+// The output is identical to libsrtp's for the same master key, SSRC and
+// packet index.
+class MediaCryptoAead {
+ public:
+  static const size_t kSaltLength = 12;
+
+  static bool IsSupported(int crypto_suite);
+  // Returns nullptr if the suite is not an AEAD one or |master_key|, the
+  // master key followed by the master salt, has the wrong length.
+  static std::unique_ptr<MediaCryptoAead> Create(int crypto_suite,
+                                                 const uint8_t* master_key,
+                                                 size_t length);
+  ~MediaCryptoAead();
+
+  size_t tag_length() const { return tag_length_; }
+
+  // |packet| holds an RTP header of |header_length| bytes, used as additional
+  // authenticated data, followed by the payload. The payload is encrypted in
+  // place and the tag appended, |max_length| must leave room for it.
+  // |index| is the 48 bit SRTP packet index, rollover counter and sequence
+  // number.
+  bool Seal(uint64_t index,
+            uint8_t* packet,
+            size_t header_length,
+            size_t length,
+            size_t max_length,
+            size_t* out_length) const;
+  // Authenticates and decrypts in place. The payload is garbage on failure.
+  bool Open(uint64_t index,
+            uint8_t* packet,
+            size_t header_length,
+            size_t length,
+            size_t* out_length) const;
+
+ private:
+  MediaCryptoAead();
+
+  void ComputeNonce(const uint8_t* header, uint64_t index,
+                    uint8_t* nonce) const;
+
+  EVP_AEAD_CTX context_;
+  uint8_t salt_[kSaltLength];
+  size_t tag_length_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MediaCryptoAead);
+};
+
+// Packet index estimation and replay window of one SSRC. Mirrors libsrtp's
+// rdbx so rollover counters and replay decisions match it exactly, but keeps
+// the window in a ring of words that is advanced without shifting it.
+class MediaCryptoReplayWindow {
+ public:
+  enum Status { kOk, kReplayed, kTooOld };
+
+  explicit MediaCryptoReplayWindow(int window_size);
+  ~MediaCryptoReplayWindow();
+
+  // Estimates the packet index of |seq_num| and returns its distance to the
+  // highest index seen so far.
+  int32_t Estimate(uint16_t seq_num, uint64_t* index) const;
+  Status Check(int32_t delta) const;
+  // Marks the estimated index as received, must follow a successful Check.
+  void Add(int32_t delta);
+
+ private:
+  bool IsSet(uint64_t index) const;
+
+  // libsrtp rounds the window up to whole 32 bit words.
+  const int window_size_;
+  uint64_t index_;
+  // Ring of at least |window_size_| + 64 bits, bit i holds index i modulo
+  // the ring size. Bits ahead of |index_| are always clear.
+  std::vector<uint64_t> bitmap_;
+  const size_t word_mask_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MediaCryptoReplayWindow);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_MEDIA_CRYPTO_AEAD_H_
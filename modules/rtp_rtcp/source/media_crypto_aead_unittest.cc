@@ -0,0 +1,257 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/media_crypto_aead.h"
+
+#include <memory>
+#include <vector>
+
+#include "third_party/libsrtp/include/srtp.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/modules/rtp_rtcp/source/media_crypto.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/test/field_trial.h"
+#include "webrtc/test/gmock.h"
+#include "webrtc/test/gtest.h"
+
+using testing::ElementsAreArray;
+
+namespace webrtc {
+namespace {
+constexpr uint8_t kPayloadType = 100;
+constexpr uint32_t kSsrc = 0x12345678;
+constexpr uint32_t kTimestamp = 0x65431278;
+constexpr size_t kPayloadSize = 500;
+constexpr int kReplayWindowSize = 128;
+
+MediaCryptoKey CreateKey(int crypto_suite) {
+  int key_length;
+  int salt_length;
+  EXPECT_TRUE(
+      rtc::GetSrtpKeyAndSaltLengths(crypto_suite, &key_length, &salt_length));
+  MediaCryptoKey key;
+  key.type = crypto_suite;
+  key.buffer.resize(key_length + salt_length);
+  for (size_t i = 0; i < key.buffer.size(); ++i)
+    key.buffer[i] = static_cast<uint8_t>(i * 13 + 5);
+  key.replay_window_size = kReplayWindowSize;
+  return key;
+}
+
+std::unique_ptr<RtpPacketToSend> CreatePacket(uint16_t seq_num) {
+  std::unique_ptr<RtpPacketToSend> packet(new RtpPacketToSend(nullptr));
+  packet->SetPayloadType(kPayloadType);
+  packet->SetSequenceNumber(seq_num);
+  packet->SetTimestamp(kTimestamp + seq_num);
+  packet->SetSsrc(kSsrc);
+  uint8_t* payload = packet->AllocatePayload(kPayloadSize);
+  for (size_t i = 0; i < kPayloadSize; ++i)
+    payload[i] = static_cast<uint8_t>(i + seq_num);
+  return packet;
+}
+
+std::vector<uint8_t> ToVector(const RtpPacketToSend& packet) {
+  return std::vector<uint8_t>(packet.data(), packet.data() + packet.size());
+}
+
+MediaCrypto* CreateAeadCrypto() {
+  test::ScopedFieldTrials field_trials("WebRTC-MediaCryptoAead/Enabled/");
+  return new MediaCrypto();
+}
+}  // namespace
+
+// Runs every test against both GCM suites, comparing the AEAD engine with
+// libsrtp packet by packet.
+class MediaCryptoAeadTest : public ::testing::TestWithParam<int> {
+ protected:
+  MediaCryptoAeadTest()
+      : libsrtp_sender_(new MediaCrypto()),
+        libsrtp_receiver_(new MediaCrypto()),
+        aead_sender_(CreateAeadCrypto()),
+        aead_receiver_(CreateAeadCrypto()) {
+    static bool srtp_initialized = srtp_init() == srtp_err_status_ok;
+    EXPECT_TRUE(srtp_initialized);
+    MediaCryptoKey key = CreateKey(GetParam());
+    EXPECT_TRUE(libsrtp_sender_->SetOutboundKey(key));
+    EXPECT_TRUE(libsrtp_receiver_->SetInboundKey(key));
+    EXPECT_TRUE(aead_sender_->SetOutboundKey(key));
+    EXPECT_TRUE(aead_receiver_->SetInboundKey(key));
+  }
+
+  // Encrypts |seq_num| with both engines and returns the packet, failing the
+  // test if they differ in a single byte.
+  std::vector<uint8_t> EncryptBoth(uint16_t seq_num) {
+    std::unique_ptr<RtpPacketToSend> expected = CreatePacket(seq_num);
+    std::unique_ptr<RtpPacketToSend> actual = CreatePacket(seq_num);
+    EXPECT_TRUE(libsrtp_sender_->Encrypt(expected.get()));
+    EXPECT_TRUE(aead_sender_->Encrypt(actual.get()));
+    EXPECT_THAT(ToVector(*expected), ElementsAreArray(ToVector(*actual)));
+    return ToVector(*actual);
+  }
+
+  bool Decrypt(MediaCrypto* receiver, std::vector<uint8_t> packet) {
+    const size_t header_size = 12;
+    size_t payload_length = packet.size() - header_size;
+    return receiver->Decrypt(packet.data() + header_size, &payload_length) &&
+           payload_length == kPayloadSize;
+  }
+
+  std::unique_ptr<MediaCrypto> libsrtp_sender_;
+  std::unique_ptr<MediaCrypto> libsrtp_receiver_;
+  std::unique_ptr<MediaCrypto> aead_sender_;
+  std::unique_ptr<MediaCrypto> aead_receiver_;
+};
+
+INSTANTIATE_TEST_CASE_P(GcmSuites,
+                        MediaCryptoAeadTest,
+                        ::testing::Values(rtc::SRTP_AEAD_AES_128_GCM,
+                                          rtc::SRTP_AEAD_AES_256_GCM));
+
+TEST_P(MediaCryptoAeadTest, SelectedByFieldTrial) {
+  EXPECT_FALSE(libsrtp_sender_->aead_enabled());
+  EXPECT_FALSE(libsrtp_receiver_->aead_enabled());
+  EXPECT_TRUE(aead_sender_->aead_enabled());
+  EXPECT_TRUE(aead_receiver_->aead_enabled());
+  EXPECT_EQ(libsrtp_sender_->GetEncryptionOverhead(),
+            aead_sender_->GetEncryptionOverhead());
+}
+
+TEST_P(MediaCryptoAeadTest, NonAeadSuiteFallsBackToLibsrtp) {
+  std::unique_ptr<MediaCrypto> crypto(CreateAeadCrypto());
+  ASSERT_TRUE(
+      crypto->SetOutboundKey(CreateKey(rtc::SRTP_AES128_CM_SHA1_80)));
+  EXPECT_FALSE(crypto->aead_enabled());
+}
+
+TEST_P(MediaCryptoAeadTest, EncryptMatchesLibsrtpAcrossRollover) {
+  // Starts below the wrap so the rollover counter goes from 0 to 1.
+  for (uint16_t seq_num = 0xfff0; seq_num != 0x0010; ++seq_num) {
+    std::vector<uint8_t> packet = EncryptBoth(seq_num);
+    EXPECT_TRUE(Decrypt(libsrtp_receiver_.get(), packet));
+    EXPECT_TRUE(Decrypt(aead_receiver_.get(), packet));
+  }
+}
+
+TEST_P(MediaCryptoAeadTest, EncryptMatchesLibsrtpAfterLongRun) {
+  // Enough packets to leave the initial rollover estimation behind and wrap
+  // twice.
+  for (uint32_t i = 0; i < 3 * 0x10000; i += 7) {
+    std::vector<uint8_t> packet = EncryptBoth(static_cast<uint16_t>(i));
+    ASSERT_TRUE(Decrypt(aead_receiver_.get(), packet));
+  }
+}
+
+TEST_P(MediaCryptoAeadTest, RetransmissionMatchesLibsrtp) {
+  for (uint16_t seq_num = 100; seq_num < 120; ++seq_num)
+    EncryptBoth(seq_num);
+  // Resending an index is allowed on the send side for both engines.
+  EncryptBoth(110);
+}
+
+TEST_P(MediaCryptoAeadTest, EncryptBatchWithWorkersMatchesLibsrtp) {
+  const uint16_t kFirstSeqNum = 0xffc0;
+  const size_t kNumPackets = 100;
+  ASSERT_TRUE(aead_sender_->EnableWorkers(3));
+
+  std::vector<std::unique_ptr<RtpPacketToSend>> packets;
+  std::vector<rtp::Packet*> batch;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    packets.push_back(CreatePacket(kFirstSeqNum + i));
+    batch.push_back(packets.back().get());
+  }
+  ASSERT_TRUE(aead_sender_->EncryptBatch(batch));
+
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    std::unique_ptr<RtpPacketToSend> expected =
+        CreatePacket(kFirstSeqNum + i);
+    ASSERT_TRUE(libsrtp_sender_->Encrypt(expected.get()));
+    EXPECT_THAT(ToVector(*expected), ElementsAreArray(ToVector(*packets[i])));
+  }
+}
+
+TEST_P(MediaCryptoAeadTest, ReplayDecisionsMatchLibsrtp) {
+  // Sent in order, received reordered, duplicated and too late.
+  const uint16_t kFirstSeqNum = 1000;
+  const uint16_t kReceivedSeqNums[] = {1000, 1002, 1001, 1002, 1003, 1200,
+                                       1100, 1070, 1072, 1100, 1201};
+  std::vector<std::vector<uint8_t>> packets;
+  for (uint16_t seq_num = kFirstSeqNum; seq_num <= 1201; ++seq_num)
+    packets.push_back(EncryptBoth(seq_num));
+  for (uint16_t seq_num : kReceivedSeqNums) {
+    const std::vector<uint8_t>& packet = packets[seq_num - kFirstSeqNum];
+    EXPECT_EQ(Decrypt(libsrtp_receiver_.get(), packet),
+              Decrypt(aead_receiver_.get(), packet));
+  }
+
+  std::vector<MediaCryptoStats> expected = libsrtp_receiver_->GetInboundStats();
+  std::vector<MediaCryptoStats> actual = aead_receiver_->GetInboundStats();
+  ASSERT_EQ(1u, expected.size());
+  ASSERT_EQ(1u, actual.size());
+  EXPECT_EQ(expected[0].packets, actual[0].packets);
+  EXPECT_EQ(expected[0].replay_drops, actual[0].replay_drops);
+  EXPECT_EQ(4u, actual[0].replay_drops);
+}
+
+TEST_P(MediaCryptoAeadTest, DropsTamperedPacket) {
+  std::vector<uint8_t> packet = EncryptBoth(7);
+  packet.back() ^= 0x01;
+  EXPECT_FALSE(Decrypt(aead_receiver_.get(), packet));
+  std::vector<MediaCryptoStats> stats = aead_receiver_->GetInboundStats();
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ(1u, stats[0].auth_failures);
+  EXPECT_EQ(0u, stats[0].packets);
+}
+
+TEST(MediaCryptoReplayWindowTest, EstimatesRolloverBothWays) {
+  MediaCryptoReplayWindow window(kReplayWindowSize);
+  uint64_t index;
+  // Rollover is not estimated until past half the sequence number space.
+  EXPECT_EQ(0xfffe, window.Estimate(0xfffe, &index));
+  EXPECT_EQ(0xfffeu, index);
+  window.Add(0xfffe);
+
+  EXPECT_EQ(3, window.Estimate(1, &index));
+  EXPECT_EQ(0x10001u, index);
+  window.Add(3);
+
+  // A late packet from before the wrap keeps the old rollover counter.
+  EXPECT_EQ(-2, window.Estimate(0xffff, &index));
+  EXPECT_EQ(0xffffu, index);
+  EXPECT_EQ(MediaCryptoReplayWindow::kOk, window.Check(-2));
+  window.Add(-2);
+  EXPECT_EQ(MediaCryptoReplayWindow::kReplayed, window.Check(-2));
+}
+
+TEST(MediaCryptoReplayWindowTest, RejectsPacketsOlderThanWindow) {
+  MediaCryptoReplayWindow window(kReplayWindowSize);
+  uint64_t index;
+  window.Add(window.Estimate(1000, &index));
+  EXPECT_EQ(MediaCryptoReplayWindow::kOk,
+            window.Check(window.Estimate(1000 - kReplayWindowSize + 1,
+                                         &index)));
+  EXPECT_EQ(MediaCryptoReplayWindow::kTooOld,
+            window.Check(window.Estimate(1000 - kReplayWindowSize, &index)));
+}
+
+TEST(MediaCryptoReplayWindowTest, LargeJumpClearsWindow) {
+  MediaCryptoReplayWindow window(kReplayWindowSize);
+  uint64_t index;
+  for (uint16_t seq_num = 1; seq_num < 200; ++seq_num)
+    window.Add(window.Estimate(seq_num, &index));
+  window.Add(window.Estimate(20000, &index));
+  // Indexes that map onto the same ring bits as the old ones are unseen.
+  for (uint16_t seq_num = 20000 - kReplayWindowSize + 1; seq_num < 20000;
+       ++seq_num) {
+    EXPECT_EQ(MediaCryptoReplayWindow::kOk,
+              window.Check(window.Estimate(seq_num, &index)));
+  }
+}
+
+}  // namespace webrtc
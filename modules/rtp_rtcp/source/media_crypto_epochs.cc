@@ -0,0 +1,232 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/media_crypto_epochs.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/logging.h"
+#include "webrtc/system_wrappers/include/clock.h"
+
+namespace webrtc {
+
+const int64_t MediaCryptoEpochs::kDefaultGracePeriodMs;
+
+MediaCryptoEpochs::MediaCryptoEpochs(Clock* clock)
+    : MediaCryptoEpochs(clock, kDefaultGracePeriodMs) {}
+
+MediaCryptoEpochs::MediaCryptoEpochs(Clock* clock, int64_t grace_period_ms)
+    : clock_(clock),
+      grace_period_ms_(grace_period_ms),
+      enabled_(0),
+      previous_expiry_ms_(-1),
+      previous_first_(false),
+      encrypted_packets_(0) {}
+
+MediaCryptoEpochs::~MediaCryptoEpochs() {}
+
+bool MediaCryptoEpochs::enabled() const {
+  return rtc::AtomicOps::AcquireLoad(&enabled_) != 0;
+}
+
+bool MediaCryptoEpochs::SetOutboundKey(const MediaCryptoKey& key,
+                                       size_t num_workers) {
+  rtc::scoped_refptr<Epoch> epoch(new Epoch());
+  if (!epoch->SetOutboundKey(key))
+    return false;
+  if (num_workers > 0)
+    epoch->EnableWorkers(num_workers);
+
+  rtc::CritScope lock(&crit_);
+  if (!current_) {
+    current_ = epoch;
+    rtc::AtomicOps::ReleaseStore(&enabled_, 1);
+  } else {
+    // A key installed before the previous pending one was used replaces it.
+    pending_ = epoch;
+  }
+  return true;
+}
+
+rtc::scoped_refptr<MediaCryptoEpochs::Epoch>
+MediaCryptoEpochs::GetOutboundEpoch() {
+  rtc::CritScope lock(&crit_);
+  if (pending_) {
+    LOG(LS_INFO) << "Switching to new outbound media crypto key";
+    current_ = pending_;
+    pending_ = nullptr;
+  }
+  return current_;
+}
+
+bool MediaCryptoEpochs::Encrypt(rtp::Packet* packet) {
+  rtc::scoped_refptr<Epoch> epoch = GetOutboundEpoch();
+  if (!epoch || !epoch->Encrypt(packet))
+    return false;
+  rtc::CritScope lock(&crit_);
+  ++encrypted_packets_;
+  return true;
+}
+
+bool MediaCryptoEpochs::EncryptBatch(
+    rtc::ArrayView<rtp::Packet* const> packets) {
+  rtc::scoped_refptr<Epoch> epoch = GetOutboundEpoch();
+  if (!epoch || !epoch->EncryptBatch(packets))
+    return false;
+  rtc::CritScope lock(&crit_);
+  encrypted_packets_ += packets.size();
+  return true;
+}
+
+uint32_t MediaCryptoEpochs::GetNumEncryptedPackets() const {
+  rtc::CritScope lock(&crit_);
+  return encrypted_packets_;
+}
+
+size_t MediaCryptoEpochs::GetEncryptionOverhead() {
+  rtc::scoped_refptr<Epoch> current;
+  rtc::scoped_refptr<Epoch> pending;
+  {
+    rtc::CritScope lock(&crit_);
+    current = current_;
+    pending = pending_;
+  }
+  // The frame being packetized may be the first one under the pending key.
+  size_t overhead = current ? current->GetEncryptionOverhead() : 0;
+  if (pending)
+    overhead = std::max(overhead, pending->GetEncryptionOverhead());
+  return overhead;
+}
+
+bool MediaCryptoEpochs::SetInboundKey(const MediaCryptoKey& key) {
+  {
+    rtc::CritScope lock(&crit_);
+    // Set again when the senders switch to a key receivers were given ahead
+    // of time, which must not drop the epoch still in use.
+    if (current_ && key.type == inbound_key_.type &&
+        key.buffer == inbound_key_.buffer) {
+      return true;
+    }
+  }
+  rtc::scoped_refptr<Epoch> epoch(new Epoch());
+  if (!epoch->SetInboundKey(key))
+    return false;
+
+  rtc::CritScope lock(&crit_);
+  inbound_key_ = key;
+  if (previous_ && previous_expiry_ms_ < 0) {
+    // The current epoch never decrypted anything, the senders are still on
+    // the previous one, keep it and replace the unused key.
+    current_ = epoch;
+    return true;
+  }
+  // Only one previous epoch is kept, an older one still in its grace period
+  // is dropped.
+  previous_ = current_;
+  current_ = epoch;
+  previous_expiry_ms_ = -1;
+  previous_first_ = previous_ != nullptr;
+  rtc::AtomicOps::ReleaseStore(&enabled_, 1);
+  return true;
+}
+
+bool MediaCryptoEpochs::Decrypt(uint8_t* payload, size_t* payload_length) {
+  rtc::scoped_refptr<Epoch> first;
+  rtc::scoped_refptr<Epoch> second;
+  {
+    rtc::CritScope lock(&crit_);
+    if (previous_ && previous_expiry_ms_ >= 0 &&
+        clock_->TimeInMilliseconds() >= previous_expiry_ms_) {
+      LOG(LS_INFO) << "Previous inbound media crypto key expired";
+      previous_ = nullptr;
+      previous_first_ = false;
+    }
+    first = current_;
+    second = previous_;
+    if (previous_first_)
+      std::swap(first, second);
+  }
+  if (!first)
+    return false;
+  if (!second)
+    return first->Decrypt(payload, payload_length);
+
+  // A failed attempt may leave the payload partially decrypted, keep the
+  // ciphertext around for the other epoch.
+  ciphertext_.assign(payload, payload + *payload_length);
+  size_t length = *payload_length;
+  if (first->Decrypt(payload, &length)) {
+    OnInboundEpochUsed(first.get());
+    *payload_length = length;
+    return true;
+  }
+  memcpy(payload, ciphertext_.data(), ciphertext_.size());
+  length = *payload_length;
+  if (!second->Decrypt(payload, &length))
+    return false;
+  OnInboundEpochUsed(second.get());
+  *payload_length = length;
+  return true;
+}
+
+void MediaCryptoEpochs::OnInboundEpochUsed(const Epoch* epoch) {
+  rtc::CritScope lock(&crit_);
+  if (!previous_)
+    return;
+  if (epoch == current_.get()) {
+    previous_first_ = false;
+    if (previous_expiry_ms_ < 0)
+      previous_expiry_ms_ = clock_->TimeInMilliseconds() + grace_period_ms_;
+  } else if (epoch == previous_.get()) {
+    previous_first_ = true;
+  }
+}
+
+std::vector<MediaCryptoStats> MediaCryptoEpochs::GetInboundStats() const {
+  rtc::scoped_refptr<Epoch> current;
+  rtc::scoped_refptr<Epoch> previous;
+  {
+    rtc::CritScope lock(&crit_);
+    current = current_;
+    previous = previous_;
+  }
+  std::vector<MediaCryptoStats> stats;
+  if (current)
+    stats = current->GetInboundStats();
+  if (!previous)
+    return stats;
+
+  std::map<uint32_t, size_t> index;
+  for (size_t i = 0; i < stats.size(); ++i)
+    index[stats[i].ssrc] = i;
+  for (const MediaCryptoStats& entry : previous->GetInboundStats()) {
+    auto it = index.find(entry.ssrc);
+    if (it == index.end()) {
+      stats.push_back(entry);
+      continue;
+    }
+    MediaCryptoStats& sum = stats[it->second];
+    sum.packets += entry.packets;
+    sum.replay_drops += entry.replay_drops;
+    sum.auth_failures += entry.auth_failures;
+  }
+  return stats;
+}
+
+size_t MediaCryptoEpochs::GetNumInboundEpochs() const {
+  rtc::CritScope lock(&crit_);
+  return previous_ ? 2 : (current_ ? 1 : 0);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_MEDIA_CRYPTO_EPOCHS_H_
+#define WEBRTC_MODULES_RTP_RTCP_SOURCE_MEDIA_CRYPTO_EPOCHS_H_
+
+#include <vector>
+
+#include "webrtc/base/array_view.h"
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/refcount.h"
+#include "webrtc/base/scoped_ref_ptr.h"
+#include "webrtc/base/thread_annotations.h"
+#include "webrtc/config.h"
+#include "webrtc/modules/rtp_rtcp/source/media_crypto.h"
+
+namespace webrtc {
+
+class Clock;
+
+// Rotates the end to end media key without tearing down the stream. Every key
+// installed gets its own MediaCrypto instance (an epoch).
+//
+// Outbound, the first key is used right away and later keys are switched to
+// at the start of the next Encrypt/EncryptBatch call, so a frame is never
+// split across two keys.
+//
+// Inbound, the previous epoch is kept around and tried when the current one
+// fails to authenticate a packet. It is dropped |grace_period_ms| after the
+// first packet was decrypted with the current epoch, so receivers can be given
+// the new key well before the senders switch to it. Setting the current
+// inbound key again is a no-op, and a key that replaced the previous one but
+// never decrypted a packet is itself replaced by the next key.
+class MediaCryptoEpochs {
+ public:
+  static const int64_t kDefaultGracePeriodMs = 10000;
+
+  explicit MediaCryptoEpochs(Clock* clock);
+  MediaCryptoEpochs(Clock* clock, int64_t grace_period_ms);
+  ~MediaCryptoEpochs();
+
+  // True once a key has been installed.
+  bool enabled() const;
+
+  bool SetOutboundKey(const MediaCryptoKey& key, size_t num_workers);
+  bool Encrypt(rtp::Packet* packet);
+  bool EncryptBatch(rtc::ArrayView<rtp::Packet* const> packets);
+  size_t GetEncryptionOverhead();
+  // Packets encrypted so far, across all outbound epochs. Retransmissions and
+  // FEC reuse the stored protected payload, so this only grows with media.
+  uint32_t GetNumEncryptedPackets() const;
+
+  bool SetInboundKey(const MediaCryptoKey& key);
+  // Must not be called concurrently, the ciphertext is saved in a member
+  // buffer while both epochs are live.
+  bool Decrypt(uint8_t* payload, size_t* payload_length);
+  // Stats of the current and previous epochs, summed per SSRC.
+  std::vector<MediaCryptoStats> GetInboundStats() const;
+
+  // Number of epochs a packet may be tried against, at most 2.
+  size_t GetNumInboundEpochs() const;
+
+ private:
+  typedef rtc::RefCountedObject<MediaCrypto> Epoch;
+
+  rtc::scoped_refptr<Epoch> GetOutboundEpoch();
+  void OnInboundEpochUsed(const Epoch* epoch);
+
+  Clock* const clock_;
+  const int64_t grace_period_ms_;
+  volatile int enabled_;
+
+  rtc::CriticalSection crit_;
+  rtc::scoped_refptr<Epoch> current_ GUARDED_BY(crit_);
+  // Key of the current inbound epoch.
+  MediaCryptoKey inbound_key_ GUARDED_BY(crit_);
+  // Outbound key waiting for the next frame.
+  rtc::scoped_refptr<Epoch> pending_ GUARDED_BY(crit_);
+  // Inbound key replaced by |current_|.
+  rtc::scoped_refptr<Epoch> previous_ GUARDED_BY(crit_);
+  // -1 until the current epoch decrypts its first packet.
+  int64_t previous_expiry_ms_ GUARDED_BY(crit_);
+  // Set while the previous epoch is the one senders still use, so that it is
+  // tried first.
+  bool previous_first_ GUARDED_BY(crit_);
+  uint32_t encrypted_packets_ GUARDED_BY(crit_);
+
+  std::vector<uint8_t> ciphertext_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MediaCryptoEpochs);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_MEDIA_CRYPTO_EPOCHS_H_
@@ -0,0 +1,206 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/media_crypto_epochs.h"
+
+#include <memory>
+#include <vector>
+
+#include "third_party/libsrtp/include/srtp.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+namespace {
+constexpr uint32_t kSsrc = 0x12345678;
+constexpr size_t kPayloadSize = 200;
+constexpr int64_t kGracePeriodMs = 1000;
+
+MediaCryptoKey CreateKey(uint8_t seed) {
+  MediaCryptoKey key;
+  key.type = rtc::SRTP_AEAD_AES_256_GCM;
+  key.buffer.resize(32 + 12);
+  for (size_t i = 0; i < key.buffer.size(); ++i)
+    key.buffer[i] = static_cast<uint8_t>(i * 7 + seed);
+  return key;
+}
+
+std::unique_ptr<RtpPacketToSend> CreatePacket(uint16_t seq_num) {
+  std::unique_ptr<RtpPacketToSend> packet(new RtpPacketToSend(nullptr));
+  packet->SetSequenceNumber(seq_num);
+  packet->SetSsrc(kSsrc);
+  uint8_t* payload = packet->AllocatePayload(kPayloadSize);
+  for (size_t i = 0; i < kPayloadSize; ++i)
+    payload[i] = static_cast<uint8_t>(i);
+  return packet;
+}
+}  // namespace
+
+class MediaCryptoEpochsTest : public ::testing::Test {
+ protected:
+  MediaCryptoEpochsTest()
+      : clock_(1000),
+        sender_(&clock_),
+        receiver_(&clock_, kGracePeriodMs),
+        seq_num_(0) {
+    static bool srtp_initialized = srtp_init() == srtp_err_status_ok;
+    EXPECT_TRUE(srtp_initialized);
+    EXPECT_TRUE(sender_.SetOutboundKey(CreateKey(0), 0));
+    EXPECT_TRUE(receiver_.SetInboundKey(CreateKey(0)));
+  }
+
+  // Encrypts one single packet frame and returns the packet as sent.
+  std::vector<uint8_t> SendFrame() {
+    std::unique_ptr<RtpPacketToSend> packet = CreatePacket(seq_num_++);
+    header_size_ = packet->headers_size();
+    EXPECT_TRUE(sender_.Encrypt(packet.get()));
+    return std::vector<uint8_t>(packet->data(),
+                                packet->data() + packet->size());
+  }
+
+  bool Receive(MediaCryptoEpochs* receiver, std::vector<uint8_t> packet) {
+    size_t payload_length = packet.size() - header_size_;
+    if (!receiver->Decrypt(packet.data() + header_size_, &payload_length))
+      return false;
+    EXPECT_EQ(kPayloadSize, payload_length);
+    for (size_t i = 0; i < kPayloadSize; ++i)
+      EXPECT_EQ(static_cast<uint8_t>(i), packet[header_size_ + i]);
+    return true;
+  }
+
+  bool Receive(std::vector<uint8_t> packet) {
+    return Receive(&receiver_, packet);
+  }
+
+  SimulatedClock clock_;
+  MediaCryptoEpochs sender_;
+  MediaCryptoEpochs receiver_;
+  uint16_t seq_num_;
+  size_t header_size_ = 0;
+};
+
+TEST_F(MediaCryptoEpochsTest, DisabledUntilKeyIsSet) {
+  MediaCryptoEpochs epochs(&clock_);
+  EXPECT_FALSE(epochs.enabled());
+  EXPECT_EQ(0u, epochs.GetNumInboundEpochs());
+  EXPECT_TRUE(sender_.enabled());
+  EXPECT_TRUE(receiver_.enabled());
+}
+
+TEST_F(MediaCryptoEpochsTest, SenderSwitchesAtNextFrame) {
+  MediaCryptoEpochs new_key_receiver(&clock_);
+  ASSERT_TRUE(new_key_receiver.SetInboundKey(CreateKey(1)));
+
+  EXPECT_TRUE(Receive(SendFrame()));
+  ASSERT_TRUE(sender_.SetOutboundKey(CreateKey(1), 0));
+  std::vector<uint8_t> packet = SendFrame();
+  EXPECT_FALSE(Receive(packet));
+  EXPECT_TRUE(Receive(&new_key_receiver, packet));
+}
+
+TEST_F(MediaCryptoEpochsTest, FrameIsNotSplitAcrossKeys) {
+  ASSERT_TRUE(sender_.SetOutboundKey(CreateKey(1), 0));
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(1)));
+
+  std::vector<std::unique_ptr<RtpPacketToSend>> frame;
+  std::vector<rtp::Packet*> batch;
+  for (int i = 0; i < 5; ++i) {
+    frame.push_back(CreatePacket(seq_num_++));
+    batch.push_back(frame.back().get());
+  }
+  header_size_ = frame[0]->headers_size();
+  ASSERT_TRUE(sender_.EncryptBatch(batch));
+  EXPECT_EQ(5u, sender_.GetNumEncryptedPackets());
+
+  MediaCryptoEpochs new_key_receiver(&clock_);
+  ASSERT_TRUE(new_key_receiver.SetInboundKey(CreateKey(1)));
+  for (const auto& packet : frame) {
+    EXPECT_TRUE(Receive(&new_key_receiver,
+                        std::vector<uint8_t>(packet->data(),
+                                             packet->data() + packet->size())));
+  }
+}
+
+TEST_F(MediaCryptoEpochsTest, ReceiverAcceptsBothKeysDuringGracePeriod) {
+  std::vector<uint8_t> old_packet = SendFrame();
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(1)));
+  EXPECT_EQ(2u, receiver_.GetNumInboundEpochs());
+  ASSERT_TRUE(sender_.SetOutboundKey(CreateKey(1), 0));
+  std::vector<uint8_t> new_packet = SendFrame();
+
+  // Late packet from before the switch, then the new key.
+  EXPECT_TRUE(Receive(new_packet));
+  EXPECT_TRUE(Receive(old_packet));
+  EXPECT_TRUE(Receive(SendFrame()));
+}
+
+TEST_F(MediaCryptoEpochsTest, PreviousKeyExpiresAfterNewKeyIsUsed) {
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(1)));
+  std::vector<uint8_t> old_packet = SendFrame();
+  ASSERT_TRUE(sender_.SetOutboundKey(CreateKey(1), 0));
+  EXPECT_TRUE(Receive(SendFrame()));
+
+  clock_.AdvanceTimeMilliseconds(kGracePeriodMs);
+  EXPECT_FALSE(Receive(old_packet));
+  EXPECT_EQ(1u, receiver_.GetNumInboundEpochs());
+  EXPECT_TRUE(Receive(SendFrame()));
+}
+
+TEST_F(MediaCryptoEpochsTest, PreviousKeyKeptUntilNewKeyIsUsed) {
+  // Receivers may get the new key long before the sender switches to it.
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(1)));
+  clock_.AdvanceTimeMilliseconds(10 * kGracePeriodMs);
+  EXPECT_TRUE(Receive(SendFrame()));
+  EXPECT_TRUE(Receive(SendFrame()));
+  EXPECT_EQ(2u, receiver_.GetNumInboundEpochs());
+}
+
+TEST_F(MediaCryptoEpochsTest, SettingCurrentKeyAgainKeepsPreviousKey) {
+  // The next key is given to receivers first, then set again on every
+  // endpoint when the senders switch to it.
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(1)));
+  std::vector<uint8_t> old_packet = SendFrame();
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(1)));
+  ASSERT_TRUE(sender_.SetOutboundKey(CreateKey(1), 0));
+  EXPECT_EQ(2u, receiver_.GetNumInboundEpochs());
+
+  EXPECT_TRUE(Receive(SendFrame()));
+  EXPECT_TRUE(Receive(old_packet));
+  clock_.AdvanceTimeMilliseconds(kGracePeriodMs);
+  EXPECT_FALSE(Receive(old_packet));
+  EXPECT_TRUE(Receive(SendFrame()));
+}
+
+TEST_F(MediaCryptoEpochsTest, UnusedNextKeyIsReplaced) {
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(1)));
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(2)));
+  EXPECT_EQ(2u, receiver_.GetNumInboundEpochs());
+
+  // Senders never used the replaced key, the original one is kept.
+  EXPECT_TRUE(Receive(SendFrame()));
+  ASSERT_TRUE(sender_.SetOutboundKey(CreateKey(2), 0));
+  EXPECT_TRUE(Receive(SendFrame()));
+}
+
+TEST_F(MediaCryptoEpochsTest, InboundStatsSumBothEpochs) {
+  EXPECT_TRUE(Receive(SendFrame()));
+  ASSERT_TRUE(receiver_.SetInboundKey(CreateKey(1)));
+  ASSERT_TRUE(sender_.SetOutboundKey(CreateKey(1), 0));
+  EXPECT_TRUE(Receive(SendFrame()));
+
+  std::vector<MediaCryptoStats> stats = receiver_.GetInboundStats();
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ(kSsrc, stats[0].ssrc);
+  EXPECT_EQ(2u, stats[0].packets);
+}
+
+}  // namespace webrtc
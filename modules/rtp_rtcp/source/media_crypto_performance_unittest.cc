@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "third_party/libsrtp/include/srtp.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/modules/rtp_rtcp/source/media_crypto.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/field_trial.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+constexpr uint32_t kSsrc = 0x12345678;
+constexpr size_t kNumPackets = 20000;
+
+MediaCryptoKey CreateKey() {
+  MediaCryptoKey key;
+  key.type = rtc::SRTP_AEAD_AES_256_GCM;
+  key.buffer.resize(32 + 12);
+  for (size_t i = 0; i < key.buffer.size(); ++i)
+    key.buffer[i] = static_cast<uint8_t>(i * 7);
+  return key;
+}
+
+// Measures packets per second encrypted and decrypted on a single core for
+// the given payload size, with libsrtp or the AEAD engine selected by
+// |field_trials|. Packets are built up front so only the crypto path is
+// timed.
+void RunMediaCryptoTest(size_t payload_size,
+                        const std::string& field_trials,
+                        const std::string& trace) {
+  static bool srtp_initialized = srtp_init() == srtp_err_status_ok;
+  ASSERT_TRUE(srtp_initialized);
+  test::ScopedFieldTrials override_field_trials(field_trials);
+  MediaCrypto sender;
+  MediaCrypto receiver;
+  ASSERT_TRUE(sender.SetOutboundKey(CreateKey()));
+  ASSERT_TRUE(receiver.SetInboundKey(CreateKey()));
+
+  RtpPacketToSend packet(nullptr);
+  packet.SetSsrc(kSsrc);
+  std::vector<std::vector<uint8_t>> encrypted(kNumPackets);
+  Clock* clock = Clock::GetRealTimeClock();
+
+  int64_t encrypt_us = 0;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    packet.SetSequenceNumber(static_cast<uint16_t>(i));
+    memset(packet.AllocatePayload(payload_size), i, payload_size);
+    int64_t start_us = clock->TimeInMicroseconds();
+    ASSERT_TRUE(sender.Encrypt(&packet));
+    encrypt_us += clock->TimeInMicroseconds() - start_us;
+    encrypted[i].assign(packet.data(), packet.data() + packet.size());
+  }
+
+  const size_t header_size = packet.headers_size();
+  const int64_t decrypt_start_us = clock->TimeInMicroseconds();
+  for (std::vector<uint8_t>& buffer : encrypted) {
+    size_t payload_length = buffer.size() - header_size;
+    ASSERT_TRUE(receiver.Decrypt(buffer.data() + header_size, &payload_length));
+  }
+  int64_t decrypt_us = clock->TimeInMicroseconds() - decrypt_start_us;
+
+  test::PrintResult("media_crypto_encrypt", "", trace,
+                    static_cast<size_t>(kNumPackets * 1000000 /
+                                        std::max<int64_t>(encrypt_us, 1)),
+                    "packets/s", true);
+  test::PrintResult("media_crypto_decrypt", "", trace,
+                    static_cast<size_t>(kNumPackets * 1000000 /
+                                        std::max<int64_t>(decrypt_us, 1)),
+                    "packets/s", true);
+}
+}  // namespace
+
+TEST(MediaCryptoPerformanceTest, VideoPacket) {
+  RunMediaCryptoTest(1200, "WebRTC-MediaCryptoAead/Disabled/",
+                     "video_1200_bytes");
+}
+
+TEST(MediaCryptoPerformanceTest, OpusPacket) {
+  RunMediaCryptoTest(60, "WebRTC-MediaCryptoAead/Disabled/",
+                     "opus_60_bytes");
+}
+
+TEST(MediaCryptoPerformanceTest, VideoPacketAead) {
+  RunMediaCryptoTest(1200, "WebRTC-MediaCryptoAead/Enabled/",
+                     "video_1200_bytes_aead");
+}
+
+TEST(MediaCryptoPerformanceTest, OpusPacketAead) {
+  RunMediaCryptoTest(60, "WebRTC-MediaCryptoAead/Enabled/",
+                     "opus_60_bytes_aead");
+}
+
+}  // namespace webrtc
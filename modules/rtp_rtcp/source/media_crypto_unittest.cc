@@ -0,0 +1,387 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/media_crypto.h"
+
+#include <memory>
+#include <vector>
+
+#include "third_party/libsrtp/include/srtp.h"
+#include "webrtc/base/fakeclock.h"
+#include "webrtc/base/random.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "webrtc/test/gmock.h"
+#include "webrtc/test/gtest.h"
+
+using testing::ElementsAreArray;
+
+namespace webrtc {
+namespace {
+constexpr uint8_t kPayloadType = 100;
+constexpr uint32_t kSsrc = 0x12345678;
+constexpr uint16_t kSeqNum = 88;
+constexpr uint32_t kTimestamp = 0x65431278;
+constexpr size_t kOhbSize = 11;
+constexpr size_t kVideoPayloadSize = 1200;
+constexpr size_t kAudioPayloadSize = 60;
+
+MediaCryptoKey CreateKey() {
+  MediaCryptoKey key;
+  key.type = rtc::SRTP_AEAD_AES_256_GCM;
+  // 256 bit key plus 96 bit salt.
+  key.buffer.resize(32 + 12);
+  for (size_t i = 0; i < key.buffer.size(); ++i)
+    key.buffer[i] = static_cast<uint8_t>(i * 7);
+  return key;
+}
+
+std::unique_ptr<RtpPacketToSend> CreatePacket(uint16_t seq_num,
+                                              size_t payload_size,
+                                              uint32_t ssrc = kSsrc) {
+  std::unique_ptr<RtpPacketToSend> packet(new RtpPacketToSend(nullptr));
+  packet->SetPayloadType(kPayloadType);
+  packet->SetSequenceNumber(seq_num);
+  packet->SetTimestamp(kTimestamp);
+  packet->SetSsrc(ssrc);
+  uint8_t* payload = packet->AllocatePayload(payload_size);
+  for (size_t i = 0; i < payload_size; ++i)
+    payload[i] = static_cast<uint8_t>(i);
+  return packet;
+}
+}  // namespace
+
+class MediaCryptoTest : public ::testing::Test {
+ protected:
+  MediaCryptoTest() {
+    // MediaCrypto relies on libsrtp being initialized by the SRTP transport.
+    static bool srtp_initialized = srtp_init() == srtp_err_status_ok;
+    EXPECT_TRUE(srtp_initialized);
+    EXPECT_TRUE(sender_.SetOutboundKey(CreateKey()));
+    EXPECT_TRUE(receiver_.SetInboundKey(CreateKey()));
+  }
+
+  void RoundTrip(size_t payload_size) {
+    std::unique_ptr<RtpPacketToSend> packet =
+        CreatePacket(kSeqNum, payload_size);
+    std::vector<uint8_t> plain(packet->payload().begin(),
+                               packet->payload().end());
+    std::vector<uint8_t> header(packet->data(),
+                                packet->data() + packet->headers_size());
+
+    ASSERT_TRUE(sender_.Encrypt(packet.get()));
+    EXPECT_EQ(payload_size + sender_.GetEncryptionOverhead(),
+              packet->payload_size());
+    // Outer header must be left untouched.
+    EXPECT_THAT(header,
+                ElementsAreArray(packet->data(), packet->headers_size()));
+
+    std::vector<uint8_t> received(packet->data(),
+                                  packet->data() + packet->size());
+    uint8_t* payload = received.data() + packet->headers_size();
+    size_t payload_length = packet->payload_size();
+    ASSERT_TRUE(receiver_.Decrypt(payload, &payload_length));
+    EXPECT_THAT(plain, ElementsAreArray(payload, payload_length));
+    EXPECT_THAT(header, ElementsAreArray(received.data(), header.size()));
+  }
+
+  bool EncryptAndDecrypt(uint16_t seq_num, uint32_t ssrc) {
+    std::unique_ptr<RtpPacketToSend> packet =
+        CreatePacket(seq_num, kAudioPayloadSize, ssrc);
+    EXPECT_TRUE(sender_.Encrypt(packet.get()));
+    std::vector<uint8_t> received(packet->data(),
+                                  packet->data() + packet->size());
+    size_t payload_length = packet->payload_size();
+    return receiver_.Decrypt(received.data() + packet->headers_size(),
+                             &payload_length);
+  }
+
+  MediaCrypto sender_;
+  MediaCrypto receiver_;
+};
+
+TEST_F(MediaCryptoTest, RoundTripVideoPacket) {
+  RoundTrip(kVideoPayloadSize);
+}
+
+TEST_F(MediaCryptoTest, RoundTripAudioPacket) {
+  RoundTrip(kAudioPayloadSize);
+}
+
+TEST_F(MediaCryptoTest, EncryptWritesOhb) {
+  std::unique_ptr<RtpPacketToSend> packet =
+      CreatePacket(kSeqNum, kAudioPayloadSize);
+  packet->SetMarker(true);
+  ASSERT_TRUE(sender_.Encrypt(packet.get()));
+  // clang-format off
+  const uint8_t kOhb[kOhbSize] = {
+      0x80 | kPayloadType, 0x00, kSeqNum,
+      0x65, 0x43, 0x12, 0x78,
+      0x12, 0x34, 0x56, 0x78};
+  // clang-format on
+  EXPECT_THAT(kOhb, ElementsAreArray(packet->payload().data(), kOhbSize));
+}
+
+TEST_F(MediaCryptoTest, EncryptFailsWithoutRoomForOverhead) {
+  std::unique_ptr<RtpPacketToSend> packet(new RtpPacketToSend(nullptr, 100));
+  packet->SetSsrc(kSsrc);
+  packet->AllocatePayload(packet->MaxPayloadSize());
+  EXPECT_FALSE(sender_.Encrypt(packet.get()));
+}
+
+TEST_F(MediaCryptoTest, DecryptFailsOnTamperedPayload) {
+  ASSERT_TRUE(EncryptAndDecrypt(kSeqNum - 1, kSsrc));
+  std::unique_ptr<RtpPacketToSend> packet =
+      CreatePacket(kSeqNum, kVideoPayloadSize);
+  ASSERT_TRUE(sender_.Encrypt(packet.get()));
+
+  std::vector<uint8_t> received(packet->data(),
+                                packet->data() + packet->size());
+  received[packet->headers_size() + kOhbSize] ^= 0x01;
+  size_t payload_length = packet->payload_size();
+  EXPECT_FALSE(receiver_.Decrypt(received.data() + packet->headers_size(),
+                                 &payload_length));
+
+  std::vector<MediaCryptoStats> stats = receiver_.GetInboundStats();
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ(kSsrc, stats[0].ssrc);
+  EXPECT_EQ(1u, stats[0].auth_failures);
+  EXPECT_EQ(1u, stats[0].packets);
+}
+
+TEST_F(MediaCryptoTest, ForgedSsrcsDoNotTakeInboundContexts) {
+  // Forged packets carry random OHB SSRCs and fail to authenticate, they must
+  // not keep a real sender from getting a context for long.
+  rtc::ScopedFakeClock fake_clock;
+  MediaCrypto receiver;
+  ASSERT_TRUE(receiver.SetInboundKey(CreateKey()));
+  Random random(0x1234);
+  for (size_t i = 0; i < 4 * MediaCrypto::kMaxInboundContexts; ++i) {
+    // Decrypt borrows the byte before the payload.
+    std::vector<uint8_t> forged(1 + kAudioPayloadSize +
+                                sender_.GetEncryptionOverhead());
+    for (uint8_t& byte : forged)
+      byte = random.Rand<uint8_t>();
+    size_t payload_length = forged.size() - 1;
+    EXPECT_FALSE(receiver.Decrypt(forged.data() + 1, &payload_length));
+  }
+  EXPECT_EQ(0u, receiver.GetNumInboundContexts());
+
+  // New senders are refused until a second has passed since the flood began.
+  std::unique_ptr<RtpPacketToSend> packet =
+      CreatePacket(kSeqNum, kAudioPayloadSize);
+  ASSERT_TRUE(sender_.Encrypt(packet.get()));
+  for (int i = 0; i < 2; ++i) {
+    std::vector<uint8_t> received(packet->data(),
+                                  packet->data() + packet->size());
+    size_t payload_length = packet->payload_size();
+    EXPECT_EQ(i == 1, receiver.Decrypt(received.data() + packet->headers_size(),
+                                       &payload_length));
+    fake_clock.AdvanceTime(rtc::TimeDelta::FromSeconds(1));
+  }
+  EXPECT_EQ(1u, receiver.GetNumInboundContexts());
+}
+
+TEST_F(MediaCryptoTest, KeepsStatsOfFailuresBeforeFirstPacket) {
+  std::unique_ptr<RtpPacketToSend> packet =
+      CreatePacket(kSeqNum, kAudioPayloadSize);
+  ASSERT_TRUE(sender_.Encrypt(packet.get()));
+  for (int i = 0; i < 3; ++i) {
+    std::vector<uint8_t> received(packet->data(),
+                                  packet->data() + packet->size());
+    uint8_t* payload = received.data() + packet->headers_size();
+    if (i < 2)
+      payload[kOhbSize] ^= 0x01;
+    size_t payload_length = packet->payload_size();
+    EXPECT_EQ(i == 2, receiver_.Decrypt(payload, &payload_length));
+    EXPECT_EQ(i == 2 ? 1u : 0u, receiver_.GetNumInboundContexts());
+  }
+
+  std::vector<MediaCryptoStats> stats = receiver_.GetInboundStats();
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ(2u, stats[0].auth_failures);
+  EXPECT_EQ(1u, stats[0].packets);
+}
+
+TEST_F(MediaCryptoTest, EvictsLeastRecentlyUsedInboundContext) {
+  // One sender keeps talking while many others come and go.
+  const uint32_t kNumSsrcs = 2 * MediaCrypto::kMaxInboundContexts;
+  for (uint32_t ssrc = 1; ssrc <= kNumSsrcs; ++ssrc) {
+    EXPECT_TRUE(EncryptAndDecrypt(kSeqNum + ssrc, kSsrc));
+    EXPECT_TRUE(EncryptAndDecrypt(kSeqNum, ssrc));
+  }
+  EXPECT_EQ(MediaCrypto::kMaxInboundContexts,
+            receiver_.GetNumInboundContexts());
+
+  // The active sender kept its context, and the most recent senders theirs.
+  std::vector<MediaCryptoStats> stats = receiver_.GetInboundStats();
+  ASSERT_EQ(MediaCrypto::kMaxInboundContexts, stats.size());
+  for (const MediaCryptoStats& entry : stats) {
+    if (entry.ssrc == kSsrc) {
+      EXPECT_EQ(kNumSsrcs, entry.packets);
+    } else {
+      EXPECT_GT(entry.ssrc, kNumSsrcs - MediaCrypto::kMaxInboundContexts);
+    }
+  }
+  EXPECT_TRUE(EncryptAndDecrypt(kSeqNum + kNumSsrcs + 1, kSsrc));
+  EXPECT_TRUE(EncryptAndDecrypt(kSeqNum + 1, kNumSsrcs));
+}
+
+TEST_F(MediaCryptoTest, CreatesInboundContextPerSsrc) {
+  const uint32_t kOtherSsrc = 0x87654321;
+  EXPECT_EQ(0u, receiver_.GetNumInboundContexts());
+  EXPECT_TRUE(EncryptAndDecrypt(kSeqNum, kSsrc));
+  EXPECT_TRUE(EncryptAndDecrypt(kSeqNum, kOtherSsrc));
+  EXPECT_TRUE(EncryptAndDecrypt(kSeqNum + 1, kSsrc));
+  EXPECT_EQ(2u, receiver_.GetNumInboundContexts());
+
+  std::vector<MediaCryptoStats> stats = receiver_.GetInboundStats();
+  ASSERT_EQ(2u, stats.size());
+  for (const MediaCryptoStats& entry : stats) {
+    EXPECT_EQ(entry.ssrc == kSsrc ? 2u : 1u, entry.packets);
+    EXPECT_EQ(0u, entry.replay_drops);
+    EXPECT_EQ(0u, entry.auth_failures);
+  }
+}
+
+TEST_F(MediaCryptoTest, ManySsrcsDoNotShareReplayWindow) {
+  // Same sequence numbers on every SSRC must not be seen as replays.
+  const uint32_t kNumSsrcs = 64;
+  for (uint32_t ssrc = 1; ssrc <= kNumSsrcs; ++ssrc)
+    EXPECT_TRUE(EncryptAndDecrypt(kSeqNum, ssrc));
+  EXPECT_EQ(kNumSsrcs, receiver_.GetNumInboundContexts());
+}
+
+TEST_F(MediaCryptoTest, DropsAndCountsReplayedPacket) {
+  std::unique_ptr<RtpPacketToSend> packet =
+      CreatePacket(kSeqNum, kAudioPayloadSize);
+  ASSERT_TRUE(sender_.Encrypt(packet.get()));
+  for (int i = 0; i < 2; ++i) {
+    std::vector<uint8_t> received(packet->data(),
+                                  packet->data() + packet->size());
+    size_t payload_length = packet->payload_size();
+    EXPECT_EQ(i == 0, receiver_.Decrypt(
+                          received.data() + packet->headers_size(),
+                          &payload_length));
+  }
+
+  std::vector<MediaCryptoStats> stats = receiver_.GetInboundStats();
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ(1u, stats[0].packets);
+  EXPECT_EQ(1u, stats[0].replay_drops);
+}
+
+TEST_F(MediaCryptoTest, ConfigurableReplayWindow) {
+  MediaCryptoKey key = CreateKey();
+  key.replay_window_size = 32;
+  MediaCrypto too_small;
+  EXPECT_FALSE(too_small.SetInboundKey(key));
+
+  key.replay_window_size = 4096;
+  MediaCrypto large;
+  EXPECT_TRUE(large.SetInboundKey(key));
+}
+
+TEST_F(MediaCryptoTest, EncryptBatchMatchesSingleEncrypt) {
+  const size_t kNumPackets = 100;
+  MediaCrypto batch_sender;
+  ASSERT_TRUE(batch_sender.SetOutboundKey(CreateKey()));
+  ASSERT_TRUE(batch_sender.EnableWorkers(3));
+
+  std::vector<std::unique_ptr<RtpPacketToSend>> packets;
+  std::vector<rtp::Packet*> batch;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    packets.push_back(CreatePacket(kSeqNum + i, kVideoPayloadSize));
+    batch.push_back(packets.back().get());
+  }
+  ASSERT_TRUE(batch_sender.EncryptBatch(batch));
+
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    std::unique_ptr<RtpPacketToSend> expected =
+        CreatePacket(kSeqNum + i, kVideoPayloadSize);
+    ASSERT_TRUE(sender_.Encrypt(expected.get()));
+    EXPECT_THAT(std::vector<uint8_t>(expected->data(),
+                                     expected->data() + expected->size()),
+                ElementsAreArray(packets[i]->data(), packets[i]->size()));
+
+    const RtpPacketToSend& packet = *packets[i];
+    std::vector<uint8_t> received(packet.data(),
+                                  packet.data() + packet.size());
+    size_t payload_length = packet.payload_size();
+    EXPECT_TRUE(receiver_.Decrypt(received.data() + packet.headers_size(),
+                                  &payload_length));
+    EXPECT_EQ(kVideoPayloadSize, payload_length);
+  }
+}
+
+TEST_F(MediaCryptoTest, EncryptSmallBatchesWithWorkers) {
+  // Frames too small to split are encrypted on the calling thread.
+  MediaCrypto batch_sender;
+  ASSERT_TRUE(batch_sender.SetOutboundKey(CreateKey()));
+  ASSERT_TRUE(batch_sender.EnableWorkers(2));
+  for (uint16_t i = 0; i < 10; ++i) {
+    std::unique_ptr<RtpPacketToSend> packet =
+        CreatePacket(kSeqNum + i, kAudioPayloadSize);
+    rtp::Packet* batch[] = {packet.get()};
+    ASSERT_TRUE(batch_sender.EncryptBatch(batch));
+
+    std::vector<uint8_t> received(packet->data(),
+                                  packet->data() + packet->size());
+    size_t payload_length = packet->payload_size();
+    EXPECT_TRUE(receiver_.Decrypt(received.data() + packet->headers_size(),
+                                  &payload_length));
+  }
+}
+
+TEST_F(MediaCryptoTest, EncryptBatchAcrossWrapWithIdleWorkers) {
+  // Mid-size frames leave some workers idle while the sequence number wraps,
+  // a large frame reaching them afterwards must still use the right indexes.
+  const size_t kMidSizeFramePackets = 2 * 16;
+  const size_t kLargeFramePackets = 4 * 16;
+  MediaCrypto batch_sender;
+  ASSERT_TRUE(batch_sender.SetOutboundKey(CreateKey()));
+  ASSERT_TRUE(batch_sender.EnableWorkers(3));
+
+  uint16_t seq_num = kSeqNum;
+  size_t num_packets = 0;
+  while (num_packets < 0x18000 + kLargeFramePackets) {
+    const size_t frame_packets = num_packets < 0x18000 ? kMidSizeFramePackets
+                                                       : kLargeFramePackets;
+    std::vector<std::unique_ptr<RtpPacketToSend>> packets;
+    std::vector<rtp::Packet*> batch;
+    for (size_t i = 0; i < frame_packets; ++i) {
+      packets.push_back(CreatePacket(seq_num++, kAudioPayloadSize));
+      batch.push_back(packets.back().get());
+    }
+    ASSERT_TRUE(batch_sender.EncryptBatch(batch));
+    for (const std::unique_ptr<RtpPacketToSend>& packet : packets) {
+      std::vector<uint8_t> received(packet->data(),
+                                    packet->data() + packet->size());
+      size_t payload_length = packet->payload_size();
+      ASSERT_TRUE(receiver_.Decrypt(received.data() + packet->headers_size(),
+                                    &payload_length))
+          << "packet " << num_packets;
+      ++num_packets;
+    }
+  }
+}
+
+TEST_F(MediaCryptoTest, EnableWorkersRequiresKey) {
+  MediaCrypto crypto;
+  EXPECT_FALSE(crypto.EnableWorkers(2));
+}
+
+TEST_F(MediaCryptoTest, DecryptFailsOnShortPayload) {
+  std::vector<uint8_t> received(12 + kOhbSize);
+  size_t payload_length = kOhbSize;
+  EXPECT_FALSE(receiver_.Decrypt(received.data() + 12, &payload_length));
+}
+
+}  // namespace webrtc
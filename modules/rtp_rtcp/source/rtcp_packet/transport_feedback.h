@@ -45,6 +45,17 @@ class TransportFeedback : public Rtpfb {
     kReceivedLargeDelta,
   };
 
+  struct ReceivedPacket {
+    ReceivedPacket(uint16_t sequence_number, int16_t delta_ticks)
+        : sequence_number(sequence_number), delta_ticks(delta_ticks) {}
+    // Delta relative to the previous received packet, or the base time for
+    // the first one, in microseconds.
+    int32_t delta_us() const { return delta_ticks * kDeltaScaleFactor; }
+
+    uint16_t sequence_number;
+    int16_t delta_ticks;
+  };
+
   uint16_t GetBaseSequence() const;
   std::vector<TransportFeedback::StatusSymbol> GetStatusVector() const;
   std::vector<int16_t> GetReceiveDeltas() const;
@@ -54,6 +65,10 @@ class TransportFeedback : public Rtpfb {
   // Convenience method for getting all deltas as microseconds. The first delta
   // is relative the base time.
   std::vector<int64_t> GetReceiveDeltasUs() const;
+  // The received packets in sequence number order, without copying them.
+  const std::vector<ReceivedPacket>& GetReceivedPackets() const {
+    return packets_;
+  }
 
   bool Parse(const CommonHeader& packet);
   static std::unique_ptr<TransportFeedback> ParseFrom(const uint8_t* buffer,
@@ -76,12 +91,6 @@ class TransportFeedback : public Rtpfb {
   using DeltaSize = uint8_t;
   // Keeps DeltaSizes that can be encoded into single chunk if it is last chunk.
   class LastChunk;
-  struct ReceivedPacket {
-    ReceivedPacket(uint16_t sequence_number, int16_t delta_ticks)
-        : sequence_number(sequence_number), delta_ticks(delta_ticks) {}
-    uint16_t sequence_number;
-    int16_t delta_ticks;
-  };
 
   // Reset packet to consistent empty state.
   void Clear();
@@ -349,7 +349,8 @@ std::string RtpPacketizerH264::ToString() {
   return "RtpPacketizerH264";
 }
 
-RtpDepacketizerH264::RtpDepacketizerH264() : offset_(0), length_(0) {}
+RtpDepacketizerH264::RtpDepacketizerH264()
+    : offset_(0), length_(0), use_modified_buffer_(false) {}
 RtpDepacketizerH264::~RtpDepacketizerH264() {}
 
 bool RtpDepacketizerH264::Parse(ParsedPayload* parsed_payload,
@@ -363,7 +364,7 @@ bool RtpDepacketizerH264::Parse(ParsedPayload* parsed_payload,
 
   offset_ = 0;
   length_ = payload_data_length;
-  modified_buffer_.reset();
+  use_modified_buffer_ = false;
 
   uint8_t nal_type = payload_data[0] & kTypeMask;
   parsed_payload->type.Video.codecHeader.H264.nalus_length = 0;
@@ -380,7 +381,7 @@ bool RtpDepacketizerH264::Parse(ParsedPayload* parsed_payload,
   }
 
   const uint8_t* payload =
-      modified_buffer_ ? modified_buffer_->data() : payload_data;
+      use_modified_buffer_ ? modified_buffer_.data() : payload_data;
 
   parsed_payload->payload = payload + offset_;
   parsed_payload->payload_length = length_;
@@ -448,18 +449,18 @@ bool RtpDepacketizerH264::ProcessStapAOrSingleNalu(
         // excessive decoder latency.
 
         // Copy any previous data first (likely just the first header).
-        std::unique_ptr<rtc::Buffer> output_buffer(new rtc::Buffer());
+        sps_buffer_.Clear();
         if (start_offset)
-          output_buffer->AppendData(payload_data, start_offset);
+          sps_buffer_.AppendData(payload_data, start_offset);
 
         rtc::Optional<SpsParser::SpsState> sps;
 
         SpsVuiRewriter::ParseResult result = SpsVuiRewriter::ParseAndRewriteSps(
             &payload_data[start_offset], end_offset - start_offset, &sps,
-            output_buffer.get());
+            &sps_buffer_);
         switch (result) {
           case SpsVuiRewriter::ParseResult::kVuiRewritten:
-            if (modified_buffer_) {
+            if (use_modified_buffer_) {
               LOG(LS_WARNING)
                   << "More than one H264 SPS NAL units needing "
                      "rewriting found within a single STAP-A packet. "
@@ -472,18 +473,18 @@ bool RtpDepacketizerH264::ProcessStapAOrSingleNalu(
                   start_offset - (H264::kNaluTypeSize + kLengthFieldSize);
               // Stap-A Length includes payload data and type header.
               size_t rewritten_size =
-                  output_buffer->size() - start_offset + H264::kNaluTypeSize;
+                  sps_buffer_.size() - start_offset + H264::kNaluTypeSize;
               ByteWriter<uint16_t>::WriteBigEndian(
-                  &(*output_buffer)[length_field_offset], rewritten_size);
+                  &sps_buffer_[length_field_offset], rewritten_size);
             }
 
             // Append rest of packet.
-            output_buffer->AppendData(
-                &payload_data[end_offset],
-                nalu_length + kNalHeaderSize - end_offset);
+            sps_buffer_.AppendData(&payload_data[end_offset],
+                                   nalu_length + kNalHeaderSize - end_offset);
 
-            modified_buffer_ = std::move(output_buffer);
-            length_ = modified_buffer_->size();
+            swap(modified_buffer_, sps_buffer_);
+            use_modified_buffer_ = true;
+            length_ = modified_buffer_.size();
 
             RTC_HISTOGRAM_ENUMERATION(kSpsValidHistogramName,
                                       SpsValidEvent::kReceivedSpsRewritten,
@@ -598,9 +599,9 @@ bool RtpDepacketizerH264::ParseFuaNalu(
                       << static_cast<int>(nalu.type);
     }
     uint8_t original_nal_header = fnri | original_nal_type;
-    modified_buffer_.reset(new rtc::Buffer());
-    modified_buffer_->AppendData(payload_data + kNalHeaderSize, length_);
-    (*modified_buffer_)[0] = original_nal_header;
+    modified_buffer_.SetData(payload_data + kNalHeaderSize, length_);
+    modified_buffer_[0] = original_nal_header;
+    use_modified_buffer_ = true;
   } else {
     offset_ = kFuAHeaderSize;
     length_ -= kFuAHeaderSize;
@@ -117,7 +117,12 @@ class RtpDepacketizerH264 : public RtpDepacketizer {
 
   size_t offset_;
   size_t length_;
-  std::unique_ptr<rtc::Buffer> modified_buffer_;
+  // Holds the payload of the last parsed packet if it had to be modified, in
+  // which case |use_modified_buffer_| is set. Both buffers are kept between
+  // packets, so that their memory is reused.
+  rtc::Buffer modified_buffer_;
+  rtc::Buffer sps_buffer_;
+  bool use_modified_buffer_;
 };
 }  // namespace webrtc
 #endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_FORMAT_H264_H_
@@ -294,6 +294,17 @@ void Packet::SetPayloadSize(size_t size_bytes) {
   buffer_.SetSize(payload_offset_ + payload_size_);
 }
 
+uint8_t* Packet::ResizePayload(size_t size_bytes) {
+  RTC_DCHECK_EQ(padding_size_, 0);
+  if (payload_offset_ + size_bytes > capacity()) {
+    LOG(LS_WARNING) << "Cannot resize payload, not enough space in buffer.";
+    return nullptr;
+  }
+  payload_size_ = size_bytes;
+  buffer_.SetSize(payload_offset_ + payload_size_);
+  return WriteAt(payload_offset_);
+}
+
 bool Packet::SetPadding(uint8_t size_bytes, Random* random) {
   RTC_DCHECK(random);
   if (payload_offset_ + payload_size_ + size_bytes > capacity()) {
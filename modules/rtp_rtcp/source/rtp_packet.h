@@ -98,6 +98,9 @@ class Packet {
   // Reserve size_bytes for payload. Returns nullptr on failure.
   uint8_t* AllocatePayload(size_t size_bytes);
   void SetPayloadSize(size_t size_bytes);
+  // Same as AllocatePayload, but keeps payload already written to the packet,
+  // so it may be grown and transformed in place. Returns nullptr on failure.
+  uint8_t* ResizePayload(size_t size_bytes);
   bool SetPadding(uint8_t size_bytes, Random* random);
 
  protected:
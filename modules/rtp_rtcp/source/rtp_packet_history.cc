@@ -15,6 +15,7 @@
 
 #include "webrtc/base/checks.h"
 #include "webrtc/base/logging.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_pool.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
 #include "webrtc/system_wrappers/include/clock.h"
 
@@ -25,7 +26,10 @@ constexpr size_t kMinPacketRequestBytes = 50;
 constexpr size_t RtpPacketHistory::kMaxCapacity;
 
 RtpPacketHistory::RtpPacketHistory(Clock* clock)
-    : clock_(clock), store_(false), prev_index_(0) {}
+    : RtpPacketHistory(clock, nullptr) {}
+
+RtpPacketHistory::RtpPacketHistory(Clock* clock, RtpPacketPool* packet_pool)
+    : clock_(clock), packet_pool_(packet_pool), store_(false), prev_index_(0) {}
 
 RtpPacketHistory::~RtpPacketHistory() {}
 
@@ -73,6 +77,8 @@ void RtpPacketHistory::PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
   RTC_DCHECK(packet);
   rtc::CritScope cs(&critsect_);
   if (!store_) {
+    if (packet_pool_)
+      packet_pool_->Release(std::move(packet));
     return;
   }
 
@@ -100,6 +106,8 @@ void RtpPacketHistory::PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
       (sent ? clock_->TimeInMilliseconds() : 0);
   stored_packets_[prev_index_].storage_type = type;
   stored_packets_[prev_index_].has_been_retransmitted = false;
+  if (packet_pool_)
+    packet_pool_->Release(std::move(stored_packets_[prev_index_].packet));
   stored_packets_[prev_index_].packet = std::move(packet);
 
   ++prev_index_;
@@ -157,6 +165,8 @@ std::unique_ptr<RtpPacketToSend> RtpPacketHistory::GetPacketAndSetSendTime(
 
 std::unique_ptr<RtpPacketToSend> RtpPacketHistory::GetPacket(int index) const {
   const RtpPacketToSend& stored = *stored_packets_[index].packet;
+  if (packet_pool_)
+    return packet_pool_->Copy(stored);
   return std::unique_ptr<RtpPacketToSend>(new RtpPacketToSend(stored));
 }
 
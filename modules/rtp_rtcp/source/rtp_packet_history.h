@@ -23,12 +23,22 @@
 namespace webrtc {
 
 class Clock;
+class RtpPacketPool;
 class RtpPacketToSend;
 
+// Packets are stored exactly as they go out, so with end to end media
+// encryption the stored payload is the protected one. Packets handed out are
+// copies of the stored ones, and RTX, retransmissions and padding built from
+// them must not run the media crypto again.
+//
+// With a |packet_pool|, packets handed out are packet objects from the pool
+// that share the buffer of the stored packet, and packets dropped from the
+// history are given back to it.
 class RtpPacketHistory {
  public:
   static constexpr size_t kMaxCapacity = 9600;
   explicit RtpPacketHistory(Clock* clock);
+  RtpPacketHistory(Clock* clock, RtpPacketPool* packet_pool);
   ~RtpPacketHistory();
 
   void SetStorePacketsStatus(bool enable, uint16_t number_to_store);
@@ -74,6 +84,7 @@ class RtpPacketHistory {
       EXCLUSIVE_LOCKS_REQUIRED(critsect_);
 
   Clock* clock_;
+  RtpPacketPool* const packet_pool_;
   rtc::CriticalSection critsect_;
   bool store_ GUARDED_BY(critsect_);
   uint32_t prev_index_ GUARDED_BY(critsect_);
@@ -10,9 +10,12 @@
 
 #include "webrtc/modules/rtp_rtcp/source/rtp_packet_history.h"
 
+#include <string.h>
+
 #include <memory>
 
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_pool.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
 #include "webrtc/system_wrappers/include/clock.h"
 #include "webrtc/test/gtest.h"
@@ -23,6 +26,8 @@ namespace webrtc {
 class RtpPacketHistoryTest : public ::testing::Test {
  protected:
   static constexpr uint16_t kSeqNum = 88;
+  // Capacity of the packets of CreateRtpPacket().
+  static constexpr size_t kPacketCapacity = 1500;
 
   RtpPacketHistoryTest() : fake_clock_(123456), hist_(&fake_clock_) {}
 
@@ -83,6 +88,58 @@ TEST_F(RtpPacketHistoryTest, GetRtpPacket) {
   EXPECT_EQ(capture_time_ms, packet_out->capture_time_ms());
 }
 
+TEST_F(RtpPacketHistoryTest, PacketsShareStoredBuffer) {
+  RtpPacketPool pool(&fake_clock_, kPacketCapacity);
+  for (RtpPacketPool* packet_pool : {static_cast<RtpPacketPool*>(nullptr),
+                                     &pool}) {
+    SCOPED_TRACE(packet_pool ? "With pool" : "Without pool");
+    RtpPacketHistory hist(&fake_clock_, packet_pool);
+    hist.SetStorePacketsStatus(true, 10);
+    std::unique_ptr<RtpPacketToSend> packet = CreateRtpPacket(kSeqNum);
+    packet->AllocatePayload(100);
+    const uint8_t* stored_data = packet->data();
+    hist.PutRtpPacket(std::move(packet), kAllowRetransmission, true);
+
+    // Neither retransmissions nor padding copy the (possibly encrypted)
+    // payload.
+    std::unique_ptr<RtpPacketToSend> retransmission =
+        hist.GetPacketAndSetSendTime(kSeqNum, 0, true);
+    ASSERT_TRUE(retransmission);
+    EXPECT_EQ(stored_data, retransmission->data());
+    std::unique_ptr<RtpPacketToSend> padding = hist.GetBestFittingPacket(100);
+    ASSERT_TRUE(padding);
+    EXPECT_EQ(stored_data, padding->data());
+  }
+}
+
+TEST_F(RtpPacketHistoryTest, PooledPacketsShareBufferAndAreRecycled) {
+  RtpPacketPool pool(&fake_clock_, kPacketCapacity);
+  RtpPacketHistory hist(&fake_clock_, &pool);
+  hist.SetStorePacketsStatus(true, 1);
+  std::unique_ptr<RtpPacketToSend> packet = CreateRtpPacket(kSeqNum);
+  memset(packet->AllocatePayload(100), 0x5a, 100);
+  const uint8_t* stored_data = packet->data();
+  hist.PutRtpPacket(std::move(packet), kAllowRetransmission, true);
+
+  // Handed out packets are packet objects of the pool that share the buffer
+  // of the stored packet.
+  std::unique_ptr<RtpPacketToSend> retransmission =
+      hist.GetPacketAndSetSendTime(kSeqNum, 0, true);
+  ASSERT_TRUE(retransmission);
+  EXPECT_EQ(stored_data, retransmission->data());
+  EXPECT_EQ(100u, retransmission->payload_size());
+  EXPECT_EQ(0x5a, retransmission->payload()[99]);
+  pool.Release(std::move(retransmission));
+
+  // The packet that is dropped from the history to make room goes back to
+  // the pool.
+  hist.PutRtpPacket(CreateRtpPacket(kSeqNum + 1), kAllowRetransmission, true);
+  EXPECT_TRUE(hist.GetPacketAndSetSendTime(kSeqNum + 1, 0, false));
+  RtpPacketPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(1, stats.packets_allocated);
+  EXPECT_EQ(1, stats.packets_reused);
+}
+
 TEST_F(RtpPacketHistoryTest, NoCaptureTime) {
   hist_.SetStorePacketsStatus(true, 10);
   fake_clock_.AdvanceTimeMilliseconds(1);
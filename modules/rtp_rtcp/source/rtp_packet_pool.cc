@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_pool.h"
+
+#include <utility>
+
+#include "webrtc/base/checks.h"
+#include "webrtc/system_wrappers/include/clock.h"
+
+namespace webrtc {
+namespace {
+// Enough for the packets of a large key frame that are sent without being
+// stored, or are stored in a packet history that is full.
+constexpr size_t kMaxFreePackets = 512;
+constexpr int64_t kAllocationRateWindowMs = 1000;
+// Packets per millisecond to packets per second.
+constexpr float kPacketsPerSecondScale = 1000.0f;
+}  // namespace
+
+RtpPacketPool::RtpPacketPool(Clock* clock, size_t packet_capacity)
+    : clock_(clock),
+      packet_capacity_(packet_capacity),
+      packets_allocated_(0),
+      packets_reused_(0),
+      allocation_rate_(kAllocationRateWindowMs, kPacketsPerSecondScale) {
+  free_packets_.reserve(kMaxFreePackets);
+}
+
+RtpPacketPool::~RtpPacketPool() {}
+
+void RtpPacketPool::SetPacketCapacity(size_t packet_capacity) {
+  rtc::CritScope cs(&crit_);
+  if (packet_capacity == packet_capacity_)
+    return;
+  packet_capacity_ = packet_capacity;
+  free_packets_.clear();
+}
+
+size_t RtpPacketPool::packet_capacity() const {
+  rtc::CritScope cs(&crit_);
+  return packet_capacity_;
+}
+
+std::unique_ptr<RtpPacketToSend> RtpPacketPool::Get(
+    const RtpPacketToSend::ExtensionManager& extensions) {
+  std::unique_ptr<RtpPacketToSend> packet = Take();
+  packet->IdentifyExtensions(extensions);
+  return packet;
+}
+
+std::unique_ptr<RtpPacketToSend> RtpPacketPool::Copy(
+    const RtpPacketToSend& packet) {
+  std::unique_ptr<RtpPacketToSend> copy = Take();
+  *copy = packet;
+  return copy;
+}
+
+std::unique_ptr<RtpPacketToSend> RtpPacketPool::CopyHeader(
+    const RtpPacketToSend& packet) {
+  std::unique_ptr<RtpPacketToSend> copy = Take();
+  copy->CopyHeaderFrom(packet);
+  copy->set_capture_time_ms(packet.capture_time_ms());
+  return copy;
+}
+
+void RtpPacketPool::Release(std::unique_ptr<RtpPacketToSend> packet) {
+  if (!packet)
+    return;
+  // Done outside the lock. If the buffer is still shared with a copy of the
+  // packet, this is where the packet gets a buffer of its own.
+  packet->Clear();
+  packet->set_capture_time_ms(0);
+
+  rtc::CritScope cs(&crit_);
+  if (packet->capacity() != packet_capacity_ ||
+      free_packets_.size() >= kMaxFreePackets) {
+    return;
+  }
+  free_packets_.push_back(std::move(packet));
+}
+
+RtpPacketPool::Stats RtpPacketPool::GetStats() const {
+  rtc::CritScope cs(&crit_);
+  Stats stats;
+  stats.packets_allocated = packets_allocated_;
+  stats.packets_reused = packets_reused_;
+  stats.allocations_per_second =
+      allocation_rate_.Rate(clock_->TimeInMilliseconds()).value_or(0);
+  return stats;
+}
+
+std::unique_ptr<RtpPacketToSend> RtpPacketPool::Take() {
+  size_t packet_capacity;
+  {
+    rtc::CritScope cs(&crit_);
+    if (!free_packets_.empty()) {
+      std::unique_ptr<RtpPacketToSend> packet = std::move(free_packets_.back());
+      free_packets_.pop_back();
+      ++packets_reused_;
+      return packet;
+    }
+    ++packets_allocated_;
+    allocation_rate_.Update(1, clock_->TimeInMilliseconds());
+    packet_capacity = packet_capacity_;
+  }
+  return std::unique_ptr<RtpPacketToSend>(
+      new RtpPacketToSend(nullptr, packet_capacity));
+}
+
+}  // namespace webrtc
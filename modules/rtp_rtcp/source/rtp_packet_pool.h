@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_PACKET_POOL_H_
+#define WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_PACKET_POOL_H_
+
+#include <memory>
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/rate_statistics.h"
+#include "webrtc/base/thread_annotations.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_to_send.h"
+
+namespace webrtc {
+
+class Clock;
+
+// Pool of packets with buffers of a fixed capacity, so that a sender creates
+// packets without allocating them or their buffers once the pool has warmed
+// up. Packets handed out are ordinary RtpPacketToSend owned by the caller, who
+// gives them back with Release() when done with them. Packets that are not
+// given back are simply deleted, and are replaced by newly allocated ones.
+//
+// Thread safe, packets are typically created on the encoder thread and given
+// back on the pacer thread.
+class RtpPacketPool {
+ public:
+  struct Stats {
+    // Packets allocated since the pool was created, and packets taken from
+    // the pool instead.
+    int64_t packets_allocated = 0;
+    int64_t packets_reused = 0;
+    // Packets allocated per second, over the last second.
+    uint32_t allocations_per_second = 0;
+  };
+
+  RtpPacketPool(Clock* clock, size_t packet_capacity);
+  ~RtpPacketPool();
+
+  // Packets in the pool with another capacity are deleted.
+  void SetPacketCapacity(size_t packet_capacity);
+  size_t packet_capacity() const;
+
+  // Returns an empty packet, see rtp::Packet::Clear(), with |extensions|
+  // identified.
+  std::unique_ptr<RtpPacketToSend> Get(
+      const RtpPacketToSend::ExtensionManager& extensions);
+
+  // Returns a copy of |packet| that, like with the copy constructor, shares
+  // the buffer of |packet| until either of them is modified. Only the packet
+  // object is taken from the pool.
+  std::unique_ptr<RtpPacketToSend> Copy(const RtpPacketToSend& packet);
+
+  // Returns a packet with the header and capture time of |packet|, and no
+  // payload.
+  std::unique_ptr<RtpPacketToSend> CopyHeader(const RtpPacketToSend& packet);
+
+  // Puts |packet| back in the pool, or deletes it if it isn't of the capacity
+  // of the pool or the pool is full. |packet| may be null.
+  void Release(std::unique_ptr<RtpPacketToSend> packet);
+
+  Stats GetStats() const;
+
+ private:
+  // Takes a packet from the pool, or allocates one if the pool is empty. The
+  // extensions of the packet are those it was last used with.
+  std::unique_ptr<RtpPacketToSend> Take();
+
+  Clock* const clock_;
+  rtc::CriticalSection crit_;
+  size_t packet_capacity_ GUARDED_BY(crit_);
+  std::vector<std::unique_ptr<RtpPacketToSend>> free_packets_
+      GUARDED_BY(crit_);
+  int64_t packets_allocated_ GUARDED_BY(crit_);
+  int64_t packets_reused_ GUARDED_BY(crit_);
+  RateStatistics allocation_rate_ GUARDED_BY(crit_);
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RtpPacketPool);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_PACKET_POOL_H_
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_pool.h"
+
+#include <string.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "webrtc/modules/rtp_rtcp/source/rtp_header_extension.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/gtest.h"
+
+namespace webrtc {
+namespace {
+constexpr size_t kCapacity = 1200;
+constexpr uint8_t kAbsoluteSendTimeId = 3;
+constexpr uint32_t kSsrc = 0x12345678;
+constexpr size_t kPayloadSize = 500;
+}  // namespace
+
+class RtpPacketPoolTest : public ::testing::Test {
+ protected:
+  RtpPacketPoolTest() : clock_(1000), pool_(&clock_, kCapacity) {
+    extensions_.Register<AbsoluteSendTime>(kAbsoluteSendTimeId);
+  }
+
+  SimulatedClock clock_;
+  RtpHeaderExtensionMap extensions_;
+  RtpPacketPool pool_;
+};
+
+TEST_F(RtpPacketPoolTest, ReusesReleasedPackets) {
+  std::unique_ptr<RtpPacketToSend> packet = pool_.Get(extensions_);
+  EXPECT_EQ(kCapacity, packet->capacity());
+  const RtpPacketToSend* first = packet.get();
+  packet->SetSsrc(kSsrc);
+  packet->AllocatePayload(kPayloadSize);
+  pool_.Release(std::move(packet));
+
+  packet = pool_.Get(extensions_);
+  EXPECT_EQ(first, packet.get());
+  // Handed out empty.
+  EXPECT_EQ(0u, packet->Ssrc());
+  EXPECT_EQ(0u, packet->payload_size());
+  EXPECT_EQ(12u, packet->size());
+  EXPECT_TRUE(packet->SetExtension<AbsoluteSendTime>(1234));
+
+  RtpPacketPool::Stats stats = pool_.GetStats();
+  EXPECT_EQ(1, stats.packets_allocated);
+  EXPECT_EQ(1, stats.packets_reused);
+}
+
+TEST_F(RtpPacketPoolTest, CopySharesBuffer) {
+  std::unique_ptr<RtpPacketToSend> packet = pool_.Get(extensions_);
+  packet->SetSsrc(kSsrc);
+  packet->SetExtension<AbsoluteSendTime>(1234);
+  packet->set_capture_time_ms(567);
+  memset(packet->AllocatePayload(kPayloadSize), 0x5a, kPayloadSize);
+
+  std::unique_ptr<RtpPacketToSend> copy = pool_.Copy(*packet);
+  EXPECT_EQ(packet->data(), copy->data());
+  EXPECT_EQ(packet->size(), copy->size());
+  EXPECT_EQ(567, copy->capture_time_ms());
+  uint32_t abs_send_time = 0;
+  uint32_t copied_abs_send_time = 0;
+  EXPECT_TRUE(packet->GetExtension<AbsoluteSendTime>(&abs_send_time));
+  EXPECT_TRUE(copy->GetExtension<AbsoluteSendTime>(&copied_abs_send_time));
+  EXPECT_EQ(abs_send_time, copied_abs_send_time);
+
+  // Modifying the copy leaves |packet| as it was.
+  EXPECT_TRUE(copy->SetExtension<AbsoluteSendTime>(4321));
+  EXPECT_NE(packet->data(), copy->data());
+  EXPECT_TRUE(packet->GetExtension<AbsoluteSendTime>(&copied_abs_send_time));
+  EXPECT_EQ(abs_send_time, copied_abs_send_time);
+
+  std::unique_ptr<RtpPacketToSend> header = pool_.CopyHeader(*packet);
+  EXPECT_EQ(packet->headers_size(), header->size());
+  EXPECT_EQ(0u, header->payload_size());
+  EXPECT_EQ(kSsrc, header->Ssrc());
+  EXPECT_EQ(567, header->capture_time_ms());
+}
+
+TEST_F(RtpPacketPoolTest, DeletesPacketsOfOtherCapacity) {
+  std::unique_ptr<RtpPacketToSend> packet = pool_.Get(extensions_);
+  pool_.Release(std::unique_ptr<RtpPacketToSend>(
+      new RtpPacketToSend(nullptr, kCapacity + 1)));
+  pool_.SetPacketCapacity(kCapacity + 100);
+  pool_.Release(std::move(packet));
+
+  packet = pool_.Get(extensions_);
+  EXPECT_EQ(kCapacity + 100, packet->capacity());
+  EXPECT_EQ(2, pool_.GetStats().packets_allocated);
+  EXPECT_EQ(0, pool_.GetStats().packets_reused);
+}
+
+TEST_F(RtpPacketPoolTest, ReportsAllocationsPerSecond) {
+  // Held on to, so that every packet is allocated.
+  std::vector<std::unique_ptr<RtpPacketToSend>> packets;
+  for (int i = 0; i < 100; ++i) {
+    packets.push_back(pool_.Get(extensions_));
+    clock_.AdvanceTimeMilliseconds(10);
+  }
+  EXPECT_NEAR(100u, pool_.GetStats().allocations_per_second, 10u);
+
+  // Once warmed up, packets are reused.
+  for (auto& packet : packets)
+    pool_.Release(std::move(packet));
+  for (int i = 0; i < 100; ++i) {
+    pool_.Release(pool_.Get(extensions_));
+    clock_.AdvanceTimeMilliseconds(10);
+  }
+  EXPECT_EQ(0u, pool_.GetStats().allocations_per_second);
+  EXPECT_EQ(100, pool_.GetStats().packets_allocated);
+}
+
+}  // namespace webrtc
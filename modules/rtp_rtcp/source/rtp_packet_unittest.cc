@@ -162,6 +162,23 @@ TEST(RtpPacketTest, CreateUnalignedPadding) {
   EXPECT_EQ(packet.size(), packet.capacity());
 }
 
+TEST(RtpPacketTest, ResizePayloadKeepsPayload) {
+  RtpPacketToSend packet(nullptr);
+  packet.SetSsrc(kSsrc);
+  uint8_t* payload = packet.AllocatePayload(sizeof(kPayload));
+  memcpy(payload, kPayload, sizeof(kPayload));
+  // Share the buffer to make sure resize keeps payload on copy-on-write too.
+  rtc::CopyOnWriteBuffer shared = packet.Buffer();
+
+  payload = packet.ResizePayload(sizeof(kPayload) + 4);
+  ASSERT_TRUE(payload);
+  EXPECT_EQ(sizeof(kPayload) + 4, packet.payload_size());
+  EXPECT_THAT(kPayload, ElementsAreArray(payload, sizeof(kPayload)));
+  EXPECT_EQ(kSsrc, packet.Ssrc());
+
+  EXPECT_FALSE(packet.ResizePayload(packet.capacity()));
+}
+
 TEST(RtpPacketTest, ParseMinimum) {
   RtpPacketReceived packet;
   EXPECT_TRUE(packet.Parse(kMinimumPacket, sizeof(kMinimumPacket)));
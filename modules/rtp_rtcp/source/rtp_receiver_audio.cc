@@ -136,7 +136,7 @@ int32_t RTPReceiverAudio::ParseRtpPacket(WebRtcRTPHeader* rtp_header,
                                          int64_t timestamp_ms,
                                          bool is_first_packet,
                                          bool is_double_enabled,
-                                         MediaCrypto* media_crypto) {
+                                         MediaCryptoEpochs* media_crypto) {
   TRACE_EVENT2(TRACE_DISABLED_BY_DEFAULT("webrtc_rtp"), "Audio::ParseRtp",
                "seqnum", rtp_header->header.sequenceNumber, "timestamp",
                rtp_header->header.timestamp);
@@ -217,7 +217,7 @@ int32_t RTPReceiverAudio::ParseAudioCodecSpecific(
     const AudioPayload& audio_specific,
     bool is_red,
     bool is_double_enabled,
-		MediaCrypto* media_crypto) {
+		MediaCryptoEpochs* media_crypto) {
 
   if (payload_length == 0) {
     return 0;
@@ -52,7 +52,7 @@ class RTPReceiverAudio : public RTPReceiverStrategy,
                          int64_t timestamp_ms,
                          bool is_first_packet,
 			 bool is_double_enabled,
-			 MediaCrypto* media_crypto) override;
+			 MediaCryptoEpochs* media_crypto) override;
 
   RTPAliveType ProcessDeadOrAlive(uint16_t last_payload_length) const override;
 
@@ -81,7 +81,7 @@ class RTPReceiverAudio : public RTPReceiverStrategy,
                                   const AudioPayload& audio_specific,
                                   bool is_red,
 				  bool is_double_enabled, 
-				  MediaCrypto* media_crypto);
+				  MediaCryptoEpochs* media_crypto);
 
   bool telephone_event_forward_to_decoder_;
   int8_t telephone_event_payload_type_;
@@ -69,7 +69,8 @@ RtpReceiverImpl::RtpReceiverImpl(
       current_remote_csrc_(),
       last_received_timestamp_(0),
       last_received_frame_time_ms_(-1),
-      last_received_sequence_number_(0) {
+      last_received_sequence_number_(0),
+      media_crypto_(clock) {
   assert(incoming_messages_callback);
 
   memset(current_remote_csrc_, 0, sizeof(current_remote_csrc_));
@@ -177,7 +178,7 @@ bool RtpReceiverImpl::IncomingRtpPacket(
   int32_t ret_val = rtp_media_receiver_->ParseRtpPacket(
       &webrtc_rtp_header, payload_specific, is_red, payload, payload_data_length,
       clock_->TimeInMilliseconds(), is_first_packet_in_frame,
-      media_crypto_enabled_, &media_crypto_);
+      media_crypto_.enabled(), &media_crypto_);
 
   if (ret_val < 0) {
     return false;
@@ -466,8 +467,11 @@ bool RtpReceiverImpl::EnableMediaCrypto(const MediaCryptoKey &key) {
   
   LOG(LS_INFO) << "Enabling End to End Media Encription";
   
-  rtc::CritScope cs(&critical_section_rtp_receiver_);
-  media_crypto_enabled_ = media_crypto_.SetInboundKey(key);
-  return  media_crypto_enabled_;
+  // The previous key stays valid for a grace period, see MediaCryptoEpochs.
+  return media_crypto_.SetInboundKey(key);
+}
+
+std::vector<MediaCryptoStats> RtpReceiverImpl::GetMediaCryptoStats() const {
+  return media_crypto_.GetInboundStats();
 }
 }  // namespace webrtc
@@ -16,7 +16,7 @@
 #include "webrtc/base/criticalsection.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_receiver.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
-#include "webrtc/modules/rtp_rtcp/source/media_crypto.h"
+#include "webrtc/modules/rtp_rtcp/source/media_crypto_epochs.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_receiver_strategy.h"
 #include "webrtc/typedefs.h"
 
@@ -59,6 +59,7 @@ class RtpReceiverImpl : public RtpReceiver {
   
   // End to end media encryption
   bool EnableMediaCrypto(const MediaCryptoKey &key) override;
+  std::vector<MediaCryptoStats> GetMediaCryptoStats() const override;
 
  private:
   bool HaveReceivedFrame() const;
@@ -90,8 +91,7 @@ class RtpReceiverImpl : public RtpReceiver {
   uint16_t last_received_sequence_number_;
   
   // Double PERC encryption
-  bool media_crypto_enabled_;
-  MediaCrypto media_crypto_;
+  MediaCryptoEpochs media_crypto_;
 };
 }  // namespace webrtc
 #endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_RECEIVER_IMPL_H_
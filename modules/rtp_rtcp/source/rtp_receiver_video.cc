@@ -57,7 +57,7 @@ int32_t RTPReceiverVideo::ParseRtpPacket(WebRtcRTPHeader* rtp_header,
                                          int64_t timestamp_ms,
                                          bool is_first_packet,
                                          bool is_double_enabled,
-                                         MediaCrypto *media_crypto) {
+                                         MediaCryptoEpochs *media_crypto) {
   TRACE_EVENT2(TRACE_DISABLED_BY_DEFAULT("webrtc_rtp"), "Video::ParseRtp",
                "seqnum", rtp_header->header.sequenceNumber, "timestamp",
                rtp_header->header.timestamp);
@@ -77,9 +77,9 @@ int32_t RTPReceiverVideo::ParseRtpPacket(WebRtcRTPHeader* rtp_header,
   }
 
   // We are not allowed to hold a critical section when calling below functions.
-  std::unique_ptr<RtpDepacketizer> depacketizer(
-      RtpDepacketizer::Create(rtp_header->type.Video.codec));
-  if (depacketizer.get() == NULL) {
+  RtpDepacketizer* depacketizer = GetDepacketizer(
+      rtp_header->header.payloadType, rtp_header->type.Video.codec);
+  if (depacketizer == NULL) {
     LOG(LS_ERROR) << "Failed to create depacketizer.";
     return -1;
   }
@@ -114,6 +114,16 @@ int32_t RTPReceiverVideo::ParseRtpPacket(WebRtcRTPHeader* rtp_header,
              : -1;
 }
 
+RtpDepacketizer* RTPReceiverVideo::GetDepacketizer(uint8_t payload_type,
+                                                   RtpVideoCodecTypes codec) {
+  Depacketizer& entry = depacketizers_[payload_type];
+  if (!entry.depacketizer || entry.codec != codec) {
+    entry.codec = codec;
+    entry.depacketizer.reset(RtpDepacketizer::Create(codec));
+  }
+  return entry.depacketizer.get();
+}
+
 RTPAliveType RTPReceiverVideo::ProcessDeadOrAlive(
     uint16_t last_payload_length) const {
   return kRtpDead;
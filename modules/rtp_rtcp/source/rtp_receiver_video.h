@@ -11,8 +11,12 @@
 #ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_RECEIVER_VIDEO_H_
 #define WEBRTC_MODULES_RTP_RTCP_SOURCE_RTP_RECEIVER_VIDEO_H_
 
+#include <map>
+#include <memory>
+
 #include "webrtc/base/onetimeevent.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_format.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_receiver_strategy.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
 #include "webrtc/typedefs.h"
@@ -33,7 +37,7 @@ class RTPReceiverVideo : public RTPReceiverStrategy {
                          int64_t timestamp,
                          bool is_first_packet,
 			 bool is_double_enabled,
-		         MediaCrypto *media_crypto) override;
+		         MediaCryptoEpochs *media_crypto) override;
 
   TelephoneEventHandler* GetTelephoneEventHandler() override { return NULL; }
 
@@ -52,7 +56,19 @@ class RTPReceiverVideo : public RTPReceiverStrategy {
   void SetPacketOverHead(uint16_t packet_over_head);
 
  private:
+  // Returns the depacketizer for |payload_type|, created the first time a
+  // packet of the payload type is received, or if its codec has changed.
+  RtpDepacketizer* GetDepacketizer(uint8_t payload_type,
+                                   RtpVideoCodecTypes codec);
+
   OneTimeEvent first_packet_received_;
+
+  struct Depacketizer {
+    RtpVideoCodecTypes codec;
+    std::unique_ptr<RtpDepacketizer> depacketizer;
+  };
+  // Only used from ParseRtpPacket(), which is called for one packet at a time.
+  std::map<uint8_t, Depacketizer> depacketizers_;
 };
 }  // namespace webrtc
 
@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/common_video/h264/h264_common.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_payload_registry.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_receiver.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+// This test replaces the global operator new and delete, and is built into an
+// executable of its own, rtp_receiver_video_allocation_tests, so that no other
+// test runs on them.
+namespace {
+// Set while the receive path is measured, in which case every allocation made
+// through operator new is counted.
+volatile int g_count_allocations = 0;
+volatile int g_num_allocations = 0;
+
+void* CountedAllocation(size_t size) {
+  if (rtc::AtomicOps::AcquireLoad(&g_count_allocations))
+    rtc::AtomicOps::Increment(&g_num_allocations);
+  void* ptr = malloc(size > 0 ? size : 1);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountedAllocation(size);
+}
+
+void* operator new[](size_t size) {
+  return CountedAllocation(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+namespace webrtc {
+namespace {
+
+constexpr int kNumFrames = 2000;
+constexpr int kPacketsPerFrame = 8;
+constexpr size_t kPayloadSize = 1100;
+constexpr uint32_t kSsrc = 0x1234;
+constexpr uint8_t kVp8PayloadType = 100;
+constexpr uint8_t kH264PayloadType = 107;
+// FU indicator with the FU-A type, and FU headers of an IDR slice.
+constexpr uint8_t kFuAIndicator = 0x60 | H264::NaluType::kFuA;
+constexpr uint8_t kFuAStart = 0x80 | H264::NaluType::kIdr;
+constexpr uint8_t kFuAMiddle = H264::NaluType::kIdr;
+constexpr uint8_t kFuAEnd = 0x40 | H264::NaluType::kIdr;
+
+// The payloads of the packets of a frame, after the RTP header.
+std::vector<std::vector<uint8_t>> CreatePayloads(RtpVideoCodecTypes codec) {
+  std::vector<std::vector<uint8_t>> payloads;
+  for (int i = 0; i < kPacketsPerFrame; ++i) {
+    std::vector<uint8_t> payload(kPayloadSize, 0x5a);
+    bool first = i == 0;
+    bool last = i == kPacketsPerFrame - 1;
+    if (codec == kRtpVideoVp8) {
+      // VP8 payload descriptor, with the S bit set in the first packet, and a
+      // key frame tag.
+      payload[0] = first ? 0x10 : 0;
+      payload[1] = 0;
+    } else {
+      payload[0] = kFuAIndicator;
+      payload[1] = first ? kFuAStart : (last ? kFuAEnd : kFuAMiddle);
+      // first_mb_in_slice, slice_type and pps_id of the slice header.
+      payload[2] = 0x88;
+      payload[3] = 0x84;
+    }
+    payloads.push_back(std::move(payload));
+  }
+  return payloads;
+}
+
+// Feeds |kNumFrames| frames of |codec| through a video RtpReceiver, and
+// reports the allocations and the time spent per received packet.
+void RunReceiverTest(VideoCodecType codec_type,
+                     RtpVideoCodecTypes codec,
+                     uint8_t payload_type,
+                     const char* payload_name,
+                     const std::string& trace) {
+  SimulatedClock clock(1000000);
+  NullRtpData data_callback;
+  NullRtpFeedback feedback;
+  RTPPayloadRegistry payload_registry;
+  std::unique_ptr<RtpReceiver> receiver(RtpReceiver::CreateVideoReceiver(
+      &clock, &data_callback, &feedback, &payload_registry));
+  VideoCodec video_codec = {};
+  video_codec.codecType = codec_type;
+  video_codec.plType = payload_type;
+  strncpy(video_codec.plName, payload_name, sizeof(video_codec.plName) - 1);
+  ASSERT_EQ(0, receiver->RegisterReceivePayload(video_codec));
+  PayloadUnion payload_specific;
+  ASSERT_TRUE(
+      payload_registry.GetPayloadSpecifics(payload_type, &payload_specific));
+  ASSERT_EQ(codec, payload_specific.Video.videoCodecType);
+
+  const std::vector<std::vector<uint8_t>> payloads = CreatePayloads(codec);
+  // The payload may be modified in place, parse a copy of it.
+  std::vector<uint8_t> payload(kPayloadSize);
+  RTPHeader header;
+  header.payloadType = payload_type;
+  header.ssrc = kSsrc;
+  header.headerLength = kRtpHeaderSize;
+  uint16_t sequence_number = 0;
+  int64_t elapsed_ns = 0;
+  // The first frame sets up the receiver, and is not measured.
+  for (int frame = 0; frame <= kNumFrames; ++frame) {
+    if (frame == 1) {
+      elapsed_ns = 0;
+      rtc::AtomicOps::ReleaseStore(&g_num_allocations, 0);
+      rtc::AtomicOps::ReleaseStore(&g_count_allocations, 1);
+    }
+    header.timestamp = static_cast<uint32_t>(frame * 3000);
+    for (int i = 0; i < kPacketsPerFrame; ++i) {
+      header.sequenceNumber = sequence_number++;
+      header.markerBit = i == kPacketsPerFrame - 1;
+      memcpy(payload.data(), payloads[i].data(), kPayloadSize);
+      int64_t start_ns = rtc::TimeNanos();
+      bool in_order = true;
+      EXPECT_TRUE(receiver->IncomingRtpPacket(header, payload.data(),
+                                              payload.size(), payload_specific,
+                                              in_order));
+      elapsed_ns += rtc::TimeNanos() - start_ns;
+    }
+    clock.AdvanceTimeMilliseconds(33);
+  }
+  rtc::AtomicOps::ReleaseStore(&g_count_allocations, 0);
+
+  const int num_packets = kNumFrames * kPacketsPerFrame;
+  test::PrintResult(
+      "rtp_receiver_video_allocations", "", trace,
+      static_cast<size_t>(rtc::AtomicOps::AcquireLoad(&g_num_allocations) *
+                          1000 / num_packets),
+      "allocations/1000_packets", true);
+  test::PrintResult("rtp_receiver_video_receive_time", "", trace,
+                    static_cast<size_t>(elapsed_ns / num_packets),
+                    "ns/packet", true);
+}
+
+}  // namespace
+
+TEST(RtpReceiverVideoPerformanceTest, Vp8) {
+  RunReceiverTest(kVideoCodecVP8, kRtpVideoVp8, kVp8PayloadType, "VP8", "vp8");
+}
+
+TEST(RtpReceiverVideoPerformanceTest, H264FuA) {
+  RunReceiverTest(kVideoCodecH264, kRtpVideoH264, kH264PayloadType, "H264",
+                  "h264_fu_a");
+}
+
+}  // namespace webrtc
@@ -103,6 +103,7 @@ ModuleRtpRtcpImpl::ModuleRtpRtcpImpl(const Configuration& configuration)
                      this),
       clock_(configuration.clock),
       audio_(configuration.audio),
+      media_crypto_workers_(configuration.media_crypto_workers),
       collision_detected_(false),
       last_process_time_(configuration.clock->TimeInMilliseconds()),
       last_bitrate_process_time_(configuration.clock->TimeInMilliseconds()),
@@ -131,7 +132,8 @@ ModuleRtpRtcpImpl::ModuleRtpRtcpImpl(const Configuration& configuration)
   
   // Check if e2e media encryption key is set to enable it
   if (configuration.media_crypto_enabled)
-    rtp_sender_.EnableMediaCrypto(*configuration.media_crypto_key);
+    rtp_sender_.EnableMediaCrypto(*configuration.media_crypto_key,
+                                  configuration.media_crypto_workers);
 }
 
 // Returns the number of milliseconds until the module want a worker thread
@@ -245,6 +247,14 @@ rtc::Optional<uint32_t> ModuleRtpRtcpImpl::FlexfecSsrc() const {
   return rtp_sender_.FlexfecSsrc();
 }
 
+bool ModuleRtpRtcpImpl::SetMediaCryptoKey(const MediaCryptoKey& key) {
+  return rtp_sender_.EnableMediaCrypto(key, media_crypto_workers_);
+}
+
+MediaCryptoStats ModuleRtpRtcpImpl::GetMediaCryptoStats() const {
+  return rtp_sender_.GetMediaCryptoStats();
+}
+
 int32_t ModuleRtpRtcpImpl::IncomingRtcpPacket(
     const uint8_t* rtcp_packet,
     const size_t length) {
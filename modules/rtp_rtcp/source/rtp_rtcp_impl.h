@@ -100,6 +100,9 @@ class ModuleRtpRtcpImpl : public RtpRtcp, public RTCPReceiver::ModuleRtpRtcp {
 
   rtc::Optional<uint32_t> FlexfecSsrc() const override;
 
+  bool SetMediaCryptoKey(const MediaCryptoKey& key) override;
+  MediaCryptoStats GetMediaCryptoStats() const override;
+
   // Sends kRtcpByeCode when going from true to false.
   int32_t SetSendingStatus(bool sending) override;
 
@@ -330,6 +333,7 @@ class ModuleRtpRtcpImpl : public RtpRtcp, public RTCPReceiver::ModuleRtpRtcp {
   bool TimeToSendFullNackList(int64_t now) const;
 
   const bool audio_;
+  const size_t media_crypto_workers_;
   bool collision_detected_;
   int64_t last_process_time_;
   int64_t last_bitrate_process_time_;
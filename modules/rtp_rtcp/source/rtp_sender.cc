@@ -98,8 +98,9 @@ RTPSender::RTPSender(
       payload_type_(-1),
       payload_type_map_(),
       rtp_header_extension_map_(),
-      packet_history_(clock),
-      flexfec_packet_history_(clock),
+      packet_pool_(clock, max_packet_size_),
+      packet_history_(clock, &packet_pool_),
+      flexfec_packet_history_(clock, &packet_pool_),
       // Statistics
       rtp_stats_callback_(nullptr),
       total_bitrate_sent_(kBitrateStatisticsWindowMs,
@@ -124,7 +125,8 @@ RTPSender::RTPSender(
       rtx_(kRtxOff),
       rtp_overhead_bytes_per_packet_(0),
       retransmission_rate_limiter_(retransmission_rate_limiter),
-      overhead_observer_(overhead_observer) {
+      overhead_observer_(overhead_observer),
+      media_crypto_(clock) {
   ssrc_ = ssrc_db_->CreateSSRC();
   RTC_DCHECK(ssrc_ != 0);
   ssrc_rtx_ = ssrc_db_->CreateSSRC();
@@ -304,6 +306,7 @@ void RTPSender::SetMaxRtpPacketSize(size_t max_packet_size) {
       << "Invalid max payload length: " << max_packet_size;
   rtc::CritScope lock(&send_critsect_);
   max_packet_size_ = max_packet_size;
+  packet_pool_.SetPacketCapacity(max_packet_size);
 }
 
 size_t RTPSender::MaxPayloadSize() const {
@@ -536,33 +539,40 @@ size_t RTPSender::SendPadData(size_t bytes, int probe_cluster_id) {
       }
     }
 
-    RtpPacketToSend padding_packet(&rtp_header_extension_map_);
-    padding_packet.SetPayloadType(payload_type);
-    padding_packet.SetMarker(false);
-    padding_packet.SetSequenceNumber(sequence_number);
-    padding_packet.SetTimestamp(timestamp);
-    padding_packet.SetSsrc(ssrc);
+    std::unique_ptr<RtpPacketToSend> padding_packet;
+    {
+      rtc::CritScope lock(&send_critsect_);
+      padding_packet = packet_pool_.Get(rtp_header_extension_map_);
+    }
+    padding_packet->SetPayloadType(payload_type);
+    padding_packet->SetMarker(false);
+    padding_packet->SetSequenceNumber(sequence_number);
+    padding_packet->SetTimestamp(timestamp);
+    padding_packet->SetSsrc(ssrc);
 
     if (capture_time_ms > 0) {
-      padding_packet.SetExtension<TransmissionOffset>(
+      padding_packet->SetExtension<TransmissionOffset>(
           (now_ms - capture_time_ms) * kTimestampTicksPerMs);
     }
-    padding_packet.SetExtension<AbsoluteSendTime>(now_ms);
+    padding_packet->SetExtension<AbsoluteSendTime>(now_ms);
     PacketOptions options;
     bool has_transport_seq_num =
-        UpdateTransportSequenceNumber(&padding_packet, &options.packet_id);
-    padding_packet.SetPadding(padding_bytes_in_packet, &random_);
+        UpdateTransportSequenceNumber(padding_packet.get(), &options.packet_id);
+    padding_packet->SetPadding(padding_bytes_in_packet, &random_);
 
     if (has_transport_seq_num) {
-      AddPacketToTransportFeedback(options.packet_id, padding_packet,
+      AddPacketToTransportFeedback(options.packet_id, *padding_packet,
                                    probe_cluster_id);
     }
 
-    if (!SendPacketToNetwork(padding_packet, options))
+    bool sent = SendPacketToNetwork(*padding_packet, options);
+    if (sent) {
+      bytes_sent += padding_bytes_in_packet;
+      UpdateRtpStats(*padding_packet, over_rtx, false);
+    }
+    packet_pool_.Release(std::move(padding_packet));
+    if (!sent)
       break;
-
-    bytes_sent += padding_bytes_in_packet;
-    UpdateRtpStats(padding_packet, over_rtx, false);
   }
 
   return bytes_sent;
@@ -587,8 +597,10 @@ int32_t RTPSender::ReSendPacket(uint16_t packet_id, int64_t min_resend_time) {
   // Check if we're overusing retransmission bitrate.
   // TODO(sprang): Add histograms for nack success or failure reasons.
   RTC_DCHECK(retransmission_rate_limiter_);
-  if (!retransmission_rate_limiter_->TryUseRate(packet->size()))
+  if (!retransmission_rate_limiter_->TryUseRate(packet->size())) {
+    packet_pool_.Release(std::move(packet));
     return -1;
+  }
 
   if (paced_sender_) {
     // Convert from TickTime to Clock since capture_time_ms is based on
@@ -600,7 +612,9 @@ int32_t RTPSender::ReSendPacket(uint16_t packet_id, int64_t min_resend_time) {
                                 corrected_capture_tims_ms,
                                 packet->payload_size(), true);
 
-    return packet->size();
+    int32_t packet_size = static_cast<int32_t>(packet->size());
+    packet_pool_.Release(std::move(packet));
+    return packet_size;
   }
   bool rtx = (RtxStatus() & kRtxRetransmitted) > 0;
   int32_t packet_size = static_cast<int32_t>(packet->size());
@@ -718,8 +732,10 @@ bool RTPSender::PrepareAndSendPacket(std::unique_ptr<RtpPacketToSend> packet,
   std::unique_ptr<RtpPacketToSend> packet_rtx;
   if (send_over_rtx) {
     packet_rtx = BuildRtxPacket(*packet);
-    if (!packet_rtx)
+    if (!packet_rtx) {
+      packet_pool_.Release(std::move(packet));
       return false;
+    }
     packet_to_send = packet_rtx.get();
   }
 
@@ -741,15 +757,17 @@ bool RTPSender::PrepareAndSendPacket(std::unique_ptr<RtpPacketToSend> packet,
                        packet->Ssrc());
   }
 
-  if (!SendPacketToNetwork(*packet_to_send, options))
-    return false;
-
-  {
-    rtc::CritScope lock(&send_critsect_);
-    media_has_been_sent_ = true;
+  bool sent = SendPacketToNetwork(*packet_to_send, options);
+  if (sent) {
+    {
+      rtc::CritScope lock(&send_critsect_);
+      media_has_been_sent_ = true;
+    }
+    UpdateRtpStats(*packet_to_send, send_over_rtx, is_retransmit);
   }
-  UpdateRtpStats(*packet_to_send, send_over_rtx, is_retransmit);
-  return true;
+  packet_pool_.Release(std::move(packet));
+  packet_pool_.Release(std::move(packet_rtx));
+  return sent;
 }
 
 void RTPSender::UpdateRtpStats(const RtpPacketToSend& packet,
@@ -888,6 +906,8 @@ bool RTPSender::SendToNetwork(std::unique_ptr<RtpPacketToSend> packet,
     // https://bugs.chromium.org/p/webrtc/issues/detail?id=6887.
     // RTC_DCHECK_EQ(ssrc, SSRC());
     packet_history_.PutRtpPacket(std::move(packet), storage, true);
+  } else {
+    packet_pool_.Release(std::move(packet));
   }
 
   return sent;
@@ -972,10 +992,10 @@ void RTPSender::GetDataCounters(StreamDataCounters* rtp_stats,
   *rtx_stats = rtx_rtp_stats_;
 }
 
-std::unique_ptr<RtpPacketToSend> RTPSender::AllocatePacket() const {
+std::unique_ptr<RtpPacketToSend> RTPSender::AllocatePacket() {
   rtc::CritScope lock(&send_critsect_);
-  std::unique_ptr<RtpPacketToSend> packet(
-      new RtpPacketToSend(&rtp_header_extension_map_, max_packet_size_));
+  std::unique_ptr<RtpPacketToSend> packet =
+      packet_pool_.Get(rtp_header_extension_map_);
   packet->SetSsrc(ssrc_);
   packet->SetCsrcs(csrcs_);
   // Reserve extensions, if registered, RtpSender set in SendToNetwork.
@@ -989,6 +1009,19 @@ std::unique_ptr<RtpPacketToSend> RTPSender::AllocatePacket() const {
   return packet;
 }
 
+std::unique_ptr<RtpPacketToSend> RTPSender::AllocatePacketWithHeader(
+    const RtpPacketToSend& packet) {
+  return packet_pool_.CopyHeader(packet);
+}
+
+void RTPSender::ReleasePacket(std::unique_ptr<RtpPacketToSend> packet) {
+  packet_pool_.Release(std::move(packet));
+}
+
+RtpPacketPool::Stats RTPSender::GetPacketPoolStats() const {
+  return packet_pool_.GetStats();
+}
+
 bool RTPSender::AssignSequenceNumber(RtpPacketToSend* packet) {
   rtc::CritScope lock(&send_critsect_);
   if (!sending_media_)
@@ -1163,19 +1196,28 @@ std::unique_ptr<RtpPacketToSend> RTPSender::BuildRtxPacket(
     const RtpPacketToSend& packet) {
   // TODO(danilchap): Create rtx packet with extra capacity for SRTP
   // when transport interface would be updated to take buffer class.
-  std::unique_ptr<RtpPacketToSend> rtx_packet(new RtpPacketToSend(
-      &rtp_header_extension_map_, packet.size() + kRtxHeaderSize));
-  // Add original RTP header.
-  rtx_packet->CopyHeaderFrom(packet);
+  std::unique_ptr<RtpPacketToSend> rtx_packet;
+  if (packet.size() + kRtxHeaderSize <= packet_pool_.packet_capacity()) {
+    rtx_packet = packet_pool_.CopyHeader(packet);
+  } else {
+    rtx_packet.reset(new RtpPacketToSend(nullptr,
+                                         packet.size() + kRtxHeaderSize));
+    // Add original RTP header.
+    rtx_packet->CopyHeaderFrom(packet);
+  }
   {
     rtc::CritScope lock(&send_critsect_);
-    if (!sending_media_)
+    if (!sending_media_) {
+      packet_pool_.Release(std::move(rtx_packet));
       return nullptr;
+    }
 
     // Replace payload type.
     auto kv = rtx_payload_type_map_.find(packet.PayloadType());
-    if (kv == rtx_payload_type_map_.end())
+    if (kv == rtx_payload_type_map_.end()) {
+      packet_pool_.Release(std::move(rtx_packet));
       return nullptr;
+    }
     rtx_packet->SetPayloadType(kv->second);
 
     // Replace sequence number.
@@ -1284,23 +1326,37 @@ void RTPSender::UpdateRtpOverhead(const RtpPacketToSend& packet) {
   overhead_observer_->OnOverheadChanged(overhead_bytes_per_packet);
 }
 
-bool RTPSender::EnableMediaCrypto(const MediaCryptoKey &key) {
+bool RTPSender::EnableMediaCrypto(const MediaCryptoKey &key,
+                                  size_t num_workers) {
   LOG(LS_INFO) << "Enabling E2E Media Encryption Encription";
   
-  rtc::CritScope cs(&send_critsect_);
-  media_crypto_enabled_ = media_crypto_.SetOutboundKey(key);
-  return  media_crypto_enabled_;
+  // Later keys take over at the next frame, see MediaCryptoEpochs.
+  return media_crypto_.SetOutboundKey(key, num_workers);
 }
 
 bool RTPSender::MediaEncrypt(rtp::Packet *packet)
 {
-  if (media_crypto_enabled_)
+  if (media_crypto_.enabled())
     return media_crypto_.Encrypt(packet);
   return true;
 }
+
+bool RTPSender::MediaEncryptBatch(rtc::ArrayView<rtp::Packet* const> packets)
+{
+  if (media_crypto_.enabled())
+    return media_crypto_.EncryptBatch(packets);
+  return true;
+}
+MediaCryptoStats RTPSender::GetMediaCryptoStats() const {
+  MediaCryptoStats stats;
+  stats.ssrc = SSRC();
+  stats.packets = media_crypto_.GetNumEncryptedPackets();
+  return stats;
+}
+
 size_t RTPSender::GetMediaEncryptionOverhead()
 {
- if (media_crypto_enabled_)
+ if (media_crypto_.enabled())
     return media_crypto_.GetEncryptionOverhead();
   return 0;	
 }
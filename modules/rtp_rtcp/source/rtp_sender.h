@@ -27,10 +27,11 @@
 #include "webrtc/common_types.h"
 #include "webrtc/modules/rtp_rtcp/include/flexfec_sender.h"
 #include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
-#include "webrtc/modules/rtp_rtcp/source/media_crypto.h"
+#include "webrtc/modules/rtp_rtcp/source/media_crypto_epochs.h"
 #include "webrtc/modules/rtp_rtcp/source/playout_delay_oracle.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_header_extension.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_packet_history.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_packet_pool.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_rtcp_config.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
 #include "webrtc/modules/rtp_rtcp/source/ssrc_database.h"
@@ -157,7 +158,14 @@ class RTPSender {
 
   // Create empty packet, fills ssrc, csrcs and reserve place for header
   // extensions RtpSender updates before sending.
-  std::unique_ptr<RtpPacketToSend> AllocatePacket() const;
+  std::unique_ptr<RtpPacketToSend> AllocatePacket();
+  // Create packet with the header of |packet| and no payload.
+  std::unique_ptr<RtpPacketToSend> AllocatePacketWithHeader(
+      const RtpPacketToSend& packet);
+  // Packets are taken from a pool of packets, give them back when not handing
+  // them to SendToNetwork.
+  void ReleasePacket(std::unique_ptr<RtpPacketToSend> packet);
+  RtpPacketPool::Stats GetPacketPoolStats() const;
   // Allocate sequence number for provided packet.
   // Save packet's fields to generate padding that doesn't break media stream.
   // Return false if sending was turned off.
@@ -210,10 +218,14 @@ class RTPSender {
   void SetRtxRtpState(const RtpState& rtp_state);
   RtpState GetRtxRtpState() const;
 
-  // End to End media crypto
-  bool EnableMediaCrypto(const MediaCryptoKey &key);
+  // End to End media crypto. Can be called again to rotate the key.
+  bool EnableMediaCrypto(const MediaCryptoKey &key, size_t num_workers);
   bool MediaEncrypt(rtp::Packet *packet);
+  // Encrypts all packets of a frame at once.
+  bool MediaEncryptBatch(rtc::ArrayView<rtp::Packet* const> packets);
   size_t GetMediaEncryptionOverhead();
+  // |packets| counts encryption operations, which only media packets cost.
+  MediaCryptoStats GetMediaCryptoStats() const;
   
  protected:
   int32_t CheckPayloadType(int8_t payload_type, RtpVideoCodecTypes* video_type);
@@ -289,6 +301,9 @@ class RTPSender {
   // delay extension on header.
   PlayoutDelayOracle playout_delay_oracle_;
 
+  // Packets sent and stored by this sender, including those built for RTX,
+  // retransmissions and padding.
+  RtpPacketPool packet_pool_;
   RtpPacketHistory packet_history_;
   // TODO(brandtr): Remove |flexfec_packet_history_| when the FlexfecSender
   // is hooked up to the PacedSender.
@@ -334,8 +349,7 @@ class RTPSender {
   OverheadObserver* overhead_observer_;
 
   // Double PERC encryption
-  bool media_crypto_enabled_;
-  MediaCrypto media_crypto_;
+  MediaCryptoEpochs media_crypto_;
   
   RTC_DISALLOW_IMPLICIT_CONSTRUCTORS(RTPSender);
 };
@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/api/call/transport.h"
+#include "webrtc/base/rate_limiter.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_sender.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+constexpr int kFramesPerSecond = 30;
+// Long enough for the packet history to fill up with small frames too, after
+// which every stored packet replaces one that goes back to the pool.
+constexpr int kWarmUpSeconds = 15;
+constexpr int kDurationSeconds = 20;
+constexpr int kPayloadType = 100;
+constexpr int kRtxPayloadType = 98;
+constexpr uint32_t kSsrc = 0x1234;
+constexpr uint32_t kRtxSsrc = 0x5678;
+constexpr uint16_t kStoredPackets = 600;
+constexpr size_t kPaddingBytesPerFrame = 1000;
+
+class CountingTransport : public Transport {
+ public:
+  bool SendRtp(const uint8_t* data,
+               size_t len,
+               const PacketOptions& options) override {
+    ++packets_sent_;
+    return true;
+  }
+  bool SendRtcp(const uint8_t* data, size_t len) override { return true; }
+
+  int packets_sent() const { return packets_sent_; }
+
+ private:
+  int packets_sent_ = 0;
+};
+
+// Queues the packets inserted by the sender, until they are sent with
+// SendQueuedPackets().
+class QueuingPacer : public RtpPacketSender {
+ public:
+  void InsertPacket(Priority priority,
+                    uint32_t ssrc,
+                    uint16_t sequence_number,
+                    int64_t capture_time_ms,
+                    size_t bytes,
+                    bool retransmission) override {
+    queue_.push_back(
+        QueuedPacket{ssrc, sequence_number, capture_time_ms, retransmission});
+  }
+
+  void SendQueuedPackets(RTPSender* sender) {
+    for (const QueuedPacket& packet : queue_) {
+      sender->TimeToSendPacket(packet.ssrc, packet.sequence_number,
+                               packet.capture_time_ms, packet.retransmission,
+                               PacketInfo::kNotAProbe);
+    }
+    queue_.clear();
+  }
+
+ private:
+  struct QueuedPacket {
+    uint32_t ssrc;
+    uint16_t sequence_number;
+    int64_t capture_time_ms;
+    bool retransmission;
+  };
+  std::vector<QueuedPacket> queue_;
+};
+
+// Sends |frame_size| byte video frames at |kFramesPerSecond| through the
+// pacer, retransmitting every |nack_interval|th packet over RTX and filling
+// up with padding after every frame. Reports the time spent per packet sent,
+// and how many packets the sender allocates per second once warmed up.
+void RunSenderTest(size_t frame_size,
+                   int nack_interval,
+                   const std::string& trace) {
+  SimulatedClock clock(1000000);
+  CountingTransport transport;
+  QueuingPacer pacer;
+  RateLimiter retransmission_rate_limiter(&clock, 1000);
+  RTPSender sender(false, &clock, &transport, &pacer, nullptr, nullptr,
+                   nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                   &retransmission_rate_limiter, nullptr);
+  char payload_name[RTP_PAYLOAD_NAME_SIZE] = "GENERIC";
+  ASSERT_EQ(0, sender.RegisterPayload(payload_name, kPayloadType, 90000, 0,
+                                      1500));
+  sender.SetSendPayloadType(kPayloadType);
+  sender.SetSSRC(kSsrc);
+  sender.SetRtxSsrc(kRtxSsrc);
+  sender.SetRtxPayloadType(kRtxPayloadType, kPayloadType);
+  sender.SetRtxStatus(kRtxRetransmitted | kRtxRedundantPayloads);
+  sender.SetStorePacketsStatus(true, kStoredPackets);
+  sender.RegisterRtpHeaderExtension(kRtpExtensionTransmissionTimeOffset, 1);
+  sender.RegisterRtpHeaderExtension(kRtpExtensionAbsoluteSendTime, 2);
+
+  std::vector<uint8_t> frame(frame_size, 0x5a);
+  const int kFrameIntervalMs = 1000 / kFramesPerSecond;
+  int64_t elapsed_ns = 0;
+  int packets_sent = 0;
+  RtpPacketPool::Stats warmed_up_stats;
+  for (int i = 0; i < (kWarmUpSeconds + kDurationSeconds) * kFramesPerSecond;
+       ++i) {
+    if (i == kWarmUpSeconds * kFramesPerSecond) {
+      warmed_up_stats = sender.GetPacketPoolStats();
+      packets_sent = transport.packets_sent();
+      elapsed_ns = 0;
+    }
+    uint32_t rtp_timestamp = static_cast<uint32_t>(i * 90 * kFrameIntervalMs);
+    int64_t start_ns = rtc::TimeNanos();
+    uint16_t first_sequence_number = sender.SequenceNumber();
+    ASSERT_TRUE(sender.SendOutgoingData(
+        i % (10 * kFramesPerSecond) == 0 ? kVideoFrameKey : kVideoFrameDelta,
+        kPayloadType, rtp_timestamp, clock.TimeInMilliseconds(), frame.data(),
+        frame.size(), nullptr, nullptr, nullptr));
+    pacer.SendQueuedPackets(&sender);
+    for (uint16_t seq = first_sequence_number; seq != sender.SequenceNumber();
+         ++seq) {
+      if (seq % nack_interval == 0)
+        sender.ReSendPacket(seq, 0);
+    }
+    pacer.SendQueuedPackets(&sender);
+    sender.TimeToSendPadding(kPaddingBytesPerFrame, PacketInfo::kNotAProbe);
+    elapsed_ns += rtc::TimeNanos() - start_ns;
+    clock.AdvanceTimeMilliseconds(kFrameIntervalMs);
+  }
+  packets_sent = transport.packets_sent() - packets_sent;
+  RtpPacketPool::Stats stats = sender.GetPacketPoolStats();
+
+  test::PrintResult("rtp_sender_send_time", "", trace,
+                    static_cast<size_t>(elapsed_ns / packets_sent),
+                    "ns/packet", true);
+  test::PrintResult(
+      "rtp_sender_packet_allocations", "", trace,
+      static_cast<size_t>(
+          (stats.packets_allocated - warmed_up_stats.packets_allocated) /
+          kDurationSeconds),
+      "packets/s", true);
+  test::PrintResult(
+      "rtp_sender_packets_reused", "", trace,
+      static_cast<size_t>(
+          (stats.packets_reused - warmed_up_stats.packets_reused) /
+          kDurationSeconds),
+      "packets/s", true);
+  EXPECT_GT(packets_sent, 0);
+}
+
+}  // namespace
+
+TEST(RtpSenderPerformanceTest, SmallFrames) {
+  RunSenderTest(2000, 50, "small_frames");
+}
+
+TEST(RtpSenderPerformanceTest, LargeFrames) {
+  RunSenderTest(40000, 50, "large_frames");
+}
+
+TEST(RtpSenderPerformanceTest, LargeFramesWithLoss) {
+  RunSenderTest(40000, 10, "large_frames_with_loss");
+}
+
+}  // namespace webrtc
@@ -121,8 +121,8 @@ void RTPSenderVideo::SendVideoPacketAsRedMaybeWithUlpfec(
   uint32_t rtp_timestamp = media_packet->Timestamp();
   uint16_t media_seq_num = media_packet->SequenceNumber();
 
-  std::unique_ptr<RtpPacketToSend> red_packet(
-      new RtpPacketToSend(*media_packet));
+  std::unique_ptr<RtpPacketToSend> red_packet =
+      rtp_sender_->AllocatePacketWithHeader(*media_packet);
   BuildRedPayload(*media_packet, red_packet.get());
 
   std::vector<std::unique_ptr<RedPacket>> fec_packets;
@@ -165,8 +165,8 @@ void RTPSenderVideo::SendVideoPacketAsRedMaybeWithUlpfec(
   for (const auto& fec_packet : fec_packets) {
     // TODO(danilchap): Make ulpfec_generator_ generate RtpPacketToSend to avoid
     // reparsing them.
-    std::unique_ptr<RtpPacketToSend> rtp_packet(
-        new RtpPacketToSend(*media_packet));
+    std::unique_ptr<RtpPacketToSend> rtp_packet =
+        rtp_sender_->AllocatePacketWithHeader(*media_packet);
     RTC_CHECK(rtp_packet->Parse(fec_packet->data(), fec_packet->length()));
     rtp_packet->set_capture_time_ms(media_packet->capture_time_ms());
     uint16_t fec_sequence_number = rtp_packet->SequenceNumber();
@@ -181,6 +181,7 @@ void RTPSenderVideo::SendVideoPacketAsRedMaybeWithUlpfec(
       LOG(LS_WARNING) << "Failed to send ULPFEC packet " << fec_sequence_number;
     }
   }
+  rtp_sender_->ReleasePacket(std::move(media_packet));
 }
 
 void RTPSenderVideo::SendVideoPacketWithFlexfec(
@@ -406,19 +407,21 @@ bool RTPSenderVideo::SendVideo(RtpVideoCodecTypes video_type,
       (video_type == kRtpVideoVp8) ? nullptr : fragmentation;
   packetizer->SetPayloadData(payload_data, payload_size, frag);
 
-  bool first_frame = first_frame_sent_();
-  bool first = true;
-  bool last = false;
-  while (!last) {
-    std::unique_ptr<RtpPacketToSend> packet(new RtpPacketToSend(*rtp_header));
+  // Packetize the whole frame first so it can be encrypted in one batch.
+  std::vector<std::unique_ptr<RtpPacketToSend>> packets;
+  std::vector<bool> protect_packets;
+  bool last_packet = false;
+  while (!last_packet) {
+    std::unique_ptr<RtpPacketToSend> packet =
+        rtp_sender_->AllocatePacketWithHeader(*rtp_header);
 
-    if (!packetizer->NextPacket(packet.get(), &last))
+    if (!packetizer->NextPacket(packet.get(), &last_packet))
       return false;
     RTC_DCHECK_LE(packet->payload_size(), max_data_payload_length);
     
     // Update star and end marks
-    frame_marks.startOfFrame = first;
-    frame_marks.endOfFrame = last;
+    frame_marks.startOfFrame = packets.empty();
+    frame_marks.endOfFrame = last_packet;
     
     // Only add frame marking for known codecs
    if (frame_marking_enabled)
@@ -428,12 +431,28 @@ bool RTPSenderVideo::SendVideo(RtpVideoCodecTypes video_type,
     if (!rtp_sender_->AssignSequenceNumber(packet.get()))
       return false;
     
-    // End to End media encryption
-    if (!rtp_sender_->MediaEncrypt(packet.get()))
-      return false;
-    
-    const bool protect_packet =
-        (packetizer->GetProtectionType() == kProtectedPacket);
+    protect_packets.push_back(packetizer->GetProtectionType() ==
+                              kProtectedPacket);
+    packets.push_back(std::move(packet));
+  }
+  rtp_sender_->ReleasePacket(std::move(rtp_header));
+
+  // End to End media encryption. This is the only place video payloads are
+  // encrypted: FEC is computed over the protected packets below, and the
+  // packet history keeps them protected for RTX and padding.
+  std::vector<rtp::Packet*> batch;
+  batch.reserve(packets.size());
+  for (const std::unique_ptr<RtpPacketToSend>& packet : packets)
+    batch.push_back(packet.get());
+  if (!rtp_sender_->MediaEncryptBatch(batch))
+    return false;
+
+  bool first_frame = first_frame_sent_();
+  for (size_t i = 0; i < packets.size(); ++i) {
+    std::unique_ptr<RtpPacketToSend> packet = std::move(packets[i]);
+    const bool first = i == 0;
+    const bool last = i == packets.size() - 1;
+    const bool protect_packet = protect_packets[i];
     if (flexfec_enabled()) {
       // TODO(brandtr): Remove the FlexFEC code path when FlexfecSender
       // is wired up to PacedSender instead.
@@ -455,7 +474,6 @@ bool RTPSenderVideo::SendVideo(RtpVideoCodecTypes video_type,
             << "Sent last RTP packet of the first video frame (pre-pacer)";
       }
     }
-    first = false;
   }
 
   TRACE_EVENT_ASYNC_END1("webrtc", "Video", capture_time_ms, "timestamp",
@@ -17,9 +17,14 @@
 
 #include "webrtc/api/video/i420_buffer.h"
 #include "webrtc/base/checks.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/task_queue.h"
+#include "webrtc/common_video/include/i420_buffer_pool.h"
+#include "webrtc/modules/include/module_common_types.h"
 #include "webrtc/modules/video_coding/codecs/vp8/screenshare_layers.h"
 #include "webrtc/modules/video_coding/utility/simulcast_rate_allocator.h"
 #include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/system_wrappers/include/field_trial.h"
 
 namespace {
 
@@ -129,10 +134,35 @@ class TemporalLayersFactoryAdapter : public webrtc::TemporalLayersFactory {
 
 namespace webrtc {
 
+struct SimulcastEncoderAdapter::LayerState {
+  // An encoded image held back until all streams are encoded. The buffer of
+  // |image| stays owned by the encoder, which doesn't touch it before its
+  // next Encode() call.
+  struct DeferredImage {
+    EncodedImage image;
+    CodecSpecificInfo codec_specific_info;
+    RTPFragmentationHeader fragmentation;
+    bool has_fragmentation = false;
+  };
+
+  LayerState() : done(false, false) {}
+
+  I420BufferPool buffer_pool;
+  // Reused across frames, only the first |num_deferred_images| are valid.
+  std::vector<std::unique_ptr<DeferredImage>> deferred_images;
+  size_t num_deferred_images = 0;
+  int encode_result = WEBRTC_VIDEO_CODEC_OK;
+  rtc::Event done;
+};
+
 SimulcastEncoderAdapter::SimulcastEncoderAdapter(VideoEncoderFactory* factory)
     : factory_(factory),
       encoded_complete_callback_(nullptr),
-      implementation_name_("SimulcastEncoderAdapter") {
+      implementation_name_("SimulcastEncoderAdapter"),
+      parallel_encoding_enabled_(
+          webrtc::field_trial::FindFullName(
+              "WebRTC-ParallelSimulcastEncoding") == "Enabled"),
+      defer_encoded_images_(false) {
   memset(&codec_, 0, sizeof(webrtc::VideoCodec));
 }
 
@@ -153,6 +183,7 @@ int SimulcastEncoderAdapter::Release() {
     delete callback;
     streaminfos_.pop_back();
   }
+  layer_states_.clear();
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
@@ -230,6 +261,7 @@ int SimulcastEncoderAdapter::InitEncode(const VideoCodec* inst,
     streaminfos_.push_back(StreamInfo(encoder, callback, stream_codec.width,
                                       stream_codec.height,
                                       start_bitrate_kbps > 0));
+    layer_states_.emplace_back(new LayerState());
     if (i != 0)
       implementation_name += ", ";
     implementation_name += streaminfos_[i].encoder->ImplementationName();
@@ -240,6 +272,10 @@ int SimulcastEncoderAdapter::InitEncode(const VideoCodec* inst,
   } else {
     implementation_name_ = implementation_name;
   }
+  if (parallel_encoding_enabled_) {
+    while (encoder_queues_.size() + 1 < streaminfos_.size())
+      encoder_queues_.emplace_back(new rtc::TaskQueue("SimulcastEncoder"));
+  }
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
@@ -273,71 +309,140 @@ int SimulcastEncoderAdapter::Encode(
     }
   }
 
-  int src_width = input_image.width();
-  int src_height = input_image.height();
+  FrameType frame_type = kVideoFrameDelta;
+  if (send_key_frame) {
+    frame_type = kVideoFrameKey;
+    for (StreamInfo& streaminfo : streaminfos_) {
+      if (streaminfo.send_stream)
+        streaminfo.key_frame_request = false;
+    }
+  }
+
+  if (!encoder_queues_.empty())
+    return EncodeStreamsInParallel(input_image, codec_specific_info, frame_type);
+
   for (size_t stream_idx = 0; stream_idx < streaminfos_.size(); ++stream_idx) {
     // Don't encode frames in resolutions that we don't intend to send.
     if (!streaminfos_[stream_idx].send_stream)
       continue;
+    int ret = EncodeStream(stream_idx, input_image, codec_specific_info,
+                           frame_type);
+    if (ret != WEBRTC_VIDEO_CODEC_OK)
+      return ret;
+  }
 
-    std::vector<FrameType> stream_frame_types;
-    if (send_key_frame) {
-      stream_frame_types.push_back(kVideoFrameKey);
-      streaminfos_[stream_idx].key_frame_request = false;
-    } else {
-      stream_frame_types.push_back(kVideoFrameDelta);
-    }
+  return WEBRTC_VIDEO_CODEC_OK;
+}
 
-    int dst_width = streaminfos_[stream_idx].width;
-    int dst_height = streaminfos_[stream_idx].height;
-    // If scaling isn't required, because the input resolution
-    // matches the destination or the input image is empty (e.g.
-    // a keyframe request for encoders with internal camera
-    // sources) or the source image has a native handle, pass the image on
-    // directly. Otherwise, we'll scale it to match what the encoder expects
-    // (below).
-    // For texture frames, the underlying encoder is expected to be able to
-    // correctly sample/scale the source texture.
-    // TODO(perkj): ensure that works going forward, and figure out how this
-    // affects webrtc:5683.
-    if ((dst_width == src_width && dst_height == src_height) ||
-        input_image.video_frame_buffer()->native_handle()) {
-      int ret = streaminfos_[stream_idx].encoder->Encode(
-          input_image, codec_specific_info, &stream_frame_types);
-      if (ret != WEBRTC_VIDEO_CODEC_OK) {
-        return ret;
-      }
-    } else {
-      // Aligning stride values based on width.
-      rtc::scoped_refptr<I420Buffer> dst_buffer =
-          I420Buffer::Create(dst_width, dst_height, dst_width,
-                             (dst_width + 1) / 2, (dst_width + 1) / 2);
-      libyuv::I420Scale(input_image.video_frame_buffer()->DataY(),
-                        input_image.video_frame_buffer()->StrideY(),
-                        input_image.video_frame_buffer()->DataU(),
-                        input_image.video_frame_buffer()->StrideU(),
-                        input_image.video_frame_buffer()->DataV(),
-                        input_image.video_frame_buffer()->StrideV(),
-                        src_width, src_height,
-                        dst_buffer->MutableDataY(), dst_buffer->StrideY(),
-                        dst_buffer->MutableDataU(), dst_buffer->StrideU(),
-                        dst_buffer->MutableDataV(), dst_buffer->StrideV(),
-                        dst_width, dst_height,
-                        libyuv::kFilterBilinear);
-
-      int ret = streaminfos_[stream_idx].encoder->Encode(
-          VideoFrame(dst_buffer, input_image.timestamp(),
-                     input_image.render_time_ms(), webrtc::kVideoRotation_0),
-          codec_specific_info, &stream_frame_types);
-      if (ret != WEBRTC_VIDEO_CODEC_OK) {
-        return ret;
+int SimulcastEncoderAdapter::EncodeStreamsInParallel(
+    const VideoFrame& input_image,
+    const CodecSpecificInfo* codec_specific_info,
+    FrameType frame_type) {
+  // The highest stream sent, usually the slowest to encode, is encoded on
+  // this thread while the workers encode the others.
+  size_t local_stream_idx = streaminfos_.size();
+  for (size_t stream_idx = 0; stream_idx < streaminfos_.size(); ++stream_idx) {
+    if (streaminfos_[stream_idx].send_stream)
+      local_stream_idx = stream_idx;
+  }
+  if (local_stream_idx == streaminfos_.size())
+    return WEBRTC_VIDEO_CODEC_OK;
+
+  defer_encoded_images_ = true;
+  for (size_t stream_idx = 0; stream_idx < local_stream_idx; ++stream_idx) {
+    if (!streaminfos_[stream_idx].send_stream)
+      continue;
+    LayerState* layer = layer_states_[stream_idx].get();
+    encoder_queues_[stream_idx]->PostTask([this, layer, stream_idx,
+                                           &input_image, codec_specific_info,
+                                           frame_type]() {
+      layer->encode_result = EncodeStream(stream_idx, input_image,
+                                          codec_specific_info, frame_type);
+      layer->done.Set();
+    });
+  }
+  layer_states_[local_stream_idx]->encode_result = EncodeStream(
+      local_stream_idx, input_image, codec_specific_info, frame_type);
+  for (size_t stream_idx = 0; stream_idx < local_stream_idx; ++stream_idx) {
+    if (streaminfos_[stream_idx].send_stream)
+      layer_states_[stream_idx]->done.Wait(rtc::Event::kForever);
+  }
+  defer_encoded_images_ = false;
+
+  // Delivers as the sequential mode would, stopping at the first stream that
+  // failed.
+  for (size_t stream_idx = 0; stream_idx <= local_stream_idx; ++stream_idx) {
+    if (!streaminfos_[stream_idx].send_stream)
+      continue;
+    LayerState* layer = layer_states_[stream_idx].get();
+    for (size_t i = 0; i < layer->num_deferred_images; ++i) {
+      const LayerState::DeferredImage& deferred = *layer->deferred_images[i];
+      DeliverEncodedImage(
+          stream_idx, deferred.image, &deferred.codec_specific_info,
+          deferred.has_fragmentation ? &deferred.fragmentation : nullptr);
+    }
+    layer->num_deferred_images = 0;
+    if (layer->encode_result != WEBRTC_VIDEO_CODEC_OK) {
+      int ret = layer->encode_result;
+      for (size_t later_idx = stream_idx + 1; later_idx <= local_stream_idx;
+           ++later_idx) {
+        layer_states_[later_idx]->num_deferred_images = 0;
       }
+      return ret;
     }
   }
-
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
+int SimulcastEncoderAdapter::EncodeStream(
+    size_t stream_idx,
+    const VideoFrame& input_image,
+    const CodecSpecificInfo* codec_specific_info,
+    FrameType frame_type) {
+  std::vector<FrameType> stream_frame_types(1, frame_type);
+  int src_width = input_image.width();
+  int src_height = input_image.height();
+  int dst_width = streaminfos_[stream_idx].width;
+  int dst_height = streaminfos_[stream_idx].height;
+  // If scaling isn't required, because the input resolution
+  // matches the destination or the input image is empty (e.g.
+  // a keyframe request for encoders with internal camera
+  // sources) or the source image has a native handle, pass the image on
+  // directly. Otherwise, we'll scale it to match what the encoder expects
+  // (below).
+  // For texture frames, the underlying encoder is expected to be able to
+  // correctly sample/scale the source texture.
+  // TODO(perkj): ensure that works going forward, and figure out how this
+  // affects webrtc:5683.
+  if ((dst_width == src_width && dst_height == src_height) ||
+      input_image.video_frame_buffer()->native_handle()) {
+    return streaminfos_[stream_idx].encoder->Encode(
+        input_image, codec_specific_info, &stream_frame_types);
+  }
+
+  // Aligning stride values based on width.
+  rtc::scoped_refptr<I420Buffer> dst_buffer =
+      layer_states_[stream_idx]->buffer_pool.CreateBuffer(dst_width,
+                                                          dst_height);
+  libyuv::I420Scale(input_image.video_frame_buffer()->DataY(),
+                    input_image.video_frame_buffer()->StrideY(),
+                    input_image.video_frame_buffer()->DataU(),
+                    input_image.video_frame_buffer()->StrideU(),
+                    input_image.video_frame_buffer()->DataV(),
+                    input_image.video_frame_buffer()->StrideV(),
+                    src_width, src_height,
+                    dst_buffer->MutableDataY(), dst_buffer->StrideY(),
+                    dst_buffer->MutableDataU(), dst_buffer->StrideU(),
+                    dst_buffer->MutableDataV(), dst_buffer->StrideV(),
+                    dst_width, dst_height,
+                    libyuv::kFilterBilinear);
+
+  return streaminfos_[stream_idx].encoder->Encode(
+      VideoFrame(dst_buffer, input_image.timestamp(),
+                 input_image.render_time_ms(), webrtc::kVideoRotation_0),
+      codec_specific_info, &stream_frame_types);
+}
+
 int SimulcastEncoderAdapter::RegisterEncodeCompleteCallback(
     EncodedImageCallback* callback) {
   encoded_complete_callback_ = callback;
@@ -404,6 +509,31 @@ EncodedImageCallback::Result SimulcastEncoderAdapter::OnEncodedImage(
     const EncodedImage& encodedImage,
     const CodecSpecificInfo* codecSpecificInfo,
     const RTPFragmentationHeader* fragmentation) {
+  if (!defer_encoded_images_) {
+    return DeliverEncodedImage(stream_idx, encodedImage, codecSpecificInfo,
+                               fragmentation);
+  }
+
+  // Called on the thread encoding the stream, see EncodeStreamsInParallel().
+  LayerState* layer = layer_states_[stream_idx].get();
+  if (layer->num_deferred_images == layer->deferred_images.size())
+    layer->deferred_images.emplace_back(new LayerState::DeferredImage());
+  LayerState::DeferredImage* deferred =
+      layer->deferred_images[layer->num_deferred_images++].get();
+  deferred->image = encodedImage;
+  deferred->codec_specific_info = *codecSpecificInfo;
+  deferred->has_fragmentation = fragmentation != nullptr;
+  if (fragmentation)
+    deferred->fragmentation.CopyFrom(*fragmentation);
+  return EncodedImageCallback::Result(EncodedImageCallback::Result::OK,
+                                      encodedImage._timeStamp);
+}
+
+EncodedImageCallback::Result SimulcastEncoderAdapter::DeliverEncodedImage(
+    size_t stream_idx,
+    const EncodedImage& encodedImage,
+    const CodecSpecificInfo* codecSpecificInfo,
+    const RTPFragmentationHeader* fragmentation) {
   CodecSpecificInfo stream_codec_specific = *codecSpecificInfo;
   stream_codec_specific.codec_name = implementation_name_.c_str();
   CodecSpecificInfoVP8* vp8Info = &(stream_codec_specific.codecSpecific.VP8);
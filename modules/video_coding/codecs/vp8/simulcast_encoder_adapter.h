@@ -18,6 +18,10 @@
 
 #include "webrtc/modules/video_coding/codecs/vp8/include/vp8.h"
 
+namespace rtc {
+class TaskQueue;
+}  // namespace rtc
+
 namespace webrtc {
 
 class SimulcastRateAllocator;
@@ -33,6 +37,12 @@ class VideoEncoderFactory {
 // webrtc::VideoEncoder instances with the given VideoEncoderFactory.
 // All the public interfaces are expected to be called from the same thread,
 // e.g the encoder thread.
+//
+// With the WebRTC-ParallelSimulcastEncoding field trial, Encode() encodes
+// the streams concurrently: each stream but the highest one sent is scaled
+// and encoded on a worker task queue of its own, and the highest one on the
+// calling thread. Encoded images are held back until every stream is done
+// and then delivered in stream order, as in the sequential mode.
 class SimulcastEncoderAdapter : public VP8Encoder {
  public:
   explicit SimulcastEncoderAdapter(VideoEncoderFactory* factory);
@@ -66,6 +76,8 @@ class SimulcastEncoderAdapter : public VP8Encoder {
   const char* ImplementationName() const override;
 
  private:
+  struct LayerState;
+
   struct StreamInfo {
     StreamInfo()
         : encoder(NULL),
@@ -103,11 +115,35 @@ class SimulcastEncoderAdapter : public VP8Encoder {
 
   bool Initialized() const;
 
+  // Scales |input_image| to the resolution of stream |stream_idx| if needed,
+  // and encodes it.
+  int EncodeStream(size_t stream_idx,
+                   const VideoFrame& input_image,
+                   const CodecSpecificInfo* codec_specific_info,
+                   FrameType frame_type);
+  int EncodeStreamsInParallel(const VideoFrame& input_image,
+                              const CodecSpecificInfo* codec_specific_info,
+                              FrameType frame_type);
+  EncodedImageCallback::Result DeliverEncodedImage(
+      size_t stream_idx,
+      const EncodedImage& encoded_image,
+      const CodecSpecificInfo* codec_specific_info,
+      const RTPFragmentationHeader* fragmentation);
+
   std::unique_ptr<VideoEncoderFactory> factory_;
   VideoCodec codec_;
   std::vector<StreamInfo> streaminfos_;
+  // Per stream scaling buffers and, in parallel mode, held back output.
+  std::vector<std::unique_ptr<LayerState>> layer_states_;
   EncodedImageCallback* encoded_complete_callback_;
   std::string implementation_name_;
+  const bool parallel_encoding_enabled_;
+  // Workers encoding the streams below the highest one in parallel mode, one
+  // per stream. Kept across InitEncode() calls.
+  std::vector<std::unique_ptr<rtc::TaskQueue>> encoder_queues_;
+  // True while Encode() waits for streams encoded in parallel, encoded
+  // images are then held back in |layer_states_|.
+  bool defer_encoded_images_;
 };
 
 }  // namespace webrtc
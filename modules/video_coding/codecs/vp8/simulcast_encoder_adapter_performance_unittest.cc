@@ -0,0 +1,197 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/base/random.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/video_coding/codecs/vp8/simulcast_encoder_adapter.h"
+#include "webrtc/modules/video_coding/codecs/vp8/temporal_layers.h"
+#include "webrtc/modules/video_coding/include/video_codec_interface.h"
+#include "webrtc/modules/video_coding/utility/simulcast_rate_allocator.h"
+#include "webrtc/test/field_trial.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int kNumFrames = 150;
+const int kNumInputFrames = 10;
+const int kFramerate = 30;
+
+struct Resolution {
+  int width;
+  int height;
+  int max_bitrate_kbps;
+};
+// The simulcast streams of a 720p source, from the lowest.
+const Resolution kStreams[] = {
+    {320, 180, 200}, {640, 360, 700}, {1280, 720, 2500}};
+
+class Vp8EncoderFactory : public VideoEncoderFactory {
+ public:
+  VideoEncoder* Create() override { return VP8Encoder::Create(); }
+  void Destroy(VideoEncoder* encoder) override { delete encoder; }
+};
+
+class DiscardingCallback : public EncodedImageCallback {
+ public:
+  Result OnEncodedImage(const EncodedImage& encoded_image,
+                        const CodecSpecificInfo* codec_specific_info,
+                        const RTPFragmentationHeader* fragmentation) override {
+    encoded_bytes_ += encoded_image._length;
+    return Result(Result::OK, encoded_image._timeStamp);
+  }
+
+  size_t encoded_bytes_ = 0;
+};
+
+// Moving gradients with some noise, so that every frame has to be coded.
+std::vector<VideoFrame> CreateInputFrames(int width, int height) {
+  Random random(0x5eed);
+  std::vector<VideoFrame> frames;
+  for (int i = 0; i < kNumInputFrames; ++i) {
+    rtc::scoped_refptr<I420Buffer> buffer = I420Buffer::Create(width, height);
+    for (int y = 0; y < height; ++y) {
+      uint8_t* row = buffer->MutableDataY() + y * buffer->StrideY();
+      for (int x = 0; x < width; ++x)
+        row[x] = static_cast<uint8_t>(x + y + 8 * i + random.Rand(0, 15));
+    }
+    const int chroma_width = (width + 1) / 2;
+    for (int y = 0; y < (height + 1) / 2; ++y) {
+      memset(buffer->MutableDataU() + y * buffer->StrideU(), 128 + i,
+             chroma_width);
+      memset(buffer->MutableDataV() + y * buffer->StrideV(), 128 - i,
+             chroma_width);
+    }
+    frames.push_back(VideoFrame(buffer, 0, 0, kVideoRotation_0));
+  }
+  return frames;
+}
+
+// Encodes |kNumFrames| frames with |num_streams| simulcast streams, the highest
+// one in 720p, and reports the time spent in Encode() per frame. Each VP8
+// encoder is given a single core, so that any speedup comes from encoding the
+// streams concurrently.
+void RunEncodeTest(size_t num_streams, bool parallel) {
+  test::ScopedFieldTrials field_trials(
+      parallel ? "WebRTC-ParallelSimulcastEncoding/Enabled/" : "");
+  SimulcastEncoderAdapter adapter(new Vp8EncoderFactory());
+
+  const Resolution* streams = kStreams + (3 - num_streams);
+  const Resolution& top = streams[num_streams - 1];
+  VideoCodec codec;
+  memset(&codec, 0, sizeof(codec));
+  strncpy(codec.plName, "VP8", 4);
+  codec.codecType = kVideoCodecVP8;
+  codec.plType = 120;
+  codec.width = top.width;
+  codec.height = top.height;
+  codec.maxFramerate = kFramerate;
+  codec.minBitrate = 30;
+  codec.numberOfSimulcastStreams = num_streams;
+  int total_bitrate_kbps = 0;
+  for (size_t i = 0; i < num_streams; ++i) {
+    SimulcastStream* stream = &codec.simulcastStream[i];
+    stream->width = streams[i].width;
+    stream->height = streams[i].height;
+    stream->maxBitrate = streams[i].max_bitrate_kbps;
+    stream->targetBitrate = streams[i].max_bitrate_kbps;
+    stream->minBitrate = 30;
+    stream->numberOfTemporalLayers = 1;
+    stream->qpMax = 56;
+    total_bitrate_kbps += streams[i].max_bitrate_kbps;
+  }
+  codec.startBitrate = total_bitrate_kbps;
+  codec.maxBitrate = total_bitrate_kbps;
+  codec.qpMax = 56;
+  codec.VP8()->numberOfTemporalLayers = 1;
+  codec.VP8()->complexity = kComplexityNormal;
+  codec.VP8()->resilience = kResilientStream;
+  codec.VP8()->keyFrameInterval = 3000;
+  TemporalLayersFactory tl_factory;
+  codec.VP8()->tl_factory = &tl_factory;
+  SimulcastRateAllocator rate_allocator(codec, nullptr);
+  tl_factory.SetListener(&rate_allocator);
+
+  ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK, adapter.InitEncode(&codec, 1, 1200));
+  DiscardingCallback callback;
+  adapter.RegisterEncodeCompleteCallback(&callback);
+  adapter.SetRateAllocation(
+      rate_allocator.GetAllocation(total_bitrate_kbps * 1000, kFramerate),
+      kFramerate);
+
+  std::vector<VideoFrame> input_frames =
+      CreateInputFrames(top.width, top.height);
+  std::vector<int64_t> encode_times_us;
+  for (int i = 0; i < kNumFrames; ++i) {
+    const VideoFrame& input = input_frames[i % kNumInputFrames];
+    VideoFrame frame(input.video_frame_buffer(),
+                     static_cast<uint32_t>(i * 90000 / kFramerate), 0,
+                     kVideoRotation_0);
+    int64_t start_us = rtc::TimeMicros();
+    ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK, adapter.Encode(frame, nullptr, nullptr));
+    encode_times_us.push_back(rtc::TimeMicros() - start_us);
+  }
+  adapter.Release();
+  EXPECT_GT(callback.encoded_bytes_, 0u);
+
+  // The first frame is a key frame.
+  encode_times_us.erase(encode_times_us.begin());
+  int64_t total_us = 0;
+  for (int64_t encode_time_us : encode_times_us)
+    total_us += encode_time_us;
+  std::sort(encode_times_us.begin(), encode_times_us.end());
+
+  const std::string trace = std::to_string(num_streams) + "_streams_" +
+                            (parallel ? "parallel" : "sequential");
+  test::PrintResult("encode_time_median", "", trace,
+                    static_cast<size_t>(
+                        encode_times_us[encode_times_us.size() / 2]),
+                    "us", true);
+  test::PrintResult("encode_time_p95", "", trace,
+                    static_cast<size_t>(
+                        encode_times_us[encode_times_us.size() * 95 / 100]),
+                    "us", false);
+  test::PrintResult("encode_time_avg", "", trace,
+                    static_cast<size_t>(total_us / encode_times_us.size()),
+                    "us", false);
+}
+
+}  // namespace
+
+TEST(SimulcastEncoderAdapterPerformanceTest, OneStreamSequential) {
+  RunEncodeTest(1, false);
+}
+
+TEST(SimulcastEncoderAdapterPerformanceTest, TwoStreamsSequential) {
+  RunEncodeTest(2, false);
+}
+
+TEST(SimulcastEncoderAdapterPerformanceTest, TwoStreamsParallel) {
+  RunEncodeTest(2, true);
+}
+
+TEST(SimulcastEncoderAdapterPerformanceTest, ThreeStreamsSequential) {
+  RunEncodeTest(3, false);
+}
+
+TEST(SimulcastEncoderAdapterPerformanceTest, ThreeStreamsParallel) {
+  RunEncodeTest(3, true);
+}
+
+}  // namespace webrtc
@@ -15,6 +15,8 @@
 #include "webrtc/modules/video_coding/codecs/vp8/simulcast_encoder_adapter.h"
 #include "webrtc/modules/video_coding/codecs/vp8/simulcast_unittest.h"
 #include "webrtc/modules/video_coding/include/video_codec_interface.h"
+#include "webrtc/system_wrappers/include/sleep.h"
+#include "webrtc/test/field_trial.h"
 #include "webrtc/test/gmock.h"
 
 namespace webrtc {
@@ -575,5 +577,96 @@ TEST_F(TestSimulcastEncoderAdapterFake, TestInitFailureCleansUpEncoders) {
   EXPECT_TRUE(helper_->factory()->encoders().empty());
 }
 
+class TestSimulcastEncoderAdapterParallelFake
+    : public TestSimulcastEncoderAdapterFake {
+ public:
+  TestSimulcastEncoderAdapterParallelFake()
+      : field_trials_("WebRTC-ParallelSimulcastEncoding/Enabled/") {
+    // Recreated, the field trial is read at construction.
+    adapter_.reset();
+    helper_.reset(new TestSimulcastEncoderAdapterFakeHelper());
+    adapter_.reset(helper_->CreateMockEncoderAdapter());
+  }
+
+  Result OnEncodedImage(const EncodedImage& encoded_image,
+                        const CodecSpecificInfo* codec_specific_info,
+                        const RTPFragmentationHeader* fragmentation) override {
+    delivered_simulcast_indices_.push_back(
+        codec_specific_info->codecSpecific.VP8.simulcastIdx);
+    return TestSimulcastEncoderAdapterFake::OnEncodedImage(
+        encoded_image, codec_specific_info, fragmentation);
+  }
+
+  void SetupAllStreams() {
+    TestVp8Simulcast::DefaultSettings(
+        &codec_, static_cast<const int*>(kTestTemporalLayerProfile));
+    codec_.VP8()->tl_factory = &tl_factory_;
+    codec_.numberOfSimulcastStreams = 3;
+    // High start bitrate, so all streams are enabled.
+    codec_.startBitrate = 3000;
+    EXPECT_EQ(0, adapter_->InitEncode(&codec_, 1, 1200));
+    adapter_->RegisterEncodeCompleteCallback(this);
+    ASSERT_EQ(3u, helper_->factory()->encoders().size());
+  }
+
+  // Makes encoder |stream_index| send one image and return |return_value|.
+  // The lowest streams take the longest, so that they finish last.
+  void ExpectEncode(size_t stream_index, int32_t return_value) {
+    MockVideoEncoder* encoder = helper_->factory()->encoders()[stream_index];
+    EXPECT_CALL(*encoder, Encode(_, _, _))
+        .WillOnce(::testing::Invoke(
+            [encoder, stream_index, return_value](
+                const VideoFrame& frame, const CodecSpecificInfo*,
+                const std::vector<FrameType>*) {
+              SleepMs(static_cast<int>(10 * (2 - stream_index)));
+              encoder->SendEncodedImage(frame.width(), frame.height());
+              return return_value;
+            }));
+  }
+
+  VideoFrame CreateInputFrame() {
+    int half_width = (kDefaultWidth + 1) / 2;
+    rtc::scoped_refptr<I420Buffer> input_buffer = I420Buffer::Create(
+        kDefaultWidth, kDefaultHeight, kDefaultWidth, half_width, half_width);
+    input_buffer->InitializeData();
+    return VideoFrame(input_buffer, 0, 0, webrtc::kVideoRotation_0);
+  }
+
+ protected:
+  test::ScopedFieldTrials field_trials_;
+  std::vector<int> delivered_simulcast_indices_;
+};
+
+TEST_F(TestSimulcastEncoderAdapterParallelFake, DeliversStreamsInOrder) {
+  SetupAllStreams();
+  for (size_t i = 0; i < 3; ++i)
+    ExpectEncode(i, WEBRTC_VIDEO_CODEC_OK);
+
+  std::vector<FrameType> frame_types(3, kVideoFrameKey);
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK,
+            adapter_->Encode(CreateInputFrame(), nullptr, &frame_types));
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), delivered_simulcast_indices_);
+  int width;
+  int height;
+  int simulcast_index;
+  EXPECT_TRUE(GetLastEncodedImageInfo(&width, &height, &simulcast_index));
+  EXPECT_EQ(codec_.simulcastStream[2].width, width);
+  EXPECT_EQ(codec_.simulcastStream[2].height, height);
+}
+
+TEST_F(TestSimulcastEncoderAdapterParallelFake,
+       StopsDeliveringAtFirstFailingStream) {
+  SetupAllStreams();
+  ExpectEncode(0, WEBRTC_VIDEO_CODEC_OK);
+  ExpectEncode(1, WEBRTC_VIDEO_CODEC_FALLBACK_SOFTWARE);
+  ExpectEncode(2, WEBRTC_VIDEO_CODEC_OK);
+
+  std::vector<FrameType> frame_types(3, kVideoFrameKey);
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_FALLBACK_SOFTWARE,
+            adapter_->Encode(CreateInputFrame(), nullptr, &frame_types));
+  // Same output as when encoding the streams one after the other.
+  EXPECT_EQ(std::vector<int>({0, 1}), delivered_simulcast_indices_);
+}
+
 }  // namespace testing
 }  // namespace webrtc
@@ -12,7 +12,7 @@
 
 #include <algorithm>
 #include <cstring>
-#include <queue>
+#include <limits>
 
 #include "webrtc/base/checks.h"
 #include "webrtc/base/logging.h"
@@ -30,6 +30,30 @@ constexpr int kMaxFramesBuffered = 600;
 
 // Max number of decoded frame info that will be saved.
 constexpr int kMaxFramesHistory = 50;
+
+// Max number of frame infos, for both buffered frames, frames they reference
+// that haven't been received yet and decoded frames.
+constexpr int kMaxFrameInfos = 2 * kMaxFramesBuffered + kMaxFramesHistory;
+
+// The picture ids of the frame infos can't be further apart than this.
+constexpr uint16_t kMaxPictureIdSpan = 1 << 15;
+
+// Extends the range of picture ids [|first|, |last|] to include |picture_id|
+// the way SeqNumMap does. Returns false if the range would become too large.
+bool ExtendPictureIdRange(uint16_t picture_id,
+                          uint16_t* first,
+                          uint16_t* last) {
+  if (AheadOf(picture_id, *last)) {
+    if (ForwardDiff(*first, picture_id) >= kMaxPictureIdSpan)
+      return false;
+    *last = picture_id;
+  } else if (AheadOf(*first, picture_id)) {
+    if (ForwardDiff(picture_id, *last) >= kMaxPictureIdSpan)
+      return false;
+    *first = picture_id;
+  }
+  return true;
+}
 }  // namespace
 
 FrameBuffer::FrameBuffer(Clock* clock,
@@ -40,12 +64,15 @@ FrameBuffer::FrameBuffer(Clock* clock,
       jitter_estimator_(jitter_estimator),
       timing_(timing),
       inter_frame_delay_(clock_->TimeInMilliseconds()),
-      last_decoded_frame_it_(frames_.end()),
-      last_continuous_frame_it_(frames_.end()),
       num_frames_history_(0),
       num_frames_buffered_(0),
       stopped_(false),
-      protection_mode_(kProtectionNack) {}
+      protection_mode_(kProtectionNack) {
+  static_assert(kMaxFrameInfos <= std::numeric_limits<int16_t>::max(),
+                "Frame info indices must fit in PictureInfo.");
+  frame_infos_.resize(kMaxFrameInfos);
+  ClearFramesAndHistory();
+}
 
 FrameBuffer::~FrameBuffer() {
   UpdateHistograms();
@@ -56,7 +83,8 @@ FrameBuffer::ReturnReason FrameBuffer::NextFrame(
     std::unique_ptr<FrameObject>* frame_out) {
   int64_t latest_return_time = clock_->TimeInMilliseconds() + max_wait_time_ms;
   int64_t wait_ms = max_wait_time_ms;
-  FrameMap::iterator next_frame_it;
+  FrameInfo* next_frame = nullptr;
+  FrameKey next_frame_key;
 
   do {
     int64_t now_ms = clock_->TimeInMilliseconds();
@@ -68,35 +96,20 @@ FrameBuffer::ReturnReason FrameBuffer::NextFrame(
 
       wait_ms = max_wait_time_ms;
 
-      // Need to hold |crit_| in order to use |frames_|, therefore we
+      // Need to hold |crit_| in order to use |frame_infos_|, therefore we
       // set it here in the loop instead of outside the loop in order to not
       // acquire the lock unnecesserily.
-      next_frame_it = frames_.end();
-
-      // |frame_it| points to the first frame after the
-      // |last_decoded_frame_it_|.
-      auto frame_it = frames_.end();
-      if (last_decoded_frame_it_ == frames_.end()) {
-        frame_it = frames_.begin();
-      } else {
-        frame_it = last_decoded_frame_it_;
-        ++frame_it;
-      }
-
-      // |continuous_end_it| points to the first frame after the
-      // |last_continuous_frame_it_|.
-      auto continuous_end_it = last_continuous_frame_it_;
-      if (continuous_end_it != frames_.end())
-        ++continuous_end_it;
-
-      for (; frame_it != continuous_end_it; ++frame_it) {
-        if (!frame_it->second.continuous ||
-            frame_it->second.num_missing_decodable > 0) {
-          continue;
-        }
-
-        FrameObject* frame = frame_it->second.frame.get();
-        next_frame_it = frame_it;
+      next_frame = nullptr;
+
+      // Only frames that can be decoded are in the decodable list, in the
+      // order they would have been found when going through all frames after
+      // the last decoded frame.
+      for (int index = first_decodable_; index != kNoFrameInfo;
+           index = frame_infos_[index].next_decodable) {
+        FrameInfo* info = &frame_infos_[index];
+        FrameObject* frame = info->frame.get();
+        next_frame = info;
+        next_frame_key = info->key;
         if (frame->RenderTime() == -1)
           frame->SetRenderTime(timing_->RenderTimeMs(frame->timestamp, now_ms));
         wait_ms = timing_->MaxWaitingTime(frame->RenderTime(), now_ms);
@@ -116,8 +129,10 @@ FrameBuffer::ReturnReason FrameBuffer::NextFrame(
   } while (new_countinuous_frame_event_.Wait(wait_ms));
 
   rtc::CritScope lock(&crit_);
-  if (next_frame_it != frames_.end()) {
-    std::unique_ptr<FrameObject> frame = std::move(next_frame_it->second.frame);
+  // A key frame may have cleared the buffer since the lock was released.
+  if (next_frame && next_frame->decodable && next_frame->key == next_frame_key) {
+    std::unique_ptr<FrameObject> frame = std::move(next_frame->frame);
+    RemoveDecodable(next_frame);
     int64_t received_time = frame->ReceivedTime();
     uint32_t timestamp = frame->timestamp;
 
@@ -133,8 +148,8 @@ FrameBuffer::ReturnReason FrameBuffer::NextFrame(
 
     UpdateJitterDelay();
 
-    PropagateDecodability(next_frame_it->second);
-    AdvanceLastDecodedFrame(next_frame_it);
+    PropagateDecodability(*next_frame);
+    AdvanceLastDecodedFrame(next_frame_key);
     *frame_out = std::move(frame);
     return kFrameFound;
   } else {
@@ -168,9 +183,7 @@ int FrameBuffer::InsertFrame(std::unique_ptr<FrameObject> frame) {
 
   FrameKey key(frame->picture_id, frame->spatial_layer);
   int last_continuous_picture_id =
-      last_continuous_frame_it_ == frames_.end()
-          ? -1
-          : last_continuous_frame_it_->first.picture_id;
+      last_continuous_frame_ ? last_continuous_frame_->picture_id : -1;
 
   if (num_frames_buffered_ >= kMaxFramesBuffered) {
     LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) (" << key.picture_id
@@ -180,6 +193,13 @@ int FrameBuffer::InsertFrame(std::unique_ptr<FrameObject> frame) {
     return last_continuous_picture_id;
   }
 
+  if (key.spatial_layer >= kMaxVp9NumberOfSpatialLayers) {
+    LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) (" << key.picture_id
+                    << ":" << static_cast<int>(key.spatial_layer)
+                    << ") has too high spatial layer, dropping frame.";
+    return last_continuous_picture_id;
+  }
+
   if (frame->inter_layer_predicted && frame->spatial_layer == 0) {
     LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) (" << key.picture_id
                     << ":" << static_cast<int>(key.spatial_layer)
@@ -187,21 +207,36 @@ int FrameBuffer::InsertFrame(std::unique_ptr<FrameObject> frame) {
     return last_continuous_picture_id;
   }
 
-  if (last_decoded_frame_it_ != frames_.end() &&
-      key < last_decoded_frame_it_->first) {
+  if (last_decoded_frame_ && key < *last_decoded_frame_) {
     LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) (" << key.picture_id
                     << ":" << static_cast<int>(key.spatial_layer)
                     << ") inserted after frame ("
-                    << last_decoded_frame_it_->first.picture_id << ":"
-                    << static_cast<int>(
-                           last_decoded_frame_it_->first.spatial_layer)
+                    << last_decoded_frame_->picture_id << ":"
+                    << static_cast<int>(last_decoded_frame_->spatial_layer)
                     << ") was handed off for decoding, dropping frame.";
     return last_continuous_picture_id;
   }
 
-  auto info = frames_.insert(std::make_pair(key, FrameInfo())).first;
+  if (!HasRoomFor(*frame)) {
+    if (frame->num_references > 0 || frame->inter_layer_predicted) {
+      LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
+                      << key.picture_id << ":"
+                      << static_cast<int>(key.spatial_layer)
+                      << ") could not be inserted due to the frame buffer "
+                      << "being out of frame infos, dropping frame.";
+      return last_continuous_picture_id;
+    }
+    // Nothing buffered is needed to decode a key frame, so start over from
+    // it.
+    LOG(LS_INFO) << "Clearing frame buffer to make room for key frame with "
+                 << "picture id " << key.picture_id << ".";
+    ClearFramesAndHistory();
+    last_continuous_picture_id = -1;
+  }
 
-  if (info->second.frame) {
+  FrameInfo* info = GetOrAddFrameInfo(key);
+
+  if (info->frame) {
     LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) (" << key.picture_id
                     << ":" << static_cast<int>(key.spatial_layer)
                     << ") already inserted, dropping frame.";
@@ -211,13 +246,13 @@ int FrameBuffer::InsertFrame(std::unique_ptr<FrameObject> frame) {
   if (!UpdateFrameInfoWithIncomingFrame(*frame, info))
     return last_continuous_picture_id;
 
-  info->second.frame = std::move(frame);
+  info->frame = std::move(frame);
   ++num_frames_buffered_;
 
-  if (info->second.num_missing_continuous == 0) {
-    info->second.continuous = true;
+  if (info->num_missing_continuous == 0) {
+    info->continuous = true;
     PropagateContinuity(info);
-    last_continuous_picture_id = last_continuous_frame_it_->first.picture_id;
+    last_continuous_picture_id = last_continuous_frame_->picture_id;
 
     // Since we now have new continuous frames there might be a better frame
     // to return from NextFrame. Signal that thread so that it again can choose
@@ -228,31 +263,153 @@ int FrameBuffer::InsertFrame(std::unique_ptr<FrameObject> frame) {
   return last_continuous_picture_id;
 }
 
-void FrameBuffer::PropagateContinuity(FrameMap::iterator start) {
-  RTC_DCHECK(start->second.continuous);
-  if (last_continuous_frame_it_ == frames_.end())
-    last_continuous_frame_it_ = start;
+bool FrameBuffer::HasRoomFor(const FrameObject& frame) const {
+  // A frame info for the frame, each frame it references and the lower
+  // spatial layer frame.
+  if (free_frame_infos_.size() < frame.num_references + 2)
+    return false;
+  if (pictures_.empty())
+    return true;
+
+  auto last_it = pictures_.end();
+  --last_it;
+  uint16_t first = pictures_.begin()->first;
+  uint16_t last = last_it->first;
+  if (!ExtendPictureIdRange(frame.picture_id, &first, &last))
+    return false;
+  for (size_t i = 0; i < frame.num_references; ++i) {
+    if (!ExtendPictureIdRange(frame.references[i], &first, &last))
+      return false;
+  }
+  return true;
+}
+
+FrameBuffer::FrameInfo* FrameBuffer::FindFrameInfo(const FrameKey& key) {
+  auto picture_it = pictures_.find(key.picture_id);
+  if (picture_it == pictures_.end())
+    return nullptr;
+  int index = picture_it->second.frame_infos[key.spatial_layer];
+  return index == kNoFrameInfo ? nullptr : &frame_infos_[index];
+}
+
+FrameBuffer::FrameInfo* FrameBuffer::GetOrAddFrameInfo(const FrameKey& key) {
+  int16_t& index = pictures_[key.picture_id].frame_infos[key.spatial_layer];
+  if (index == kNoFrameInfo) {
+    RTC_DCHECK(!free_frame_infos_.empty());
+    index = free_frame_infos_.back();
+    free_frame_infos_.pop_back();
+    frame_infos_[index].key = key;
+  }
+  return &frame_infos_[index];
+}
+
+void FrameBuffer::RemoveFrameInfo(const FrameKey& key) {
+  auto picture_it = pictures_.find(key.picture_id);
+  RTC_DCHECK(picture_it != pictures_.end());
+  std::array<int16_t, kMaxVp9NumberOfSpatialLayers>& frame_infos =
+      picture_it->second.frame_infos;
+  int index = frame_infos[key.spatial_layer];
+  RTC_DCHECK(index != kNoFrameInfo);
+  RemoveDecodable(&frame_infos_[index]);
+  frame_infos_[index] = FrameInfo();
+  free_frame_infos_.push_back(index);
+  frame_infos[key.spatial_layer] = kNoFrameInfo;
+
+  for (int16_t layer_index : frame_infos) {
+    if (layer_index != kNoFrameInfo)
+      return;
+  }
+  pictures_.erase(picture_it);
+}
+
+void FrameBuffer::ClearFramesAndHistory() {
+  pictures_.clear();
+  free_frame_infos_.clear();
+  for (int index = kMaxFrameInfos - 1; index >= 0; --index) {
+    frame_infos_[index] = FrameInfo();
+    free_frame_infos_.push_back(index);
+  }
+  first_decodable_ = kNoFrameInfo;
+  last_decodable_ = kNoFrameInfo;
+  last_decoded_frame_ = rtc::Optional<FrameKey>();
+  last_continuous_frame_ = rtc::Optional<FrameKey>();
+  num_frames_history_ = 0;
+  num_frames_buffered_ = 0;
+}
+
+void FrameBuffer::UpdateDecodable(FrameInfo* info) {
+  if (info->decodable || !info->frame || !info->continuous ||
+      info->num_missing_decodable > 0) {
+    return;
+  }
+  if (last_decoded_frame_ && info->key <= *last_decoded_frame_)
+    return;
+
+  // Frames mostly become decodable in order, so look for where |info| goes
+  // from the back of the list.
+  const int index = static_cast<int>(info - frame_infos_.data());
+  int prev = last_decodable_;
+  while (prev != kNoFrameInfo && info->key < frame_infos_[prev].key)
+    prev = frame_infos_[prev].prev_decodable;
+
+  int next = prev == kNoFrameInfo ? first_decodable_
+                                  : frame_infos_[prev].next_decodable;
+  info->prev_decodable = prev;
+  info->next_decodable = next;
+  if (prev == kNoFrameInfo)
+    first_decodable_ = index;
+  else
+    frame_infos_[prev].next_decodable = index;
+  if (next == kNoFrameInfo)
+    last_decodable_ = index;
+  else
+    frame_infos_[next].prev_decodable = index;
+  info->decodable = true;
+}
+
+void FrameBuffer::RemoveDecodable(FrameInfo* info) {
+  if (!info->decodable)
+    return;
+
+  if (info->prev_decodable == kNoFrameInfo)
+    first_decodable_ = info->next_decodable;
+  else
+    frame_infos_[info->prev_decodable].next_decodable = info->next_decodable;
+  if (info->next_decodable == kNoFrameInfo)
+    last_decodable_ = info->prev_decodable;
+  else
+    frame_infos_[info->next_decodable].prev_decodable = info->prev_decodable;
+  info->prev_decodable = kNoFrameInfo;
+  info->next_decodable = kNoFrameInfo;
+  info->decodable = false;
+}
+
+void FrameBuffer::PropagateContinuity(FrameInfo* start) {
+  RTC_DCHECK(start->continuous);
+  if (!last_continuous_frame_)
+    last_continuous_frame_ = rtc::Optional<FrameKey>(start->key);
 
-  std::queue<FrameMap::iterator> continuous_frames;
-  continuous_frames.push(start);
+  continuous_frames_.clear();
+  continuous_frames_.push_back(start);
 
   // A simple BFS to traverse continuous frames.
-  while (!continuous_frames.empty()) {
-    auto frame = continuous_frames.front();
-    continuous_frames.pop();
+  for (size_t i = 0; i < continuous_frames_.size(); ++i) {
+    FrameInfo* frame = continuous_frames_[i];
 
-    if (last_continuous_frame_it_->first < frame->first)
-      last_continuous_frame_it_ = frame;
+    if (*last_continuous_frame_ < frame->key)
+      last_continuous_frame_ = rtc::Optional<FrameKey>(frame->key);
+    UpdateDecodable(frame);
 
     // Loop through all dependent frames, and if that frame no longer has
     // any unfulfilled dependencies then that frame is continuous as well.
-    for (size_t d = 0; d < frame->second.num_dependent_frames; ++d) {
-      auto frame_ref = frames_.find(frame->second.dependent_frames[d]);
-      --frame_ref->second.num_missing_continuous;
-
-      if (frame_ref->second.num_missing_continuous == 0) {
-        frame_ref->second.continuous = true;
-        continuous_frames.push(frame_ref);
+    for (size_t d = 0; d < frame->num_dependent_frames; ++d) {
+      FrameInfo* frame_ref = FindFrameInfo(frame->dependent_frames[d]);
+      RTC_DCHECK(frame_ref);
+      --frame_ref->num_missing_continuous;
+
+      if (frame_ref->num_missing_continuous == 0) {
+        frame_ref->continuous = true;
+        continuous_frames_.push_back(frame_ref);
       }
     }
   }
@@ -260,55 +417,73 @@ void FrameBuffer::PropagateContinuity(FrameMap::iterator start) {
 
 void FrameBuffer::PropagateDecodability(const FrameInfo& info) {
   for (size_t d = 0; d < info.num_dependent_frames; ++d) {
-    auto ref_info = frames_.find(info.dependent_frames[d]);
-    RTC_DCHECK(ref_info != frames_.end());
-    RTC_DCHECK_GT(ref_info->second.num_missing_decodable, 0U);
-    --ref_info->second.num_missing_decodable;
+    FrameInfo* ref_info = FindFrameInfo(info.dependent_frames[d]);
+    RTC_DCHECK(ref_info);
+    RTC_DCHECK_GT(ref_info->num_missing_decodable, 0U);
+    --ref_info->num_missing_decodable;
+    UpdateDecodable(ref_info);
   }
 }
 
-void FrameBuffer::AdvanceLastDecodedFrame(FrameMap::iterator decoded) {
-  if (last_decoded_frame_it_ == frames_.end()) {
-    last_decoded_frame_it_ = frames_.begin();
-  } else {
-    RTC_DCHECK(last_decoded_frame_it_->first < decoded->first);
-    ++last_decoded_frame_it_;
-  }
+void FrameBuffer::AdvanceLastDecodedFrame(const FrameKey& decoded) {
+  RTC_DCHECK(!last_decoded_frame_ || *last_decoded_frame_ < decoded);
   --num_frames_buffered_;
   ++num_frames_history_;
 
   // First, delete non-decoded frames from the history.
-  while (last_decoded_frame_it_ != decoded) {
-    if (last_decoded_frame_it_->second.frame)
-      --num_frames_buffered_;
-    last_decoded_frame_it_ = frames_.erase(last_decoded_frame_it_);
+  auto picture_it = last_decoded_frame_
+                        ? pictures_.lower_bound(last_decoded_frame_->picture_id)
+                        : pictures_.begin();
+  while (picture_it != pictures_.end() &&
+         !AheadOf(picture_it->first, decoded.picture_id)) {
+    const uint16_t picture_id = picture_it->first;
+    const PictureInfo picture = picture_it->second;
+    // Removing the frame infos of the picture may erase it.
+    ++picture_it;
+    for (size_t layer = 0; layer < picture.frame_infos.size(); ++layer) {
+      if (picture.frame_infos[layer] == kNoFrameInfo)
+        continue;
+      FrameKey key(picture_id, static_cast<uint8_t>(layer));
+      if ((last_decoded_frame_ && key <= *last_decoded_frame_) ||
+          decoded <= key) {
+        continue;
+      }
+      if (frame_infos_[picture.frame_infos[layer]].frame)
+        --num_frames_buffered_;
+      RemoveFrameInfo(key);
+    }
   }
+  last_decoded_frame_ = rtc::Optional<FrameKey>(decoded);
 
   // Then remove old history if we have too much history saved.
   if (num_frames_history_ > kMaxFramesHistory) {
-    frames_.erase(frames_.begin());
+    auto oldest_it = pictures_.begin();
+    const std::array<int16_t, kMaxVp9NumberOfSpatialLayers>& frame_infos =
+        oldest_it->second.frame_infos;
+    size_t layer = 0;
+    while (frame_infos[layer] == kNoFrameInfo)
+      ++layer;
+    RemoveFrameInfo(FrameKey(oldest_it->first, static_cast<uint8_t>(layer)));
     --num_frames_history_;
   }
 }
 
 bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const FrameObject& frame,
-                                                   FrameMap::iterator info) {
+                                                   FrameInfo* info) {
   FrameKey key(frame.picture_id, frame.spatial_layer);
-  info->second.num_missing_continuous = frame.num_references;
-  info->second.num_missing_decodable = frame.num_references;
+  info->num_missing_continuous = frame.num_references;
+  info->num_missing_decodable = frame.num_references;
 
-  RTC_DCHECK(last_decoded_frame_it_ == frames_.end() ||
-             last_decoded_frame_it_->first < info->first);
+  RTC_DCHECK(!last_decoded_frame_ || *last_decoded_frame_ < info->key);
 
   // Check how many dependencies that have already been fulfilled.
   for (size_t i = 0; i < frame.num_references; ++i) {
     FrameKey ref_key(frame.references[i], frame.spatial_layer);
-    auto ref_info = frames_.find(ref_key);
+    FrameInfo* ref_info = FindFrameInfo(ref_key);
 
     // Does |frame| depend on a frame earlier than the last decoded frame?
-    if (last_decoded_frame_it_ != frames_.end() &&
-        ref_key <= last_decoded_frame_it_->first) {
-      if (ref_info == frames_.end()) {
+    if (last_decoded_frame_ && ref_key <= *last_decoded_frame_) {
+      if (!ref_info) {
         LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
                         << key.picture_id << ":"
                         << static_cast<int>(key.spatial_layer)
@@ -317,49 +492,46 @@ bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const FrameObject& frame,
         return false;
       }
 
-      --info->second.num_missing_continuous;
-      --info->second.num_missing_decodable;
+      --info->num_missing_continuous;
+      --info->num_missing_decodable;
     } else {
-      if (ref_info == frames_.end())
-        ref_info = frames_.insert(std::make_pair(ref_key, FrameInfo())).first;
+      if (!ref_info)
+        ref_info = GetOrAddFrameInfo(ref_key);
 
-      if (ref_info->second.continuous)
-        --info->second.num_missing_continuous;
+      if (ref_info->continuous)
+        --info->num_missing_continuous;
 
       // Add backwards reference so |frame| can be updated when new
       // frames are inserted or decoded.
-      ref_info->second.dependent_frames[ref_info->second.num_dependent_frames] =
-          key;
-      ++ref_info->second.num_dependent_frames;
+      ref_info->dependent_frames[ref_info->num_dependent_frames] = key;
+      ++ref_info->num_dependent_frames;
     }
-    RTC_DCHECK_LE(ref_info->second.num_missing_continuous,
-                  ref_info->second.num_missing_decodable);
+    RTC_DCHECK_LE(ref_info->num_missing_continuous,
+                  ref_info->num_missing_decodable);
   }
 
   // Check if we have the lower spatial layer frame.
   if (frame.inter_layer_predicted) {
-    ++info->second.num_missing_continuous;
-    ++info->second.num_missing_decodable;
+    ++info->num_missing_continuous;
+    ++info->num_missing_decodable;
 
     FrameKey ref_key(frame.picture_id, frame.spatial_layer - 1);
     // Gets or create the FrameInfo for the referenced frame.
-    auto ref_info = frames_.insert(std::make_pair(ref_key, FrameInfo())).first;
-    if (ref_info->second.continuous)
-      --info->second.num_missing_continuous;
+    FrameInfo* ref_info = GetOrAddFrameInfo(ref_key);
+    if (ref_info->continuous)
+      --info->num_missing_continuous;
 
-    if (ref_info == last_decoded_frame_it_) {
-      --info->second.num_missing_decodable;
+    if (last_decoded_frame_ && ref_key == *last_decoded_frame_) {
+      --info->num_missing_decodable;
     } else {
-      ref_info->second.dependent_frames[ref_info->second.num_dependent_frames] =
-          key;
-      ++ref_info->second.num_dependent_frames;
+      ref_info->dependent_frames[ref_info->num_dependent_frames] = key;
+      ++ref_info->num_dependent_frames;
     }
-    RTC_DCHECK_LE(ref_info->second.num_missing_continuous,
-                  ref_info->second.num_missing_decodable);
+    RTC_DCHECK_LE(ref_info->num_missing_continuous,
+                  ref_info->num_missing_decodable);
   }
 
-  RTC_DCHECK_LE(info->second.num_missing_continuous,
-                info->second.num_missing_decodable);
+  RTC_DCHECK_LE(info->num_missing_continuous, info->num_missing_decodable);
 
   return true;
 }
@@ -12,13 +12,14 @@
 #define WEBRTC_MODULES_VIDEO_CODING_FRAME_BUFFER2_H_
 
 #include <array>
-#include <map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "webrtc/base/constructormagic.h"
 #include "webrtc/base/criticalsection.h"
 #include "webrtc/base/event.h"
+#include "webrtc/base/optional.h"
 #include "webrtc/base/thread_annotations.h"
 #include "webrtc/modules/video_coding/frame_object.h"
 #include "webrtc/modules/video_coding/include/video_coding_defines.h"
@@ -85,14 +86,23 @@ class FrameBuffer {
 
     bool operator<=(const FrameKey& rhs) const { return !(rhs < *this); }
 
+    bool operator==(const FrameKey& rhs) const {
+      return picture_id == rhs.picture_id &&
+             spatial_layer == rhs.spatial_layer;
+    }
+
     uint16_t picture_id;
     uint8_t spatial_layer;
   };
 
+  static constexpr int kNoFrameInfo = -1;
+
   struct FrameInfo {
     // The maximum number of frames that can depend on this frame.
     static constexpr size_t kMaxNumDependentFrames = 8;
 
+    FrameKey key;
+
     // Which other frames that have direct unfulfilled dependencies
     // on this frame.
     FrameKey dependent_frames[kMaxNumDependentFrames];
@@ -112,38 +122,91 @@ class FrameBuffer {
     // If this frame is continuous or not.
     bool continuous = false;
 
+    // If this frame is in the list of frames that can be decoded, and the
+    // frames before and after it in that list.
+    bool decodable = false;
+    int prev_decodable = kNoFrameInfo;
+    int next_decodable = kNoFrameInfo;
+
     // The actual FrameObject.
     std::unique_ptr<FrameObject> frame;
   };
 
-  using FrameMap = std::map<FrameKey, FrameInfo>;
+  // Where in |frame_infos_| the FrameInfo of each spatial layer of a picture
+  // is, or kNoFrameInfo.
+  struct PictureInfo {
+    PictureInfo() { frame_infos.fill(kNoFrameInfo); }
+
+    std::array<int16_t, kMaxVp9NumberOfSpatialLayers> frame_infos;
+  };
+
+  // Returns the FrameInfo of |key|, or null if there is none.
+  FrameInfo* FindFrameInfo(const FrameKey& key) EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Returns the FrameInfo of |key|, adding it if there is none. There must be
+  // room for it, see HasRoomFor.
+  FrameInfo* GetOrAddFrameInfo(const FrameKey& key)
+      EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Whether there are enough free FrameInfos for |frame| and the frames it
+  // references, and their picture ids aren't too far from the ones of the
+  // FrameInfos in use.
+  bool HasRoomFor(const FrameObject& frame) const
+      EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes the FrameInfo of |key|, which must be present.
+  void RemoveFrameInfo(const FrameKey& key) EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes all frames and the history of decoded frames.
+  void ClearFramesAndHistory() EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Adds |info| to the list of frames that can be decoded if it is
+  // continuous, has all the frames it references decoded and hasn't been
+  // handed off for decoding yet.
+  void UpdateDecodable(FrameInfo* info) EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes |info| from the list of frames that can be decoded, if it is in
+  // it.
+  void RemoveDecodable(FrameInfo* info) EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Update all directly dependent and indirectly dependent frames and mark
   // them as continuous if all their references has been fulfilled.
-  void PropagateContinuity(FrameMap::iterator start)
-      EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  void PropagateContinuity(FrameInfo* start) EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Marks the frame as decoded and updates all directly dependent frames.
   void PropagateDecodability(const FrameInfo& info)
       EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
-  // Advances |last_decoded_frame_it_| to |decoded| and removes old
+  // Advances |last_decoded_frame_| to |decoded| and removes old
   // frame info.
-  void AdvanceLastDecodedFrame(FrameMap::iterator decoded)
+  void AdvanceLastDecodedFrame(const FrameKey& decoded)
       EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Update the corresponding FrameInfo of |frame| and all FrameInfos that
   // |frame| references.
   // Return false if |frame| will never be decodable, true otherwise.
   bool UpdateFrameInfoWithIncomingFrame(const FrameObject& frame,
-                                        FrameMap::iterator info)
+                                        FrameInfo* info)
       EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   void UpdateJitterDelay() EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   void UpdateHistograms() const;
 
-  FrameMap frames_ GUARDED_BY(crit_);
+  // The FrameInfos of all frames, both received and referenced ones, in a
+  // pool allocated up front, and where each of them is by picture id. Neither
+  // allocates per frame.
+  std::vector<FrameInfo> frame_infos_ GUARDED_BY(crit_);
+  std::vector<int> free_frame_infos_ GUARDED_BY(crit_);
+  SeqNumMap<uint16_t, PictureInfo> pictures_ GUARDED_BY(crit_);
+
+  // The frames that can be decoded, in decoding order, linked through their
+  // FrameInfos. NextFrame only has to look at these.
+  int first_decodable_ GUARDED_BY(crit_);
+  int last_decodable_ GUARDED_BY(crit_);
+
+  // Scratch space of PropagateContinuity.
+  std::vector<FrameInfo*> continuous_frames_ GUARDED_BY(crit_);
 
   rtc::CriticalSection crit_;
   Clock* const clock_;
@@ -151,8 +214,8 @@ class FrameBuffer {
   VCMJitterEstimator* const jitter_estimator_ GUARDED_BY(crit_);
   VCMTiming* const timing_ GUARDED_BY(crit_);
   VCMInterFrameDelay inter_frame_delay_ GUARDED_BY(crit_);
-  FrameMap::iterator last_decoded_frame_it_ GUARDED_BY(crit_);
-  FrameMap::iterator last_continuous_frame_it_ GUARDED_BY(crit_);
+  rtc::Optional<FrameKey> last_decoded_frame_ GUARDED_BY(crit_);
+  rtc::Optional<FrameKey> last_continuous_frame_ GUARDED_BY(crit_);
   int num_frames_history_ GUARDED_BY(crit_);
   int num_frames_buffered_ GUARDED_BY(crit_);
   bool stopped_ GUARDED_BY(crit_);
@@ -0,0 +1,161 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/checks.h"
+#include "webrtc/base/logging.h"
+#include "webrtc/base/random.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/video_coding/frame_buffer2.h"
+#include "webrtc/modules/video_coding/frame_object.h"
+#include "webrtc/modules/video_coding/jitter_estimator.h"
+#include "webrtc/modules/video_coding/timing.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace video_coding {
+namespace {
+
+const int kNumSpatialLayers = 4;
+const int kFramerate = 30;
+const int kNumSuperFrames = 30 * kFramerate;
+// Frames are reordered within windows of this many super frames, and
+// extracted for decoding at the end of a window.
+const int kReorderWindow = 3;
+
+class FakeFrame : public FrameObject {
+ public:
+  bool GetBitstream(uint8_t* destination) const override { return true; }
+  uint32_t Timestamp() const override { return timestamp; }
+  int64_t ReceivedTime() const override { return 0; }
+  int64_t RenderTime() const override { return _renderTimeMs; }
+};
+
+// The layer frames of a VP9 stream with |kNumSpatialLayers| spatial layers and
+// three temporal layers in the 0-2-1-2 pattern, where every upper spatial
+// layer frame is predicted from the layer below it. The frames of a few super
+// frames at a time are shuffled, like when packets are retransmitted.
+std::vector<std::unique_ptr<FrameObject>> CreateFrames() {
+  const uint8_t kTemporalPattern[] = {0, 2, 1, 2};
+  Random random(0x5eed);
+  std::vector<std::unique_ptr<FrameObject>> frames;
+  for (int picture_id = 0; picture_id < kNumSuperFrames; ++picture_id) {
+    const uint8_t temporal_idx = kTemporalPattern[picture_id % 4];
+    for (int spatial_layer = 0; spatial_layer < kNumSpatialLayers;
+         ++spatial_layer) {
+      std::unique_ptr<FakeFrame> frame(new FakeFrame());
+      frame->picture_id = picture_id;
+      frame->spatial_layer = spatial_layer;
+      frame->timestamp = picture_id * 90000 / kFramerate;
+      frame->inter_layer_predicted = spatial_layer > 0;
+      frame->num_references = 0;
+      if (picture_id > 0) {
+        // Temporal layer 0 references the previous layer 0 frame, 1 and 2
+        // the previous frame on a lower layer.
+        int reference = temporal_idx == 0 ? picture_id - 4
+                      : temporal_idx == 1 ? picture_id - 2
+                                          : picture_id - 1;
+        frame->references[0] = static_cast<uint16_t>(reference);
+        frame->num_references = 1;
+      }
+      frames.push_back(std::move(frame));
+    }
+  }
+  const size_t window = kReorderWindow * kNumSpatialLayers;
+  for (size_t start = window; start + window <= frames.size();
+       start += window) {
+    for (size_t i = start + window - 1; i > start; --i)
+      std::swap(frames[i], frames[start + random.Rand(0u, i - start)]);
+  }
+  return frames;
+}
+
+// Inserts the frames of CreateFrames() into a FrameBuffer, and every
+// |decode_interval| super frames, a multiple of |kReorderWindow|, extracts all
+// frames that are ready to be decoded. Unless |late| is set, the playout
+// delay is long enough that every frame is decoded in order; otherwise the
+// FrameBuffer skips ahead to the newest decodable frame. Reports the time
+// spent inserting and extracting frames per inserted frame.
+void RunDecodeTest(int decode_interval, bool late, const std::string& trace) {
+  std::vector<std::unique_ptr<FrameObject>> frames = CreateFrames();
+  const size_t num_frames = frames.size();
+  RTC_DCHECK_EQ(0, decode_interval % kReorderWindow);
+  SimulatedClock clock(0);
+  VCMTiming timing(&clock);
+  if (!late)
+    timing.set_min_playout_delay(10000);
+  VCMJitterEstimator jitter_estimator(&clock);
+  FrameBuffer buffer(&clock, &jitter_estimator, &timing);
+  // Frames arriving after the decoder skipped past them are logged.
+  rtc::LoggingSeverity log_severity = rtc::LogMessage::GetLogToDebug();
+  rtc::LogMessage::LogToDebug(rtc::LS_ERROR);
+
+  int64_t insert_ns = 0;
+  int64_t next_frame_ns = 0;
+  int decoded_frames = 0;
+  const size_t frames_per_interval = decode_interval * kNumSpatialLayers;
+  for (size_t i = 0; i < num_frames; ++i) {
+    // Like the RTP receiver does for every packet.
+    timing.IncomingTimestamp(frames[i]->timestamp, clock.TimeInMilliseconds());
+    int64_t start_ns = rtc::TimeNanos();
+    buffer.InsertFrame(std::move(frames[i]));
+    insert_ns += rtc::TimeNanos() - start_ns;
+
+    if ((i + 1) % kNumSpatialLayers == 0)
+      clock.AdvanceTimeMilliseconds(1000 / kFramerate);
+    if ((i + 1) % frames_per_interval != 0 && i + 1 != num_frames)
+      continue;
+    while (true) {
+      std::unique_ptr<FrameObject> frame;
+      start_ns = rtc::TimeNanos();
+      FrameBuffer::ReturnReason reason = buffer.NextFrame(0, &frame);
+      next_frame_ns += rtc::TimeNanos() - start_ns;
+      if (reason != FrameBuffer::kFrameFound)
+        break;
+      ++decoded_frames;
+    }
+  }
+  rtc::LogMessage::LogToDebug(log_severity);
+
+  test::PrintResult("insert_frame_time", "", trace,
+                    static_cast<size_t>(insert_ns / num_frames), "ns/frame",
+                    true);
+  // Includes waiting on the new frame event, which is not free even with a
+  // zero timeout.
+  test::PrintResult("next_frame_time", "", trace,
+                    static_cast<size_t>(next_frame_ns / num_frames),
+                    "ns/frame", true);
+  test::PrintResult("decoded_frames", "", trace,
+                    static_cast<size_t>(decoded_frames), "frames", false);
+  EXPECT_GT(decoded_frames, 0);
+}
+
+}  // namespace
+
+TEST(FrameBuffer2PerformanceTest, DecodeEveryReorderWindow) {
+  RunDecodeTest(kReorderWindow, false, "decode_every_reorder_window");
+}
+
+TEST(FrameBuffer2PerformanceTest, DecodeEverySecond) {
+  RunDecodeTest(kFramerate, false, "decode_every_second");
+}
+
+TEST(FrameBuffer2PerformanceTest, DecodeEverySecondLate) {
+  RunDecodeTest(kFramerate, true, "decode_every_second_late");
+}
+
+}  // namespace video_coding
+}  // namespace webrtc
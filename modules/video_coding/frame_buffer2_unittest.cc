@@ -419,5 +419,23 @@ TEST_F(TestFrameBuffer2, LastContinuousFrameTwoLayers) {
   EXPECT_EQ(pid + 3, InsertFrame(pid + 3, 1, ts, true, pid + 2));
 }
 
+TEST_F(TestFrameBuffer2, KeyFrameFarAheadClearsBuffer) {
+  uint16_t pid = Rand();
+  uint16_t far_pid = pid + 40000;
+  uint32_t ts = Rand();
+
+  EXPECT_EQ(pid, InsertFrame(pid, 0, ts, false));
+  EXPECT_EQ(pid, InsertFrame(pid + 2, 0, ts, false, pid + 1));
+  EXPECT_EQ(pid, InsertFrame(pid + 20000, 0, ts, false, pid + 19999));
+  // Too far from the oldest buffered frame to be kept together with it.
+  EXPECT_EQ(pid, InsertFrame(far_pid, 0, ts, false, far_pid - 1));
+  EXPECT_EQ(far_pid, InsertFrame(far_pid, 0, ts, false));
+
+  ExtractFrame();
+  ExtractFrame();
+  CheckFrame(0, far_pid, 0);
+  CheckNoFrame(1);
+}
+
 }  // namespace video_coding
 }  // namespace webrtc
@@ -11,9 +11,7 @@
 #ifndef WEBRTC_MODULES_VIDEO_CODING_NACK_MODULE_H_
 #define WEBRTC_MODULES_VIDEO_CODING_NACK_MODULE_H_
 
-#include <map>
 #include <vector>
-#include <set>
 
 #include "webrtc/base/criticalsection.h"
 #include "webrtc/base/thread_annotations.h"
@@ -82,10 +80,8 @@ class NackModule : public Module {
   NackSender* const nack_sender_;
   KeyFrameRequestSender* const keyframe_request_sender_;
 
-  std::map<uint16_t, NackInfo, DescendingSeqNumComp<uint16_t>> nack_list_
-      GUARDED_BY(crit_);
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t>> keyframe_list_
-      GUARDED_BY(crit_);
+  SeqNumMap<uint16_t, NackInfo> nack_list_ GUARDED_BY(crit_);
+  SeqNumSet<uint16_t> keyframe_list_ GUARDED_BY(crit_);
   video_coding::Histogram reordering_histogram_ GUARDED_BY(crit_);
   bool running_ GUARDED_BY(crit_);
   bool initialized_ GUARDED_BY(crit_);
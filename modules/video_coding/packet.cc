@@ -85,6 +85,7 @@ void VCMPacket::Reset() {
   width = 0;
   height = 0;
   memset(&video_header, 0, sizeof(RTPVideoHeader));
+  receive_buffer = rtc::CopyOnWriteBuffer();
 }
 
 void VCMPacket::CopyCodecSpecifics(const RTPVideoHeader& videoHeader) {
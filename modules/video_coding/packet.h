@@ -12,6 +12,7 @@
 #define WEBRTC_MODULES_VIDEO_CODING_PACKET_H_
 
 #include "webrtc/base/deprecation.h"
+#include "webrtc/base/copyonwritebuffer.h"
 #include "webrtc/modules/include/module_common_types.h"
 #include "webrtc/modules/video_coding/jitter_buffer_common.h"
 #include "webrtc/typedefs.h"
@@ -50,6 +51,9 @@ class VCMPacket {
   int width;
   int height;
   RTPVideoHeader video_header;
+  // If not empty, the received RTP packet that |dataPtr| points into, which
+  // is referenced instead of copying the payload. Used by the PacketBuffer.
+  rtc::CopyOnWriteBuffer receive_buffer;
 
  protected:
   void CopyCodecSpecifics(const RTPVideoHeader& videoHeader);
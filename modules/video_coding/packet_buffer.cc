@@ -22,6 +22,18 @@
 
 namespace webrtc {
 namespace video_coding {
+namespace {
+
+// Frees the payload of |packet|, or drops the reference to the receive buffer
+// it points into.
+void ReleasePayload(VCMPacket* packet) {
+  if (packet->receive_buffer.size() == 0)
+    delete[] packet->dataPtr;
+  packet->dataPtr = nullptr;
+  packet->receive_buffer = rtc::CopyOnWriteBuffer();
+}
+
+}  // namespace
 
 rtc::scoped_refptr<PacketBuffer> PacketBuffer::Create(
     Clock* clock,
@@ -69,8 +81,7 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
       // If we have explicitly cleared past this packet then it's old,
       // don't insert it.
       if (is_cleared_to_first_seq_num_) {
-        delete[] packet->dataPtr;
-        packet->dataPtr = nullptr;
+        ReleasePayload(packet);
         return false;
       }
 
@@ -80,8 +91,7 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
     if (sequence_buffer_[index].used) {
       // Duplicate packet, just delete the payload.
       if (data_buffer_[index].seqNum == packet->seqNum) {
-        delete[] packet->dataPtr;
-        packet->dataPtr = nullptr;
+        ReleasePayload(packet);
         return true;
       }
 
@@ -92,8 +102,7 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
 
       // Packet buffer is still full.
       if (sequence_buffer_[index].used) {
-        delete[] packet->dataPtr;
-        packet->dataPtr = nullptr;
+        ReleasePayload(packet);
         return false;
       }
     }
@@ -104,7 +113,7 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
     sequence_buffer_[index].continuous = false;
     sequence_buffer_[index].frame_created = false;
     sequence_buffer_[index].used = true;
-    data_buffer_[index] = *packet;
+    data_buffer_[index] = std::move(*packet);
     packet->dataPtr = nullptr;
 
     found_frames = FindFrames(seq_num);
@@ -126,8 +135,7 @@ void PacketBuffer::ClearTo(uint16_t seq_num) {
   is_cleared_to_first_seq_num_ = true;
   while (AheadOrAt<uint16_t>(seq_num, first_seq_num_)) {
     size_t index = first_seq_num_ % size_;
-    delete[] data_buffer_[index].dataPtr;
-    data_buffer_[index].dataPtr = nullptr;
+    ReleasePayload(&data_buffer_[index]);
     sequence_buffer_[index].used = false;
     ++first_seq_num_;
   }
@@ -136,8 +144,7 @@ void PacketBuffer::ClearTo(uint16_t seq_num) {
 void PacketBuffer::Clear() {
   rtc::CritScope lock(&crit_);
   for (size_t i = 0; i < size_; ++i) {
-    delete[] data_buffer_[i].dataPtr;
-    data_buffer_[i].dataPtr = nullptr;
+    ReleasePayload(&data_buffer_[i]);
     sequence_buffer_[i].used = false;
   }
 
@@ -241,8 +248,7 @@ void PacketBuffer::ReturnFrame(RtpFrameObject* frame) {
   uint16_t seq_num = frame->first_seq_num();
   while (index != end) {
     if (sequence_buffer_[index].seq_num == seq_num) {
-      delete[] data_buffer_[index].dataPtr;
-      data_buffer_[index].dataPtr = nullptr;
+      ReleasePayload(&data_buffer_[index]);
       sequence_buffer_[index].used = false;
     }
 
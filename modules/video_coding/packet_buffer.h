@@ -50,7 +50,9 @@ class PacketBuffer {
 
   // Returns true if |packet| is inserted into the packet buffer, false
   // otherwise. The PacketBuffer will always take ownership of the
-  // |packet.dataPtr| when this function is called. Made virtual for testing.
+  // |packet.dataPtr| when this function is called, or of the reference to
+  // |packet.receive_buffer| if |packet.dataPtr| points into it. Made virtual
+  // for testing.
   virtual bool InsertPacket(VCMPacket* packet);
   void ClearTo(uint16_t seq_num);
   void Clear();
@@ -467,14 +467,6 @@ void RtpFrameReferenceFinder::ManageFrameVp9(
     up_switch_.insert(pid_tidx);
   }
 
-  // If this is a base layer frame that contains a scalability structure
-  // then gof info has already been inserted earlier, so we only want to
-  // insert if we haven't done so already.
-  if (codec_header.temporal_idx == 0 && !codec_header.ss_data_available) {
-    GofInfo new_info(info->gof, frame->picture_id);
-    gof_info_.insert(std::make_pair(codec_header.tl0_pic_idx, new_info));
-  }
-
   // Clean out old info about up switch frames.
   uint16_t old_picture_id = Subtract<kPicIdLength>(frame->picture_id, 50);
   auto up_switch_erase_to = up_switch_.lower_bound(old_picture_id);
@@ -498,6 +490,15 @@ void RtpFrameReferenceFinder::ManageFrameVp9(
     }
   }
 
+  // If this is a base layer frame that contains a scalability structure
+  // then gof info has already been inserted earlier, so we only want to
+  // insert if we haven't done so already. This is done last since inserting
+  // may move the element |info| points to.
+  if (codec_header.temporal_idx == 0 && !codec_header.ss_data_available) {
+    GofInfo new_info(info->gof, frame->picture_id);
+    gof_info_.insert(std::make_pair(codec_header.tl0_pic_idx, new_info));
+  }
+
   CompletedFrameVp9(std::move(frame));
 }
 
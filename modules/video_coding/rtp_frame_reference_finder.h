@@ -15,7 +15,6 @@
 #include <map>
 #include <memory>
 #include <deque>
-#include <set>
 #include <utility>
 
 #include "webrtc/base/criticalsection.h"
@@ -67,6 +66,7 @@ class RtpFrameReferenceFinder {
 
 
   struct GofInfo {
+    GofInfo() : gof(nullptr), last_picture_id(0) {}
     GofInfo(GofInfoVP9* gof, uint16_t last_picture_id)
         : gof(gof), last_picture_id(last_picture_id) {}
     GofInfoVP9* gof;
@@ -152,6 +152,8 @@ class RtpFrameReferenceFinder {
   // the sequence number of the last packet of the last completed frame, and
   // the second being the sequence number of the last packet of the last
   // completed frame advanced by any potential continuous packets of padding.
+  // Keyframes are sparse and the last one is kept however old it is, so this
+  // isn't a SeqNumMap.
   std::map<uint16_t,
            std::pair<uint16_t, uint16_t>,
            DescendingSeqNumComp<uint16_t>>
@@ -163,8 +165,7 @@ class RtpFrameReferenceFinder {
 
   // Padding packets that have been received but that are not yet continuous
   // with any group of pictures.
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t>> stashed_padding_
-      GUARDED_BY(crit_);
+  SeqNumSet<uint16_t> stashed_padding_ GUARDED_BY(crit_);
 
   // The last unwrapped picture id. Used to unwrap the picture id from a length
   // of |kPicIdLength| to 16 bits.
@@ -172,8 +173,8 @@ class RtpFrameReferenceFinder {
 
   // Frames earlier than the last received frame that have not yet been
   // fully received.
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t, kPicIdLength>>
-      not_yet_received_frames_ GUARDED_BY(crit_);
+  SeqNumSet<uint16_t, kPicIdLength> not_yet_received_frames_
+      GUARDED_BY(crit_);
 
   // Frames that have been fully received but didn't have all the information
   // needed to determine their references.
@@ -181,10 +182,8 @@ class RtpFrameReferenceFinder {
 
   // Holds the information about the last completed frame for a given temporal
   // layer given a Tl0 picture index.
-  std::map<uint8_t,
-           std::array<int16_t, kMaxTemporalLayers>,
-           DescendingSeqNumComp<uint8_t>>
-      layer_info_ GUARDED_BY(crit_);
+  SeqNumMap<uint8_t, std::array<int16_t, kMaxTemporalLayers>> layer_info_
+      GUARDED_BY(crit_);
 
   // Where the current scalability structure is in the
   // |scalability_structures_| array.
@@ -195,17 +194,14 @@ class RtpFrameReferenceFinder {
       GUARDED_BY(crit_);
 
   // Holds the the Gof information for a given TL0 picture index.
-  std::map<uint8_t, GofInfo, DescendingSeqNumComp<uint8_t>> gof_info_
-      GUARDED_BY(crit_);
+  SeqNumMap<uint8_t, GofInfo> gof_info_ GUARDED_BY(crit_);
 
   // Keep track of which picture id and which temporal layer that had the
   // up switch flag set.
-  std::map<uint16_t, uint8_t, DescendingSeqNumComp<uint16_t, kPicIdLength>>
-      up_switch_ GUARDED_BY(crit_);
+  SeqNumMap<uint16_t, uint8_t, kPicIdLength> up_switch_ GUARDED_BY(crit_);
 
   // For every temporal layer, keep a set of which frames that are missing.
-  std::array<std::set<uint16_t, DescendingSeqNumComp<uint16_t, kPicIdLength>>,
-             kMaxTemporalLayers>
+  std::array<SeqNumSet<uint16_t, kPicIdLength>, kMaxTemporalLayers>
       missing_frames_for_layer_ GUARDED_BY(crit_);
 
   // How far frames have been cleared by sequence number. A frame will be
@@ -11,9 +11,16 @@
 #ifndef WEBRTC_MODULES_VIDEO_CODING_SEQUENCE_NUMBER_UTIL_H_
 #define WEBRTC_MODULES_VIDEO_CODING_SEQUENCE_NUMBER_UTIL_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <iterator>
 #include <limits>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "webrtc/base/checks.h"
 #include "webrtc/base/mod_ops.h"
 
 namespace webrtc {
@@ -105,6 +112,493 @@ struct DescendingSeqNumComp
   }
 };
 
+namespace internal {
+
+// Index of the lowest set bit of |word|, which must not be zero.
+inline int LowestSetBit(uint64_t word) {
+#ifdef __GNUC__
+  return __builtin_ctzll(word);
+#else
+  int bit = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    ++bit;
+  }
+  return bit;
+#endif
+}
+
+// Index of the highest set bit of |word|, which must not be zero.
+inline int HighestSetBit(uint64_t word) {
+#ifdef __GNUC__
+  return 63 - __builtin_clzll(word);
+#else
+  int bit = 63;
+  while (!(word >> 63)) {
+    word <<= 1;
+    --bit;
+  }
+  return bit;
+#endif
+}
+
+// The values of a SeqNumRing, one per slot. Empty value types take no space.
+template <typename V, bool = std::is_empty<V>::value>
+class SeqNumRingValues {
+ public:
+  void Resize(size_t size) { values_.resize(size); }
+  V& operator[](size_t slot) { return values_[slot]; }
+  const V& operator[](size_t slot) const { return values_[slot]; }
+  void Swap(SeqNumRingValues* other) { values_.swap(other->values_); }
+
+ private:
+  std::vector<V> values_;
+};
+
+template <typename V>
+class SeqNumRingValues<V, true> {
+ public:
+  void Resize(size_t size) {}
+  V& operator[](size_t slot) { return value_; }
+  const V& operator[](size_t slot) const { return value_; }
+  void Swap(SeqNumRingValues* other) {}
+
+ private:
+  V value_;
+};
+
+struct NoValue {};
+
+// Ordered container of sequence numbers that wrap around at |M|, or at the
+// size of |T| if |M| is 0, with a |V| for each of them. Keys are stored in a
+// ring of slots indexed by the key modulo the capacity, with a bitmap of the
+// slots in use, so inserting, finding and erasing a key is a few bit
+// operations and iterating skips 64 empty slots at a time. The ring grows to
+// cover the distance between the oldest and the newest key.
+//
+// Like with AscendingSeqNumComp, the keys can't be further apart than half
+// the sequence number space. Inserting a key further away than that from the
+// oldest or newest key drops the keys at the other end. Looking up a key
+// that is too far from the oldest key to be ahead of it treats it as older
+// than all keys.
+//
+// Iterators refer to keys and stay valid until their key is erased. Pointers
+// and references to values are invalidated when the ring grows.
+template <typename T, typename V, T M>
+class SeqNumRing {
+ public:
+  static_assert(std::is_unsigned<T>::value && sizeof(T) <= 2,
+                "Type must be an unsigned integer of at most 16 bits.");
+  static const uint32_t kModulus =
+      M == 0 ? uint32_t{std::numeric_limits<T>::max()} + 1 : M;
+  static_assert((kModulus & (kModulus - 1)) == 0 && kModulus >= 128,
+                "The sequence number space must be a power of two.");
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  void clear() {
+    for (size_t offset = 0; size_ > 0 && offset != kNone;
+         offset = NextOffset(offset + 1)) {
+      EraseSlot(Slot(KeyAt(offset)));
+    }
+    size_ = 0;
+  }
+
+ protected:
+  static const size_t kNone = static_cast<size_t>(-1);
+  static const size_t kMinCapacity = 64;
+  static const size_t kMaxCapacity = kModulus / 2;
+
+  SeqNumRing()
+      : capacity_(kMinCapacity), used_(kMinCapacity / 64), first_(0),
+        last_(0), size_(0) {
+    values_.Resize(capacity_);
+  }
+
+  // Distance from |from| forward to |to|.
+  static size_t Distance(T from, T to) {
+    return (static_cast<uint32_t>(to) - from) & (kModulus - 1);
+  }
+  static bool IsAhead(T a, T b) {
+    return internal::SeqNumComp<T, std::integral_constant<T, M>>()(a, b);
+  }
+
+  size_t Slot(T key) const { return key & (capacity_ - 1); }
+  bool Used(size_t slot) const { return (used_[slot / 64] >> slot % 64) & 1; }
+  T KeyAt(size_t offset) const {
+    return static_cast<T>((first_ + offset) & (kModulus - 1));
+  }
+  size_t Span() const { return Distance(first_, last_); }
+
+  // Offset from the oldest key of |key|, or kNone if it isn't present.
+  size_t Find(T key) const {
+    size_t offset = Distance(first_, key);
+    if (size_ == 0 || offset > Span() || !Used(Slot(key)))
+      return kNone;
+    return offset;
+  }
+
+  // Offset of the first key at or after |offset|, or kNone if there is none.
+  size_t NextOffset(size_t offset) const {
+    const size_t span = Span();
+    const size_t first_slot = Slot(first_);
+    while (offset <= span) {
+      size_t slot = (first_slot + offset) & (capacity_ - 1);
+      uint64_t word = used_[slot / 64] >> (slot % 64);
+      if (word) {
+        offset += LowestSetBit(word);
+        return offset <= span ? offset : kNone;
+      }
+      offset += 64 - slot % 64;
+    }
+    return kNone;
+  }
+
+  // Whether |key| is before the oldest key. Keys that are too far from the
+  // oldest key to be ahead of it count as being before it, even if they are
+  // ahead of the newest key, so that a stale key doesn't compare as new.
+  bool IsBeforeFirst(T key) const {
+    return key != first_ && !IsAhead(key, first_);
+  }
+
+  // The key after |key|, which must be present and not be the newest key.
+  // Slots outside of the oldest to newest key are never in use, so this is a
+  // scan for the next bit set in the bitmap.
+  T NextKey(T key) const {
+    // The capacity is a multiple of 64, so a key has the same bit position
+    // in its word of the bitmap as in its slot.
+    const uint32_t next = key + 1u;
+    const size_t slot = Slot(static_cast<T>(next));
+    uint64_t word = used_[slot / 64] >> (next % 64);
+    if (word)
+      return static_cast<T>((next + LowestSetBit(word)) & (kModulus - 1));
+    size_t index = slot / 64;
+    do {
+      index = (index + 1) & (used_.size() - 1);
+    } while (!used_[index]);
+    const size_t found = index * 64 + LowestSetBit(used_[index]);
+    return static_cast<T>((next + ((found - slot) & (capacity_ - 1))) &
+                          (kModulus - 1));
+  }
+
+  // The key before |key|, which must be present and not be the oldest key.
+  T PrevKey(T key) const {
+    const size_t mask = capacity_ - 1;
+    const size_t slot = Slot(key);
+    size_t prev = (slot - 1) & mask;
+    uint64_t word = used_[prev / 64] << (63 - prev % 64);
+    if (word) {
+      prev -= 63 - HighestSetBit(word);
+    } else {
+      size_t index = prev / 64;
+      do {
+        index = (index - 1) & (used_.size() - 1);
+      } while (!used_[index]);
+      prev = index * 64 + HighestSetBit(used_[index]);
+    }
+    return static_cast<T>((key - ((slot - prev) & mask)) & (kModulus - 1));
+  }
+
+  T first() const { return first_; }
+  T last() const { return last_; }
+
+  // Offset of the first key that isn't before |key|, or kNone.
+  size_t LowerBound(T key) const {
+    if (size_ == 0)
+      return kNone;
+    if (IsBeforeFirst(key))
+      return 0;
+    size_t offset = Distance(first_, key);
+    return offset > Span() ? kNone : NextOffset(offset);
+  }
+
+  // Offset of the first key after |key|, or kNone.
+  size_t UpperBound(T key) const {
+    if (size_ == 0)
+      return kNone;
+    if (IsBeforeFirst(key))
+      return 0;
+    size_t offset = Distance(first_, key);
+    return offset >= Span() ? kNone : NextOffset(offset + 1);
+  }
+
+  // Inserts |key| with a default value if it isn't present. Returns true if
+  // it was inserted.
+  bool Insert(T key) {
+    if (size_ == 0) {
+      first_ = last_ = key;
+    } else if (IsAhead(key, last_)) {
+      while (size_ > 0 && Distance(first_, key) >= kMaxCapacity)
+        Erase(first_);
+      if (size_ == 0)
+        first_ = key;
+      Reserve(Distance(first_, key));
+      last_ = key;
+    } else if (IsAhead(first_, key)) {
+      while (size_ > 0 && Distance(key, last_) >= kMaxCapacity)
+        Erase(last_);
+      if (size_ == 0)
+        last_ = key;
+      Reserve(Distance(key, last_));
+      first_ = key;
+    } else if (Used(Slot(key))) {
+      return false;
+    }
+    size_t slot = Slot(key);
+    used_[slot / 64] |= uint64_t{1} << (slot % 64);
+    ++size_;
+    return true;
+  }
+
+  // Erases |key|, which must be present.
+  void Erase(T key) {
+    RTC_DCHECK(Find(key) != kNone);
+    if (key == first_ && key != last_)
+      first_ = NextKey(key);
+    else if (key == last_ && key != first_)
+      last_ = PrevKey(key);
+    EraseSlot(Slot(key));
+    --size_;
+  }
+
+  SeqNumRingValues<V> values_;
+
+ private:
+  void EraseSlot(size_t slot) {
+    used_[slot / 64] &= ~(uint64_t{1} << (slot % 64));
+    values_[slot] = V();
+  }
+
+  // Grows the ring to hold keys |span| apart.
+  void Reserve(size_t span) {
+    if (span < capacity_)
+      return;
+    size_t capacity = capacity_;
+    while (capacity <= span)
+      capacity *= 2;
+    RTC_DCHECK(capacity <= kMaxCapacity);
+
+    std::vector<uint64_t> used(capacity / 64);
+    SeqNumRingValues<V> values;
+    values.Resize(capacity);
+    for (size_t offset = NextOffset(0); offset != kNone;
+         offset = NextOffset(offset + 1)) {
+      T key = KeyAt(offset);
+      size_t slot = key & (capacity - 1);
+      used[slot / 64] |= uint64_t{1} << (slot % 64);
+      values[slot] = std::move(values_[Slot(key)]);
+    }
+    used_.swap(used);
+    values_.Swap(&values);
+    capacity_ = capacity;
+  }
+
+  size_t capacity_;
+  std::vector<uint64_t> used_;
+  // Oldest and newest keys, valid if |size_| > 0.
+  T first_;
+  T last_;
+  size_t size_;
+};
+
+}  // namespace internal
+
+// Ordered set of sequence numbers, oldest first, like a std::set with
+// DescendingSeqNumComp. See internal::SeqNumRing.
+template <typename T, T M = 0>
+class SeqNumSet : public internal::SeqNumRing<T, internal::NoValue, M> {
+  using Ring = internal::SeqNumRing<T, internal::NoValue, M>;
+
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = const T*;
+    using reference = T;
+
+    T operator*() const { return key_; }
+    const_iterator& operator++() {
+      if (key_ == set_->last())
+        key_end_ = true;
+      else
+        key_ = set_->NextKey(key_);
+      return *this;
+    }
+    const_iterator& operator--() {
+      if (key_end_) {
+        key_end_ = false;
+        key_ = set_->last();
+      } else {
+        key_ = set_->PrevKey(key_);
+      }
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const {
+      return key_end_ == other.key_end_ && (key_end_ || key_ == other.key_);
+    }
+    bool operator!=(const const_iterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    friend class SeqNumSet;
+    const_iterator(const SeqNumSet* set, T key, bool end)
+        : set_(set), key_(key), key_end_(end) {}
+
+    const SeqNumSet* set_;
+    T key_;
+    bool key_end_;
+  };
+  using iterator = const_iterator;
+
+  const_iterator begin() const { return At(Ring::empty() ? Ring::kNone : 0); }
+  const_iterator end() const { return const_iterator(this, 0, true); }
+  const_iterator find(T key) const { return At(Ring::Find(key)); }
+  const_iterator lower_bound(T key) const { return At(Ring::LowerBound(key)); }
+  const_iterator upper_bound(T key) const { return At(Ring::UpperBound(key)); }
+  size_t count(T key) const { return Ring::Find(key) != Ring::kNone; }
+
+  std::pair<const_iterator, bool> insert(T key) {
+    bool inserted = Ring::Insert(key);
+    return std::make_pair(find(key), inserted);
+  }
+
+  size_t erase(T key) {
+    if (Ring::Find(key) == Ring::kNone)
+      return 0;
+    Ring::Erase(key);
+    return 1;
+  }
+  const_iterator erase(const_iterator it) {
+    const_iterator next = it;
+    ++next;
+    Ring::Erase(*it);
+    return next;
+  }
+  const_iterator erase(const_iterator first, const_iterator last) {
+    while (first != last)
+      first = erase(first);
+    return last;
+  }
+
+ private:
+  const_iterator At(size_t offset) const {
+    return offset == Ring::kNone ? end()
+                                 : const_iterator(this, Ring::KeyAt(offset),
+                                                  false);
+  }
+};
+
+// Ordered map from sequence numbers, oldest first, like a std::map with
+// DescendingSeqNumComp. See internal::SeqNumRing.
+template <typename T, typename V, T M = 0>
+class SeqNumMap : public internal::SeqNumRing<T, std::pair<T, V>, M> {
+  using Ring = internal::SeqNumRing<T, std::pair<T, V>, M>;
+
+ public:
+  using value_type = std::pair<T, V>;
+
+  template <typename Map, typename Value>
+  class iterator_base {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = Value;
+    using difference_type = ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+
+    Value& operator*() const { return map_->values_[map_->Slot(key_)]; }
+    Value* operator->() const { return &**this; }
+    iterator_base& operator++() {
+      if (key_ == map_->last())
+        key_end_ = true;
+      else
+        key_ = map_->NextKey(key_);
+      return *this;
+    }
+    iterator_base& operator--() {
+      if (key_end_) {
+        key_end_ = false;
+        key_ = map_->last();
+      } else {
+        key_ = map_->PrevKey(key_);
+      }
+      return *this;
+    }
+    bool operator==(const iterator_base& other) const {
+      return key_end_ == other.key_end_ && (key_end_ || key_ == other.key_);
+    }
+    bool operator!=(const iterator_base& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    friend class SeqNumMap;
+    iterator_base(Map* map, T key, bool end)
+        : map_(map), key_(key), key_end_(end) {}
+
+    Map* map_;
+    T key_;
+    bool key_end_;
+  };
+  using iterator = iterator_base<SeqNumMap, value_type>;
+  using const_iterator = iterator_base<const SeqNumMap, const value_type>;
+
+  iterator begin() { return At<iterator>(Ring::empty() ? Ring::kNone : 0); }
+  const_iterator begin() const {
+    return At<const_iterator>(Ring::empty() ? Ring::kNone : 0);
+  }
+  iterator end() { return iterator(this, 0, true); }
+  const_iterator end() const { return const_iterator(this, 0, true); }
+  iterator find(T key) { return At<iterator>(Ring::Find(key)); }
+  const_iterator find(T key) const {
+    return At<const_iterator>(Ring::Find(key));
+  }
+  iterator lower_bound(T key) { return At<iterator>(Ring::LowerBound(key)); }
+  iterator upper_bound(T key) { return At<iterator>(Ring::UpperBound(key)); }
+  size_t count(T key) const { return Ring::Find(key) != Ring::kNone; }
+
+  V& operator[](T key) { return insert(value_type(key, V())).first->second; }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    bool inserted = Ring::Insert(value.first);
+    iterator it = find(value.first);
+    if (inserted)
+      *it = value;
+    return std::make_pair(it, inserted);
+  }
+
+  size_t erase(T key) {
+    if (Ring::Find(key) == Ring::kNone)
+      return 0;
+    Ring::Erase(key);
+    return 1;
+  }
+  iterator erase(iterator it) {
+    iterator next = it;
+    ++next;
+    Ring::Erase(it->first);
+    return next;
+  }
+  iterator erase(iterator first, iterator last) {
+    while (first != last)
+      first = erase(first);
+    return last;
+  }
+
+ private:
+  template <typename Iterator>
+  Iterator At(size_t offset) const {
+    return offset == Ring::kNone
+               ? Iterator(const_cast<SeqNumMap*>(this), 0, true)
+               : Iterator(const_cast<SeqNumMap*>(this), Ring::KeyAt(offset),
+                          false);
+  }
+};
+
 }  // namespace webrtc
 
 #endif  // WEBRTC_MODULES_VIDEO_CODING_SEQUENCE_NUMBER_UTIL_H_
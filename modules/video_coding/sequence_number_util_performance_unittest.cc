@@ -0,0 +1,299 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/random.h"
+#include "webrtc/base/scoped_ref_ptr.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/modules/video_coding/frame_object.h"
+#include "webrtc/modules/video_coding/nack_module.h"
+#include "webrtc/modules/video_coding/packet_buffer.h"
+#include "webrtc/modules/video_coding/rtp_frame_reference_finder.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int kPacketsPerSecond = 2000;
+const int kFramesPerSecond = 30;
+const int kDurationSeconds = 60;
+const int kRttMs = 100;
+const int kMaxRetransmissions = 10;
+const int kProcessIntervalMs = 20;
+const int kKeyFrameIntervalFrames = 10 * kFramesPerSecond;
+
+// A packet of a stream sent at |kPacketsPerSecond|, with the time it is
+// received at, or -1 if it and all its retransmissions are lost.
+struct ReceivedPacket {
+  int64_t receive_time_us;
+  // Index of the packet in the stream, |seq_num| unwrapped.
+  int index;
+  uint16_t seq_num;
+  bool first_in_frame;
+  bool keyframe;
+};
+
+// Drops every transmission with probability |loss|, and retransmits lost
+// packets once per |kRttMs|. Returns the packets in the order they arrive,
+// each once.
+std::vector<ReceivedPacket> SimulateLossyStream(double loss) {
+  Random random(0x5eed);
+  const int num_packets = kPacketsPerSecond * kDurationSeconds;
+  const int packets_per_frame = kPacketsPerSecond / kFramesPerSecond;
+  std::vector<ReceivedPacket> packets;
+  for (int i = 0; i < num_packets; ++i) {
+    ReceivedPacket packet;
+    packet.index = i;
+    packet.seq_num = static_cast<uint16_t>(i);
+    packet.first_in_frame = i % packets_per_frame == 0;
+    packet.keyframe = i / packets_per_frame % kKeyFrameIntervalFrames == 0;
+    packet.receive_time_us = -1;
+    int64_t send_time_us = int64_t{i} * rtc::kNumMicrosecsPerSec /
+                           kPacketsPerSecond;
+    for (int attempt = 0; attempt <= kMaxRetransmissions; ++attempt) {
+      if (random.Rand<double>() >= loss) {
+        packet.receive_time_us =
+            send_time_us + attempt * kRttMs * rtc::kNumMicrosecsPerMillisec;
+        break;
+      }
+    }
+    if (packet.receive_time_us != -1)
+      packets.push_back(packet);
+  }
+  std::stable_sort(packets.begin(), packets.end(),
+                   [](const ReceivedPacket& a, const ReceivedPacket& b) {
+                     return a.receive_time_us < b.receive_time_us;
+                   });
+  return packets;
+}
+
+std::string LossTrace(double loss) {
+  return std::to_string(static_cast<int>(loss * 100)) + "_percent_loss";
+}
+
+class NullNackSender : public NackSender, public KeyFrameRequestSender {
+ public:
+  void SendNack(const std::vector<uint16_t>& sequence_numbers) override {
+    nacks_sent_ += sequence_numbers.size();
+  }
+  void RequestKeyFrame() override { ++keyframes_requested_; }
+
+  size_t nacks_sent_ = 0;
+  int keyframes_requested_ = 0;
+};
+
+// Feeds NackModule the packets of a lossy stream, calling Process() every
+// |kProcessIntervalMs| and clearing up to the packets of complete frames
+// like the receive stream does.
+void RunNackModuleTest(double loss) {
+  std::vector<ReceivedPacket> packets = SimulateLossyStream(loss);
+  SimulatedClock clock(0);
+  NullNackSender sender;
+  NackModule nack_module(&clock, &sender, &sender);
+
+  const int64_t start_us = rtc::TimeMicros();
+  int64_t next_process_us = 0;
+  uint16_t newest_seq_num = 0;
+  for (const ReceivedPacket& received : packets) {
+    while (next_process_us <= received.receive_time_us) {
+      clock.AdvanceTimeMicroseconds(next_process_us -
+                                    clock.TimeInMicroseconds());
+      nack_module.Process();
+      // Frames older than an RTT are done with, one way or another.
+      nack_module.ClearUpTo(static_cast<uint16_t>(
+          newest_seq_num - kPacketsPerSecond * kRttMs / 1000));
+      next_process_us += kProcessIntervalMs * rtc::kNumMicrosecsPerMillisec;
+    }
+    clock.AdvanceTimeMicroseconds(received.receive_time_us -
+                                  clock.TimeInMicroseconds());
+    VCMPacket packet;
+    packet.seqNum = received.seq_num;
+    packet.is_first_packet_in_frame = received.first_in_frame;
+    packet.frameType = received.keyframe ? kVideoFrameKey : kVideoFrameDelta;
+    nack_module.OnReceivedPacket(packet);
+    if (AheadOf(received.seq_num, newest_seq_num))
+      newest_seq_num = received.seq_num;
+  }
+  const int64_t elapsed_us = rtc::TimeMicros() - start_us;
+
+  const std::string trace = LossTrace(loss);
+  test::PrintResult("nack_module_time", "", trace,
+                    static_cast<size_t>(elapsed_us * 1000 / packets.size()),
+                    "ns/packet", true);
+  test::PrintResult("nacks_sent", "", trace, sender.nacks_sent_, "packets",
+                    false);
+  EXPECT_EQ(0, sender.keyframes_requested_);
+}
+
+// Keeps the first and last packet of recent frames, which is all
+// RtpFrameObject reads.
+class FakePacketBuffer : public video_coding::PacketBuffer {
+ public:
+  FakePacketBuffer() : PacketBuffer(nullptr, 0, 0, nullptr), packets_(8192) {}
+
+  VCMPacket* GetPacket(uint16_t seq_num) override {
+    VCMPacket* packet = &packets_[seq_num % packets_.size()];
+    return packet->seqNum == seq_num ? packet : nullptr;
+  }
+  bool InsertPacket(VCMPacket* packet) override {
+    packets_[packet->seqNum % packets_.size()] = *packet;
+    return true;
+  }
+  bool GetBitstream(const video_coding::RtpFrameObject& frame,
+                    uint8_t* destination) override {
+    return true;
+  }
+  void ReturnFrame(video_coding::RtpFrameObject* frame) override {}
+
+ private:
+  std::vector<VCMPacket> packets_;
+};
+
+class FrameCounter : public video_coding::OnCompleteFrameCallback {
+ public:
+  void OnCompleteFrame(
+      std::unique_ptr<video_coding::FrameObject> frame) override {
+    ++complete_frames_;
+  }
+
+  int complete_frames_ = 0;
+};
+
+// Hands RtpFrameReferenceFinder the frames of a lossy VP8 or VP9 stream with
+// three temporal layers as they get complete, which is out of order when
+// packets are retransmitted.
+void RunReferenceFinderTest(VideoCodecType codec, double loss) {
+  std::vector<ReceivedPacket> packets = SimulateLossyStream(loss);
+  const int packets_per_frame = kPacketsPerSecond / kFramesPerSecond;
+  const int num_frames = kPacketsPerSecond * kDurationSeconds /
+                         packets_per_frame;
+  // A frame is complete when its last packet is received.
+  std::vector<int64_t> complete_time_us(num_frames, 0);
+  std::vector<int> packets_received(num_frames, 0);
+  for (const ReceivedPacket& packet : packets) {
+    int frame = packet.index / packets_per_frame;
+    if (frame >= num_frames)
+      continue;
+    complete_time_us[frame] =
+        std::max(complete_time_us[frame], packet.receive_time_us);
+    ++packets_received[frame];
+  }
+  std::vector<int> frame_order;
+  for (int frame = 0; frame < num_frames; ++frame) {
+    if (packets_received[frame] == packets_per_frame)
+      frame_order.push_back(frame);
+  }
+  std::stable_sort(frame_order.begin(), frame_order.end(),
+                   [&complete_time_us](int a, int b) {
+                     return complete_time_us[a] < complete_time_us[b];
+                   });
+
+  GofInfoVP9 gof;
+  gof.SetGofInfoVP9(kTemporalStructureMode3);
+  const uint8_t kTemporalPattern[] = {0, 2, 1, 2};
+  rtc::scoped_refptr<FakePacketBuffer> packet_buffer(new FakePacketBuffer());
+  FrameCounter counter;
+  video_coding::RtpFrameReferenceFinder reference_finder(&counter);
+
+  int64_t elapsed_ns = 0;
+  for (int frame : frame_order) {
+    uint16_t first_seq_num = static_cast<uint16_t>(frame * packets_per_frame);
+    uint16_t last_seq_num =
+        static_cast<uint16_t>(first_seq_num + packets_per_frame - 1);
+    const bool keyframe = frame % kKeyFrameIntervalFrames == 0;
+    const uint8_t temporal_idx = kTemporalPattern[frame % 4];
+    const int tl0_pic_idx = frame / 4;
+    // The first frame of each upper layer after a key frame is a sync frame.
+    const bool layer_sync =
+        temporal_idx > 0 && frame % kKeyFrameIntervalFrames < 4;
+
+    VCMPacket packet;
+    packet.codec = codec;
+    packet.timestamp = frame * 90000 / kFramesPerSecond;
+    packet.seqNum = first_seq_num;
+    packet.frameType = keyframe ? kVideoFrameKey : kVideoFrameDelta;
+    if (codec == kVideoCodecVP8) {
+      RTPVideoHeaderVP8& vp8 = packet.video_header.codecHeader.VP8;
+      vp8.pictureId = frame % (1 << 15);
+      vp8.temporalIdx = temporal_idx;
+      vp8.tl0PicIdx = tl0_pic_idx % 256;
+      vp8.layerSync = layer_sync;
+    } else {
+      RTPVideoHeaderVP9& vp9 = packet.video_header.codecHeader.VP9;
+      vp9.flexible_mode = false;
+      vp9.picture_id = frame % (1 << 15);
+      vp9.temporal_idx = temporal_idx;
+      vp9.spatial_idx = 0;
+      vp9.tl0_pic_idx = tl0_pic_idx % 256;
+      vp9.temporal_up_switch = layer_sync;
+      if (keyframe) {
+        vp9.ss_data_available = true;
+        vp9.gof = gof;
+      }
+    }
+    packet_buffer->InsertPacket(&packet);
+    packet.seqNum = last_seq_num;
+    packet.markerBit = true;
+    packet_buffer->InsertPacket(&packet);
+
+    std::unique_ptr<video_coding::RtpFrameObject> frame_object(
+        new video_coding::RtpFrameObject(packet_buffer.get(), first_seq_num,
+                                         last_seq_num, 0, 0, 0));
+    const int64_t start_ns = rtc::TimeNanos();
+    reference_finder.ManageFrame(std::move(frame_object));
+    elapsed_ns += rtc::TimeNanos() - start_ns;
+  }
+
+  const std::string trace =
+      std::string(codec == kVideoCodecVP8 ? "vp8_" : "vp9_") + LossTrace(loss);
+  test::PrintResult("reference_finder_time", "", trace,
+                    static_cast<size_t>(elapsed_ns /
+                                        std::max<size_t>(frame_order.size(),
+                                                         1)),
+                    "ns/frame", true);
+  test::PrintResult("complete_frames", "", trace,
+                    static_cast<size_t>(counter.complete_frames_), "frames",
+                    false);
+  EXPECT_GT(counter.complete_frames_, 0);
+}
+
+}  // namespace
+
+TEST(NackModulePerformanceTest, FivePercentLoss) {
+  RunNackModuleTest(0.05);
+}
+
+TEST(NackModulePerformanceTest, TwentyPercentLoss) {
+  RunNackModuleTest(0.2);
+}
+
+TEST(RtpFrameReferenceFinderPerformanceTest, Vp8FivePercentLoss) {
+  RunReferenceFinderTest(kVideoCodecVP8, 0.05);
+}
+
+TEST(RtpFrameReferenceFinderPerformanceTest, Vp8TwentyPercentLoss) {
+  RunReferenceFinderTest(kVideoCodecVP8, 0.2);
+}
+
+TEST(RtpFrameReferenceFinderPerformanceTest, Vp9FivePercentLoss) {
+  RunReferenceFinderTest(kVideoCodecVP9, 0.05);
+}
+
+TEST(RtpFrameReferenceFinderPerformanceTest, Vp9TwentyPercentLoss) {
+  RunReferenceFinderTest(kVideoCodecVP9, 0.2);
+}
+
+}  // namespace webrtc
@@ -8,8 +8,11 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <map>
 #include <set>
+#include <vector>
 
+#include "webrtc/base/random.h"
 #include "webrtc/modules/video_coding/sequence_number_util.h"
 #include "webrtc/test/gtest.h"
 
@@ -209,4 +212,168 @@ TEST_F(TestSeqNumUtil, SeqNumComparatorWithDivisor) {
   }
 }
 
+TEST(SeqNumSetTest, IteratesInOrderAcrossWrap) {
+  SeqNumSet<uint16_t> seq_nums;
+  const std::vector<uint16_t> expected = {0xfff0, 0xfffe, 0xffff, 0, 3, 500};
+  for (auto it = expected.rbegin(); it != expected.rend(); ++it)
+    EXPECT_TRUE(seq_nums.insert(*it).second);
+  EXPECT_FALSE(seq_nums.insert(3).second);
+  EXPECT_EQ(expected.size(), seq_nums.size());
+
+  std::vector<uint16_t> iterated(seq_nums.begin(), seq_nums.end());
+  EXPECT_EQ(expected, iterated);
+
+  auto it = seq_nums.end();
+  for (auto expected_it = expected.rbegin(); expected_it != expected.rend();
+       ++expected_it) {
+    --it;
+    EXPECT_EQ(*expected_it, *it);
+  }
+  EXPECT_TRUE(it == seq_nums.begin());
+}
+
+TEST(SeqNumSetTest, LowerAndUpperBound) {
+  SeqNumSet<uint16_t> seq_nums;
+  seq_nums.insert(0xfffe);
+  seq_nums.insert(2);
+  seq_nums.insert(10);
+
+  EXPECT_EQ(0xfffe, *seq_nums.lower_bound(0xfff0));
+  EXPECT_EQ(0xfffe, *seq_nums.lower_bound(0xfffe));
+  EXPECT_EQ(2, *seq_nums.lower_bound(0xffff));
+  EXPECT_EQ(2, *seq_nums.upper_bound(0xfffe));
+  EXPECT_EQ(10, *seq_nums.upper_bound(2));
+  EXPECT_TRUE(seq_nums.lower_bound(11) == seq_nums.end());
+  EXPECT_TRUE(seq_nums.upper_bound(10) == seq_nums.end());
+}
+
+TEST(SeqNumSetTest, BoundsOfStaleKeyAreBegin) {
+  SeqNumSet<uint8_t> seq_nums;
+  for (uint8_t seq_num = 29; seq_num <= 79; ++seq_num)
+    seq_nums.insert(seq_num);
+
+  // 207 is exactly half the range ahead of 79, but isn't ahead of 29.
+  EXPECT_EQ(29, *seq_nums.lower_bound(207));
+  EXPECT_EQ(29, *seq_nums.upper_bound(207));
+  seq_nums.erase(seq_nums.begin(), seq_nums.lower_bound(207));
+  EXPECT_EQ(51u, seq_nums.size());
+}
+
+TEST(SeqNumSetTest, RangeErase) {
+  SeqNumSet<uint16_t> seq_nums;
+  for (uint16_t seq_num = 0xff00; seq_num != 0x0100; ++seq_num)
+    seq_nums.insert(seq_num);
+  EXPECT_EQ(512u, seq_nums.size());
+
+  seq_nums.erase(seq_nums.begin(), seq_nums.lower_bound(0));
+  EXPECT_EQ(256u, seq_nums.size());
+  EXPECT_EQ(0, *seq_nums.begin());
+
+  EXPECT_EQ(1u, seq_nums.erase(0));
+  EXPECT_EQ(0u, seq_nums.erase(0));
+  EXPECT_EQ(1, *seq_nums.begin());
+
+  seq_nums.clear();
+  EXPECT_TRUE(seq_nums.empty());
+  EXPECT_TRUE(seq_nums.begin() == seq_nums.end());
+}
+
+TEST(SeqNumSetTest, DropsOldestWhenSpanningHalfTheRange) {
+  SeqNumSet<uint8_t> seq_nums;
+  seq_nums.insert(0);
+  seq_nums.insert(100);
+  seq_nums.insert(127);
+  EXPECT_EQ(3u, seq_nums.size());
+
+  // 128 can't be ordered against 0.
+  seq_nums.insert(128);
+  EXPECT_EQ(3u, seq_nums.size());
+  EXPECT_EQ(100, *seq_nums.begin());
+  EXPECT_EQ(0u, seq_nums.count(0));
+}
+
+TEST(SeqNumSetTest, WithDivisor) {
+  const uint16_t kPicIdLength = 1 << 15;
+  SeqNumSet<uint16_t, kPicIdLength> pic_ids;
+  pic_ids.insert(kPicIdLength - 1);
+  pic_ids.insert(0);
+  EXPECT_EQ(kPicIdLength - 1, *pic_ids.begin());
+  EXPECT_EQ(0, *pic_ids.upper_bound(kPicIdLength - 1));
+}
+
+TEST(SeqNumMapTest, InsertDoesNotOverwrite) {
+  SeqNumMap<uint16_t, int> map;
+  EXPECT_TRUE(map.insert(std::make_pair(uint16_t{7}, 1)).second);
+  EXPECT_FALSE(map.insert(std::make_pair(uint16_t{7}, 2)).second);
+  EXPECT_EQ(1, map.find(7)->second);
+  map[7] = 3;
+  EXPECT_EQ(3, map.find(7)->second);
+  EXPECT_TRUE(map.find(8) == map.end());
+}
+
+TEST(SeqNumMapTest, IteratorsStayValidWhenGrowing) {
+  SeqNumMap<uint16_t, int> map;
+  map[0xfff0] = 1;
+  auto it = map.find(0xfff0);
+  for (uint16_t seq_num = 0; seq_num < 5000; ++seq_num)
+    map[seq_num] = seq_num;
+  EXPECT_EQ(0xfff0, it->first);
+  EXPECT_EQ(1, it->second);
+  ++it;
+  EXPECT_EQ(0, it->first);
+  EXPECT_EQ(5001u, map.size());
+}
+
+TEST(SeqNumMapTest, EraseWhileIterating) {
+  SeqNumMap<uint16_t, int> map;
+  for (uint16_t seq_num = 0xffe0; seq_num != 0x20; ++seq_num)
+    map[seq_num] = seq_num % 2;
+  for (auto it = map.begin(); it != map.end();) {
+    if (it->second)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+  EXPECT_EQ(32u, map.size());
+  for (const auto& entry : map)
+    EXPECT_EQ(0, entry.first % 2);
+}
+
+TEST(SeqNumMapTest, MatchesStdMap) {
+  Random random(0x1234);
+  SeqNumMap<uint16_t, int> map;
+  std::map<uint16_t, int, DescendingSeqNumComp<uint16_t>> reference;
+  uint16_t base = 0xf000;
+  for (int i = 0; i < 20000; ++i) {
+    uint16_t seq_num = base + random.Rand(0, 2000);
+    switch (random.Rand(0, 4)) {
+      case 0:
+      case 1:
+        map[seq_num] = i;
+        reference[seq_num] = i;
+        break;
+      case 2:
+        map.erase(seq_num);
+        reference.erase(seq_num);
+        break;
+      case 3:
+        map.erase(map.begin(), map.lower_bound(seq_num));
+        reference.erase(reference.begin(), reference.lower_bound(seq_num));
+        break;
+      case 4:
+        base += random.Rand(0, 100);
+        break;
+    }
+    ASSERT_EQ(reference.size(), map.size());
+  }
+  auto it = map.begin();
+  for (const auto& entry : reference) {
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ(entry.first, it->first);
+    EXPECT_EQ(entry.second, it->second);
+    ++it;
+  }
+  EXPECT_TRUE(it == map.end());
+}
+
 }  // namespace webrtc
@@ -23,6 +23,7 @@
 #include "webrtc/base/socketadapters.h"
 #include "webrtc/base/ssladapter.h"
 #include "webrtc/base/thread.h"
+#include "webrtc/system_wrappers/include/field_trial.h"
 
 namespace rtc {
 
@@ -61,7 +62,12 @@ AsyncPacketSocket* BasicPacketSocketFactory::CreateUdpSocket(
     delete socket;
     return NULL;
   }
-  return new AsyncUDPSocket(socket);
+  AsyncUDPSocket* udp_socket = new AsyncUDPSocket(socket);
+  if (webrtc::field_trial::FindFullName("WebRTC-UdpBatchedReceive") ==
+      "Enabled") {
+    udp_socket->SetReceiveBatchSize(AsyncUDPSocket::kMaxReceiveBatchSize);
+  }
+  return udp_socket;
 }
 
 AsyncPacketSocket* BasicPacketSocketFactory::CreateServerTcpSocket(
@@ -423,6 +423,28 @@ int DtlsTransportChannelWrapper::SendPacket(
   }
 }
 
+int DtlsTransportChannelWrapper::SendPackets(
+    const rtc::CopyOnWriteBuffer* packets,
+    const rtc::PacketOptions* options,
+    size_t count,
+    int flags) {
+  if (!dtls_active_) {
+    // Not doing DTLS.
+    return channel_->SendPackets(packets, options, count, 0);
+  }
+  if (dtls_state() != DTLS_TRANSPORT_CONNECTED || !(flags & PF_SRTP_BYPASS))
+    return TransportChannelImpl::SendPackets(packets, options, count, flags);
+
+  RTC_DCHECK(!srtp_ciphers_.empty());
+  for (size_t i = 0; i < count; ++i) {
+    if (!IsRtpPacket(packets[i].data<char>(), packets[i].size())) {
+      // Sent one by one, up to the packet SendPacket rejects.
+      return TransportChannelImpl::SendPackets(packets, options, count, flags);
+    }
+  }
+  return channel_->SendPackets(packets, options, count, 0);
+}
+
 bool DtlsTransportChannelWrapper::IsDtlsConnected() {
   return dtls_ && dtls_->IsTlsConnected();
 }
@@ -111,6 +111,11 @@ class DtlsTransportChannelWrapper : public TransportChannelImpl {
                  size_t size,
                  const rtc::PacketOptions& options,
                  int flags) override;
+  // SRTP packets bypassing DTLS are handed to the ICE transport as one batch.
+  int SendPackets(const rtc::CopyOnWriteBuffer* packets,
+                  const rtc::PacketOptions* options,
+                  size_t count,
+                  int flags) override;
 
   // TransportChannel calls that we forward to the wrapped transport.
   int SetOption(rtc::Socket::Option opt, int value) override {
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <set>
 
 #include "webrtc/api/umametrics.h"
@@ -162,6 +163,8 @@ void P2PTransportChannel::AddAllocatorSession(
 void P2PTransportChannel::AddConnection(Connection* connection) {
   connections_.push_back(connection);
   unpinged_connections_.insert(connection);
+  connections_to_rank_.insert(connection);
+  connections_to_reschedule_.insert(connection);
   connection->set_remote_ice_mode(remote_ice_mode_);
   connection->set_receiving_timeout(config_.receiving_timeout);
   connection->SignalReadPacket.connect(
@@ -251,6 +254,8 @@ void P2PTransportChannel::SetIceRole(IceRole ice_role) {
   RTC_DCHECK(network_thread_ == rtc::Thread::Current());
   if (ice_role_ != ice_role) {
     ice_role_ = ice_role;
+    // The role changes how connections are compared, and their priorities.
+    rank_all_connections_ = true;
     for (PortInterface* port : ports_) {
       port->SetIceRole(ice_role);
     }
@@ -347,6 +352,8 @@ void P2PTransportChannel::SetRemoteIceParameters(
   }
   // Updating the remote ICE candidate generation could change the sort order.
   RequestSortAndStateUpdate();
+  // Connections may have become pingable.
+  reschedule_all_checks_ = true;
 }
 
 void P2PTransportChannel::SetRemoteIceMode(IceMode mode) {
@@ -431,6 +438,10 @@ void P2PTransportChannel::SetIceConfig(const IceConfig& config) {
     LOG(LS_INFO) << "Set default nomination mode to "
                  << static_cast<int>(config_.default_nomination_mode);
   }
+
+  // The intervals and timeouts may have changed.
+  reschedule_all_checks_ = true;
+  RescheduleChecks();
 }
 
 const IceConfig& P2PTransportChannel::config() const {
@@ -718,6 +729,9 @@ void P2PTransportChannel::OnNominated(Connection* conn) {
   RTC_DCHECK(network_thread_ == rtc::Thread::Current());
   RTC_DCHECK(ice_role_ == ICEROLE_CONTROLLED);
 
+  // The controlled side ranks connections by their nomination.
+  connections_to_rank_.insert(conn);
+
   if (selected_connection_ == conn) {
     return;
   }
@@ -1006,6 +1020,29 @@ int P2PTransportChannel::SendPacket(const char *data, size_t len,
   return sent;
 }
 
+int P2PTransportChannel::SendPackets(const rtc::CopyOnWriteBuffer* packets,
+                                     const rtc::PacketOptions* options,
+                                     size_t count,
+                                     int flags) {
+  RTC_DCHECK(network_thread_ == rtc::Thread::Current());
+  if (flags != 0) {
+    error_ = EINVAL;
+    return -1;
+  }
+  if (!ReadyToSend(selected_connection_)) {
+    error_ = ENOTCONN;
+    return -1;
+  }
+  if (count == 0)
+    return 0;
+
+  last_sent_packet_id_ = options[count - 1].packet_id;
+  int sent = selected_connection_->SendBatch(packets, options, count);
+  if (sent < static_cast<int>(count))
+    error_ = selected_connection_->GetError();
+  return sent;
+}
+
 bool P2PTransportChannel::GetStats(ConnectionInfos *infos) {
   RTC_DCHECK(network_thread_ == rtc::Thread::Current());
   // Gather connection infos.
@@ -1059,7 +1096,7 @@ void P2PTransportChannel::MaybeStartPinging() {
           [this, now](const Connection* c) { return IsPingable(c, now); })) {
     LOG_J(LS_INFO, this) << "Have a pingable connection for the first time; "
                          << "starting to ping.";
-    thread()->Post(RTC_FROM_HERE, this, MSG_CHECK_AND_PING);
+    reschedule_all_checks_ = true;
     thread()->PostDelayed(RTC_FROM_HERE,
                           *config_.regather_on_failed_networks_interval, this,
                           MSG_REGATHER_ON_FAILED_NETWORKS);
@@ -1219,6 +1256,87 @@ bool P2PTransportChannel::PresumedWritable(const Connection* conn) const {
            conn->remote_candidate().type() == PRFLX_PORT_TYPE));
 }
 
+bool P2PTransportChannel::RanksBefore(const Connection* a,
+                                      const Connection* b) const {
+  int cmp = CompareConnections(a, b, rtc::Optional<int64_t>(), nullptr);
+  if (cmp != 0) {
+    return cmp > 0;
+  }
+  // Otherwise, sort based on latency estimate.
+  return a->rtt() < b->rtt();
+}
+
+// Puts |connections_| in the order std::stable_sort() would, without
+// comparing each connection with log(n) others every time. Only the
+// connections in |connections_to_rank_| are expected to move far; they are
+// taken out, and put back in by binary search. The others still get one
+// insertion sort pass, which costs a comparison per connection when they are
+// in order, because some of what they are compared by, e.g. the RTT and the
+// last time data was received, changes without a state change signal.
+void P2PTransportChannel::SortConnections() {
+  if (rank_all_connections_) {
+    std::stable_sort(connections_.begin(), connections_.end(),
+                     [this](const Connection* a, const Connection* b) {
+                       return RanksBefore(a, b);
+                     });
+    rank_all_connections_ = false;
+    connections_to_rank_.clear();
+    return;
+  }
+
+  // Connections that rank the same keep their relative order, which |index|
+  // records.
+  struct RankedConnection {
+    Connection* connection;
+    size_t index;
+  };
+  std::vector<RankedConnection> ranked;
+  std::vector<RankedConnection> to_rank;
+  ranked.reserve(connections_.size());
+  for (size_t i = 0; i < connections_.size(); ++i) {
+    RankedConnection ranked_connection = {connections_[i], i};
+    if (connections_to_rank_.find(connections_[i]) !=
+        connections_to_rank_.end()) {
+      to_rank.push_back(ranked_connection);
+    } else {
+      ranked.push_back(ranked_connection);
+    }
+  }
+  connections_to_rank_.clear();
+
+  // Stable, since a connection only moves past those it ranks before.
+  for (size_t i = 1; i < ranked.size(); ++i) {
+    RankedConnection ranked_connection = ranked[i];
+    size_t j = i;
+    for (; j > 0 && RanksBefore(ranked_connection.connection,
+                                ranked[j - 1].connection);
+         --j) {
+      ranked[j] = ranked[j - 1];
+    }
+    ranked[j] = ranked_connection;
+  }
+
+  auto ranks_before = [this](const RankedConnection& a,
+                             const RankedConnection& b) {
+    if (RanksBefore(a.connection, b.connection)) {
+      return true;
+    }
+    if (RanksBefore(b.connection, a.connection)) {
+      return false;
+    }
+    return a.index < b.index;
+  };
+  for (const RankedConnection& ranked_connection : to_rank) {
+    ranked.insert(std::upper_bound(ranked.begin(), ranked.end(),
+                                   ranked_connection, ranks_before),
+                  ranked_connection);
+  }
+
+  for (size_t i = 0; i < ranked.size(); ++i) {
+    connections_[i] = ranked[i].connection;
+  }
+}
+
 // Sort the available connections to find the best one.  We also monitor
 // the number of available connections and the current state.
 void P2PTransportChannel::SortConnectionsAndUpdateState() {
@@ -1235,17 +1353,7 @@ void P2PTransportChannel::SortConnectionsAndUpdateState() {
   // that amongst equal preference, writable connections, this will choose the
   // one whose estimated latency is lowest.  So it is the only one that we
   // need to consider switching to.
-  // TODO(honghaiz): Don't sort;  Just use std::max_element in the right places.
-  std::stable_sort(connections_.begin(), connections_.end(),
-                   [this](const Connection* a, const Connection* b) {
-                     int cmp = CompareConnections(
-                         a, b, rtc::Optional<int64_t>(), nullptr);
-                     if (cmp != 0) {
-                       return cmp > 0;
-                     }
-                     // Otherwise, sort based on latency estimate.
-                     return a->rtt() < b->rtt();
-                   });
+  SortConnections();
 
   LOG(LS_VERBOSE) << "Sorting " << connections_.size()
                   << " available connections:";
@@ -1296,6 +1404,8 @@ void P2PTransportChannel::SortConnectionsAndUpdateState() {
   // * ICE credentials were provided.
   // * A TCP connection became connected.
   MaybeStartPinging();
+
+  RescheduleChecks();
 }
 
 std::map<rtc::Network*, Connection*>
@@ -1383,6 +1493,9 @@ void P2PTransportChannel::SwitchSelectedConnection(Connection* conn) {
   SignalSelectedCandidatePairChanged(this, selected_connection_,
                                      last_sent_packet_id_,
                                      ReadyToSend(selected_connection_));
+  // Which connections are pinged, and how often, depends on the selected one.
+  reschedule_all_checks_ = true;
+  RescheduleChecks();
 }
 
 // Warning: UpdateState should eventually be called whenever a connection
@@ -1431,6 +1544,8 @@ void P2PTransportChannel::UpdateState() {
     }
     state_ = state;
     SignalStateChanged(this);
+    // Backup connections are pinged only once the channel is completed.
+    reschedule_all_checks_ = true;
   }
 
   // If our selected connection is "presumed writable" (TURN-TURN with no
@@ -1497,9 +1612,17 @@ void P2PTransportChannel::OnMessage(rtc::Message *pmsg) {
     case MSG_SORT_AND_UPDATE_STATE:
       SortConnectionsAndUpdateState();
       break;
-    case MSG_CHECK_AND_PING:
-      OnCheckAndPing();
+    case MSG_CHECK_AND_PING: {
+      rtc::TypedMessageData<int64_t>* data =
+          static_cast<rtc::TypedMessageData<int64_t>*>(pmsg->pdata);
+      bool superseded = data->data() != check_and_ping_time_;
+      delete data;
+      if (!superseded) {
+        check_and_ping_time_ = -1;
+        OnCheckAndPing();
+      }
       break;
+    }
     case MSG_REGATHER_ON_FAILED_NETWORKS:
       OnRegatherOnFailedNetworks();
       break;
@@ -1511,29 +1634,37 @@ void P2PTransportChannel::OnMessage(rtc::Message *pmsg) {
 
 // Handle queued up check-and-ping request
 void P2PTransportChannel::OnCheckAndPing() {
-  // Make sure the states of the connections are up-to-date (since this affects
-  // which ones are pingable).
-  UpdateConnectionStates();
-  // When the selected connection is not receiving or not writable, or any
-  // active connection has not been pinged enough times, use the weak ping
-  // interval.
-  bool need_more_pings_at_weak_interval = std::any_of(
-      connections_.begin(), connections_.end(), [](Connection* conn) {
-        return conn->active() &&
-               conn->num_pings_sent() < MIN_PINGS_AT_WEAK_PING_INTERVAL;
-      });
-  int ping_interval = (weak() || need_more_pings_at_weak_interval)
-                          ? weak_ping_interval_
-                          : STRONG_PING_INTERVAL;
-  if (rtc::TimeMillis() >= last_ping_sent_ms_ + ping_interval) {
+  int64_t now = rtc::TimeMillis();
+  // Make sure the states of the connections that are due are up-to-date (since
+  // this affects which ones are pingable). The states of the others cannot
+  // have timed out yet.
+  std::vector<Connection*> due_connections;
+  while (!scheduled_checks_.empty() && scheduled_checks_.top().first <= now) {
+    ScheduledCheck check = scheduled_checks_.top();
+    scheduled_checks_.pop();
+    auto it = check_times_.find(check.second);
+    if (it == check_times_.end() || it->second != check.first) {
+      continue;
+    }
+    check_times_.erase(it);
+    due_connections.push_back(check.second);
+    check.second->UpdateState(now);
+  }
+
+  int ping_interval = CalculatePingInterval();
+  if (!due_connections.empty() && now >= last_ping_sent_ms_ + ping_interval) {
     Connection* conn = FindNextPingableConnection();
     if (conn) {
       PingConnection(conn);
       MarkConnectionPinged(conn);
+      ping_interval = CalculatePingInterval();
+      ScheduleCheck(conn, now, ping_interval);
     }
   }
-  int delay = std::min(ping_interval, check_receiving_interval_);
-  thread()->PostDelayed(RTC_FROM_HERE, delay, this, MSG_CHECK_AND_PING);
+  for (Connection* conn : due_connections) {
+    ScheduleCheck(conn, now, ping_interval);
+  }
+  PostCheckAndPing(now + 1);
 }
 
 // A connection is considered a backup connection if the channel state
@@ -1620,6 +1751,125 @@ int P2PTransportChannel::CalculateActiveWritablePingInterval(
                                         : weak_or_stablizing_interval;
 }
 
+int P2PTransportChannel::CalculatePingInterval() const {
+  // When the selected connection is not receiving or not writable, or any
+  // active connection has not been pinged enough times, use the weak ping
+  // interval.
+  bool need_more_pings_at_weak_interval = std::any_of(
+      connections_.begin(), connections_.end(), [](Connection* conn) {
+        return conn->active() &&
+               conn->num_pings_sent() < MIN_PINGS_AT_WEAK_PING_INTERVAL;
+      });
+  return (weak() || need_more_pings_at_weak_interval) ? weak_ping_interval_
+                                                      : STRONG_PING_INTERVAL;
+}
+
+// Mirrors IsPingable().
+int64_t P2PTransportChannel::NextPingableTime(const Connection* conn,
+                                              int64_t now) const {
+  const int64_t kNever = std::numeric_limits<int64_t>::max();
+  const Candidate& remote = conn->remote_candidate();
+  if (remote.username().empty() || remote.password().empty()) {
+    return kNever;
+  }
+  if (conn->state() == IceCandidatePairState::FAILED) {
+    return kNever;
+  }
+  if (!conn->connected() && !conn->writable()) {
+    return kNever;
+  }
+  if (weak()) {
+    return now;
+  }
+  if (IsBackupConnection(conn)) {
+    if (conn->rtt_samples() == 0) {
+      return now;
+    }
+    return conn->last_ping_response_received() +
+           config_.backup_connection_ping_interval;
+  }
+  if (!conn->active()) {
+    return kNever;
+  }
+  if (!conn->writable()) {
+    return now;
+  }
+  return conn->last_ping_sent() +
+         CalculateActiveWritablePingInterval(conn, now);
+}
+
+void P2PTransportChannel::ScheduleCheck(Connection* conn,
+                                        int64_t now,
+                                        int ping_interval) {
+  // A connection that is due to be pinged waits for the channel to be allowed
+  // to send the next ping.
+  int64_t ping_time = NextPingableTime(conn, now);
+  if (ping_time != std::numeric_limits<int64_t>::max()) {
+    ping_time = std::max(ping_time, last_ping_sent_ms_ + ping_interval);
+  }
+  // State timeouts are checked at multiples of |check_receiving_interval_|,
+  // so that the connections that time out close together do so in one go.
+  int64_t state_time = conn->NextStateChangeTime(now);
+  if (state_time != std::numeric_limits<int64_t>::max()) {
+    state_time = (state_time + check_receiving_interval_ - 1) /
+                 check_receiving_interval_ * check_receiving_interval_;
+  }
+
+  int64_t time = std::min(ping_time, state_time);
+  if (time == std::numeric_limits<int64_t>::max()) {
+    check_times_.erase(conn);
+    return;
+  }
+  check_times_[conn] = time;
+  scheduled_checks_.push(ScheduledCheck(time, conn));
+}
+
+void P2PTransportChannel::RescheduleChecks() {
+  if (!started_pinging_) {
+    return;
+  }
+  int64_t now = rtc::TimeMillis();
+  int ping_interval = CalculatePingInterval();
+  if (reschedule_all_checks_ || ping_interval != scheduled_ping_interval_) {
+    scheduled_checks_ = ScheduledCheckQueue();
+    check_times_.clear();
+    for (Connection* conn : connections_) {
+      ScheduleCheck(conn, now, ping_interval);
+    }
+  } else {
+    for (Connection* conn : connections_to_reschedule_) {
+      ScheduleCheck(conn, now, ping_interval);
+    }
+  }
+  reschedule_all_checks_ = false;
+  scheduled_ping_interval_ = ping_interval;
+  connections_to_reschedule_.clear();
+  PostCheckAndPing(now);
+}
+
+void P2PTransportChannel::PostCheckAndPing(int64_t earliest_time) {
+  while (!scheduled_checks_.empty()) {
+    const ScheduledCheck& check = scheduled_checks_.top();
+    auto it = check_times_.find(check.second);
+    if (it != check_times_.end() && it->second == check.first) {
+      break;
+    }
+    scheduled_checks_.pop();
+  }
+  if (scheduled_checks_.empty()) {
+    return;
+  }
+  int64_t time = std::max(scheduled_checks_.top().first, earliest_time);
+  if (check_and_ping_time_ != -1 && check_and_ping_time_ <= time) {
+    return;
+  }
+  // Supersedes the pending message, if any.
+  check_and_ping_time_ = time;
+  int delay = static_cast<int>(std::max<int64_t>(time - rtc::TimeMillis(), 0));
+  thread()->PostDelayed(RTC_FROM_HERE, delay, this, MSG_CHECK_AND_PING,
+                        new rtc::TypedMessageData<int64_t>(time));
+}
+
 // Returns the next pingable connection to ping.
 Connection* P2PTransportChannel::FindNextPingableConnection() {
   int64_t now = rtc::TimeMillis();
@@ -1788,6 +2038,13 @@ void P2PTransportChannel::OnConnectionStateChange(Connection* connection) {
     MaybeStopPortAllocatorSessions();
   }
 
+  connections_to_rank_.insert(connection);
+  connections_to_reschedule_.insert(connection);
+  // The channel is weak unless its selected connection is strong.
+  if (connection == selected_connection_) {
+    reschedule_all_checks_ = true;
+  }
+
   // We have to unroll the stack before doing this because we may be changing
   // the state of connections while sorting.
   RequestSortAndStateUpdate();
@@ -1807,6 +2064,9 @@ void P2PTransportChannel::OnConnectionDestroyed(Connection* connection) {
   RTC_DCHECK(iter != connections_.end());
   pinged_connections_.erase(*iter);
   unpinged_connections_.erase(*iter);
+  connections_to_rank_.erase(*iter);
+  connections_to_reschedule_.erase(*iter);
+  check_times_.erase(*iter);
   connections_.erase(iter);
 
   LOG_J(LS_INFO, this) << "Removed connection " << std::hex << connection
@@ -1828,6 +2088,7 @@ void P2PTransportChannel::OnConnectionDestroyed(Connection* connection) {
     // we do need to update state, because we could be switching to "failed" or
     // "completed".
     UpdateState();
+    RescheduleChecks();
   }
 }
 
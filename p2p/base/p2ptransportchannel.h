@@ -20,10 +20,13 @@
 #ifndef WEBRTC_P2P_BASE_P2PTRANSPORTCHANNEL_H_
 #define WEBRTC_P2P_BASE_P2PTRANSPORTCHANNEL_H_
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <queue>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "webrtc/base/asyncpacketsocket.h"
@@ -103,6 +106,10 @@ class P2PTransportChannel : public IceTransportInternal,
                  size_t len,
                  const rtc::PacketOptions& options,
                  int flags) override;
+  int SendPackets(const rtc::CopyOnWriteBuffer* packets,
+                  const rtc::PacketOptions* options,
+                  size_t count,
+                  int flags) override;
   int SetOption(rtc::Socket::Option opt, int value) override;
   bool GetOption(rtc::Socket::Option opt, int* value) override;
   int GetError() override { return error_; }
@@ -196,6 +203,9 @@ class P2PTransportChannel : public IceTransportInternal,
 
   bool PresumedWritable(const cricket::Connection* conn) const;
 
+  // Returns true if |a| goes before |b| in |connections_|.
+  bool RanksBefore(const Connection* a, const Connection* b) const;
+  void SortConnections();
   void SortConnectionsAndUpdateState();
   void SwitchSelectedConnection(Connection* conn);
   void UpdateState();
@@ -222,6 +232,21 @@ class P2PTransportChannel : public IceTransportInternal,
                                           int64_t now) const;
   int CalculateActiveWritablePingInterval(const Connection* conn,
                                           int64_t now) const;
+  // Returns the minimum interval between two pings sent by the channel.
+  int CalculatePingInterval() const;
+  // Returns the earliest time at which IsPingable() returns true for |conn|,
+  // unless the state of the channel or the connection changes first.
+  int64_t NextPingableTime(const Connection* conn, int64_t now) const;
+  // Schedules the next check of |conn|, for when it is due to be pinged or
+  // its state may time out.
+  void ScheduleCheck(Connection* conn, int64_t now, int ping_interval);
+  // Schedules the checks of the connections that may have moved since they
+  // were scheduled, or of all of them after a change to the channel, and
+  // wakes up for the earliest.
+  void RescheduleChecks();
+  // Makes sure MSG_CHECK_AND_PING is posted for the earliest scheduled check,
+  // but not before |earliest_time|.
+  void PostCheckAndPing(int64_t earliest_time);
   void PingConnection(Connection* conn);
   void AddAllocatorSession(std::unique_ptr<PortAllocatorSession> session);
   void AddConnection(Connection* connection);
@@ -338,6 +363,33 @@ class P2PTransportChannel : public IceTransportInternal,
   std::vector<Connection *> connections_;
   std::set<Connection*> pinged_connections_;
   std::set<Connection*> unpinged_connections_;
+  // Connections that may have changed rank since |connections_| was last
+  // sorted, because they are new or have signaled a state change.
+  std::set<Connection*> connections_to_rank_;
+  // Set when what all the connections are compared by changes, i.e. the ICE
+  // role.
+  bool rank_all_connections_ = false;
+
+  // A min-heap of the times at which connections next need to be pinged or
+  // have their state checked, so that the channel only wakes up when one
+  // does. An entry is stale, and skipped, unless its time is the one in
+  // |check_times_| for the connection.
+  typedef std::pair<int64_t, Connection*> ScheduledCheck;
+  typedef std::priority_queue<ScheduledCheck,
+                              std::vector<ScheduledCheck>,
+                              std::greater<ScheduledCheck>>
+      ScheduledCheckQueue;
+  ScheduledCheckQueue scheduled_checks_;
+  std::map<Connection*, int64_t> check_times_;
+  // Connections that have signaled a state change since they were scheduled.
+  std::set<Connection*> connections_to_reschedule_;
+  // Set when what all the checks are scheduled by changes: the selected
+  // connection or its state, the channel state or the configuration.
+  bool reschedule_all_checks_ = false;
+  int scheduled_ping_interval_ = 0;
+  // When the pending MSG_CHECK_AND_PING is for, or -1 if none is. Messages
+  // for other times have been superseded and are ignored.
+  int64_t check_and_ping_time_ = -1;
 
   Connection* selected_connection_ = nullptr;
 
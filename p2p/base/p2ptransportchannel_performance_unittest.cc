@@ -0,0 +1,220 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "webrtc/base/fakeclock.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/logging.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/random.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/base/virtualsocketserver.h"
+#include "webrtc/p2p/base/fakeportallocator.h"
+#include "webrtc/p2p/base/p2ptransportchannel.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+const int kNumRounds = 4;
+const int kTimeoutMs = 10000;
+const int kStepMs = 100;
+const int kRttMs = 100;
+const int kRemotePingIntervalMs = 1000;
+const int kSettleMs = 20000;
+const int kIdleSeconds = 60;
+const int kNumIdlePairs = 8;
+const IceParameters kLocalIceParams("UFRAG0",
+                                    "TESTICEPWD00000000000000",
+                                    false);
+const IceParameters kRemoteIceParams("UFRAG1",
+                                     "TESTICEPWD00000000000001",
+                                     false);
+
+Candidate CreateRemoteCandidate(int index, uint32_t priority) {
+  Candidate c;
+  c.set_address(rtc::SocketAddress(
+      "10.0." + rtc::ToString(index / 250) + "." +
+          rtc::ToString(1 + index % 250),
+      1000 + index));
+  c.set_component(ICE_CANDIDATE_COMPONENT_DEFAULT);
+  c.set_protocol(UDP_PROTOCOL_NAME);
+  c.set_priority(priority);
+  c.set_type(LOCAL_PORT_TYPE);
+  return c;
+}
+
+// Creates a channel with |num_pairs| candidate pairs, none of them writable
+// yet, and delivers a ping response to each of them in a random order, as
+// happens while ICE checks connectivity. Every response makes a connection
+// writable, and has the channel rank its connections again. Reports the time
+// the channel spends on each response.
+void RunPingResponseTest(int num_pairs) {
+  std::unique_ptr<rtc::PhysicalSocketServer> pss(
+      new rtc::PhysicalSocketServer());
+  std::unique_ptr<rtc::VirtualSocketServer> vss(
+      new rtc::VirtualSocketServer(pss.get()));
+  rtc::SocketServerScope ss_scope(vss.get());
+  // Keeps the pings and timeouts of the channel from interfering.
+  rtc::ScopedFakeClock clock;
+  webrtc::Random random(num_pairs);
+  // Every connection logs as it is created and becomes writable.
+  rtc::LoggingSeverity log_severity = rtc::LogMessage::GetLogToDebug();
+  rtc::LogMessage::LogToDebug(rtc::LS_ERROR);
+
+  int64_t total_ns = 0;
+  for (int round = 0; round < kNumRounds; ++round) {
+    FakePortAllocator allocator(rtc::Thread::Current(), nullptr);
+    P2PTransportChannel channel("perf", 1, &allocator);
+    // The controlled side does not prune before it is nominated a connection,
+    // so all of them stay in the ranking.
+    channel.SetIceRole(ICEROLE_CONTROLLED);
+    channel.SetIceParameters(kLocalIceParams);
+    channel.SetRemoteIceParameters(kRemoteIceParams);
+    channel.MaybeStartGathering();
+    for (int i = 0; i < num_pairs; ++i) {
+      channel.AddRemoteCandidate(
+          CreateRemoteCandidate(i, random.Rand(1u, 1000000u)));
+    }
+    EXPECT_EQ_SIMULATED_WAIT(static_cast<size_t>(num_pairs),
+                             channel.connections().size(), kTimeoutMs, clock);
+    ASSERT_EQ(static_cast<size_t>(num_pairs), channel.connections().size());
+
+    std::vector<Connection*> connections = channel.connections();
+    for (size_t i = connections.size() - 1; i > 0; --i) {
+      std::swap(connections[i],
+                connections[random.Rand(static_cast<uint32_t>(i))]);
+    }
+    for (Connection* connection : connections) {
+      connection->ReceivedPingResponse(random.Rand(10, 200), "id");
+      int64_t start_ns = rtc::SystemTimeNanos();
+      rtc::Thread::Current()->ProcessMessages(0);
+      total_ns += rtc::SystemTimeNanos() - start_ns;
+    }
+    EXPECT_TRUE(channel.writable());
+  }
+  rtc::LogMessage::LogToDebug(log_severity);
+
+  webrtc::test::PrintResult(
+      "ping_response_cpu", "", rtc::ToString(num_pairs) + "_pairs",
+      static_cast<size_t>(total_ns / (kNumRounds * num_pairs)), "ns", true);
+}
+
+// Creates |num_channels| channels with a few candidate pairs each, and lets
+// them idle, as many calls do once they are set up: the remote side pings every
+// connection every second, and answers every ping. Reports the time a channel
+// spends per second.
+void RunIdleTest(int num_channels) {
+  std::unique_ptr<rtc::PhysicalSocketServer> pss(
+      new rtc::PhysicalSocketServer());
+  std::unique_ptr<rtc::VirtualSocketServer> vss(
+      new rtc::VirtualSocketServer(pss.get()));
+  rtc::SocketServerScope ss_scope(vss.get());
+  rtc::ScopedFakeClock clock;
+  rtc::LoggingSeverity log_severity = rtc::LogMessage::GetLogToDebug();
+  rtc::LogMessage::LogToDebug(rtc::LS_ERROR);
+
+  std::vector<std::unique_ptr<FakePortAllocator>> allocators;
+  std::vector<std::unique_ptr<P2PTransportChannel>> channels;
+  for (int i = 0; i < num_channels; ++i) {
+    allocators.emplace_back(
+        new FakePortAllocator(rtc::Thread::Current(), nullptr));
+    channels.emplace_back(
+        new P2PTransportChannel("idle", 1, allocators.back().get()));
+    P2PTransportChannel* channel = channels.back().get();
+    channel->SetIceRole(ICEROLE_CONTROLLING);
+    channel->SetIceParameters(kLocalIceParams);
+    channel->SetRemoteIceParameters(kRemoteIceParams);
+    channel->MaybeStartGathering();
+    for (int j = 0; j < kNumIdlePairs; ++j) {
+      channel->AddRemoteCandidate(
+          CreateRemoteCandidate(i * kNumIdlePairs + j, 1 + j));
+    }
+  }
+  EXPECT_TRUE_SIMULATED_WAIT(
+      std::all_of(channels.begin(), channels.end(),
+                  [](const std::unique_ptr<P2PTransportChannel>& channel) {
+                    return channel->connections().size() == kNumIdlePairs;
+                  }),
+      kTimeoutMs, clock);
+  std::vector<Connection*> connections;
+  for (const auto& channel : channels) {
+    ASSERT_EQ(static_cast<size_t>(kNumIdlePairs),
+              channel->connections().size());
+    connections.insert(connections.end(), channel->connections().begin(),
+                       channel->connections().end());
+  }
+
+  int64_t total_ns = 0;
+  int64_t last_remote_ping_ms = 0;
+  for (int elapsed_ms = 0; elapsed_ms < kSettleMs + kIdleSeconds * 1000;
+       elapsed_ms += kStepMs) {
+    int64_t start_ns = rtc::SystemTimeNanos();
+    clock.AdvanceTime(rtc::TimeDelta::FromMilliseconds(kStepMs));
+    if (elapsed_ms >= kSettleMs) {
+      total_ns += rtc::SystemTimeNanos() - start_ns;
+    }
+
+    int64_t now = rtc::TimeMillis();
+    bool remote_ping = now >= last_remote_ping_ms + kRemotePingIntervalMs;
+    if (remote_ping) {
+      last_remote_ping_ms = now;
+    }
+    for (Connection* connection : connections) {
+      if (remote_ping) {
+        connection->ReceivedPing();
+      }
+      if (connection->last_ping_sent() >
+          connection->last_ping_response_received()) {
+        connection->ReceivedPingResponse(kRttMs, "id");
+      }
+    }
+  }
+  for (const auto& channel : channels) {
+    EXPECT_TRUE(channel->writable());
+  }
+  rtc::LogMessage::LogToDebug(log_severity);
+
+  webrtc::test::PrintResult(
+      "idle_cpu_per_second", "", rtc::ToString(num_channels) + "_channels",
+      static_cast<size_t>(total_ns / (kIdleSeconds * num_channels)), "ns",
+      true);
+}
+
+}  // namespace
+
+TEST(P2PTransportChannelPerformanceTest, PingResponses50Pairs) {
+  RunPingResponseTest(50);
+}
+
+TEST(P2PTransportChannelPerformanceTest, PingResponses200Pairs) {
+  RunPingResponseTest(200);
+}
+
+TEST(P2PTransportChannelPerformanceTest, PingResponses500Pairs) {
+  RunPingResponseTest(500);
+}
+
+TEST(P2PTransportChannelPerformanceTest, Idle100Channels) {
+  RunIdleTest(100);
+}
+
+TEST(P2PTransportChannelPerformanceTest, Idle400Channels) {
+  RunIdleTest(400);
+}
+
+}  // namespace cricket
@@ -3266,6 +3266,46 @@ TEST_F(P2PTransportChannelPingTest, PingingStartedAsSoonAsPossible) {
   EXPECT_TRUE_SIMULATED_WAIT(conn->num_pings_sent() > 0, 1, clock);
 }
 
+// Test that a strong and stable connection is pinged exactly when its next
+// ping is due, and not in between.
+TEST_F(P2PTransportChannelPingTest, TestStableConnectionPingedWhenDue) {
+  rtc::ScopedFakeClock clock;
+  const int kNumPingsToStabilize = 6;
+
+  FakePortAllocator pa(rtc::Thread::Current(), nullptr);
+  P2PTransportChannel ch("TestChannel", 1, &pa);
+  PrepareChannel(&ch);
+  // Keeps the connection receiving from one answered ping to the next.
+  ch.SetIceConfig(CreateIceConfig(
+      2 * STRONG_AND_STABLE_WRITABLE_CONNECTION_PING_INTERVAL, GATHER_ONCE));
+  ch.MaybeStartGathering();
+  ch.AddRemoteCandidate(CreateUdpCandidate(LOCAL_PORT_TYPE, "1.1.1.1", 1, 1));
+  Connection* conn = WaitForConnectionTo(&ch, "1.1.1.1", 1, &clock);
+  ASSERT_TRUE(conn != nullptr);
+
+  // Answer the pings until the RTT has converged.
+  for (int i = 0; i < kNumPingsToStabilize; ++i) {
+    int num_pings_sent = conn->num_pings_sent();
+    EXPECT_TRUE_SIMULATED_WAIT(conn->num_pings_sent() > num_pings_sent,
+                               kMediumTimeout, clock);
+    conn->ReceivedPingResponse(LOW_RTT, "id");
+  }
+  EXPECT_EQ(conn, ch.selected_connection());
+  EXPECT_TRUE(conn->stable(rtc::TimeMillis()));
+
+  for (int i = 0; i < 3; ++i) {
+    int num_pings_sent = conn->num_pings_sent();
+    int64_t due_ms = conn->last_ping_sent() +
+                     STRONG_AND_STABLE_WRITABLE_CONNECTION_PING_INTERVAL;
+    clock.AdvanceTime(
+        rtc::TimeDelta::FromMilliseconds(due_ms - 1 - rtc::TimeMillis()));
+    EXPECT_EQ(num_pings_sent, conn->num_pings_sent());
+    clock.AdvanceTime(rtc::TimeDelta::FromMilliseconds(1));
+    EXPECT_EQ(num_pings_sent + 1, conn->num_pings_sent());
+    conn->ReceivedPingResponse(LOW_RTT, "id");
+  }
+}
+
 TEST_F(P2PTransportChannelPingTest, TestNoTriggeredChecksWhenWritable) {
   FakePortAllocator pa(rtc::Thread::Current(), nullptr);
   P2PTransportChannel ch("trigger checks", 1, &pa);
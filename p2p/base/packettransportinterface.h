@@ -14,6 +14,8 @@
 #include <string>
 #include <vector>
 
+#include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/base/copyonwritebuffer.h"
 #include "webrtc/base/sigslot.h"
 #include "webrtc/base/socket.h"
 
@@ -22,9 +24,6 @@ class TransportChannel;
 }
 
 namespace rtc {
-struct PacketOptions;
-struct PacketTime;
-struct SentPacket;
 
 class PacketTransportInterface : public sigslot::has_slots<> {
  public:
@@ -53,6 +52,23 @@ class PacketTransportInterface : public sigslot::has_slots<> {
                          const rtc::PacketOptions& options,
                          int flags = 0) = 0;
 
+  // Sends |count| packets in order, |options| has one entry per packet.
+  // Returns the number of packets sent, which stops at the first failure, or
+  // -1 if none could be sent. Transports that can hand a whole burst to the
+  // socket override this, the default sends them one by one.
+  virtual int SendPackets(const rtc::CopyOnWriteBuffer* packets,
+                          const rtc::PacketOptions* options,
+                          size_t count,
+                          int flags) {
+    for (size_t i = 0; i < count; ++i) {
+      int sent = SendPacket(packets[i].data<char>(), packets[i].size(),
+                            options[i], flags);
+      if (sent != static_cast<int>(packets[i].size()))
+        return i > 0 ? static_cast<int>(i) : -1;
+    }
+    return static_cast<int>(count);
+  }
+
   // Sets a socket option. Note that not all options are
   // supported by all transport types.
   virtual int SetOption(rtc::Socket::Option opt, int value) = 0;
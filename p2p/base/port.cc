@@ -11,6 +11,7 @@
 #include "webrtc/p2p/base/port.h"
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "webrtc/p2p/base/common.h"
@@ -552,6 +553,19 @@ void Port::CreateStunUsername(const std::string& remote_username,
   stun_username_attr_str->append(username_fragment());
 }
 
+int Port::SendToBatch(const rtc::DatagramToSend* datagrams,
+                      const rtc::PacketOptions* options,
+                      size_t count,
+                      bool payload) {
+  for (size_t i = 0; i < count; ++i) {
+    int sent = SendTo(datagrams[i].data, datagrams[i].length,
+                      datagrams[i].address, options[i], payload);
+    if (sent < 0)
+      return i > 0 ? static_cast<int>(i) : sent;
+  }
+  return static_cast<int>(count);
+}
+
 void Port::SendBindingResponse(StunMessage* request,
                                const rtc::SocketAddress& addr) {
   RTC_DCHECK(request->type() == STUN_BINDING_REQUEST);
@@ -882,6 +896,17 @@ Connection::Connection(Port* port,
 Connection::~Connection() {
 }
 
+int Connection::SendBatch(const rtc::CopyOnWriteBuffer* packets,
+                          const rtc::PacketOptions* options,
+                          size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    int sent = Send(packets[i].data(), packets[i].size(), options[i]);
+    if (sent < 0)
+      return i > 0 ? static_cast<int>(i) : sent;
+  }
+  return static_cast<int>(count);
+}
+
 const Candidate& Connection::local_candidate() const {
   RTC_DCHECK(local_candidate_index_ < port_->Candidates().size());
   return port_->Candidates()[local_candidate_index_];
@@ -1289,6 +1314,48 @@ bool Connection::stable(int64_t now) const {
   return rtt_converged() && !missing_responses(now);
 }
 
+int64_t Connection::NextStateChangeTime(int64_t now) const {
+  int64_t next_time = std::numeric_limits<int64_t>::max();
+  auto consider = [now, &next_time](int64_t time) {
+    if (time > now) {
+      next_time = std::min(next_time, time);
+    }
+  };
+
+  // The write state times out once the pings go unanswered for long enough,
+  // and the connection stops being stable once one is missing. See
+  // UpdateState() and missing_responses().
+  if (!pings_since_last_response_.empty()) {
+    int64_t first_sent_time = pings_since_last_response_[0].sent_time;
+    if (write_state_ == STATE_WRITABLE &&
+        pings_since_last_response_.size() >=
+            CONNECTION_WRITE_CONNECT_FAILURES) {
+      int64_t failed_time =
+          pings_since_last_response_[CONNECTION_WRITE_CONNECT_FAILURES - 1]
+              .sent_time +
+          ConservativeRTTEstimate(rtt_) + 1;
+      consider(std::max(
+          failed_time, first_sent_time + CONNECTION_WRITE_CONNECT_TIMEOUT + 1));
+    }
+    if (write_state_ == STATE_WRITE_UNRELIABLE ||
+        write_state_ == STATE_WRITE_INIT) {
+      consider(first_sent_time + CONNECTION_WRITE_TIMEOUT + 1);
+    }
+    consider(first_sent_time + 2 * rtt() + 1);
+  }
+
+  // The receiving state and dead() time out since the last thing received.
+  if (receiving_) {
+    consider(last_received() + receiving_timeout_ + 1);
+  }
+  if (last_received() > 0) {
+    consider(last_received() + DEAD_CONNECTION_RECEIVE_TIMEOUT + 1);
+  } else if (!active()) {
+    consider(time_created_ms_ + MIN_CONNECTION_LIFETIME + 1);
+  }
+  return next_time;
+}
+
 std::string Connection::ToDebugId() const {
   std::stringstream ss;
   ss << std::hex << this;
@@ -1589,4 +1656,25 @@ int ProxyConnection::Send(const void* data, size_t size,
   return sent;
 }
 
+int ProxyConnection::SendBatch(const rtc::CopyOnWriteBuffer* packets,
+                               const rtc::PacketOptions* options,
+                               size_t count) {
+  stats_.sent_total_packets += count;
+  datagrams_.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    datagrams_[i].data = packets[i].data();
+    datagrams_[i].length = packets[i].size();
+    datagrams_[i].address = remote_candidate_.address();
+  }
+  int sent = port_->SendToBatch(datagrams_.data(), options, count, true);
+  size_t num_sent = sent > 0 ? static_cast<size_t>(sent) : 0;
+  if (num_sent < count) {
+    error_ = port_->GetError();
+    stats_.sent_discarded_packets += count - num_sent;
+  }
+  for (size_t i = 0; i < num_sent; ++i)
+    send_rate_tracker_.AddSamples(packets[i].size());
+  return sent;
+}
+
 }  // namespace cricket
@@ -26,6 +26,7 @@
 #include "webrtc/p2p/base/stunrequest.h"
 #include "webrtc/base/asyncpacketsocket.h"
 #include "webrtc/base/checks.h"
+#include "webrtc/base/copyonwritebuffer.h"
 #include "webrtc/base/network.h"
 #include "webrtc/base/proxyinfo.h"
 #include "webrtc/base/ratetracker.h"
@@ -252,6 +253,14 @@ class Port : public PortInterface, public rtc::MessageHandler,
     return false;
   }
 
+  // Sends |count| packets in order, |options| has one entry per packet.
+  // Returns the number of packets sent, or a negative error if none could be.
+  // The default calls SendTo for each packet.
+  virtual int SendToBatch(const rtc::DatagramToSend* datagrams,
+                          const rtc::PacketOptions* options,
+                          size_t count,
+                          bool payload);
+
   // Sends a response message (normal or error) to the given request.  One of
   // these methods should be called as a response to SignalUnknownAddress.
   // NOTE: You MUST call CreateConnection BEFORE SendBindingResponse.
@@ -485,6 +494,11 @@ class Connection : public CandidatePairInterface,
   // covers.
   virtual int Send(const void* data, size_t size,
                    const rtc::PacketOptions& options) = 0;
+  // Sends |count| packets in order, |options| has one entry per packet.
+  // Returns the number of packets sent, or < 0 if none could be.
+  virtual int SendBatch(const rtc::CopyOnWriteBuffer* packets,
+                        const rtc::PacketOptions* options,
+                        size_t count);
 
   // Error if Send() returns < 0
   virtual int GetError() = 0;
@@ -609,6 +623,12 @@ class Connection : public CandidatePairInterface,
 
   bool stable(int64_t now) const;
 
+  // Returns the earliest time after |now| at which UpdateState() may change
+  // the state of this connection, or it may stop being stable, only because
+  // time has passed. Returns std::numeric_limits<int64_t>::max() if only
+  // sending or receiving something can change them.
+  int64_t NextStateChangeTime(int64_t now) const;
+
  protected:
   enum { MSG_DELETE = 0, MSG_FIRST_AVAILABLE };
 
@@ -709,10 +729,15 @@ class ProxyConnection : public Connection {
   int Send(const void* data,
            size_t size,
            const rtc::PacketOptions& options) override;
+  int SendBatch(const rtc::CopyOnWriteBuffer* packets,
+                const rtc::PacketOptions* options,
+                size_t count) override;
   int GetError() override { return error_; }
 
  private:
   int error_ = 0;
+  // Reused by SendBatch.
+  std::vector<rtc::DatagramToSend> datagrams_;
 };
 
 }  // namespace cricket
@@ -777,6 +777,14 @@ class PortTest : public testing::Test, public sigslot::has_slots<> {
   void OnDestroyed(PortInterface* port) { ++ports_destroyed_; }
   int ports_destroyed() const { return ports_destroyed_; }
 
+  void ConnectToSignalSentPacket(PortInterface* port) {
+    port->SignalSentPacket.connect(this, &PortTest::OnSentPacket);
+  }
+  void OnSentPacket(const rtc::SentPacket& sent_packet) {
+    sent_packet_ids_.push_back(sent_packet.packet_id);
+  }
+  const std::vector<int>& sent_packet_ids() const { return sent_packet_ids_; }
+
   rtc::BasicPacketSocketFactory* nat_socket_factory1() {
     return &nat_socket_factory1_;
   }
@@ -803,6 +811,7 @@ class PortTest : public testing::Test, public sigslot::has_slots<> {
   std::string password_;
   bool role_conflict_;
   int ports_destroyed_;
+  std::vector<int> sent_packet_ids_;
 };
 
 void PortTest::TestConnectivity(const char* name1, Port* port1,
@@ -2500,6 +2509,41 @@ TEST_F(PortTest, TestWritableState) {
   ch2.Stop();
 }
 
+TEST_F(PortTest, TestConnectionSendBatch) {
+  rtc::ScopedFakeClock clock;
+  UDPPort* port1 = CreateUdpPort(kLocalAddr1);
+  port1->SetIceRole(cricket::ICEROLE_CONTROLLING);
+  ConnectToSignalSentPacket(port1);
+  UDPPort* port2 = CreateUdpPort(kLocalAddr2);
+  port2->SetIceRole(cricket::ICEROLE_CONTROLLED);
+
+  TestChannel ch1(port1);
+  TestChannel ch2(port2);
+  ch1.Start();
+  ch2.Start();
+  ASSERT_EQ_SIMULATED_WAIT(1, ch1.complete_count(), kDefaultTimeout, clock);
+  ASSERT_EQ_SIMULATED_WAIT(1, ch2.complete_count(), kDefaultTimeout, clock);
+  ch1.CreateConnection(GetCandidate(port2));
+  ASSERT_TRUE(ch1.conn() != NULL);
+
+  // The whole burst goes through the socket in one call, in order.
+  const size_t kNumPackets = 3;
+  rtc::CopyOnWriteBuffer packets[kNumPackets];
+  rtc::PacketOptions options[kNumPackets];
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    packets[i].SetData("abcd", 4);
+    options[i].packet_id = static_cast<int>(i) + 1;
+  }
+  EXPECT_EQ(static_cast<int>(kNumPackets),
+            ch1.conn()->SendBatch(packets, options, kNumPackets));
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), sent_packet_ids());
+  EXPECT_EQ(kNumPackets, ch1.conn()->stats().sent_total_packets);
+  EXPECT_EQ(0u, ch1.conn()->stats().sent_discarded_packets);
+
+  ch1.Stop();
+  ch2.Stop();
+}
+
 TEST_F(PortTest, TestTimeoutForNeverWritable) {
   UDPPort* port1 = CreateUdpPort(kLocalAddr1);
   port1->SetIceRole(cricket::ICEROLE_CONTROLLING);
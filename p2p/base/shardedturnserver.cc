@@ -0,0 +1,122 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/p2p/base/shardedturnserver.h"
+
+#include <utility>
+
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/base/logging.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/p2p/base/basicpacketsocketfactory.h"
+
+namespace cricket {
+
+struct ShardedTurnServer::Shard {
+  std::unique_ptr<rtc::Thread> thread;
+  // Created, used and destroyed on |thread|.
+  std::unique_ptr<TurnServer> server;
+};
+
+ShardedTurnServer::ShardedTurnServer(size_t num_shards)
+    : num_shards_(num_shards) {
+  RTC_DCHECK_GT(num_shards, 0u);
+}
+
+ShardedTurnServer::~ShardedTurnServer() {
+  Stop();
+}
+
+bool ShardedTurnServer::Start(const rtc::SocketAddress& int_addr,
+                              const rtc::IPAddress& ext_ip) {
+  RTC_DCHECK(shards_.empty());
+  address_ = int_addr;
+  for (size_t i = 0; i < num_shards_; ++i) {
+    std::unique_ptr<Shard> shard(new Shard());
+    // Every allocation has a socket of its own, more than select() can
+    // wait on.
+    shard->thread.reset(new rtc::Thread(
+        std::unique_ptr<rtc::SocketServer>(new rtc::PhysicalSocketServer(
+            rtc::PhysicalSocketServer::Backend::kEpoll))));
+    shard->thread->SetName("TurnServerShard", shard.get());
+    shard->thread->Start();
+    shards_.push_back(std::move(shard));
+    if (!StartShard(shards_.back().get(), ext_ip)) {
+      Stop();
+      return false;
+    }
+  }
+  LOG(LS_INFO) << "Started " << num_shards_ << " TURN server shards at "
+               << address_.ToString();
+  return true;
+}
+
+bool ShardedTurnServer::StartShard(Shard* shard,
+                                   const rtc::IPAddress& ext_ip) {
+  return shard->thread->Invoke<bool>(RTC_FROM_HERE, [this, shard, &ext_ip] {
+    rtc::Thread* thread = rtc::Thread::Current();
+    std::unique_ptr<rtc::AsyncSocket> socket(
+        thread->socketserver()->CreateAsyncSocket(address_.family(),
+                                                  SOCK_DGRAM));
+    if (!socket) {
+      LOG(LS_ERROR) << "Failed to create a UDP socket";
+      return false;
+    }
+    if (num_shards_ > 1 &&
+        socket->SetOption(rtc::Socket::OPT_REUSEPORT, 1) != 0) {
+      LOG(LS_ERROR) << "Failed to share the port between shards, error="
+                    << socket->GetError();
+      return false;
+    }
+    if (socket->Bind(address_) != 0) {
+      LOG(LS_ERROR) << "Failed to bind a UDP socket at "
+                    << address_.ToString() << ", error="
+                    << socket->GetError();
+      return false;
+    }
+    // The next shards bind to the port picked for the first one.
+    address_ = socket->GetLocalAddress();
+
+    shard->server.reset(new TurnServer(thread));
+    shard->server->set_realm(realm_);
+    shard->server->set_software(software_);
+    shard->server->set_auth_hook(auth_hook_);
+    shard->server->AddInternalSocket(new rtc::AsyncUDPSocket(socket.release()),
+                                     PROTO_UDP);
+    shard->server->SetExternalSocketFactory(
+        new rtc::BasicPacketSocketFactory(thread),
+        rtc::SocketAddress(ext_ip, 0));
+    return true;
+  });
+}
+
+void ShardedTurnServer::Stop() {
+  for (const auto& shard : shards_) {
+    shard->thread->Invoke<void>(RTC_FROM_HERE,
+                                [&shard] { shard->server.reset(); });
+    shard->thread->Stop();
+  }
+  shards_.clear();
+}
+
+std::vector<size_t> ShardedTurnServer::GetNumAllocations() const {
+  std::vector<size_t> num_allocations;
+  for (const auto& shard : shards_) {
+    num_allocations.push_back(
+        shard->thread->Invoke<size_t>(RTC_FROM_HERE, [&shard] {
+          return shard->server ? shard->server->allocations().size() : 0;
+        }));
+  }
+  return num_allocations;
+}
+
+}  // namespace cricket
@@ -0,0 +1,80 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_P2P_BASE_SHARDEDTURNSERVER_H_
+#define WEBRTC_P2P_BASE_SHARDEDTURNSERVER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/ipaddress.h"
+#include "webrtc/base/socketaddress.h"
+#include "webrtc/p2p/base/turnserver.h"
+
+namespace rtc {
+class Thread;
+}
+
+namespace cricket {
+
+// Runs one TurnServer per worker thread, all listening on the same UDP
+// address. Each shard binds its own socket with Socket::OPT_REUSEPORT, and
+// the kernel spreads the clients across the sockets by the hash of their
+// 5-tuple, so every packet of an allocation reaches the shard that owns it.
+// The shards share no state, and take no locks on the relay path.
+//
+// A client keeps reaching the same shard as long as the set of shards does
+// not change, which it does not while started. More than one shard is only
+// supported where Socket::OPT_REUSEPORT is, i.e. on Linux.
+class ShardedTurnServer {
+ public:
+  explicit ShardedTurnServer(size_t num_shards);
+  ~ShardedTurnServer();
+
+  // These must be set before Start().
+  void set_realm(const std::string& realm) { realm_ = realm; }
+  void set_software(const std::string& software) { software_ = software; }
+  // Does not take ownership. The hook is called on all the shard threads
+  // concurrently, and must be thread safe.
+  void set_auth_hook(TurnAuthInterface* auth_hook) { auth_hook_ = auth_hook; }
+
+  // Starts listening for clients at |int_addr|, and relaying from sockets
+  // bound to |ext_ip|. If the port of |int_addr| is 0, all shards listen on
+  // the port picked for the first one. Returns false, with no shard running,
+  // if any of the sockets could not be bound.
+  bool Start(const rtc::SocketAddress& int_addr, const rtc::IPAddress& ext_ip);
+  void Stop();
+
+  size_t num_shards() const { return num_shards_; }
+  // The address listened at, once started.
+  const rtc::SocketAddress& address() const { return address_; }
+  // The number of allocations owned by each shard.
+  std::vector<size_t> GetNumAllocations() const;
+
+ private:
+  struct Shard;
+
+  bool StartShard(Shard* shard, const rtc::IPAddress& ext_ip);
+
+  const size_t num_shards_;
+  std::string realm_;
+  std::string software_;
+  TurnAuthInterface* auth_hook_ = nullptr;
+  rtc::SocketAddress address_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ShardedTurnServer);
+};
+
+}  // namespace cricket
+
+#endif  // WEBRTC_P2P_BASE_SHARDEDTURNSERVER_H_
@@ -0,0 +1,180 @@
+/*
+ *  Copyright 2017 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/p2p/base/basicpacketsocketfactory.h"
+#include "webrtc/p2p/base/shardedturnserver.h"
+#include "webrtc/p2p/base/stun.h"
+#include "webrtc/p2p/base/turnport.h"
+
+namespace cricket {
+
+namespace {
+
+const char kRealm[] = "example.org";
+const char kUsername[] = "test";
+const char kPassword[] = "test";
+const rtc::SocketAddress kLoopbackAddr("127.0.0.1", 0);
+const int kTimeoutMs = 10000;
+
+class TestAuth : public TurnAuthInterface {
+ public:
+  bool GetKey(const std::string& username,
+              const std::string& realm,
+              std::string* key) override {
+    return ComputeStunCredentialHash(username, realm, kPassword, key);
+  }
+};
+
+// Echoes every packet back to where it came from.
+class EchoPeer : public sigslot::has_slots<> {
+ public:
+  explicit EchoPeer(rtc::SocketServer* socket_server)
+      : socket_(rtc::AsyncUDPSocket::Create(socket_server, kLoopbackAddr)) {
+    socket_->SignalReadPacket.connect(this, &EchoPeer::OnReadPacket);
+  }
+
+  rtc::SocketAddress address() const { return socket_->GetLocalAddress(); }
+
+ private:
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const rtc::SocketAddress& remote_addr,
+                    const rtc::PacketTime& packet_time) {
+    rtc::PacketOptions options;
+    socket_->SendTo(data, size, remote_addr, options);
+  }
+
+  std::unique_ptr<rtc::AsyncUDPSocket> socket_;
+};
+
+}  // namespace
+
+class ShardedTurnServerTest : public testing::Test,
+                              public sigslot::has_slots<> {
+ public:
+  ShardedTurnServerTest()
+      : ss_scope_(&pss_),
+        network_("unittest", "unittest", kLoopbackAddr.ipaddr(), 32),
+        socket_factory_(rtc::Thread::Current()) {
+    network_.AddIP(kLoopbackAddr.ipaddr());
+  }
+
+  // Starts |num_shards| shards, and allocates from |num_ports| TURN ports.
+  void StartAndAllocate(size_t num_shards, int num_ports) {
+    server_.reset(new ShardedTurnServer(num_shards));
+    server_->set_realm(kRealm);
+    server_->set_auth_hook(&auth_);
+    ASSERT_TRUE(server_->Start(kLoopbackAddr, kLoopbackAddr.ipaddr()));
+    EXPECT_NE(0, server_->address().port());
+
+    for (int i = 0; i < num_ports; ++i) {
+      ports_.emplace_back(TurnPort::Create(
+          rtc::Thread::Current(), &socket_factory_, &network_,
+          kLoopbackAddr.ipaddr(), 0, 0, "ufrag", "password",
+          ProtocolAddress(server_->address(), PROTO_UDP),
+          RelayCredentials(kUsername, kPassword), 0, std::string()));
+      ports_.back()->SignalPortComplete.connect(
+          this, &ShardedTurnServerTest::OnPortComplete);
+      ports_.back()->PrepareAddress();
+    }
+    EXPECT_EQ_WAIT(num_ports, num_ready_ports_, kTimeoutMs);
+  }
+
+  // Creates a connection from the first port to |peer_addr|, through which
+  // the packets relayed from the peer are received.
+  Connection* CreateConnection(const rtc::SocketAddress& peer_addr) {
+    Candidate peer_candidate(ICE_CANDIDATE_COMPONENT_RTP, UDP_PROTOCOL_NAME,
+                             peer_addr, 0, "", "", LOCAL_PORT_TYPE, 0, "");
+    Connection* connection =
+        ports_[0]->CreateConnection(peer_candidate, Port::ORIGIN_MESSAGE);
+    if (connection) {
+      connection->SignalReadPacket.connect(
+          this, &ShardedTurnServerTest::OnReadPacket);
+    }
+    return connection;
+  }
+
+  void OnPortComplete(Port* port) { ++num_ready_ports_; }
+
+  void OnReadPacket(Connection* connection,
+                    const char* data,
+                    size_t size,
+                    const rtc::PacketTime& packet_time) {
+    received_.push_back(std::string(data, size));
+  }
+
+ protected:
+  rtc::PhysicalSocketServer pss_;
+  rtc::SocketServerScope ss_scope_;
+  rtc::Network network_;
+  rtc::BasicPacketSocketFactory socket_factory_;
+  TestAuth auth_;
+  std::unique_ptr<ShardedTurnServer> server_;
+  std::vector<std::unique_ptr<TurnPort>> ports_;
+  int num_ready_ports_ = 0;
+  std::vector<std::string> received_;
+};
+
+TEST_F(ShardedTurnServerTest, AllocatesOnOneShard) {
+  StartAndAllocate(1, 4);
+  EXPECT_EQ(std::vector<size_t>(1, 4), server_->GetNumAllocations());
+}
+
+TEST_F(ShardedTurnServerTest, RelaysThroughChannel) {
+  StartAndAllocate(1, 1);
+  EchoPeer peer(&pss_);
+  ASSERT_TRUE(CreateConnection(peer.address()) != nullptr);
+
+  // The first packets go in send indications, and bind a channel that the
+  // next ones, and the echoes, use.
+  rtc::PacketOptions options;
+  const int kNumPackets = 10;
+  for (int i = 0; i < kNumPackets; ++i) {
+    std::string data(100, static_cast<char>(0x80 + i));
+    ASSERT_EQ(static_cast<int>(data.size()),
+              ports_[0]->SendTo(data.data(), data.size(), peer.address(),
+                                options, true));
+    ASSERT_EQ_WAIT(static_cast<size_t>(i + 1), received_.size(), kTimeoutMs);
+    EXPECT_EQ(data, received_.back());
+  }
+}
+
+// Sharding relies on the kernel spreading datagrams across sockets sharing a
+// port, which only Linux does.
+#if defined(WEBRTC_LINUX)
+TEST_F(ShardedTurnServerTest, SpreadsAllocationsAcrossShards) {
+  const size_t kNumShards = 4;
+  const int kNumPorts = 32;
+  StartAndAllocate(kNumShards, kNumPorts);
+
+  std::vector<size_t> num_allocations = server_->GetNumAllocations();
+  ASSERT_EQ(kNumShards, num_allocations.size());
+  size_t total = 0;
+  size_t num_used_shards = 0;
+  for (size_t num : num_allocations) {
+    total += num;
+    if (num > 0)
+      ++num_used_shards;
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumPorts), total);
+  EXPECT_GT(num_used_shards, 1u);
+}
+#endif
+
+}  // namespace cricket
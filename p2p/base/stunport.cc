@@ -286,6 +286,20 @@ int UDPPort::SendTo(const void* data, size_t size,
   return sent;
 }
 
+int UDPPort::SendToBatch(const rtc::DatagramToSend* datagrams,
+                         const rtc::PacketOptions* options,
+                         size_t count,
+                         bool payload) {
+  int sent = socket_->SendToBatch(datagrams, options, count);
+  if (sent < static_cast<int>(count)) {
+    error_ = socket_->GetError();
+    LOG_J(LS_ERROR, this) << "UDP send of a batch of " << count
+                          << " packets failed after " << (sent > 0 ? sent : 0)
+                          << " with error " << error_;
+  }
+  return sent;
+}
+
 void UDPPort::UpdateNetworkCost() {
   Port::UpdateNetworkCost();
   stun_keepalive_lifetime_ = GetStunKeepaliveLifetime();
@@ -150,6 +150,10 @@ class UDPPort : public Port {
                      const rtc::SocketAddress& addr,
                      const rtc::PacketOptions& options,
                      bool payload);
+  int SendToBatch(const rtc::DatagramToSend* datagrams,
+                  const rtc::PacketOptions* options,
+                  size_t count,
+                  bool payload) override;
 
   virtual void UpdateNetworkCost();
 
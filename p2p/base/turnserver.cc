@@ -25,6 +25,7 @@
 #include "webrtc/base/socketadapters.h"
 #include "webrtc/base/stringencode.h"
 #include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
 
 namespace cricket {
 
@@ -72,6 +73,7 @@ class TurnServerAllocation::Permission : public rtc::MessageHandler {
 
   rtc::Thread* thread_;
   rtc::IPAddress peer_;
+  int64_t expires_ms_;
 };
 
 // Encapsulates a TURN channel binding.
@@ -95,6 +97,7 @@ class TurnServerAllocation::Channel : public rtc::MessageHandler {
   rtc::Thread* thread_;
   int id_;
   rtc::SocketAddress peer_;
+  int64_t expires_ms_;
 };
 
 static bool InitResponse(const StunMessage* req, StunMessage* resp) {
@@ -547,7 +550,10 @@ TurnServerConnection::TurnServerConnection(const rtc::SocketAddress& src,
                                            ProtocolType proto,
                                            rtc::AsyncPacketSocket* socket)
     : src_(src),
-      dst_(socket->GetRemoteAddress()),
+      // Done for every packet received. UDP sockets are not connected, and
+      // have no remote address to get.
+      dst_(proto == PROTO_UDP ? rtc::SocketAddress()
+                              : socket->GetRemoteAddress()),
       proto_(proto),
       socket_(socket) {
 }
@@ -584,13 +590,13 @@ TurnServerAllocation::TurnServerAllocation(TurnServer* server,
 }
 
 TurnServerAllocation::~TurnServerAllocation() {
-  for (ChannelList::iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    delete *it;
+  for (ChannelIdMap::iterator it = channels_by_id_.begin();
+       it != channels_by_id_.end(); ++it) {
+    delete it->second;
   }
-  for (PermissionList::iterator it = perms_.begin();
+  for (PermissionMap::iterator it = perms_.begin();
        it != perms_.end(); ++it) {
-    delete *it;
+    delete it->second;
   }
   thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
   LOG_J(LS_INFO, this) << "Allocation destroyed";
@@ -767,7 +773,8 @@ void TurnServerAllocation::HandleChannelBindRequest(const TurnMessage* msg) {
     channel1 = new Channel(thread_, channel_id, peer_attr->GetAddress());
     channel1->SignalDestroyed.connect(this,
         &TurnServerAllocation::OnChannelDestroyed);
-    channels_.push_back(channel1);
+    channels_by_id_[channel_id] = channel1;
+    channels_by_peer_[channel1->peer()] = channel1;
   } else {
     channel1->Refresh();
   }
@@ -850,7 +857,7 @@ void TurnServerAllocation::AddPermission(const rtc::IPAddress& addr) {
     perm = new Permission(thread_, addr);
     perm->SignalDestroyed.connect(
         this, &TurnServerAllocation::OnPermissionDestroyed);
-    perms_.push_back(perm);
+    perms_[addr] = perm;
   } else {
     perm->Refresh();
   }
@@ -858,32 +865,20 @@ void TurnServerAllocation::AddPermission(const rtc::IPAddress& addr) {
 
 TurnServerAllocation::Permission* TurnServerAllocation::FindPermission(
     const rtc::IPAddress& addr) const {
-  for (PermissionList::const_iterator it = perms_.begin();
-       it != perms_.end(); ++it) {
-    if ((*it)->peer() == addr)
-      return *it;
-  }
-  return NULL;
+  PermissionMap::const_iterator it = perms_.find(addr);
+  return (it != perms_.end()) ? it->second : NULL;
 }
 
 TurnServerAllocation::Channel* TurnServerAllocation::FindChannel(
     int channel_id) const {
-  for (ChannelList::const_iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    if ((*it)->id() == channel_id)
-      return *it;
-  }
-  return NULL;
+  ChannelIdMap::const_iterator it = channels_by_id_.find(channel_id);
+  return (it != channels_by_id_.end()) ? it->second : NULL;
 }
 
 TurnServerAllocation::Channel* TurnServerAllocation::FindChannel(
     const rtc::SocketAddress& addr) const {
-  for (ChannelList::const_iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    if ((*it)->peer() == addr)
-      return *it;
-  }
-  return NULL;
+  ChannelPeerMap::const_iterator it = channels_by_peer_.find(addr);
+  return (it != channels_by_peer_.end()) ? it->second : NULL;
 }
 
 void TurnServerAllocation::SendResponse(TurnMessage* msg) {
@@ -914,36 +909,47 @@ void TurnServerAllocation::OnMessage(rtc::Message* msg) {
 }
 
 void TurnServerAllocation::OnPermissionDestroyed(Permission* perm) {
-  PermissionList::iterator it = std::find(perms_.begin(), perms_.end(), perm);
-  RTC_DCHECK(it != perms_.end());
+  PermissionMap::iterator it = perms_.find(perm->peer());
+  RTC_DCHECK(it != perms_.end() && it->second == perm);
   perms_.erase(it);
 }
 
 void TurnServerAllocation::OnChannelDestroyed(Channel* channel) {
-  ChannelList::iterator it =
-      std::find(channels_.begin(), channels_.end(), channel);
-  RTC_DCHECK(it != channels_.end());
-  channels_.erase(it);
+  RTC_DCHECK(channels_by_id_.find(channel->id()) != channels_by_id_.end());
+  RTC_DCHECK(channels_by_peer_.find(channel->peer()) !=
+             channels_by_peer_.end());
+  channels_by_id_.erase(channel->id());
+  channels_by_peer_.erase(channel->peer());
 }
 
 TurnServerAllocation::Permission::Permission(rtc::Thread* thread,
                                    const rtc::IPAddress& peer)
     : thread_(thread), peer_(peer) {
   Refresh();
+  thread_->PostDelayed(RTC_FROM_HERE, kPermissionTimeout, this,
+                       MSG_ALLOCATION_TIMEOUT);
 }
 
 TurnServerAllocation::Permission::~Permission() {
   thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
 }
 
+// Clearing the posted timer walks the whole message queue of the thread,
+// which holds a timer for every permission and channel of every allocation.
+// So a refresh only moves the expiration, and the timer, when it fires,
+// waits out whatever is left.
 void TurnServerAllocation::Permission::Refresh() {
-  thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
-  thread_->PostDelayed(RTC_FROM_HERE, kPermissionTimeout, this,
-                       MSG_ALLOCATION_TIMEOUT);
+  expires_ms_ = rtc::TimeMillis() + kPermissionTimeout;
 }
 
 void TurnServerAllocation::Permission::OnMessage(rtc::Message* msg) {
   RTC_DCHECK(msg->message_id == MSG_ALLOCATION_TIMEOUT);
+  int64_t remaining_ms = expires_ms_ - rtc::TimeMillis();
+  if (remaining_ms > 0) {
+    thread_->PostDelayed(RTC_FROM_HERE, static_cast<int>(remaining_ms), this,
+                         MSG_ALLOCATION_TIMEOUT);
+    return;
+  }
   SignalDestroyed(this);
   delete this;
 }
@@ -952,20 +958,27 @@ TurnServerAllocation::Channel::Channel(rtc::Thread* thread, int id,
                              const rtc::SocketAddress& peer)
     : thread_(thread), id_(id), peer_(peer) {
   Refresh();
+  thread_->PostDelayed(RTC_FROM_HERE, kChannelTimeout, this,
+                       MSG_ALLOCATION_TIMEOUT);
 }
 
 TurnServerAllocation::Channel::~Channel() {
   thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
 }
 
+// Refreshed lazily, like permissions.
 void TurnServerAllocation::Channel::Refresh() {
-  thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
-  thread_->PostDelayed(RTC_FROM_HERE, kChannelTimeout, this,
-                       MSG_ALLOCATION_TIMEOUT);
+  expires_ms_ = rtc::TimeMillis() + kChannelTimeout;
 }
 
 void TurnServerAllocation::Channel::OnMessage(rtc::Message* msg) {
   RTC_DCHECK(msg->message_id == MSG_ALLOCATION_TIMEOUT);
+  int64_t remaining_ms = expires_ms_ - rtc::TimeMillis();
+  if (remaining_ms > 0) {
+    thread_->PostDelayed(RTC_FROM_HERE, static_cast<int>(remaining_ms), this,
+                         MSG_ALLOCATION_TIMEOUT);
+    return;
+  }
   SignalDestroyed(this);
   delete this;
 }
@@ -40,10 +40,9 @@ bool SetRawAudioSink_w(VoiceMediaChannel* channel,
   return true;
 }
 
-struct SendPacketMessageData : public rtc::MessageData {
-  rtc::CopyOnWriteBuffer packet;
-  rtc::PacketOptions options;
-};
+// Packets sent from other threads that may wait for the network thread.
+// Further packets are not sent, and reported as such, until it catches up.
+const size_t kMaxPendingSends = 512;
 
 #if defined(ENABLE_EXTERNAL_AUTH)
 // Returns the named header extension if found among all extensions,
@@ -63,8 +62,7 @@ const webrtc::RtpExtension* FindHeaderExtension(
 
 enum {
   MSG_EARLYMEDIATIMEOUT = 1,
-  MSG_SEND_RTP_PACKET,
-  MSG_SEND_RTCP_PACKET,
+  MSG_SEND_PACKETS,
   MSG_CHANNEL_ERROR,
   MSG_READYTOSENDDATA,
   MSG_DATARECEIVED,
@@ -193,8 +191,8 @@ BaseChannel::~BaseChannel() {
 }
 
 void BaseChannel::DisconnectTransportChannels_n() {
-  // Send any outstanding RTCP packets.
-  FlushRtcpMessages_n();
+  // Send any outstanding packets, RTCP ones especially.
+  FlushPendingPackets_n();
 
   // Stop signals from transport channels, but keep them alive because
   // media_channel may use them from a different thread.
@@ -525,10 +523,16 @@ bool BaseChannel::SetMediaCryptoKey(const webrtc::MediaCryptoKey &key) {
   if (!media_channel_)
     return false;
   // Set it on the media channel
-  media_channel_->SetMediaCryptoKey(key);
+  worker_thread_->Invoke<void>(
+      RTC_FROM_HERE, Bind(&BaseChannel::SetMediaCryptoKey_w, this, key));
   return true;
 }
 
+void BaseChannel::SetMediaCryptoKey_w(const webrtc::MediaCryptoKey& key) {
+  RTC_DCHECK(worker_thread_->IsCurrent());
+  media_channel_->SetMediaCryptoKey(key);
+}
+
 void BaseChannel::OnWritableState(rtc::PacketTransportInterface* transport) {
   RTC_DCHECK(transport == rtp_transport_ || transport == rtcp_transport_);
   RTC_DCHECK(network_thread_->IsCurrent());
@@ -630,18 +634,50 @@ bool BaseChannel::SendPacket(bool rtcp,
   // synchronize access to all the pieces of the send path, including
   // SRTP and the inner workings of the transport channels.
   // The only downside is that we can't return a proper failure code if
-  // needed. Since UDP is unreliable anyway, this should be a non-issue.
+  // needed, only whether the packet could be queued. Since UDP is unreliable
+  // anyway, this should be a non-issue.
   if (!network_thread_->IsCurrent()) {
-    // Avoid a copy by transferring the ownership of the packet data.
-    int message_id = rtcp ? MSG_SEND_RTCP_PACKET : MSG_SEND_RTP_PACKET;
-    SendPacketMessageData* data = new SendPacketMessageData;
-    data->packet = std::move(*packet);
-    data->options = options;
-    network_thread_->Post(RTC_FROM_HERE, this, message_id, data);
+    // RTP and RTCP packets queued while the network thread is busy are sent
+    // together and in order, see SendPendingPackets_n.
+    bool post;
+    {
+      rtc::CritScope cs(&pending_sends_crit_);
+      if (pending_sends_.size() == kMaxPendingSends)
+        return false;
+      post = pending_sends_.empty();
+      // This doesn't memcpy the actual data.
+      pending_sends_.push_back(std::move(*packet));
+      pending_send_options_.push_back(options);
+      pending_send_rtcp_.push_back(rtcp);
+    }
+    if (post)
+      network_thread_->Post(RTC_FROM_HERE, this, MSG_SEND_PACKETS);
     return true;
   }
   TRACE_EVENT0("webrtc", "BaseChannel::SendPacket");
 
+  rtc::PacketOptions updated_options = options;
+  TransportChannel* channel = PreparePacket_n(rtcp, packet, &updated_options);
+  if (!channel)
+    return false;
+
+  // Bon voyage.
+  int flags = (secure() && secure_dtls()) ? PF_SRTP_BYPASS : PF_NORMAL;
+  int ret = channel->SendPacket(packet->data<char>(), packet->size(),
+                                updated_options, flags);
+  if (ret != static_cast<int>(packet->size())) {
+    if (channel->GetError() == ENOTCONN) {
+      LOG(LS_WARNING) << "Got ENOTCONN from transport.";
+      SetTransportChannelReadyToSend(rtcp, false);
+    }
+    return false;
+  }
+  return true;
+}
+
+TransportChannel* BaseChannel::PreparePacket_n(bool rtcp,
+                                               rtc::CopyOnWriteBuffer* packet,
+                                               rtc::PacketOptions* options) {
   // Now that we are on the correct thread, ensure we have a place to send this
   // packet before doing anything. (We might get RTCP packets that we don't
   // intend to send.) If we've negotiated RTCP mux, send RTCP over the RTP
@@ -649,7 +685,7 @@ bool BaseChannel::SendPacket(bool rtcp,
   TransportChannel* channel =
       (!rtcp || rtcp_mux_filter_.IsActive()) ? rtp_transport_ : rtcp_transport_;
   if (!channel || !channel->writable()) {
-    return false;
+    return nullptr;
   }
 
   // Protect ourselves against crazy data.
@@ -657,11 +693,9 @@ bool BaseChannel::SendPacket(bool rtcp,
     LOG(LS_ERROR) << "Dropping outgoing " << content_name_ << " "
                   << PacketType(rtcp)
                   << " packet: wrong size=" << packet->size();
-    return false;
+    return nullptr;
   }
 
-  rtc::PacketOptions updated_options;
-  updated_options = options;
   // Protect if needed.
   if (srtp_filter_.IsActive()) {
     TRACE_EVENT0("webrtc", "SRTP Encode");
@@ -678,21 +712,21 @@ bool BaseChannel::SendPacket(bool rtcp,
       res = srtp_filter_.ProtectRtp(
           data, len, static_cast<int>(packet->capacity()), &len);
 #else
-      updated_options.packet_time_params.rtp_sendtime_extension_id =
+      options->packet_time_params.rtp_sendtime_extension_id =
           rtp_abs_sendtime_extn_id_;
       res = srtp_filter_.ProtectRtp(
           data, len, static_cast<int>(packet->capacity()), &len,
-          &updated_options.packet_time_params.srtp_packet_index);
+          &options->packet_time_params.srtp_packet_index);
       // If protection succeeds, let's get auth params from srtp.
       if (res) {
         uint8_t* auth_key = NULL;
         int key_len;
         res = srtp_filter_.GetRtpAuthParams(
             &auth_key, &key_len,
-            &updated_options.packet_time_params.srtp_auth_tag_len);
+            &options->packet_time_params.srtp_auth_tag_len);
         if (res) {
-          updated_options.packet_time_params.srtp_auth_key.resize(key_len);
-          updated_options.packet_time_params.srtp_auth_key.assign(
+          options->packet_time_params.srtp_auth_key.resize(key_len);
+          options->packet_time_params.srtp_auth_key.assign(
               auth_key, auth_key + key_len);
         }
       }
@@ -705,7 +739,7 @@ bool BaseChannel::SendPacket(bool rtcp,
         LOG(LS_ERROR) << "Failed to protect " << content_name_
                       << " RTP packet: size=" << len
                       << ", seqnum=" << seq_num << ", SSRC=" << ssrc;
-        return false;
+        return nullptr;
       }
     } else {
       res = srtp_filter_.ProtectRtcp(data, len,
@@ -716,7 +750,7 @@ bool BaseChannel::SendPacket(bool rtcp,
         GetRtcpType(data, len, &type);
         LOG(LS_ERROR) << "Failed to protect " << content_name_
                       << " RTCP packet: size=" << len << ", type=" << type;
-        return false;
+        return nullptr;
       }
     }
 
@@ -727,28 +761,71 @@ bool BaseChannel::SendPacket(bool rtcp,
     // streams are created, so don't treat this as an error for RTCP.
     // See: https://bugs.chromium.org/p/webrtc/issues/detail?id=6809
     if (rtcp) {
-      return false;
+      return nullptr;
     }
     // However, there shouldn't be any RTP packets sent before SRTP is set up
     // (and SetSend(true) is called).
     LOG(LS_ERROR) << "Can't send outgoing RTP packet when SRTP is inactive"
                   << " and crypto is required";
     RTC_NOTREACHED();
-    return false;
+    return nullptr;
   }
+  return channel;
+}
 
-  // Bon voyage.
-  int flags = (secure() && secure_dtls()) ? PF_SRTP_BYPASS : PF_NORMAL;
-  int ret = channel->SendPacket(packet->data<char>(), packet->size(),
-                                updated_options, flags);
-  if (ret != static_cast<int>(packet->size())) {
-    if (channel->GetError() == ENOTCONN) {
-      LOG(LS_WARNING) << "Got ENOTCONN from transport.";
-      SetTransportChannelReadyToSend(rtcp, false);
+void BaseChannel::SendPendingPackets_n() {
+  RTC_DCHECK(network_thread_->IsCurrent());
+  {
+    rtc::CritScope cs(&pending_sends_crit_);
+    sending_.swap(pending_sends_);
+    sending_options_.swap(pending_send_options_);
+    sending_rtcp_.swap(pending_send_rtcp_);
+  }
+  TRACE_EVENT1("webrtc", "BaseChannel::SendPendingPackets_n", "packets",
+               sending_.size());
+  // Every packet is protected before it is handed to the transport, those
+  // that can't be sent are dropped. Packets are moved to the front as they
+  // are kept, and each run of them going to the same transport channel is
+  // sent in one go. Without RTCP mux, RTCP splits the runs of RTP.
+  TransportChannel* channel = nullptr;
+  size_t run_start = 0;
+  size_t count = 0;
+  for (size_t i = 0; i < sending_.size(); ++i) {
+    TransportChannel* packet_channel =
+        PreparePacket_n(sending_rtcp_[i], &sending_[i], &sending_options_[i]);
+    if (!packet_channel)
+      continue;
+    if (packet_channel != channel) {
+      SendPacketRun_n(channel, run_start, count);
+      channel = packet_channel;
+      run_start = count;
     }
-    return false;
+    if (count != i) {
+      sending_[count] = std::move(sending_[i]);
+      sending_options_[count] = sending_options_[i];
+    }
+    ++count;
+  }
+  SendPacketRun_n(channel, run_start, count);
+  // Keeps the capacity, the vectors are swapped back in on the next batch.
+  sending_.clear();
+  sending_options_.clear();
+  sending_rtcp_.clear();
+}
+
+void BaseChannel::SendPacketRun_n(TransportChannel* channel,
+                                  size_t begin,
+                                  size_t end) {
+  if (begin == end)
+    return;
+  int flags = (secure() && secure_dtls()) ? PF_SRTP_BYPASS : PF_NORMAL;
+  int sent = channel->SendPackets(&sending_[begin], &sending_options_[begin],
+                                  end - begin, flags);
+  if (sent < static_cast<int>(end - begin) &&
+      channel->GetError() == ENOTCONN) {
+    LOG(LS_WARNING) << "Got ENOTCONN from transport.";
+    SetTransportChannelReadyToSend(channel == rtcp_transport_, false);
   }
-  return true;
 }
 
 bool BaseChannel::WantsPacket(bool rtcp, const rtc::CopyOnWriteBuffer* packet) {
@@ -827,23 +904,29 @@ void BaseChannel::HandlePacket(bool rtcp, rtc::CopyOnWriteBuffer* packet,
     return;
   }
 
-  invoker_.AsyncInvoke<void>(
-      RTC_FROM_HERE, worker_thread_,
-      Bind(&BaseChannel::OnPacketReceived, this, rtcp, *packet, packet_time));
+  bool post;
+  {
+    rtc::CritScope cs(&pending_packets_crit_);
+    post = pending_packets_.empty();
+    // This doesn't memcpy the actual data.
+    pending_packets_.push_back({rtcp, *packet, packet_time});
+  }
+  if (post) {
+    invoker_.AsyncInvoke<void>(RTC_FROM_HERE, worker_thread_,
+                               Bind(&BaseChannel::OnPacketsReceived, this));
+  }
 }
 
-void BaseChannel::OnPacketReceived(bool rtcp,
-                                   const rtc::CopyOnWriteBuffer& packet,
-                                   const rtc::PacketTime& packet_time) {
+void BaseChannel::OnPacketsReceived() {
   RTC_DCHECK(worker_thread_->IsCurrent());
-  // Need to copy variable because OnRtcpReceived/OnPacketReceived
-  // requires non-const pointer to buffer. This doesn't memcpy the actual data.
-  rtc::CopyOnWriteBuffer data(packet);
-  if (rtcp) {
-    media_channel_->OnRtcpReceived(&data, packet_time);
-  } else {
-    media_channel_->OnPacketReceived(&data, packet_time);
+  std::vector<MediaChannel::ReceivedPacket> packets;
+  {
+    rtc::CritScope cs(&pending_packets_crit_);
+    packets.swap(pending_packets_);
   }
+  TRACE_EVENT1("webrtc", "BaseChannel::OnPacketsReceived", "packets",
+               packets.size());
+  media_channel_->OnPacketsReceived(packets);
 }
 
 bool BaseChannel::PushdownLocalDescription(
@@ -1414,16 +1497,9 @@ void BaseChannel::CacheRtpAbsSendTimeHeaderExtension_n(
 void BaseChannel::OnMessage(rtc::Message *pmsg) {
   TRACE_EVENT0("webrtc", "BaseChannel::OnMessage");
   switch (pmsg->message_id) {
-    case MSG_SEND_RTP_PACKET:
-    case MSG_SEND_RTCP_PACKET: {
-      RTC_DCHECK(network_thread_->IsCurrent());
-      SendPacketMessageData* data =
-          static_cast<SendPacketMessageData*>(pmsg->pdata);
-      bool rtcp = pmsg->message_id == MSG_SEND_RTCP_PACKET;
-      SendPacket(rtcp, &data->packet, data->options);
-      delete data;
+    case MSG_SEND_PACKETS:
+      SendPendingPackets_n();
       break;
-    }
     case MSG_FIRSTPACKETRECEIVED: {
       SignalFirstPacketReceived(this);
       break;
@@ -1431,16 +1507,11 @@ void BaseChannel::OnMessage(rtc::Message *pmsg) {
   }
 }
 
-void BaseChannel::FlushRtcpMessages_n() {
-  // Flush all remaining RTCP messages. This should only be called in
-  // destructor.
+void BaseChannel::FlushPendingPackets_n() {
+  // Flush all remaining packets. This should only be called in destructor.
   RTC_DCHECK(network_thread_->IsCurrent());
-  rtc::MessageList rtcp_messages;
-  network_thread_->Clear(this, MSG_SEND_RTCP_PACKET, &rtcp_messages);
-  for (const auto& message : rtcp_messages) {
-    network_thread_->Send(RTC_FROM_HERE, this, MSG_SEND_RTCP_PACKET,
-                          message.pdata);
-  }
+  network_thread_->Clear(this, MSG_SEND_PACKETS);
+  SendPendingPackets_n();
 }
 
 void BaseChannel::SignalSentPacket_n(
@@ -189,7 +189,8 @@ class BaseChannel
 
   bool SetCryptoOptions(const rtc::CryptoOptions& crypto_options);
   
-  // End to end media encryption
+  // End to end media encryption. Setting a new key on a channel already
+  // using one rotates the key of its existing streams.
   bool SetMediaCryptoKey(const webrtc::MediaCryptoKey& key);
 
   // This function returns true if we require SRTP for call setup.
@@ -232,7 +233,7 @@ class BaseChannel
   void ConnectToTransportChannel(TransportChannel* tc);
   void DisconnectFromTransportChannel(TransportChannel* tc);
 
-  void FlushRtcpMessages_n();
+  void FlushPendingPackets_n();
 
   // NetworkInterface implementation, called by MediaEngine
   bool SendPacket(rtc::CopyOnWriteBuffer* packet,
@@ -263,13 +264,19 @@ class BaseChannel
   bool SendPacket(bool rtcp,
                   rtc::CopyOnWriteBuffer* packet,
                   const rtc::PacketOptions& options);
+  // Returns the transport channel to send |packet| on once it is protected,
+  // or null if it has to be dropped. |options| are updated for the transport.
+  TransportChannel* PreparePacket_n(bool rtcp,
+                                    rtc::CopyOnWriteBuffer* packet,
+                                    rtc::PacketOptions* options);
+  void SendPendingPackets_n();
+  // Sends packets [begin, end) of |sending_| on |channel|.
+  void SendPacketRun_n(TransportChannel* channel, size_t begin, size_t end);
 
   bool WantsPacket(bool rtcp, const rtc::CopyOnWriteBuffer* packet);
   void HandlePacket(bool rtcp, rtc::CopyOnWriteBuffer* packet,
                     const rtc::PacketTime& packet_time);
-  void OnPacketReceived(bool rtcp,
-                        const rtc::CopyOnWriteBuffer& packet,
-                        const rtc::PacketTime& packet_time);
+  void OnPacketsReceived();
 
   void EnableMedia_w();
   void DisableMedia_w();
@@ -285,6 +292,7 @@ class BaseChannel
   bool RemoveRecvStream_w(uint32_t ssrc);
   bool AddSendStream_w(const StreamParams& sp);
   bool RemoveSendStream_w(uint32_t ssrc);
+  void SetMediaCryptoKey_w(const webrtc::MediaCryptoKey& key);
   bool ShouldSetupDtlsSrtp_n() const;
   // Do the DTLS key expansion and impose it on the SRTP/SRTCP filters.
   // |rtcp_channel| indicates whether to set up the RTP or RTCP filter.
@@ -397,6 +405,25 @@ class BaseChannel
   bool writable_ = false;
   bool was_ever_writable_ = false;
   bool has_received_packet_ = false;
+  // Packets unprotected on the network thread and not yet handed to the media
+  // channel. The worker thread is only posted to when the first packet is
+  // queued, and then takes every packet received meanwhile in one go.
+  rtc::CriticalSection pending_packets_crit_;
+  std::vector<MediaChannel::ReceivedPacket> pending_packets_
+      GUARDED_BY(pending_packets_crit_);
+  // RTP and RTCP packets sent from other threads and not yet protected. As
+  // above, the network thread is only posted to for the first one, and then
+  // sends all of them in order, batching those that share a transport.
+  rtc::CriticalSection pending_sends_crit_;
+  std::vector<rtc::CopyOnWriteBuffer> pending_sends_
+      GUARDED_BY(pending_sends_crit_);
+  std::vector<rtc::PacketOptions> pending_send_options_
+      GUARDED_BY(pending_sends_crit_);
+  std::vector<bool> pending_send_rtcp_ GUARDED_BY(pending_sends_crit_);
+  // The batch being sent on the network thread, reused to keep its capacity.
+  std::vector<rtc::CopyOnWriteBuffer> sending_;
+  std::vector<rtc::PacketOptions> sending_options_;
+  std::vector<bool> sending_rtcp_;
   bool dtls_keyed_ = false;
   const bool srtp_required_ = true;
   rtc::CryptoOptions crypto_options_;
@@ -214,8 +214,11 @@ RtpStreamReceiver::RtpStreamReceiver(
   }
   
   // Check if end to end media encryption is enabled
-  if (config->media_crypto_enabled)
+  if (config->media_crypto_enabled) {
     rtp_receiver_->EnableMediaCrypto(config->media_crypto_key);
+    if (!config->media_crypto_next_key.buffer.empty())
+      rtp_receiver_->EnableMediaCrypto(config->media_crypto_next_key);
+  }
 }
 
 RtpStreamReceiver::~RtpStreamReceiver() {
@@ -289,12 +292,21 @@ int32_t RtpStreamReceiver::OnReceivedPayloadData(
         case video_coding::H264SpsPpsTracker::kInsert:
           break;
       }
+      ++num_copied_payloads_;
+    } else if (receive_buffer_ && packet.dataPtr >= receive_buffer_->cdata() &&
+               packet.dataPtr + packet.sizeBytes <=
+                   receive_buffer_->cdata() + receive_buffer_->size()) {
+      // The payload wasn't moved out of the received packet, by RTX or FEC
+      // for instance, so keep a reference to the packet instead of copying.
+      packet.receive_buffer = *receive_buffer_;
     } else {
       uint8_t* data = new uint8_t[packet.sizeBytes];
       memcpy(data, packet.dataPtr, packet.sizeBytes);
       packet.dataPtr = data;
+      ++num_copied_payloads_;
     }
 
+    ++num_inserted_packets_;
     packet_buffer_->InsertPacket(&packet);
   } else {
     if (video_receiver_->IncomingPacket(payload_data, payload_size,
@@ -335,7 +347,8 @@ void RtpStreamReceiver::OnIncomingSSRCChanged(const uint32_t ssrc) {
 
 bool RtpStreamReceiver::DeliverRtp(const uint8_t* rtp_packet,
                                    size_t rtp_packet_length,
-                                   const PacketTime& packet_time) {
+                                   const PacketTime& packet_time,
+                                   const rtc::CopyOnWriteBuffer* buffer) {
   RTC_DCHECK(remote_bitrate_estimator_);
   {
     rtc::CritScope lock(&receive_cs_);
@@ -381,7 +394,9 @@ bool RtpStreamReceiver::DeliverRtp(const uint8_t* rtp_packet,
 
   bool in_order = IsPacketInOrder(header);
   rtp_payload_registry_.SetIncomingPayloadType(header);
+  receive_buffer_ = buffer;
   bool ret = ReceivePacket(rtp_packet, rtp_packet_length, header, in_order);
+  receive_buffer_ = nullptr;
   // Update receive statistics after ReceivePacket.
   // Receive statistics will be reset if the payload type changes (make sure
   // that the first packet is included in the stats).
@@ -640,6 +655,12 @@ bool RtpStreamReceiver::IsPacketRetransmitted(const RTPHeader& header,
 }
 
 void RtpStreamReceiver::UpdateHistograms() {
+  if (num_inserted_packets_ > 0) {
+    RTC_HISTOGRAM_PERCENTAGE(
+        "WebRTC.Video.CopiedPayloadsInPercent",
+        static_cast<int>(num_copied_payloads_ * 100 / num_inserted_packets_));
+  }
+
   FecPacketCounter counter = ulpfec_receiver_->GetPacketCounter();
   if (counter.first_packet_time_ms == -1)
     return;
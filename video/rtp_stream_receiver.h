@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "webrtc/base/constructormagic.h"
+#include "webrtc/base/copyonwritebuffer.h"
 #include "webrtc/base/criticalsection.h"
 #include "webrtc/modules/include/module_common_types.h"
 #include "webrtc/modules/rtp_rtcp/include/receive_statistics.h"
@@ -96,9 +97,12 @@ class RtpStreamReceiver : public RtpData,
   void StartReceive();
   void StopReceive();
 
+  // If |buffer| isn't null, it holds |rtp_packet|, and the packet buffer
+  // references it instead of copying the payload.
   bool DeliverRtp(const uint8_t* rtp_packet,
                   size_t rtp_packet_length,
-                  const PacketTime& packet_time);
+                  const PacketTime& packet_time,
+                  const rtc::CopyOnWriteBuffer* buffer);
   bool DeliverRtcp(const uint8_t* rtcp_packet, size_t rtcp_packet_length);
 
   void FrameContinuous(uint16_t seq_num);
@@ -205,6 +209,14 @@ class RtpStreamReceiver : public RtpData,
   // Maps a payload type to a map of out-of-band supplied codec parameters.
   std::map<uint8_t, std::map<std::string, std::string>> pt_codec_params_;
   int16_t last_payload_type_ = -1;
+
+  // The buffer of the packet being handled by DeliverRtp(), or null. Only
+  // used on the thread delivering packets, like the counters below.
+  const rtc::CopyOnWriteBuffer* receive_buffer_ = nullptr;
+  // Packets inserted into the packet buffer, and how many of their payloads
+  // were copied on the way rather than referenced in their receive buffer.
+  int64_t num_inserted_packets_ = 0;
+  int64_t num_copied_payloads_ = 0;
 };
 
 }  // namespace webrtc
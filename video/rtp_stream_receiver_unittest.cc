@@ -0,0 +1,188 @@
+/*
+ *  Copyright (c) 2017 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <vector>
+
+#include "webrtc/base/copyonwritebuffer.h"
+#include "webrtc/modules/pacing/packet_router.h"
+#include "webrtc/modules/remote_bitrate_estimator/include/mock/mock_remote_bitrate_estimator.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/modules/utility/include/mock/mock_process_thread.h"
+#include "webrtc/modules/video_coding/frame_object.h"
+#include "webrtc/modules/video_coding/include/video_coding_defines.h"
+#include "webrtc/modules/video_coding/timing.h"
+#include "webrtc/modules/video_coding/video_coding_impl.h"
+#include "webrtc/system_wrappers/include/clock.h"
+#include "webrtc/system_wrappers/include/metrics_default.h"
+#include "webrtc/test/field_trial.h"
+#include "webrtc/test/gmock.h"
+#include "webrtc/test/gtest.h"
+#include "webrtc/test/mock_transport.h"
+#include "webrtc/video/rtp_stream_receiver.h"
+#include "webrtc/video/vie_remb.h"
+
+namespace webrtc {
+namespace {
+
+const uint32_t kRemoteSsrc = 1111;
+const uint32_t kLocalSsrc = 2222;
+const uint8_t kVp8PayloadType = 100;
+const int kPacketsPerFrame = 3;
+const size_t kPayloadSize = 500;
+// The RTP header, and the one byte VP8 payload descriptor.
+const size_t kPayloadOffset = 13;
+
+class NullNackSender : public NackSender {
+ public:
+  void SendNack(const std::vector<uint16_t>& sequence_numbers) override {}
+};
+
+class NullKeyFrameRequestSender : public KeyFrameRequestSender {
+ public:
+  void RequestKeyFrame() override {}
+};
+
+class FrameRecorder : public video_coding::OnCompleteFrameCallback {
+ public:
+  void OnCompleteFrame(
+      std::unique_ptr<video_coding::FrameObject> frame) override {
+    frames_.push_back(std::move(frame));
+  }
+
+  std::vector<std::unique_ptr<video_coding::FrameObject>> frames_;
+};
+
+// An RTP packet of a VP8 key frame. The payload of the first packet starts
+// with the key frame header, the rest of the payload is |seq_num|.
+rtc::CopyOnWriteBuffer CreateVp8Packet(uint16_t seq_num,
+                                       uint32_t timestamp,
+                                       bool first,
+                                       bool last) {
+  rtc::CopyOnWriteBuffer packet(kPayloadOffset + kPayloadSize);
+  uint8_t* data = packet.data();
+  data[0] = 0x80;
+  data[1] = kVp8PayloadType | (last ? 0x80 : 0);
+  ByteWriter<uint16_t>::WriteBigEndian(&data[2], seq_num);
+  ByteWriter<uint32_t>::WriteBigEndian(&data[4], timestamp);
+  ByteWriter<uint32_t>::WriteBigEndian(&data[8], kRemoteSsrc);
+  // VP8 payload descriptor, with the S bit set in the first packet.
+  data[kPayloadOffset - 1] = first ? 0x10 : 0;
+  uint8_t* payload = &data[kPayloadOffset];
+  memset(payload, static_cast<uint8_t>(seq_num), kPayloadSize);
+  if (first) {
+    // Key frame tag, start code and 16x16 pixels.
+    const uint8_t kKeyFrameHeader[] = {0x00, 0x00, 0x00, 0x9d, 0x01,
+                                       0x2a, 0x10, 0x00, 0x10, 0x00};
+    memcpy(payload, kKeyFrameHeader, sizeof(kKeyFrameHeader));
+  }
+  return packet;
+}
+
+}  // namespace
+
+class RtpStreamReceiverTest : public ::testing::Test {
+ public:
+  RtpStreamReceiverTest()
+      : override_field_trials_("WebRTC-NewVideoJitterBuffer/Enabled/"),
+        config_(&mock_transport_),
+        timing_(Clock::GetRealTimeClock()),
+        video_receiver_(Clock::GetRealTimeClock(), nullptr, nullptr, &timing_),
+        remb_(Clock::GetRealTimeClock()) {
+    metrics::Reset();
+    config_.rtp.remote_ssrc = kRemoteSsrc;
+    config_.rtp.local_ssrc = kLocalSsrc;
+    rtp_stream_receiver_.reset(new RtpStreamReceiver(
+        &video_receiver_, &remote_bitrate_estimator_, &mock_transport_,
+        nullptr, nullptr, &packet_router_, &remb_, &config_, nullptr,
+        &process_thread_, nullptr, &nack_sender_, &keyframe_request_sender_,
+        &frame_recorder_, &timing_));
+
+    VideoCodec codec = {};
+    codec.codecType = kVideoCodecVP8;
+    codec.plType = kVp8PayloadType;
+    strncpy(codec.plName, "VP8", sizeof(codec.plName));
+    EXPECT_TRUE(rtp_stream_receiver_->AddReceiveCodec(codec));
+    rtp_stream_receiver_->StartReceive();
+  }
+
+  // Delivers a frame, either with the buffers holding the packets, or as
+  // plain pointers, and checks the bitstream of the received frame.
+  void DeliverFrame(uint16_t first_seq_num, bool with_buffers) {
+    std::vector<rtc::CopyOnWriteBuffer> packets;
+    std::vector<uint8_t> expected_bitstream;
+    for (int i = 0; i < kPacketsPerFrame; ++i) {
+      packets.push_back(CreateVp8Packet(first_seq_num + i, first_seq_num * 90,
+                                        i == 0, i == kPacketsPerFrame - 1));
+      const uint8_t* payload = packets.back().cdata() + kPayloadOffset;
+      expected_bitstream.insert(expected_bitstream.end(), payload,
+                                payload + kPayloadSize);
+    }
+    size_t num_frames = frame_recorder_.frames_.size();
+    for (const rtc::CopyOnWriteBuffer& packet : packets) {
+      EXPECT_TRUE(rtp_stream_receiver_->DeliverRtp(
+          packet.cdata(), packet.size(), PacketTime(),
+          with_buffers ? &packet : nullptr));
+    }
+    // The packet buffer holds on to the packets, the received ones can go.
+    packets.clear();
+
+    ASSERT_EQ(num_frames + 1, frame_recorder_.frames_.size());
+    const video_coding::FrameObject& frame = *frame_recorder_.frames_.back();
+    ASSERT_EQ(expected_bitstream.size(), frame.Length());
+    EXPECT_EQ(0, memcmp(expected_bitstream.data(), frame.Buffer(),
+                        frame.Length()));
+  }
+
+ protected:
+  test::ScopedFieldTrials override_field_trials_;
+  MockTransport mock_transport_;
+  VideoReceiveStream::Config config_;
+  VCMTiming timing_;
+  vcm::VideoReceiver video_receiver_;
+  VieRemb remb_;
+  testing::NiceMock<MockRemoteBitrateEstimator> remote_bitrate_estimator_;
+  testing::NiceMock<MockProcessThread> process_thread_;
+  PacketRouter packet_router_;
+  NullNackSender nack_sender_;
+  NullKeyFrameRequestSender keyframe_request_sender_;
+  FrameRecorder frame_recorder_;
+  std::unique_ptr<RtpStreamReceiver> rtp_stream_receiver_;
+};
+
+TEST_F(RtpStreamReceiverTest, ReferencesPayloadsInReceiveBuffers) {
+  DeliverFrame(1000, true);
+  DeliverFrame(1000 + kPacketsPerFrame, true);
+
+  rtp_stream_receiver_.reset();
+  EXPECT_EQ(1, metrics::NumSamples("WebRTC.Video.CopiedPayloadsInPercent"));
+  EXPECT_EQ(1, metrics::NumEvents("WebRTC.Video.CopiedPayloadsInPercent", 0));
+}
+
+TEST_F(RtpStreamReceiverTest, CopiesPayloadsWithoutReceiveBuffers) {
+  DeliverFrame(1000, false);
+  DeliverFrame(1000 + kPacketsPerFrame, false);
+
+  rtp_stream_receiver_.reset();
+  EXPECT_EQ(1, metrics::NumSamples("WebRTC.Video.CopiedPayloadsInPercent"));
+  EXPECT_EQ(1,
+            metrics::NumEvents("WebRTC.Video.CopiedPayloadsInPercent", 100));
+}
+
+TEST_F(RtpStreamReceiverTest, CopiesPayloadsNotInReceiveBuffer) {
+  DeliverFrame(1000, true);
+  DeliverFrame(1000 + kPacketsPerFrame, false);
+
+  rtp_stream_receiver_.reset();
+  EXPECT_EQ(1,
+            metrics::NumEvents("WebRTC.Video.CopiedPayloadsInPercent", 50));
+}
+
+}  // namespace webrtc
@@ -22,6 +22,7 @@
 #include "webrtc/common_video/h264/profile_level_id.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
 #include "webrtc/modules/congestion_controller/include/congestion_controller.h"
+#include "webrtc/modules/rtp_rtcp/include/rtp_receiver.h"
 #include "webrtc/modules/utility/include/process_thread.h"
 #include "webrtc/modules/video_coding/frame_object.h"
 #include "webrtc/modules/video_coding/include/video_coding.h"
@@ -278,8 +279,9 @@ bool VideoReceiveStream::DeliverRtcp(const uint8_t* packet, size_t length) {
 
 bool VideoReceiveStream::DeliverRtp(const uint8_t* packet,
                                     size_t length,
-                                    const PacketTime& packet_time) {
-  return rtp_stream_receiver_.DeliverRtp(packet, length, packet_time);
+                                    const PacketTime& packet_time,
+                                    const rtc::CopyOnWriteBuffer* buffer) {
+  return rtp_stream_receiver_.DeliverRtp(packet, length, packet_time, buffer);
 }
 
 bool VideoReceiveStream::OnRecoveredPacket(const uint8_t* packet,
@@ -379,6 +381,13 @@ VideoReceiveStream::Stats VideoReceiveStream::GetStats() const {
   return stats_proxy_.GetStats();
 }
 
+void VideoReceiveStream::SetMediaCryptoKey(const MediaCryptoKey& key) {
+  // Safe to call while packets are being decrypted, epochs are swapped under
+  // a lock inside the receiver.
+  if (!rtp_stream_receiver_.GetRtpReceiver()->EnableMediaCrypto(key))
+    LOG(LS_ERROR) << "Failed to install new media crypto key.";
+}
+
 // TODO(tommi): This method grabs a lock 6 times.
 void VideoReceiveStream::OnFrame(const VideoFrame& video_frame) {
   // TODO(tommi): OnDecodedFrame grabs a lock, incidentally the same lock
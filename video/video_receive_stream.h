@@ -60,9 +60,11 @@ class VideoReceiveStream : public webrtc::VideoReceiveStream,
 
   void SignalNetworkState(NetworkState state);
   bool DeliverRtcp(const uint8_t* packet, size_t length);
+  // |buffer| is the reference counted buffer holding |packet|, or null.
   bool DeliverRtp(const uint8_t* packet,
                   size_t length,
-                  const PacketTime& packet_time);
+                  const PacketTime& packet_time,
+                  const rtc::CopyOnWriteBuffer* buffer);
 
   bool OnRecoveredPacket(const uint8_t* packet, size_t length);
 
@@ -71,6 +73,7 @@ class VideoReceiveStream : public webrtc::VideoReceiveStream,
   void Stop() override;
 
   webrtc::VideoReceiveStream::Stats GetStats() const override;
+  void SetMediaCryptoKey(const MediaCryptoKey& key) override;
 
   // Overrides rtc::VideoSinkInterface<VideoFrame>.
   void OnFrame(const VideoFrame& video_frame) override;
@@ -57,6 +57,7 @@ std::vector<RtpRtcp*> CreateRtpRtcpModules(
     RateLimiter* retransmission_rate_limiter,
     OverheadObserver* overhead_observer,
     const MediaCryptoKey* media_crypto_key,                                          
+    size_t media_crypto_workers,
     size_t num_modules) {
   RTC_DCHECK_GT(num_modules, 0);
   RtpRtcp::Configuration configuration;
@@ -84,6 +85,7 @@ std::vector<RtpRtcp*> CreateRtpRtcpModules(
   if (media_crypto_key) {
     configuration.media_crypto_enabled = true;
     configuration.media_crypto_key = media_crypto_key;
+    configuration.media_crypto_workers = media_crypto_workers;
   }
   std::vector<RtpRtcp*> modules;
   for (size_t i = 0; i < num_modules; ++i) {
@@ -259,7 +261,8 @@ std::string VideoSendStream::StreamStats::ToString() const {
   ss << "max_ext_seq: " << rtcp_stats.extended_max_sequence_number << ", ";
   ss << "nack: " << rtcp_packet_type_counts.nack_packets << ", ";
   ss << "fir: " << rtcp_packet_type_counts.fir_packets << ", ";
-  ss << "pli: " << rtcp_packet_type_counts.pli_packets;
+  ss << "pli: " << rtcp_packet_type_counts.pli_packets << ", ";
+  ss << "media_crypto_packets: " << media_crypto_packets;
   return ss.str();
 }
 
@@ -345,6 +348,9 @@ class VideoSendStreamImpl : public webrtc::BitrateAllocatorObserver,
                                    size_t byte_limit);
 
   void SetTransportOverhead(size_t transport_overhead_per_packet);
+  void SetMediaCryptoKey(const MediaCryptoKey& key);
+  // Can be called on any thread.
+  void GetMediaCryptoStats(VideoSendStream::Stats* stats) const;
 
  private:
   class CheckEncoderActivityTask;
@@ -688,7 +694,9 @@ VideoSendStream::Stats VideoSendStream::GetStats() {
   // TODO(perkj, solenberg): Some test cases in EndToEndTest call GetStats from
   // a network thread. See comment in Call::GetStats().
   // RTC_DCHECK_RUN_ON(&thread_checker_);
-  return stats_proxy_.GetStats();
+  Stats stats = stats_proxy_.GetStats();
+  send_stream_->GetMediaCryptoStats(&stats);
+  return stats;
 }
 
 void VideoSendStream::SignalNetworkState(NetworkState state) {
@@ -720,6 +728,13 @@ void VideoSendStream::SetTransportOverhead(
   });
 }
 
+void VideoSendStream::SetMediaCryptoKey(const MediaCryptoKey& key) {
+  RTC_DCHECK_RUN_ON(&thread_checker_);
+  VideoSendStreamImpl* send_stream = send_stream_.get();
+  worker_queue_->PostTask(
+      [send_stream, key] { send_stream->SetMediaCryptoKey(key); });
+}
+
 bool VideoSendStream::DeliverRtcp(const uint8_t* packet, size_t length) {
   // Called on a network thread.
   return send_stream_->DeliverRtcp(packet, length);
@@ -783,6 +798,7 @@ VideoSendStreamImpl::VideoSendStreamImpl(
           congestion_controller_->GetRetransmissionRateLimiter(),
           this,
           config->media_crypto_enabled ? &(config->media_crypto_key) : NULL,
+          config->media_crypto_workers,
           config_->rtp.ssrcs.size())),
       payload_router_(rtp_rtcp_modules_,
                       config_->encoder_settings.payload_type),
@@ -1319,5 +1335,25 @@ void VideoSendStreamImpl::SetTransportOverhead(
   }
 }
 
+void VideoSendStreamImpl::GetMediaCryptoStats(
+    VideoSendStream::Stats* stats) const {
+  if (!config_->media_crypto_enabled)
+    return;
+  for (RtpRtcp* rtp_rtcp : rtp_rtcp_modules_) {
+    MediaCryptoStats crypto_stats = rtp_rtcp->GetMediaCryptoStats();
+    auto it = stats->substreams.find(crypto_stats.ssrc);
+    if (it != stats->substreams.end())
+      it->second.media_crypto_packets = crypto_stats.packets;
+  }
+}
+
+void VideoSendStreamImpl::SetMediaCryptoKey(const MediaCryptoKey& key) {
+  RTC_DCHECK_RUN_ON(worker_queue_);
+  for (RtpRtcp* rtp_rtcp : rtp_rtcp_modules_) {
+    if (!rtp_rtcp->SetMediaCryptoKey(key))
+      LOG(LS_ERROR) << "Failed to install new media crypto key.";
+  }
+}
+
 }  // namespace internal
 }  // namespace webrtc
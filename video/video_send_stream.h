@@ -78,6 +78,7 @@ class VideoSendStream : public webrtc::VideoSendStream {
 
   void ReconfigureVideoEncoder(VideoEncoderConfig) override;
   Stats GetStats() override;
+  void SetMediaCryptoKey(const MediaCryptoKey& key) override;
 
   typedef std::map<uint32_t, RtpState> RtpStateMap;
 
@@ -199,6 +199,8 @@ class VideoReceiveStream {
     // End to End media encryption
     bool media_crypto_enabled = false;
     MediaCryptoKey media_crypto_key;
+    // Receive only key accepted alongside |media_crypto_key|, if not empty.
+    MediaCryptoKey media_crypto_next_key;
   };
 
   // Starts stream activity.
@@ -211,6 +213,10 @@ class VideoReceiveStream {
   // TODO(pbos): Add info on currently-received codec to Stats.
   virtual Stats GetStats() const = 0;
 
+  // Installs a new end to end media key. Packets protected with the previous
+  // key are still accepted for a grace period.
+  virtual void SetMediaCryptoKey(const MediaCryptoKey& key) = 0;
+
   // Takes ownership of the file, is responsible for closing it later.
   // Calling this method will close and finalize any current log.
   // Giving rtc::kInvalidPlatformFileValue disables logging.
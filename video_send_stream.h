@@ -47,6 +47,9 @@ class VideoSendStream {
     StreamDataCounters rtp_stats;
     RtcpPacketTypeCounter rtcp_packet_type_counts;
     RtcpStatistics rtcp_stats;
+    // Packets protected with the end to end media key. Retransmissions, FEC
+    // and padding reuse the stored protected payload and don't add to it.
+    uint32_t media_crypto_packets = 0;
   };
 
   struct Stats {
@@ -202,6 +205,8 @@ class VideoSendStream {
     // End to End media encryption
     bool media_crypto_enabled = false;
     MediaCryptoKey media_crypto_key;
+    // Number of extra threads used to encrypt large frames, e.g. keyframes.
+    size_t media_crypto_workers = 0;
    private:
     // Access to the copy constructor is private to force use of the Copy()
     // method for those exceptional cases where we do use it.
@@ -234,6 +239,10 @@ class VideoSendStream {
 
   virtual Stats GetStats() = 0;
 
+  // Rotates the end to end media key, the new key is used from the next
+  // frame on. Only valid if the stream was created with media crypto enabled.
+  virtual void SetMediaCryptoKey(const MediaCryptoKey& key) = 0;
+
   // Takes ownership of each file, is responsible for closing them later.
   // Calling this method will close and finalize any current logs.
   // Some codecs produce multiple streams (VP8 only at present), each of these
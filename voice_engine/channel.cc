@@ -2879,6 +2879,12 @@ void Channel::SetTransportOverhead(size_t transport_overhead_per_packet) {
   UpdateOverheadForEncoder();
 }
 
+bool Channel::SetMediaCryptoKey(const MediaCryptoKey& key) {
+  bool send_ok = key.receive_only || _rtpRtcpModule->SetMediaCryptoKey(key);
+  bool receive_ok = rtp_receiver_->EnableMediaCrypto(key);
+  return send_ok && receive_ok;
+}
+
 void Channel::OnOverheadChanged(size_t overhead_bytes_per_packet) {
   rtp_overhead_per_packet_ = overhead_bytes_per_packet;
   UpdateOverheadForEncoder();
@@ -416,6 +416,9 @@ class Channel
   void SetRtcpRttStats(RtcpRttStats* rtcp_rtt_stats);
   void SetTransportOverhead(size_t transport_overhead_per_packet);
 
+  // Rotates the end to end media key on both the send and receive side.
+  bool SetMediaCryptoKey(const MediaCryptoKey& key);
+
   // From OverheadObserver in the RTP/RTCP module
   void OnOverheadChanged(size_t overhead_bytes_per_packet) override;
   
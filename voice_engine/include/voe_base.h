@@ -202,6 +202,13 @@ class WEBRTC_DLLEXPORT VoEBase {
   // 1 <- 2 <- 1.
   virtual int AssociateSendChannel(int channel, int accociate_send_channel) = 0;
 
+  // Installs a new end to end media key on a |channel| created with media
+  // crypto enabled. The new key is used from the next frame on, the previous
+  // one is still accepted on receive for a grace period.
+  virtual int SetMediaCryptoKey(int channel, const MediaCryptoKey& key) {
+    return -1;
+  }
+
  protected:
   VoEBase() {}
   virtual ~VoEBase() {}
@@ -773,4 +773,25 @@ int VoEBaseImpl::AssociateSendChannel(int channel,
   return 0;
 }
 
+int VoEBaseImpl::SetMediaCryptoKey(int channel, const MediaCryptoKey& key) {
+  rtc::CritScope cs(shared_->crit_sec());
+  if (!shared_->statistics().Initialized()) {
+    shared_->SetLastError(VE_NOT_INITED, kTraceError);
+    return -1;
+  }
+  voe::ChannelOwner ch = shared_->channel_manager().GetChannel(channel);
+  voe::Channel* channel_ptr = ch.channel();
+  if (channel_ptr == nullptr) {
+    shared_->SetLastError(VE_CHANNEL_NOT_VALID, kTraceError,
+                          "SetMediaCryptoKey() failed to locate channel");
+    return -1;
+  }
+  if (!channel_ptr->SetMediaCryptoKey(key)) {
+    shared_->SetLastError(VE_INVALID_ARGUMENT, kTraceError,
+                          "SetMediaCryptoKey() failed to set key");
+    return -1;
+  }
+  return 0;
+}
+
 }  // namespace webrtc